@@ -0,0 +1,250 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestCellLocatorCache.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Checks that cell locators restored from a search structure file answer
+// queries like the locator that wrote it, and that a file is not used for
+// another geometry or when it holds ids of cells the data set lacks.
+
+#include "vtkCellArray.h"
+#include "vtkCellLocator.h"
+#include "vtkIdList.h"
+#include "vtkMath.h"
+#include "vtkOBBTree.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+#include "vtkSmartPointer.h"
+#include "vtkTestUtilities.h"
+
+#include <stdio.h>
+
+// A randomly perturbed grid of triangles
+static vtkPolyData *MakeTriangles(int res)
+{
+  vtkPolyData *pd = vtkPolyData::New();
+  vtkPoints *pts = vtkPoints::New();
+  vtkCellArray *polys = vtkCellArray::New();
+  vtkMath::RandomSeed(8765);
+  int i, j;
+  for (j=0; j < res; j++)
+    {
+    for (i=0; i < res; i++)
+      {
+      pts->InsertNextPoint(i + vtkMath::Random(-0.3, 0.3),
+                           j + vtkMath::Random(-0.3, 0.3),
+                           vtkMath::Random(0.0, 2.0));
+      }
+    }
+  for (j=0; j < res-1; j++)
+    {
+    for (i=0; i < res-1; i++)
+      {
+      vtkIdType tri[3];
+      tri[0] = i + res*j;
+      tri[1] = i + 1 + res*j;
+      tri[2] = i + res*(j + 1);
+      polys->InsertNextCell(3, tri);
+      tri[0] = i + 1 + res*j;
+      tri[1] = i + 1 + res*(j + 1);
+      tri[2] = i + res*(j + 1);
+      polys->InsertNextCell(3, tri);
+      }
+    }
+  pd->SetPoints(pts);
+  pd->SetPolys(polys);
+  pts->Delete();
+  polys->Delete();
+  return pd;
+}
+
+// Compare line intersections and, for locators supporting them, closest
+// point and box queries.
+static int CompareQueries(vtkAbstractCellLocator *a,
+                          vtkAbstractCellLocator *b, int res,
+                          int allQueries)
+{
+  vtkMath::RandomSeed(42);
+  vtkIdList *cellsA = vtkIdList::New();
+  vtkIdList *cellsB = vtkIdList::New();
+  int rval = 0;
+  for (int q=0; q < 200 && !rval; q++)
+    {
+    double x[3];
+    x[0] = vtkMath::Random(0.0, res);
+    x[1] = vtkMath::Random(0.0, res);
+    x[2] = vtkMath::Random(-1.0, 3.0);
+
+    vtkIdType cellA, cellB;
+    int subId;
+    double p0[3] = {x[0], x[1], -5.0};
+    double p1[3] = {x[0], x[1], 5.0};
+    double t, pa[3], pb[3], pcoords[3];
+    int hitA = a->IntersectWithLine(p0, p1, 0.0, t, pa, pcoords, subId,
+                                    cellA);
+    int hitB = b->IntersectWithLine(p0, p1, 0.0, t, pb, pcoords, subId,
+                                    cellB);
+    if (hitA != hitB || (hitA && cellA != cellB))
+      {
+      cerr << "Line intersection " << q << " differs" << endl;
+      rval++;
+      }
+    if (!allQueries)
+      {
+      continue;
+      }
+
+    double ca[3], cb[3], da, db;
+    a->FindClosestPoint(x, ca, cellA, subId, da);
+    b->FindClosestPoint(x, cb, cellB, subId, db);
+    if (cellA != cellB || da != db)
+      {
+      cerr << "Closest point query " << q << " differs" << endl;
+      rval++;
+      }
+
+    double bounds[6] = {x[0]-1, x[0]+1, x[1]-1, x[1]+1, -1, 3};
+    a->FindCellsWithinBounds(bounds, cellsA);
+    b->FindCellsWithinBounds(bounds, cellsB);
+    if (cellsA->GetNumberOfIds() != cellsB->GetNumberOfIds())
+      {
+      cerr << "Box query " << q << " differs" << endl;
+      rval++;
+      }
+    }
+  cellsA->Delete();
+  cellsB->Delete();
+  return rval;
+}
+
+static int TestLocator(vtkAbstractCellLocator *built,
+                       vtkAbstractCellLocator *restored,
+                       vtkPolyData *input, vtkPolyData *other, int res,
+                       int allQueries, const char *tempDir)
+{
+  int rval = 0;
+  char fileName[1024];
+  sprintf(fileName, "%s/TestCellLocatorCache_%s.vtklocator", tempDir,
+          built->GetClassName());
+
+  built->SetDataSet(input);
+  built->BuildLocator();
+  if (!built->WriteSearchStructure(fileName))
+    {
+    cerr << built->GetClassName() << " could not write its file" << endl;
+    return 1;
+    }
+
+  restored->SetDataSet(input);
+  if (!restored->ReadSearchStructure(fileName))
+    {
+    cerr << restored->GetClassName() << " could not read its file" << endl;
+    remove(fileName);
+    return 1;
+    }
+  rval += CompareQueries(built, restored, res, allQueries);
+
+  // a different geometry or different parameters must not use the file
+  restored->SetDataSet(other);
+  if (restored->ReadSearchStructure(fileName))
+    {
+    cerr << "File was read for another geometry" << endl;
+    rval++;
+    }
+  restored->SetDataSet(input);
+  restored->SetNumberOfCellsPerNode(built->GetNumberOfCellsPerNode() + 1);
+  if (restored->ReadSearchStructure(fileName))
+    {
+    cerr << "File was read with other parameters" << endl;
+    rval++;
+    }
+
+  // both formats end with a cell id list: an id past the cells of the data
+  // set must make the file invalid
+  restored->SetNumberOfCellsPerNode(built->GetNumberOfCellsPerNode());
+  vtkIdType badId = input->GetNumberOfCells();
+  FILE *fp = fopen(fileName, "r+b");
+  if (!fp ||
+      fseek(fp, -static_cast<long>(sizeof(vtkIdType)), SEEK_END) != 0 ||
+      fwrite(&badId, sizeof(vtkIdType), 1, fp) != 1)
+    {
+    cerr << "Could not modify " << fileName << endl;
+    rval++;
+    }
+  if (fp)
+    {
+    fclose(fp);
+    }
+  if (restored->ReadSearchStructure(fileName))
+    {
+    cerr << "File was read with an out of range cell id" << endl;
+    rval++;
+    }
+  remove(fileName);
+
+  // automatic caching: the second locator reads what the first wrote
+  char cacheName[1024];
+  vtkTypeUInt64 hash = built->ComputeGeometryHash();
+  sprintf(cacheName, "%s/%s_%08x%08x.vtklocator", tempDir,
+          built->GetClassName(),
+          static_cast<unsigned int>(hash >> 32),
+          static_cast<unsigned int>(hash & 0xffffffff));
+  remove(cacheName);
+  built->SetCacheDirectory(tempDir);
+  built->Modified();
+  built->BuildLocator();
+  fp = fopen(cacheName, "rb");
+  if (!fp)
+    {
+    cerr << "No cache file " << cacheName << endl;
+    return rval + 1;
+    }
+  fclose(fp);
+
+  restored->SetNumberOfCellsPerNode(built->GetNumberOfCellsPerNode());
+  restored->SetCacheDirectory(tempDir);
+  restored->BuildLocator();
+  rval += CompareQueries(built, restored, res, allQueries);
+  remove(cacheName);
+  return rval;
+}
+
+int TestCellLocatorCache(int argc, char *argv[])
+{
+  int rval = 0;
+  char *tempDir = vtkTestUtilities::GetArgOrEnvOrDefault(
+    "-T", argc, argv, "VTK_TEMP_DIR", "../../../Testing/Temporary");
+  const int res = 60;
+  vtkPolyData *input = MakeTriangles(res);
+  vtkPolyData *other = vtkPolyData::New();
+  other->DeepCopy(input);
+  double x[3];
+  other->GetPoint(10, x);
+  x[2] += 0.5;
+  other->GetPoints()->SetPoint(10, x);
+
+  vtkSmartPointer<vtkCellLocator> cellLocator =
+    vtkSmartPointer<vtkCellLocator>::New();
+  vtkSmartPointer<vtkCellLocator> cellLocator2 =
+    vtkSmartPointer<vtkCellLocator>::New();
+  rval += TestLocator(cellLocator, cellLocator2, input, other, res, 1,
+                      tempDir);
+
+  vtkSmartPointer<vtkOBBTree> obbTree = vtkSmartPointer<vtkOBBTree>::New();
+  vtkSmartPointer<vtkOBBTree> obbTree2 = vtkSmartPointer<vtkOBBTree>::New();
+  rval += TestLocator(obbTree, obbTree2, input, other, res, 0, tempDir);
+
+  other->Delete();
+  input->Delete();
+  delete [] tempDir;
+  return rval;
+}
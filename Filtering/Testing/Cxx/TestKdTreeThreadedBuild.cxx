@@ -0,0 +1,157 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestKdTreeThreadedBuild.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Checks that vtkKdTree builds the same decomposition whatever its
+// NumberOfThreads.
+
+#include "vtkCellArray.h"
+#include "vtkIdTypeArray.h"
+#include "vtkKdTree.h"
+#include "vtkMath.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+#include "vtkSmartPointer.h"
+
+// A randomly perturbed grid of triangles
+static vtkPolyData *MakeTriangles(int res)
+{
+  vtkPolyData *pd = vtkPolyData::New();
+  vtkPoints *pts = vtkPoints::New();
+  vtkCellArray *polys = vtkCellArray::New();
+  vtkMath::RandomSeed(4321);
+  int i, j;
+  for (j=0; j < res; j++)
+    {
+    for (i=0; i < res; i++)
+      {
+      pts->InsertNextPoint(i + vtkMath::Random(-0.3, 0.3),
+                           j + vtkMath::Random(-0.3, 0.3),
+                           vtkMath::Random(0.0, 5.0));
+      }
+    }
+  for (j=0; j < res-1; j++)
+    {
+    for (i=0; i < res-1; i++)
+      {
+      vtkIdType tri[3];
+      tri[0] = i + res*j;
+      tri[1] = i + 1 + res*j;
+      tri[2] = i + res*(j + 1);
+      polys->InsertNextCell(3, tri);
+      tri[0] = i + 1 + res*j;
+      tri[1] = i + 1 + res*(j + 1);
+      tri[2] = i + res*(j + 1);
+      polys->InsertNextCell(3, tri);
+      }
+    }
+  pd->SetPoints(pts);
+  pd->SetPolys(polys);
+  pts->Delete();
+  polys->Delete();
+  return pd;
+}
+
+static int CompareRegions(vtkKdTree *a, vtkKdTree *b)
+{
+  if (a->GetNumberOfRegions() != b->GetNumberOfRegions() ||
+      a->GetNumberOfRegions() < 2)
+    {
+    cerr << "Number of regions differ: " << a->GetNumberOfRegions()
+         << " / " << b->GetNumberOfRegions() << endl;
+    return 1;
+    }
+  for (int r=0; r < a->GetNumberOfRegions(); r++)
+    {
+    double ba[6], bb[6];
+    a->GetRegionBounds(r, ba);
+    b->GetRegionBounds(r, bb);
+    for (int i=0; i < 6; i++)
+      {
+      if (ba[i] != bb[i])
+        {
+        cerr << "Bounds of region " << r << " differ" << endl;
+        return 1;
+        }
+      }
+    }
+  return 0;
+}
+
+int TestKdTreeThreadedBuild(int, char *[])
+{
+  int rval = 0;
+  vtkPolyData *input = MakeTriangles(120);
+
+  // decomposition of cell centers
+  vtkSmartPointer<vtkKdTree> serial = vtkSmartPointer<vtkKdTree>::New();
+  serial->SetNumberOfThreads(1);
+  serial->SetMinCells(20);
+  serial->SetDataSet(input);
+  serial->BuildLocator();
+
+  vtkSmartPointer<vtkKdTree> threaded = vtkSmartPointer<vtkKdTree>::New();
+  threaded->SetNumberOfThreads(4);
+  threaded->SetMinCells(20);
+  threaded->SetDataSet(input);
+  threaded->BuildLocator();
+
+  rval += CompareRegions(serial, threaded);
+
+  int *serialList = serial->AllGetRegionContainingCell();
+  int *threadedList = threaded->AllGetRegionContainingCell();
+  vtkIdType numCells = input->GetNumberOfCells();
+  vtkIdType cellId;
+  for (cellId=0; cellId < numCells; cellId++)
+    {
+    if (serialList[cellId] != threadedList[cellId] ||
+        threadedList[cellId] != threaded->GetRegionContainingCell(cellId))
+      {
+      cerr << "Region of cell " << cellId << " differs" << endl;
+      rval++;
+      break;
+      }
+    }
+
+  // decomposition of points
+  serial->BuildLocatorFromPoints(input->GetPoints());
+  threaded->BuildLocatorFromPoints(input->GetPoints());
+  rval += CompareRegions(serial, threaded);
+
+  for (int r=0; r < serial->GetNumberOfRegions() && !rval; r++)
+    {
+    vtkIdTypeArray *serialIds = serial->GetPointsInRegion(r);
+    vtkIdTypeArray *threadedIds = threaded->GetPointsInRegion(r);
+    vtkIdType numIds = serialIds->GetNumberOfTuples();
+    if (threadedIds->GetNumberOfTuples() != numIds)
+      {
+      rval++;
+      }
+    for (vtkIdType i=0; i < numIds && !rval; i++)
+      {
+      if (serialIds->GetValue(i) != threadedIds->GetValue(i))
+        {
+        rval++;
+        }
+      }
+    if (rval)
+      {
+      cerr << "Points of region " << r << " differ" << endl;
+      }
+    serialIds->Delete();
+    threadedIds->Delete();
+    }
+
+  input->Delete();
+  return rval;
+}
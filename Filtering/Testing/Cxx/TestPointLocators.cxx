@@ -13,6 +13,7 @@
 
 =========================================================================*/
 #include "vtkIdList.h"
+#include "vtkIdTypeArray.h"
 #include "vtkKdTree.h"
 #include "vtkKdTreePointLocator.h"
 #include "vtkMath.h"
@@ -293,6 +294,149 @@ int TestKdTreePointLocator()
   return rval;
 }
 
+// This test checks the approximate and the batched (threaded) queries of
+// vtkKdTree against the exact single point queries.
+int TestKdTreeApproximateAndBatchedQueries()
+{
+  int rval = 0;
+  vtkIdType num_points = 2000;
+  vtkIdType num_test_points = 50;
+  int N = 10;
+  double radius = 0.1;
+  double eps = 0.5;
+  vtkIdType point;
+  double x[3];
+
+  vtkPoints * A = vtkPoints::New();
+  A->SetDataTypeToDouble();
+  A->SetNumberOfPoints( num_points );
+  for ( point = 0; point < num_points; ++point )
+    {
+    x[0] = ((double) rand()) / RAND_MAX;
+    x[1] = ((double) rand()) / RAND_MAX;
+    x[2] = ((double) rand()) / RAND_MAX;
+    A->SetPoint( point, x );
+    }
+
+  vtkPoints * B = vtkPoints::New();
+  B->SetDataTypeToDouble();
+  B->SetNumberOfPoints( num_test_points );
+  for ( point = 0; point < num_test_points; ++point )
+    {
+    x[0] = ((double) rand()) / RAND_MAX;
+    x[1] = ((double) rand()) / RAND_MAX;
+    x[2] = ((double) rand()) / RAND_MAX;
+    B->SetPoint( point, x );
+    }
+
+  vtkKdTree * kd = vtkKdTree::New();
+  kd->SetNumberOfThreads( 4 );
+  kd->BuildLocatorFromPoints( A );
+
+  vtkIdList * exactList = vtkIdList::New();
+  vtkIdList * approxList = vtkIdList::New();
+  vtkIdTypeArray * batchIds = vtkIdTypeArray::New();
+  vtkIdTypeArray * batchOffsets = vtkIdTypeArray::New();
+
+  // batched queries must match the single point queries
+  kd->FindClosestNPoints( N, B, batchIds );
+  for ( point = 0; point < num_test_points; ++point )
+    {
+    B->GetPoint( point, x );
+    kd->FindClosestNPoints( N, x, exactList );
+    for ( int j = 0; j < N; j++ )
+      {
+      if ( batchIds->GetValue( point * N + j ) != exactList->GetId( j ) )
+        {
+        cerr << "Batched FindClosestNPoints differs from single query\n";
+        rval++;
+        break;
+        }
+      }
+    }
+
+  kd->FindPointsWithinRadius( radius, B, batchIds, batchOffsets );
+  for ( point = 0; point < num_test_points; ++point )
+    {
+    B->GetPoint( point, x );
+    kd->FindPointsWithinRadius( radius, x, exactList );
+    vtkIdType begin = batchOffsets->GetValue( point );
+    vtkIdType end = batchOffsets->GetValue( point + 1 );
+    if ( end - begin != exactList->GetNumberOfIds() )
+      {
+      cerr << "Batched FindPointsWithinRadius differs from single query\n";
+      rval++;
+      }
+    }
+
+  // approximate results must be within the requested error bound
+  kd->SetApproximationFactor( eps );
+  for ( point = 0; point < num_test_points; ++point )
+    {
+    B->GetPoint( point, x );
+    kd->SetApproximationFactor( 0.0 );
+    kd->FindClosestNPoints( N, x, exactList );
+    kd->SetApproximationFactor( eps );
+    kd->FindClosestNPoints( N, x, approxList );
+    double exactDist2 = vtkMath::Distance2BetweenPoints(
+      x, A->GetPoint( exactList->GetId( N - 1 ) ) );
+    double approxDist2 = vtkMath::Distance2BetweenPoints(
+      x, A->GetPoint( approxList->GetId( N - 1 ) ) );
+    if ( approxList->GetNumberOfIds() != N ||
+         approxDist2 > ( 1 + eps ) * ( 1 + eps ) * exactDist2 * 1.00001 )
+      {
+      cerr << "Approximate FindClosestNPoints exceeds the error bound\n";
+      rval++;
+      }
+
+    kd->FindPointsWithinRadius( radius, x, approxList );
+    vtkIdType numInside = 0;
+    for ( vtkIdType j = 0; j < approxList->GetNumberOfIds(); j++ )
+      {
+      double d2 = vtkMath::Distance2BetweenPoints(
+        x, A->GetPoint( approxList->GetId( j ) ) );
+      if ( d2 > ( 1 + eps ) * ( 1 + eps ) * radius * radius * 1.00001 )
+        {
+        cerr << "Approximate FindPointsWithinRadius returned a far point\n";
+        rval++;
+        }
+      if ( d2 <= radius * radius )
+        {
+        numInside++;
+        }
+      }
+    kd->SetApproximationFactor( 0.0 );
+    kd->FindPointsWithinRadius( radius, x, exactList );
+    if ( numInside != exactList->GetNumberOfIds() )
+      {
+      cerr << "Approximate FindPointsWithinRadius missed points\n";
+      rval++;
+      }
+    kd->SetApproximationFactor( eps );
+    }
+
+  // a bounded search still returns N points
+  kd->SetApproximationFactor( 0.0 );
+  kd->SetMaximumNumberOfRegionVisits( 1 );
+  B->GetPoint( 0, x );
+  kd->FindClosestNPoints( N, x, approxList );
+  if ( approxList->GetNumberOfIds() != N )
+    {
+    cerr << "Bounded FindClosestNPoints did not return " << N << " points\n";
+    rval++;
+    }
+
+  batchIds->Delete();
+  batchOffsets->Delete();
+  exactList->Delete();
+  approxList->Delete();
+  kd->Delete();
+  A->Delete();
+  B->Delete();
+
+  return rval;
+}
+
 int TestPointLocators(int , char *[])
 {
   vtkKdTreePointLocator* kdTreeLocator = vtkKdTreePointLocator::New();
@@ -311,6 +455,7 @@ int TestPointLocators(int , char *[])
   octreeLocator->Delete();
 
   rval += TestKdTreePointLocator();
+  rval += TestKdTreeApproximateAndBatchedQueries();
 
   return rval;
 }
@@ -21,7 +21,63 @@
 #include "vtkIdList.h"
 #include "vtkPoints.h"
 #include "vtkDataSet.h"
+#include "vtkIdTypeArray.h"
 #include "vtkMath.h"
+#include "vtkPointSet.h"
+#include "vtkPolyData.h"
+#include "vtkUnsignedCharArray.h"
+#include "vtkUnstructuredGrid.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vtkstd/string>
+
+// Identifies search structure files; the version is part of it
+static const char vtkAbstractCellLocatorMagic[8] =
+  {'v','t','k','L','o','c','0','1'};
+
+//----------------------------------------------------------------------------
+// Fold a block of memory into a 64 bit hash, eight bytes at a time
+static void vtkAbstractCellLocatorHash(vtkTypeUInt64 &hash, const void *data,
+                                       size_t size)
+{
+  const vtkTypeUInt64 prime = 0x100000001b3ULL;
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8)
+    {
+    vtkTypeUInt64 word;
+    memcpy(&word, bytes + i, 8);
+    hash = (hash ^ word) * prime;
+    hash ^= hash >> 29;
+    }
+  for (; i < size; i++)
+    {
+    hash = (hash ^ bytes[i]) * prime;
+    }
+}
+
+//----------------------------------------------------------------------------
+static void vtkAbstractCellLocatorHashArray(vtkTypeUInt64 &hash,
+                                            vtkDataArray *array)
+{
+  if (!array)
+    {
+    vtkIdType zero = 0;
+    vtkAbstractCellLocatorHash(hash, &zero, sizeof(zero));
+    return;
+    }
+  vtkIdType num = array->GetNumberOfTuples() *
+    array->GetNumberOfComponents();
+  int type = array->GetDataType();
+  vtkAbstractCellLocatorHash(hash, &num, sizeof(num));
+  vtkAbstractCellLocatorHash(hash, &type, sizeof(type));
+  if (num > 0)
+    {
+    vtkAbstractCellLocatorHash(hash, array->GetVoidPointer(0),
+                               num * array->GetDataTypeSize());
+    }
+}
 //----------------------------------------------------------------------------
 //----------------------------------------------------------------------------
 vtkAbstractCellLocator::vtkAbstractCellLocator()
@@ -34,12 +90,16 @@ vtkAbstractCellLocator::vtkAbstractCellLocator()
   this->NumberOfCellsPerNode       = 32;
   this->UseExistingSearchStructure = 0;
   this->LazyEvaluation             = 0;
+  this->CacheDirectory             = NULL;
   this->GenericCell                = vtkGenericCell::New();
+  this->GeometryHash               = 0;
+  this->GeometryHashDataSet        = NULL;
 }
 //----------------------------------------------------------------------------
 vtkAbstractCellLocator::~vtkAbstractCellLocator()
 {
   this->GenericCell->Delete();
+  this->SetCacheDirectory(NULL);
 }
 //----------------------------------------------------------------------------
 bool vtkAbstractCellLocator::StoreCellBounds()
@@ -229,5 +289,302 @@ void vtkAbstractCellLocator::PrintSelf(ostream& os, vtkIndent indent)
      << this->UseExistingSearchStructure << "\n";
   os << indent << "LazyEvaluation: " 
      << this->LazyEvaluation << "\n";
+  os << indent << "CacheDirectory: " 
+     << (this->CacheDirectory ? this->CacheDirectory : "(none)") << "\n";
+}
+//----------------------------------------------------------------------------
+vtkTypeUInt64 vtkAbstractCellLocator::ComputeGeometryHash()
+{
+  vtkTypeUInt64 hash = 0xcbf29ce484222325ULL;
+  if (!this->DataSet)
+    {
+    return hash;
+    }
+
+  vtkDataSet *ds = this->DataSet;
+  vtkIdType numPts = ds->GetNumberOfPoints();
+  vtkIdType numCells = ds->GetNumberOfCells();
+  vtkIdType i;
+  vtkAbstractCellLocatorHash(hash, &numPts, sizeof(numPts));
+  vtkAbstractCellLocatorHash(hash, &numCells, sizeof(numCells));
+
+  vtkPointSet *ps = vtkPointSet::SafeDownCast(ds);
+  if (ps && ps->GetPoints())
+    {
+    vtkAbstractCellLocatorHashArray(hash, ps->GetPoints()->GetData());
+    }
+  else
+    {
+    double x[3];
+    for (i=0; i < numPts; i++)
+      {
+      ds->GetPoint(i, x);
+      vtkAbstractCellLocatorHash(hash, x, sizeof(x));
+      }
+    }
+
+  vtkPolyData *pd = vtkPolyData::SafeDownCast(ds);
+  vtkUnstructuredGrid *ug = vtkUnstructuredGrid::SafeDownCast(ds);
+  if (pd)
+    {
+    vtkCellArray *cells[4] = {pd->GetVerts(), pd->GetLines(),
+                              pd->GetPolys(), pd->GetStrips()};
+    for (int c=0; c < 4; c++)
+      {
+      vtkAbstractCellLocatorHashArray(hash,
+        cells[c] ? cells[c]->GetData() : NULL);
+      }
+    }
+  else if (ug && ug->GetCells())
+    {
+    vtkAbstractCellLocatorHashArray(hash, ug->GetCells()->GetData());
+    vtkAbstractCellLocatorHashArray(hash, ug->GetCellTypesArray());
+    vtkAbstractCellLocatorHashArray(hash, ug->GetFaces());
+    }
+  else
+    {
+    vtkIdList *ptIds = vtkIdList::New();
+    for (i=0; i < numCells; i++)
+      {
+      int type = ds->GetCellType(i);
+      ds->GetCellPoints(i, ptIds);
+      vtkIdType npts = ptIds->GetNumberOfIds();
+      vtkAbstractCellLocatorHash(hash, &type, sizeof(type));
+      vtkAbstractCellLocatorHash(hash, &npts, sizeof(npts));
+      if (npts > 0)
+        {
+        vtkAbstractCellLocatorHash(hash, ptIds->GetPointer(0),
+                                   npts * sizeof(vtkIdType));
+        }
+      }
+    ptIds->Delete();
+    }
+
+  return hash;
+}
+//----------------------------------------------------------------------------
+vtkTypeUInt64 vtkAbstractCellLocator::GetGeometryHash()
+{
+  if (this->GeometryHashDataSet != this->DataSet || !this->DataSet ||
+      this->GeometryHashTime < this->DataSet->GetMTime())
+    {
+    this->GeometryHash = this->ComputeGeometryHash();
+    this->GeometryHashDataSet = this->DataSet;
+    this->GeometryHashTime.Modified();
+    }
+  return this->GeometryHash;
+}
+//----------------------------------------------------------------------------
+int vtkAbstractCellLocator::GetSearchStructureParameters(double params[8])
+{
+  params[0] = this->NumberOfCellsPerNode;
+  params[1] = this->MaxLevel;
+  return 2;
+}
+//----------------------------------------------------------------------------
+int vtkAbstractCellLocator::WriteSearchStructure(const char *)
+{
+  vtkErrorMacro(<< this->GetClassName()
+                << " cannot write its search structure");
+  return 0;
+}
+//----------------------------------------------------------------------------
+int vtkAbstractCellLocator::ReadSearchStructure(const char *)
+{
+  vtkErrorMacro(<< this->GetClassName()
+                << " cannot read its search structure");
+  return 0;
+}
+//----------------------------------------------------------------------------
+// Header layout: magic, byte order tag, sizeof(vtkIdType), class name,
+// geometry hash, number of cells, build parameters.
+void vtkAbstractCellLocator::WriteSearchStructureHeader(ostream &os)
+{
+  int byteOrder = 0x01020304;
+  int idSize = static_cast<int>(sizeof(vtkIdType));
+  const char *className = this->GetClassName();
+  int nameLength = static_cast<int>(strlen(className));
+  vtkTypeUInt64 hash = this->GetGeometryHash();
+  vtkIdType numCells = this->DataSet->GetNumberOfCells();
+  double params[8];
+  int numParams = this->GetSearchStructureParameters(params);
+
+  os.write(vtkAbstractCellLocatorMagic, sizeof(vtkAbstractCellLocatorMagic));
+  os.write(reinterpret_cast<char *>(&byteOrder), sizeof(byteOrder));
+  os.write(reinterpret_cast<char *>(&idSize), sizeof(idSize));
+  os.write(reinterpret_cast<char *>(&nameLength), sizeof(nameLength));
+  os.write(className, nameLength);
+  os.write(reinterpret_cast<char *>(&hash), sizeof(hash));
+  os.write(reinterpret_cast<char *>(&numCells), sizeof(numCells));
+  os.write(reinterpret_cast<char *>(&numParams), sizeof(numParams));
+  os.write(reinterpret_cast<char *>(params), numParams * sizeof(double));
+}
+//----------------------------------------------------------------------------
+int vtkAbstractCellLocator::ReadSearchStructureHeader(const char *&buffer,
+                                                      const char *end)
+{
+  char magic[sizeof(vtkAbstractCellLocatorMagic)];
+  int byteOrder, idSize, nameLength, numParams;
+  if (!vtkAbstractCellLocator::ReadFromBuffer(buffer, end, magic,
+                                              sizeof(magic)) ||
+      memcmp(magic, vtkAbstractCellLocatorMagic, sizeof(magic)) != 0 ||
+      !vtkAbstractCellLocator::ReadFromBuffer(buffer, end, &byteOrder,
+                                              sizeof(byteOrder)) ||
+      byteOrder != 0x01020304 ||
+      !vtkAbstractCellLocator::ReadFromBuffer(buffer, end, &idSize,
+                                              sizeof(idSize)) ||
+      idSize != static_cast<int>(sizeof(vtkIdType)) ||
+      !vtkAbstractCellLocator::ReadFromBuffer(buffer, end, &nameLength,
+                                              sizeof(nameLength)) ||
+      nameLength < 0 || nameLength > end - buffer)
+    {
+    vtkDebugMacro(<< "Not a search structure file for this platform");
+    return 0;
+    }
+  vtkstd::string className(buffer, nameLength);
+  buffer += nameLength;
+  if (className != this->GetClassName())
+    {
+    vtkDebugMacro(<< "Search structure file is for a " << className);
+    return 0;
+    }
+
+  vtkTypeUInt64 hash;
+  vtkIdType numCells;
+  double params[8], fileParams[8];
+  if (!vtkAbstractCellLocator::ReadFromBuffer(buffer, end, &hash,
+                                              sizeof(hash)) ||
+      !vtkAbstractCellLocator::ReadFromBuffer(buffer, end, &numCells,
+                                              sizeof(numCells)) ||
+      !vtkAbstractCellLocator::ReadFromBuffer(buffer, end, &numParams,
+                                              sizeof(numParams)) ||
+      numParams != this->GetSearchStructureParameters(params) ||
+      !vtkAbstractCellLocator::ReadFromBuffer(buffer, end, fileParams,
+                                              numParams * sizeof(double)))
+    {
+    vtkDebugMacro(<< "Truncated search structure file");
+    return 0;
+    }
+  if (!this->DataSet || numCells != this->DataSet->GetNumberOfCells() ||
+      hash != this->GetGeometryHash())
+    {
+    vtkDebugMacro(<< "Search structure file is for another geometry");
+    return 0;
+    }
+  for (int i=0; i < numParams; i++)
+    {
+    if (params[i] != fileParams[i])
+      {
+      vtkDebugMacro(<< "Search structure file was built with other "
+                    "parameters");
+      return 0;
+      }
+    }
+  return 1;
+}
+//----------------------------------------------------------------------------
+char *vtkAbstractCellLocator::ReadWholeFile(const char *fileName,
+                                            size_t &size)
+{
+  FILE *fp = fopen(fileName, "rb");
+  if (!fp)
+    {
+    return NULL;
+    }
+  fseek(fp, 0, SEEK_END);
+  long length = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+  char *buffer = NULL;
+  if (length > 0)
+    {
+    buffer = new char [length];
+    if (fread(buffer, 1, length, fp) != static_cast<size_t>(length))
+      {
+      delete [] buffer;
+      buffer = NULL;
+      }
+    }
+  fclose(fp);
+  size = buffer ? static_cast<size_t>(length) : 0;
+  return buffer;
+}
+//----------------------------------------------------------------------------
+int vtkAbstractCellLocator::ReadFromBuffer(const char *&buffer,
+                                           const char *end,
+                                           void *data, size_t size)
+{
+  if (static_cast<size_t>(end - buffer) < size)
+    {
+    return 0;
+    }
+  memcpy(data, buffer, size);
+  buffer += size;
+  return 1;
+}
+//----------------------------------------------------------------------------
+// Cache files are named after the class and the geometry hash.
+static vtkstd::string vtkAbstractCellLocatorCacheFile(const char *directory,
+                                                      const char *className,
+                                                      vtkTypeUInt64 hash)
+{
+  char hex[17];
+  sprintf(hex, "%08x%08x", static_cast<unsigned int>(hash >> 32),
+          static_cast<unsigned int>(hash & 0xffffffff));
+  vtkstd::string fileName = directory;
+  if (!fileName.empty() && fileName[fileName.size()-1] != '/' &&
+      fileName[fileName.size()-1] != '\\')
+    {
+    fileName += "/";
+    }
+  fileName += className;
+  fileName += "_";
+  fileName += hex;
+  fileName += ".vtklocator";
+  return fileName;
+}
+//----------------------------------------------------------------------------
+int vtkAbstractCellLocator::ReadSearchStructureFromCache()
+{
+  if (!this->CacheDirectory || !this->DataSet)
+    {
+    return 0;
+    }
+  vtkstd::string fileName = vtkAbstractCellLocatorCacheFile(
+    this->CacheDirectory, this->GetClassName(), this->GetGeometryHash());
+  FILE *fp = fopen(fileName.c_str(), "rb");
+  if (!fp)
+    {
+    return 0;
+    }
+  fclose(fp);
+  vtkDebugMacro(<< "Reading search structure from " << fileName.c_str());
+  return this->ReadSearchStructure(fileName.c_str());
+}
+//----------------------------------------------------------------------------
+// The file is written under a temporary name and then renamed, so that
+// concurrent sessions never read a partial file.
+void vtkAbstractCellLocator::WriteSearchStructureToCache()
+{
+  if (!this->CacheDirectory || !this->DataSet)
+    {
+    return;
+    }
+  vtkstd::string fileName = vtkAbstractCellLocatorCacheFile(
+    this->CacheDirectory, this->GetClassName(), this->GetGeometryHash());
+  vtkstd::string tmpName = fileName + ".tmp";
+  vtkDebugMacro(<< "Writing search structure to " << fileName.c_str());
+  if (this->WriteSearchStructure(tmpName.c_str()))
+    {
+    remove(fileName.c_str());
+    if (rename(tmpName.c_str(), fileName.c_str()) != 0)
+      {
+      vtkWarningMacro(<< "Could not write cache file " << fileName.c_str());
+      remove(tmpName.c_str());
+      }
+    }
+  else
+    {
+    remove(tmpName.c_str());
+    }
 }
 //----------------------------------------------------------------------------
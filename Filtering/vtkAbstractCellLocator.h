@@ -94,6 +94,35 @@ public:
   vtkGetMacro(UseExistingSearchStructure,int);
   vtkBooleanMacro(UseExistingSearchStructure,int);
 
+  // Description:
+  // Directory in which built search structures are cached.  When set,
+  // building the locator first looks there for a file written for the
+  // same geometry (see ComputeGeometryHash()) and the same build
+  // parameters, and reads it instead of building the structure.
+  // Otherwise the structure is built and written there for the next
+  // time.  Only locators implementing WriteSearchStructure() and
+  // ReadSearchStructure() use the cache.  Default is NULL (no cache).
+  vtkSetStringMacro(CacheDirectory);
+  vtkGetStringMacro(CacheDirectory);
+
+  // Description:
+  // Write the built search structure to a binary file, or replace the
+  // search structure by the one read from a file.  The file records the
+  // geometry hash and the build parameters; reading fails if they do
+  // not match the current DataSet and parameters.  Files are in the
+  // native byte order.  Return 1 on success.  Not all locators support
+  // this.
+  virtual int WriteSearchStructure(const char *fileName);
+  virtual int ReadSearchStructure(const char *fileName);
+
+//BTX
+  // Description:
+  // Compute a 64 bit hash of the points and the cells of DataSet.
+  // Point coordinates and connectivity are hashed in bulk for point
+  // sets, polydata and unstructured grids.
+  vtkTypeUInt64 ComputeGeometryHash();
+//ETX
+
   // Description:
   // Return intersection point (if any) of finite line with cells contained
   // in cell locator.
@@ -252,12 +281,51 @@ protected:
   virtual bool StoreCellBounds();
   virtual void FreeCellBounds();
 
+  // Description:
+  // Read the search structure from the CacheDirectory file for the
+  // current geometry, if there is one.  Returns 1 if it was read.
+  int ReadSearchStructureFromCache();
+
+  // Description:
+  // Write the search structure to CacheDirectory, if set.
+  void WriteSearchStructureToCache();
+
+  // Description:
+  // Fill params with the ivars the search structure depends on and
+  // return their number (at most 8).  They are stored in the header of
+  // search structure files.
+  virtual int GetSearchStructureParameters(double params[8]);
+
+//BTX
+  // Description:
+  // Helpers for subclasses implementing Write/ReadSearchStructure().
+  // The header identifies the class, the geometry and the parameters.
+  // ReadWholeFile() reads a file in a single read into a buffer the
+  // caller must delete [].  ReadFromBuffer() copies size bytes from the
+  // buffer and advances it, returning 0 if it would go past end.
+  void WriteSearchStructureHeader(ostream &os);
+  int ReadSearchStructureHeader(const char *&buffer, const char *end);
+  static char *ReadWholeFile(const char *fileName, size_t &size);
+  static int ReadFromBuffer(const char *&buffer, const char *end,
+                            void *data, size_t size);
+
+  // Description:
+  // The geometry hash of DataSet, recomputed only when it changed.
+  vtkTypeUInt64 GetGeometryHash();
+//ETX
+
   int NumberOfCellsPerNode;
   int RetainCellLists;
   int CacheCellBounds;
   int LazyEvaluation;
   int UseExistingSearchStructure;
+  char *CacheDirectory;
   vtkGenericCell *GenericCell;
+//BTX
+  vtkTypeUInt64 GeometryHash;
+  vtkTimeStamp GeometryHashTime;
+  vtkDataSet *GeometryHashDataSet;
+//ETX
 //BTX - begin tcl exclude
   double (*CellBounds)[6];
 //ETX - end tcl exclude
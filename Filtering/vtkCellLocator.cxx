@@ -22,6 +22,7 @@
 #include "vtkBox.h"
 
 #include <math.h>
+#include <vtkstd/vector>
 
 vtkStandardNewMacro(vtkCellLocator);
 
@@ -1189,7 +1190,15 @@ void vtkCellLocator::ForceBuildLocator()
     vtkDebugMacro(<< "BuildLocator exited - UseExistingSearchStructure");
     return;
   }
+  if (this->ReadSearchStructureFromCache())
+    {
+    return;
+    }
   this->BuildLocatorInternal();
+  if (this->Tree)
+    {
+    this->WriteSearchStructureToCache();
+    }
 }
 //---------------------------------------------------------------------------
 //  Method to form subdivision of space based on the cells provided and
@@ -2001,4 +2010,212 @@ void vtkCellLocator::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os,indent);
 }
+
+//----------------------------------------------------------------------------
+int vtkCellLocator::GetSearchStructureParameters(double params[8])
+{
+  int n = this->Superclass::GetSearchStructureParameters(params);
+  params[n++] = this->Automatic ? -1 :
+    (this->Level < this->MaxLevel ? this->Level : this->MaxLevel);
+  return n;
+}
+
+//----------------------------------------------------------------------------
+// The octants are written as one array of sizes (-1 for empty octants,
+// -2 for parent octants containing cells) followed by all the cell ids.
+int vtkCellLocator::WriteSearchStructure(const char *fileName)
+{
+  if (!this->Tree || !this->DataSet)
+    {
+    vtkErrorMacro(<< "No search structure to write");
+    return 0;
+    }
+
+  ofstream os(fileName, ios::out | ios::binary);
+  if (!os)
+    {
+    vtkErrorMacro(<< "Cannot open " << fileName << " for writing");
+    return 0;
+    }
+
+  this->WriteSearchStructureHeader(os);
+
+  int i;
+  vtkIdType numIds = 0;
+  vtkIdType *sizes = new vtkIdType [this->NumberOfOctants];
+  for (i=0; i < this->NumberOfOctants; i++)
+    {
+    vtkIdList *octant = this->Tree[i];
+    if (octant == NULL)
+      {
+      sizes[i] = -1;
+      }
+    else if (octant == reinterpret_cast<void *>(VTK_CELL_INSIDE))
+      {
+      sizes[i] = -2;
+      }
+    else
+      {
+      sizes[i] = octant->GetNumberOfIds();
+      numIds += sizes[i];
+      }
+    }
+
+  os.write(reinterpret_cast<char *>(&this->Level), sizeof(int));
+  os.write(reinterpret_cast<char *>(&this->NumberOfDivisions), sizeof(int));
+  os.write(reinterpret_cast<char *>(&this->NumberOfOctants), sizeof(int));
+  os.write(reinterpret_cast<char *>(this->Bounds), 6*sizeof(double));
+  os.write(reinterpret_cast<char *>(this->H), 3*sizeof(double));
+  os.write(reinterpret_cast<char *>(&numIds), sizeof(vtkIdType));
+  os.write(reinterpret_cast<char *>(sizes),
+           this->NumberOfOctants*sizeof(vtkIdType));
+  for (i=0; i < this->NumberOfOctants; i++)
+    {
+    if (sizes[i] > 0)
+      {
+      os.write(reinterpret_cast<char *>(this->Tree[i]->GetPointer(0)),
+               sizes[i]*sizeof(vtkIdType));
+      }
+    }
+  delete [] sizes;
+
+  if (!os)
+    {
+    vtkErrorMacro(<< "Error writing " << fileName);
+    return 0;
+    }
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkCellLocator::ReadSearchStructure(const char *fileName)
+{
+  size_t size;
+  char *data = vtkAbstractCellLocator::ReadWholeFile(fileName, size);
+  if (!data)
+    {
+    vtkErrorMacro(<< "Cannot read " << fileName);
+    return 0;
+    }
+  const char *buffer = data;
+  const char *end = data + size;
+
+  int level, ndivs, numOctants;
+  double bounds[6], h[3];
+  vtkIdType numIds;
+  if (!this->ReadSearchStructureHeader(buffer, end) ||
+      !vtkAbstractCellLocator::ReadFromBuffer(buffer, end, &level,
+                                              sizeof(int)) ||
+      !vtkAbstractCellLocator::ReadFromBuffer(buffer, end, &ndivs,
+                                              sizeof(int)) ||
+      !vtkAbstractCellLocator::ReadFromBuffer(buffer, end, &numOctants,
+                                              sizeof(int)) ||
+      !vtkAbstractCellLocator::ReadFromBuffer(buffer, end, bounds,
+                                              6*sizeof(double)) ||
+      !vtkAbstractCellLocator::ReadFromBuffer(buffer, end, h,
+                                              3*sizeof(double)) ||
+      !vtkAbstractCellLocator::ReadFromBuffer(buffer, end, &numIds,
+                                              sizeof(vtkIdType)) ||
+      numOctants < 1 || numIds < 0 || numIds > end - buffer ||
+      static_cast<size_t>(end - buffer) !=
+      (numOctants + numIds)*sizeof(vtkIdType))
+    {
+    vtkDebugMacro(<< fileName << " does not hold a matching octree");
+    delete [] data;
+    return 0;
+    }
+
+  // The octree must have the geometry of its level, and the lists must
+  // hold all the ids, each of them a cell of the data set.  The buffer is
+  // not aligned for vtkIdType, so the values are copied out of it.
+  vtkIdType expectedOctants = 0;
+  vtkIdType octantsOfLevel = 1;
+  int maxLevel = (level < 10 ? level : 10);
+  for (int l=0; l <= maxLevel; l++)
+    {
+    expectedOctants += octantsOfLevel;
+    octantsOfLevel *= 8;
+    }
+  vtkstd::vector<vtkIdType> sizes(numOctants);
+  memcpy(&sizes[0], buffer, numOctants*sizeof(vtkIdType));
+  const char *ids = buffer + numOctants*sizeof(vtkIdType);
+  vtkIdType numCells = this->DataSet->GetNumberOfCells();
+  int valid = (level >= 0 && level <= 10 && ndivs == (1 << level) &&
+               numOctants == expectedOctants);
+  vtkIdType totalIds = 0;
+  for (int octant=0; valid && octant < numOctants; octant++)
+    {
+    valid = (sizes[octant] >= -2);
+    totalIds += (sizes[octant] > 0 ? sizes[octant] : 0);
+    }
+  valid = (valid && totalIds == numIds);
+  for (vtkIdType j=0; valid && j < numIds; j++)
+    {
+    vtkIdType cellId;
+    memcpy(&cellId, ids + j*sizeof(vtkIdType), sizeof(vtkIdType));
+    valid = (cellId >= 0 && cellId < numCells);
+    }
+  if (!valid)
+    {
+    vtkDebugMacro(<< fileName << " does not hold a valid octree");
+    delete [] data;
+    return 0;
+    }
+
+  this->FreeSearchStructure();
+  if (this->CellHasBeenVisited)
+    {
+    delete [] this->CellHasBeenVisited;
+    this->CellHasBeenVisited = NULL;
+    }
+  this->FreeCellBounds();
+
+  this->Level = level;
+  this->NumberOfDivisions = ndivs;
+  this->NumberOfOctants = numOctants;
+  for (int i=0; i < 3; i++)
+    {
+    this->Bounds[2*i] = bounds[2*i];
+    this->Bounds[2*i+1] = bounds[2*i+1];
+    this->H[i] = h[i];
+    }
+
+  typedef vtkIdList *vtkIdListPtr;
+  this->Tree = new vtkIdListPtr[numOctants];
+  for (int octant=0; octant < numOctants; octant++)
+    {
+    vtkIdType n = sizes[octant];
+    if (n == -1)
+      {
+      this->Tree[octant] = NULL;
+      }
+    else if (n == -2)
+      {
+      this->Tree[octant] = reinterpret_cast<vtkIdList *>(VTK_CELL_INSIDE);
+      }
+    else
+      {
+      vtkIdList *list = vtkIdList::New();
+      list->SetNumberOfIds(n);
+      if (n > 0)
+        {
+        memcpy(list->GetPointer(0), ids, n*sizeof(vtkIdType));
+        }
+      ids += n*sizeof(vtkIdType);
+      this->Tree[octant] = list;
+      }
+    }
+  delete [] data;
+
+  this->CellHasBeenVisited = new unsigned char [ numCells ];
+  this->ClearCellHasBeenVisited();
+  this->QueryNumber = 0;
+  if (this->CacheCellBounds)
+    {
+    this->StoreCellBounds();
+    }
+
+  this->BuildTime.Modified();
+  return 1;
+}
   
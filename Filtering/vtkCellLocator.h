@@ -223,11 +223,19 @@ public:
   virtual void ForceBuildLocator();
   virtual void BuildLocatorInternal();
   virtual void GenerateRepresentation(int level, vtkPolyData *pd);
+
+  // Description:
+  // Write the octree to a binary file, or read it back.  See
+  // vtkAbstractCellLocator::SetCacheDirectory() to do this automatically.
+  virtual int WriteSearchStructure(const char *fileName);
+  virtual int ReadSearchStructure(const char *fileName);
   
 protected:
   vtkCellLocator();
   ~vtkCellLocator();
 
+  virtual int GetSearchStructureParameters(double params[8]);
+
   void GetBucketNeighbors(int ijk[3], int ndivs, int level);
   void GetOverlappingBuckets(double x[3], int ijk[3], double dist, 
                              int prevMinLevel[3], int prevMaxLevel[3]);
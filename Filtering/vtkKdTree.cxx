@@ -27,6 +27,7 @@
 #include "vtkDataSet.h"
 #include "vtkDataSetCollection.h"
 #include "vtkFloatArray.h"
+#include "vtkGenericCell.h"
 #include "vtkMath.h"
 #include "vtkCell.h"
 #include "vtkCellArray.h"
@@ -36,6 +37,7 @@
 #include "vtkPoints.h"
 #include "vtkIdTypeArray.h"
 #include "vtkIntArray.h"
+#include "vtkMultiThreader.h"
 #include "vtkPointSet.h"
 #include "vtkImageData.h"
 #include "vtkUniformGrid.h"
@@ -50,6 +52,7 @@
 #include <vtkstd/map>
 #include <vtkstd/queue>
 #include <vtkstd/set>
+#include <vtkstd/vector>
 
 
 // Timing data ---------------------------------------------
@@ -172,6 +175,140 @@ namespace
     float LargestDist2;
     vtkstd::map<float, vtkstd::list<vtkIdType> > dist2ToIds; // map from dist^2 to a list of ids
   };
+
+  // Compute the squared distances from x to the closest and the farthest
+  // corner of the spatial bounds of a k-d tree node.
+  void vtkKdTreeNodeDistance2(vtkKdNode *node, const double x[3],
+                              double &mindist2, double &maxdist2)
+  {
+    double b[6];
+    node->GetBounds(b);
+
+    mindist2 = 0; // distance to closest vertex of BB
+    maxdist2 = 0; // distance to furthest vertex of BB
+    // x-dir
+    if(x[0] < b[0])
+      {
+      mindist2 = (b[0]-x[0])*(b[0]-x[0]);
+      maxdist2 = (b[1]-x[0])*(b[1]-x[0]);
+      }
+    else if(x[0] > b[1])
+      {
+      mindist2 = (b[1]-x[0])*(b[1]-x[0]);
+      maxdist2 = (b[0]-x[0])*(b[0]-x[0]);
+      }
+    else if((b[1]-x[0]) > (x[0]-b[0]))
+      {
+      maxdist2 = (b[1]-x[0])*(b[1]-x[0]);
+      }
+    else
+      {
+      maxdist2 = (b[0]-x[0])*(b[0]-x[0]);
+      }
+    // y-dir
+    if(x[1] < b[2])
+      {
+      mindist2 += (b[2]-x[1])*(b[2]-x[1]);
+      maxdist2 += (b[3]-x[1])*(b[3]-x[1]);
+      }
+    else if(x[1] > b[3])
+      {
+      mindist2 += (b[3]-x[1])*(b[3]-x[1]);
+      maxdist2 += (b[2]-x[1])*(b[2]-x[1]);
+      }
+    else if((b[3]-x[1]) > (x[1]-b[2]))
+      {
+      maxdist2 += (b[3]-x[1])*(b[3]-x[1]);
+      }
+    else
+      {
+      maxdist2 += (b[2]-x[1])*(b[2]-x[1]);
+      }
+    // z-dir
+    if(x[2] < b[4])
+      {
+      mindist2 += (b[4]-x[2])*(b[4]-x[2]);
+      maxdist2 += (b[5]-x[2])*(b[5]-x[2]);
+      }
+    else if(x[2] > b[5])
+      {
+      mindist2 += (b[5]-x[2])*(b[5]-x[2]);
+      maxdist2 += (b[4]-x[2])*(b[4]-x[2]);
+      }
+    else if((b[5]-x[2]) > (x[2]-b[4]))
+      {
+      maxdist2 += (b[5]-x[2])*(b[5]-x[2]);
+      }
+    else
+      {
+      maxdist2 += (x[2]-b[4])*(x[2]-b[4]);
+      }
+  }
+
+  // Entry of the best-first queue used by vtkKdTree::FindClosestNPoints().
+  // The comparison is reversed so the closest node is on top.
+  class NodeDistance2
+  {
+  public:
+    NodeDistance2(vtkKdNode *node, double dist2)
+      {
+        this->Node = node;
+        this->Dist2 = dist2;
+      }
+    bool operator<(const NodeDistance2 &other) const
+      {
+        return this->Dist2 > other.Dist2;
+      }
+    vtkKdNode *Node;
+    double Dist2;
+  };
+
+  // Shared state for the batched, threaded queries
+  struct vtkKdTreeBatchQuery
+  {
+    vtkKdTree *Tree;
+    vtkPoints *QueryPoints;
+    int N;
+    double Radius;
+    vtkIdTypeArray *Result;
+    vtkIdList **Lists;
+  };
+
+  // A subtree still to be divided by vtkKdTree::DivideRegionInParallel()
+  struct vtkKdTreeBuildTask
+  {
+    vtkKdNode *Node;
+    float *Centers;
+    int *Ids;
+    int Level;
+  };
+
+  // Shared state for the threaded tree build
+  struct vtkKdTreeBuildState
+  {
+    vtkKdTree *Tree;
+    vtkKdNode *Top;
+    // cell centers of these data sets, FirstCell[i] being the index of
+    // the first cell of DataSets[i]
+    vtkstd::vector<vtkDataSet *> DataSets;
+    vtkstd::vector<int> FirstCell;
+    int MaxCellSize;
+    float *Centers;
+    int NumberOfCenters;
+    int *RegionIds;
+    vtkstd::vector<vtkKdTreeBuildTask> *Tasks;
+    int SplitOnly;
+  };
+
+  // Below this many cells or points per thread, the tree is built serially
+  const int vtkKdTreeMinimumPerThread = 1000;
+
+  int vtkKdTreeNumberOfThreads(int maxThreads, int num)
+  {
+    int numThreads = num / vtkKdTreeMinimumPerThread;
+    numThreads = (numThreads > maxThreads) ? maxThreads : numThreads;
+    return (numThreads < 1) ? 1 : numThreads;
+  }
 }
 
 vtkStandardNewMacro(vtkKdTree);
@@ -187,6 +324,10 @@ vtkKdTree::vtkKdTree()
   this->NumberOfRegionsOrLess = 0;
   this->NumberOfRegionsOrMore = 0;
 
+  this->ApproximationFactor = 0.0;
+  this->MaximumNumberOfRegionVisits = 0;
+  this->NumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+
   this->ValidDirections =
   (1 << vtkKdTree::XDIM) | (1 << vtkKdTree::YDIM) | (1 << vtkKdTree::ZDIM);
 
@@ -601,16 +742,47 @@ float *vtkKdTree::ComputeCellCenters(int set)
 float *vtkKdTree::ComputeCellCenters(vtkDataSet *set)
 {
   this->UpdateSubOperationProgress(0);
-  int totalCells;
+
+  vtkKdTreeBuildState state;
+  state.Tree = this;
+  state.MaxCellSize = 0;
 
   if (set)
     {
-    totalCells = set->GetNumberOfCells();
+    state.DataSets.push_back(set);
     }
   else
     {
-    totalCells = this->GetNumberOfCells();   // all data sets
+    vtkCollectionSimpleIterator cookie;
+    this->DataSets->InitTraversal(cookie);
+    for (vtkDataSet *iset = this->DataSets->GetNextDataSet(cookie);
+         iset != NULL; iset = this->DataSets->GetNextDataSet(cookie))
+      {
+      state.DataSets.push_back(iset);
+      }
+    }
+
+  // GetCell(cellId, vtkGenericCell*) is thread safe once it has been
+  // called from a single thread, which builds the cell structures of
+  // the data set if needed.
+  vtkGenericCell *cell = vtkGenericCell::New();
+  int totalCells = 0;
+  state.FirstCell.push_back(0);
+  for (size_t i=0; i < state.DataSets.size(); i++)
+    {
+    vtkDataSet *iset = state.DataSets[i];
+    int nCells = iset->GetNumberOfCells();
+    if (nCells > 0)
+      {
+      iset->GetCell(0, cell);
+      }
+    int cellSize = iset->GetMaxCellSize();
+    state.MaxCellSize = (cellSize > state.MaxCellSize) ?
+      cellSize : state.MaxCellSize;
+    totalCells += nCells;
+    state.FirstCell.push_back(totalCells);
     }
+  cell->Delete();
 
   if (totalCells == 0) 
     {
@@ -624,72 +796,68 @@ float *vtkKdTree::ComputeCellCenters(vtkDataSet *set)
     return NULL;
     }
 
-  int maxCellSize = 0;
+  state.Centers = center;
 
-  if (set)
-    {
-    maxCellSize = set->GetMaxCellSize();
-    }
-  else
-    {
-    vtkCollectionSimpleIterator cookie;
-    this->DataSets->InitTraversal(cookie);
-    for (vtkDataSet *iset = this->DataSets->GetNextDataSet(cookie);
-         iset != NULL; iset = this->DataSets->GetNextDataSet(cookie))
-      {
-      int cellSize = iset->GetMaxCellSize();
-      maxCellSize = (cellSize > maxCellSize) ? cellSize : maxCellSize;
-      }
-    }
+  vtkMultiThreader *threader = vtkMultiThreader::New();
+  threader->SetNumberOfThreads(
+    vtkKdTreeNumberOfThreads(this->NumberOfThreads, totalCells));
+  threader->SetSingleMethod(vtkKdTree::ThreadedComputeCellCenters, &state);
+  threader->SingleMethodExecute();
+  threader->Delete();
 
-  double *weights = new double [maxCellSize];
+  this->UpdateSubOperationProgress(1.0);
+  return center;
+}
 
-  float *cptr = center;
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkKdTree::ThreadedComputeCellCenters(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkKdTreeBuildState *state =
+    static_cast<vtkKdTreeBuildState *>(info->UserData);
+
+  int totalCells = state->FirstCell.back();
+  int begin = static_cast<int>(
+    static_cast<vtkIdType>(totalCells) * info->ThreadID /
+    info->NumberOfThreads);
+  int end = static_cast<int>(
+    static_cast<vtkIdType>(totalCells) * (info->ThreadID + 1) /
+    info->NumberOfThreads);
+
+  // the data set holding cell "begin"
+  size_t setIndex = vtkstd::upper_bound(state->FirstCell.begin(),
+                                        state->FirstCell.end(), begin) -
+    state->FirstCell.begin() - 1;
+
+  vtkGenericCell *cell = vtkGenericCell::New();
+  double *weights = new double [state->MaxCellSize + 1];
+  float *cptr = state->Centers + 3*begin;
   double dcenter[3];
 
-  if (set)
+  for (int j=begin; j<end; j++)
     {
-    for (int j=0; j<totalCells; j++)
+    while (j >= state->FirstCell[setIndex+1])
       {
-      this->ComputeCellCenter(set->GetCell(j), dcenter, weights);
-      cptr[0] = static_cast<float>(dcenter[0]);
-      cptr[1] = static_cast<float>(dcenter[1]);
-      cptr[2] = static_cast<float>(dcenter[2]);
-      cptr += 3;
-      if (j%1000 == 0)
-        {
-        this->UpdateSubOperationProgress(static_cast<double>(j)/totalCells);
-        }
+      setIndex++;
       }
-    }
-  else
-    {
-    vtkCollectionSimpleIterator cookie;
-    this->DataSets->InitTraversal(cookie);
-    for (vtkDataSet *iset = this->DataSets->GetNextDataSet(cookie);
-         iset != NULL; iset = this->DataSets->GetNextDataSet(cookie))
+    state->DataSets[setIndex]->GetCell(j - state->FirstCell[setIndex], cell);
+    state->Tree->ComputeCellCenter(cell, dcenter, weights);
+    cptr[0] = static_cast<float>(dcenter[0]);
+    cptr[1] = static_cast<float>(dcenter[1]);
+    cptr[2] = static_cast<float>(dcenter[2]);
+    cptr += 3;
+    if (info->ThreadID == 0 && (j-begin)%1000 == 0)
       {
-      int nCells = iset->GetNumberOfCells();
-
-      for (int j=0; j<nCells; j++)
-        {
-        this->ComputeCellCenter(iset->GetCell(j), dcenter, weights);
-        cptr[0] = static_cast<float>(dcenter[0]);
-        cptr[1] = static_cast<float>(dcenter[1]);
-        cptr[2] = static_cast<float>(dcenter[2]);
-        cptr += 3;
-        if (j%1000 == 0)
-          {
-          this->UpdateSubOperationProgress(static_cast<double>(j)/totalCells);
-          }
-        }
+      state->Tree->UpdateSubOperationProgress(
+        static_cast<double>(j-begin)/(end-begin));
       }
     }
 
   delete [] weights;
+  cell->Delete();
 
-  this->UpdateSubOperationProgress(1.0);
-  return center;
+  return VTK_THREAD_RETURN_VALUE;
 }
 
 //----------------------------------------------------------------------------
@@ -916,7 +1084,7 @@ void vtkKdTree::BuildLocator()
   
     this->ProgressOffset += this->ProgressScale;
     this->ProgressScale = 0.7;
-    this->DivideRegion(kd, ptarray, NULL, 0);
+    this->DivideRegionInParallel(kd, ptarray, NULL);
   
     TIMERDONE("Build tree");
   
@@ -1244,6 +1412,26 @@ int vtkKdTree::DivideTest(int size, int level)
 }
 //----------------------------------------------------------------------------
 int vtkKdTree::DivideRegion(vtkKdNode *kd, float *c1, int *ids, int level)
+{
+  if (!this->SplitRegion(kd, c1, ids, level))
+    {
+    return 0;   // unable to divide region further
+    }
+
+  int nleft = kd->GetLeft()->GetNumberOfPoints();
+
+  int *leftIds  = ids;
+  int *rightIds = ids ? ids + nleft : NULL;
+  
+  this->DivideRegion(kd->GetLeft(), c1, leftIds, level + 1);
+  
+  this->DivideRegion(kd->GetRight(), c1 + nleft*3, rightIds, level + 1);
+  
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+int vtkKdTree::SplitRegion(vtkKdNode *kd, float *c1, int *ids, int level)
 {
   int ok = this->DivideTest(kd->GetNumberOfPoints(), level);
 
@@ -1298,21 +1486,104 @@ int vtkKdTree::DivideRegion(vtkKdNode *kd, float *c1, int *ids, int level)
 
   this->DoMedianFind(kd, c1, ids, dim1, dim2, dim3);
 
-  if (kd->GetLeft() == NULL)
+  return (kd->GetLeft() != NULL);
+}
+
+//----------------------------------------------------------------------------
+// The two halves of a divided region are independent, so the subtrees
+// can be divided concurrently.  The top levels are split breadth first,
+// each node by one thread, until there are enough subtrees to keep all
+// threads busy; the subtrees are then divided completely.
+//
+void vtkKdTree::DivideRegionInParallel(vtkKdNode *kd, float *c1, int *ids)
+{
+  int maxThreads =
+    vtkKdTreeNumberOfThreads(this->NumberOfThreads, kd->GetNumberOfPoints());
+
+  if (maxThreads < 2)
     {
-    return 0;   // unable to divide region further
+    this->DivideRegion(kd, c1, ids, 0);
+    return;
     }
 
-  int nleft = kd->GetLeft()->GetNumberOfPoints();
+  vtkstd::vector<vtkKdTreeBuildTask> tasks(1);
+  tasks[0].Node = kd;
+  tasks[0].Centers = c1;
+  tasks[0].Ids = ids;
+  tasks[0].Level = 0;
 
-  int *leftIds  = ids;
-  int *rightIds = ids ? ids + nleft : NULL;
-  
-  this->DivideRegion(kd->GetLeft(), c1, leftIds, level + 1);
-  
-  this->DivideRegion(kd->GetRight(), c1 + nleft*3, rightIds, level + 1);
-  
-  return 0;
+  vtkKdTreeBuildState state;
+  state.Tree = this;
+  state.Tasks = &tasks;
+
+  vtkMultiThreader *threader = vtkMultiThreader::New();
+  threader->SetSingleMethod(vtkKdTree::ThreadedDivideRegions, &state);
+
+  state.SplitOnly = 1;
+  while (!tasks.empty() && static_cast<int>(tasks.size()) < 4*maxThreads)
+    {
+    int numTasks = static_cast<int>(tasks.size());
+    threader->SetNumberOfThreads(numTasks < maxThreads ? numTasks : maxThreads);
+    threader->SingleMethodExecute();
+
+    vtkstd::vector<vtkKdTreeBuildTask> children;
+    for (int i=0; i < numTasks; i++)
+      {
+      vtkKdNode *node = tasks[i].Node;
+      if (node->GetLeft() == NULL)
+        {
+        continue;
+        }
+      int nleft = node->GetLeft()->GetNumberOfPoints();
+      vtkKdTreeBuildTask child = tasks[i];
+      child.Level++;
+      child.Node = node->GetLeft();
+      children.push_back(child);
+      child.Node = node->GetRight();
+      child.Centers += nleft*3;
+      child.Ids = child.Ids ? child.Ids + nleft : NULL;
+      children.push_back(child);
+      }
+    tasks.swap(children);
+    }
+
+  if (!tasks.empty())
+    {
+    int numTasks = static_cast<int>(tasks.size());
+    state.SplitOnly = 0;
+    threader->SetNumberOfThreads(numTasks < maxThreads ? numTasks : maxThreads);
+    threader->SingleMethodExecute();
+    }
+
+  threader->Delete();
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkKdTree::ThreadedDivideRegions(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkKdTreeBuildState *state =
+    static_cast<vtkKdTreeBuildState *>(info->UserData);
+
+  vtkstd::vector<vtkKdTreeBuildTask> &tasks = *state->Tasks;
+  int numTasks = static_cast<int>(tasks.size());
+
+  for (int i = info->ThreadID; i < numTasks; i += info->NumberOfThreads)
+    {
+    vtkKdTreeBuildTask &task = tasks[i];
+    if (state->SplitOnly)
+      {
+      state->Tree->SplitRegion(task.Node, task.Centers, task.Ids, task.Level);
+      }
+    else
+      {
+      state->Tree->DivideRegion(task.Node, task.Centers, task.Ids,
+                                task.Level);
+      }
+    }
+
+  return VTK_THREAD_RETURN_VALUE;
 }
 
 //----------------------------------------------------------------------------
@@ -1877,7 +2148,7 @@ void vtkKdTree::BuildLocatorFromPoints(vtkPoints **ptArrays, int numPtArrays)
 
   TIMER("Build tree");
 
-  this->DivideRegion(kd, points, ptIds, 0);
+  this->DivideRegionInParallel(kd, points, ptIds);
 
   this->SetActualLevel();
   this->BuildRegionList();
@@ -2454,8 +2725,8 @@ void vtkKdTree::FindPointsWithinRadius(double R, const double x[3],
 }
 
 //----------------------------------------------------------------------------
-void vtkKdTree::FindPointsWithinRadius(vtkKdNode* node, double R2, 
-                                       const double x[3], 
+void vtkKdTree::FindPointsWithinRadius(vtkKdNode* top, double R2,
+                                       const double x[3],
                                        vtkIdList* result)
 
 {
@@ -2465,105 +2736,61 @@ void vtkKdTree::FindPointsWithinRadius(vtkKdNode* node, double R2,
     return;
     }
 
-  double b[6];
-  node->GetBounds(b);
+  // Whole regions are accepted once they lie within the (possibly
+  // enlarged) radius; partially covered leaves are still tested exactly.
+  double eps1 = 1.0 + this->ApproximationFactor;
+  double acceptR2 = R2 * eps1 * eps1;
 
-  double mindist2 = 0; // distance to closest vertex of BB
-  double maxdist2 = 0; // distance to furthest vertex of BB
-  // x-dir
-  if(x[0] < b[0])
-    {
-    mindist2 = (b[0]-x[0])*(b[0]-x[0]);
-    maxdist2 = (b[1]-x[0])*(b[1]-x[0]);
-    }
-  else if(x[0] > b[1])
-    {
-    mindist2 = (b[1]-x[0])*(b[1]-x[0]);
-    maxdist2 = (b[0]-x[0])*(b[0]-x[0]);
-    }
-  else if((b[1]-x[0]) > (x[0]-b[0]))
-    {
-    maxdist2 = (b[1]-x[0])*(b[1]-x[0]);    
-    }
-  else
-    {
-    maxdist2 = (b[0]-x[0])*(b[0]-x[0]);
-    }
-  // y-dir
-  if(x[1] < b[2])
-    {
-    mindist2 += (b[2]-x[1])*(b[2]-x[1]);
-    maxdist2 += (b[3]-x[1])*(b[3]-x[1]);
-    }
-  else if(x[1] > b[3])
-    {
-    mindist2 += (b[3]-x[1])*(b[3]-x[1]);
-    maxdist2 += (b[2]-x[1])*(b[2]-x[1]);
-    }
-  else if((b[3]-x[1]) > (x[1]-b[2]))
-    {
-    maxdist2 += (b[3]-x[1])*(b[3]-x[1]);
-    }
-  else
-    {
-    maxdist2 += (b[2]-x[1])*(b[2]-x[1]);
-    }
-  // z-dir
-  if(x[2] < b[4])
-    {
-    mindist2 += (b[4]-x[2])*(b[4]-x[2]);
-    maxdist2 += (b[5]-x[2])*(b[5]-x[2]);
-    }
-  else if(x[2] > b[5])
-    {
-    mindist2 += (b[5]-x[2])*(b[5]-x[2]);
-    maxdist2 += (b[4]-x[2])*(b[4]-x[2]);
-    }
-  else if((b[5]-x[2]) > (x[2]-b[4]))
-    {
-    maxdist2 += (b[5]-x[2])*(b[5]-x[2]);
-    }
-  else
-    {
-    maxdist2 += (x[2]-b[4])*(x[2]-b[4]);
-    }
+  vtkstd::vector<vtkKdNode*> nodeStack;
+  nodeStack.push_back(top);
 
-  if(mindist2 > R2)
+  while (!nodeStack.empty())
     {
-    // non-intersecting
-    return;
-    }
+    vtkKdNode *node = nodeStack.back();
+    nodeStack.pop_back();
 
-  if(maxdist2 <= R2)
-    {
-    // sphere contains BB
-    this->AddAllPointsInRegion(node, result);
-    return;
-    }
+    double mindist2, maxdist2;
+    vtkKdTreeNodeDistance2(node, x, mindist2, maxdist2);
 
-  // partial intersection of sphere & BB
-  if (node->GetLeft() == NULL)
-    {
-    int regionID = node->GetID();
-    int regionLoc = this->LocatorRegionLocation[regionID];
-    float* pt = this->LocatorPoints + (regionLoc * 3);
-    vtkIdType numPoints = this->RegionList[regionID]->GetNumberOfPoints();
-    for (vtkIdType i = 0; i < numPoints; i++)
+    if(mindist2 > R2)
       {
-      double dist2 = (pt[0]-x[0])*(pt[0]-x[0])+
-        (pt[1]-x[1])*(pt[1]-x[1])+(pt[2]-x[2])*(pt[2]-x[2]);
-      if(dist2 <= R2)
+      // non-intersecting
+      continue;
+      }
+
+    if(maxdist2 <= acceptR2)
+      {
+      // sphere contains BB
+      this->AddAllPointsInRegion(node, result);
+      continue;
+      }
+
+    // partial intersection of sphere & BB
+    if (node->GetLeft() == NULL)
+      {
+      int regionID = node->GetID();
+      int regionLoc = this->LocatorRegionLocation[regionID];
+      float* pt = this->LocatorPoints + (regionLoc * 3);
+      vtkIdType numPoints = this->RegionList[regionID]->GetNumberOfPoints();
+      for (vtkIdType i = 0; i < numPoints; i++)
         {
-        vtkIdType ptId = static_cast<vtkIdType>(this->LocatorIds[regionLoc + i]);
-        result->InsertNextId(ptId);
+        double dist2 = (pt[0]-x[0])*(pt[0]-x[0])+
+          (pt[1]-x[1])*(pt[1]-x[1])+(pt[2]-x[2])*(pt[2]-x[2]);
+        if(dist2 <= R2)
+          {
+          vtkIdType ptId = static_cast<vtkIdType>(this->LocatorIds[regionLoc + i]);
+          result->InsertNextId(ptId);
+          }
+        pt += 3;
         }
-      pt += 3;
       }
-    }
-  else
-    {
-    this->FindPointsWithinRadius(node->GetLeft(), R2, x, result);
-    this->FindPointsWithinRadius(node->GetRight(), R2, x, result);
+    else
+      {
+      // push right first so the left subtree is visited first, giving
+      // the same ordering as a depth first recursion
+      nodeStack.push_back(node->GetRight());
+      nodeStack.push_back(node->GetLeft());
+      }
     }
 }
 
@@ -2683,18 +2910,28 @@ void vtkKdTree::FindClosestNPoints(int N, const double x[3],
     pt += 3;
     }
 
-  // to finish up we have to check other regions for 
-  // closer points
+  // to finish up we have to check other regions for
+  // closer points.  Regions are visited closest first so that the
+  // search can stop as soon as no remaining region can improve the
+  // result (or the visit budget is used up).
   float LargestDist2 = orderedPoints.GetLargestDist2();
+  double eps1 = 1.0 + this->ApproximationFactor;
+  double shrink = 1.0 / (eps1 * eps1);
+  int numVisits = 1; // the starting region has been searched
   double delta[3] = {0,0,0};
   double bounds[6];
-  node = this->Top;
-  vtkstd::queue<vtkKdNode*> nodesToBeSearched;
-  nodesToBeSearched.push(node);
+  vtkstd::priority_queue<NodeDistance2> nodesToBeSearched;
+  nodesToBeSearched.push(NodeDistance2(this->Top, 0.0));
   while(!nodesToBeSearched.empty())
     {
-    node = nodesToBeSearched.front();
+    NodeDistance2 next = nodesToBeSearched.top();
     nodesToBeSearched.pop();
+    if(next.Dist2 >= LargestDist2 * shrink)
+      {
+      // every node left in the queue is at least this far away
+      break;
+      }
+    node = next.Node;
     if(node == startingNode)
       {
       continue;
@@ -2702,21 +2939,29 @@ void vtkKdTree::FindClosestNPoints(int N, const double x[3],
     vtkKdNode* left = node->GetLeft();
     if(left)
       {
-      left->GetDataBounds(bounds);
-      if(vtkMath::PointIsWithinBounds(const_cast<double*>(x), bounds, delta) == 1 ||
-         left->GetDistance2ToBoundary(x[0], x[1], x[2], 1) < LargestDist2)
+      vtkKdNode* children[2] = {left, node->GetRight()};
+      for (int c=0; c<2; c++)
         {
-        nodesToBeSearched.push(left);
-        }
-      node->GetRight()->GetDataBounds(bounds);
-      if(vtkMath::PointIsWithinBounds(const_cast<double*>(x), bounds, delta) == 1 ||
-         node->GetRight()->GetDistance2ToBoundary(x[0], x[1], x[2], 1) < LargestDist2)
-        {
-        nodesToBeSearched.push(node->GetRight());
+        children[c]->GetDataBounds(bounds);
+        double dist2 = 0.0;
+        if(vtkMath::PointIsWithinBounds(const_cast<double*>(x), bounds, delta) != 1)
+          {
+          dist2 = children[c]->GetDistance2ToBoundary(x[0], x[1], x[2], 1);
+          }
+        if(dist2 < LargestDist2 * shrink)
+          {
+          nodesToBeSearched.push(NodeDistance2(children[c], dist2));
+          }
         }
       }
-    else if(node->GetDistance2ToBoundary(x[0], x[1], x[2], 1) < LargestDist2)
+    else
       {
+      if(this->MaximumNumberOfRegionVisits > 0 &&
+         numVisits >= this->MaximumNumberOfRegionVisits)
+        {
+        break;
+        }
+      numVisits++;
       regionId = node->GetID();
       numPoints = node->GetNumberOfPoints();
       where = this->LocatorRegionLocation[regionId];
@@ -2733,6 +2978,160 @@ void vtkKdTree::FindClosestNPoints(int N, const double x[3],
     }
   orderedPoints.GetSortedIds(result);
 }
+
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkKdTree::ThreadedFindClosestNPoints(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkKdTreeBatchQuery *query =
+    static_cast<vtkKdTreeBatchQuery *>(info->UserData);
+
+  vtkIdType numQueries = query->QueryPoints->GetNumberOfPoints();
+  vtkIdType begin = numQueries * info->ThreadID / info->NumberOfThreads;
+  vtkIdType end = numQueries * (info->ThreadID + 1) / info->NumberOfThreads;
+
+  vtkIdList *ids = vtkIdList::New();
+  vtkIdType *out = query->Result->GetPointer(begin * query->N);
+  double x[3];
+  for (vtkIdType i = begin; i < end; i++)
+    {
+    query->QueryPoints->GetPoint(i, x);
+    query->Tree->FindClosestNPoints(query->N, x, ids);
+    vtkIdType numIds = ids->GetNumberOfIds();
+    for (int j = 0; j < query->N; j++)
+      {
+      *out++ = (j < numIds) ? ids->GetId(j) : -1;
+      }
+    }
+  ids->Delete();
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkKdTree::ThreadedFindPointsWithinRadius(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkKdTreeBatchQuery *query =
+    static_cast<vtkKdTreeBatchQuery *>(info->UserData);
+
+  vtkIdType numQueries = query->QueryPoints->GetNumberOfPoints();
+  vtkIdType begin = numQueries * info->ThreadID / info->NumberOfThreads;
+  vtkIdType end = numQueries * (info->ThreadID + 1) / info->NumberOfThreads;
+
+  double x[3];
+  for (vtkIdType i = begin; i < end; i++)
+    {
+    query->QueryPoints->GetPoint(i, x);
+    query->Lists[i] = vtkIdList::New();
+    query->Tree->FindPointsWithinRadius(query->Radius, x, query->Lists[i]);
+    }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+void vtkKdTree::FindClosestNPoints(int N, vtkPoints *queryPoints,
+                                   vtkIdTypeArray *result)
+{
+  if (!this->LocatorPoints)
+    {
+    vtkErrorMacro(<< "vtkKdTree::FindClosestNPoints - must build locator first");
+    return;
+    }
+  if (N <= 0 || !queryPoints || !result)
+    {
+    return;
+    }
+
+  vtkIdType numQueries = queryPoints->GetNumberOfPoints();
+  result->Initialize();
+  result->SetNumberOfComponents(N);
+  result->SetNumberOfTuples(numQueries);
+
+  vtkKdTreeBatchQuery query;
+  query.Tree = this;
+  query.QueryPoints = queryPoints;
+  query.N = N;
+  query.Radius = 0.0;
+  query.Result = result;
+  query.Lists = NULL;
+
+  vtkMultiThreader *threader = vtkMultiThreader::New();
+  int numThreads = this->NumberOfThreads;
+  if (numThreads > numQueries)
+    {
+    numThreads = (numQueries > 0) ? static_cast<int>(numQueries) : 1;
+    }
+  threader->SetNumberOfThreads(numThreads);
+  threader->SetSingleMethod(vtkKdTree::ThreadedFindClosestNPoints, &query);
+  threader->SingleMethodExecute();
+  threader->Delete();
+}
+
+//----------------------------------------------------------------------------
+void vtkKdTree::FindPointsWithinRadius(double R, vtkPoints *queryPoints,
+                                       vtkIdTypeArray *result,
+                                       vtkIdTypeArray *offsets)
+{
+  if (!this->LocatorPoints)
+    {
+    vtkErrorMacro(<< "vtkKdTree::FindPointsWithinRadius - must build locator first");
+    return;
+    }
+  if (!queryPoints || !result || !offsets)
+    {
+    return;
+    }
+
+  vtkIdType numQueries = queryPoints->GetNumberOfPoints();
+
+  vtkKdTreeBatchQuery query;
+  query.Tree = this;
+  query.QueryPoints = queryPoints;
+  query.N = 0;
+  query.Radius = R;
+  query.Result = result;
+  query.Lists = new vtkIdList* [numQueries];
+
+  vtkMultiThreader *threader = vtkMultiThreader::New();
+  int numThreads = this->NumberOfThreads;
+  if (numThreads > numQueries)
+    {
+    numThreads = (numQueries > 0) ? static_cast<int>(numQueries) : 1;
+    }
+  threader->SetNumberOfThreads(numThreads);
+  threader->SetSingleMethod(vtkKdTree::ThreadedFindPointsWithinRadius, &query);
+  threader->SingleMethodExecute();
+  threader->Delete();
+
+  // Concatenate the per query lists in query order
+  offsets->Initialize();
+  offsets->SetNumberOfValues(numQueries + 1);
+  vtkIdType total = 0;
+  vtkIdType i;
+  for (i = 0; i < numQueries; i++)
+    {
+    offsets->SetValue(i, total);
+    total += query.Lists[i]->GetNumberOfIds();
+    }
+  offsets->SetValue(numQueries, total);
+
+  result->Initialize();
+  result->SetNumberOfValues(total);
+  vtkIdType *out = result->GetPointer(0);
+  for (i = 0; i < numQueries; i++)
+    {
+    vtkIdType numIds = query.Lists[i]->GetNumberOfIds();
+    memcpy(out, query.Lists[i]->GetPointer(0), numIds * sizeof(vtkIdType));
+    out += numIds;
+    query.Lists[i]->Delete();
+    }
+  delete [] query.Lists;
+}
                                    
 
 //----------------------------------------------------------------------------
@@ -4150,17 +4549,25 @@ int *vtkKdTree::AllGetRegionContainingCell()
     {
     int setCells = iset->GetNumberOfCells();
     
+    if (setCells == 0)
+      {
+      continue;
+      }
+
     float *centers = this->ComputeCellCenters(iset);
-    
-    float *pt = centers;
 
-    for (int cellId = 0; cellId < setCells; cellId++)
-      {
-      listPtr[cellId] =
-        this->GetRegionContainingPoint(pt[0], pt[1], pt[2]);
+    vtkKdTreeBuildState state;
+    state.Top = this->Top;
+    state.Centers = centers;
+    state.NumberOfCenters = setCells;
+    state.RegionIds = listPtr;
 
-      pt += 3;
-      }
+    vtkMultiThreader *threader = vtkMultiThreader::New();
+    threader->SetNumberOfThreads(
+      vtkKdTreeNumberOfThreads(this->NumberOfThreads, setCells));
+    threader->SetSingleMethod(vtkKdTree::ThreadedFindRegions, &state);
+    threader->SingleMethodExecute();
+    threader->Delete();
 
     listPtr += setCells;
 
@@ -4170,6 +4577,30 @@ int *vtkKdTree::AllGetRegionContainingCell()
   return this->CellRegionList;
 }
 
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkKdTree::ThreadedFindRegions(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkKdTreeBuildState *state =
+    static_cast<vtkKdTreeBuildState *>(info->UserData);
+
+  vtkIdType num = state->NumberOfCenters;
+  int begin = static_cast<int>(num * info->ThreadID / info->NumberOfThreads);
+  int end =
+    static_cast<int>(num * (info->ThreadID + 1) / info->NumberOfThreads);
+  float *pt = state->Centers + 3*begin;
+
+  for (int cellId = begin; cellId < end; cellId++)
+    {
+    state->RegionIds[cellId] =
+      vtkKdTree::findRegion(state->Top, pt[0], pt[1], pt[2]);
+    pt += 3;
+    }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
 //----------------------------------------------------------------------------
 int vtkKdTree::GetRegionContainingPoint(double x, double y, double z)
 {
@@ -4753,21 +5184,20 @@ void vtkKdTree::AddAllPointsInRegion(vtkKdNode* node, vtkIdTypeArray* ids)
 //----------------------------------------------------------------------------
 void vtkKdTree::AddAllPointsInRegion(vtkKdNode* node, vtkIdList* ids)
 {
-  if (node->GetLeft() == NULL)
+  // The points of the leaves below a node are stored contiguously,
+  // starting with the points of the left most leaf.
+  vtkKdNode *leaf = node;
+  while (leaf->GetLeft())
     {
-    int regionID = node->GetID();
-    int regionLoc = this->LocatorRegionLocation[regionID];
-    vtkIdType numPoints = this->RegionList[regionID]->GetNumberOfPoints();
-    for (vtkIdType i = 0; i < numPoints; i++)
-      {
-      vtkIdType ptId = static_cast<vtkIdType>(this->LocatorIds[regionLoc + i]);
-      ids->InsertNextId(ptId);
-      }
+    leaf = leaf->GetLeft();
     }
-  else
+  int regionLoc = this->LocatorRegionLocation[leaf->GetID()];
+  vtkIdType numPoints = node->GetNumberOfPoints();
+  vtkIdType start = ids->GetNumberOfIds();
+  vtkIdType *ptIds = ids->WritePointer(start, numPoints);
+  for (vtkIdType i = 0; i < numPoints; i++)
     {
-    this->AddAllPointsInRegion(node->GetLeft(), ids);
-    this->AddAllPointsInRegion(node->GetRight(), ids);
+    ptIds[i] = static_cast<vtkIdType>(this->LocatorIds[regionLoc + i]);
     }
 }
 
@@ -4780,6 +5210,9 @@ void vtkKdTree::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "MinCells: " << this->MinCells << endl;
   os << indent << "NumberOfRegionsOrLess: " << this->NumberOfRegionsOrLess << endl;
   os << indent << "NumberOfRegionsOrMore: " << this->NumberOfRegionsOrMore << endl;
+  os << indent << "ApproximationFactor: " << this->ApproximationFactor << endl;
+  os << indent << "MaximumNumberOfRegionVisits: " << this->MaximumNumberOfRegionVisits << endl;
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << endl;
 
   os << indent << "NumberOfRegions: " << this->NumberOfRegions << endl;
 
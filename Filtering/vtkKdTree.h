@@ -485,6 +485,52 @@ public:
   // indirectly called from a single thread first.
   void FindClosestNPoints(int N, const double x[3], vtkIdList *result);
 
+  // Description:
+  // Error bound for approximate searches with FindClosestNPoints and
+  // FindPointsWithinRadius.  With a value of eps, a region is only
+  // searched if it could contain a point closer than 1/(1+eps) times the
+  // current N-th closest distance, so the returned points are within
+  // (1+eps) of the true N-th closest distance.  FindPointsWithinRadius
+  // returns every point within R but may also return points up to
+  // (1+eps)R away.  The default of 0 gives exact results.
+  vtkSetClampMacro(ApproximationFactor, double, 0.0, VTK_DOUBLE_MAX);
+  vtkGetMacro(ApproximationFactor, double);
+
+  // Description:
+  // The maximum number of leaf regions FindClosestNPoints will examine,
+  // searched in order of increasing distance from the query position.
+  // Once the limit is reached the best points found so far are
+  // returned.  The default of 0 means no limit.
+  vtkSetClampMacro(MaximumNumberOfRegionVisits, int, 0, VTK_INT_MAX);
+  vtkGetMacro(MaximumNumberOfRegionVisits, int);
+
+  // Description:
+  // The number of threads used to build the tree (cell centers, median
+  // splits of independent subtrees and assignment of cells to regions)
+  // and by the batched query methods.  The tree built does not depend
+  // on it.  The default is
+  // vtkMultiThreader::GetGlobalDefaultNumberOfThreads().
+  vtkSetClampMacro(NumberOfThreads, int, 1, VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads, int);
+
+  // Description:
+  // Batched version of FindClosestNPoints.  Queries every point of
+  // queryPoints, splitting the work over NumberOfThreads threads.  The
+  // result has N components and one tuple per query point holding the
+  // closest point ids sorted from closest to farthest.  If fewer than N
+  // points exist the remaining components are set to -1.
+  void FindClosestNPoints(int N, vtkPoints *queryPoints,
+                          vtkIdTypeArray *result);
+
+  // Description:
+  // Batched version of FindPointsWithinRadius.  The ids found for query
+  // point i are stored in result, from index offsets[i] up to (but not
+  // including) offsets[i+1].  offsets has one more value than there are
+  // query points.  The work is split over NumberOfThreads threads.
+  void FindPointsWithinRadius(double R, vtkPoints *queryPoints,
+                              vtkIdTypeArray *result,
+                              vtkIdTypeArray *offsets);
+
   // Description:
   // Get a list of the original IDs of all points in a region.  You
   // must have called BuildLocatorFromPoints before calling this.
@@ -677,13 +723,18 @@ protected:
   static void ZeroNumberOfPoints(vtkKdNode *kd);
 
 //BTX
-  // Recursive helper for public FindPointsWithinRadius
-  void FindPointsWithinRadius(vtkKdNode* node, double R2, 
-                              const double x[3], vtkIdList* ids);  
+  // Helper for public FindPointsWithinRadius, traverses the subtree
+  // rooted at node iteratively.
+  void FindPointsWithinRadius(vtkKdNode* node, double R2,
+                              const double x[3], vtkIdList* ids);
 
-  // Recursive helper for public FindPointsWithinRadius
+  // Helper for public FindPointsWithinRadius
   void AddAllPointsInRegion(vtkKdNode* node, vtkIdList* ids);
 
+  // Thread entry points for the batched queries
+  static VTK_THREAD_RETURN_TYPE ThreadedFindClosestNPoints(void *arg);
+  static VTK_THREAD_RETURN_TYPE ThreadedFindPointsWithinRadius(void *arg);
+
   // Recursive helper for public FindPointsInArea
   void FindPointsInArea(vtkKdNode* node, double* area, vtkIdTypeArray* ids);
 
@@ -692,6 +743,19 @@ protected:
 
   int DivideRegion(vtkKdNode *kd, float *c1, int *ids, int nlevels);
 
+  // Divide kd once if DivideTest() allows it.  Returns 1 if child nodes
+  // were added.
+  int SplitRegion(vtkKdNode *kd, float *c1, int *ids, int level);
+
+  // Same as DivideRegion(kd, c1, ids, 0), the independent subtrees
+  // being divided in NumberOfThreads threads.
+  void DivideRegionInParallel(vtkKdNode *kd, float *c1, int *ids);
+
+  // Thread entry points for the tree build
+  static VTK_THREAD_RETURN_TYPE ThreadedComputeCellCenters(void *arg);
+  static VTK_THREAD_RETURN_TYPE ThreadedDivideRegions(void *arg);
+  static VTK_THREAD_RETURN_TYPE ThreadedFindRegions(void *arg);
+
   void DoMedianFind(vtkKdNode *kd, float *c1, int *ids, int d1, int d2, int d3);
 
   void SelfRegister(vtkKdNode *kd);
@@ -790,6 +854,10 @@ protected:
   int NumberOfRegionsOrLess;
   int NumberOfRegionsOrMore;
 
+  double ApproximationFactor;
+  int MaximumNumberOfRegionVisits;
+  int NumberOfThreads;
+
   int IncludeRegionBoundaryCells;
   double CellBoundsCache[6];       // to optimize IntersectsCell()
 
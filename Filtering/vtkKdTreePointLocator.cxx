@@ -14,7 +14,9 @@
 =========================================================================*/
 #include "vtkKdTreePointLocator.h"
 
+#include "vtkIdTypeArray.h"
 #include "vtkKdTree.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointSet.h"
 
@@ -23,6 +25,9 @@ vtkStandardNewMacro(vtkKdTreePointLocator);
 vtkKdTreePointLocator::vtkKdTreePointLocator()
 {
   this->KdTree = 0;
+  this->ApproximationFactor = 0.0;
+  this->MaximumNumberOfRegionVisits = 0;
+  this->NumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
 }
 
 vtkKdTreePointLocator::~vtkKdTreePointLocator()
@@ -52,6 +57,7 @@ void vtkKdTreePointLocator::FindClosestNPoints(int N, const double x[3],
                                                vtkIdList* result)
 {
   this->BuildLocator();
+  this->UpdateSearchParameters();
   this->KdTree->FindClosestNPoints(N, x, result);
 }
 
@@ -59,9 +65,52 @@ void vtkKdTreePointLocator::FindPointsWithinRadius(double R, const double x[3],
                                                    vtkIdList * result)
 {
   this->BuildLocator();
+  this->UpdateSearchParameters();
   this->KdTree->FindPointsWithinRadius(R, x, result);
 }
 
+void vtkKdTreePointLocator::FindClosestNPoints(int N, vtkPoints *queryPoints,
+                                               vtkIdTypeArray *result)
+{
+  this->BuildLocator();
+  this->UpdateSearchParameters();
+  this->KdTree->FindClosestNPoints(N, queryPoints, result);
+}
+
+void vtkKdTreePointLocator::FindPointsWithinRadius(double R,
+                                                   vtkPoints *queryPoints,
+                                                   vtkIdTypeArray *result,
+                                                   vtkIdTypeArray *offsets)
+{
+  this->BuildLocator();
+  this->UpdateSearchParameters();
+  this->KdTree->FindPointsWithinRadius(R, queryPoints, result, offsets);
+}
+
+void vtkKdTreePointLocator::UpdateSearchParameters()
+{
+  if(!this->KdTree)
+    {
+    return;
+    }
+  // Only touch the tree when something changed so that concurrent
+  // queries with unchanged settings do not write to it.
+  if(this->KdTree->GetApproximationFactor() != this->ApproximationFactor)
+    {
+    this->KdTree->SetApproximationFactor(this->ApproximationFactor);
+    }
+  if(this->KdTree->GetMaximumNumberOfRegionVisits() !=
+     this->MaximumNumberOfRegionVisits)
+    {
+    this->KdTree->SetMaximumNumberOfRegionVisits(
+      this->MaximumNumberOfRegionVisits);
+    }
+  if(this->KdTree->GetNumberOfThreads() != this->NumberOfThreads)
+    {
+    this->KdTree->SetNumberOfThreads(this->NumberOfThreads);
+    }
+}
+
 void vtkKdTreePointLocator::FreeSearchStructure()
 {
   if(this->KdTree)
@@ -99,5 +148,9 @@ void vtkKdTreePointLocator::PrintSelf(ostream& os, vtkIndent indent)
   this->Superclass::PrintSelf(os,indent);
 
   os << indent << "KdTree " << this->KdTree << "\n";
+  os << indent << "ApproximationFactor " << this->ApproximationFactor << "\n";
+  os << indent << "MaximumNumberOfRegionVisits "
+     << this->MaximumNumberOfRegionVisits << "\n";
+  os << indent << "NumberOfThreads " << this->NumberOfThreads << "\n";
 }
 
@@ -26,7 +26,9 @@
 #include "vtkAbstractPointLocator.h"
 
 class vtkIdList;
+class vtkIdTypeArray;
 class vtkKdTree;
+class vtkPoints;
 
 class VTK_FILTERING_EXPORT vtkKdTreePointLocator : public vtkAbstractPointLocator
 {
@@ -66,7 +68,36 @@ public:
   // indirectly called from a single thread first.
   virtual void FindPointsWithinRadius(double R, const double x[3],
                                       vtkIdList *result);
-  
+
+  // Description:
+  // Error bound for approximate FindClosestNPoints and
+  // FindPointsWithinRadius searches.  0 (the default) gives exact
+  // results.  See vtkKdTree::SetApproximationFactor().
+  vtkSetClampMacro(ApproximationFactor, double, 0.0, VTK_DOUBLE_MAX);
+  vtkGetMacro(ApproximationFactor, double);
+
+  // Description:
+  // Maximum number of k-d tree regions searched by FindClosestNPoints.
+  // 0 (the default) means no limit.  See
+  // vtkKdTree::SetMaximumNumberOfRegionVisits().
+  vtkSetClampMacro(MaximumNumberOfRegionVisits, int, 0, VTK_INT_MAX);
+  vtkGetMacro(MaximumNumberOfRegionVisits, int);
+
+  // Description:
+  // Number of threads used by the batched query methods.
+  vtkSetClampMacro(NumberOfThreads, int, 1, VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads, int);
+
+  // Description:
+  // Batched, multithreaded versions of FindClosestNPoints and
+  // FindPointsWithinRadius for all the points of queryPoints.  See
+  // vtkKdTree for the layout of the result arrays.
+  virtual void FindClosestNPoints(int N, vtkPoints *queryPoints,
+                                  vtkIdTypeArray *result);
+  virtual void FindPointsWithinRadius(double R, vtkPoints *queryPoints,
+                                      vtkIdTypeArray *result,
+                                      vtkIdTypeArray *offsets);
+
   // Description:
   // See vtkLocator interface documentation.
   // These methods are not thread safe.
@@ -78,7 +109,14 @@ protected:
   vtkKdTreePointLocator();
   virtual ~vtkKdTreePointLocator();
 
+  // Description:
+  // Pass the search settings on to the k-d tree.
+  void UpdateSearchParameters();
+
   vtkKdTree* KdTree;
+  double ApproximationFactor;
+  int MaximumNumberOfRegionVisits;
+  int NumberOfThreads;
 
 private:
   vtkKdTreePointLocator(const vtkKdTreePointLocator&);  // Not implemented.
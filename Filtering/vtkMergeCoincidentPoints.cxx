@@ -0,0 +1,454 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    vtkMergeCoincidentPoints.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "vtkMergeCoincidentPoints.h"
+
+#include "vtkIdTypeArray.h"
+#include "vtkMath.h"
+#include "vtkMultiThreader.h"
+#include "vtkObjectFactory.h"
+#include "vtkPoints.h"
+
+#include <vtkstd/algorithm>
+#include <vtkstd/vector>
+
+vtkStandardNewMacro(vtkMergeCoincidentPoints);
+
+// Shared state of the threaded passes
+struct vtkMergeCoincidentPointsThreadStruct
+{
+  vtkMergeCoincidentPoints *Self;
+  vtkPoints *Points;
+  vtkIdType *BinIds;
+  vtkIdType *BinOffsets;
+  vtkIdType *SortedIds;
+  vtkIdType *Representative;
+  vtkIdType NumberOfBins;
+  int Divisions[3];
+  double Bounds[6];
+  double H[3];
+};
+
+// Orders point ids by coordinates, then by id, so that coincident points
+// are adjacent and the lowest id of each group comes first.
+class vtkMergeCoincidentPointsCompare
+{
+public:
+  vtkMergeCoincidentPointsCompare(const double *coords) : Coords(coords) {};
+  bool operator()(vtkIdType a, vtkIdType b) const
+    {
+    // a and b index the local coordinate array, which follows id order
+    const double *pa = this->Coords + 3*a;
+    const double *pb = this->Coords + 3*b;
+    if (pa[0] != pb[0]) { return pa[0] < pb[0]; }
+    if (pa[1] != pb[1]) { return pa[1] < pb[1]; }
+    if (pa[2] != pb[2]) { return pa[2] < pb[2]; }
+    return a < b;
+    }
+private:
+  const double *Coords;
+};
+
+//----------------------------------------------------------------------------
+vtkMergeCoincidentPoints::vtkMergeCoincidentPoints()
+{
+  this->Tolerance = 0.0;
+  this->NumberOfPointsPerBin = 8;
+  this->NumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+  this->Divisions[0] = this->Divisions[1] = this->Divisions[2] = 1;
+  for (int i=0; i < 3; i++)
+    {
+    this->Bounds[2*i] = 0.0;
+    this->Bounds[2*i+1] = 1.0;
+    this->H[i] = 1.0;
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkMergeCoincidentPoints::ComputeDivisions(const double bounds[6],
+                                                vtkIdType numPts)
+{
+  int i;
+  double level, hmin;
+  int ndivs[3];
+
+  for (i=0; i < 3; i++)
+    {
+    this->Bounds[2*i] = bounds[2*i];
+    this->Bounds[2*i+1] = bounds[2*i+1];
+    if (this->Bounds[2*i+1] <= this->Bounds[2*i])
+      {
+      this->Bounds[2*i+1] = this->Bounds[2*i] + 1.0;
+      }
+    }
+
+  // Same heuristic as vtkPointLocator: bins roughly cubical, with
+  // NumberOfPointsPerBin points on average.
+  double numBins = static_cast<double>(numPts) / this->NumberOfPointsPerBin;
+  level = pow(numBins < 1.0 ? 1.0 : numBins, 1.0/3.0);
+  for (hmin=0.0, i=0; i < 3; i++)
+    {
+    double width = bounds[2*i+1] - bounds[2*i];
+    if (width > hmin)
+      {
+      hmin = width;
+      }
+    }
+  hmin = (hmin > 0.0) ? hmin / level : 1.0;
+
+  for (i=0; i < 3; i++)
+    {
+    double width = bounds[2*i+1] - bounds[2*i];
+    ndivs[i] = (width > 0.0) ? static_cast<int>(width / hmin) : 1;
+    // keep bins at least as wide as the tolerance so that only
+    // neighboring bins need to be searched
+    if (this->Tolerance > 0.0 && width > 0.0)
+      {
+      int maxDivs = static_cast<int>(width / this->Tolerance);
+      if (ndivs[i] > maxDivs)
+        {
+        ndivs[i] = maxDivs;
+        }
+      }
+    if (ndivs[i] < 1)
+      {
+      ndivs[i] = 1;
+      }
+    // avoid overflowing the bin index
+    if (ndivs[i] > 1024)
+      {
+      ndivs[i] = 1024;
+      }
+    this->Divisions[i] = ndivs[i];
+    this->H[i] = (this->Bounds[2*i+1] - this->Bounds[2*i]) / ndivs[i];
+    }
+}
+
+//----------------------------------------------------------------------------
+// Compute the bin of every point; each thread handles a contiguous range
+// of point ids.
+VTK_THREAD_RETURN_TYPE vtkMergeCoincidentPoints::ThreadedComputeBins(
+  void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkMergeCoincidentPointsThreadStruct *str =
+    static_cast<vtkMergeCoincidentPointsThreadStruct *>(info->UserData);
+
+  vtkIdType numPts = str->Points->GetNumberOfPoints();
+  vtkIdType begin = numPts * info->ThreadID / info->NumberOfThreads;
+  vtkIdType end = numPts * (info->ThreadID + 1) / info->NumberOfThreads;
+  const int *divs = str->Divisions;
+  double x[3];
+  int ijk[3];
+
+  for (vtkIdType ptId = begin; ptId < end; ptId++)
+    {
+    str->Points->GetPoint(ptId, x);
+    for (int i=0; i < 3; i++)
+      {
+      ijk[i] = static_cast<int>((x[i] - str->Bounds[2*i]) / str->H[i]);
+      if (ijk[i] < 0)
+        {
+        ijk[i] = 0;
+        }
+      else if (ijk[i] >= divs[i])
+        {
+        ijk[i] = divs[i] - 1;
+        }
+      }
+    str->BinIds[ptId] = ijk[0] +
+      static_cast<vtkIdType>(divs[0]) * (ijk[1] +
+        static_cast<vtkIdType>(divs[1]) * ijk[2]);
+    }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+// Find exactly coincident points within each bin.  Bins are independent,
+// so each thread handles a contiguous range of bins.
+VTK_THREAD_RETURN_TYPE vtkMergeCoincidentPoints::ThreadedMergeBins(
+  void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkMergeCoincidentPointsThreadStruct *str =
+    static_cast<vtkMergeCoincidentPointsThreadStruct *>(info->UserData);
+
+  vtkIdType begin = str->NumberOfBins * info->ThreadID / info->NumberOfThreads;
+  vtkIdType end =
+    str->NumberOfBins * (info->ThreadID + 1) / info->NumberOfThreads;
+
+  vtkstd::vector<double> coords;
+  vtkstd::vector<vtkIdType> order;
+
+  for (vtkIdType bin = begin; bin < end; bin++)
+    {
+    vtkIdType *ids = str->SortedIds + str->BinOffsets[bin];
+    vtkIdType numIds = str->BinOffsets[bin+1] - str->BinOffsets[bin];
+    if (numIds == 0)
+      {
+      continue;
+      }
+    if (numIds == 1)
+      {
+      str->Representative[ids[0]] = ids[0];
+      continue;
+      }
+
+    // ids are in increasing order within a bin (stable counting sort),
+    // so sorting the local indices also orders coincident points by id
+    coords.resize(3*numIds);
+    order.resize(numIds);
+    vtkIdType i;
+    for (i=0; i < numIds; i++)
+      {
+      str->Points->GetPoint(ids[i], &coords[3*i]);
+      order[i] = i;
+      }
+    vtkstd::sort(order.begin(), order.end(),
+                 vtkMergeCoincidentPointsCompare(&coords[0]));
+
+    vtkIdType first = order[0];
+    str->Representative[ids[first]] = ids[first];
+    for (i=1; i < numIds; i++)
+      {
+      const double *p = &coords[3*order[i]];
+      const double *q = &coords[3*first];
+      if (p[0] != q[0] || p[1] != q[1] || p[2] != q[2])
+        {
+        first = order[i];
+        }
+      str->Representative[ids[order[i]]] = ids[first];
+      }
+    }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+void vtkMergeCoincidentPoints::MergeWithinTolerance(vtkPoints *points,
+                                                    vtkIdType *binOffsets,
+                                                    vtkIdType *sortedIds,
+                                                    vtkIdType *binIds,
+                                                    vtkIdType *representative)
+{
+  vtkIdType numPts = points->GetNumberOfPoints();
+  double tol2 = this->Tolerance * this->Tolerance;
+  vtkIdType sliceSize =
+    static_cast<vtkIdType>(this->Divisions[0]) * this->Divisions[1];
+  double x[3], y[3];
+
+  for (vtkIdType ptId=0; ptId < numPts; ptId++)
+    {
+    points->GetPoint(ptId, x);
+    vtkIdType bin = binIds[ptId];
+    int ijk[3];
+    ijk[2] = static_cast<int>(bin / sliceSize);
+    ijk[1] = static_cast<int>((bin % sliceSize) / this->Divisions[0]);
+    ijk[0] = static_cast<int>(bin % this->Divisions[0]);
+
+    vtkIdType closest = ptId;
+    double closestDist2 = VTK_DOUBLE_MAX;
+    for (int k = ijk[2]-1; k <= ijk[2]+1; k++)
+      {
+      if (k < 0 || k >= this->Divisions[2])
+        {
+        continue;
+        }
+      for (int j = ijk[1]-1; j <= ijk[1]+1; j++)
+        {
+        if (j < 0 || j >= this->Divisions[1])
+          {
+          continue;
+          }
+        for (int i = ijk[0]-1; i <= ijk[0]+1; i++)
+          {
+          if (i < 0 || i >= this->Divisions[0])
+            {
+            continue;
+            }
+          vtkIdType nei = i + this->Divisions[0]*j + sliceSize*k;
+          // only earlier points can be merged onto; ids within a bin
+          // are increasing
+          for (vtkIdType n = binOffsets[nei];
+               n < binOffsets[nei+1] && sortedIds[n] < ptId; n++)
+            {
+            vtkIdType candidate = sortedIds[n];
+            if (representative[candidate] != candidate)
+              {
+              continue;
+              }
+            points->GetPoint(candidate, y);
+            double dist2 = vtkMath::Distance2BetweenPoints(x, y);
+            if (dist2 <= tol2 && (dist2 < closestDist2 ||
+                (dist2 == closestDist2 && candidate < closest)))
+              {
+              closest = candidate;
+              closestDist2 = dist2;
+              }
+            }
+          }
+        }
+      }
+    representative[ptId] = closest;
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkMergeCoincidentPoints::BuildMergeMap(vtkPoints *points,
+                                                  vtkIdTypeArray *mergeMap)
+{
+  if (!points || !mergeMap)
+    {
+    vtkErrorMacro(<<"Points and merge map must be provided");
+    return 0;
+    }
+
+  vtkIdType numPts = points->GetNumberOfPoints();
+  mergeMap->Initialize();
+  mergeMap->SetNumberOfValues(numPts);
+  if (numPts < 1)
+    {
+    return 0;
+    }
+
+  double bounds[6];
+  points->GetBounds(bounds);
+  this->ComputeDivisions(bounds, numPts);
+
+  vtkMergeCoincidentPointsThreadStruct str;
+  str.Self = this;
+  str.Points = points;
+  str.NumberOfBins = static_cast<vtkIdType>(this->Divisions[0]) *
+    this->Divisions[1] * this->Divisions[2];
+  for (int i=0; i < 3; i++)
+    {
+    str.Divisions[i] = this->Divisions[i];
+    str.Bounds[2*i] = this->Bounds[2*i];
+    str.Bounds[2*i+1] = this->Bounds[2*i+1];
+    str.H[i] = this->H[i];
+    }
+  str.BinIds = new vtkIdType [numPts];
+  str.BinOffsets = new vtkIdType [str.NumberOfBins + 1];
+  str.SortedIds = new vtkIdType [numPts];
+  str.Representative = new vtkIdType [numPts];
+
+  int numThreads = this->NumberOfThreads;
+  if (numThreads > numPts)
+    {
+    numThreads = static_cast<int>(numPts);
+    }
+  vtkMultiThreader *threader = vtkMultiThreader::New();
+  threader->SetNumberOfThreads(numThreads);
+
+  // Bin the points
+  threader->SetSingleMethod(vtkMergeCoincidentPoints::ThreadedComputeBins,
+                            &str);
+  threader->SingleMethodExecute();
+
+  // Stable counting sort of the point ids by bin
+  vtkIdType bin, ptId;
+  for (bin=0; bin <= str.NumberOfBins; bin++)
+    {
+    str.BinOffsets[bin] = 0;
+    }
+  for (ptId=0; ptId < numPts; ptId++)
+    {
+    str.BinOffsets[str.BinIds[ptId]+1]++;
+    }
+  for (bin=0; bin < str.NumberOfBins; bin++)
+    {
+    str.BinOffsets[bin+1] += str.BinOffsets[bin];
+    }
+  vtkIdType *fill = new vtkIdType [str.NumberOfBins];
+  memcpy(fill, str.BinOffsets, str.NumberOfBins * sizeof(vtkIdType));
+  for (ptId=0; ptId < numPts; ptId++)
+    {
+    str.SortedIds[fill[str.BinIds[ptId]]++] = ptId;
+    }
+  delete [] fill;
+
+  // Find the representative (lowest id) of each group of merged points
+  if (this->Tolerance > 0.0)
+    {
+    this->MergeWithinTolerance(points, str.BinOffsets, str.SortedIds,
+                               str.BinIds, str.Representative);
+    }
+  else
+    {
+    if (numThreads > str.NumberOfBins)
+      {
+      threader->SetNumberOfThreads(static_cast<int>(str.NumberOfBins));
+      }
+    threader->SetSingleMethod(vtkMergeCoincidentPoints::ThreadedMergeBins,
+                              &str);
+    threader->SingleMethodExecute();
+    }
+  threader->Delete();
+
+  // Number the unique points in order of first occurrence.  The
+  // representative of a point never has a larger id than the point.
+  vtkIdType *map = mergeMap->GetPointer(0);
+  vtkIdType numUnique = 0;
+  for (ptId=0; ptId < numPts; ptId++)
+    {
+    vtkIdType rep = str.Representative[ptId];
+    map[ptId] = (rep == ptId) ? numUnique++ : map[rep];
+    }
+
+  delete [] str.BinIds;
+  delete [] str.BinOffsets;
+  delete [] str.SortedIds;
+  delete [] str.Representative;
+
+  return numUnique;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkMergeCoincidentPoints::MergePoints(vtkPoints *points,
+                                                vtkIdTypeArray *mergeMap,
+                                                vtkPoints *mergedPoints)
+{
+  vtkIdType numUnique = this->BuildMergeMap(points, mergeMap);
+  if (!mergedPoints)
+    {
+    return numUnique;
+    }
+
+  mergedPoints->SetNumberOfPoints(numUnique);
+  vtkIdType numPts = points->GetNumberOfPoints();
+  vtkIdType next = 0;
+  for (vtkIdType ptId=0; ptId < numPts && next < numUnique; ptId++)
+    {
+    if (mergeMap->GetValue(ptId) == next)
+      {
+      mergedPoints->SetPoint(next++, points->GetPoint(ptId));
+      }
+    }
+
+  return numUnique;
+}
+
+//----------------------------------------------------------------------------
+void vtkMergeCoincidentPoints::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "Tolerance: " << this->Tolerance << "\n";
+  os << indent << "Number of Points per Bin: "
+     << this->NumberOfPointsPerBin << "\n";
+  os << indent << "Number of Threads: " << this->NumberOfThreads << "\n";
+}
@@ -0,0 +1,111 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    vtkMergeCoincidentPoints.h
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// .NAME vtkMergeCoincidentPoints - merge coincident points in one pass
+// .SECTION Description
+// vtkMergeCoincidentPoints computes, for a whole vtkPoints at once, a map
+// from the original point ids to the ids of the unique points.  It is a
+// bulk alternative to inserting the points one at a time into a
+// vtkMergePoints locator.
+//
+// The points are sorted into a regular grid of spatial bins.  The bin of
+// each point is computed in parallel, the points are counting-sorted by
+// bin and, for exact merging (Tolerance of 0), the coincident points of
+// each bin are found in parallel.  When a Tolerance is set, a point is
+// merged onto the closest earlier unique point within the tolerance;
+// this assignment depends on the point order and is done serially.
+//
+// Unique points are numbered in order of their first occurrence, so the
+// map is identical to the ids vtkMergePoints::InsertUniquePoint returns
+// when the points are inserted in increasing id order.
+
+// .SECTION See Also
+// vtkMergePoints vtkCleanPolyData
+
+#ifndef __vtkMergeCoincidentPoints_h
+#define __vtkMergeCoincidentPoints_h
+
+#include "vtkObject.h"
+
+class vtkIdTypeArray;
+class vtkPoints;
+
+class VTK_FILTERING_EXPORT vtkMergeCoincidentPoints : public vtkObject
+{
+public:
+  vtkTypeMacro(vtkMergeCoincidentPoints,vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+  static vtkMergeCoincidentPoints *New();
+
+  // Description:
+  // Absolute distance below which two points are merged.  The default
+  // of 0 merges only points with exactly equal coordinates.
+  vtkSetClampMacro(Tolerance,double,0.0,VTK_DOUBLE_MAX);
+  vtkGetMacro(Tolerance,double);
+
+  // Description:
+  // Average number of points per spatial bin.  Default is 8.
+  vtkSetClampMacro(NumberOfPointsPerBin,int,1,VTK_INT_MAX);
+  vtkGetMacro(NumberOfPointsPerBin,int);
+
+  // Description:
+  // Number of threads used to bin and merge the points.  The default is
+  // vtkMultiThreader::GetGlobalDefaultNumberOfThreads().
+  vtkSetClampMacro(NumberOfThreads,int,1,VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads,int);
+
+  // Description:
+  // Compute the map from the ids of points to the ids of the unique
+  // points.  mergeMap gets one value per input point.  Returns the
+  // number of unique points.
+  vtkIdType BuildMergeMap(vtkPoints *points, vtkIdTypeArray *mergeMap);
+
+  // Description:
+  // Same as BuildMergeMap(), also filling mergedPoints with the
+  // coordinates of the first occurrence of each unique point.
+  vtkIdType MergePoints(vtkPoints *points, vtkIdTypeArray *mergeMap,
+                        vtkPoints *mergedPoints);
+
+protected:
+  vtkMergeCoincidentPoints();
+  ~vtkMergeCoincidentPoints() {};
+
+  // Description:
+  // Choose the bin grid for the given bounds and number of points.
+  void ComputeDivisions(const double bounds[6], vtkIdType numPts);
+
+  // Description:
+  // Merge each point onto the closest earlier unique point within the
+  // tolerance.  Serial, since the result depends on the point order.
+  void MergeWithinTolerance(vtkPoints *points, vtkIdType *binOffsets,
+                            vtkIdType *sortedIds, vtkIdType *binIds,
+                            vtkIdType *representative);
+
+  static VTK_THREAD_RETURN_TYPE ThreadedComputeBins(void *arg);
+  static VTK_THREAD_RETURN_TYPE ThreadedMergeBins(void *arg);
+
+  double Tolerance;
+  int NumberOfPointsPerBin;
+  int NumberOfThreads;
+
+  int Divisions[3];
+  double Bounds[6];
+  double H[3];
+
+private:
+  vtkMergeCoincidentPoints(const vtkMergeCoincidentPoints&);  // Not implemented.
+  void operator=(const vtkMergeCoincidentPoints&);  // Not implemented.
+};
+
+#endif
@@ -16,6 +16,7 @@
 
 #include "vtkCellData.h"
 #include "vtkCommand.h"
+#include "vtkCriticalSection.h"
 #include "vtkDataArray.h"
 #include "vtkImageData.h"
 #include "vtkInformation.h"
@@ -32,6 +33,11 @@ vtkThreadedImageAlgorithm::vtkThreadedImageAlgorithm()
 {
   this->Threader = vtkMultiThreader::New();
   this->NumberOfThreads = this->Threader->GetNumberOfThreads();
+  this->SplitMode = VTK_IMAGE_SPLIT_SLAB;
+  this->DesiredBytesPerPiece = 65536;
+  this->MinimumPieceSize[0] = 16;
+  this->MinimumPieceSize[1] = 1;
+  this->MinimumPieceSize[2] = 1;
 }
 
 //----------------------------------------------------------------------------
@@ -46,6 +52,25 @@ void vtkThreadedImageAlgorithm::PrintSelf(ostream& os, vtkIndent indent)
   this->Superclass::PrintSelf(os,indent);
   
   os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
+  os << indent << "SplitMode: " << this->GetSplitModeAsString() << "\n";
+  os << indent << "DesiredBytesPerPiece: " << this->DesiredBytesPerPiece
+     << "\n";
+  os << indent << "MinimumPieceSize: (" << this->MinimumPieceSize[0] << ", "
+     << this->MinimumPieceSize[1] << ", " << this->MinimumPieceSize[2]
+     << ")\n";
+}
+
+//----------------------------------------------------------------------------
+const char *vtkThreadedImageAlgorithm::GetSplitModeAsString()
+{
+  switch (this->SplitMode)
+    {
+    case VTK_IMAGE_SPLIT_BEAM:
+      return "Beam";
+    case VTK_IMAGE_SPLIT_BLOCK:
+      return "Block";
+    }
+  return "Slab";
 }
 
 struct vtkImageThreadStruct
@@ -56,6 +81,12 @@ struct vtkImageThreadStruct
   vtkInformationVector *OutputsInfo;
   vtkImageData   ***Inputs;
   vtkImageData   **Outputs;
+  // the extent to split, and in beam and block modes the number of pieces
+  // and the next piece to process
+  int Extent[6];
+  int NumberOfPieces;
+  int NextPiece;
+  vtkSimpleCriticalSection PieceLock;
 };
 
 //----------------------------------------------------------------------------
@@ -80,6 +111,11 @@ int vtkThreadedImageAlgorithm::SplitExtent(int splitExt[6],
   // start with same extent
   memcpy(splitExt, startExt, 6 * sizeof(int));
 
+  if (this->SplitMode != VTK_IMAGE_SPLIT_SLAB)
+    {
+    return this->SplitExtentIntoBlocks(splitExt, startExt, num, total);
+    }
+
   splitAxis = 2;
   min = startExt[4];
   max = startExt[5];
@@ -121,23 +157,86 @@ int vtkThreadedImageAlgorithm::SplitExtent(int splitExt[6],
   return maxThreadIdUsed + 1;
 }
 
-
-// this mess is really a simple function. All it does is call
-// the ThreadedExecute method after setting the correct
-// extent for this thread. Its just a pain to calculate
-// the correct extent.
-VTK_THREAD_RETURN_TYPE vtkThreadedImageAlgorithmThreadedExecute( void *arg )
+//----------------------------------------------------------------------------
+// Split the extent into beams or blocks. The axis along which the pieces
+// are the longest is split once more as long as there are less than total
+// pieces, and the pieces are numbered with x varying fastest.
+int vtkThreadedImageAlgorithm::SplitExtentIntoBlocks(int splitExt[6],
+                                                     int startExt[6],
+                                                     int num, int total)
 {
-  vtkImageThreadStruct *str;
-  int ext[6], splitExt[6], total;
-  int threadId, threadCount;
-  
-  threadId = static_cast<vtkMultiThreader::ThreadInfo *>(arg)->ThreadID;
-  threadCount = static_cast<vtkMultiThreader::ThreadInfo *>(arg)->NumberOfThreads;
-  
-  str = static_cast<vtkImageThreadStruct *>
-    (static_cast<vtkMultiThreader::ThreadInfo *>(arg)->UserData);
+  int size[3], divisions[3], minSize[3], axis;
+  int firstAxis = (this->SplitMode == VTK_IMAGE_SPLIT_BEAM ? 1 : 0);
+  for (axis = 0; axis < 3; axis++)
+    {
+    size[axis] = startExt[2*axis+1] - startExt[2*axis] + 1;
+    if (size[axis] < 1)
+      {
+      // empty extent so cannot split
+      return 1;
+      }
+    divisions[axis] = 1;
+    minSize[axis] = (this->MinimumPieceSize[axis] > 1 ?
+                     this->MinimumPieceSize[axis] : 1);
+    }
+
+  int pieces = 1;
+  for (;;)
+    {
+    int splitAxis = -1;
+    double longest = 0.0;
+    for (axis = 2; axis >= firstAxis; axis--)
+      {
+      double length = size[axis]/static_cast<double>(divisions[axis]);
+      if (length > longest &&
+          (divisions[axis] + 1)*minSize[axis] <= size[axis] &&
+          pieces/divisions[axis]*(divisions[axis] + 1) <= total)
+        {
+        splitAxis = axis;
+        longest = length;
+        }
+      }
+    if (splitAxis < 0)
+      {
+      break;
+      }
+    pieces = pieces/divisions[splitAxis]*(divisions[splitAxis] + 1);
+    divisions[splitAxis]++;
+    }
+
+  if (num >= pieces)
+    {
+    vtkDebugMacro("  SplitRequest (" << num
+                  << ") larger than total: " << pieces);
+    return pieces;
+    }
 
+  int index[3];
+  index[0] = num % divisions[0];
+  index[1] = (num / divisions[0]) % divisions[1];
+  index[2] = num / (divisions[0]*divisions[1]);
+  for (axis = 0; axis < 3; axis++)
+    {
+    vtkIdType n = size[axis];
+    splitExt[2*axis] = startExt[2*axis] +
+      static_cast<int>(n*index[axis]/divisions[axis]);
+    splitExt[2*axis+1] = startExt[2*axis] +
+      static_cast<int>(n*(index[axis] + 1)/divisions[axis]) - 1;
+    }
+
+  vtkDebugMacro("  Split Piece: ( " <<splitExt[0]<< ", " <<splitExt[1]<< ", "
+                << splitExt[2] << ", " << splitExt[3] << ", "
+                << splitExt[4] << ", " << splitExt[5] << ")");
+
+  return pieces;
+}
+
+//----------------------------------------------------------------------------
+// Find the extent to split: the update extent of the output the request
+// comes from, or the one of the first input when there is no output.
+static int vtkThreadedImageAlgorithmGetExtent(vtkImageThreadStruct *str,
+                                              int ext[6])
+{
   // if we have an output
   if (str->Filter->GetNumberOfOutputPorts())
     {
@@ -149,43 +248,94 @@ VTK_THREAD_RETURN_TYPE vtkThreadedImageAlgorithmThreadedExecute( void *arg )
     // update directly, for now an error
     if (outputPort == -1)
       {
-      return VTK_THREAD_RETURN_VALUE;
+      return 0;
       }
   
     // get the update extent from the output port
     vtkInformation *outInfo = 
       str->OutputsInfo->GetInformationObject(outputPort);
-    int updateExtent[6];
-    outInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), 
-                 updateExtent);
-    memcpy(ext,updateExtent, sizeof(int)*6);
+    outInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), ext);
+    return 1;
     }
-  else
+
+  // if there is no output, then use UE from input, use the first input
+  for (int inPort = 0; inPort < str->Filter->GetNumberOfInputPorts();
+       ++inPort)
     {
-    // if there is no output, then use UE from input, use the first input
-    int inPort;
-    for (inPort = 0; inPort < str->Filter->GetNumberOfInputPorts(); ++inPort)
+    if (str->Filter->GetNumberOfInputConnections(inPort))
       {
-      if (str->Filter->GetNumberOfInputConnections(inPort))
+      str->InputsInfo[inPort]
+        ->GetInformationObject(0)
+        ->Get(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), ext);
+      return 1;
+      }
+    }
+  return 0;
+}
+
+
+// this mess is really a simple function. All it does is call
+// the ThreadedExecute method after setting the correct
+// extent for this thread. Its just a pain to calculate
+// the correct extent.
+VTK_THREAD_RETURN_TYPE vtkThreadedImageAlgorithmThreadedExecute( void *arg )
+{
+  vtkImageThreadStruct *str;
+  int splitExt[6], total;
+  int threadId, threadCount;
+  
+  threadId = static_cast<vtkMultiThreader::ThreadInfo *>(arg)->ThreadID;
+  threadCount = static_cast<vtkMultiThreader::ThreadInfo *>(arg)->NumberOfThreads;
+  
+  str = static_cast<vtkImageThreadStruct *>
+    (static_cast<vtkMultiThreader::ThreadInfo *>(arg)->UserData);
+
+  // in beam and block modes, process the pieces left until there is none.
+  // The progress is the fraction of the pieces taken, reported by the
+  // first thread about 50 times since a thread may process many pieces.
+  if (str->Filter->GetSplitMode() != VTK_IMAGE_SPLIT_SLAB)
+    {
+    int reportedStep = -1;
+    for (;;)
+      {
+      str->PieceLock.Lock();
+      int piece = str->NextPiece++;
+      str->PieceLock.Unlock();
+      if (piece >= str->NumberOfPieces || str->Filter->GetAbortExecute())
         {
-        int updateExtent[6];
-        str->InputsInfo[inPort]
-          ->GetInformationObject(0)
-          ->Get(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), 
-                updateExtent);
-        memcpy(ext,updateExtent, sizeof(int)*6);
         break;
         }
+      if (threadId == 0)
+        {
+        int step = static_cast<int>(
+          50.0*piece/static_cast<double>(str->NumberOfPieces));
+        if (step > reportedStep)
+          {
+          reportedStep = step;
+          str->Filter->UpdateProgress(
+            piece/static_cast<double>(str->NumberOfPieces));
+          }
+        }
+      str->Filter->SplitExtent(splitExt, str->Extent, piece,
+                               str->NumberOfPieces);
+      if (splitExt[1] < splitExt[0] ||
+          splitExt[3] < splitExt[2] ||
+          splitExt[5] < splitExt[4])
+        {
+        continue;
+        }
+      str->Filter->ThreadedRequestData(str->Request,
+                                       str->InputsInfo, str->OutputsInfo,
+                                       str->Inputs, str->Outputs, 
+                                       splitExt, threadId);
       }
-    if (inPort >= str->Filter->GetNumberOfInputPorts())
-      {
-      return VTK_THREAD_RETURN_VALUE;
-      }
+    return VTK_THREAD_RETURN_VALUE;
     }
-  
+
   // execute the actual method with appropriate extent
   // first find out how many pieces extent can be split into.
-  total = str->Filter->SplitExtent(splitExt, ext, threadId, threadCount);
+  total = str->Filter->SplitExtent(splitExt, str->Extent, threadId,
+                                   threadCount);
     
   if (threadId < total)
     {
@@ -281,15 +431,51 @@ int vtkThreadedImageAlgorithm::RequestData(
     {
     this->CopyAttributeData(str.Inputs[0][0],str.Outputs[0],inputVector);
     }
-    
-  this->Threader->SetNumberOfThreads(this->NumberOfThreads);
-  this->Threader->SetSingleMethod(vtkThreadedImageAlgorithmThreadedExecute, &str);  
-
-  // always shut off debugging to avoid threading problems with GetMacros
-  int debug = this->Debug;
-  this->Debug = 0;
-  this->Threader->SingleMethodExecute();
-  this->Debug = debug;
+
+  // In beam and block modes, split the extent into pieces of about
+  // DesiredBytesPerPiece bytes, and at least one piece per thread.
+  int execute = vtkThreadedImageAlgorithmGetExtent(&str, str.Extent);
+  str.NumberOfPieces = 0;
+  str.NextPiece = 0;
+  if (execute && this->SplitMode != VTK_IMAGE_SPLIT_SLAB)
+    {
+    vtkImageData *data = (str.Outputs ? str.Outputs[0] :
+                          (str.Inputs && str.Inputs[0] ? str.Inputs[0][0] :
+                           0));
+    double bytes = 1.0;
+    if (data)
+      {
+      bytes = data->GetScalarSize()*data->GetNumberOfScalarComponents();
+      }
+    for (i = 0; i < 3; i++)
+      {
+      bytes *= (str.Extent[2*i+1] - str.Extent[2*i] + 1);
+      }
+    double pieces = ceil(bytes/this->DesiredBytesPerPiece);
+    if (pieces > VTK_INT_MAX)
+      {
+      pieces = VTK_INT_MAX;
+      }
+    int total = static_cast<int>(pieces);
+    if (total < this->NumberOfThreads)
+      {
+      total = this->NumberOfThreads;
+      }
+    int splitExt[6];
+    str.NumberOfPieces = this->SplitExtent(splitExt, str.Extent, 0, total);
+    }
+
+  if (execute)
+    {
+    this->Threader->SetNumberOfThreads(this->NumberOfThreads);
+    this->Threader->SetSingleMethod(vtkThreadedImageAlgorithmThreadedExecute, &str);  
+
+    // always shut off debugging to avoid threading problems with GetMacros
+    int debug = this->Debug;
+    this->Debug = 0;
+    this->Threader->SingleMethodExecute();
+    this->Debug = debug;
+    }
 
   // free up the arrays
   for (i = 0; i < this->GetNumberOfInputPorts(); ++i)
@@ -19,6 +19,17 @@
 // into smaller extents so that the vtkImageData limits are observed. It 
 // also provides support for multithreading. If you don't need any of this
 // functionality, consider using vtkSimpleImageToImageAlgorithm instead.
+//
+// The update extent is split into pieces by SplitExtent() according to
+// SplitMode. In slab mode each thread processes one piece. In beam and
+// block modes the extent is split into pieces of about DesiredBytesPerPiece
+// bytes of output, usually many more than threads, and each thread takes
+// the next piece left as soon as it is done with the previous one. The
+// same thread may then call ThreadedRequestData() several times, so
+// subclasses that accumulate results per thread id must not reset them
+// there to support these modes. For the same reason, progress in these
+// modes is reported here from the number of pieces taken, and subclasses
+// should only report the progress of their extent in slab mode.
 // .SECTION See also
 // vtkSimpleImageToImageAlgorithm
 
@@ -30,6 +41,10 @@
 class vtkImageData;
 class vtkMultiThreader;
 
+#define VTK_IMAGE_SPLIT_SLAB 0
+#define VTK_IMAGE_SPLIT_BEAM 1
+#define VTK_IMAGE_SPLIT_BLOCK 2
+
 class VTK_FILTERING_EXPORT vtkThreadedImageAlgorithm : public vtkImageAlgorithm
 {
 public:
@@ -58,8 +73,40 @@ public:
   vtkSetClampMacro( NumberOfThreads, int, 1, VTK_MAX_THREADS );
   vtkGetMacro( NumberOfThreads, int );
 
+  // Description:
+  // Set/Get how the update extent is split into pieces. Slab (the default)
+  // splits the slowest varying axis of more than one point into
+  // NumberOfThreads pieces. Beam splits the y and z axes, and block all
+  // three axes, into pieces about DesiredBytesPerPiece bytes large, which
+  // are processed by the threads as they become idle. Beams keep whole
+  // rows, blocks keep the neighborhoods of large kernels in cache.
+  vtkSetClampMacro(SplitMode,int,VTK_IMAGE_SPLIT_SLAB,VTK_IMAGE_SPLIT_BLOCK);
+  vtkGetMacro(SplitMode,int);
+  void SetSplitModeToSlab()
+    {this->SetSplitMode(VTK_IMAGE_SPLIT_SLAB);}
+  void SetSplitModeToBeam()
+    {this->SetSplitMode(VTK_IMAGE_SPLIT_BEAM);}
+  void SetSplitModeToBlock()
+    {this->SetSplitMode(VTK_IMAGE_SPLIT_BLOCK);}
+  const char *GetSplitModeAsString();
+
+  // Description:
+  // Set/Get the number of output bytes of each piece in beam and block
+  // modes. There are at least NumberOfThreads pieces. Default is 65536.
+  vtkSetClampMacro(DesiredBytesPerPiece,vtkIdType,1,VTK_LARGE_ID);
+  vtkGetMacro(DesiredBytesPerPiece,vtkIdType);
+
+  // Description:
+  // Set/Get the minimum number of points of the pieces along each axis in
+  // beam and block modes. Default is (16,1,1), so that the rows split in
+  // block mode are long enough to be read efficiently.
+  vtkSetVector3Macro(MinimumPieceSize,int);
+  vtkGetVector3Macro(MinimumPieceSize,int);
+
   // Description:
   // Putting this here until I merge graphics and imaging streaming.
+  // Splits startExt into at most total pieces according to SplitMode, puts
+  // piece num in splitExt and returns the number of pieces.
   virtual int SplitExtent(int splitExt[6], int startExt[6], 
                           int num, int total); 
 
@@ -69,6 +116,14 @@ protected:
 
   vtkMultiThreader *Threader;
   int NumberOfThreads;
+  int SplitMode;
+  vtkIdType DesiredBytesPerPiece;
+  int MinimumPieceSize[3];
+
+  // Description:
+  // Split an extent into beams or blocks for SplitExtent().
+  int SplitExtentIntoBlocks(int splitExt[6], int startExt[6],
+                            int num, int total);
   
   // Description:
   // This is called by the superclass.
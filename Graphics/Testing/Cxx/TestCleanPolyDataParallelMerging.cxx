@@ -0,0 +1,187 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestCleanPolyDataParallelMerging.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Checks that vtkCleanPolyData gives the same output whether points are
+// merged through the locator or in bulk by vtkMergeCoincidentPoints.
+
+#include "vtkCellArray.h"
+#include "vtkCleanPolyData.h"
+#include "vtkFloatArray.h"
+#include "vtkIdTypeArray.h"
+#include "vtkMergeCoincidentPoints.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+
+// Build a grid of quads where every quad has its own four points, so
+// that each interior grid point is duplicated up to four times.
+static vtkPolyData *MakeSplitQuads(int res)
+{
+  vtkPolyData *pd = vtkPolyData::New();
+  vtkPoints *pts = vtkPoints::New();
+  vtkCellArray *polys = vtkCellArray::New();
+  vtkFloatArray *scalars = vtkFloatArray::New();
+  scalars->SetName("Scalars");
+
+  for (int j=0; j < res; j++)
+    {
+    for (int i=0; i < res; i++)
+      {
+      vtkIdType ids[4];
+      double corners[4][2] = {{0,0},{1,0},{1,1},{0,1}};
+      for (int c=0; c < 4; c++)
+        {
+        double x = (i + corners[c][0]) * 0.1;
+        double y = (j + corners[c][1]) * 0.1;
+        ids[c] = pts->InsertNextPoint(x, y, 0.01 * x * y);
+        scalars->InsertNextValue(static_cast<float>(ids[c]));
+        }
+      polys->InsertNextCell(4, ids);
+      }
+    }
+  // a degenerate quad collapsing to a line once merged
+  vtkIdType ids[4];
+  ids[0] = pts->InsertNextPoint(0.0, 0.0, 0.0);
+  ids[1] = pts->InsertNextPoint(0.1, 0.0, 0.0);
+  ids[2] = pts->InsertNextPoint(0.1, 0.0, 0.0);
+  ids[3] = pts->InsertNextPoint(0.0, 0.0, 0.0);
+  for (int c=0; c < 4; c++)
+    {
+    scalars->InsertNextValue(static_cast<float>(ids[c]));
+    }
+  polys->InsertNextCell(4, ids);
+  // an unused point
+  pts->InsertNextPoint(5.0, 5.0, 5.0);
+  scalars->InsertNextValue(-1.0f);
+
+  pd->SetPoints(pts);
+  pd->SetPolys(polys);
+  pd->GetPointData()->SetScalars(scalars);
+  pts->Delete();
+  polys->Delete();
+  scalars->Delete();
+  return pd;
+}
+
+static int CompareOutputs(vtkPolyData *a, vtkPolyData *b)
+{
+  if (a->GetNumberOfPoints() != b->GetNumberOfPoints() ||
+      a->GetNumberOfCells() != b->GetNumberOfCells() ||
+      a->GetNumberOfLines() != b->GetNumberOfLines())
+    {
+    cerr << "Point or cell counts differ: " << a->GetNumberOfPoints()
+         << " / " << b->GetNumberOfPoints() << " points, "
+         << a->GetNumberOfCells() << " / " << b->GetNumberOfCells()
+         << " cells" << endl;
+    return 1;
+    }
+  vtkIdType i;
+  for (i=0; i < a->GetNumberOfPoints(); i++)
+    {
+    double *pa = a->GetPoint(i);
+    double xa[3] = {pa[0], pa[1], pa[2]};
+    double *pb = b->GetPoint(i);
+    if (xa[0] != pb[0] || xa[1] != pb[1] || xa[2] != pb[2] ||
+        a->GetPointData()->GetScalars()->GetTuple1(i) !=
+        b->GetPointData()->GetScalars()->GetTuple1(i))
+      {
+      cerr << "Point " << i << " differs" << endl;
+      return 1;
+      }
+    }
+  vtkIdTypeArray *ca = a->GetPolys()->GetData();
+  vtkIdTypeArray *cb = b->GetPolys()->GetData();
+  if (ca->GetNumberOfTuples() != cb->GetNumberOfTuples())
+    {
+    cerr << "Connectivity sizes differ" << endl;
+    return 1;
+    }
+  for (i=0; i < ca->GetNumberOfTuples(); i++)
+    {
+    if (ca->GetValue(i) != cb->GetValue(i))
+      {
+      cerr << "Connectivity differs at " << i << endl;
+      return 1;
+      }
+    }
+  return 0;
+}
+
+int TestCleanPolyDataParallelMerging(int, char *[])
+{
+  int rval = 0;
+  vtkPolyData *input = MakeSplitQuads(40);
+
+  vtkCleanPolyData *serial = vtkCleanPolyData::New();
+  serial->SetInput(input);
+  serial->Update();
+
+  vtkCleanPolyData *bulk = vtkCleanPolyData::New();
+  bulk->SetInput(input);
+  bulk->ParallelPointMergingOn();
+  bulk->Update();
+
+  rval += CompareOutputs(serial->GetOutput(), bulk->GetOutput());
+  if (bulk->GetOutput()->GetNumberOfPoints() != 41*41)
+    {
+    cerr << "Expected " << 41*41 << " points, got "
+         << bulk->GetOutput()->GetNumberOfPoints() << endl;
+    rval++;
+    }
+
+  // a tolerance smaller than the grid spacing merges the same points
+  serial->SetToleranceIsAbsolute(1);
+  serial->SetAbsoluteTolerance(0.01);
+  serial->Update();
+  bulk->SetToleranceIsAbsolute(1);
+  bulk->SetAbsoluteTolerance(0.01);
+  bulk->Update();
+  rval += CompareOutputs(serial->GetOutput(), bulk->GetOutput());
+
+  // the merge map numbers unique points by first occurrence
+  vtkMergeCoincidentPoints *merger = vtkMergeCoincidentPoints::New();
+  vtkIdTypeArray *mergeMap = vtkIdTypeArray::New();
+  vtkPoints *merged = vtkPoints::New();
+  vtkIdType numUnique = merger->MergePoints(input->GetPoints(), mergeMap,
+                                            merged);
+  vtkIdType next = 0;
+  for (vtkIdType i=0; i < mergeMap->GetNumberOfTuples(); i++)
+    {
+    vtkIdType id = mergeMap->GetValue(i);
+    if (id > next || id < 0)
+      {
+      cerr << "Merge map is not in first occurrence order" << endl;
+      rval++;
+      break;
+      }
+    if (id == next)
+      {
+      next++;
+      }
+    }
+  if (next != numUnique || merged->GetNumberOfPoints() != numUnique)
+    {
+    cerr << "Wrong number of unique points" << endl;
+    rval++;
+    }
+
+  merged->Delete();
+  mergeMap->Delete();
+  merger->Delete();
+  serial->Delete();
+  bulk->Delete();
+  input->Delete();
+
+  return rval;
+}
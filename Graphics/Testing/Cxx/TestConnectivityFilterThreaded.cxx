@@ -0,0 +1,235 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestConnectivityFilterThreaded.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Checks that vtkConnectivityFilter and vtkPolyDataConnectivityFilter find
+// the same regions whatever their NumberOfThreads, and that labeling the
+// regions only adds the region ids to the input.
+
+#include "vtkAppendFilter.h"
+#include "vtkAppendPolyData.h"
+#include "vtkCellData.h"
+#include "vtkConnectivityFilter.h"
+#include "vtkFloatArray.h"
+#include "vtkIdTypeArray.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+#include "vtkPolyDataConnectivityFilter.h"
+#include "vtkSphereSource.h"
+#include "vtkUnstructuredGrid.h"
+
+#include <math.h>
+
+static int CompareArrays(vtkFieldData *a, vtkFieldData *b)
+{
+  if (a->GetNumberOfArrays() != b->GetNumberOfArrays())
+    {
+    cerr << "Number of arrays differ" << endl;
+    return 1;
+    }
+  for (int i=0; i < a->GetNumberOfArrays(); i++)
+    {
+    vtkDataArray *da = a->GetArray(i);
+    vtkDataArray *db = b->GetArray(i);
+    if (!da || !db || strcmp(da->GetName(), db->GetName()) ||
+        da->GetNumberOfTuples() != db->GetNumberOfTuples() ||
+        da->GetNumberOfComponents() != db->GetNumberOfComponents())
+      {
+      cerr << "Array " << i << " differs" << endl;
+      return 1;
+      }
+    for (vtkIdType t=0; t < da->GetNumberOfTuples(); t++)
+      {
+      for (int c=0; c < da->GetNumberOfComponents(); c++)
+        {
+        if (da->GetComponent(t, c) != db->GetComponent(t, c))
+          {
+          cerr << "Array " << da->GetName() << " differs at tuple " << t
+               << endl;
+          return 1;
+          }
+        }
+      }
+    }
+  return 0;
+}
+
+static int CompareOutputs(vtkDataSet *a, vtkDataSet *b)
+{
+  if (a->GetNumberOfPoints() != b->GetNumberOfPoints() ||
+      a->GetNumberOfCells() != b->GetNumberOfCells())
+    {
+    cerr << "Point or cell counts differ: " << a->GetNumberOfPoints()
+         << " / " << b->GetNumberOfPoints() << " points, "
+         << a->GetNumberOfCells() << " / " << b->GetNumberOfCells()
+         << " cells" << endl;
+    return 1;
+    }
+  for (vtkIdType i=0; i < a->GetNumberOfPoints(); i++)
+    {
+    double xa[3], xb[3];
+    a->GetPoint(i, xa);
+    b->GetPoint(i, xb);
+    if (xa[0] != xb[0] || xa[1] != xb[1] || xa[2] != xb[2])
+      {
+      cerr << "Point " << i << " differs" << endl;
+      return 1;
+      }
+    }
+  return CompareArrays(a->GetPointData(), b->GetPointData()) +
+    CompareArrays(a->GetCellData(), b->GetCellData());
+}
+
+// Each sphere of the input must be a region, numbered in the order of the
+// spheres.
+static int CheckLabels(vtkDataSet *output, vtkPolyData *input, int numSpheres)
+{
+  vtkDataArray *cellRegions = output->GetCellData()->GetArray("RegionId");
+  vtkDataArray *pointRegions = output->GetPointData()->GetArray("RegionId");
+  if (output->GetNumberOfPoints() != input->GetNumberOfPoints() ||
+      output->GetNumberOfCells() != input->GetNumberOfCells() ||
+      !cellRegions || !pointRegions)
+    {
+    cerr << "The regions are not labeled on the input" << endl;
+    return 1;
+    }
+  vtkIdType cellsPerSphere = input->GetNumberOfCells() / numSpheres;
+  vtkIdType pointsPerSphere = input->GetNumberOfPoints() / numSpheres;
+  for (vtkIdType i=0; i < input->GetNumberOfCells(); i++)
+    {
+    if (cellRegions->GetComponent(i, 0) != i / cellsPerSphere)
+      {
+      cerr << "Cell " << i << " is in the wrong region" << endl;
+      return 1;
+      }
+    }
+  for (vtkIdType i=0; i < input->GetNumberOfPoints(); i++)
+    {
+    if (pointRegions->GetComponent(i, 0) != i / pointsPerSphere)
+      {
+      cerr << "Point " << i << " is in the wrong region" << endl;
+      return 1;
+      }
+    }
+  return 0;
+}
+
+int TestConnectivityFilterThreaded(int, char *[])
+{
+  int rval = 0;
+
+  // a row of separate spheres, with a scalar splitting them further
+  const int numSpheres = 6;
+  vtkAppendPolyData *append = vtkAppendPolyData::New();
+  for (int s=0; s < numSpheres; s++)
+    {
+    vtkSphereSource *sphere = vtkSphereSource::New();
+    sphere->SetThetaResolution(100);
+    sphere->SetPhiResolution(60);
+    sphere->SetCenter(3.0*s, 0.0, 0.0);
+    sphere->Update();
+    append->AddInput(sphere->GetOutput());
+    sphere->Delete();
+    }
+  append->Update();
+  vtkPolyData *input = vtkPolyData::New();
+  input->ShallowCopy(append->GetOutput());
+  vtkFloatArray *scalars = vtkFloatArray::New();
+  scalars->SetName("Wave");
+  for (vtkIdType i=0; i < input->GetNumberOfPoints(); i++)
+    {
+    double x[3];
+    input->GetPoint(i, x);
+    scalars->InsertNextValue(sin(4.0*x[0]) + x[1]*x[2]);
+    }
+  input->GetPointData()->SetScalars(scalars);
+  scalars->Delete();
+  vtkAppendFilter *grid = vtkAppendFilter::New();
+  grid->AddInput(input);
+  grid->Update();
+
+  vtkConnectivityFilter *serial = vtkConnectivityFilter::New();
+  serial->SetNumberOfThreads(1);
+  serial->SetInput(grid->GetOutput());
+  vtkConnectivityFilter *threaded = vtkConnectivityFilter::New();
+  threaded->SetNumberOfThreads(4);
+  threaded->SetInput(grid->GetOutput());
+  vtkPolyDataConnectivityFilter *polySerial =
+    vtkPolyDataConnectivityFilter::New();
+  polySerial->SetNumberOfThreads(1);
+  polySerial->SetInput(input);
+  vtkPolyDataConnectivityFilter *polyThreaded =
+    vtkPolyDataConnectivityFilter::New();
+  polyThreaded->SetNumberOfThreads(4);
+  polyThreaded->SetInput(input);
+
+  for (int config=0; config < 4; config++)
+    {
+    vtkConnectivityFilter *filters[2] = {serial, threaded};
+    vtkPolyDataConnectivityFilter *polyFilters[2] = {polySerial, polyThreaded};
+    for (int f=0; f < 2; f++)
+      {
+      vtkConnectivityFilter *connect = filters[f];
+      vtkPolyDataConnectivityFilter *polyConnect = polyFilters[f];
+      if (config == 1)
+        {
+        connect->SetExtractionModeToLargestRegion();
+        polyConnect->SetExtractionModeToLargestRegion();
+        }
+      else
+        {
+        connect->SetExtractionModeToAllRegions();
+        polyConnect->SetExtractionModeToAllRegions();
+        }
+      connect->SetScalarConnectivity(config == 2);
+      connect->SetScalarRange(0.0, 0.5);
+      connect->ColorRegionsOn();
+      connect->SetLabelRegionsOnly(config == 3);
+      connect->Update();
+      polyConnect->SetScalarConnectivity(config == 2);
+      polyConnect->SetScalarRange(0.0, 0.5);
+      polyConnect->ColorRegionsOn();
+      polyConnect->SetLabelRegionsOnly(config == 3);
+      polyConnect->Update();
+      }
+
+    rval += CompareOutputs(serial->GetOutput(), threaded->GetOutput());
+    rval += CompareOutputs(polySerial->GetOutput(),
+                           polyThreaded->GetOutput());
+    int numRegions = threaded->GetNumberOfExtractedRegions();
+    if (numRegions != polyThreaded->GetNumberOfExtractedRegions() ||
+        numRegions != serial->GetNumberOfExtractedRegions() ||
+        (config != 2 && numRegions != numSpheres) ||
+        (config == 2 && numRegions <= numSpheres))
+      {
+      cerr << "Found " << numRegions << " regions in configuration " << config
+           << endl;
+      rval++;
+      }
+    if (config == 3)
+      {
+      rval += CheckLabels(threaded->GetOutput(), input, numSpheres);
+      rval += CheckLabels(polyThreaded->GetOutput(), input, numSpheres);
+      }
+    }
+
+  serial->Delete();
+  threaded->Delete();
+  polySerial->Delete();
+  polyThreaded->Delete();
+  grid->Delete();
+  input->Delete();
+  append->Delete();
+  return rval;
+}
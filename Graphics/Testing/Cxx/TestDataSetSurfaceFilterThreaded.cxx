@@ -0,0 +1,238 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestDataSetSurfaceFilterThreaded.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Checks that vtkDataSetSurfaceFilter extracts the same surface of an
+// unstructured grid whatever its NumberOfThreads, and that the face hashing
+// methods overridden by a subclass are called.
+
+#include "vtkCellArray.h"
+#include "vtkCellData.h"
+#include "vtkCellType.h"
+#include "vtkDataSetSurfaceFilter.h"
+#include "vtkIdTypeArray.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+#include "vtkUnstructuredGrid.h"
+
+// Counts the quads hashed through the virtual method.
+class vtkQuadCountingSurfaceFilter : public vtkDataSetSurfaceFilter
+{
+public:
+  static vtkQuadCountingSurfaceFilter *New()
+    { return new vtkQuadCountingSurfaceFilter; }
+  vtkTypeMacro(vtkQuadCountingSurfaceFilter,vtkDataSetSurfaceFilter);
+
+  vtkIdType NumberOfQuads;
+
+protected:
+  vtkQuadCountingSurfaceFilter() { this->NumberOfQuads = 0; }
+
+  virtual void InsertQuadInHash(vtkIdType a, vtkIdType b, vtkIdType c,
+                                vtkIdType d, vtkIdType sourceId)
+    {
+    this->NumberOfQuads++;
+    this->Superclass::InsertQuadInHash(a, b, c, d, sourceId);
+    }
+};
+
+// A res^3 lattice of cells.  If mixed is set, the cells are a mix of
+// hexahedra, pairs of wedges and pyramids around a center point, plus a
+// vertex, a line and a triangle.
+static vtkUnstructuredGrid *MakeGrid(int res, int mixed)
+{
+  vtkUnstructuredGrid *grid = vtkUnstructuredGrid::New();
+  vtkPoints *pts = vtkPoints::New();
+  int n = res + 1;
+  int i, j, k;
+  for (k=0; k < n; k++)
+    {
+    for (j=0; j < n; j++)
+      {
+      for (i=0; i < n; i++)
+        {
+        pts->InsertNextPoint(i, j, k);
+        }
+      }
+    }
+  grid->Allocate(res*res*res*2);
+  for (k=0; k < res; k++)
+    {
+    for (j=0; j < res; j++)
+      {
+      for (i=0; i < res; i++)
+        {
+        vtkIdType c[8];
+        c[0] = i + n*(j + n*k);
+        c[1] = c[0] + 1;
+        c[2] = c[0] + 1 + n;
+        c[3] = c[0] + n;
+        c[4] = c[0] + n*n;
+        c[5] = c[1] + n*n;
+        c[6] = c[2] + n*n;
+        c[7] = c[3] + n*n;
+        int kind = mixed ? (i + 2*j + 3*k) % 3 : 0;
+        if (kind == 0)
+          {
+          grid->InsertNextCell(VTK_HEXAHEDRON, 8, c);
+          }
+        else if (kind == 1)
+          {
+          vtkIdType w0[6] = {c[0], c[1], c[3], c[4], c[5], c[7]};
+          vtkIdType w1[6] = {c[1], c[2], c[3], c[5], c[6], c[7]};
+          grid->InsertNextCell(VTK_WEDGE, 6, w0);
+          grid->InsertNextCell(VTK_WEDGE, 6, w1);
+          }
+        else
+          {
+          vtkIdType center = pts->InsertNextPoint(i + 0.5, j + 0.5, k + 0.5);
+          vtkIdType p0[5] = {c[0], c[1], c[2], c[3], center};
+          vtkIdType p1[5] = {c[4], c[7], c[6], c[5], center};
+          vtkIdType t0[4] = {c[0], c[1], c[5], center};
+          vtkIdType t1[4] = {c[0], c[5], c[4], center};
+          grid->InsertNextCell(VTK_PYRAMID, 5, p0);
+          grid->InsertNextCell(VTK_PYRAMID, 5, p1);
+          grid->InsertNextCell(VTK_TETRA, 4, t0);
+          grid->InsertNextCell(VTK_TETRA, 4, t1);
+          }
+        }
+      }
+    }
+  if (mixed)
+    {
+    vtkIdType ids[3] = {0, 1, n};
+    grid->InsertNextCell(VTK_VERTEX, 1, ids);
+    grid->InsertNextCell(VTK_LINE, 2, ids);
+    grid->InsertNextCell(VTK_TRIANGLE, 3, ids);
+    }
+  grid->SetPoints(pts);
+  pts->Delete();
+  return grid;
+}
+
+static int CompareSurfaces(vtkPolyData *a, vtkPolyData *b)
+{
+  if (a->GetNumberOfPoints() != b->GetNumberOfPoints() ||
+      a->GetNumberOfCells() != b->GetNumberOfCells() ||
+      a->GetNumberOfPolys() != b->GetNumberOfPolys())
+    {
+    cerr << "Point or cell counts differ: " << a->GetNumberOfPoints()
+         << " / " << b->GetNumberOfPoints() << " points, "
+         << a->GetNumberOfCells() << " / " << b->GetNumberOfCells()
+         << " cells" << endl;
+    return 1;
+    }
+  vtkIdType i;
+  for (i=0; i < a->GetNumberOfPoints(); i++)
+    {
+    double xa[3], xb[3];
+    a->GetPoint(i, xa);
+    b->GetPoint(i, xb);
+    if (xa[0] != xb[0] || xa[1] != xb[1] || xa[2] != xb[2])
+      {
+      cerr << "Point " << i << " differs" << endl;
+      return 1;
+      }
+    }
+  vtkIdTypeArray *ca = a->GetPolys()->GetData();
+  vtkIdTypeArray *cb = b->GetPolys()->GetData();
+  if (ca->GetNumberOfTuples() != cb->GetNumberOfTuples())
+    {
+    cerr << "Connectivity sizes differ" << endl;
+    return 1;
+    }
+  for (i=0; i < ca->GetNumberOfTuples(); i++)
+    {
+    if (ca->GetValue(i) != cb->GetValue(i))
+      {
+      cerr << "Connectivity differs at " << i << endl;
+      return 1;
+      }
+    }
+  vtkIdTypeArray *ida = vtkIdTypeArray::SafeDownCast(
+    a->GetCellData()->GetArray("vtkOriginalCellIds"));
+  vtkIdTypeArray *idb = vtkIdTypeArray::SafeDownCast(
+    b->GetCellData()->GetArray("vtkOriginalCellIds"));
+  if (!ida || !idb)
+    {
+    cerr << "Missing original cell ids" << endl;
+    return 1;
+    }
+  for (i=0; i < a->GetNumberOfCells(); i++)
+    {
+    if (ida->GetValue(i) != idb->GetValue(i))
+      {
+      cerr << "Original id of cell " << i << " differs" << endl;
+      return 1;
+      }
+    }
+  return 0;
+}
+
+int TestDataSetSurfaceFilterThreaded(int, char *[])
+{
+  int rval = 0;
+  const int res = 16;
+
+  vtkDataSetSurfaceFilter *serial = vtkDataSetSurfaceFilter::New();
+  serial->SetNumberOfThreads(1);
+  serial->PassThroughCellIdsOn();
+  vtkDataSetSurfaceFilter *threaded = vtkDataSetSurfaceFilter::New();
+  threaded->SetNumberOfThreads(4);
+  threaded->PassThroughCellIdsOn();
+
+  for (int mixed=0; mixed < 2; mixed++)
+    {
+    vtkUnstructuredGrid *grid = MakeGrid(res, mixed);
+    serial->SetInput(grid);
+    serial->Update();
+    threaded->SetInput(grid);
+    threaded->Update();
+    rval += CompareSurfaces(serial->GetOutput(), threaded->GetOutput());
+
+    vtkPolyData *output = threaded->GetOutput();
+    if (mixed && (output->GetNumberOfVerts() != 1 ||
+                  output->GetNumberOfLines() != 1))
+      {
+      cerr << "Vertex or line missing" << endl;
+      rval++;
+      }
+    // the skin of the lattice
+    if (!mixed && output->GetNumberOfPolys() != 6*res*res)
+      {
+      cerr << "Expected " << 6*res*res << " faces, got "
+           << output->GetNumberOfPolys() << endl;
+      rval++;
+      }
+    grid->Delete();
+    }
+
+  // a subclass is hashed serially, through its overrides
+  vtkUnstructuredGrid *grid = MakeGrid(res, 0);
+  vtkQuadCountingSurfaceFilter *counting = vtkQuadCountingSurfaceFilter::New();
+  counting->SetNumberOfThreads(4);
+  counting->SetInput(grid);
+  counting->Update();
+  if (counting->NumberOfQuads != 6*res*res*res)
+    {
+    cerr << "Expected " << 6*res*res*res << " quads through the subclass, "
+         << "got " << counting->NumberOfQuads << endl;
+    rval++;
+    }
+  counting->Delete();
+  grid->Delete();
+
+  serial->Delete();
+  threaded->Delete();
+  return rval;
+}
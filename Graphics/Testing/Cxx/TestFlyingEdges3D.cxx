@@ -0,0 +1,210 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestFlyingEdges3D.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Checks that vtkFlyingEdges3D contours the same way whatever its
+// NumberOfThreads, that it finds as many points and triangles as
+// vtkSynchronizedTemplates3D, and that the normals of the spheres it extracts from a
+// distance field point toward their center, against the gradient.
+
+#include "vtkCellArray.h"
+#include "vtkFloatArray.h"
+#include "vtkFlyingEdges3D.h"
+#include "vtkIdTypeArray.h"
+#include "vtkImageData.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+#include "vtkSynchronizedTemplates3D.h"
+
+#include <math.h>
+
+static int CompareArrays(vtkFieldData *a, vtkFieldData *b)
+{
+  if (a->GetNumberOfArrays() != b->GetNumberOfArrays())
+    {
+    cerr << "Number of arrays differ" << endl;
+    return 1;
+    }
+  for (int i=0; i < a->GetNumberOfArrays(); i++)
+    {
+    vtkDataArray *da = a->GetArray(i);
+    vtkDataArray *db = b->GetArray(i);
+    if (!da || !db || strcmp(da->GetName(), db->GetName()) ||
+        da->GetNumberOfTuples() != db->GetNumberOfTuples() ||
+        da->GetNumberOfComponents() != db->GetNumberOfComponents())
+      {
+      cerr << "Array " << i << " differs" << endl;
+      return 1;
+      }
+    for (vtkIdType t=0; t < da->GetNumberOfTuples(); t++)
+      {
+      for (int c=0; c < da->GetNumberOfComponents(); c++)
+        {
+        if (da->GetComponent(t, c) != db->GetComponent(t, c))
+          {
+          cerr << "Array " << da->GetName() << " differs at tuple " << t
+               << endl;
+          return 1;
+          }
+        }
+      }
+    }
+  return 0;
+}
+
+static int CompareMeshes(vtkPolyData *a, vtkPolyData *b)
+{
+  if (a->GetNumberOfPoints() != b->GetNumberOfPoints() ||
+      a->GetNumberOfPolys() != b->GetNumberOfPolys())
+    {
+    cerr << "Point or triangle counts differ: " << a->GetNumberOfPoints()
+         << " / " << b->GetNumberOfPoints() << " points, "
+         << a->GetNumberOfPolys() << " / " << b->GetNumberOfPolys()
+         << " triangles" << endl;
+    return 1;
+    }
+  vtkIdType i;
+  for (i=0; i < a->GetNumberOfPoints(); i++)
+    {
+    double xa[3], xb[3];
+    a->GetPoint(i, xa);
+    b->GetPoint(i, xb);
+    if (xa[0] != xb[0] || xa[1] != xb[1] || xa[2] != xb[2])
+      {
+      cerr << "Point " << i << " differs" << endl;
+      return 1;
+      }
+    }
+  vtkIdTypeArray *ca = a->GetPolys()->GetData();
+  vtkIdTypeArray *cb = b->GetPolys()->GetData();
+  if (ca->GetNumberOfTuples() != cb->GetNumberOfTuples())
+    {
+    cerr << "Connectivity sizes differ" << endl;
+    return 1;
+    }
+  for (i=0; i < ca->GetNumberOfTuples(); i++)
+    {
+    if (ca->GetValue(i) != cb->GetValue(i))
+      {
+      cerr << "Connectivity differs at " << i << endl;
+      return 1;
+      }
+    }
+  return CompareArrays(a->GetPointData(), b->GetPointData());
+}
+
+int TestFlyingEdges3D(int, char *[])
+{
+  int rval = 0;
+
+  // The distance to the center of a volume that is not a cube, not starting
+  // at the origin of its extent.
+  vtkImageData *image = vtkImageData::New();
+  image->SetExtent(-10, 69, 5, 94, 0, 69);
+  image->SetOrigin(-0.6, -1.2, -0.5);
+  image->SetSpacing(0.02, 0.025, 0.015);
+  vtkFloatArray *distances = vtkFloatArray::New();
+  distances->SetName("Distance");
+  distances->SetNumberOfTuples(image->GetNumberOfPoints());
+  double center[3] = {0.2, 1.1, 0.5};
+  for (vtkIdType ptId=0; ptId < image->GetNumberOfPoints(); ptId++)
+    {
+    double x[3];
+    image->GetPoint(ptId, x);
+    distances->SetValue(ptId, static_cast<float>(
+      sqrt((x[0] - center[0])*(x[0] - center[0]) +
+           (x[1] - center[1])*(x[1] - center[1]) +
+           (x[2] - center[2])*(x[2] - center[2]))));
+    }
+  image->GetPointData()->SetScalars(distances);
+  distances->Delete();
+
+  // radii that no distance equals, so that no triangle degenerates
+  double radii[3] = {0.1537, 0.3121, 0.4679};
+  vtkFlyingEdges3D *serial = vtkFlyingEdges3D::New();
+  serial->SetInput(image);
+  serial->SetNumberOfThreads(1);
+  vtkFlyingEdges3D *threaded = vtkFlyingEdges3D::New();
+  threaded->SetInput(image);
+  threaded->SetNumberOfThreads(4);
+  vtkSynchronizedTemplates3D *templates = vtkSynchronizedTemplates3D::New();
+  templates->SetInput(image);
+  for (int i=0; i < 3; i++)
+    {
+    serial->SetValue(i, radii[i]);
+    threaded->SetValue(i, radii[i]);
+    templates->SetValue(i, radii[i]);
+    }
+
+  for (int config=0; config < 2; config++)
+    {
+    serial->SetComputeGradients(config);
+    serial->SetComputeScalars(!config);
+    serial->Update();
+    threaded->SetComputeGradients(config);
+    threaded->SetComputeScalars(!config);
+    threaded->Update();
+    rval += CompareMeshes(serial->GetOutput(), threaded->GetOutput());
+    }
+
+  templates->Update();
+  vtkPolyData *expected = templates->GetOutput();
+  vtkPolyData *output = threaded->GetOutput();
+  if (output->GetNumberOfPoints() != expected->GetNumberOfPoints() ||
+      output->GetNumberOfPolys() != expected->GetNumberOfPolys() ||
+      output->GetNumberOfPolys() < 1000)
+    {
+    cerr << "Flying edges gives " << output->GetNumberOfPoints()
+         << " points and " << output->GetNumberOfPolys()
+         << " triangles instead of " << expected->GetNumberOfPoints()
+         << " and " << expected->GetNumberOfPolys() << endl;
+    rval++;
+    }
+
+  // Each point lies on one of the spheres, with a normal pointing inward.
+  vtkDataArray *normals = output->GetPointData()->GetNormals();
+  if (!normals || !output->GetPointData()->GetArray("Gradients"))
+    {
+    cerr << "Normals or gradients are missing" << endl;
+    return rval + 1;
+    }
+  for (vtkIdType ptId=0; ptId < output->GetNumberOfPoints(); ptId++)
+    {
+    double x[3], n[3];
+    output->GetPoint(ptId, x);
+    normals->GetTuple(ptId, n);
+    double r[3] = {x[0] - center[0], x[1] - center[1], x[2] - center[2]};
+    double dist = sqrt(r[0]*r[0] + r[1]*r[1] + r[2]*r[2]);
+    if (fabs(dist - radii[0]) > 0.01 && fabs(dist - radii[1]) > 0.01 &&
+        fabs(dist - radii[2]) > 0.01)
+      {
+      cerr << "Point " << ptId << " is off the spheres" << endl;
+      rval++;
+      break;
+      }
+    if (fabs(n[0]*n[0] + n[1]*n[1] + n[2]*n[2] - 1.0) > 1e-3 ||
+        -(n[0]*r[0] + n[1]*r[1] + n[2]*r[2]) < 0.9*dist)
+      {
+      cerr << "Normal " << ptId << " does not point inward" << endl;
+      rval++;
+      break;
+      }
+    }
+
+  serial->Delete();
+  threaded->Delete();
+  templates->Delete();
+  image->Delete();
+  return rval;
+}
@@ -0,0 +1,293 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestGlyph3DThreaded.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Checks that vtkGlyph3D generates the same glyphs whatever its
+// NumberOfThreads, and that the transformations of its instanced output
+// map the sources to these glyphs.
+
+#include "vtkCellArray.h"
+#include "vtkCellData.h"
+#include "vtkConeSource.h"
+#include "vtkDoubleArray.h"
+#include "vtkFloatArray.h"
+#include "vtkGlyph3D.h"
+#include "vtkIdTypeArray.h"
+#include "vtkMath.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+#include "vtkTexturedSphereSource.h"
+#include "vtkTransform.h"
+
+#include <math.h>
+
+// Random points with a size, a direction (some of them along x, or null)
+// and a temperature
+static vtkPolyData *MakePoints(int num)
+{
+  vtkPolyData *input = vtkPolyData::New();
+  vtkPoints *pts = vtkPoints::New();
+  vtkFloatArray *sizes = vtkFloatArray::New();
+  sizes->SetName("Size");
+  vtkDoubleArray *directions = vtkDoubleArray::New();
+  directions->SetName("Direction");
+  directions->SetNumberOfComponents(3);
+  vtkFloatArray *temperatures = vtkFloatArray::New();
+  temperatures->SetName("Temperature");
+  vtkMath::RandomSeed(1357);
+  for (int i=0; i < num; i++)
+    {
+    pts->InsertNextPoint(vtkMath::Random(-10.0, 10.0),
+                         vtkMath::Random(-10.0, 10.0),
+                         vtkMath::Random(-10.0, 10.0));
+    sizes->InsertNextValue(i % 50 ? vtkMath::Random(0.0, 1.0) : 0.0);
+    if (i % 7 == 0)
+      {
+      directions->InsertNextTuple3(i % 2 ? -2.0 : 0.0, 0.0, 0.0);
+      }
+    else
+      {
+      directions->InsertNextTuple3(vtkMath::Random(-1.0, 1.0),
+                                   vtkMath::Random(-1.0, 1.0),
+                                   vtkMath::Random(-1.0, 1.0));
+      }
+    temperatures->InsertNextValue(vtkMath::Random(0.0, 100.0));
+    }
+  input->SetPoints(pts);
+  input->GetPointData()->SetScalars(sizes);
+  input->GetPointData()->SetVectors(directions);
+  input->GetPointData()->AddArray(temperatures);
+  pts->Delete();
+  sizes->Delete();
+  directions->Delete();
+  temperatures->Delete();
+  return input;
+}
+
+static int CompareArrays(vtkFieldData *a, vtkFieldData *b)
+{
+  if (a->GetNumberOfArrays() != b->GetNumberOfArrays())
+    {
+    cerr << "Number of arrays differ" << endl;
+    return 1;
+    }
+  for (int i=0; i < a->GetNumberOfArrays(); i++)
+    {
+    vtkDataArray *da = a->GetArray(i);
+    vtkDataArray *db = b->GetArray(i);
+    if (!da || !db || strcmp(da->GetName(), db->GetName()) ||
+        da->GetDataType() != db->GetDataType() ||
+        da->GetNumberOfTuples() != db->GetNumberOfTuples() ||
+        da->GetNumberOfComponents() != db->GetNumberOfComponents())
+      {
+      cerr << "Array " << i << " differs" << endl;
+      return 1;
+      }
+    for (vtkIdType t=0; t < da->GetNumberOfTuples(); t++)
+      {
+      for (int c=0; c < da->GetNumberOfComponents(); c++)
+        {
+        if (da->GetComponent(t, c) != db->GetComponent(t, c))
+          {
+          cerr << "Array " << da->GetName() << " differs at tuple " << t
+               << endl;
+          return 1;
+          }
+        }
+      }
+    }
+  return 0;
+}
+
+static int CompareGlyphs(vtkPolyData *a, vtkPolyData *b)
+{
+  if (a->GetNumberOfPoints() != b->GetNumberOfPoints() ||
+      a->GetNumberOfPolys() != b->GetNumberOfPolys() ||
+      a->GetNumberOfCells() != b->GetNumberOfCells())
+    {
+    cerr << "Point or cell counts differ: " << a->GetNumberOfPoints()
+         << " / " << b->GetNumberOfPoints() << " points, "
+         << a->GetNumberOfCells() << " / " << b->GetNumberOfCells()
+         << " cells" << endl;
+    return 1;
+    }
+  vtkIdType i;
+  for (i=0; i < a->GetNumberOfPoints(); i++)
+    {
+    double xa[3], xb[3];
+    a->GetPoint(i, xa);
+    b->GetPoint(i, xb);
+    if (xa[0] != xb[0] || xa[1] != xb[1] || xa[2] != xb[2])
+      {
+      cerr << "Point " << i << " differs" << endl;
+      return 1;
+      }
+    }
+  vtkIdTypeArray *ca = a->GetPolys()->GetData();
+  vtkIdTypeArray *cb = b->GetPolys()->GetData();
+  if (ca->GetNumberOfTuples() != cb->GetNumberOfTuples())
+    {
+    cerr << "Connectivity sizes differ" << endl;
+    return 1;
+    }
+  for (i=0; i < ca->GetNumberOfTuples(); i++)
+    {
+    if (ca->GetValue(i) != cb->GetValue(i))
+      {
+      cerr << "Connectivity differs at " << i << endl;
+      return 1;
+      }
+    }
+  return CompareArrays(a->GetPointData(), b->GetPointData()) +
+    CompareArrays(a->GetCellData(), b->GetCellData());
+}
+
+// The instance transformations applied to the source points must give the
+// glyph points.
+static int CheckInstances(vtkPolyData *instances, vtkPolyData *glyphs,
+                          vtkPolyData *source)
+{
+  vtkIdType numSourcePts = source->GetNumberOfPoints();
+  vtkIdType numInstances = instances->GetNumberOfPoints();
+  vtkDataArray *transforms =
+    instances->GetPointData()->GetArray("GlyphTransform");
+  if (!transforms || instances->GetNumberOfVerts() != numInstances ||
+      !instances->GetPointData()->GetArray("GlyphDirection") ||
+      !instances->GetPointData()->GetArray("GlyphScaleFactors") ||
+      glyphs->GetNumberOfPoints() != numInstances*numSourcePts)
+    {
+    cerr << "Unexpected instanced output" << endl;
+    return 1;
+    }
+  for (vtkIdType i=0; i < numInstances; i++)
+    {
+    double m[16];
+    transforms->GetTuple(i, m);
+    for (vtkIdType j=0; j < numSourcePts; j++)
+      {
+      double x[3], y[3];
+      source->GetPoint(j, x);
+      glyphs->GetPoint(i*numSourcePts + j, y);
+      for (int r=0; r < 3; r++)
+        {
+        double z = m[4*r]*x[0] + m[4*r+1]*x[1] + m[4*r+2]*x[2] + m[4*r+3];
+        if (fabs(z - y[r]) > 1.0e-4*(1.0 + fabs(y[r])))
+          {
+          cerr << "Transformation of instance " << i << " is wrong" << endl;
+          return 1;
+          }
+        }
+      }
+    }
+  return 0;
+}
+
+int TestGlyph3DThreaded(int, char *[])
+{
+  int rval = 0;
+  vtkPolyData *input = MakePoints(5000);
+  vtkConeSource *cone = vtkConeSource::New();
+  cone->SetResolution(8);
+  cone->Update();
+  vtkTexturedSphereSource *sphere = vtkTexturedSphereSource::New();
+  sphere->SetThetaResolution(8);
+  sphere->SetPhiResolution(6);
+  sphere->Update();
+  vtkTransform *sourceTransform = vtkTransform::New();
+  sourceTransform->RotateZ(30.0);
+  sourceTransform->Translate(0.5, 0.0, 0.0);
+
+  vtkGlyph3D *serial = vtkGlyph3D::New();
+  serial->SetNumberOfThreads(1);
+  vtkGlyph3D *threaded = vtkGlyph3D::New();
+  threaded->SetNumberOfThreads(4);
+  vtkGlyph3D *instanced = vtkGlyph3D::New();
+  instanced->SetNumberOfThreads(3);
+  instanced->InstancedOutputOn();
+
+  for (int config=0; config < 3; config++)
+    {
+    vtkGlyph3D *filters[3] = {serial, threaded, instanced};
+    for (int f=0; f < 3; f++)
+      {
+      vtkGlyph3D *glyph = filters[f];
+      glyph->SetInput(input);
+      glyph->GeneratePointIdsOn();
+      glyph->FillCellDataOn();
+      if (config == 0)
+        {
+        // sphere glyphs with normals and texture coordinates
+        glyph->SetSource(sphere->GetOutput());
+        glyph->SetScaleFactor(0.5);
+        }
+      else if (config == 1)
+        {
+        // cones indexed by the vector magnitude
+        glyph->SetSource(0, cone->GetOutput());
+        glyph->SetSource(1, sphere->GetOutput());
+        glyph->SetIndexModeToVector();
+        glyph->SetScaleModeToScaleByVector();
+        glyph->SetColorModeToColorByVector();
+        glyph->SetRange(0.0, 1.5);
+        glyph->ClampingOn();
+        }
+      else
+        {
+        // transformed cones scaled by vector components and colored by
+        // temperature
+        glyph->SetSource(0, cone->GetOutput());
+        glyph->SetIndexModeToOff();
+        glyph->SetSourceTransform(sourceTransform);
+        glyph->SetScaleModeToScaleByVectorComponents();
+        glyph->SetColorModeToColorByScalar();
+        glyph->SetInputArrayToProcess(
+          3, 0, 0, vtkDataObject::FIELD_ASSOCIATION_POINTS, "Temperature");
+        glyph->ClampingOff();
+        }
+      glyph->Update();
+      }
+
+    vtkPolyData *output = threaded->GetOutput();
+    rval += CompareGlyphs(serial->GetOutput(), output);
+    if (output->GetNumberOfPolys() < 5000 ||
+        !output->GetPointData()->GetArray("InputPointIds") ||
+        (config != 1 && !output->GetCellData()->GetArray("Temperature")) ||
+        (config == 0 && (!output->GetPointData()->GetNormals() ||
+                         !output->GetPointData()->GetTCoords())))
+      {
+      cerr << "Glyphs or their arrays are missing" << endl;
+      rval++;
+      }
+    if (config != 1)
+      {
+      vtkPolyData *source = (config == 0 ? sphere->GetOutput() :
+                             cone->GetOutput());
+      rval += CheckInstances(instanced->GetOutput(), output, source);
+      }
+    else if (!instanced->GetOutput()->GetPointData()->GetArray("GlyphIndex"))
+      {
+      cerr << "Missing glyph indices" << endl;
+      rval++;
+      }
+    }
+
+  serial->Delete();
+  threaded->Delete();
+  instanced->Delete();
+  sourceTransform->Delete();
+  cone->Delete();
+  sphere->Delete();
+  input->Delete();
+  return rval;
+}
@@ -0,0 +1,188 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestPolyDataNormalsThreaded.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Checks that vtkPolyDataNormals computes the same normals whatever its
+// NumberOfThreads, and that skipping the consistency and splitting passes
+// gives the same normals on a consistently ordered smooth surface.
+
+#include "vtkCellArray.h"
+#include "vtkCellData.h"
+#include "vtkIdTypeArray.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+#include "vtkPolyDataNormals.h"
+#include "vtkSphereSource.h"
+#include "vtkSuperquadricSource.h"
+
+static int CompareArrays(vtkFieldData *a, vtkFieldData *b)
+{
+  if (a->GetNumberOfArrays() != b->GetNumberOfArrays())
+    {
+    cerr << "Number of arrays differ" << endl;
+    return 1;
+    }
+  for (int i=0; i < a->GetNumberOfArrays(); i++)
+    {
+    vtkDataArray *da = a->GetArray(i);
+    vtkDataArray *db = b->GetArray(i);
+    if (!da || !db || strcmp(da->GetName(), db->GetName()) ||
+        da->GetNumberOfTuples() != db->GetNumberOfTuples() ||
+        da->GetNumberOfComponents() != db->GetNumberOfComponents())
+      {
+      cerr << "Array " << i << " differs" << endl;
+      return 1;
+      }
+    for (vtkIdType t=0; t < da->GetNumberOfTuples(); t++)
+      {
+      for (int c=0; c < da->GetNumberOfComponents(); c++)
+        {
+        if (da->GetComponent(t, c) != db->GetComponent(t, c))
+          {
+          cerr << "Array " << da->GetName() << " differs at tuple " << t
+               << endl;
+          return 1;
+          }
+        }
+      }
+    }
+  return 0;
+}
+
+static int CompareMeshes(vtkPolyData *a, vtkPolyData *b)
+{
+  if (a->GetNumberOfPoints() != b->GetNumberOfPoints() ||
+      a->GetNumberOfPolys() != b->GetNumberOfPolys())
+    {
+    cerr << "Point or polygon counts differ: " << a->GetNumberOfPoints()
+         << " / " << b->GetNumberOfPoints() << " points, "
+         << a->GetNumberOfPolys() << " / " << b->GetNumberOfPolys()
+         << " polygons" << endl;
+    return 1;
+    }
+  vtkIdType i;
+  for (i=0; i < a->GetNumberOfPoints(); i++)
+    {
+    double xa[3], xb[3];
+    a->GetPoint(i, xa);
+    b->GetPoint(i, xb);
+    if (xa[0] != xb[0] || xa[1] != xb[1] || xa[2] != xb[2])
+      {
+      cerr << "Point " << i << " differs" << endl;
+      return 1;
+      }
+    }
+  vtkIdTypeArray *ca = a->GetPolys()->GetData();
+  vtkIdTypeArray *cb = b->GetPolys()->GetData();
+  if (ca->GetNumberOfTuples() != cb->GetNumberOfTuples())
+    {
+    cerr << "Connectivity sizes differ" << endl;
+    return 1;
+    }
+  for (i=0; i < ca->GetNumberOfTuples(); i++)
+    {
+    if (ca->GetValue(i) != cb->GetValue(i))
+      {
+      cerr << "Connectivity differs at " << i << endl;
+      return 1;
+      }
+    }
+  return CompareArrays(a->GetPointData(), b->GetPointData()) +
+    CompareArrays(a->GetCellData(), b->GetCellData());
+}
+
+int TestPolyDataNormalsThreaded(int, char *[])
+{
+  int rval = 0;
+
+  // a smooth sphere, with some triangles in the wrong order
+  vtkSphereSource *sphere = vtkSphereSource::New();
+  sphere->SetThetaResolution(200);
+  sphere->SetPhiResolution(120);
+  sphere->Update();
+  vtkPolyData *misordered = vtkPolyData::New();
+  misordered->DeepCopy(sphere->GetOutput());
+  misordered->BuildCells();
+  for (vtkIdType cellId=0; cellId < misordered->GetNumberOfCells();
+       cellId += 7)
+    {
+    misordered->ReverseCell(cellId);
+    }
+
+  // a superquadric with sharp edges, made of triangle strips
+  vtkSuperquadricSource *superquadric = vtkSuperquadricSource::New();
+  superquadric->SetThetaResolution(256);
+  superquadric->SetPhiResolution(128);
+  superquadric->SetThetaRoundness(0.2);
+  superquadric->SetPhiRoundness(0.3);
+  superquadric->Update();
+
+  vtkPolyDataNormals *serial = vtkPolyDataNormals::New();
+  serial->SetNumberOfThreads(1);
+  vtkPolyDataNormals *threaded = vtkPolyDataNormals::New();
+  threaded->SetNumberOfThreads(4);
+
+  for (int config=0; config < 4; config++)
+    {
+    vtkPolyDataNormals *filters[2] = {serial, threaded};
+    for (int f=0; f < 2; f++)
+      {
+      vtkPolyDataNormals *normals = filters[f];
+      normals->SetInput(config == 1 ? superquadric->GetOutput() :
+                        misordered);
+      normals->SetConsistency(config != 3);
+      normals->SetSplitting(config == 1);
+      normals->SetAutoOrientNormals(config == 2);
+      normals->SetFlipNormals(config == 3);
+      normals->ComputeCellNormalsOn();
+      normals->Update();
+      }
+    vtkPolyData *output = threaded->GetOutput();
+    rval += CompareMeshes(serial->GetOutput(), output);
+    if (!output->GetPointData()->GetNormals() ||
+        !output->GetCellData()->GetNormals())
+      {
+      cerr << "Normals are missing" << endl;
+      rval++;
+      }
+    if (config == 1 &&
+        output->GetNumberOfPoints() <=
+        superquadric->GetOutput()->GetNumberOfPoints())
+      {
+      cerr << "Sharp edges were not split" << endl;
+      rval++;
+      }
+    }
+
+  // Without consistency nor splitting, the normals of the consistently
+  // ordered sphere are the ones computed with them.
+  serial->SetInput(sphere->GetOutput());
+  serial->ConsistencyOn();
+  serial->SplittingOff();
+  serial->FlipNormalsOff();
+  serial->Update();
+  threaded->SetInput(sphere->GetOutput());
+  threaded->ConsistencyOff();
+  threaded->SplittingOff();
+  threaded->FlipNormalsOff();
+  threaded->Update();
+  rval += CompareMeshes(serial->GetOutput(), threaded->GetOutput());
+
+  serial->Delete();
+  threaded->Delete();
+  superquadric->Delete();
+  misordered->Delete();
+  sphere->Delete();
+  return rval;
+}
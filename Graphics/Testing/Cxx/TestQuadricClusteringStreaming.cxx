@@ -0,0 +1,231 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestQuadricClusteringStreaming.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Checks that vtkQuadricClustering decimates the same way whatever its
+// NumberOfThreads, and that streaming the pieces of a sphere gives the
+// same bins and triangles as decimating the whole sphere.
+
+#include "vtkCellArray.h"
+#include "vtkCellData.h"
+#include "vtkIdFilter.h"
+#include "vtkIdTypeArray.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+#include "vtkQuadricClustering.h"
+#include "vtkSphereSource.h"
+#include "vtkSuperquadricSource.h"
+
+#include <math.h>
+
+static int CompareArrays(vtkFieldData *a, vtkFieldData *b)
+{
+  if (a->GetNumberOfArrays() != b->GetNumberOfArrays())
+    {
+    cerr << "Number of arrays differ" << endl;
+    return 1;
+    }
+  for (int i=0; i < a->GetNumberOfArrays(); i++)
+    {
+    vtkDataArray *da = a->GetArray(i);
+    vtkDataArray *db = b->GetArray(i);
+    if (!da || !db || strcmp(da->GetName(), db->GetName()) ||
+        da->GetNumberOfTuples() != db->GetNumberOfTuples() ||
+        da->GetNumberOfComponents() != db->GetNumberOfComponents())
+      {
+      cerr << "Array " << i << " differs" << endl;
+      return 1;
+      }
+    for (vtkIdType t=0; t < da->GetNumberOfTuples(); t++)
+      {
+      for (int c=0; c < da->GetNumberOfComponents(); c++)
+        {
+        if (da->GetComponent(t, c) != db->GetComponent(t, c))
+          {
+          cerr << "Array " << da->GetName() << " differs at tuple " << t
+               << endl;
+          return 1;
+          }
+        }
+      }
+    }
+  return 0;
+}
+
+static int CompareCells(vtkCellArray *a, vtkCellArray *b)
+{
+  vtkIdTypeArray *ca = a->GetData();
+  vtkIdTypeArray *cb = b->GetData();
+  if (ca->GetNumberOfTuples() != cb->GetNumberOfTuples())
+    {
+    cerr << "Connectivity sizes differ" << endl;
+    return 1;
+    }
+  for (vtkIdType i=0; i < ca->GetNumberOfTuples(); i++)
+    {
+    if (ca->GetValue(i) != cb->GetValue(i))
+      {
+      cerr << "Connectivity differs at " << i << endl;
+      return 1;
+      }
+    }
+  return 0;
+}
+
+static int CompareMeshes(vtkPolyData *a, vtkPolyData *b)
+{
+  if (a->GetNumberOfPoints() != b->GetNumberOfPoints() ||
+      a->GetNumberOfCells() != b->GetNumberOfCells())
+    {
+    cerr << "Point or cell counts differ: " << a->GetNumberOfPoints()
+         << " / " << b->GetNumberOfPoints() << " points, "
+         << a->GetNumberOfCells() << " / " << b->GetNumberOfCells()
+         << " cells" << endl;
+    return 1;
+    }
+  for (vtkIdType i=0; i < a->GetNumberOfPoints(); i++)
+    {
+    double xa[3], xb[3];
+    a->GetPoint(i, xa);
+    b->GetPoint(i, xb);
+    if (xa[0] != xb[0] || xa[1] != xb[1] || xa[2] != xb[2])
+      {
+      cerr << "Point " << i << " differs" << endl;
+      return 1;
+      }
+    }
+  return CompareCells(a->GetPolys(), b->GetPolys()) +
+    CompareCells(a->GetStrips(), b->GetStrips()) +
+    CompareArrays(a->GetPointData(), b->GetPointData()) +
+    CompareArrays(a->GetCellData(), b->GetCellData());
+}
+
+int TestQuadricClusteringStreaming(int, char *[])
+{
+  int rval = 0;
+
+  // a fine sphere with its cell ids, and a superquadric made of strips
+  vtkSphereSource *sphere = vtkSphereSource::New();
+  sphere->SetThetaResolution(400);
+  sphere->SetPhiResolution(300);
+  vtkIdFilter *ids = vtkIdFilter::New();
+  ids->SetInputConnection(sphere->GetOutputPort());
+  ids->PointIdsOff();
+  ids->CellIdsOn();
+  ids->FieldDataOff();
+  ids->Update();
+  vtkSuperquadricSource *superquadric = vtkSuperquadricSource::New();
+  superquadric->SetThetaResolution(256);
+  superquadric->SetPhiResolution(128);
+  superquadric->SetThetaRoundness(0.2);
+  superquadric->SetPhiRoundness(0.3);
+  superquadric->Update();
+
+  vtkQuadricClustering *serial = vtkQuadricClustering::New();
+  serial->SetNumberOfThreads(1);
+  vtkQuadricClustering *threaded = vtkQuadricClustering::New();
+  threaded->SetNumberOfThreads(4);
+
+  for (int config=0; config < 3; config++)
+    {
+    vtkQuadricClustering *filters[2] = {serial, threaded};
+    for (int f=0; f < 2; f++)
+      {
+      vtkQuadricClustering *decimate = filters[f];
+      decimate->SetInput(config == 1 ? superquadric->GetOutput() :
+                         ids->GetOutput());
+      decimate->SetNumberOfDivisions(80, 70, 60);
+      decimate->SetCopyCellData(config == 0);
+      decimate->SetUseInternalTriangles(config != 1);
+      decimate->SetPreventDuplicateCells(config != 1);
+      decimate->SetUseFeatureEdges(config == 2);
+      decimate->SetUseInputPoints(config == 2);
+      decimate->Update();
+      }
+    vtkPolyData *output = threaded->GetOutput();
+    rval += CompareMeshes(serial->GetOutput(), output);
+    if (output->GetNumberOfPolys() < 1000 ||
+        (config == 0 && !output->GetCellData()->GetArray("vtkIdFilter_Ids")))
+      {
+      cerr << "Triangles or their arrays are missing" << endl;
+      rval++;
+      }
+    }
+
+  // Stream the pieces of a sphere, which provides its bounding box.  The
+  // bins are set by their origin and spacing, so that they do not depend on
+  // the exact bounds.
+  sphere->SetThetaResolution(256);
+  sphere->SetPhiResolution(200);
+  serial->SetInputConnection(sphere->GetOutputPort());
+  serial->SetDivisionOrigin(-0.5, -0.5, -0.5);
+  serial->SetDivisionSpacing(1.0/64, 1.0/64, 1.0/64);
+  serial->CopyCellDataOff();
+  serial->UseInternalTrianglesOn();
+  serial->PreventDuplicateCellsOn();
+  serial->UseFeatureEdgesOff();
+  serial->UseInputPointsOff();
+  serial->SetNumberOfStreamDivisions(8);
+  serial->Update();
+  threaded->SetInputConnection(sphere->GetOutputPort());
+  threaded->SetDivisionOrigin(-0.5, -0.5, -0.5);
+  threaded->SetDivisionSpacing(1.0/64, 1.0/64, 1.0/64);
+  threaded->CopyCellDataOff();
+  threaded->UseInternalTrianglesOn();
+  threaded->PreventDuplicateCellsOn();
+  threaded->UseFeatureEdgesOff();
+  threaded->UseInputPointsOff();
+  threaded->SetNumberOfStreamDivisions(8);
+  threaded->Update();
+  vtkPolyData *streamed = threaded->GetOutput();
+  rval += CompareMeshes(serial->GetOutput(), streamed);
+
+  // The same bins and triangles are used without streaming.
+  vtkQuadricClustering *whole = vtkQuadricClustering::New();
+  whole->SetInputConnection(sphere->GetOutputPort());
+  whole->SetDivisionOrigin(-0.5, -0.5, -0.5);
+  whole->SetDivisionSpacing(1.0/64, 1.0/64, 1.0/64);
+  whole->Update();
+  if (streamed->GetNumberOfPoints() != whole->GetOutput()->GetNumberOfPoints()
+      || streamed->GetNumberOfPolys() !=
+      whole->GetOutput()->GetNumberOfPolys() ||
+      streamed->GetNumberOfPolys() < 1000)
+    {
+    cerr << "Streaming gives " << streamed->GetNumberOfPoints()
+         << " points and " << streamed->GetNumberOfPolys()
+         << " triangles instead of " << whole->GetOutput()->GetNumberOfPoints()
+         << " and " << whole->GetOutput()->GetNumberOfPolys() << endl;
+    rval++;
+    }
+  for (vtkIdType i=0; i < streamed->GetNumberOfPoints(); i++)
+    {
+    double x[3];
+    streamed->GetPoint(i, x);
+    double r = sqrt(x[0]*x[0] + x[1]*x[1] + x[2]*x[2]);
+    if (fabs(r - 0.5) > 0.02)
+      {
+      cerr << "Point " << i << " is off the sphere" << endl;
+      rval++;
+      break;
+      }
+    }
+
+  serial->Delete();
+  threaded->Delete();
+  whole->Delete();
+  superquadric->Delete();
+  ids->Delete();
+  sphere->Delete();
+  return rval;
+}
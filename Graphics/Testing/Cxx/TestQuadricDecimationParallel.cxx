@@ -0,0 +1,241 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestQuadricDecimationParallel.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Checks that the parallel passes of vtkQuadricDecimation decimate the same
+// way whatever the NumberOfThreads, reach the target reduction, keep the
+// attributes and the boundary of the mesh, and stay close to the surface.
+
+#include "vtkCellArray.h"
+#include "vtkDataArray.h"
+#include "vtkElevationFilter.h"
+#include "vtkIdTypeArray.h"
+#include "vtkMath.h"
+#include "vtkPlaneSource.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+#include "vtkQuadricDecimation.h"
+#include "vtkSphereSource.h"
+#include "vtkTriangleFilter.h"
+
+#include <math.h>
+
+static int CompareArrays(vtkFieldData *a, vtkFieldData *b)
+{
+  if (a->GetNumberOfArrays() != b->GetNumberOfArrays())
+    {
+    cerr << "Number of arrays differ" << endl;
+    return 1;
+    }
+  for (int i=0; i < a->GetNumberOfArrays(); i++)
+    {
+    vtkDataArray *da = a->GetArray(i);
+    vtkDataArray *db = b->GetArray(i);
+    if (!da || !db || strcmp(da->GetName(), db->GetName()) ||
+        da->GetNumberOfTuples() != db->GetNumberOfTuples() ||
+        da->GetNumberOfComponents() != db->GetNumberOfComponents())
+      {
+      cerr << "Array " << i << " differs" << endl;
+      return 1;
+      }
+    for (vtkIdType t=0; t < da->GetNumberOfTuples(); t++)
+      {
+      for (int c=0; c < da->GetNumberOfComponents(); c++)
+        {
+        if (da->GetComponent(t, c) != db->GetComponent(t, c))
+          {
+          cerr << "Array " << da->GetName() << " differs at tuple " << t
+               << endl;
+          return 1;
+          }
+        }
+      }
+    }
+  return 0;
+}
+
+static int CompareMeshes(vtkPolyData *a, vtkPolyData *b)
+{
+  if (a->GetNumberOfPoints() != b->GetNumberOfPoints() ||
+      a->GetNumberOfPolys() != b->GetNumberOfPolys())
+    {
+    cerr << "Point or triangle counts differ: " << a->GetNumberOfPoints()
+         << " / " << b->GetNumberOfPoints() << " points, "
+         << a->GetNumberOfPolys() << " / " << b->GetNumberOfPolys()
+         << " triangles" << endl;
+    return 1;
+    }
+  vtkIdType i;
+  for (i=0; i < a->GetNumberOfPoints(); i++)
+    {
+    double xa[3], xb[3];
+    a->GetPoint(i, xa);
+    b->GetPoint(i, xb);
+    if (xa[0] != xb[0] || xa[1] != xb[1] || xa[2] != xb[2])
+      {
+      cerr << "Point " << i << " differs" << endl;
+      return 1;
+      }
+    }
+  vtkIdTypeArray *ca = a->GetPolys()->GetData();
+  vtkIdTypeArray *cb = b->GetPolys()->GetData();
+  if (ca->GetNumberOfTuples() != cb->GetNumberOfTuples())
+    {
+    cerr << "Connectivity sizes differ" << endl;
+    return 1;
+    }
+  for (i=0; i < ca->GetNumberOfTuples(); i++)
+    {
+    if (ca->GetValue(i) != cb->GetValue(i))
+      {
+      cerr << "Connectivity differs at " << i << endl;
+      return 1;
+      }
+    }
+  return CompareArrays(a->GetPointData(), b->GetPointData());
+}
+
+// The triangles still in use must all be referenced, and far enough from
+// the sphere radius.
+static int CheckSphere(vtkPolyData *output, double radius, double tolerance)
+{
+  vtkIdType npts, *pts;
+  vtkCellArray *polys = output->GetPolys();
+  for (polys->InitTraversal(); polys->GetNextCell(npts, pts); )
+    {
+    for (vtkIdType i=0; i < npts; i++)
+      {
+      double x[3];
+      output->GetPoint(pts[i], x);
+      if (fabs(vtkMath::Norm(x) - radius) > tolerance)
+        {
+        cerr << "Point " << pts[i] << " is off the sphere" << endl;
+        return 1;
+        }
+      }
+    }
+  return 0;
+}
+
+int TestQuadricDecimationParallel(int, char *[])
+{
+  int rval = 0;
+
+  // a sphere with normals and elevation scalars, and a flat square
+  vtkSphereSource *sphere = vtkSphereSource::New();
+  sphere->SetThetaResolution(200);
+  sphere->SetPhiResolution(150);
+  vtkElevationFilter *elevation = vtkElevationFilter::New();
+  elevation->SetInputConnection(sphere->GetOutputPort());
+  elevation->SetLowPoint(0.0, 0.0, -0.5);
+  elevation->SetHighPoint(0.0, 0.0, 0.5);
+  elevation->Update();
+  vtkPolyData *colored = vtkPolyData::SafeDownCast(elevation->GetOutput());
+  vtkPlaneSource *plane = vtkPlaneSource::New();
+  plane->SetResolution(150, 150);
+  vtkTriangleFilter *triangles = vtkTriangleFilter::New();
+  triangles->SetInputConnection(plane->GetOutputPort());
+  triangles->Update();
+
+  vtkQuadricDecimation *serial = vtkQuadricDecimation::New();
+  serial->ParallelCollapseOn();
+  serial->SetNumberOfThreads(1);
+  vtkQuadricDecimation *threaded = vtkQuadricDecimation::New();
+  threaded->ParallelCollapseOn();
+  threaded->SetNumberOfThreads(4);
+
+  for (int config=0; config < 3; config++)
+    {
+    vtkQuadricDecimation *filters[2] = {serial, threaded};
+    for (int f=0; f < 2; f++)
+      {
+      vtkQuadricDecimation *decimate = filters[f];
+      decimate->SetInput(config == 2 ? triangles->GetOutput() : colored);
+      decimate->SetAttributeErrorMetric(config == 1);
+      decimate->SetTargetReduction(config == 1 ? 0.7 : 0.9);
+      decimate->Update();
+      }
+    vtkPolyData *input = (config == 2 ? triangles->GetOutput() : colored);
+    vtkPolyData *output = threaded->GetOutput();
+    rval += CompareMeshes(serial->GetOutput(), output);
+
+    double reduction = 1.0 -
+      static_cast<double>(output->GetNumberOfPolys()) /
+      input->GetNumberOfPolys();
+    if (reduction < threaded->GetTargetReduction() ||
+        reduction > threaded->GetTargetReduction() + 0.01 ||
+        fabs(reduction - threaded->GetActualReduction()) > 1.0e-6)
+      {
+      cerr << "Reduction of " << reduction << " instead of "
+           << threaded->GetTargetReduction() << endl;
+      rval++;
+      }
+
+    if (config == 0)
+      {
+      rval += CheckSphere(output, 0.5, 0.005);
+      }
+    else if (config == 1)
+      {
+      // the attributes are interpolated along the surface
+      vtkDataArray *normals = output->GetPointData()->GetNormals();
+      vtkDataArray *scalars = output->GetPointData()->GetScalars();
+      if (!normals || !scalars)
+        {
+        cerr << "Attributes are missing" << endl;
+        rval++;
+        }
+      else
+        {
+        for (vtkIdType i=0; i < output->GetNumberOfPoints(); i++)
+          {
+          double x[3];
+          output->GetPoint(i, x);
+          if (fabs(vtkMath::Norm(normals->GetTuple3(i)) - 1.0) > 0.01 ||
+              fabs(scalars->GetComponent(i, 0) - (x[2] + 0.5)) > 0.05)
+            {
+            cerr << "Attributes of point " << i << " are wrong" << endl;
+            rval++;
+            break;
+            }
+          }
+        }
+      rval += CheckSphere(output, 0.5, 0.005);
+      }
+    else
+      {
+      // the boundary constraints keep the square
+      double inBounds[6], outBounds[6];
+      input->GetBounds(inBounds);
+      output->GetBounds(outBounds);
+      for (int i=0; i < 6; i++)
+        {
+        if (fabs(inBounds[i] - outBounds[i]) > 1.0e-6)
+          {
+          cerr << "The boundary has moved" << endl;
+          rval++;
+          break;
+          }
+        }
+      }
+    }
+
+  serial->Delete();
+  threaded->Delete();
+  triangles->Delete();
+  plane->Delete();
+  elevation->Delete();
+  sphere->Delete();
+  return rval;
+}
@@ -0,0 +1,308 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestSpatialReorderFilter.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Checks that vtkSpatialReorderFilter only renumbers points and cells,
+// that its result does not depend on the number of threads, and that
+// the Hilbert order of a lattice visits neighboring points.
+
+#include "vtkCellArray.h"
+#include "vtkCellData.h"
+#include "vtkCellType.h"
+#include "vtkExecutive.h"
+#include "vtkFloatArray.h"
+#include "vtkIdList.h"
+#include "vtkIdTypeArray.h"
+#include "vtkMath.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+#include "vtkSpatialReorderFilter.h"
+#include "vtkStructuredGrid.h"
+#include "vtkUnstructuredGrid.h"
+
+// A lattice of res^3 points in a shuffled order, with a vertex on every
+// point, a line and a quad on every cell of the z=0 layer, and point and
+// cell scalars equal to the original ids.
+static vtkPolyData *MakeShuffledLattice(int res)
+{
+  vtkPolyData *pd = vtkPolyData::New();
+  vtkPoints *pts = vtkPoints::New();
+  vtkIdType numPts = res * res * res;
+  pts->SetNumberOfPoints(numPts);
+  vtkIdType *order = new vtkIdType[numPts];
+  vtkIdType i;
+  for (i=0; i < numPts; i++)
+    {
+    order[i] = i;
+    }
+  vtkMath::RandomSeed(1234);
+  for (i=numPts-1; i > 0; i--)
+    {
+    vtkIdType j = static_cast<vtkIdType>(vtkMath::Random(0.0, i + 1.0));
+    j = (j > i) ? i : j;
+    vtkIdType tmp = order[i];
+    order[i] = order[j];
+    order[j] = tmp;
+    }
+  // point order[n] is at lattice position n
+  vtkIdType *ids = new vtkIdType[numPts];
+  for (i=0; i < numPts; i++)
+    {
+    int x = i % res;
+    int y = (i / res) % res;
+    int z = i / (res * res);
+    pts->SetPoint(order[i], x, y, z);
+    ids[order[i]] = i;
+    }
+
+  vtkCellArray *verts = vtkCellArray::New();
+  for (i=0; i < numPts; i++)
+    {
+    verts->InsertNextCell(1, &i);
+    }
+  vtkCellArray *lines = vtkCellArray::New();
+  vtkCellArray *polys = vtkCellArray::New();
+  for (int y=0; y < res-1; y++)
+    {
+    for (int x=0; x < res-1; x++)
+      {
+      vtkIdType quad[4];
+      quad[0] = order[x + res*y];
+      quad[1] = order[x + 1 + res*y];
+      quad[2] = order[x + 1 + res*(y + 1)];
+      quad[3] = order[x + res*(y + 1)];
+      polys->InsertNextCell(4, quad);
+      lines->InsertNextCell(2, quad);
+      }
+    }
+
+  pd->SetPoints(pts);
+  pd->SetVerts(verts);
+  pd->SetLines(lines);
+  pd->SetPolys(polys);
+
+  vtkFloatArray *pointScalars = vtkFloatArray::New();
+  pointScalars->SetName("PointIds");
+  vtkFloatArray *cellScalars = vtkFloatArray::New();
+  cellScalars->SetName("CellIds");
+  for (i=0; i < numPts; i++)
+    {
+    pointScalars->InsertNextValue(static_cast<float>(i));
+    }
+  for (i=0; i < pd->GetNumberOfCells(); i++)
+    {
+    cellScalars->InsertNextValue(static_cast<float>(i));
+    }
+  pd->GetPointData()->SetScalars(pointScalars);
+  pd->GetCellData()->SetScalars(cellScalars);
+
+  pts->Delete();
+  verts->Delete();
+  lines->Delete();
+  polys->Delete();
+  pointScalars->Delete();
+  cellScalars->Delete();
+  delete [] order;
+  delete [] ids;
+  return pd;
+}
+
+// Check that output cell i is input cell origCellIds[i] with its points
+// renumbered, and that the attributes followed.
+static int CheckReordered(vtkPointSet *input, vtkPointSet *output)
+{
+  vtkIdTypeArray *origPts = vtkIdTypeArray::SafeDownCast(
+    output->GetPointData()->GetArray("vtkOriginalPointIds"));
+  vtkIdTypeArray *origCells = vtkIdTypeArray::SafeDownCast(
+    output->GetCellData()->GetArray("vtkOriginalCellIds"));
+  if (!origPts || !origCells ||
+      output->GetNumberOfPoints() != input->GetNumberOfPoints() ||
+      output->GetNumberOfCells() != input->GetNumberOfCells())
+    {
+    cerr << "Missing original ids or wrong sizes" << endl;
+    return 1;
+    }
+  if (!output->GetPointData()->GetScalars() ||
+      !output->GetCellData()->GetScalars())
+    {
+    cerr << "Active scalars were not kept" << endl;
+    return 1;
+    }
+
+  vtkIdType i;
+  double x[3], y[3];
+  for (i=0; i < output->GetNumberOfPoints(); i++)
+    {
+    vtkIdType orig = origPts->GetValue(i);
+    output->GetPoint(i, x);
+    input->GetPoint(orig, y);
+    if (x[0] != y[0] || x[1] != y[1] || x[2] != y[2] ||
+        output->GetPointData()->GetScalars()->GetTuple1(i) != orig)
+      {
+      cerr << "Point " << i << " does not match input point " << orig
+           << endl;
+      return 1;
+      }
+    }
+
+  vtkIdList *outIds = vtkIdList::New();
+  vtkIdList *inIds = vtkIdList::New();
+  int rval = 0;
+  for (i=0; i < output->GetNumberOfCells() && !rval; i++)
+    {
+    vtkIdType orig = origCells->GetValue(i);
+    output->GetCellPoints(i, outIds);
+    input->GetCellPoints(orig, inIds);
+    if (output->GetCellType(i) != input->GetCellType(orig) ||
+        outIds->GetNumberOfIds() != inIds->GetNumberOfIds() ||
+        output->GetCellData()->GetScalars()->GetTuple1(i) != orig)
+      {
+      rval = 1;
+      }
+    for (vtkIdType j=0; j < outIds->GetNumberOfIds() && !rval; j++)
+      {
+      if (origPts->GetValue(outIds->GetId(j)) != inIds->GetId(j))
+        {
+        rval = 1;
+        }
+      }
+    if (rval)
+      {
+      cerr << "Cell " << i << " does not match input cell " << orig << endl;
+      }
+    }
+  outIds->Delete();
+  inIds->Delete();
+  return rval;
+}
+
+static int CompareIds(vtkDataSetAttributes *a, vtkDataSetAttributes *b,
+                      const char *name)
+{
+  vtkDataArray *ida = a->GetArray(name);
+  vtkDataArray *idb = b->GetArray(name);
+  for (vtkIdType i=0; i < ida->GetNumberOfTuples(); i++)
+    {
+    if (ida->GetTuple1(i) != idb->GetTuple1(i))
+      {
+      cerr << name << " depend on the number of threads" << endl;
+      return 1;
+      }
+    }
+  return 0;
+}
+
+int TestSpatialReorderFilter(int, char *[])
+{
+  int rval = 0;
+  const int res = 16;
+  vtkPolyData *input = MakeShuffledLattice(res);
+
+  vtkSpatialReorderFilter *reorder = vtkSpatialReorderFilter::New();
+  reorder->SetInput(input);
+  reorder->GenerateOriginalPointIdsOn();
+  reorder->GenerateOriginalCellIdsOn();
+
+  int curve;
+  for (curve = VTK_SPATIAL_REORDER_MORTON;
+       curve <= VTK_SPATIAL_REORDER_HILBERT; curve++)
+    {
+    reorder->SetCurveType(curve);
+    reorder->SetNumberOfThreads(1);
+    reorder->Update();
+    vtkPolyData *serial = vtkPolyData::New();
+    serial->DeepCopy(reorder->GetOutput());
+    rval += CheckReordered(input, serial);
+    if (serial->GetNumberOfVerts() != input->GetNumberOfVerts() ||
+        serial->GetNumberOfLines() != input->GetNumberOfLines() ||
+        serial->GetNumberOfPolys() != input->GetNumberOfPolys())
+      {
+      cerr << "Cell groups were not kept" << endl;
+      rval++;
+      }
+
+    reorder->SetNumberOfThreads(4);
+    reorder->Update();
+    rval += CheckReordered(input, reorder->GetOutput());
+    rval += CompareIds(serial->GetPointData(),
+                       reorder->GetOutput()->GetPointData(),
+                       "vtkOriginalPointIds");
+    rval += CompareIds(serial->GetCellData(),
+                       reorder->GetOutput()->GetCellData(),
+                       "vtkOriginalCellIds");
+    serial->Delete();
+    }
+
+  // On a power of two lattice consecutive points along the Hilbert curve
+  // are neighbors.
+  double x[3], y[3];
+  vtkPointSet *output = reorder->GetOutput();
+  for (vtkIdType i=1; i < output->GetNumberOfPoints(); i++)
+    {
+    output->GetPoint(i-1, x);
+    output->GetPoint(i, y);
+    if (vtkMath::Distance2BetweenPoints(x, y) != 1.0)
+      {
+      cerr << "Points " << i-1 << " and " << i
+           << " are not neighbors along the Hilbert curve" << endl;
+      rval++;
+      break;
+      }
+    }
+
+  // Unstructured grid with mixed cells
+  vtkUnstructuredGrid *grid = vtkUnstructuredGrid::New();
+  grid->SetPoints(input->GetPoints());
+  grid->GetPointData()->PassData(input->GetPointData());
+  grid->Allocate(input->GetNumberOfCells());
+  vtkIdList *cellIds = vtkIdList::New();
+  for (vtkIdType c = input->GetNumberOfCells() - 1; c >= 0; c--)
+    {
+    input->GetCellPoints(c, cellIds);
+    grid->InsertNextCell(input->GetCellType(c), cellIds);
+    }
+  cellIds->Delete();
+  grid->GetCellData()->PassData(input->GetCellData());
+
+  reorder->SetInput(grid);
+  reorder->Update();
+  rval += CheckReordered(grid, reorder->GetOutput());
+  if (reorder->GetOutput()->GetCellType(0) == VTK_EMPTY_CELL)
+    {
+    cerr << "Cell types were lost" << endl;
+    rval++;
+    }
+
+  grid->Delete();
+
+  // Other point sets are rejected by the pipeline.
+  vtkStructuredGrid *structured = vtkStructuredGrid::New();
+  structured->SetDimensions(res, res, res);
+  structured->SetPoints(input->GetPoints());
+  reorder->SetInput(structured);
+  int warnings = vtkObject::GetGlobalWarningDisplay();
+  vtkObject::GlobalWarningDisplayOff();
+  if (reorder->GetExecutive()->Update())
+    {
+    cerr << "A vtkStructuredGrid input was accepted" << endl;
+    rval++;
+    }
+  vtkObject::SetGlobalWarningDisplay(warnings);
+  structured->Delete();
+
+  reorder->Delete();
+  input->Delete();
+
+  return rval;
+}
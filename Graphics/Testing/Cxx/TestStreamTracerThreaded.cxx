@@ -0,0 +1,221 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestStreamTracerThreaded.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Checks that vtkStreamTracer generates the same streamlines whatever its
+// NumberOfThreads, with both kinds of velocity field interpolators.
+
+#include "vtkCellArray.h"
+#include "vtkCellData.h"
+#include "vtkCellLocator.h"
+#include "vtkCellLocatorInterpolatedVelocityField.h"
+#include "vtkDoubleArray.h"
+#include "vtkIdTypeArray.h"
+#include "vtkMath.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+#include "vtkStreamTracer.h"
+#include "vtkStructuredGrid.h"
+
+// A sheared res^3 grid holding a swirling velocity field and a scalar
+static vtkStructuredGrid *MakeGrid(int res)
+{
+  vtkStructuredGrid *grid = vtkStructuredGrid::New();
+  grid->SetDimensions(res, res, res);
+  vtkPoints *pts = vtkPoints::New();
+  vtkDoubleArray *vectors = vtkDoubleArray::New();
+  vectors->SetName("Velocity");
+  vectors->SetNumberOfComponents(3);
+  vtkDoubleArray *scalars = vtkDoubleArray::New();
+  scalars->SetName("Pressure");
+  double h = 2.0 / (res - 1);
+  for (int k=0; k < res; k++)
+    {
+    for (int j=0; j < res; j++)
+      {
+      for (int i=0; i < res; i++)
+        {
+        double x = -1.0 + i*h + 0.2*k*h;
+        double y = -1.0 + j*h;
+        double z = -1.0 + k*h;
+        pts->InsertNextPoint(x, y, z);
+        vectors->InsertNextTuple3(-y + 0.1*z, x, 0.3 + 0.2*x*y);
+        scalars->InsertNextValue(x*x + y*y - z);
+        }
+      }
+    }
+  grid->SetPoints(pts);
+  grid->GetPointData()->SetVectors(vectors);
+  grid->GetPointData()->SetScalars(scalars);
+  pts->Delete();
+  vectors->Delete();
+  scalars->Delete();
+  return grid;
+}
+
+// Random seeds, a few of them outside of the grid
+static vtkPolyData *MakeSeeds(int num)
+{
+  vtkPolyData *seeds = vtkPolyData::New();
+  vtkPoints *pts = vtkPoints::New();
+  vtkMath::RandomSeed(2468);
+  for (int i=0; i < num; i++)
+    {
+    pts->InsertNextPoint(vtkMath::Random(-0.9, 1.1),
+                         vtkMath::Random(-0.9, 1.1),
+                         vtkMath::Random(-0.9, 0.5));
+    }
+  seeds->SetPoints(pts);
+  pts->Delete();
+  return seeds;
+}
+
+static int CompareArrays(vtkFieldData *a, vtkFieldData *b)
+{
+  if (a->GetNumberOfArrays() != b->GetNumberOfArrays())
+    {
+    cerr << "Number of arrays differ" << endl;
+    return 1;
+    }
+  for (int i=0; i < a->GetNumberOfArrays(); i++)
+    {
+    vtkDataArray *da = a->GetArray(i);
+    vtkDataArray *db = b->GetArray(i);
+    if (!da || !db || strcmp(da->GetName(), db->GetName()) ||
+        da->GetNumberOfTuples() != db->GetNumberOfTuples() ||
+        da->GetNumberOfComponents() != db->GetNumberOfComponents())
+      {
+      cerr << "Array " << i << " differs" << endl;
+      return 1;
+      }
+    for (vtkIdType t=0; t < da->GetNumberOfTuples(); t++)
+      {
+      for (int c=0; c < da->GetNumberOfComponents(); c++)
+        {
+        if (da->GetComponent(t, c) != db->GetComponent(t, c))
+          {
+          cerr << "Array " << da->GetName() << " differs at tuple " << t
+               << endl;
+          return 1;
+          }
+        }
+      }
+    }
+  return 0;
+}
+
+static int CompareStreamlines(vtkPolyData *a, vtkPolyData *b)
+{
+  if (a->GetNumberOfPoints() != b->GetNumberOfPoints() ||
+      a->GetNumberOfLines() != b->GetNumberOfLines())
+    {
+    cerr << "Point or line counts differ: " << a->GetNumberOfPoints()
+         << " / " << b->GetNumberOfPoints() << " points, "
+         << a->GetNumberOfLines() << " / " << b->GetNumberOfLines()
+         << " lines" << endl;
+    return 1;
+    }
+  vtkIdType i;
+  for (i=0; i < a->GetNumberOfPoints(); i++)
+    {
+    double xa[3], xb[3];
+    a->GetPoint(i, xa);
+    b->GetPoint(i, xb);
+    if (xa[0] != xb[0] || xa[1] != xb[1] || xa[2] != xb[2])
+      {
+      cerr << "Point " << i << " differs" << endl;
+      return 1;
+      }
+    }
+  vtkIdTypeArray *ca = a->GetLines()->GetData();
+  vtkIdTypeArray *cb = b->GetLines()->GetData();
+  if (ca->GetNumberOfTuples() != cb->GetNumberOfTuples())
+    {
+    cerr << "Connectivity sizes differ" << endl;
+    return 1;
+    }
+  for (i=0; i < ca->GetNumberOfTuples(); i++)
+    {
+    if (ca->GetValue(i) != cb->GetValue(i))
+      {
+      cerr << "Connectivity differs at " << i << endl;
+      return 1;
+      }
+    }
+  return CompareArrays(a->GetPointData(), b->GetPointData()) +
+    CompareArrays(a->GetCellData(), b->GetCellData());
+}
+
+int TestStreamTracerThreaded(int, char *[])
+{
+  int rval = 0;
+  vtkStructuredGrid *grid = MakeGrid(24);
+  vtkPolyData *seeds = MakeSeeds(300);
+
+  vtkStreamTracer *serial = vtkStreamTracer::New();
+  serial->SetInput(grid);
+  serial->SetSource(seeds);
+  serial->SetNumberOfThreads(1);
+  vtkStreamTracer *threaded = vtkStreamTracer::New();
+  threaded->SetInput(grid);
+  threaded->SetSource(seeds);
+  threaded->SetNumberOfThreads(4);
+
+  // vtkModifiedBSPTree, the default cell locator, splits along random
+  // axes, so both tracers use a vtkCellLocator to search the same cells.
+  vtkCellLocatorInterpolatedVelocityField *cellLocatorField =
+    vtkCellLocatorInterpolatedVelocityField::New();
+  vtkCellLocator *locator = vtkCellLocator::New();
+  cellLocatorField->SetCellLocatorPrototype(locator);
+  locator->Delete();
+
+  for (int config=0; config < 3; config++)
+    {
+    vtkStreamTracer *tracers[2] = {serial, threaded};
+    for (int t=0; t < 2; t++)
+      {
+      vtkStreamTracer *tracer = tracers[t];
+      tracer->SetMaximumPropagation(config == 2 ? 2.0 : 5.0);
+      tracer->SetIntegrationDirection(config == 2 ?
+                                      vtkStreamTracer::BOTH :
+                                      vtkStreamTracer::FORWARD);
+      if (config == 1)
+        {
+        tracer->SetInterpolatorPrototype(cellLocatorField);
+        }
+      if (config == 2)
+        {
+        tracer->SetIntegratorTypeToRungeKutta45();
+        }
+      tracer->Update();
+      }
+
+    vtkPolyData *output = threaded->GetOutput();
+    rval += CompareStreamlines(serial->GetOutput(), output);
+    if (output->GetNumberOfLines() < 100 ||
+        !output->GetPointData()->GetArray("Normals") ||
+        !output->GetCellData()->GetArray("ReasonForTermination"))
+      {
+      cerr << "Streamlines or their arrays are missing" << endl;
+      rval++;
+      }
+    }
+
+  serial->Delete();
+  threaded->Delete();
+  cellLocatorField->Delete();
+  seeds->Delete();
+  grid->Delete();
+  return rval;
+}
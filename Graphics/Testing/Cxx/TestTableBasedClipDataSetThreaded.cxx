@@ -0,0 +1,335 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestTableBasedClipDataSetThreaded.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Checks that vtkTableBasedClipDataSet clips unstructured, structured and
+// rectilinear grids and image data the same way whatever its
+// NumberOfThreads.
+
+#include "vtkCellArray.h"
+#include "vtkCellData.h"
+#include "vtkCellType.h"
+#include "vtkDoubleArray.h"
+#include "vtkFloatArray.h"
+#include "vtkIdTypeArray.h"
+#include "vtkImageData.h"
+#include "vtkIntArray.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkRectilinearGrid.h"
+#include "vtkSphere.h"
+#include "vtkStructuredGrid.h"
+#include "vtkTableBasedClipDataSet.h"
+#include "vtkUnstructuredGrid.h"
+
+// Attach a point scalar and a cell array to a grid
+static void AddArrays(vtkDataSet *grid)
+{
+  vtkFloatArray *scalars = vtkFloatArray::New();
+  scalars->SetName("Distance");
+  for (vtkIdType i=0; i < grid->GetNumberOfPoints(); i++)
+    {
+    double x[3];
+    grid->GetPoint(i, x);
+    scalars->InsertNextValue(x[0]*x[0] + 0.5*x[1]*x[1] - x[2]);
+    }
+  grid->GetPointData()->SetScalars(scalars);
+  scalars->Delete();
+
+  vtkIntArray *ids = vtkIntArray::New();
+  ids->SetName("CellNumber");
+  for (vtkIdType i=0; i < grid->GetNumberOfCells(); i++)
+    {
+    ids->InsertNextValue(static_cast<int>(i));
+    }
+  grid->GetCellData()->AddArray(ids);
+  ids->Delete();
+}
+
+// A res^3 lattice of hexahedra, with some of them split into wedges or
+// tetrahedra and some quadrilateral faces added as polygons, which the
+// clip tables do not handle.
+static vtkUnstructuredGrid *MakeUnstructuredGrid(int res)
+{
+  vtkUnstructuredGrid *grid = vtkUnstructuredGrid::New();
+  vtkPoints *pts = vtkPoints::New();
+  int n = res + 1;
+  int i, j, k;
+  for (k=0; k < n; k++)
+    {
+    for (j=0; j < n; j++)
+      {
+      for (i=0; i < n; i++)
+        {
+        pts->InsertNextPoint(-1.0 + 2.0*i/res, -1.0 + 2.0*j/res,
+                             -1.0 + 2.0*k/res);
+        }
+      }
+    }
+  grid->SetPoints(pts);
+  pts->Delete();
+  grid->Allocate(res*res*res*2);
+  int cell = 0;
+  for (k=0; k < res; k++)
+    {
+    for (j=0; j < res; j++)
+      {
+      for (i=0; i < res; i++, cell++)
+        {
+        vtkIdType c[8];
+        c[0] = i + n*(j + n*k);
+        c[1] = c[0] + 1;
+        c[2] = c[0] + 1 + n;
+        c[3] = c[0] + n;
+        c[4] = c[0] + n*n;
+        c[5] = c[1] + n*n;
+        c[6] = c[2] + n*n;
+        c[7] = c[3] + n*n;
+        if (cell % 5 == 1)
+          {
+          vtkIdType w0[6] = {c[0], c[1], c[3], c[4], c[5], c[7]};
+          vtkIdType w1[6] = {c[1], c[2], c[3], c[5], c[6], c[7]};
+          grid->InsertNextCell(VTK_WEDGE, 6, w0);
+          grid->InsertNextCell(VTK_WEDGE, 6, w1);
+          }
+        else if (cell % 5 == 3)
+          {
+          vtkIdType t0[4] = {c[0], c[1], c[3], c[4]};
+          vtkIdType t1[4] = {c[1], c[2], c[3], c[6]};
+          grid->InsertNextCell(VTK_TETRA, 4, t0);
+          grid->InsertNextCell(VTK_TETRA, 4, t1);
+          }
+        else
+          {
+          grid->InsertNextCell(VTK_HEXAHEDRON, 8, c);
+          }
+        if (cell % 997 == 0)
+          {
+          grid->InsertNextCell(VTK_POLYGON, 4, c);
+          }
+        }
+      }
+    }
+  AddArrays(grid);
+  return grid;
+}
+
+// A sheared res^3 structured grid
+static vtkStructuredGrid *MakeStructuredGrid(int res)
+{
+  vtkStructuredGrid *grid = vtkStructuredGrid::New();
+  grid->SetDimensions(res + 1, res + 1, res + 1);
+  vtkPoints *pts = vtkPoints::New();
+  for (int k=0; k <= res; k++)
+    {
+    for (int j=0; j <= res; j++)
+      {
+      for (int i=0; i <= res; i++)
+        {
+        double z = -1.0 + 2.0*k/res;
+        pts->InsertNextPoint(-1.0 + 2.0*i/res + 0.2*z, -1.0 + 2.0*j/res, z);
+        }
+      }
+    }
+  grid->SetPoints(pts);
+  pts->Delete();
+  AddArrays(grid);
+  return grid;
+}
+
+// A res^3 rectilinear grid with uneven spacings
+static vtkRectilinearGrid *MakeRectilinearGrid(int res)
+{
+  vtkRectilinearGrid *grid = vtkRectilinearGrid::New();
+  grid->SetDimensions(res + 1, res + 1, res + 1);
+  vtkDoubleArray *coords[3];
+  for (int c=0; c < 3; c++)
+    {
+    coords[c] = vtkDoubleArray::New();
+    for (int i=0; i <= res; i++)
+      {
+      double t = -1.0 + 2.0*i/res;
+      coords[c]->InsertNextValue(t + 0.1*(c + 1)*t*t*t);
+      }
+    }
+  grid->SetXCoordinates(coords[0]);
+  grid->SetYCoordinates(coords[1]);
+  grid->SetZCoordinates(coords[2]);
+  for (int c=0; c < 3; c++)
+    {
+    coords[c]->Delete();
+    }
+  AddArrays(grid);
+  return grid;
+}
+
+static vtkImageData *MakeImage(int res)
+{
+  vtkImageData *image = vtkImageData::New();
+  image->SetDimensions(res + 1, res + 1, res + 1);
+  image->SetOrigin(-1.0, -1.0, -1.0);
+  image->SetSpacing(2.0/res, 2.0/res, 2.0/res);
+  AddArrays(image);
+  return image;
+}
+
+static int CompareArrays(vtkFieldData *a, vtkFieldData *b)
+{
+  if (a->GetNumberOfArrays() != b->GetNumberOfArrays())
+    {
+    cerr << "Number of arrays differ" << endl;
+    return 1;
+    }
+  for (int i=0; i < a->GetNumberOfArrays(); i++)
+    {
+    vtkDataArray *da = a->GetArray(i);
+    vtkDataArray *db = b->GetArray(i);
+    if (!da || !db || strcmp(da->GetName(), db->GetName()) ||
+        da->GetNumberOfTuples() != db->GetNumberOfTuples() ||
+        da->GetNumberOfComponents() != db->GetNumberOfComponents())
+      {
+      cerr << "Array " << i << " differs" << endl;
+      return 1;
+      }
+    for (vtkIdType t=0; t < da->GetNumberOfTuples(); t++)
+      {
+      for (int c=0; c < da->GetNumberOfComponents(); c++)
+        {
+        if (da->GetComponent(t, c) != db->GetComponent(t, c))
+          {
+          cerr << "Array " << da->GetName() << " differs at tuple " << t
+               << endl;
+          return 1;
+          }
+        }
+      }
+    }
+  return 0;
+}
+
+static int CompareClips(vtkUnstructuredGrid *a, vtkUnstructuredGrid *b)
+{
+  if (a->GetNumberOfPoints() != b->GetNumberOfPoints() ||
+      a->GetNumberOfCells() != b->GetNumberOfCells())
+    {
+    cerr << "Point or cell counts differ: " << a->GetNumberOfPoints()
+         << " / " << b->GetNumberOfPoints() << " points, "
+         << a->GetNumberOfCells() << " / " << b->GetNumberOfCells()
+         << " cells" << endl;
+    return 1;
+    }
+  vtkIdType i;
+  for (i=0; i < a->GetNumberOfPoints(); i++)
+    {
+    double xa[3], xb[3];
+    a->GetPoint(i, xa);
+    b->GetPoint(i, xb);
+    if (xa[0] != xb[0] || xa[1] != xb[1] || xa[2] != xb[2])
+      {
+      cerr << "Point " << i << " differs" << endl;
+      return 1;
+      }
+    }
+  vtkIdTypeArray *ca = a->GetCells()->GetData();
+  vtkIdTypeArray *cb = b->GetCells()->GetData();
+  if (ca->GetNumberOfTuples() != cb->GetNumberOfTuples())
+    {
+    cerr << "Connectivity sizes differ" << endl;
+    return 1;
+    }
+  for (i=0; i < ca->GetNumberOfTuples(); i++)
+    {
+    if (ca->GetValue(i) != cb->GetValue(i))
+      {
+      cerr << "Connectivity differs at " << i << endl;
+      return 1;
+      }
+    }
+  for (i=0; i < a->GetNumberOfCells(); i++)
+    {
+    if (a->GetCellType(i) != b->GetCellType(i))
+      {
+      cerr << "Type of cell " << i << " differs" << endl;
+      return 1;
+      }
+    }
+  return CompareArrays(a->GetPointData(), b->GetPointData()) +
+    CompareArrays(a->GetCellData(), b->GetCellData());
+}
+
+int TestTableBasedClipDataSetThreaded(int, char *[])
+{
+  int rval = 0;
+  const int res = 40;
+  vtkDataSet *grids[4];
+  grids[0] = MakeUnstructuredGrid(res);
+  grids[1] = MakeStructuredGrid(res);
+  grids[2] = MakeRectilinearGrid(res);
+  grids[3] = MakeImage(res);
+
+  vtkSphere *sphere = vtkSphere::New();
+  sphere->SetCenter(0.1, -0.2, 0.3);
+  sphere->SetRadius(0.8);
+
+  vtkTableBasedClipDataSet *serial = vtkTableBasedClipDataSet::New();
+  serial->SetNumberOfThreads(1);
+  vtkTableBasedClipDataSet *threaded = vtkTableBasedClipDataSet::New();
+  threaded->SetNumberOfThreads(4);
+
+  for (int g=0; g < 4; g++)
+    {
+    for (int config=0; config < 2; config++)
+      {
+      vtkTableBasedClipDataSet *clippers[2] = {serial, threaded};
+      for (int c=0; c < 2; c++)
+        {
+        vtkTableBasedClipDataSet *clipper = clippers[c];
+        clipper->SetInput(grids[g]);
+        if (config == 0)
+          {
+          // clip by the point scalars
+          clipper->SetClipFunction(NULL);
+          clipper->SetValue(0.1);
+          clipper->InsideOutOff();
+          clipper->GenerateClipScalarsOff();
+          }
+        else
+          {
+          clipper->SetClipFunction(sphere);
+          clipper->InsideOutOn();
+          clipper->GenerateClipScalarsOn();
+          }
+        clipper->Update();
+        }
+
+      vtkUnstructuredGrid *output = threaded->GetOutput();
+      rval += CompareClips(serial->GetOutput(), output);
+      if (output->GetNumberOfCells() < 1000 ||
+          !output->GetCellData()->GetArray("CellNumber"))
+        {
+        cerr << "Clipped cells or their arrays are missing for grid " << g
+             << endl;
+        rval++;
+        }
+      }
+    }
+
+  serial->Delete();
+  threaded->Delete();
+  sphere->Delete();
+  for (int g=0; g < 4; g++)
+    {
+    grids[g]->Delete();
+    }
+  return rval;
+}
@@ -0,0 +1,203 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestWindowedSincPolyDataFilterThreaded.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Checks that vtkWindowedSincPolyDataFilter smooths the same way whatever
+// its NumberOfThreads, that it smooths a noisy sphere back onto the sphere,
+// and that it smooths a mesh made only of lines.
+
+#include "vtkCellArray.h"
+#include "vtkMath.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+#include "vtkSphereSource.h"
+#include "vtkWindowedSincPolyDataFilter.h"
+
+#include <math.h>
+
+static int CompareArrays(vtkFieldData *a, vtkFieldData *b)
+{
+  if (a->GetNumberOfArrays() != b->GetNumberOfArrays())
+    {
+    cerr << "Number of arrays differ" << endl;
+    return 1;
+    }
+  for (int i=0; i < a->GetNumberOfArrays(); i++)
+    {
+    vtkDataArray *da = a->GetArray(i);
+    vtkDataArray *db = b->GetArray(i);
+    if (!da || !db || da->GetNumberOfTuples() != db->GetNumberOfTuples() ||
+        da->GetNumberOfComponents() != db->GetNumberOfComponents())
+      {
+      cerr << "Array " << i << " differs" << endl;
+      return 1;
+      }
+    for (vtkIdType t=0; t < da->GetNumberOfTuples(); t++)
+      {
+      for (int c=0; c < da->GetNumberOfComponents(); c++)
+        {
+        if (da->GetComponent(t, c) != db->GetComponent(t, c))
+          {
+          cerr << "Array " << i << " differs at tuple " << t << endl;
+          return 1;
+          }
+        }
+      }
+    }
+  return 0;
+}
+
+static int ComparePoints(vtkPolyData *a, vtkPolyData *b)
+{
+  if (a->GetNumberOfPoints() != b->GetNumberOfPoints())
+    {
+    cerr << "Point counts differ: " << a->GetNumberOfPoints() << " / "
+         << b->GetNumberOfPoints() << endl;
+    return 1;
+    }
+  for (vtkIdType i=0; i < a->GetNumberOfPoints(); i++)
+    {
+    double xa[3], xb[3];
+    a->GetPoint(i, xa);
+    b->GetPoint(i, xb);
+    if (xa[0] != xb[0] || xa[1] != xb[1] || xa[2] != xb[2])
+      {
+      cerr << "Point " << i << " differs" << endl;
+      return 1;
+      }
+    }
+  return CompareArrays(a->GetPointData(), b->GetPointData());
+}
+
+int TestWindowedSincPolyDataFilterThreaded(int, char *[])
+{
+  int rval = 0;
+
+  // a noisy sphere, with some lines across it and a few fixed vertices
+  vtkSphereSource *sphere = vtkSphereSource::New();
+  sphere->SetThetaResolution(300);
+  sphere->SetPhiResolution(150);
+  sphere->Update();
+  vtkPolyData *noisy = vtkPolyData::New();
+  noisy->DeepCopy(sphere->GetOutput());
+  vtkPoints *pts = noisy->GetPoints();
+  vtkIdType numPts = pts->GetNumberOfPoints();
+  vtkMath::RandomSeed(4321);
+  vtkIdType i;
+  for (i=0; i < numPts; i++)
+    {
+    double x[3];
+    pts->GetPoint(i, x);
+    for (int k=0; k < 3; k++)
+      {
+      x[k] += vtkMath::Random(-0.005, 0.005);
+      }
+    pts->SetPoint(i, x);
+    }
+  vtkCellArray *lines = vtkCellArray::New();
+  for (i=0; i < 10; i++)
+    {
+    lines->InsertNextCell(20);
+    for (vtkIdType j=0; j < 20; j++)
+      {
+      lines->InsertCellPoint((1000*i + 37*j) % numPts);
+      }
+    }
+  noisy->SetLines(lines);
+  lines->Delete();
+  vtkCellArray *verts = vtkCellArray::New();
+  verts->InsertNextCell(3);
+  verts->InsertCellPoint(10);
+  verts->InsertCellPoint(numPts/2);
+  verts->InsertCellPoint(numPts - 10);
+  noisy->SetVerts(verts);
+  verts->Delete();
+
+  vtkWindowedSincPolyDataFilter *serial = vtkWindowedSincPolyDataFilter::New();
+  serial->SetNumberOfThreads(1);
+  vtkWindowedSincPolyDataFilter *threaded =
+    vtkWindowedSincPolyDataFilter::New();
+  threaded->SetNumberOfThreads(4);
+
+  for (int config=0; config < 3; config++)
+    {
+    vtkWindowedSincPolyDataFilter *filters[2] = {serial, threaded};
+    for (int f=0; f < 2; f++)
+      {
+      vtkWindowedSincPolyDataFilter *smooth = filters[f];
+      smooth->SetInput(noisy);
+      smooth->SetNumberOfIterations(config == 2 ? 5 : 20);
+      smooth->SetFeatureEdgeSmoothing(config == 1);
+      smooth->SetNonManifoldSmoothing(config == 2);
+      smooth->SetNormalizeCoordinates(config == 2);
+      smooth->GenerateErrorScalarsOn();
+      smooth->SetGenerateErrorVectors(config != 0);
+      smooth->Update();
+      }
+    rval += ComparePoints(serial->GetOutput(), threaded->GetOutput());
+    }
+
+  // Smoothing the sphere without its lines brings the points back onto it.
+  threaded->SetInput(sphere->GetOutput());
+  threaded->SetNumberOfIterations(20);
+  threaded->NormalizeCoordinatesOn();
+  threaded->Update();
+  vtkPolyData *output = threaded->GetOutput();
+  for (i=0; i < output->GetNumberOfPoints(); i++)
+    {
+    double x[3];
+    output->GetPoint(i, x);
+    double r = sqrt(x[0]*x[0] + x[1]*x[1] + x[2]*x[2]);
+    if (fabs(r - 0.5) > 0.01)
+      {
+      cerr << "Point " << i << " is off the sphere" << endl;
+      rval++;
+      break;
+      }
+    }
+
+  // A zigzag polyline alone is smoothed too.
+  vtkPolyData *zigzag = vtkPolyData::New();
+  vtkPoints *zigzagPts = vtkPoints::New();
+  vtkCellArray *zigzagLine = vtkCellArray::New();
+  zigzagLine->InsertNextCell(101);
+  for (i=0; i <= 100; i++)
+    {
+    zigzagPts->InsertNextPoint(0.01*i, (i % 2) ? 0.002 : -0.002, 0.0);
+    zigzagLine->InsertCellPoint(i);
+    }
+  zigzag->SetPoints(zigzagPts);
+  zigzag->SetLines(zigzagLine);
+  zigzagPts->Delete();
+  zigzagLine->Delete();
+  serial->SetInput(zigzag);
+  serial->NormalizeCoordinatesOff();
+  serial->SetNumberOfIterations(20);
+  serial->SetEdgeAngle(60.0);
+  serial->Update();
+  double x[3];
+  serial->GetOutput()->GetPoint(50, x);
+  if (serial->GetOutput()->GetNumberOfPoints() != 101 || fabs(x[1]) > 0.001)
+    {
+    cerr << "The polyline is not smoothed" << endl;
+    rval++;
+    }
+
+  zigzag->Delete();
+  serial->Delete();
+  threaded->Delete();
+  noisy->Delete();
+  sphere->Delete();
+  return rval;
+}
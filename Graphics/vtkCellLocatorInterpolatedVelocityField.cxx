@@ -271,6 +271,36 @@ void vtkCellLocatorInterpolatedVelocityField::AddDataSet( vtkDataSet * dataset )
     }
 }
 
+//----------------------------------------------------------------------------
+void vtkCellLocatorInterpolatedVelocityField::ShareCellLocators
+  ( vtkCellLocatorInterpolatedVelocityField * from )
+{
+  if ( !from || from->CellLocators->size() != this->CellLocators->size() )
+    {
+    vtkErrorMacro( <<"Cell locators of a different set of datasets!" );
+    return;
+    }
+
+  int numDataSets = static_cast<int>( this->CellLocators->size() );
+  for ( int i = 0; i < numDataSets; i ++ )
+    {
+    vtkAbstractCellLocator * loc = ( *from->CellLocators )[i].GetPointer();
+    vtkDataSet * dataset = ( *this->DataSets )[i];
+    if ( loc && dataset->GetNumberOfPoints() > 0 )
+      {
+      // the locators are lazily evaluated, a query builds them
+      double x[3], pcoords[3];
+      dataset->GetPoint( 0, x );
+      loc->FindCell( x, 0.0, this->GenCell, pcoords, this->Weights );
+      }
+    ( *this->CellLocators )[i] = loc;
+    }
+
+  this->LastCellLocator = 0;
+  this->LastDataSet     = 0;
+  this->LastCellId      = -1;
+}
+
 //----------------------------------------------------------------------------
 void vtkCellLocatorInterpolatedVelocityField::CopyParameters
   ( vtkAbstractInterpolatedVelocityField * from )
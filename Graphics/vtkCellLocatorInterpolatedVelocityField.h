@@ -89,6 +89,13 @@ public:
   // DOES NOT CHANGE THE REFERENCE COUNT OF dataset FOR THREAD SAFETY REASONS.
   virtual void AddDataSet( vtkDataSet * dataset );
 
+  // Description:
+  // Use the cell locators of another instance, to which the same datasets
+  // were added in the same order, instead of building its own ones. The
+  // locators of from are built here, so that afterwards several instances,
+  // e.g., one per thread, can search them concurrently.
+  void ShareCellLocators( vtkCellLocatorInterpolatedVelocityField * from );
+
   // Description:
   // Evaluate the velocity field f at point (x, y, z).
   virtual int FunctionValues( double * x, double * f );
@@ -16,6 +16,8 @@
 
 #include "vtkCellArray.h"
 #include "vtkCellData.h"
+#include "vtkIdTypeArray.h"
+#include "vtkMergeCoincidentPoints.h"
 #include "vtkMergePoints.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
@@ -37,6 +39,7 @@ vtkCxxSetObjectMacro(vtkCleanPolyData,Locator,vtkIncrementalPointLocator);
 vtkCleanPolyData::vtkCleanPolyData()
 {
   this->PointMerging = 1;
+  this->ParallelPointMerging = 0;
   this->ToleranceIsAbsolute  = 0;
   this->Tolerance            = 0.0;
   this->AbsoluteTolerance    = 1.0;
@@ -186,9 +189,15 @@ int vtkCleanPolyData::RequestData(
   vtkPointData *inputPD = input->GetPointData();
   vtkCellData  *inputCD = input->GetCellData();
 
+  // When merging in bulk, the merged point ids are known before the
+  // topology is processed, so the cells are remapped through pointMap
+  // exactly as when merging is off.
+  int bulkMerging = this->PointMerging && this->ParallelPointMerging;
+  int usePointMap = !this->PointMerging || bulkMerging;
+
   // We must be careful to 'operate' on the bounds of the locator so
   // that all inserted points lie inside it
-  if ( this->PointMerging )
+  if ( this->PointMerging && !bulkMerging )
     {
     this->CreateDefaultLocator(input);
     if (this->ToleranceIsAbsolute) 
@@ -218,6 +227,11 @@ int vtkCleanPolyData::RequestData(
   outputPD->CopyAllocate(inputPD);
   outputCD->CopyAllocate(inputCD);
 
+  if ( bulkMerging )
+    {
+    numUsedPts = this->MergePointsInBulk(input, newPts, outputPD, pointMap);
+    }
+
   // Celldata needs to be copied correctly. If a poly is converted to
   // a line, or a line to a point, then using a CellCounter will not
   // do, as the cells should be ordered verts, lines, polys,
@@ -247,7 +261,7 @@ int vtkCleanPolyData::RequestData(
         {
         inPts->GetPoint(pts[i],x);
         this->OperateOnPoint(x, newx);
-        if ( ! this->PointMerging )
+        if ( usePointMap )
           {
           if ( (ptId=pointMap[pts[i]]) == -1 )
             {
@@ -292,7 +306,7 @@ int vtkCleanPolyData::RequestData(
         {
         inPts->GetPoint(pts[i],x);
         this->OperateOnPoint(x, newx);
-        if ( ! this->PointMerging )
+        if ( usePointMap )
           {
           if ( (ptId=pointMap[pts[i]]) == -1 )
             {
@@ -358,7 +372,7 @@ int vtkCleanPolyData::RequestData(
         {
         inPts->GetPoint(pts[i],x);
         this->OperateOnPoint(x, newx);
-        if ( ! this->PointMerging )
+        if ( usePointMap )
           {
           if ( (ptId=pointMap[pts[i]]) == -1 )
             {
@@ -444,7 +458,7 @@ int vtkCleanPolyData::RequestData(
         {
         inPts->GetPoint(pts[i],x);
         this->OperateOnPoint(x, newx);
-        if ( ! this->PointMerging )
+        if ( usePointMap )
           {
           if ( (ptId=pointMap[pts[i]]) == -1 )
             {
@@ -533,7 +547,7 @@ int vtkCleanPolyData::RequestData(
   // Update ourselves and release memory
   //
   delete [] updatedPts;
-  if ( this->PointMerging )
+  if ( !usePointMap )
     {
     this->Locator->Initialize(); //release memory.
     }
@@ -602,6 +616,92 @@ int vtkCleanPolyData::RequestData(
   return 1;
 }
 
+//--------------------------------------------------------------------------
+// Merge the points used by the cells in one pass.  The points are given
+// to vtkMergeCoincidentPoints in order of first use by the cells (verts,
+// lines, polys then strips), which is the order they would be inserted
+// into the locator, so the new point ids are the same.  Fills pointMap
+// and newPts, copies the point data to outputPD and returns the number
+// of new points.
+vtkIdType vtkCleanPolyData::MergePointsInBulk(vtkPolyData *input,
+                                              vtkPoints *newPts,
+                                              vtkPointData *outputPD,
+                                              vtkIdType *pointMap)
+{
+  vtkPoints *inPts = input->GetPoints();
+  vtkIdType numPts = input->GetNumberOfPoints();
+  vtkIdType numUsedPts = 0;
+  vtkIdType i, npts = 0;
+  vtkIdType *pts = 0;
+  vtkIdType *order = new vtkIdType [numPts];
+
+  vtkCellArray *cellArrays[4] = {input->GetVerts(), input->GetLines(),
+                                 input->GetPolys(), input->GetStrips()};
+  for (int type=0; type < 4; type++)
+    {
+    vtkCellArray *cells = cellArrays[type];
+    for (cells->InitTraversal(); cells->GetNextCell(npts,pts); )
+      {
+      for (i=0; i < npts; i++)
+        {
+        if ( pointMap[pts[i]] == -1 )
+          {
+          pointMap[pts[i]] = numUsedPts;
+          order[numUsedPts++] = pts[i];
+          }
+        }
+      }
+    }
+
+  // The points are merged after OperateOnPoint(), in the precision of the
+  // output points, just as they would be by the locator.
+  vtkPoints *usedPts = newPts->NewInstance();
+  usedPts->SetDataType(newPts->GetDataType());
+  usedPts->SetNumberOfPoints(numUsedPts);
+  double x[3], newx[3];
+  for (i=0; i < numUsedPts; i++)
+    {
+    inPts->GetPoint(order[i],x);
+    this->OperateOnPoint(x, newx);
+    usedPts->SetPoint(i,newx);
+    }
+
+  vtkMergeCoincidentPoints *merger = vtkMergeCoincidentPoints::New();
+  if (this->ToleranceIsAbsolute)
+    {
+    merger->SetTolerance(this->AbsoluteTolerance);
+    }
+  else
+    {
+    merger->SetTolerance(this->Tolerance*input->GetLength());
+    }
+  vtkIdTypeArray *mergeMap = vtkIdTypeArray::New();
+  vtkIdType numNewPts = merger->BuildMergeMap(usedPts, mergeMap);
+  merger->Delete();
+
+  vtkPointData *inputPD = input->GetPointData();
+  newPts->SetNumberOfPoints(numNewPts);
+  vtkIdType nextId = 0;
+  for (i=0; i < numUsedPts; i++)
+    {
+    vtkIdType newId = mergeMap->GetValue(i);
+    pointMap[order[i]] = newId;
+    if ( newId == nextId )
+      {
+      // first occurrence of this point
+      newPts->SetPoint(newId, usedPts->GetPoint(i));
+      outputPD->CopyData(inputPD, order[i], newId);
+      nextId++;
+      }
+    }
+
+  mergeMap->Delete();
+  usedPts->Delete();
+  delete [] order;
+
+  return numNewPts;
+}
+
 //--------------------------------------------------------------------------
 // Method manages creation of locators. It takes into account the potential
 // change of tolerance (zero to non-zero).
@@ -659,6 +759,8 @@ void vtkCleanPolyData::PrintSelf(ostream& os, vtkIndent indent)
 
   os << indent << "Point Merging: "
      << (this->PointMerging ? "On\n" : "Off\n");
+  os << indent << "Parallel Point Merging: "
+     << (this->ParallelPointMerging ? "On\n" : "Off\n");
   os << indent << "ToleranceIsAbsolute: "
      << (this->ToleranceIsAbsolute ? "On\n" : "Off\n");
   os << indent << "Tolerance: "
@@ -43,6 +43,11 @@
 // Note that merging of points can be disabled. In this case, a point locator
 // will not be used, and points that are not used by any cells will be
 // eliminated, but never merged.
+//
+// With ParallelPointMerging on, the points are merged in bulk with
+// vtkMergeCoincidentPoints instead of being inserted one at a time into
+// the locator.  For a zero tolerance the output is identical to the
+// locator path.
 
 // .SECTION Caveats
 // Merging points can alter topology, including introducing non-manifold
@@ -60,6 +65,8 @@
 #include "vtkPolyDataAlgorithm.h"
 
 class vtkIncrementalPointLocator;
+class vtkPointData;
+class vtkPoints;
 
 class VTK_GRAPHICS_EXPORT vtkCleanPolyData : public vtkPolyDataAlgorithm
 {
@@ -114,6 +121,19 @@ public:
   vtkGetMacro(PointMerging,int);
   vtkBooleanMacro(PointMerging,int);
 
+  // Description:
+  // Set/Get a boolean value that controls whether points are merged in
+  // bulk, with multiple threads, by vtkMergeCoincidentPoints rather than
+  // through the Locator.  The numbering of the output points is the same
+  // as with the locator.  With a zero tolerance the output is identical;
+  // with a non-zero tolerance a point is merged onto the closest
+  // previously used point within tolerance, which may differ from the
+  // point a locator finds first.  Any Locator set is ignored in this
+  // mode.  Default is off.
+  vtkSetMacro(ParallelPointMerging,int);
+  vtkGetMacro(ParallelPointMerging,int);
+  vtkBooleanMacro(ParallelPointMerging,int);
+
   // Description:
   // Set/Get a spatial locator for speeding the search process. By
   // default an instance of vtkMergePoints is used.
@@ -158,7 +178,12 @@ protected:
   virtual int RequestInformation(vtkInformation *, vtkInformationVector **, vtkInformationVector *);
   virtual int RequestUpdateExtent(vtkInformation *, vtkInformationVector **, vtkInformationVector *);
 
+  // Merge all used points at once when ParallelPointMerging is on.
+  vtkIdType MergePointsInBulk(vtkPolyData *input, vtkPoints *newPts,
+                              vtkPointData *outputPD, vtkIdType *pointMap);
+
   int   PointMerging;
+  int   ParallelPointMerging;
   double Tolerance;
   double AbsoluteTolerance;
   int ConvertLinesToPoints;
@@ -22,15 +22,177 @@
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkMath.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
 #include "vtkPointData.h"
 #include "vtkPoints.h"
+#include "vtkPolyData.h"
 #include "vtkUnstructuredGrid.h"
 #include "vtkIdTypeArray.h"
 
+#include <vtkstd/vector>
+
 vtkStandardNewMacro(vtkConnectivityFilter);
 
+// Minimum number of cells scanned by each thread
+#define VTK_CONNECTIVITY_MIN_CELLS_PER_THREAD 10000
+
+namespace
+{
+// The data shared by the threads labeling the regions
+struct vtkConnectivityFilterThreadStruct
+{
+  vtkDataSet *Input;
+  vtkDataArray *InScalars;
+  double ScalarRange[2];
+  vtkIdType NumberOfCells;
+  int NumberOfThreads;
+  vtkstd::vector<vtkIdList *> PointIds;
+  // the first point of each cell (-1 if none), and whether the cell
+  // connects its points (it has points and meets the scalar criterion)
+  vtkIdType *FirstPoints;
+  char *Connecting;
+  // the union-find forest of each thread, over a window of point ids
+  vtkstd::vector<vtkIdType> WindowBegin;
+  vtkstd::vector<vtkIdType> WindowEnd;
+  vtkstd::vector<vtkIdType *> Parents;
+};
+
+// Return the root of point ptId in a forest over the point ids starting at
+// offset, halving the path on the way. Parent ids are never greater than
+// their child ids, the root of a tree being its smallest point id.
+inline vtkIdType vtkConnectivityFilterFind(vtkIdType *parents,
+                                           vtkIdType offset, vtkIdType ptId)
+{
+  while (parents[ptId - offset] != ptId)
+    {
+    parents[ptId - offset] = parents[parents[ptId - offset] - offset];
+    ptId = parents[ptId - offset];
+    }
+  return ptId;
+}
+
+// Join the trees of two points under the smaller root.
+inline void vtkConnectivityFilterUnion(vtkIdType *parents, vtkIdType offset,
+                                       vtkIdType p1, vtkIdType p2)
+{
+  p1 = vtkConnectivityFilterFind(parents, offset, p1);
+  p2 = vtkConnectivityFilterFind(parents, offset, p2);
+  if (p1 < p2)
+    {
+    parents[p2 - offset] = p1;
+    }
+  else if (p2 < p1)
+    {
+    parents[p1 - offset] = p2;
+    }
+}
+
+// Scan a contiguous range of cells: keep their first point, check the
+// scalar criterion, and find the window of the point ids they connect.
+VTK_THREAD_RETURN_TYPE vtkConnectivityFilterScanCells(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkConnectivityFilterThreadStruct *ts =
+    static_cast<vtkConnectivityFilterThreadStruct *>(info->UserData);
+  int threadId = info->ThreadID;
+  vtkIdType begin = ts->NumberOfCells*threadId/ts->NumberOfThreads;
+  vtkIdType end = ts->NumberOfCells*(threadId + 1)/ts->NumberOfThreads;
+  vtkIdList *ptIds = ts->PointIds[threadId];
+  vtkIdType windowBegin = VTK_LARGE_ID, windowEnd = 0;
+
+  for (vtkIdType cellId=begin; cellId < end; cellId++)
+    {
+    ts->Input->GetCellPoints(cellId, ptIds);
+    vtkIdType npts = ptIds->GetNumberOfIds();
+    vtkIdType *pts = ptIds->GetPointer(0);
+    ts->FirstPoints[cellId] = (npts > 0 ? pts[0] : -1);
+
+    // same criterion as the wave propagation, on the float scalars
+    double range[2];
+    range[0] = VTK_DOUBLE_MAX; range[1] = -VTK_DOUBLE_MAX;
+    vtkIdType i;
+    if ( ts->InScalars )
+      {
+      for (i=0; i < npts; i++)
+        {
+        double s = static_cast<float>(ts->InScalars->GetComponent(pts[i], 0));
+        if ( s < range[0] )
+          {
+          range[0] = s;
+          }
+        if ( s > range[1] )
+          {
+          range[1] = s;
+          }
+        }
+      }
+    ts->Connecting[cellId] = ( npts > 0 && (!ts->InScalars ||
+                                            (range[1] >= ts->ScalarRange[0] &&
+                                             range[0] <= ts->ScalarRange[1])) );
+    if ( ts->Connecting[cellId] )
+      {
+      for (i=0; i < npts; i++)
+        {
+        if ( pts[i] < windowBegin )
+          {
+          windowBegin = pts[i];
+          }
+        if ( pts[i] >= windowEnd )
+          {
+          windowEnd = pts[i] + 1;
+          }
+        }
+      }
+    }
+  if ( windowBegin >= windowEnd )
+    {
+    windowBegin = windowEnd = 0;
+    }
+  ts->WindowBegin[threadId] = windowBegin;
+  ts->WindowEnd[threadId] = windowEnd;
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+// Join the points of each connecting cell of a contiguous range of cells in
+// the forest of the thread.
+VTK_THREAD_RETURN_TYPE vtkConnectivityFilterJoinPoints(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkConnectivityFilterThreadStruct *ts =
+    static_cast<vtkConnectivityFilterThreadStruct *>(info->UserData);
+  int threadId = info->ThreadID;
+  vtkIdType begin = ts->NumberOfCells*threadId/ts->NumberOfThreads;
+  vtkIdType end = ts->NumberOfCells*(threadId + 1)/ts->NumberOfThreads;
+  vtkIdList *ptIds = ts->PointIds[threadId];
+  vtkIdType *parents = ts->Parents[threadId];
+  vtkIdType offset = ts->WindowBegin[threadId];
+  vtkIdType i;
+
+  for (i=offset; i < ts->WindowEnd[threadId]; i++)
+    {
+    parents[i - offset] = i;
+    }
+  for (vtkIdType cellId=begin; cellId < end; cellId++)
+    {
+    if ( ts->Connecting[cellId] )
+      {
+      ts->Input->GetCellPoints(cellId, ptIds);
+      vtkIdType npts = ptIds->GetNumberOfIds();
+      vtkIdType *pts = ptIds->GetPointer(0);
+      for (i=1; i < npts; i++)
+        {
+        vtkConnectivityFilterUnion(parents, offset, pts[0], pts[i]);
+        }
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+}
+
 // Construct with default extraction mode to extract largest regions.
 vtkConnectivityFilter::vtkConnectivityFilter()
 {
@@ -55,6 +217,9 @@ vtkConnectivityFilter::vtkConnectivityFilter()
 
   this->NewScalars = 0;
   this->NewCellScalars = 0;
+
+  this->LabelRegionsOnly = 0;
+  this->NumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
 }
 
 vtkConnectivityFilter::~vtkConnectivityFilter()
@@ -84,8 +249,7 @@ int vtkConnectivityFilter::RequestData(
   vtkIdType numPts, numCells, cellId, newCellId, i, j, pt;
   vtkPoints *newPts;
   int id;
-  int maxCellsInRegion;
-  int largestRegionId = 0;
+  vtkIdType largestRegionId = 0;
   vtkPointData *pd=input->GetPointData(), *outputPD=output->GetPointData();
   vtkCellData *cd=input->GetCellData(), *outputCD=output->GetCellData();
   
@@ -99,7 +263,6 @@ int vtkConnectivityFilter::RequestData(
     vtkDebugMacro(<<"No data to connect!");
     return 1;
     }
-  output->Allocate(numCells,numCells);
 
   // See whether to consider scalar connectivity
   //
@@ -138,59 +301,45 @@ int vtkConnectivityFilter::RequestData(
   this->NewCellScalars->SetName("RegionId");
   this->NewCellScalars->SetNumberOfTuples(numCells);
 
-  newPts = vtkPoints::New();
-  newPts->Allocate(numPts);
-
-  // Traverse all cells marking those visited.  Each new search
-  // starts a new connected region. Connected region grows 
-  // using a connected wave propagation.
-  //
-  this->Wave = vtkIdList::New();
-  this->Wave->Allocate(numPts/4+1,numPts);
-  this->Wave2 = vtkIdList::New();
-  this->Wave2->Allocate(numPts/4+1,numPts);
-
   this->PointNumber = 0;
   this->RegionNumber = 0;
-  maxCellsInRegion = 0;
 
   this->CellIds = vtkIdList::New(); 
   this->CellIds->Allocate(8, VTK_CELL_SIZE);
   this->PointIds = vtkIdList::New(); 
   this->PointIds->Allocate(8, VTK_CELL_SIZE);
 
-  if ( this->ExtractionMode != VTK_EXTRACT_POINT_SEEDED_REGIONS && 
-  this->ExtractionMode != VTK_EXTRACT_CELL_SEEDED_REGIONS &&
-  this->ExtractionMode != VTK_EXTRACT_CLOSEST_POINT_REGION ) 
-    { //visit all cells marking with region number
-    for (cellId=0; cellId < numCells; cellId++)
-      {
-      if ( cellId && !(cellId % 5000) )
-        {
-        this->UpdateProgress (0.1 + 0.8*cellId/numCells);
-        }
+  int labelAllRegions = ( this->LabelRegionsOnly ||
+    (this->ExtractionMode != VTK_EXTRACT_POINT_SEEDED_REGIONS && 
+     this->ExtractionMode != VTK_EXTRACT_CELL_SEEDED_REGIONS &&
+     this->ExtractionMode != VTK_EXTRACT_CLOSEST_POINT_REGION) );
 
-      if ( this->Visited[cellId] < 0 ) 
-        {
-        this->NumCellsInRegion = 0;
-        this->Wave->InsertNextId(cellId);
-        this->TraverseAndMark (input);
+  if ( labelAllRegions )
+    { //label all cells and points with their region number
+    vtkIdType *pointRegions = new vtkIdType[numPts];
+    largestRegionId = this->LabelAllRegions(input, pointRegions);
 
-        if ( this->NumCellsInRegion > maxCellsInRegion )
-          {
-          maxCellsInRegion = this->NumCellsInRegion;
-          largestRegionId = this->RegionNumber;
-          }
-
-        this->RegionSizes->InsertValue(this->RegionNumber++,
-                                       this->NumCellsInRegion);
-        this->Wave->Reset();
-        this->Wave2->Reset();
+    // Points are kept in their input order: all of them when only
+    // labeling, else the points used by cells.
+    for ( i=0; i < numPts; i++ )
+      {
+      if ( this->LabelRegionsOnly || pointRegions[i] >= 0 )
+        {
+        this->PointMap[i] = this->PointNumber;
+        this->NewScalars->SetValue(this->PointNumber++, pointRegions[i]);
         }
       }
+    delete [] pointRegions;
     }
   else // regions have been seeded, everything considered in same region
     {
+    // Traverse the cells from the seeds with a connected wave propagation.
+    //
+    this->Wave = vtkIdList::New();
+    this->Wave->Allocate(numPts/4+1,numPts);
+    this->Wave2 = vtkIdList::New();
+    this->Wave2->Allocate(numPts/4+1,numPts);
+
     this->NumCellsInRegion = 0;
 
     if ( this->ExtractionMode == VTK_EXTRACT_POINT_SEEDED_REGIONS )
@@ -245,11 +394,35 @@ int vtkConnectivityFilter::RequestData(
     this->TraverseAndMark (input);
     this->RegionSizes->InsertValue(this->RegionNumber,this->NumCellsInRegion);
     this->UpdateProgress (0.9);
+
+    this->Wave->Delete();
+    this->Wave2->Delete();
     }
 
   vtkDebugMacro (<<"Extracted " << this->RegionNumber << " region(s)");
-  this->Wave->Delete();
-  this->Wave2->Delete();
+
+  // When only labeling an unstructured grid, the output shares its points
+  // and cells.
+  if ( this->LabelRegionsOnly && input->IsA("vtkUnstructuredGrid") )
+    {
+    output->CopyStructure(input);
+    outputPD->PassData(pd);
+    outputCD->PassData(cd);
+    int idx = outputPD->AddArray(this->NewScalars);
+    outputPD->SetActiveAttribute(idx, vtkDataSetAttributes::SCALARS);
+    idx = outputCD->AddArray(this->NewCellScalars);
+    outputCD->SetActiveAttribute(idx, vtkDataSetAttributes::SCALARS);
+    this->NewScalars->Delete();
+    this->NewCellScalars->Delete();
+    delete [] this->Visited;
+    delete [] this->PointMap;
+    this->PointIds->Delete();
+    this->CellIds->Delete();
+    return 1;
+    }
+  output->Allocate(numCells,numCells);
+  newPts = vtkPoints::New();
+  newPts->Allocate(numPts);
 
   // Now that points and cells have been marked, traverse these lists pulling
   // everything that has been visited.
@@ -268,7 +441,7 @@ int vtkConnectivityFilter::RequestData(
     }
 
   // if coloring regions; send down new scalar data
-  if ( this->ColorRegions )
+  if ( this->ColorRegions || this->LabelRegionsOnly )
     {
     int idx = outputPD->AddArray(this->NewScalars);
     outputPD->SetActiveAttribute(idx, vtkDataSetAttributes::SCALARS);
@@ -283,7 +456,8 @@ int vtkConnectivityFilter::RequestData(
 
   // Create output cells
   //
-  if ( this->ExtractionMode == VTK_EXTRACT_POINT_SEEDED_REGIONS ||
+  if ( this->LabelRegionsOnly ||
+  this->ExtractionMode == VTK_EXTRACT_POINT_SEEDED_REGIONS ||
   this->ExtractionMode == VTK_EXTRACT_CELL_SEEDED_REGIONS ||
   this->ExtractionMode == VTK_EXTRACT_CLOSEST_POINT_REGION ||
   this->ExtractionMode == VTK_EXTRACT_ALL_REGIONS)
@@ -414,6 +588,227 @@ int vtkConnectivityFilter::RequestData(
 }
 
 
+// Label the regions with a union-find over the points of the cells, which
+// gives the same regions as the wave propagation from each unvisited cell.
+// Cells meeting the scalar criterion join their points. A region is seeded
+// by the first cell of a tree of joined points, or by a cell failing the
+// criterion, which grabs the trees of its points not seeded yet.
+//
+vtkIdType vtkConnectivityFilter::LabelAllRegions(vtkDataSet *input,
+                                                 vtkIdType *pointRegions)
+{
+  vtkIdType numPts = input->GetNumberOfPoints();
+  vtkIdType numCells = input->GetNumberOfCells();
+  vtkIdType cellId, ptId, root, region, i;
+  vtkIdType npts, *pts;
+  int t;
+
+  // The cells are scanned by NumberOfThreads threads, each of them handling
+  // a range of cells. Only polygonal data and unstructured grids get the
+  // points of their cells without modifying themselves.
+  int numThreads = this->NumberOfThreads;
+  int maxThreads = vtkMultiThreader::GetGlobalMaximumNumberOfThreads();
+  if (maxThreads > 0 && numThreads > maxThreads)
+    {
+    numThreads = maxThreads;
+    }
+  if (numThreads > numCells / VTK_CONNECTIVITY_MIN_CELLS_PER_THREAD)
+    {
+    numThreads = static_cast<int>(
+      numCells / VTK_CONNECTIVITY_MIN_CELLS_PER_THREAD);
+    }
+  if (numThreads < 1 || (!input->IsA("vtkPolyData") &&
+                         !input->IsA("vtkUnstructuredGrid")))
+    {
+    numThreads = 1;
+    }
+  input->GetCellPoints(0, this->PointIds); //builds the cells of polydata
+
+  vtkstd::vector<vtkIdType> firstPoints(numCells);
+  vtkstd::vector<char> connecting(numCells);
+  vtkConnectivityFilterThreadStruct ts;
+  ts.Input = input;
+  ts.InScalars = this->InScalars;
+  ts.ScalarRange[0] = this->ScalarRange[0];
+  ts.ScalarRange[1] = this->ScalarRange[1];
+  ts.NumberOfCells = numCells;
+  ts.NumberOfThreads = numThreads;
+  ts.FirstPoints = &firstPoints[0];
+  ts.Connecting = &connecting[0];
+  ts.PointIds.resize(numThreads);
+  for (t=0; t < numThreads; t++)
+    {
+    ts.PointIds[t] = vtkIdList::New();
+    ts.PointIds[t]->Allocate(8, VTK_CELL_SIZE);
+    }
+  ts.WindowBegin.resize(numThreads);
+  ts.WindowEnd.resize(numThreads);
+  ts.Parents.resize(numThreads);
+
+  vtkMultiThreader *threader = vtkMultiThreader::New();
+  threader->SetNumberOfThreads(numThreads);
+  threader->SetSingleMethod(vtkConnectivityFilterScanCells, &ts);
+  threader->SingleMethodExecute();
+  this->UpdateProgress(0.3);
+
+  // Each thread joins the points in its own forest, over the window of the
+  // point ids of its cells. The forests are then merged into a forest over
+  // all the points. When the windows overlap too much (cells of a thread
+  // using far apart points), a single thread joins all the points.
+  vtkstd::vector<vtkIdType> parents(numPts);
+  vtkstd::vector<vtkstd::vector<vtkIdType> > forests;
+  vtkIdType windowSizes = 0;
+  for (t=0; t < numThreads; t++)
+    {
+    windowSizes += ts.WindowEnd[t] - ts.WindowBegin[t];
+    }
+  if ( numThreads > 1 && windowSizes <= 2*numPts )
+    {
+    forests.resize(numThreads);
+    for (t=0; t < numThreads; t++)
+      {
+      forests[t].resize(ts.WindowEnd[t] - ts.WindowBegin[t] + 1);
+      ts.Parents[t] = &forests[t][0];
+      }
+    }
+  else
+    {
+    numThreads = ts.NumberOfThreads = 1;
+    threader->SetNumberOfThreads(1);
+    ts.WindowBegin[0] = 0;
+    ts.WindowEnd[0] = numPts;
+    ts.Parents[0] = &parents[0];
+    }
+  threader->SetSingleMethod(vtkConnectivityFilterJoinPoints, &ts);
+  threader->SingleMethodExecute();
+  threader->Delete();
+  for (t=0; t < static_cast<int>(ts.PointIds.size()); t++)
+    {
+    ts.PointIds[t]->Delete();
+    }
+
+  if ( numThreads > 1 )
+    {
+    for (ptId=0; ptId < numPts; ptId++)
+      {
+      parents[ptId] = ptId;
+      }
+    for (t=0; t < numThreads; t++)
+      {
+      for (ptId=ts.WindowBegin[t]; ptId < ts.WindowEnd[t]; ptId++)
+        {
+        root = vtkConnectivityFilterFind(ts.Parents[t], ts.WindowBegin[t],
+                                         ptId);
+        if ( root != ptId )
+          {
+          vtkConnectivityFilterUnion(&parents[0], 0, ptId, root);
+          }
+        }
+      }
+    }
+  // parents are never greater than their children: point all of them to
+  // their root
+  for (ptId=0; ptId < numPts; ptId++)
+    {
+    parents[ptId] = parents[parents[ptId]];
+    }
+  this->UpdateProgress(0.6);
+
+  // The seed of a tree is its first connecting cell, unless a cell failing
+  // the scalar criterion uses one of its points before.
+  vtkstd::vector<vtkIdType> seeds(numPts, -1);
+  for (cellId=0; cellId < numCells; cellId++)
+    {
+    if ( connecting[cellId] && seeds[root=parents[firstPoints[cellId]]] < 0 )
+      {
+      seeds[root] = cellId;
+      }
+    }
+  if ( this->InScalars )
+    {
+    for (cellId=0; cellId < numCells; cellId++)
+      {
+      if ( !connecting[cellId] )
+        {
+        input->GetCellPoints(cellId, this->PointIds);
+        npts = this->PointIds->GetNumberOfIds();
+        pts = this->PointIds->GetPointer(0);
+        for (i=0; i < npts; i++)
+          {
+          if ( seeds[root=parents[pts[i]]] > cellId )
+            {
+            seeds[root] = cellId;
+            }
+          }
+        }
+      }
+    }
+
+  // Number the regions in the order of their seeds.
+  vtkstd::vector<vtkIdType> sizes;
+  for (cellId=0; cellId < numCells; cellId++)
+    {
+    vtkIdType seed = cellId;
+    if ( connecting[cellId] )
+      {
+      seed = seeds[parents[firstPoints[cellId]]];
+      }
+    if ( seed == cellId )
+      {
+      region = this->RegionNumber++;
+      sizes.push_back(0);
+      }
+    else
+      {
+      region = this->Visited[seed];
+      }
+    this->Visited[cellId] = region;
+    this->NewCellScalars->SetValue(cellId, region);
+    sizes[region]++;
+    }
+  this->UpdateProgress(0.8);
+
+  // The region of a point is the first region using it.
+  for (ptId=0; ptId < numPts; ptId++)
+    {
+    root = parents[ptId];
+    pointRegions[ptId] = (seeds[root] >= 0 ? this->Visited[seeds[root]] : -1);
+    }
+  if ( this->InScalars )
+    {
+    for (cellId=0; cellId < numCells; cellId++)
+      {
+      if ( !connecting[cellId] )
+        {
+        region = this->Visited[cellId];
+        input->GetCellPoints(cellId, this->PointIds);
+        npts = this->PointIds->GetNumberOfIds();
+        pts = this->PointIds->GetPointer(0);
+        for (i=0; i < npts; i++)
+          {
+          if ( pointRegions[pts[i]] < 0 || region < pointRegions[pts[i]] )
+            {
+            pointRegions[pts[i]] = region;
+            }
+          }
+        }
+      }
+    }
+
+  vtkIdType largestRegionId = 0;
+  for (region=0; region < this->RegionNumber; region++)
+    {
+    this->RegionSizes->InsertValue(region, sizes[region]);
+    if ( sizes[region] > sizes[largestRegionId] )
+      {
+      largestRegionId = region;
+      }
+    }
+  this->UpdateProgress(0.9);
+
+  return largestRegionId;
+}
+
 // Mark current cell as visited and assign region number.  Note:
 // traversal occurs across shared vertices.
 //
@@ -570,5 +965,9 @@ void vtkConnectivityFilter::PrintSelf(ostream& os, vtkIndent indent)
 
   double *range = this->GetScalarRange();
   os << indent << "Scalar Range: (" << range[0] << ", " << range[1] << ")\n";
+
+  os << indent << "Label Regions Only: "
+     << (this->LabelRegionsOnly ? "On\n" : "Off\n");
+  os << indent << "Number Of Threads: " << this->NumberOfThreads << "\n";
 }
 
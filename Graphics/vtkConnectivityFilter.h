@@ -40,6 +40,14 @@
 // connectivity will pull out all voxels "containing" the anatomical
 // structure. These voxels can then be contoured or processed by other
 // visualization filters.
+//
+// When all the regions are visited (largest, specified or all regions
+// extraction), the regions are labeled with a union-find over the cell
+// points instead of a wave propagation, by several threads for polygonal
+// and unstructured inputs (see NumberOfThreads). The region ids and sizes
+// are the same: regions are numbered in the order of their first cell. The
+// extracted points keep their input order. The LabelRegionsOnly mode only
+// adds the region ids to the input.
 
 // .SECTION See Also
 // vtkPolyDataConnectivityFilter
@@ -144,6 +152,24 @@ public:
   vtkGetMacro(ColorRegions,int);
   vtkBooleanMacro(ColorRegions,int);
 
+  // Description:
+  // Turn on/off labeling the regions without extracting them. When on, all
+  // the regions are labeled whatever the ExtractionMode, and the output is
+  // the input with "RegionId" point and cell arrays. Points used by no cell
+  // get the region id -1. The points and cells of an unstructured grid
+  // input are shared with the output rather than copied. Off by default.
+  vtkSetMacro(LabelRegionsOnly,int);
+  vtkGetMacro(LabelRegionsOnly,int);
+  vtkBooleanMacro(LabelRegionsOnly,int);
+
+  // Description:
+  // Set/Get the number of threads labeling the regions of polygonal and
+  // unstructured inputs. Small inputs use fewer threads. The regions do not
+  // depend on this number. The default is
+  // vtkMultiThreader::GetGlobalDefaultNumberOfThreads().
+  vtkSetClampMacro(NumberOfThreads,int,1,VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads,int);
+
 protected:
   vtkConnectivityFilter();
   ~vtkConnectivityFilter();
@@ -163,8 +189,18 @@ protected:
   int ScalarConnectivity;
   double ScalarRange[2];
 
+  int LabelRegionsOnly;
+  int NumberOfThreads;
+
   void TraverseAndMark(vtkDataSet *input);
 
+  // Description:
+  // Label all the regions of the input with a union-find over the points of
+  // the cells. Set the region of each cell and the region sizes, return the
+  // id of the largest region and the region of each point (the first region
+  // using it, -1 when no cell uses it) in pointRegions.
+  vtkIdType LabelAllRegions(vtkDataSet *input, vtkIdType *pointRegions);
+
 private:
   // used to support algorithm execution
   vtkFloatArray *CellScalars;
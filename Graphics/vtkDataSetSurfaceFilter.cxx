@@ -16,6 +16,7 @@
 
 #include "vtkCellArray.h"
 #include "vtkCellData.h"
+#include "vtkCellTypes.h"
 #include "vtkDoubleArray.h"
 #include "vtkGenericCell.h"
 #include "vtkHexahedron.h"
@@ -23,6 +24,7 @@
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkMergePoints.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
 #include "vtkPolyData.h"
@@ -40,14 +42,161 @@
 #include "vtkWedge.h"
 
 #include <vtkstd/algorithm>
+#include <vtkstd/vector>
 #include <vtksys/hash_map.hxx>
 
+// Below this many cells per thread the faces are hashed serially
+#define VTK_SURFACE_FILTER_MIN_CELLS_PER_THREAD 1024
+
 static int sizeofFastQuad(int numPts)
 {
   // account for size of ptArray
   return static_cast<int>(sizeof(vtkFastGeomQuad)+(numPts-4)*sizeof(vtkIdType));
 }
 
+//----------------------------------------------------------------------------
+// 2D cells are copied to the output rather than hashed.
+static int vtkDataSetSurfaceFilterIs2DCell(int cellType)
+{
+  return (cellType == VTK_PIXEL || cellType == VTK_QUAD ||
+          cellType == VTK_TRIANGLE || cellType == VTK_POLYGON ||
+          cellType == VTK_TRIANGLE_STRIP ||
+          cellType == VTK_QUADRATIC_TRIANGLE ||
+          cellType == VTK_BIQUADRATIC_TRIANGLE ||
+          cellType == VTK_QUADRATIC_QUAD ||
+          cellType == VTK_QUADRATIC_LINEAR_QUAD ||
+          cellType == VTK_BIQUADRATIC_QUAD);
+}
+
+//----------------------------------------------------------------------------
+// Reorder the points of a quad to get the smallest id in a.
+static void vtkDataSetSurfaceFilterOrderQuad(vtkIdType &a, vtkIdType &b,
+                                             vtkIdType &c, vtkIdType &d)
+{
+  vtkIdType tmp;
+  if (b < a && b < c && b < d)
+    {
+    tmp = a;
+    a = b;
+    b = c;
+    c = d;
+    d = tmp;
+    }
+  else if (c < a && c < b && c < d)
+    {
+    tmp = a;
+    a = c;
+    c = tmp;
+    tmp = b;
+    b = d;
+    d = tmp;
+    }
+  else if (d < a && d < b && d < c)
+    {
+    tmp = a;
+    a = d;
+    d = c;
+    c = b;
+    b = tmp;
+    }
+}
+
+//----------------------------------------------------------------------------
+// Reorder the points of a triangle to get the smallest id in a.
+// We can't put the second smallest in b because it might change the order
+// of the verticies in the final triangle.
+static void vtkDataSetSurfaceFilterOrderTri(vtkIdType &a, vtkIdType &b,
+                                            vtkIdType &c)
+{
+  vtkIdType tmp;
+  if (b < a && b < c)
+    {
+    tmp = a;
+    a = b;
+    b = c;
+    c = tmp;
+    }
+  else if (c < a && c < b)
+    {
+    tmp = a;
+    a = c;
+    c = b;
+    b = tmp;
+    }
+}
+
+//----------------------------------------------------------------------------
+// Copy the ids of a polygon into tab with the smallest id first.
+static void vtkDataSetSurfaceFilterOrderPolygon(const vtkIdType *ids,
+                                                int numPts, vtkIdType *tab)
+{
+  int offset = 0;
+  for (int i=1; i<numPts; i++)
+    {
+    if (ids[i] < ids[offset])
+      {
+      offset = i;
+      }
+    }
+  for (int i=0; i<numPts; i++)
+    {
+    tab[i] = ids[(offset+i)%numPts];
+    }
+}
+
+//----------------------------------------------------------------------------
+// Whether quad, found in the bin of pts[0], is the same face as pts in
+// either orientation.  Triangles and quads only need to compare the points
+// following and preceding pts[0].
+static int vtkDataSetSurfaceFilterMatchFace(vtkFastGeomQuad *quad,
+                                            const vtkIdType *pts, int numPts)
+{
+  if (numPts != quad->numPts)
+    {
+    return 0;
+    }
+  if (numPts == 3)
+    {
+    return (pts[1] == quad->ptArray[1] && pts[2] == quad->ptArray[2]) ||
+      (pts[1] == quad->ptArray[2] && pts[2] == quad->ptArray[1]);
+    }
+  if (numPts == 4)
+    {
+    // c should be independant of point order.
+    return pts[2] == quad->ptArray[2] &&
+      ((pts[1] == quad->ptArray[1] && pts[3] == quad->ptArray[3]) ||
+       (pts[1] == quad->ptArray[3] && pts[3] == quad->ptArray[1]));
+    }
+  int i;
+  if (pts[1] == quad->ptArray[1])
+    {
+    // if the first two points match loop through forwards
+    // checking all points
+    for (i = 2; i < numPts; i++)
+      {
+      if (pts[i] != quad->ptArray[i])
+        {
+        return 0;
+        }
+      }
+    return 1;
+    }
+  if (pts[numPts-1] == quad->ptArray[1])
+    {
+    // the first two points match with the opposite sense.
+    // loop though comparing the correct sense
+    for (i = 2; i < numPts; i++)
+      {
+      if (pts[numPts - i] != quad->ptArray[i])
+        {
+        return 0;
+        }
+      }
+    return 1;
+    }
+  return 0;
+}
+
 
 class vtkDataSetSurfaceFilter::vtkEdgeInterpolationMap
 {
@@ -111,6 +260,8 @@ vtkDataSetSurfaceFilter::vtkDataSetSurfaceFilter()
   this->OriginalPointIdsName = NULL;
 
   this->NonlinearSubdivisionLevel = 1;
+
+  this->NumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
 }
 
 //----------------------------------------------------------------------------
@@ -945,6 +1096,7 @@ void vtkDataSetSurfaceFilter::PrintSelf(ostream& os, vtkIndent indent)
 
   os << indent << "NonlinearSubdivisionLevel: "
      << this->NonlinearSubdivisionLevel << endl;
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << endl;
 }
 
 //========================================================================
@@ -1007,6 +1159,31 @@ int vtkDataSetSurfaceFilter::UnstructuredGridExecute(vtkDataSet *dataSetInput,
   this->NumberOfNewCells = 0;
   this->InitializeQuadHash(numPts);
 
+  // The faces of linear 3D cells can be hashed in parallel.  Nonlinear
+  // cells need the cell links and are processed serially.  The threads do
+  // not call the virtual Insert*InHash() methods, so subclasses, which may
+  // override them, are processed serially too (IsA() would match them).
+  vtkIdType numThreads = numCells / VTK_SURFACE_FILTER_MIN_CELLS_PER_THREAD;
+  numThreads = (numThreads > this->NumberOfThreads) ?
+    this->NumberOfThreads : numThreads;
+  if (strcmp(this->GetClassName(), "vtkDataSetSurfaceFilter") != 0)
+    {
+    numThreads = 1;
+    }
+  for (cellId=0; cellId < numCells && numThreads > 1; cellId++)
+    {
+    if (!vtkCellTypes::IsLinear(cellTypes[cellId]))
+      {
+      numThreads = 1;
+      }
+    }
+  int facesHashed = 0;
+  if (numThreads > 1)
+    {
+    this->InsertFacesInHashInParallel(input, static_cast<int>(numThreads));
+    facesHashed = 1;
+    }
+
   // Allocate
   //
   newPts = vtkPoints::New();
@@ -1114,6 +1291,10 @@ int vtkDataSetSurfaceFilter::UnstructuredGridExecute(vtkDataSet *dataSetInput,
       this->RecordOrigCellId(this->NumberOfNewCells, cellId);
       outputCD->CopyData(cd, cellId, this->NumberOfNewCells++);
       }
+    else if (facesHashed && !vtkDataSetSurfaceFilterIs2DCell(cellType))
+      {
+      // The faces were hashed by InsertFacesInHashInParallel.
+      }
     else if (cellType == VTK_HEXAHEDRON)
       {
       this->InsertQuadInHash(ids[0], ids[1], ids[5], ids[4], cellId);
@@ -1162,14 +1343,7 @@ int vtkDataSetSurfaceFilter::UnstructuredGridExecute(vtkDataSet *dataSetInput,
       this->InsertPolygonInHash (ids, 6, cellId);
       this->InsertPolygonInHash (&ids[6], 6, cellId);
       }
-    else if (cellType == VTK_PIXEL || cellType == VTK_QUAD ||
-             cellType == VTK_TRIANGLE || cellType == VTK_POLYGON ||
-             cellType == VTK_TRIANGLE_STRIP ||
-             cellType == VTK_QUADRATIC_TRIANGLE ||
-             cellType == VTK_BIQUADRATIC_TRIANGLE ||
-             cellType == VTK_QUADRATIC_QUAD ||
-             cellType == VTK_QUADRATIC_LINEAR_QUAD ||
-             cellType == VTK_BIQUADRATIC_QUAD )
+    else if (vtkDataSetSurfaceFilterIs2DCell(cellType))
       { // save 2D cells for second pass
       flag2D = 1;
       }
@@ -1599,35 +1773,11 @@ void vtkDataSetSurfaceFilter::InsertQuadInHash(vtkIdType a, vtkIdType b,
                                                vtkIdType c, vtkIdType d, 
                                                vtkIdType sourceId)
 {
-  vtkIdType tmp;
   vtkFastGeomQuad *quad, **end;
 
   // Reorder to get smallest id in a.
-  if (b < a && b < c && b < d)
-    {
-    tmp = a;
-    a = b;
-    b = c;
-    c = d;
-    d = tmp;
-    }
-  else if (c < a && c < b && c < d)
-    {
-    tmp = a;
-    a = c;
-    c = tmp;
-    tmp = b;
-    b = d;
-    d = tmp;
-    }
-  else if (d < a && d < b && d < c)
-    {
-    tmp = a;
-    a = d;
-    d = c;
-    c = b;
-    b = tmp;
-    }
+  vtkDataSetSurfaceFilterOrderQuad(a, b, c, d);
+  vtkIdType pts[4] = {a, b, c, d};
 
   // Look for existing quad in the hash;
   end = this->QuadHash + a;
@@ -1636,17 +1786,12 @@ void vtkDataSetSurfaceFilter::InsertQuadInHash(vtkIdType a, vtkIdType b,
     {
     end = &(quad->Next);
     // a has to match in this bin.
-    // c should be independant of point order.
-    if (quad->numPts == 4 && c == quad->ptArray[2])
-      { 
-      // Check boh orders for b and d.
-      if ((b == quad->ptArray[1] && d == quad->ptArray[3]) || (b == quad->ptArray[3] && d == quad->ptArray[1]))
-        {
-        // We have a match.
-        quad->SourceId = -1;
-        // That is all we need to do.  Hide any quad shared by two or more cells.
-        return;
-        }
+    if (vtkDataSetSurfaceFilterMatchFace(quad, pts, 4))
+      {
+      // We have a match.
+      quad->SourceId = -1;
+      // That is all we need to do.  Hide any quad shared by two or more cells.
+      return;
       }
     quad = *end;
     }
@@ -1667,26 +1812,11 @@ void vtkDataSetSurfaceFilter::InsertTriInHash(vtkIdType a, vtkIdType b,
                                               vtkIdType c, vtkIdType sourceId,
                                               vtkIdType vtkNotUsed(faceId)/*= -1*/)
 {
-  vtkIdType tmp;
   vtkFastGeomQuad *quad, **end;
 
   // Reorder to get smallest id in a.
-  if (b < a && b < c)
-    {
-    tmp = a;
-    a = b;
-    b = c;
-    c = tmp;
-    }
-  else if (c < a && c < b)
-    {
-    tmp = a;
-    a = c;
-    c = b;
-    b = tmp;
-    }
-  // We can't put the second smnallest in b because it might change the order
-  // of the verticies in the final triangle.
+  vtkDataSetSurfaceFilterOrderTri(a, b, c);
+  vtkIdType pts[3] = {a, b, c};
 
   // Look for existing tri in the hash;
   end = this->QuadHash + a;
@@ -1695,15 +1825,12 @@ void vtkDataSetSurfaceFilter::InsertTriInHash(vtkIdType a, vtkIdType b,
     {
     end = &(quad->Next);
     // a has to match in this bin.
-    if (quad->numPts == 3)
-      { 
-      if ((b == quad->ptArray[1] && c == quad->ptArray[2]) || (b == quad->ptArray[2] && c == quad->ptArray[1]))
-        {
-        // We have a match.
-        quad->SourceId = -1;
-        // That is all we need to do. Hide any tri shared by two or more cells.
-        return;
-        }
+    if (vtkDataSetSurfaceFilterMatchFace(quad, pts, 3))
+      {
+      // We have a match.
+      quad->SourceId = -1;
+      // That is all we need to do. Hide any tri shared by two or more cells.
+      return;
       }
     quad = *end;
     }
@@ -1729,22 +1856,11 @@ void vtkDataSetSurfaceFilter::InsertPolygonInHash(vtkIdType* ids,
 {
   vtkFastGeomQuad *quad, **end;
 
-  // find the index to the smallest id
-  vtkIdType offset = 0;
-  for(int i=1; i<numPts; i++)
-    {
-    if(ids[i] < ids[offset])
-      {
-      offset = i;
-      }
-    }
-
-  // copy ids into ordered array with smallest id first
-  vtkIdType* tab = new vtkIdType[numPts];
-  for(int i=0; i<numPts; i++)
-    {
-    tab[i] = ids[(offset+i)%numPts];
-    }
+  // copy ids into ordered array with smallest id first; the usual small
+  // polygons do not need an allocation.
+  vtkIdType tabBuffer[16];
+  vtkIdType* tab = (numPts <= 16) ? tabBuffer : new vtkIdType[numPts];
+  vtkDataSetSurfaceFilterOrderPolygon(ids, numPts, tab);
   
   // Look for existing hex in the hash;
   end = this->QuadHash + tab[0];
@@ -1753,68 +1869,351 @@ void vtkDataSetSurfaceFilter::InsertPolygonInHash(vtkIdType* ids,
     {
     end = &(quad->Next);
     // a has to match in this bin.
-    // first just check the polygon size.
-    bool match = true;
-    if (numPts == quad->numPts)
+    if (vtkDataSetSurfaceFilterMatchFace(quad, tab, numPts))
+      {
+      // We have a match.
+      quad->SourceId = -1;
+      // That is all we need to do. Hide any tri shared by two or more cells.
+      if (tab != tabBuffer)
+        {
+        delete [] tab;
+        }
+      return;
+      }
+    quad = *end;
+    }
+  
+  // Create a new quad and add it to the hash.
+  quad = this->NewFastGeomQuad(numPts);
+  // mark the structure as a polygon
+  quad->Next = NULL;
+  quad->SourceId = sourceId;
+  for (int i = 0; i < numPts; i++)
+    {
+      quad->ptArray[i] = tab[i];
+    }
+  *end = quad;
+
+  if (tab != tabBuffer)
+    {
+    delete [] tab;
+    }
+}
+
+//----------------------------------------------------------------------------
+// Faces are hashed in two passes.  First each thread computes the faces of
+// its share of the cells and sorts them by the thread owning their
+// smallest point id, into flat lists of (sourceId, numPts, pts...)
+// records.  Then each thread inserts the faces it owns in its bins of the
+// hash, taking the lists in cell order so that every bin is the same as
+// with serial insertion.  The faces of a thread are allocated in chunks of
+// its share of the serial chunk size, so that shared faces cost no memory.
+namespace
+{
+typedef vtkstd::vector<vtkIdType> vtkSurfaceFaceList;
+
+struct vtkSurfaceFaceThreadStruct
+{
+  vtkUnstructuredGrid *Input;
+  vtkIdType NumberOfCells;
+  vtkIdType NumberOfPoints;
+  int NumberOfThreads;
+  // Faces[t*NumberOfThreads + p] holds the faces of the cells of thread t
+  // whose smallest point id belongs to thread p.
+  vtkstd::vector<vtkSurfaceFaceList> Faces;
+  vtkFastGeomQuad **QuadHash;
+  size_t ChunkLength;
+  // Pools[p] holds the chunks of the faces hashed by thread p.
+  vtkstd::vector<vtkstd::vector<unsigned char *> > Pools;
+};
+
+// Append faces, in the same order as the serial Insert*InHash methods.
+class vtkSurfaceFaceSink
+{
+public:
+  vtkSurfaceFaceSink(vtkSurfaceFaceThreadStruct *str, int threadId)
+    {
+    this->Lists = &str->Faces[threadId * str->NumberOfThreads];
+    this->NumberOfThreads = str->NumberOfThreads;
+    this->NumberOfPoints = str->NumberOfPoints;
+    }
+  void AddQuad(vtkIdType a, vtkIdType b, vtkIdType c, vtkIdType d,
+               vtkIdType sourceId)
+    {
+    vtkDataSetSurfaceFilterOrderQuad(a, b, c, d);
+    vtkSurfaceFaceList &list = this->GetList(a, sourceId, 4);
+    list.push_back(a);
+    list.push_back(b);
+    list.push_back(c);
+    list.push_back(d);
+    }
+  void AddTri(vtkIdType a, vtkIdType b, vtkIdType c, vtkIdType sourceId)
+    {
+    vtkDataSetSurfaceFilterOrderTri(a, b, c);
+    vtkSurfaceFaceList &list = this->GetList(a, sourceId, 3);
+    list.push_back(a);
+    list.push_back(b);
+    list.push_back(c);
+    }
+  void AddPolygon(const vtkIdType *ids, int numPts, vtkIdType sourceId)
+    {
+    vtkIdType smallest = ids[0];
+    for (int i=1; i < numPts; i++)
+      {
+      smallest = (ids[i] < smallest) ? ids[i] : smallest;
+      }
+    vtkSurfaceFaceList &list = this->GetList(smallest, sourceId, numPts);
+    size_t size = list.size();
+    list.resize(size + numPts);
+    vtkDataSetSurfaceFilterOrderPolygon(ids, numPts, &list[size]);
+    }
+
+protected:
+  vtkSurfaceFaceList &GetList(vtkIdType smallest, vtkIdType sourceId,
+                              int numPts)
+    {
+    vtkSurfaceFaceList &list = this->Lists[
+      smallest * this->NumberOfThreads / this->NumberOfPoints];
+    list.push_back(sourceId);
+    list.push_back(numPts);
+    return list;
+    }
+
+  vtkSurfaceFaceList *Lists;
+  int NumberOfThreads;
+  vtkIdType NumberOfPoints;
+};
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkSurfaceComputeFaces(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkSurfaceFaceThreadStruct *str =
+    static_cast<vtkSurfaceFaceThreadStruct *>(info->UserData);
+
+  vtkIdType begin = str->NumberOfCells * info->ThreadID / info->NumberOfThreads;
+  vtkIdType end =
+    str->NumberOfCells * (info->ThreadID + 1) / info->NumberOfThreads;
+  vtkUnstructuredGrid *input = str->Input;
+  vtkIdType *connectivity = input->GetCells()->GetPointer();
+  vtkIdType *locations = input->GetCellLocationsArray()->GetPointer(0);
+  unsigned char *cellTypes = input->GetCellTypesArray()->GetPointer(0);
+  vtkGenericCell *cell = vtkGenericCell::New();
+  vtkSurfaceFaceSink sink(str, info->ThreadID);
+
+  for (vtkIdType cellId = begin; cellId < end; cellId++)
+    {
+    int cellType = cellTypes[cellId];
+    vtkIdType *ids = connectivity + locations[cellId] + 1;
+    if (cellType == VTK_VERTEX || cellType == VTK_POLY_VERTEX ||
+        cellType == VTK_LINE || cellType == VTK_POLY_LINE ||
+        vtkDataSetSurfaceFilterIs2DCell(cellType))
+      {
+      // Copied to the output by UnstructuredGridExecute.
+      }
+    else if (cellType == VTK_HEXAHEDRON)
+      {
+      sink.AddQuad(ids[0], ids[1], ids[5], ids[4], cellId);
+      sink.AddQuad(ids[0], ids[3], ids[2], ids[1], cellId);
+      sink.AddQuad(ids[0], ids[4], ids[7], ids[3], cellId);
+      sink.AddQuad(ids[1], ids[2], ids[6], ids[5], cellId);
+      sink.AddQuad(ids[2], ids[3], ids[7], ids[6], cellId);
+      sink.AddQuad(ids[4], ids[5], ids[6], ids[7], cellId);
+      }
+    else if (cellType == VTK_VOXEL)
+      {
+      sink.AddQuad(ids[0], ids[1], ids[5], ids[4], cellId);
+      sink.AddQuad(ids[0], ids[2], ids[3], ids[1], cellId);
+      sink.AddQuad(ids[0], ids[4], ids[6], ids[2], cellId);
+      sink.AddQuad(ids[1], ids[3], ids[7], ids[5], cellId);
+      sink.AddQuad(ids[2], ids[6], ids[7], ids[3], cellId);
+      sink.AddQuad(ids[4], ids[5], ids[7], ids[6], cellId);
+      }
+    else if (cellType == VTK_TETRA)
       {
-      if ( tab[1] == quad->ptArray[1])
+      sink.AddTri(ids[0], ids[1], ids[3], cellId);
+      sink.AddTri(ids[0], ids[2], ids[1], cellId);
+      sink.AddTri(ids[0], ids[3], ids[2], cellId);
+      sink.AddTri(ids[1], ids[2], ids[3], cellId);
+      }
+    else if (cellType == VTK_PENTAGONAL_PRISM)
+      {
+      sink.AddQuad(ids[0], ids[1], ids[6], ids[5], cellId);
+      sink.AddQuad(ids[1], ids[2], ids[7], ids[6], cellId);
+      sink.AddQuad(ids[2], ids[3], ids[8], ids[7], cellId);
+      sink.AddQuad(ids[3], ids[4], ids[9], ids[8], cellId);
+      sink.AddQuad(ids[4], ids[0], ids[5], ids[9], cellId);
+      sink.AddPolygon(ids, 5, cellId);
+      sink.AddPolygon(&ids[5], 5, cellId);
+      }
+    else if (cellType == VTK_HEXAGONAL_PRISM)
+      {
+      sink.AddQuad(ids[0], ids[1], ids[7], ids[6], cellId);
+      sink.AddQuad(ids[1], ids[2], ids[8], ids[7], cellId);
+      sink.AddQuad(ids[2], ids[3], ids[9], ids[8], cellId);
+      sink.AddQuad(ids[3], ids[4], ids[10], ids[9], cellId);
+      sink.AddQuad(ids[4], ids[5], ids[11], ids[10], cellId);
+      sink.AddQuad(ids[5], ids[0], ids[6], ids[11], cellId);
+      sink.AddPolygon(ids, 6, cellId);
+      sink.AddPolygon(&ids[6], 6, cellId);
+      }
+    else
+      {
+      input->GetCell(cellId, cell);
+      if (cell->GetCellDimension() == 3)
         {
-        // if the first two points match loop through forwards
-        // checking all points
-        for (int i = 2; i < numPts; i++)
+        int numFaces = cell->GetNumberOfFaces();
+        for (int j=0; j < numFaces; j++)
           {
-          if ( tab[i] != quad->ptArray[i])
+          vtkCell *face = cell->GetFace(j);
+          vtkIdType *facePts = face->PointIds->GetPointer(0);
+          int numFacePts = static_cast<int>(face->PointIds->GetNumberOfIds());
+          if (numFacePts == 4)
+            {
+            sink.AddQuad(facePts[0], facePts[1], facePts[2], facePts[3],
+                         cellId);
+            }
+          else if (numFacePts == 3)
+            {
+            sink.AddTri(facePts[0], facePts[1], facePts[2], cellId);
+            }
+          else
             {
-            match = false;
-            break;
+            sink.AddPolygon(facePts, numFacePts, cellId);
             }
           }
         }
-      else if (tab[numPts-1] == quad->ptArray[1])
+      }
+    }
+
+  cell->Delete();
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkSurfaceHashFaces(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkSurfaceFaceThreadStruct *str =
+    static_cast<vtkSurfaceFaceThreadStruct *>(info->UserData);
+  int numThreads = str->NumberOfThreads;
+  vtkstd::vector<unsigned char *> &chunks = str->Pools[info->ThreadID];
+  unsigned char *pool = NULL;
+  size_t poolLeft = 0;
+
+  for (int t = 0; t < numThreads; t++)
+    {
+    vtkSurfaceFaceList &list = str->Faces[t*numThreads + info->ThreadID];
+    for (size_t r = 0; r < list.size(); r += 2 + list[r+1])
+      {
+      vtkIdType sourceId = list[r];
+      int numPts = static_cast<int>(list[r+1]);
+      const vtkIdType *pts = &list[r+2];
+
+      vtkFastGeomQuad **end = str->QuadHash + pts[0];
+      vtkFastGeomQuad *quad = *end;
+      while (quad)
         {
-        // the first two points match with the opposite sense.
-        // loop though comparing the correct sense
-        for (int i = 2; i < numPts; i++)
+        end = &(quad->Next);
+        if (vtkDataSetSurfaceFilterMatchFace(quad, pts, numPts))
           {
-          if ( tab[numPts - i] != quad->ptArray[i])
-            {
-            match = false;
-            break;
-            }
+          // Hide any face shared by two or more cells.
+          quad->SourceId = -1;
+          break;
           }
+        quad = *end;
         }
-      else
+      if (!quad)
         {
-        match = false;
+        size_t quadSize = sizeofFastQuad(numPts);
+        if (quadSize > poolLeft)
+          {
+          poolLeft = (quadSize > str->ChunkLength ? quadSize :
+                      str->ChunkLength);
+          pool = new unsigned char[poolLeft];
+          chunks.push_back(pool);
+          }
+        quad = reinterpret_cast<vtkFastGeomQuad *>(pool);
+        pool += quadSize;
+        poolLeft -= quadSize;
+        quad->Next = NULL;
+        quad->SourceId = sourceId;
+        quad->numPts = numPts;
+        for (int i = 0; i < numPts; i++)
+          {
+          quad->ptArray[i] = pts[i];
+          }
+        *end = quad;
         }
       }
-    else
+    // Release the list as soon as possible.
+    vtkSurfaceFaceList().swap(list);
+    }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+}
+
+//----------------------------------------------------------------------------
+// This must be called right after InitializeQuadHash(), before any face was
+// allocated.
+void vtkDataSetSurfaceFilter::InsertFacesInHashInParallel(
+  vtkUnstructuredGrid *input, int numThreads)
+{
+  vtkSurfaceFaceThreadStruct str;
+  str.Input = input;
+  str.NumberOfCells = input->GetNumberOfCells();
+  str.NumberOfPoints = input->GetNumberOfPoints();
+  str.NumberOfThreads = numThreads;
+  str.Faces.resize(numThreads * numThreads);
+  str.QuadHash = this->QuadHash;
+  str.ChunkLength = static_cast<size_t>(
+    this->FastGeomQuadArrayLength / numThreads);
+  if (str.ChunkLength < static_cast<size_t>(50 * sizeofFastQuad(4)))
+    {
+    str.ChunkLength = 50 * sizeofFastQuad(4);
+    }
+  str.Pools.resize(numThreads);
+
+  vtkMultiThreader *threader = vtkMultiThreader::New();
+  threader->SetNumberOfThreads(numThreads);
+  threader->SetSingleMethod(vtkSurfaceComputeFaces, &str);
+  threader->SingleMethodExecute();
+  threader->SetSingleMethod(vtkSurfaceHashFaces, &str);
+  threader->SingleMethodExecute();
+  threader->Delete();
+
+  // Hand the chunks over to the face allocator, which frees them in
+  // DeleteAllFastGeomQuads().  Any later face goes to a new array.
+  int numChunks = 0;
+  int t;
+  for (t = 0; t < numThreads; t++)
+    {
+    numChunks += static_cast<int>(str.Pools[t].size());
+    }
+  if (numChunks >= this->NumberOfFastGeomQuadArrays)
+    {
+    unsigned char **arrays = new unsigned char*[numChunks + 1];
+    for (int idx = 0; idx <= numChunks; ++idx)
       {
-      match = false;
+      arrays[idx] = NULL;
       }
-
-      if (match)
-        {
-        // We have a match.
-        quad->SourceId = -1;
-        // That is all we need to do. Hide any tri shared by two or more cells.
-        return;
-        }
-    quad = *end;
+    delete [] this->FastGeomQuadArrays;
+    this->FastGeomQuadArrays = arrays;
+    this->NumberOfFastGeomQuadArrays = numChunks + 1;
     }
-  
-  // Create a new quad and add it to the hash.
-  quad = this->NewFastGeomQuad(numPts);
-  // mark the structure as a polygon
-  quad->Next = NULL;
-  quad->SourceId = sourceId;
-  for (int i = 0; i < numPts; i++)
+  int chunk = 0;
+  for (t = 0; t < numThreads; t++)
     {
-      quad->ptArray[i] = tab[i];
+    for (size_t i = 0; i < str.Pools[t].size(); i++)
+      {
+      this->FastGeomQuadArrays[chunk++] = str.Pools[t][i];
+      }
     }
-  *end = quad;
-
-  delete [] tab;
+  this->NextArrayIndex = numChunks - 1;
+  this->NextQuadIndex = this->FastGeomQuadArrayLength;
 }
 
 //----------------------------------------------------------------------------
@@ -18,6 +18,20 @@
 // does not have an option to select bounds.  It may use more memory than
 // vtkGeometryFilter.  It only has one option: whether to use triangle strips 
 // when the input type is structured.
+//
+// For unstructured grids made of linear cells, the faces of the 3D cells
+// are hashed by NumberOfThreads threads.  Each thread owns the faces whose
+// smallest point id falls in its share of the point ids, so the faces, their
+// order and the original cell ids are the same as with a single thread.
+// The faces of all the cells are listed before they are hashed, so the
+// threaded hashing needs up to about two and a half times the memory of the
+// serial one; set NumberOfThreads to 1 when memory matters more than time.
+
+// .SECTION Caveats
+// The threaded face hashing does not go through InsertQuadInHash(),
+// InsertTriInHash() or InsertPolygonInHash(), so it is only used by
+// vtkDataSetSurfaceFilter itself: subclasses, which may override these
+// methods, always hash their faces serially whatever NumberOfThreads is.
 
 // .SECTION See Also
 // vtkGeometryFilter vtkStructuredGridGeometryFilter.
@@ -31,6 +45,7 @@
 class vtkPointData;
 class vtkPoints;
 class vtkIdTypeArray;
+class vtkUnstructuredGrid;
 
 //BTX
 // Helper structure for hashing faces.
@@ -109,6 +124,13 @@ public:
   vtkSetMacro(NonlinearSubdivisionLevel, int);
   vtkGetMacro(NonlinearSubdivisionLevel, int);
 
+  // Description:
+  // Number of threads used to hash the faces of unstructured grids.  The
+  // default is vtkMultiThreader::GetGlobalDefaultNumberOfThreads().
+  // Subclasses ignore it and use one thread (see the caveats).
+  vtkSetClampMacro(NumberOfThreads,int,1,VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads,int);
+
   // Description:
   // Direct access methods that can be used to use the this class as an
   // algorithm without using it as a filter.
@@ -160,6 +182,12 @@ protected:
                        vtkIdType sourceId, vtkIdType faceId = -1);
   virtual void InsertPolygonInHash(vtkIdType* ids, int numpts,
                            vtkIdType sourceId);
+
+  // Description:
+  // Hash the faces of all the 3D cells of the input with numThreads
+  // threads.  Only valid when all the cells of the input are linear.
+  void InsertFacesInHashInParallel(vtkUnstructuredGrid *input,
+                                   int numThreads);
   void InitQuadHashTraversal();
   vtkFastGeomQuad *GetNextVisibleQuadFromHash();
 
@@ -209,6 +237,8 @@ protected:
 
   int NonlinearSubdivisionLevel;
 
+  int NumberOfThreads;
+
 private:
   vtkDataSetSurfaceFilter(const vtkDataSetSurfaceFilter&);  // Not implemented.
   void operator=(const vtkDataSetSurfaceFilter&);  // Not implemented.
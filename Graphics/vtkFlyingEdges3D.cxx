@@ -0,0 +1,763 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    vtkFlyingEdges3D.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "vtkFlyingEdges3D.h"
+
+#include "vtkCellArray.h"
+#include "vtkFloatArray.h"
+#include "vtkIdTypeArray.h"
+#include "vtkImageData.h"
+#include "vtkInformation.h"
+#include "vtkInformationVector.h"
+#include "vtkMarchingCubesCases.h"
+#include "vtkMath.h"
+#include "vtkMultiThreader.h"
+#include "vtkObjectFactory.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+
+#include <vtkstd/vector>
+
+vtkStandardNewMacro(vtkFlyingEdges3D);
+
+// Minimum number of rows of x-edges processed by each thread
+#define VTK_FLYING_EDGES_3D_MIN_ROWS_PER_THREAD 64
+
+namespace
+{
+// The data shared by the threads contouring one value. Row j + k*ny holds
+// the x-edges between the points (i,j,k) and (i+1,j,k).
+struct vtkFlyingEdges3DThreadStruct
+{
+  void *Scalars;
+  int ScalarType;
+  vtkIdType Increments[3];
+  int Dimensions[3];
+  double Origin[3]; // of the first point of the extent
+  double Spacing[3];
+  double Value;
+  int NumberOfThreads;
+  vtkIdType NumberOfRows;
+  vtkMarchingCubesTriangleCases *Cases;
+  int NumberOfTriangles[256];
+  // The case of each x-edge: bit 0 is set when its first point is above the
+  // value, bit 1 when its second point is.
+  unsigned char *EdgeCases;
+  // For each row, the numbers of x-, y- and z-edges cut, the number of
+  // triangles of the row of voxels starting there, then the ids of its
+  // first point and first triangle.
+  vtkIdType *RowCounts;
+  // For each row, the first x-edge cut and the one after the last cut (nx-1
+  // and 0 when none is cut).
+  int *RowTrims;
+  float *Points;
+  float *Normals;
+  float *Gradients;
+  float *NewScalars;
+  vtkIdType *Polys;
+};
+
+// Whether point i of a row is above the value
+inline int vtkFlyingEdges3DState(const unsigned char *edgeCases, int i, int nx)
+{
+  return (i < nx-1 ? (edgeCases[i] & 1) : (edgeCases[nx-2] >> 1));
+}
+
+// The marching cubes case of a voxel from the cases of its four x-edges
+inline int vtkFlyingEdges3DVoxelCase(unsigned char ec0, unsigned char ec1,
+                                     unsigned char ec2, unsigned char ec3)
+{
+  return (ec0 & 3) | ((ec1 & 2) << 1) | ((ec1 & 1) << 3) |
+    ((ec2 & 3) << 4) | ((ec3 & 2) << 5) | ((ec3 & 1) << 7);
+}
+
+// Find the span [lo,hi] of point indices of some rows out of which every
+// row keeps the state of its first (before lo) or last (after hi) point.
+// When these states differ between the rows, the edges joining the rows are
+// cut out of the span too, which is then extended to the end of the rows.
+void vtkFlyingEdges3DTrim(vtkFlyingEdges3DThreadStruct *ts,
+                          const vtkIdType *rows, int numRows,
+                          int &lo, int &hi)
+{
+  int nx = ts->Dimensions[0];
+  const unsigned char *ec0 = ts->EdgeCases + rows[0]*(nx-1);
+  int firstDiffer = 0, lastDiffer = 0;
+  lo = nx - 1;
+  hi = 0;
+  for (int r=0; r < numRows; r++)
+    {
+    const int *trim = ts->RowTrims + 2*rows[r];
+    const unsigned char *ec = ts->EdgeCases + rows[r]*(nx-1);
+    if ( trim[0] < lo )
+      {
+      lo = trim[0];
+      }
+    if ( trim[1] > hi )
+      {
+      hi = trim[1];
+      }
+    if ( (ec[0] & 1) != (ec0[0] & 1) )
+      {
+      firstDiffer = 1;
+      }
+    if ( (ec[nx-2] >> 1) != (ec0[nx-2] >> 1) )
+      {
+      lastDiffer = 1;
+      }
+    }
+  if ( firstDiffer )
+    {
+    lo = 0;
+    }
+  if ( lastDiffer )
+    {
+    hi = nx - 1;
+    }
+}
+
+// Classify the x-edges of a contiguous range of rows.
+template <class T>
+void vtkFlyingEdges3DClassify(vtkFlyingEdges3DThreadStruct *ts, T *scalars,
+                              vtkIdType begin, vtkIdType end)
+{
+  int nx = ts->Dimensions[0];
+  int ny = ts->Dimensions[1];
+  double value = ts->Value;
+
+  for (vtkIdType row=begin; row < end; row++)
+    {
+    int j = static_cast<int>(row % ny);
+    int k = static_cast<int>(row / ny);
+    T *s = scalars + j*ts->Increments[1] + k*ts->Increments[2];
+    unsigned char *ec = ts->EdgeCases + row*(nx-1);
+    vtkIdType numCuts = 0;
+    int xL = nx - 1, xR = 0;
+    unsigned char above = (static_cast<double>(*s) >= value ? 1 : 0);
+    for (int i=0; i < nx-1; i++)
+      {
+      s += ts->Increments[0];
+      unsigned char next = (static_cast<double>(*s) >= value ? 1 : 0);
+      ec[i] = above | (next << 1);
+      if ( above != next )
+        {
+        if ( !numCuts )
+          {
+          xL = i;
+          }
+        xR = i + 1;
+        numCuts++;
+        }
+      above = next;
+      }
+    ts->RowCounts[6*row] = numCuts;
+    ts->RowTrims[2*row] = xL;
+    ts->RowTrims[2*row+1] = xR;
+    }
+}
+
+VTK_THREAD_RETURN_TYPE vtkFlyingEdges3DClassifyRows(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkFlyingEdges3DThreadStruct *ts =
+    static_cast<vtkFlyingEdges3DThreadStruct *>(info->UserData);
+  int threadId = info->ThreadID;
+  vtkIdType begin = ts->NumberOfRows*threadId/ts->NumberOfThreads;
+  vtkIdType end = ts->NumberOfRows*(threadId + 1)/ts->NumberOfThreads;
+
+  switch (ts->ScalarType)
+    {
+    vtkTemplateMacro(
+      vtkFlyingEdges3DClassify(ts, static_cast<VTK_TT *>(ts->Scalars),
+                               begin, end));
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+// Count the y- and z-edges cut along a contiguous range of rows, and the
+// triangles of the rows of voxels starting there.
+VTK_THREAD_RETURN_TYPE vtkFlyingEdges3DCountRows(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkFlyingEdges3DThreadStruct *ts =
+    static_cast<vtkFlyingEdges3DThreadStruct *>(info->UserData);
+  int threadId = info->ThreadID;
+  vtkIdType begin = ts->NumberOfRows*threadId/ts->NumberOfThreads;
+  vtkIdType end = ts->NumberOfRows*(threadId + 1)/ts->NumberOfThreads;
+  int nx = ts->Dimensions[0];
+  int ny = ts->Dimensions[1];
+  int nz = ts->Dimensions[2];
+  vtkIdType rows[4];
+  int lo, hi, i;
+
+  for (vtkIdType row=begin; row < end; row++)
+    {
+    int j = static_cast<int>(row % ny);
+    int k = static_cast<int>(row / ny);
+    vtkIdType *counts = ts->RowCounts + 6*row;
+    const unsigned char *ec0 = ts->EdgeCases + row*(nx-1);
+    const unsigned char *ec1 = ec0 + (nx-1);
+    const unsigned char *ec2 = ec0 + ny*(nx-1);
+    const unsigned char *ec3 = ec2 + (nx-1);
+    counts[1] = counts[2] = counts[3] = 0;
+
+    rows[0] = row;
+    if ( j < ny-1 )
+      {
+      rows[1] = row + 1;
+      vtkFlyingEdges3DTrim(ts, rows, 2, lo, hi);
+      for (i=lo; i <= hi; i++)
+        {
+        if ( vtkFlyingEdges3DState(ec0, i, nx) !=
+             vtkFlyingEdges3DState(ec1, i, nx) )
+          {
+          counts[1]++;
+          }
+        }
+      }
+    if ( k < nz-1 )
+      {
+      rows[1] = row + ny;
+      vtkFlyingEdges3DTrim(ts, rows, 2, lo, hi);
+      for (i=lo; i <= hi; i++)
+        {
+        if ( vtkFlyingEdges3DState(ec0, i, nx) !=
+             vtkFlyingEdges3DState(ec2, i, nx) )
+          {
+          counts[2]++;
+          }
+        }
+      }
+    if ( j < ny-1 && k < nz-1 )
+      {
+      rows[1] = row + 1;
+      rows[2] = row + ny;
+      rows[3] = row + ny + 1;
+      vtkFlyingEdges3DTrim(ts, rows, 4, lo, hi);
+      for (i=lo; i < hi; i++)
+        {
+        counts[3] += ts->NumberOfTriangles[
+          vtkFlyingEdges3DVoxelCase(ec0[i], ec1[i], ec2[i], ec3[i])];
+        }
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+// Calculate the gradient at a point using central differences, one-sided
+// on the boundary of the volume.
+template <class T>
+void vtkFlyingEdges3DGradient(vtkFlyingEdges3DThreadStruct *ts, T *s,
+                              const int ijk[3], double g[3])
+{
+  for (int a=0; a < 3; a++)
+    {
+    vtkIdType inc = ts->Increments[a];
+    if ( ijk[a] == 0 )
+      {
+      g[a] = (static_cast<double>(s[inc]) - static_cast<double>(s[0])) /
+        ts->Spacing[a];
+      }
+    else if ( ijk[a] == ts->Dimensions[a]-1 )
+      {
+      g[a] = (static_cast<double>(s[0]) - static_cast<double>(s[-inc])) /
+        ts->Spacing[a];
+      }
+    else
+      {
+      g[a] = 0.5 * (static_cast<double>(s[inc]) -
+                    static_cast<double>(s[-inc])) / ts->Spacing[a];
+      }
+    }
+}
+
+// Write the point cutting the edge from point (i,j,k) along an axis, with
+// its attributes.
+template <class T>
+void vtkFlyingEdges3DInterpolate(vtkFlyingEdges3DThreadStruct *ts,
+                                 T *rowScalars, int i, int j, int k,
+                                 int axis, vtkIdType ptId)
+{
+  T *s0 = rowScalars + i*ts->Increments[0];
+  T *s1 = s0 + ts->Increments[axis];
+  double v0 = static_cast<double>(*s0);
+  double t = (ts->Value - v0) / (static_cast<double>(*s1) - v0);
+  int ijk[3];
+  ijk[0] = i; ijk[1] = j; ijk[2] = k;
+  double x[3];
+  for (int a=0; a < 3; a++)
+    {
+    x[a] = ts->Origin[a] + ts->Spacing[a]*ijk[a];
+    }
+  x[axis] += t*ts->Spacing[axis];
+  float *p = ts->Points + 3*ptId;
+  p[0] = static_cast<float>(x[0]);
+  p[1] = static_cast<float>(x[1]);
+  p[2] = static_cast<float>(x[2]);
+
+  if ( ts->Normals || ts->Gradients )
+    {
+    double g0[3], g1[3], n[3];
+    vtkFlyingEdges3DGradient(ts, s0, ijk, g0);
+    ijk[axis]++;
+    vtkFlyingEdges3DGradient(ts, s1, ijk, g1);
+    n[0] = g0[0] + t * (g1[0] - g0[0]);
+    n[1] = g0[1] + t * (g1[1] - g0[1]);
+    n[2] = g0[2] + t * (g1[2] - g0[2]);
+    if ( ts->Gradients )
+      {
+      float *g = ts->Gradients + 3*ptId;
+      g[0] = static_cast<float>(n[0]);
+      g[1] = static_cast<float>(n[1]);
+      g[2] = static_cast<float>(n[2]);
+      }
+    if ( ts->Normals )
+      {
+      vtkMath::Normalize(n);
+      float *nn = ts->Normals + 3*ptId;
+      nn[0] = static_cast<float>(-n[0]);
+      nn[1] = static_cast<float>(-n[1]);
+      nn[2] = static_cast<float>(-n[2]);
+      }
+    }
+  if ( ts->NewScalars )
+    {
+    ts->NewScalars[ptId] = static_cast<float>(ts->Value);
+    }
+}
+
+// Write the points of the edges cut along a contiguous range of rows, and
+// the triangles of the rows of voxels starting there.
+template <class T>
+void vtkFlyingEdges3DGenerate(vtkFlyingEdges3DThreadStruct *ts, T *scalars,
+                              vtkIdType begin, vtkIdType end)
+{
+  int nx = ts->Dimensions[0];
+  int ny = ts->Dimensions[1];
+  int nz = ts->Dimensions[2];
+  vtkIdType rows[4];
+  int lo, hi, i;
+
+  for (vtkIdType row=begin; row < end; row++)
+    {
+    int j = static_cast<int>(row % ny);
+    int k = static_cast<int>(row / ny);
+    T *s = scalars + j*ts->Increments[1] + k*ts->Increments[2];
+    const vtkIdType *counts = ts->RowCounts + 6*row;
+    const int *trim = ts->RowTrims + 2*row;
+    const unsigned char *ec0 = ts->EdgeCases + row*(nx-1);
+    const unsigned char *ec1 = ec0 + (nx-1);
+    const unsigned char *ec2 = ec0 + ny*(nx-1);
+    const unsigned char *ec3 = ec2 + (nx-1);
+    vtkIdType ptId = counts[4];
+
+    // the points of the x-, then y- and z-edges of the row
+    for (i=trim[0]; i < trim[1]; i++)
+      {
+      if ( ec0[i] == 1 || ec0[i] == 2 )
+        {
+        vtkFlyingEdges3DInterpolate(ts, s, i, j, k, 0, ptId++);
+        }
+      }
+    rows[0] = row;
+    if ( j < ny-1 )
+      {
+      rows[1] = row + 1;
+      vtkFlyingEdges3DTrim(ts, rows, 2, lo, hi);
+      for (i=lo; i <= hi; i++)
+        {
+        if ( vtkFlyingEdges3DState(ec0, i, nx) !=
+             vtkFlyingEdges3DState(ec1, i, nx) )
+          {
+          vtkFlyingEdges3DInterpolate(ts, s, i, j, k, 1, ptId++);
+          }
+        }
+      }
+    if ( k < nz-1 )
+      {
+      rows[1] = row + ny;
+      vtkFlyingEdges3DTrim(ts, rows, 2, lo, hi);
+      for (i=lo; i <= hi; i++)
+        {
+        if ( vtkFlyingEdges3DState(ec0, i, nx) !=
+             vtkFlyingEdges3DState(ec2, i, nx) )
+          {
+          vtkFlyingEdges3DInterpolate(ts, s, i, j, k, 2, ptId++);
+          }
+        }
+      }
+    if ( j == ny-1 || k == nz-1 )
+      {
+      continue;
+      }
+
+    // The triangles of the row of voxels. The ids of the points cut on the
+    // x-edges of the four rows and on the y- and z-edges of two of them are
+    // advanced along the voxels.
+    rows[1] = row + 1;
+    rows[2] = row + ny;
+    rows[3] = row + ny + 1;
+    vtkFlyingEdges3DTrim(ts, rows, 4, lo, hi);
+    const vtkIdType *counts1 = ts->RowCounts + 6*rows[1];
+    const vtkIdType *counts2 = ts->RowCounts + 6*rows[2];
+    const vtkIdType *counts3 = ts->RowCounts + 6*rows[3];
+    vtkIdType xIds[4], yIds[2], zIds[2], edgeIds[12];
+    xIds[0] = counts[4];
+    xIds[1] = counts1[4];
+    xIds[2] = counts2[4];
+    xIds[3] = counts3[4];
+    yIds[0] = counts[4] + counts[0];
+    yIds[1] = counts2[4] + counts2[0];
+    zIds[0] = counts[4] + counts[0] + counts[1];
+    zIds[1] = counts1[4] + counts1[0] + counts1[1];
+    vtkIdType *poly = ts->Polys + 4*counts[5];
+    for (i=lo; i < hi; i++)
+      {
+      int index = vtkFlyingEdges3DVoxelCase(ec0[i], ec1[i], ec2[i], ec3[i]);
+      if ( index == 0 || index == 255 )
+        {
+        continue;
+        }
+      int b[8];
+      for (int v=0; v < 8; v++)
+        {
+        b[v] = (index >> v) & 1;
+        }
+      // the edges cut, numbered as in the marching cubes case table
+      int c0 = b[0] ^ b[1], c2 = b[3] ^ b[2], c4 = b[4] ^ b[5];
+      int c6 = b[7] ^ b[6], c3 = b[0] ^ b[3], c7 = b[4] ^ b[7];
+      int c8 = b[0] ^ b[4], c10 = b[3] ^ b[7];
+      edgeIds[0] = xIds[0];
+      edgeIds[2] = xIds[1];
+      edgeIds[4] = xIds[2];
+      edgeIds[6] = xIds[3];
+      edgeIds[3] = yIds[0];
+      edgeIds[1] = yIds[0] + c3;
+      edgeIds[7] = yIds[1];
+      edgeIds[5] = yIds[1] + c7;
+      edgeIds[8] = zIds[0];
+      edgeIds[9] = zIds[0] + c8;
+      edgeIds[10] = zIds[1];
+      edgeIds[11] = zIds[1] + c10;
+      for (EDGE_LIST *edge=ts->Cases[index].edges; edge[0] > -1; edge += 3)
+        {
+        *poly++ = 3;
+        *poly++ = edgeIds[edge[0]];
+        *poly++ = edgeIds[edge[1]];
+        *poly++ = edgeIds[edge[2]];
+        }
+      xIds[0] += c0;
+      xIds[1] += c2;
+      xIds[2] += c4;
+      xIds[3] += c6;
+      yIds[0] += c3;
+      yIds[1] += c7;
+      zIds[0] += c8;
+      zIds[1] += c10;
+      }
+    }
+}
+
+VTK_THREAD_RETURN_TYPE vtkFlyingEdges3DGenerateRows(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkFlyingEdges3DThreadStruct *ts =
+    static_cast<vtkFlyingEdges3DThreadStruct *>(info->UserData);
+  int threadId = info->ThreadID;
+  vtkIdType begin = ts->NumberOfRows*threadId/ts->NumberOfThreads;
+  vtkIdType end = ts->NumberOfRows*(threadId + 1)/ts->NumberOfThreads;
+
+  switch (ts->ScalarType)
+    {
+    vtkTemplateMacro(
+      vtkFlyingEdges3DGenerate(ts, static_cast<VTK_TT *>(ts->Scalars),
+                               begin, end));
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+}
+
+//----------------------------------------------------------------------------
+// Construct object with a single contour value of 0.0, computing normals
+// and scalars.
+vtkFlyingEdges3D::vtkFlyingEdges3D()
+{
+  this->ContourValues = vtkContourValues::New();
+  this->ComputeNormals = 1;
+  this->ComputeGradients = 0;
+  this->ComputeScalars = 1;
+  this->ArrayComponent = 0;
+  this->NumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+
+  // by default process active point scalars
+  this->SetInputArrayToProcess(0,0,0,vtkDataObject::FIELD_ASSOCIATION_POINTS,
+                               vtkDataSetAttributes::SCALARS);
+}
+
+//----------------------------------------------------------------------------
+vtkFlyingEdges3D::~vtkFlyingEdges3D()
+{
+  this->ContourValues->Delete();
+}
+
+//----------------------------------------------------------------------------
+// Overload standard modified time function. If contour values are modified,
+// then this object is modified as well.
+unsigned long vtkFlyingEdges3D::GetMTime()
+{
+  unsigned long mTime=this->Superclass::GetMTime();
+  unsigned long mTime2=this->ContourValues->GetMTime();
+
+  mTime = ( mTime2 > mTime ? mTime2 : mTime );
+  return mTime;
+}
+
+//----------------------------------------------------------------------------
+int vtkFlyingEdges3D::RequestData(
+  vtkInformation *vtkNotUsed(request),
+  vtkInformationVector **inputVector,
+  vtkInformationVector *outputVector)
+{
+  // get the info objects
+  vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
+  vtkInformation *outInfo = outputVector->GetInformationObject(0);
+
+  // get the input and output
+  vtkImageData *input = vtkImageData::SafeDownCast(
+    inInfo->Get(vtkDataObject::DATA_OBJECT()));
+  vtkPolyData *output = vtkPolyData::SafeDownCast(
+    outInfo->Get(vtkDataObject::DATA_OBJECT()));
+
+  vtkDebugMacro(<< "Executing flying edges");
+
+  int *ext = input->GetExtent();
+  int dims[3];
+  dims[0] = ext[1] - ext[0] + 1;
+  dims[1] = ext[3] - ext[2] + 1;
+  dims[2] = ext[5] - ext[4] + 1;
+  if ( dims[0] < 2 || dims[1] < 2 || dims[2] < 2 )
+    {
+    vtkDebugMacro(<<"3D structured contours requires 3D data");
+    return 1;
+    }
+
+  vtkDataArray *inScalars = this->GetInputArrayToProcess(0,inputVector);
+  if ( inScalars == NULL )
+    {
+    vtkDebugMacro("No scalars for contouring.");
+    return 1;
+    }
+  int numComps = inScalars->GetNumberOfComponents();
+  if ( this->ArrayComponent >= numComps )
+    {
+    vtkErrorMacro("Scalars have " << numComps << " components. "
+                  "ArrayComponent must be smaller than " << numComps);
+    return 1;
+    }
+  if ( inScalars->GetNumberOfTuples() != input->GetNumberOfPoints() )
+    {
+    vtkErrorMacro("Only point scalars can be contoured.");
+    return 1;
+    }
+
+  int numContours = this->ContourValues->GetNumberOfContours();
+  double *values = this->ContourValues->GetValues();
+  double *origin = input->GetOrigin();
+  double *spacing = input->GetSpacing();
+  int a;
+
+  vtkFlyingEdges3DThreadStruct ts;
+  ts.Scalars = inScalars->GetVoidPointer(this->ArrayComponent);
+  ts.ScalarType = inScalars->GetDataType();
+  ts.Increments[0] = numComps;
+  ts.Increments[1] = ts.Increments[0]*dims[0];
+  ts.Increments[2] = ts.Increments[1]*dims[1];
+  for (a=0; a < 3; a++)
+    {
+    ts.Dimensions[a] = dims[a];
+    ts.Origin[a] = origin[a] + spacing[a]*ext[2*a];
+    ts.Spacing[a] = spacing[a];
+    }
+  ts.NumberOfRows = static_cast<vtkIdType>(dims[1])*dims[2];
+
+  // the number of triangles of each marching cubes case
+  ts.Cases = vtkMarchingCubesTriangleCases::GetCases();
+  for (int index=0; index < 256; index++)
+    {
+    EDGE_LIST *edge = ts.Cases[index].edges;
+    for (ts.NumberOfTriangles[index]=0; edge[0] > -1; edge += 3)
+      {
+      ts.NumberOfTriangles[index]++;
+      }
+    }
+
+  // The rows are split over the threads.
+  int numThreads = this->NumberOfThreads;
+  int maxThreads = vtkMultiThreader::GetGlobalMaximumNumberOfThreads();
+  if (maxThreads > 0 && numThreads > maxThreads)
+    {
+    numThreads = maxThreads;
+    }
+  if (numThreads > ts.NumberOfRows / VTK_FLYING_EDGES_3D_MIN_ROWS_PER_THREAD)
+    {
+    numThreads = static_cast<int>(
+      ts.NumberOfRows / VTK_FLYING_EDGES_3D_MIN_ROWS_PER_THREAD);
+    }
+  if (numThreads < 1)
+    {
+    numThreads = 1;
+    }
+  ts.NumberOfThreads = numThreads;
+
+  vtkstd::vector<unsigned char> edgeCases(ts.NumberOfRows*(dims[0]-1));
+  vtkstd::vector<vtkIdType> rowCounts(6*ts.NumberOfRows);
+  vtkstd::vector<int> rowTrims(2*ts.NumberOfRows);
+  ts.EdgeCases = &edgeCases[0];
+  ts.RowCounts = &rowCounts[0];
+  ts.RowTrims = &rowTrims[0];
+
+  // The output arrays grow once per contour value, to their exact size.
+  vtkPoints *newPts = vtkPoints::New();
+  newPts->SetDataTypeToFloat();
+  vtkFloatArray *newPtsData = vtkFloatArray::SafeDownCast(newPts->GetData());
+  vtkIdTypeArray *newConnectivity = vtkIdTypeArray::New();
+  vtkFloatArray *newNormals = NULL;
+  vtkFloatArray *newGradients = NULL;
+  vtkFloatArray *newScalars = NULL;
+  if ( this->ComputeNormals )
+    {
+    newNormals = vtkFloatArray::New();
+    newNormals->SetNumberOfComponents(3);
+    newNormals->SetName("Normals");
+    }
+  if ( this->ComputeGradients )
+    {
+    newGradients = vtkFloatArray::New();
+    newGradients->SetNumberOfComponents(3);
+    newGradients->SetName("Gradients");
+    }
+  if ( this->ComputeScalars )
+    {
+    newScalars = vtkFloatArray::New();
+    newScalars->SetName(inScalars->GetName());
+    }
+
+  vtkMultiThreader *threader = vtkMultiThreader::New();
+  threader->SetNumberOfThreads(numThreads);
+  vtkIdType numPts = 0, numTris = 0, row;
+  for (int c=0; c < numContours && !this->GetAbortExecute(); c++)
+    {
+    ts.Value = values[c];
+    threader->SetSingleMethod(vtkFlyingEdges3DClassifyRows, &ts);
+    threader->SingleMethodExecute();
+    threader->SetSingleMethod(vtkFlyingEdges3DCountRows, &ts);
+    threader->SingleMethodExecute();
+    this->UpdateProgress((c + 0.5)/numContours);
+
+    // the first point and triangle ids of each row
+    vtkIdType firstPt = numPts;
+    for (row=0; row < ts.NumberOfRows; row++)
+      {
+      vtkIdType *counts = ts.RowCounts + 6*row;
+      counts[4] = numPts;
+      counts[5] = numTris;
+      numPts += counts[0] + counts[1] + counts[2];
+      numTris += counts[3];
+      }
+    if ( numPts == firstPt )
+      {
+      continue;
+      }
+
+    newPtsData->Resize(numPts);
+    ts.Points = newPtsData->WritePointer(0, 3*numPts);
+    newConnectivity->Resize(4*numTris);
+    ts.Polys = newConnectivity->WritePointer(0, 4*numTris);
+    ts.Normals = ts.Gradients = ts.NewScalars = NULL;
+    if ( newNormals )
+      {
+      newNormals->Resize(numPts);
+      ts.Normals = newNormals->WritePointer(0, 3*numPts);
+      }
+    if ( newGradients )
+      {
+      newGradients->Resize(numPts);
+      ts.Gradients = newGradients->WritePointer(0, 3*numPts);
+      }
+    if ( newScalars )
+      {
+      newScalars->Resize(numPts);
+      ts.NewScalars = newScalars->WritePointer(0, numPts);
+      }
+    threader->SetSingleMethod(vtkFlyingEdges3DGenerateRows, &ts);
+    threader->SingleMethodExecute();
+    this->UpdateProgress((c + 1.0)/numContours);
+    }
+  threader->Delete();
+
+  vtkDebugMacro(<< "Created " << numPts << " points and " << numTris
+                << " triangles");
+
+  output->SetPoints(newPts);
+  newPts->Delete();
+  vtkCellArray *newPolys = vtkCellArray::New();
+  newPolys->SetCells(numTris, newConnectivity);
+  output->SetPolys(newPolys);
+  newPolys->Delete();
+  newConnectivity->Delete();
+
+  if (newScalars)
+    {
+    int idx = output->GetPointData()->AddArray(newScalars);
+    output->GetPointData()->SetActiveAttribute(idx, vtkDataSetAttributes::SCALARS);
+    newScalars->Delete();
+    }
+  if (newGradients)
+    {
+    int idx = output->GetPointData()->AddArray(newGradients);
+    output->GetPointData()->SetActiveAttribute(idx, vtkDataSetAttributes::VECTORS);
+    newGradients->Delete();
+    }
+  if (newNormals)
+    {
+    output->GetPointData()->SetNormals(newNormals);
+    newNormals->Delete();
+    }
+
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkFlyingEdges3D::FillInputPortInformation(int, vtkInformation *info)
+{
+  info->Set(vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(), "vtkImageData");
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+void vtkFlyingEdges3D::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  this->ContourValues->PrintSelf(os,indent.GetNextIndent());
+
+  os << indent << "Compute Normals: " << (this->ComputeNormals ? "On\n" : "Off\n");
+  os << indent << "Compute Gradients: " << (this->ComputeGradients ? "On\n" : "Off\n");
+  os << indent << "Compute Scalars: " << (this->ComputeScalars ? "On\n" : "Off\n");
+  os << indent << "ArrayComponent: " << this->ArrayComponent << endl;
+  os << indent << "Number Of Threads: " << this->NumberOfThreads << "\n";
+}
@@ -0,0 +1,160 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    vtkFlyingEdges3D.h
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// .NAME vtkFlyingEdges3D - generate isosurfaces from volumes in a few threaded passes
+// .SECTION Description
+// vtkFlyingEdges3D generates triangle isosurfaces from the scalars of a 3D
+// image with the marching cubes case table, but without looking up or
+// merging points. Each contour value is processed in a few passes over the
+// rows of voxel edges along x, each of them split over NumberOfThreads
+// threads:
+//
+// 1) the x-edges are classified, and the first and last x-edges cut by
+// the isosurface along each row are kept. 2) The y- and z-edges cut and
+// the triangles of each row of voxels are counted, the rows being trimmed
+// to the span where the isosurface can lie. 3) The counts are turned into
+// the point and triangle offsets of each row. 4) The points, normals,
+// gradients and scalars of the cut edges and the triangles are written
+// directly at these offsets into arrays allocated once.
+//
+// Every point belongs to exactly one edge of a row, so no point is
+// computed twice, and the output does not depend on the number of threads.
+// The points are numbered by contour value, then by row, and along each
+// row x-edges first, then y- and z-edges.
+
+// .SECTION Caveats
+// This filter is specialized to 3D images; the whole input extent is
+// contoured. One byte per x-edge is kept while contouring each value.
+// Point attributes other than the contoured scalars are not interpolated,
+// and no cell attributes are copied.
+
+// .SECTION See Also
+// vtkSynchronizedTemplates3D vtkMarchingCubes vtkContourFilter
+
+#ifndef __vtkFlyingEdges3D_h
+#define __vtkFlyingEdges3D_h
+
+#include "vtkPolyDataAlgorithm.h"
+#include "vtkContourValues.h" // Passes calls through
+
+class vtkImageData;
+
+class VTK_GRAPHICS_EXPORT vtkFlyingEdges3D : public vtkPolyDataAlgorithm
+{
+public:
+  static vtkFlyingEdges3D *New();
+  vtkTypeMacro(vtkFlyingEdges3D,vtkPolyDataAlgorithm);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  // Description:
+  // Because we delegate to vtkContourValues
+  unsigned long int GetMTime();
+
+  // Description:
+  // Set/Get the computation of normals. Normals are the normalized
+  // opposite of the gradients, interpolated along the edges.
+  vtkSetMacro(ComputeNormals,int);
+  vtkGetMacro(ComputeNormals,int);
+  vtkBooleanMacro(ComputeNormals,int);
+
+  // Description:
+  // Set/Get the computation of gradients, by central differences at the
+  // voxel points, interpolated along the edges.
+  vtkSetMacro(ComputeGradients,int);
+  vtkGetMacro(ComputeGradients,int);
+  vtkBooleanMacro(ComputeGradients,int);
+
+  // Description:
+  // Set/Get the computation of scalars (the contour value of each point).
+  vtkSetMacro(ComputeScalars,int);
+  vtkGetMacro(ComputeScalars,int);
+  vtkBooleanMacro(ComputeScalars,int);
+
+  // Description:
+  // Set a particular contour value at contour number i. The index i ranges
+  // between 0<=i<NumberOfContours.
+  void SetValue(int i, double value) {this->ContourValues->SetValue(i,value);}
+
+  // Description:
+  // Get the ith contour value.
+  double GetValue(int i) {return this->ContourValues->GetValue(i);}
+
+  // Description:
+  // Get a pointer to an array of contour values. There will be
+  // GetNumberOfContours() values in the list.
+  double *GetValues() {return this->ContourValues->GetValues();}
+
+  // Description:
+  // Fill a supplied list with contour values. There will be
+  // GetNumberOfContours() values in the list. Make sure you allocate
+  // enough memory to hold the list.
+  void GetValues(double *contourValues) {
+    this->ContourValues->GetValues(contourValues);}
+
+  // Description:
+  // Set the number of contours to place into the list. You only really
+  // need to use this method to reduce list size. The method SetValue()
+  // will automatically increase list size as needed.
+  void SetNumberOfContours(int number) {
+    this->ContourValues->SetNumberOfContours(number);}
+
+  // Description:
+  // Get the number of contours in the list of contour values.
+  int GetNumberOfContours() {
+    return this->ContourValues->GetNumberOfContours();}
+
+  // Description:
+  // Generate numContours equally spaced contour values between specified
+  // range. Contour values will include min/max range values.
+  void GenerateValues(int numContours, double range[2]) {
+    this->ContourValues->GenerateValues(numContours, range);}
+
+  // Description:
+  // Generate numContours equally spaced contour values between specified
+  // range. Contour values will include min/max range values.
+  void GenerateValues(int numContours, double rangeStart, double rangeEnd)
+    {this->ContourValues->GenerateValues(numContours, rangeStart, rangeEnd);}
+
+  // Description:
+  // Set/get which component of the scalar array to contour on; defaults to 0.
+  vtkSetMacro(ArrayComponent, int);
+  vtkGetMacro(ArrayComponent, int);
+
+  // Description:
+  // Set/Get the number of threads processing the rows of edges. Small
+  // volumes use fewer threads. The output does not depend on this number.
+  // The default is vtkMultiThreader::GetGlobalDefaultNumberOfThreads().
+  vtkSetClampMacro(NumberOfThreads,int,1,VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads,int);
+
+protected:
+  vtkFlyingEdges3D();
+  ~vtkFlyingEdges3D();
+
+  int ComputeNormals;
+  int ComputeGradients;
+  int ComputeScalars;
+  int ArrayComponent;
+  int NumberOfThreads;
+  vtkContourValues *ContourValues;
+
+  virtual int RequestData(vtkInformation *, vtkInformationVector **, vtkInformationVector *);
+  virtual int FillInputPortInformation(int port, vtkInformation *info);
+
+private:
+  vtkFlyingEdges3D(const vtkFlyingEdges3D&);  // Not implemented.
+  void operator=(const vtkFlyingEdges3D&);  // Not implemented.
+};
+
+#endif
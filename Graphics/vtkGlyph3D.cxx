@@ -14,26 +14,404 @@
 =========================================================================*/
 #include "vtkGlyph3D.h"
 
+#include "vtkCellArray.h"
 #include "vtkCellData.h"
 #include "vtkCell.h"
 #include "vtkDataSet.h"
+#include "vtkDoubleArray.h"
 #include "vtkFloatArray.h"
 #include "vtkIdList.h"
 #include "vtkIdTypeArray.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
+#include "vtkIntArray.h"
 #include "vtkMath.h"
+#include "vtkMatrix4x4.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
+#include "vtkPointSet.h"
 #include "vtkPolyData.h"
 #include "vtkSmartPointer.h"
 #include "vtkStreamingDemandDrivenPipeline.h"
 #include "vtkTransform.h"
 #include "vtkUnsignedCharArray.h"
 
+#include <vtkstd/vector>
+
+// Minimum number of input points glyphed by each thread
+#define VTK_GLYPH3D_MIN_POINTS_PER_THREAD 1000
+
 vtkStandardNewMacro(vtkGlyph3D);
 vtkCxxSetObjectMacro(vtkGlyph3D, SourceTransform, vtkTransform);
 
+namespace
+{
+// The geometry of one glyph source, SourceTransform applied. The cells
+// are all of the same kind, so that their connectivity is a single array.
+struct vtkGlyph3DTemplate
+{
+  vtkPolyData *Source;
+  vtkIdType NumberOfPoints;
+  vtkIdType NumberOfCells;
+  vtkstd::vector<double> Points;
+  vtkstd::vector<double> Normals;
+  vtkstd::vector<vtkIdType> Connectivity;
+};
+
+// What the threads generating the glyphs share. Thread i glyphs the input
+// points from Begin[i] to Begin[i+1] and writes the glyphs at the offsets
+// computed beforehand; the point and cell data copied from the input go to
+// its own block, appended to the output afterwards.
+struct vtkGlyph3DThreadStruct
+{
+  vtkGlyph3D *Filter;
+  int ScaleMode;
+  int ColorMode;
+  int IndexMode;
+  int Clamping;
+  int Orient;
+  int Scaling;
+  int Instanced;
+  double ScaleFactor;
+  double Range[2];
+  double Den;
+  int NumberOfSources;
+
+  vtkPoints *InputPoints;
+  vtkPointData *InputPD;
+  vtkDataArray *SScalars;
+  vtkDataArray *CScalars;
+  vtkDataArray *OrientArray;
+  vtkstd::vector<int> Indices;
+  vtkstd::vector<vtkGlyph3DTemplate> Templates;
+  vtkstd::vector<double> SourceTCoords;
+  int NumberOfTCoordComponents;
+  int HaveSourceMatrix;
+  double SourceMatrix[16];
+
+  vtkstd::vector<vtkIdType> Begin;
+  vtkstd::vector<vtkIdType> PointOffset;
+  vtkstd::vector<vtkIdType> CellOffset;
+  vtkstd::vector<vtkIdType> ConnectivityOffset;
+
+  float *NewPoints;
+  float *NewNormals;
+  float *NewVectors;
+  float *NewScalars;
+  float *NewTCoords;
+  vtkIdType *NewPointIds;
+  vtkIdType *NewConnectivity;
+  double *NewTransforms;
+  double *NewDirections;
+  double *NewScaleFactors;
+  int *NewIndices;
+  vtkstd::vector<vtkPointData *> BlockPD;
+  vtkstd::vector<vtkCellData *> BlockCD;
+  vtkstd::vector<vtkDataArray *> BlockScalars;
+};
+
+// The scale factors (ScaleFactor not applied yet) and the orientation
+// vector of input point ptId, computed as in RequestData. Returns the index
+// of the glyph in the source table.
+int vtkGlyph3DComputeScales(vtkGlyph3DThreadStruct *str, vtkIdType ptId,
+                            double scale[3], double v[3], double &vMag)
+{
+  double s = 0.0;
+  int i;
+  scale[0] = scale[1] = scale[2] = 1.0;
+  vMag = 0.0;
+  if ( str->SScalars )
+    {
+    s = str->SScalars->GetComponent(ptId, 0);
+    if ( str->ScaleMode == VTK_SCALE_BY_SCALAR ||
+         str->ScaleMode == VTK_DATA_SCALING_OFF )
+      {
+      scale[0] = scale[1] = scale[2] = s;
+      }
+    }
+  if ( str->OrientArray )
+    {
+    str->OrientArray->GetTuple(ptId, v);
+    vMag = vtkMath::Norm(v);
+    if ( str->ScaleMode == VTK_SCALE_BY_VECTORCOMPONENTS )
+      {
+      scale[0] = v[0];
+      scale[1] = v[1];
+      scale[2] = v[2];
+      }
+    else if ( str->ScaleMode == VTK_SCALE_BY_VECTOR )
+      {
+      scale[0] = scale[1] = scale[2] = vMag;
+      }
+    }
+  if ( str->Clamping )
+    {
+    for (i=0; i < 3; i++)
+      {
+      scale[i] = (scale[i] < str->Range[0] ? str->Range[0] :
+                  (scale[i] > str->Range[1] ? str->Range[1] : scale[i]));
+      scale[i] = (scale[i] - str->Range[0]) / str->Den;
+      }
+    }
+
+  if ( str->IndexMode == VTK_INDEXING_OFF )
+    {
+    return 0;
+    }
+  double value = (str->IndexMode == VTK_INDEXING_BY_SCALAR ? s : vMag);
+  int index = static_cast<int>((value - str->Range[0])*str->NumberOfSources /
+                               str->Den);
+  return (index < 0 ? 0 : (index >= str->NumberOfSources ?
+                           (str->NumberOfSources-1) : index));
+}
+
+// Set trans to the transformation of the glyph at x, as in RequestData.
+// scale is changed to the scale factors actually applied.
+void vtkGlyph3DBuildTransform(vtkGlyph3DThreadStruct *str,
+                              vtkTransform *trans, double x[3],
+                              double v[3], double vMag, double scale[3])
+{
+  trans->Identity();
+  trans->Translate(x[0], x[1], x[2]);
+  if ( str->OrientArray && str->Orient && vMag > 0.0 )
+    {
+    if ( v[1] == 0.0 && v[2] == 0.0 )
+      {
+      if (v[0] < 0) //just flip x if we need to
+        {
+        trans->RotateWXYZ(180.0,0,1,0);
+        }
+      }
+    else
+      {
+      trans->RotateWXYZ(180.0, (v[0]+vMag) / 2.0, v[1] / 2.0, v[2] / 2.0);
+      }
+    }
+  if ( str->Scaling )
+    {
+    for (int i=0; i < 3; i++)
+      {
+      if ( str->ScaleMode == VTK_DATA_SCALING_OFF )
+        {
+        scale[i] = str->ScaleFactor;
+        }
+      else
+        {
+        scale[i] *= str->ScaleFactor;
+        }
+      if ( scale[i] == 0.0 )
+        {
+        scale[i] = 1.0e-10;
+        }
+      }
+    trans->Scale(scale[0], scale[1], scale[2]);
+    }
+}
+
+VTK_THREAD_RETURN_TYPE vtkGlyph3DThreadedGlyph(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkGlyph3DThreadStruct *str =
+    static_cast<vtkGlyph3DThreadStruct *>(info->UserData);
+  int range = info->ThreadID;
+  if ( range >= static_cast<int>(str->Begin.size()) - 1 )
+    {
+    return VTK_THREAD_RETURN_VALUE;
+    }
+
+  vtkPointData *blockPD = str->BlockPD.empty() ? NULL : str->BlockPD[range];
+  vtkCellData *blockCD = str->BlockCD.empty() ? NULL : str->BlockCD[range];
+  vtkDataArray *blockScalars =
+    str->BlockScalars.empty() ? NULL : str->BlockScalars[range];
+  vtkIdType ptIncr = str->PointOffset[range];
+  vtkIdType connIncr = str->ConnectivityOffset[range];
+  vtkIdType blockPtId = 0, blockCellId = 0;
+  vtkIdType begin = str->Begin[range];
+  vtkIdType end = str->Begin[range+1];
+  vtkIdType inPtId, i, j, k;
+  double x[3], v[3], vMag, scale[3], colorScale, n[3];
+  double normalMatrix[4][4];
+  vtkTransform *trans = vtkTransform::New();
+
+  for (inPtId=begin; inPtId < end; inPtId++)
+    {
+    if ( range == 0 && !((inPtId - begin) % 10000) )
+      {
+      str->Filter->UpdateProgress(
+        0.5 + 0.5*static_cast<double>(inPtId - begin)/(end - begin));
+      }
+    int index = str->Indices[inPtId];
+    if ( index < 0 )
+      {
+      continue;
+      }
+    const vtkGlyph3DTemplate &glyph = str->Templates[index];
+    vtkIdType numGlyphPts = glyph.NumberOfPoints;
+
+    vtkGlyph3DComputeScales(str, inPtId, scale, v, vMag);
+    colorScale = scale[0];
+    str->InputPoints->GetPoint(inPtId, x);
+    vtkGlyph3DBuildTransform(str, trans, x, v, vMag, scale);
+    double (*matrix)[4] = trans->GetMatrix()->Element;
+
+    if ( str->Instanced )
+      {
+      float *p = str->NewPoints + 3*ptIncr;
+      double *direction = str->NewDirections + 3*ptIncr;
+      double *scaleFactors = str->NewScaleFactors + 3*ptIncr;
+      for (i=0; i < 3; i++)
+        {
+        p[i] = static_cast<float>(x[i]);
+        direction[i] = (str->OrientArray && str->Orient ?
+                        v[i] : (i == 0 ? 1.0 : 0.0));
+        scaleFactors[i] = (str->Scaling ? scale[i] : 1.0);
+        }
+      if ( str->HaveSourceMatrix )
+        {
+        vtkMatrix4x4::Multiply4x4(*matrix, str->SourceMatrix,
+                                  str->NewTransforms + 16*ptIncr);
+        }
+      else
+        {
+        memcpy(str->NewTransforms + 16*ptIncr, *matrix, 16*sizeof(double));
+        }
+      if ( str->NewIndices )
+        {
+        str->NewIndices[ptIncr] = index;
+        }
+      }
+    else if ( numGlyphPts > 0 )
+      {
+      // same arithmetic as vtkLinearTransform::TransformPoints()
+      const double *in = &glyph.Points[0];
+      float *out = str->NewPoints + 3*ptIncr;
+      for (i=0; i < numGlyphPts; i++, in += 3, out += 3)
+        {
+        out[0] = static_cast<float>(matrix[0][0]*in[0] + matrix[0][1]*in[1] +
+                                    matrix[0][2]*in[2] + matrix[0][3]);
+        out[1] = static_cast<float>(matrix[1][0]*in[0] + matrix[1][1]*in[1] +
+                                    matrix[1][2]*in[2] + matrix[1][3]);
+        out[2] = static_cast<float>(matrix[2][0]*in[0] + matrix[2][1]*in[1] +
+                                    matrix[2][2]*in[2] + matrix[2][3]);
+        }
+
+      if ( str->NewNormals )
+        {
+        // and as vtkLinearTransform::TransformNormals()
+        vtkMatrix4x4::DeepCopy(*normalMatrix, trans->GetMatrix());
+        vtkMatrix4x4::Invert(*normalMatrix, *normalMatrix);
+        vtkMatrix4x4::Transpose(*normalMatrix, *normalMatrix);
+        in = &glyph.Normals[0];
+        out = str->NewNormals + 3*ptIncr;
+        for (i=0; i < numGlyphPts; i++, in += 3, out += 3)
+          {
+          n[0] = normalMatrix[0][0]*in[0] + normalMatrix[0][1]*in[1] +
+            normalMatrix[0][2]*in[2];
+          n[1] = normalMatrix[1][0]*in[0] + normalMatrix[1][1]*in[1] +
+            normalMatrix[1][2]*in[2];
+          n[2] = normalMatrix[2][0]*in[0] + normalMatrix[2][1]*in[1] +
+            normalMatrix[2][2]*in[2];
+          vtkMath::Normalize(n);
+          out[0] = static_cast<float>(n[0]);
+          out[1] = static_cast<float>(n[1]);
+          out[2] = static_cast<float>(n[2]);
+          }
+        }
+
+      if ( str->NewTCoords )
+        {
+        int numComps = str->NumberOfTCoordComponents;
+        out = str->NewTCoords + numComps*ptIncr;
+        for (i=0; i < numComps*numGlyphPts; i++)
+          {
+          out[i] = static_cast<float>(str->SourceTCoords[i]);
+          }
+        }
+      }
+
+    // Copy the topology, offsetting the point ids
+    vtkIdType connSize = static_cast<vtkIdType>(glyph.Connectivity.size());
+    vtkIdType *conn = str->NewConnectivity + connIncr;
+    for (j=0; j < connSize; )
+      {
+      vtkIdType npts = glyph.Connectivity[j];
+      conn[j++] = npts;
+      for (k=0; k < npts; k++, j++)
+        {
+        conn[j] = glyph.Connectivity[j] + ptIncr;
+        }
+      }
+
+    for (i=0; i < numGlyphPts; i++)
+      {
+      vtkIdType outPtId = ptIncr + i;
+      if ( str->NewVectors )
+        {
+        str->NewVectors[3*outPtId] = static_cast<float>(v[0]);
+        str->NewVectors[3*outPtId+1] = static_cast<float>(v[1]);
+        str->NewVectors[3*outPtId+2] = static_cast<float>(v[2]);
+        }
+      if ( str->NewScalars )
+        {
+        str->NewScalars[outPtId] = static_cast<float>(
+          str->ColorMode == VTK_COLOR_BY_VECTOR ? vMag : colorScale);
+        }
+      if ( blockScalars )
+        {
+        blockScalars->InsertTuple(blockPtId + i, inPtId, str->CScalars);
+        }
+      if ( str->NewPointIds )
+        {
+        str->NewPointIds[outPtId] = inPtId;
+        }
+      if ( blockPD )
+        {
+        blockPD->CopyData(str->InputPD, inPtId, blockPtId + i);
+        }
+      }
+    if ( blockCD )
+      {
+      for (i=0; i < glyph.NumberOfCells; i++)
+        {
+        blockCD->CopyData(str->InputPD, inPtId, blockCellId + i);
+        }
+      }
+
+    ptIncr += numGlyphPts;
+    connIncr += connSize;
+    blockPtId += numGlyphPts;
+    blockCellId += glyph.NumberOfCells;
+    }
+
+  trans->Delete();
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+// Copy the tuples of a thread's block to the output array, from tuple
+// offset on.
+void vtkGlyph3DAppendBlock(vtkAbstractArray *block, vtkAbstractArray *to,
+                           vtkIdType offset)
+{
+  vtkIdType numTuples = block->GetNumberOfTuples();
+  if ( vtkDataArray::SafeDownCast(to) && to->GetDataType() != VTK_BIT &&
+       block->GetDataType() == to->GetDataType() )
+    {
+    int numComps = to->GetNumberOfComponents();
+    memcpy(to->GetVoidPointer(offset*numComps), block->GetVoidPointer(0),
+           numTuples*numComps*to->GetDataTypeSize());
+    }
+  else
+    {
+    for (vtkIdType i=0; i < numTuples; i++)
+      {
+      to->SetTuple(offset + i, i, block);
+      }
+    }
+}
+}
+
 //----------------------------------------------------------------------------
 // Construct object with scaling on, scaling mode is by scalar value,
 // scale factor = 1.0, the range is (0,1), orient geometry is on, and
@@ -57,6 +435,8 @@ vtkGlyph3D::vtkGlyph3D()
   this->SetNumberOfInputPorts(2);
   this->FillCellData = 0;
   this->SourceTransform = 0;
+  this->NumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+  this->InstancedOutput = 0;
 
   // by default process active point scalars
   this->SetInputArrayToProcess(0,0,0,vtkDataObject::FIELD_ASSOCIATION_POINTS,
@@ -248,6 +628,18 @@ int vtkGlyph3D::RequestData(
     defaultPoints->Delete();
     defaultPoints = NULL;
     }
+
+  if ( (this->InstancedOutput || this->NumberOfThreads > 1) &&
+       this->GlyphInParallel(input, output, inputVector[1], inSScalars,
+                             inCScalars, (!haveVectors ? NULL :
+                              (this->VectorMode == VTK_USE_NORMAL ?
+                               inNormals : inVectors)),
+                             den, inGhostLevels, requestedGhostLevel) )
+    {
+    pts->Delete();
+    trans->Delete();
+    return 1;
+    }
   
   if ( this->IndexMode != VTK_INDEXING_OFF )
     {
@@ -690,6 +1082,524 @@ int vtkGlyph3D::RequestData(
   return 1;
 }
 
+//----------------------------------------------------------------------------
+int vtkGlyph3D::GlyphInParallel(vtkDataSet *input, vtkPolyData *output,
+                                vtkInformationVector *sourceVector,
+                                vtkDataArray *inSScalars,
+                                vtkDataArray *inCScalars,
+                                vtkDataArray *orientArray, double den,
+                                unsigned char *inGhostLevels,
+                                int requestedGhostLevel)
+{
+  vtkIdType numPts = input->GetNumberOfPoints();
+  vtkIdType inPtId, i;
+  int numberOfSources = this->GetNumberOfInputConnections(1);
+  int numThreads = this->NumberOfThreads;
+  int maxThreads = vtkMultiThreader::GetGlobalMaximumNumberOfThreads();
+  if ( maxThreads > 0 && numThreads > maxThreads )
+    {
+    numThreads = maxThreads;
+    }
+  if ( numThreads > numPts / VTK_GLYPH3D_MIN_POINTS_PER_THREAD )
+    {
+    numThreads = static_cast<int>(numPts / VTK_GLYPH3D_MIN_POINTS_PER_THREAD);
+    }
+  if ( numThreads < 1 )
+    {
+    numThreads = 1;
+    }
+  if ( numThreads == 1 && !this->InstancedOutput )
+    {
+    return 0;
+    }
+
+  vtkGlyph3DThreadStruct str;
+  str.Filter = this;
+  str.ScaleMode = this->ScaleMode;
+  str.ColorMode = this->ColorMode;
+  str.IndexMode = this->IndexMode;
+  str.Clamping = this->Clamping;
+  str.Orient = this->Orient;
+  str.Scaling = this->Scaling;
+  str.Instanced = this->InstancedOutput;
+  str.ScaleFactor = this->ScaleFactor;
+  str.Range[0] = this->Range[0];
+  str.Range[1] = this->Range[1];
+  str.Den = den;
+  str.NumberOfSources = numberOfSources;
+  str.SScalars = inSScalars;
+  str.CScalars = inCScalars;
+  str.OrientArray = orientArray;
+  str.NumberOfTCoordComponents = 0;
+  str.HaveSourceMatrix = 0;
+
+  // Build the glyph templates. The glyphs are appended to a single cell
+  // array, in the order RequestData inserts them, so all the sources must
+  // have the same kind of cells.
+  int numTemplates = (this->IndexMode == VTK_INDEXING_OFF ?
+                      1 : numberOfSources);
+  int cellType = (this->InstancedOutput ? 0 : -1);
+  int haveNormals = !this->InstancedOutput;
+  vtkDataArray *sourceTCoords = NULL;
+  str.Templates.resize(numTemplates);
+  for (int t=0; t < numTemplates; t++)
+    {
+    vtkGlyph3DTemplate &glyph = str.Templates[t];
+    vtkPolyData *source = this->GetSource(t, sourceVector);
+    glyph.Source = source;
+    glyph.NumberOfPoints = glyph.NumberOfCells = 0;
+    if ( !source )
+      {
+      continue;
+      }
+    if ( this->InstancedOutput )
+      {
+      glyph.NumberOfPoints = glyph.NumberOfCells = 1;
+      glyph.Connectivity.push_back(1);
+      glyph.Connectivity.push_back(0);
+      continue;
+      }
+
+    vtkCellArray *cells[4] = {source->GetVerts(), source->GetLines(),
+                              source->GetPolys(), source->GetStrips()};
+    for (int c=0; c < 4; c++)
+      {
+      if ( cells[c]->GetNumberOfCells() > 0 )
+        {
+        if ( cellType != -1 && cellType != c )
+          {
+          return 0;
+          }
+        cellType = c;
+        vtkIdType *conn = cells[c]->GetPointer();
+        glyph.Connectivity.assign(
+          conn, conn + cells[c]->GetNumberOfConnectivityEntries());
+        glyph.NumberOfCells = cells[c]->GetNumberOfCells();
+        }
+      }
+
+    vtkPoints *sourcePts = source->GetPoints();
+    if ( sourcePts )
+      {
+      if ( this->SourceTransform )
+        {
+        vtkPoints *transformedSourcePts = vtkPoints::New();
+        transformedSourcePts->SetDataTypeToDouble();
+        transformedSourcePts->Allocate(sourcePts->GetNumberOfPoints());
+        this->SourceTransform->TransformPoints(sourcePts,
+                                               transformedSourcePts);
+        glyph.Points.resize(3*sourcePts->GetNumberOfPoints());
+        for (i=0; i < sourcePts->GetNumberOfPoints(); i++)
+          {
+          transformedSourcePts->GetPoint(i, &glyph.Points[3*i]);
+          }
+        transformedSourcePts->Delete();
+        }
+      else
+        {
+        glyph.Points.resize(3*sourcePts->GetNumberOfPoints());
+        for (i=0; i < sourcePts->GetNumberOfPoints(); i++)
+          {
+          sourcePts->GetPoint(i, &glyph.Points[3*i]);
+          }
+        }
+      glyph.NumberOfPoints = sourcePts->GetNumberOfPoints();
+      }
+
+    vtkDataArray *sourceNormals = source->GetPointData()->GetNormals();
+    if ( !sourceNormals )
+      {
+      haveNormals = 0;
+      }
+    else if ( sourceNormals->GetNumberOfComponents() != 3 ||
+              sourceNormals->GetNumberOfTuples() != glyph.NumberOfPoints )
+      {
+      return 0;
+      }
+    else
+      {
+      glyph.Normals.resize(3*glyph.NumberOfPoints);
+      for (i=0; i < glyph.NumberOfPoints; i++)
+        {
+        sourceNormals->GetTuple(i, &glyph.Normals[3*i]);
+        }
+      }
+
+    if ( this->IndexMode == VTK_INDEXING_OFF )
+      {
+      sourceTCoords = source->GetPointData()->GetTCoords();
+      if ( sourceTCoords &&
+           sourceTCoords->GetNumberOfTuples() != glyph.NumberOfPoints )
+        {
+        return 0;
+        }
+      }
+    }
+  if ( sourceTCoords )
+    {
+    str.NumberOfTCoordComponents = sourceTCoords->GetNumberOfComponents();
+    str.SourceTCoords.resize(
+      str.NumberOfTCoordComponents*sourceTCoords->GetNumberOfTuples());
+    for (i=0; i < sourceTCoords->GetNumberOfTuples(); i++)
+      {
+      sourceTCoords->GetTuple(
+        i, &str.SourceTCoords[str.NumberOfTCoordComponents*i]);
+      }
+    }
+  if ( this->InstancedOutput && this->SourceTransform )
+    {
+    str.HaveSourceMatrix = 1;
+    vtkMatrix4x4::DeepCopy(str.SourceMatrix,
+                           this->SourceTransform->GetMatrix());
+    }
+
+  // Find the glyphed points and their glyphs. Point coordinates are read
+  // directly from the points of point sets; other datasets compute them in
+  // a buffer that is not thread safe, so they are gathered here.
+  vtkPointSet *pointSet = vtkPointSet::SafeDownCast(input);
+  vtkSmartPointer<vtkPoints> inPts;
+  if ( pointSet && pointSet->GetPoints() )
+    {
+    str.InputPoints = pointSet->GetPoints();
+    }
+  else
+    {
+    inPts = vtkSmartPointer<vtkPoints>::New();
+    inPts->SetDataTypeToDouble();
+    inPts->SetNumberOfPoints(numPts);
+    str.InputPoints = inPts;
+    }
+  str.Indices.resize(numPts);
+  double x[3], v[3], vMag, scale[3];
+  int abort = 0;
+  for (inPtId=0; inPtId < numPts; inPtId++)
+    {
+    if ( ! (inPtId % 10000) )
+      {
+      this->UpdateProgress(0.5*inPtId/numPts);
+      abort = abort || this->GetAbortExecute();
+      }
+    int index = -1;
+    if ( !abort )
+      {
+      if ( inPts )
+        {
+        input->GetPoint(inPtId, x);
+        inPts->SetPoint(inPtId, x);
+        }
+      index = vtkGlyph3DComputeScales(&str, inPtId, scale, v, vMag);
+      if ( !str.Templates[index].Source ||
+           (inGhostLevels && inGhostLevels[inPtId] > requestedGhostLevel) ||
+           !this->IsPointVisible(input, inPtId) )
+        {
+        index = -1;
+        }
+      }
+    str.Indices[inPtId] = index;
+    }
+
+  // Split the points in ranges and find where their glyphs go
+  str.Begin.resize(numThreads+1);
+  str.PointOffset.resize(numThreads+1);
+  str.CellOffset.resize(numThreads+1);
+  str.ConnectivityOffset.resize(numThreads+1);
+  str.PointOffset[0] = str.CellOffset[0] = str.ConnectivityOffset[0] = 0;
+  int range;
+  for (range=0; range <= numThreads; range++)
+    {
+    str.Begin[range] = numPts*range/numThreads;
+    }
+  for (range=0; range < numThreads; range++)
+    {
+    vtkIdType numRangePts = 0, numRangeCells = 0, connSize = 0;
+    for (inPtId=str.Begin[range]; inPtId < str.Begin[range+1]; inPtId++)
+      {
+      if ( str.Indices[inPtId] >= 0 )
+        {
+        const vtkGlyph3DTemplate &glyph = str.Templates[str.Indices[inPtId]];
+        numRangePts += glyph.NumberOfPoints;
+        numRangeCells += glyph.NumberOfCells;
+        connSize += static_cast<vtkIdType>(glyph.Connectivity.size());
+        }
+      }
+    str.PointOffset[range+1] = str.PointOffset[range] + numRangePts;
+    str.CellOffset[range+1] = str.CellOffset[range] + numRangeCells;
+    str.ConnectivityOffset[range+1] = str.ConnectivityOffset[range] + connSize;
+    }
+  vtkIdType numNewPts = str.PointOffset[numThreads];
+  vtkIdType numNewCells = str.CellOffset[numThreads];
+
+  // Allocate the output, like RequestData does. The point data of the
+  // glyphs is copied by each thread to a block with the same arrays.
+  vtkPointData *outputPD = output->GetPointData();
+  vtkCellData *outputCD = output->GetCellData();
+  vtkPointData *pd = NULL;
+  if ( this->IndexMode == VTK_INDEXING_OFF )
+    {
+    pd = input->GetPointData();
+    str.BlockPD.resize(numThreads);
+    for (range=0; range < numThreads; range++)
+      {
+      vtkIdType numRangePts =
+        str.PointOffset[range+1] - str.PointOffset[range];
+      str.BlockPD[range] = vtkPointData::New();
+      str.BlockPD[range]->ShallowCopy(outputPD);
+      str.BlockPD[range]->CopyAllocate(pd, numRangePts > 0 ? numRangePts : 1);
+      }
+    outputPD->CopyAllocate(pd, numNewPts > 0 ? numNewPts : 1);
+    for (i=0; i < outputPD->GetNumberOfArrays(); i++)
+      {
+      outputPD->GetAbstractArray(i)->SetNumberOfTuples(numNewPts);
+      }
+    if ( this->FillCellData )
+      {
+      str.BlockCD.resize(numThreads);
+      for (range=0; range < numThreads; range++)
+        {
+        vtkIdType numRangeCells =
+          str.CellOffset[range+1] - str.CellOffset[range];
+        str.BlockCD[range] = vtkCellData::New();
+        str.BlockCD[range]->ShallowCopy(outputCD);
+        str.BlockCD[range]->CopyAllocate(
+          pd, numRangeCells > 0 ? numRangeCells : 1);
+        }
+      outputCD->CopyAllocate(pd, numNewCells > 0 ? numNewCells : 1);
+      for (i=0; i < outputCD->GetNumberOfArrays(); i++)
+        {
+        outputCD->GetAbstractArray(i)->SetNumberOfTuples(numNewCells);
+        }
+      }
+    }
+  str.InputPD = pd;
+
+  vtkPoints *newPts = vtkPoints::New();
+  newPts->SetNumberOfPoints(numNewPts);
+  str.NewPoints = static_cast<vtkFloatArray *>(newPts->GetData())->GetPointer(0);
+  str.NewPointIds = NULL;
+  if ( this->GeneratePointIds )
+    {
+    vtkIdTypeArray *pointIds = vtkIdTypeArray::New();
+    pointIds->SetName(this->PointIdsName);
+    pointIds->SetNumberOfValues(numNewPts);
+    outputPD->AddArray(pointIds);
+    str.NewPointIds = pointIds->GetPointer(0);
+    pointIds->Delete();
+    }
+  vtkDataArray *newScalars = NULL;
+  str.NewScalars = NULL;
+  if ( this->ColorMode == VTK_COLOR_BY_SCALAR && inCScalars )
+    {
+    int numComps = inCScalars->GetNumberOfComponents();
+    newScalars = inCScalars->NewInstance();
+    newScalars->SetNumberOfComponents(numComps);
+    newScalars->SetNumberOfTuples(numNewPts);
+    newScalars->SetName(inCScalars->GetName());
+    str.BlockScalars.resize(numThreads);
+    for (range=0; range < numThreads; range++)
+      {
+      vtkIdType numRangePts =
+        str.PointOffset[range+1] - str.PointOffset[range];
+      str.BlockScalars[range] = inCScalars->NewInstance();
+      str.BlockScalars[range]->SetNumberOfComponents(numComps);
+      str.BlockScalars[range]->Allocate(numComps*numRangePts);
+      }
+    }
+  else if ( (this->ColorMode == VTK_COLOR_BY_SCALE && inSScalars) ||
+            (this->ColorMode == VTK_COLOR_BY_VECTOR && orientArray) )
+    {
+    vtkFloatArray *scalars = vtkFloatArray::New();
+    scalars->SetNumberOfTuples(numNewPts);
+    if ( this->ColorMode == VTK_COLOR_BY_VECTOR )
+      {
+      scalars->SetName("VectorMagnitude");
+      }
+    else if ( this->ScaleMode == VTK_SCALE_BY_SCALAR )
+      {
+      scalars->SetName(inSScalars->GetName());
+      }
+    else
+      {
+      scalars->SetName("GlyphScale");
+      }
+    str.NewScalars = scalars->GetPointer(0);
+    newScalars = scalars;
+    }
+  vtkFloatArray *newVectors = NULL;
+  str.NewVectors = NULL;
+  if ( orientArray )
+    {
+    newVectors = vtkFloatArray::New();
+    newVectors->SetNumberOfComponents(3);
+    newVectors->SetNumberOfTuples(numNewPts);
+    newVectors->SetName("GlyphVector");
+    str.NewVectors = newVectors->GetPointer(0);
+    }
+  vtkFloatArray *newNormals = NULL;
+  str.NewNormals = NULL;
+  if ( haveNormals )
+    {
+    newNormals = vtkFloatArray::New();
+    newNormals->SetNumberOfComponents(3);
+    newNormals->SetNumberOfTuples(numNewPts);
+    newNormals->SetName("Normals");
+    str.NewNormals = newNormals->GetPointer(0);
+    }
+  vtkFloatArray *newTCoords = NULL;
+  str.NewTCoords = NULL;
+  if ( sourceTCoords && !this->InstancedOutput )
+    {
+    newTCoords = vtkFloatArray::New();
+    newTCoords->SetNumberOfComponents(str.NumberOfTCoordComponents);
+    newTCoords->SetNumberOfTuples(numNewPts);
+    newTCoords->SetName("TCoords");
+    str.NewTCoords = newTCoords->GetPointer(0);
+    }
+  vtkIdTypeArray *newConnectivity = vtkIdTypeArray::New();
+  newConnectivity->SetNumberOfValues(str.ConnectivityOffset[numThreads]);
+  str.NewConnectivity = newConnectivity->GetPointer(0);
+
+  vtkDoubleArray *newTransforms = NULL;
+  vtkDoubleArray *newDirections = NULL;
+  vtkDoubleArray *newScaleFactors = NULL;
+  vtkIntArray *newIndices = NULL;
+  str.NewTransforms = str.NewDirections = str.NewScaleFactors = NULL;
+  str.NewIndices = NULL;
+  if ( this->InstancedOutput )
+    {
+    newTransforms = vtkDoubleArray::New();
+    newTransforms->SetNumberOfComponents(16);
+    newTransforms->SetNumberOfTuples(numNewPts);
+    newTransforms->SetName("GlyphTransform");
+    str.NewTransforms = newTransforms->GetPointer(0);
+    newDirections = vtkDoubleArray::New();
+    newDirections->SetNumberOfComponents(3);
+    newDirections->SetNumberOfTuples(numNewPts);
+    newDirections->SetName("GlyphDirection");
+    str.NewDirections = newDirections->GetPointer(0);
+    newScaleFactors = vtkDoubleArray::New();
+    newScaleFactors->SetNumberOfComponents(3);
+    newScaleFactors->SetNumberOfTuples(numNewPts);
+    newScaleFactors->SetName("GlyphScaleFactors");
+    str.NewScaleFactors = newScaleFactors->GetPointer(0);
+    if ( this->IndexMode != VTK_INDEXING_OFF )
+      {
+      newIndices = vtkIntArray::New();
+      newIndices->SetNumberOfValues(numNewPts);
+      newIndices->SetName("GlyphIndex");
+      str.NewIndices = newIndices->GetPointer(0);
+      }
+    }
+
+  vtkMultiThreader *threader = vtkMultiThreader::New();
+  threader->SetNumberOfThreads(numThreads);
+  threader->SetSingleMethod(vtkGlyph3DThreadedGlyph, &str);
+  threader->SingleMethodExecute();
+  threader->Delete();
+
+  // Append the blocks of the threads
+  for (range=0; range < numThreads; range++)
+    {
+    if ( !str.BlockPD.empty() )
+      {
+      vtkPointData *block = str.BlockPD[range];
+      for (int a=0; a < block->GetNumberOfArrays(); a++)
+        {
+        vtkGlyph3DAppendBlock(block->GetAbstractArray(a),
+                              outputPD->GetAbstractArray(a),
+                              str.PointOffset[range]);
+        }
+      block->Delete();
+      }
+    if ( !str.BlockCD.empty() )
+      {
+      vtkCellData *block = str.BlockCD[range];
+      for (int a=0; a < block->GetNumberOfArrays(); a++)
+        {
+        vtkGlyph3DAppendBlock(block->GetAbstractArray(a),
+                              outputCD->GetAbstractArray(a),
+                              str.CellOffset[range]);
+        }
+      block->Delete();
+      }
+    if ( !str.BlockScalars.empty() )
+      {
+      vtkGlyph3DAppendBlock(str.BlockScalars[range], newScalars,
+                            str.PointOffset[range]);
+      str.BlockScalars[range]->Delete();
+      }
+    }
+
+  // Update ourselves and release memory
+  //
+  output->SetPoints(newPts);
+  newPts->Delete();
+
+  vtkCellArray *newCells = vtkCellArray::New();
+  newCells->SetCells(numNewCells, newConnectivity);
+  newConnectivity->Delete();
+  switch (cellType)
+    {
+    case 0:
+      output->SetVerts(newCells);
+      break;
+    case 1:
+      output->SetLines(newCells);
+      break;
+    case 2:
+      output->SetPolys(newCells);
+      break;
+    case 3:
+      output->SetStrips(newCells);
+      break;
+    }
+  newCells->Delete();
+
+  if (newScalars)
+    {
+    int idx = outputPD->AddArray(newScalars);
+    outputPD->SetActiveAttribute(idx, vtkDataSetAttributes::SCALARS);
+    newScalars->Delete();
+    }
+
+  if (newVectors)
+    {
+    outputPD->SetVectors(newVectors);
+    newVectors->Delete();
+    }
+
+  if (newNormals)
+    {
+    outputPD->SetNormals(newNormals);
+    newNormals->Delete();
+    }
+
+  if (newTCoords)
+    {
+    outputPD->SetTCoords(newTCoords);
+    newTCoords->Delete();
+    }
+
+  if (newTransforms)
+    {
+    outputPD->AddArray(newTransforms);
+    newTransforms->Delete();
+    outputPD->AddArray(newDirections);
+    newDirections->Delete();
+    outputPD->AddArray(newScaleFactors);
+    newScaleFactors->Delete();
+    }
+
+  if (newIndices)
+    {
+    outputPD->AddArray(newIndices);
+    newIndices->Delete();
+    }
+
+  output->Squeeze();
+
+  return 1;
+}
+
 //----------------------------------------------------------------------------
 // Specify a source object at a specified table location.
 void vtkGlyph3D::SetSourceConnection(int id, vtkAlgorithmOutput* algOutput)
@@ -831,6 +1741,9 @@ void vtkGlyph3D::PrintSelf(ostream& os, vtkIndent indent)
     }
 
   os << indent << "Fill Cell Data: " << (this->FillCellData ? "On\n" : "Off\n");
+  os << indent << "Number Of Threads: " << this->NumberOfThreads << "\n";
+  os << indent << "Instanced Output: "
+     << (this->InstancedOutput ? "On\n" : "Off\n");
 
   os << indent << "SourceTransform: ";
   if (this->SourceTransform)
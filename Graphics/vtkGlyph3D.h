@@ -22,6 +22,14 @@
 // creating a table of source objects, each defining a different glyph. If a
 // table of glyphs is defined, then the table can be indexed into by using
 // either scalar value or vector magnitude.
+//
+// The glyphs can be generated with several threads (see NumberOfThreads).
+// Each thread copies the source geometry, transformed once by
+// SourceTransform, to a contiguous range of input points, and the output
+// is the same as the one generated with a single thread. Instead of the
+// glyph geometry, the filter can also output one vertex per glyph along
+// with the transformation of the glyph (see InstancedOutput), for
+// rendering the glyphs as instances with vtkGlyph3DMapper.
 // 
 // To use this object you'll have to provide an input dataset and a source
 // to define the glyph. Then decide whether you want to scale the glyph and
@@ -91,6 +99,7 @@
 #define VTK_INDEXING_BY_SCALAR 1
 #define VTK_INDEXING_BY_VECTOR 2
 
+class vtkDataArray;
 class vtkTransform;
 
 class VTK_GRAPHICS_EXPORT vtkGlyph3D : public vtkPolyDataAlgorithm
@@ -242,6 +251,31 @@ public:
   void SetSourceTransform(vtkTransform*);
   vtkGetObjectMacro(SourceTransform, vtkTransform);
 
+  // Description:
+  // Set/Get the number of threads generating the glyphs. Multiple threads
+  // are used when all the glyph sources are made of a single kind of cells
+  // (vertices, lines, polygons or triangle strips), which is the usual
+  // case. The default is vtkMultiThreader::GetGlobalDefaultNumberOfThreads().
+  vtkSetClampMacro(NumberOfThreads,int,1,VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads,int);
+
+  // Description:
+  // Enable/disable the output of glyph instances instead of glyph geometry.
+  // When on, the output has one vertex at each glyphed input point, with
+  // the point data that would be attached to the glyph points, plus
+  // "GlyphTransform", the 16 components of the matrix (row after row)
+  // mapping the source to the glyph, including SourceTransform,
+  // "GlyphDirection" and "GlyphScaleFactors" and, when indexing,
+  // "GlyphIndex", the index of the source in the table. Without
+  // SourceTransform, vtkGlyph3DMapper renders the same glyphs from this
+  // output using "GlyphDirection" as orientation array (direction mode),
+  // "GlyphScaleFactors" as scale array (scaling by vector components with a
+  // scale factor of 1) and "GlyphIndex" as source index array with a range
+  // of (0, number of sources). Default is off.
+  vtkSetMacro(InstancedOutput,int);
+  vtkGetMacro(InstancedOutput,int);
+  vtkBooleanMacro(InstancedOutput,int);
+
   // Description:
   // Overridden to include SourceTransform's MTime.
   virtual unsigned long GetMTime();
@@ -256,6 +290,17 @@ protected:
 
   vtkPolyData* GetSource(int idx, vtkInformationVector *sourceInfo);
 
+  // Description:
+  // Generate the glyphs with NumberOfThreads threads, or the glyph
+  // instances when InstancedOutput is on. orientArray holds the vectors or
+  // normals used to orient the glyphs, or is NULL. Returns 0, leaving the
+  // output untouched, when the glyphs have to be generated serially.
+  int GlyphInParallel(vtkDataSet *input, vtkPolyData *output,
+                      vtkInformationVector *sourceVector,
+                      vtkDataArray *inSScalars, vtkDataArray *inCScalars,
+                      vtkDataArray *orientArray, double den,
+                      unsigned char *inGhostLevels, int requestedGhostLevel);
+
   vtkPolyData **Source; // Geometry to copy to each point
   int Scaling; // Determine whether scaling of geometry is performed
   int ScaleMode; // Scale by scalar value or vector magnitude
@@ -270,6 +315,8 @@ protected:
   int FillCellData; // whether to fill output cell data
   char *PointIdsName;
   vtkTransform* SourceTransform;
+  int NumberOfThreads;
+  int InstancedOutput;
 
 private:
   vtkGlyph3D(const vtkGlyph3D&);  // Not implemented.
@@ -1063,6 +1063,11 @@ void vtkOBBTree::BuildLocator()
     return;
     }
 
+  if ( this->ReadSearchStructureFromCache() )
+    {
+    return;
+    }
+
   this->OBBCount = 0;
   this->InsertedPoints = new int[numPts];
   for (i=0; i < numPts; i++)
@@ -1112,6 +1117,7 @@ void vtkOBBTree::BuildLocator()
   this->PointsList->Delete();
 
   this->BuildTime.Modified();
+  this->WriteSearchStructureToCache();
 }
 
 // NOTE: for better memory usage this recursive method
@@ -1872,6 +1878,165 @@ int vtkOBBTree::IntersectWithOBBTree( vtkOBBTree *OBBTreeB,
   return( count );
   }
 
+//----------------------------------------------------------------------------
+int vtkOBBTree::GetSearchStructureParameters(double params[8])
+{
+  int n = this->Superclass::GetSearchStructureParameters(params);
+  params[n++] = this->RetainCellLists;
+  return n;
+}
+
+//----------------------------------------------------------------------------
+// The nodes are written in pre-order: the corner and axes of the box, a
+// flag telling whether the node has children, and its cell list (a count
+// of -1 when the node holds no list).
+int vtkOBBTree::WriteSearchStructure(const char *fileName)
+{
+  if ( !this->Tree || !this->DataSet )
+    {
+    vtkErrorMacro(<<"No OBB tree to write");
+    return 0;
+    }
+
+  ofstream os(fileName, ios::out | ios::binary);
+  if ( !os )
+    {
+    vtkErrorMacro(<<"Cannot open " << fileName << " for writing");
+    return 0;
+    }
+
+  this->WriteSearchStructureHeader(os);
+  os.write(reinterpret_cast<char *>(&this->Level), sizeof(int));
+  os.write(reinterpret_cast<char *>(&this->OBBCount), sizeof(int));
+  this->WriteNode(os, this->Tree);
+
+  if ( !os )
+    {
+    vtkErrorMacro(<<"Error writing " << fileName);
+    return 0;
+    }
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+void vtkOBBTree::WriteNode(ostream &os, vtkOBBNode *OBBptr)
+{
+  vtkIdType flags[2];
+  flags[0] = (OBBptr->Kids != NULL);
+  flags[1] = OBBptr->Cells ? OBBptr->Cells->GetNumberOfIds() : -1;
+  os.write(reinterpret_cast<char *>(OBBptr->Corner), 3*sizeof(double));
+  os.write(reinterpret_cast<char *>(OBBptr->Axes), 9*sizeof(double));
+  os.write(reinterpret_cast<char *>(flags), 2*sizeof(vtkIdType));
+  if ( flags[1] > 0 )
+    {
+    os.write(reinterpret_cast<char *>(OBBptr->Cells->GetPointer(0)),
+             flags[1]*sizeof(vtkIdType));
+    }
+  if ( OBBptr->Kids )
+    {
+    this->WriteNode(os, OBBptr->Kids[0]);
+    this->WriteNode(os, OBBptr->Kids[1]);
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkOBBTree::ReadSearchStructure(const char *fileName)
+{
+  size_t size;
+  char *data = vtkAbstractCellLocator::ReadWholeFile(fileName, size);
+  if ( !data )
+    {
+    vtkErrorMacro(<<"Cannot read " << fileName);
+    return 0;
+    }
+  const char *buffer = data;
+  const char *end = data + size;
+
+  int level, obbCount;
+  vtkOBBNode *tree = new vtkOBBNode;
+  if ( !this->ReadSearchStructureHeader(buffer, end) ||
+       !vtkAbstractCellLocator::ReadFromBuffer(buffer, end, &level,
+                                               sizeof(int)) ||
+       !vtkAbstractCellLocator::ReadFromBuffer(buffer, end, &obbCount,
+                                               sizeof(int)) ||
+       !this->ReadNode(buffer, end, tree, 0) || buffer != end )
+    {
+    vtkDebugMacro(<<fileName << " does not hold a matching OBB tree");
+    this->DeleteTree(tree);
+    delete tree;
+    delete [] data;
+    return 0;
+    }
+  delete [] data;
+
+  this->FreeSearchStructure();
+  this->Tree = tree;
+  this->Level = level;
+  this->OBBCount = obbCount;
+  this->BuildTime.Modified();
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+// On failure the children and cell lists created so far stay attached to
+// OBBptr, so the caller can free the partial tree with DeleteTree().
+int vtkOBBTree::ReadNode(const char *&buffer, const char *end,
+                         vtkOBBNode *OBBptr, int level)
+{
+  vtkIdType flags[2];
+  if ( level > this->MaxLevel ||
+       !vtkAbstractCellLocator::ReadFromBuffer(buffer, end, OBBptr->Corner,
+                                               3*sizeof(double)) ||
+       !vtkAbstractCellLocator::ReadFromBuffer(buffer, end, OBBptr->Axes,
+                                               9*sizeof(double)) ||
+       !vtkAbstractCellLocator::ReadFromBuffer(buffer, end, flags,
+                                               2*sizeof(vtkIdType)) ||
+       flags[1] < -1 ||
+       static_cast<size_t>(end - buffer) <
+       (flags[1] > 0 ? flags[1] : 0)*sizeof(vtkIdType) )
+    {
+    return 0;
+    }
+
+  if ( flags[1] >= 0 )
+    {
+    OBBptr->Cells = vtkIdList::New();
+    OBBptr->Cells->SetNumberOfIds(flags[1]);
+    if ( flags[1] > 0 )
+      {
+      vtkAbstractCellLocator::ReadFromBuffer(buffer, end,
+                                             OBBptr->Cells->GetPointer(0),
+                                             flags[1]*sizeof(vtkIdType));
+      }
+    // Every id must be a cell of the data set, or the queries would index
+    // past its cells.
+    vtkIdType numCells = this->DataSet->GetNumberOfCells();
+    for ( vtkIdType i=0; i < flags[1]; i++ )
+      {
+      vtkIdType cellId = OBBptr->Cells->GetId(i);
+      if ( cellId < 0 || cellId >= numCells )
+        {
+        return 0;
+        }
+      }
+    }
+
+  if ( flags[0] )
+    {
+    OBBptr->Kids = new vtkOBBNode *[2];
+    OBBptr->Kids[0] = new vtkOBBNode;
+    OBBptr->Kids[1] = new vtkOBBNode;
+    OBBptr->Kids[0]->Parent = OBBptr;
+    OBBptr->Kids[1]->Parent = OBBptr;
+    if ( !this->ReadNode(buffer, end, OBBptr->Kids[0], level+1) ||
+         !this->ReadNode(buffer, end, OBBptr->Kids[1], level+1) )
+      {
+      return 0;
+      }
+    }
+  return 1;
+}
+
 void vtkOBBTree::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
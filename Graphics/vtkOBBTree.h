@@ -265,11 +265,22 @@ public:
   // the relative diameter of the OBB compared to the diameter (d).
   void GenerateRepresentation(int level, vtkPolyData *pd);
 
+  // Description:
+  // Write the OBB tree to a binary file, or read it back.  See
+  // vtkAbstractCellLocator::SetCacheDirectory() to do this automatically.
+  virtual int WriteSearchStructure(const char *fileName);
+  virtual int ReadSearchStructure(const char *fileName);
+
   //BTX
 protected:
   vtkOBBTree();
   ~vtkOBBTree();
 
+  virtual int GetSearchStructureParameters(double params[8]);
+  void WriteNode(ostream &os, vtkOBBNode *OBBptr);
+  int ReadNode(const char *&buffer, const char *end, vtkOBBNode *OBBptr,
+               int level);
+
   // Compute an OBB from the list of cells given.  This used to be
   // public but should not have been.  A public call has been added
   // so that the functionality can be accessed.
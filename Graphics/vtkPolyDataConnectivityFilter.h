@@ -34,6 +34,14 @@
 // scalar values of one of the cell's points falls in the scalar range
 // specified. This use of ScalarConnectivity is particularly useful for
 // selecting cells for later processing.
+//
+// When all the regions are visited (largest, specified or all regions
+// extraction), the regions are labeled with a union-find over the cell
+// points instead of a wave propagation, by several threads (see
+// NumberOfThreads). The region ids and sizes are the same: regions are
+// numbered in the order of their first cell. The extracted points keep
+// their input order. The LabelRegionsOnly mode only adds the region ids to
+// the input.
 
 // .SECTION See Also
 // vtkConnectivityFilter
@@ -137,6 +145,22 @@ public:
   vtkGetMacro(ColorRegions,int);
   vtkBooleanMacro(ColorRegions,int);
 
+  // Description:
+  // Turn on/off labeling the regions without extracting them. When on, all
+  // the regions are labeled whatever the ExtractionMode, and the output is
+  // the input with "RegionId" point and cell arrays, sharing its points and
+  // cells. Points used by no cell get the region id -1. Off by default.
+  vtkSetMacro(LabelRegionsOnly,int);
+  vtkGetMacro(LabelRegionsOnly,int);
+  vtkBooleanMacro(LabelRegionsOnly,int);
+
+  // Description:
+  // Set/Get the number of threads labeling the regions. Small inputs use
+  // fewer threads. The regions do not depend on this number. The default is
+  // vtkMultiThreader::GetGlobalDefaultNumberOfThreads().
+  vtkSetClampMacro(NumberOfThreads,int,1,VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads,int);
+
 protected:
   vtkPolyDataConnectivityFilter();
   ~vtkPolyDataConnectivityFilter();
@@ -155,8 +179,18 @@ protected:
   int ScalarConnectivity;
   double ScalarRange[2];
 
+  int LabelRegionsOnly;
+  int NumberOfThreads;
+
   void TraverseAndMark();
 
+  // Description:
+  // Label all the regions of the mesh with a union-find over the points of
+  // the cells. Set the region of each cell and the region sizes, return the
+  // id of the largest region and the region of each point (the first region
+  // using it, -1 when no cell uses it) in pointRegions.
+  vtkIdType LabelAllRegions(vtkIdType *pointRegions);
+
 private:
   // used to support algorithm execution
   vtkDataArray *CellScalars;
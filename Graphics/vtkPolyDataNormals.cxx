@@ -20,6 +20,7 @@
 #include "vtkMath.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
 #include "vtkPolyData.h"
@@ -27,8 +28,241 @@
 #include "vtkTriangleStrip.h"
 #include "vtkPriorityQueue.h"
 
+#include <vtkstd/vector>
+
 vtkStandardNewMacro(vtkPolyDataNormals);
 
+// Minimum number of polygons processed by each thread
+#define VTK_POLYDATA_NORMALS_MIN_POLYS_PER_THREAD 10000
+
+namespace
+{
+// The data shared by the threads computing the normals
+struct vtkPolyDataNormalsThreadStruct
+{
+  vtkPolyDataNormals *Filter;
+  vtkPoints *Points;
+  vtkIdType NumberOfPolys;
+  vtkIdType NumberOfPoints;
+  int NumberOfThreads;
+  // connectivity of all the polygons, and of the first polygon of each
+  // thread
+  vtkIdType *Connectivity;
+  vtkIdType *ConnectivityEnd;
+  vtkstd::vector<vtkIdType *> FirstPolys;
+  // with several threads, PointPolys[t*NumberOfThreads + p] holds the
+  // (polygon id, connectivity offset) pairs of the polygons of thread t
+  // that have points of thread p, in polygon order
+  vtkstd::vector<vtkstd::vector<vtkIdType> > PointPolys;
+  float *PolyNormals;
+  float *PointNormals;
+  double FlipDirection;
+};
+
+// Compute the normals of a contiguous range of polygons.
+VTK_THREAD_RETURN_TYPE vtkPolyDataNormalsPolyNormals(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkPolyDataNormalsThreadStruct *ts =
+    static_cast<vtkPolyDataNormalsThreadStruct *>(info->UserData);
+  int threadId = info->ThreadID;
+  vtkIdType begin = ts->NumberOfPolys*threadId/ts->NumberOfThreads;
+  vtkIdType end = ts->NumberOfPolys*(threadId + 1)/ts->NumberOfThreads;
+  vtkIdType *pts = ts->FirstPolys[threadId];
+  double n[3];
+
+  for (vtkIdType cellId=begin; cellId < end; cellId++)
+    {
+    // only the calling thread reports progress
+    if (threadId == 0 && (cellId % 1000) == 0)
+      {
+      ts->Filter->UpdateProgress(0.333 + 0.333*(cellId - begin)/(end - begin));
+      if (ts->Filter->GetAbortExecute())
+        {
+        break;
+        }
+      }
+    vtkIdType npts = *pts++;
+    vtkPolygon::ComputeNormal(ts->Points, npts, pts, n);
+    float *polyNormal = ts->PolyNormals + 3*cellId;
+    polyNormal[0] = static_cast<float>(n[0]);
+    polyNormal[1] = static_cast<float>(n[1]);
+    polyNormal[2] = static_cast<float>(n[2]);
+    pts += npts;
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+// Find the connectivity of the first polygon of each thread.
+void vtkPolyDataNormalsFindFirstPolys(vtkPolyDataNormalsThreadStruct *ts)
+{
+  int numThreads = ts->NumberOfThreads;
+  ts->FirstPolys.assign(numThreads, ts->Connectivity);
+  vtkIdType *pts = ts->Connectivity;
+  for (vtkIdType cellId=0, j=0; cellId < ts->NumberOfPolys;
+       cellId++, pts += *pts + 1)
+    {
+    if (j < numThreads && cellId == ts->NumberOfPolys*j/numThreads)
+      {
+      ts->FirstPolys[j++] = pts;
+      }
+    }
+}
+
+// The thread that owns a point, the one whose range of point ids contains
+// it.  The range of the last owner is kept, since the points of a polygon
+// are often close.
+class vtkPolyDataNormalsPointOwner
+{
+public:
+  vtkPolyDataNormalsPointOwner(vtkIdType numPoints, int numThreads) :
+    NumberOfPoints(numPoints), NumberOfThreads(numThreads),
+    Owner(0), Begin(0), End(0) {}
+
+  int operator()(vtkIdType ptId)
+    {
+    if (ptId < this->Begin || ptId >= this->End)
+      {
+      vtkIdType n = this->NumberOfThreads;
+      this->Owner = static_cast<int>(ptId*n/this->NumberOfPoints);
+      this->Begin = (this->NumberOfPoints*this->Owner + n - 1)/n;
+      this->End = (this->NumberOfPoints*(this->Owner + 1) + n - 1)/n;
+      }
+    return this->Owner;
+    }
+
+protected:
+  vtkIdType NumberOfPoints;
+  int NumberOfThreads;
+  int Owner;
+  vtkIdType Begin;
+  vtkIdType End;
+};
+
+// List each polygon of a contiguous range of polygons once for every
+// thread that owns some of its points.
+VTK_THREAD_RETURN_TYPE vtkPolyDataNormalsSortPointPolys(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkPolyDataNormalsThreadStruct *ts =
+    static_cast<vtkPolyDataNormalsThreadStruct *>(info->UserData);
+  int threadId = info->ThreadID;
+  int numThreads = ts->NumberOfThreads;
+  vtkIdType begin = ts->NumberOfPolys*threadId/numThreads;
+  vtkIdType end = ts->NumberOfPolys*(threadId + 1)/numThreads;
+  vtkstd::vector<vtkIdType> *lists = &ts->PointPolys[threadId*numThreads];
+  vtkPolyDataNormalsPointOwner owner(ts->NumberOfPoints, numThreads);
+  vtkIdType *pts = ts->FirstPolys[threadId];
+
+  for (vtkIdType cellId=begin; cellId < end; cellId++)
+    {
+    vtkIdType offset = pts - ts->Connectivity;
+    vtkIdType npts = *pts++;
+    for (vtkIdType i=0; i < npts; i++, pts++)
+      {
+      vtkstd::vector<vtkIdType> &list = lists[owner(*pts)];
+      if (list.empty() || list[list.size() - 2] != cellId)
+        {
+        list.push_back(cellId);
+        list.push_back(offset);
+        }
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+// Accumulate the polygon normals at the points of a contiguous range of
+// point ids, then normalize them. The normals are summed in polygon order,
+// whatever the number of threads.
+VTK_THREAD_RETURN_TYPE vtkPolyDataNormalsPointNormals(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkPolyDataNormalsThreadStruct *ts =
+    static_cast<vtkPolyDataNormalsThreadStruct *>(info->UserData);
+  int threadId = info->ThreadID;
+  int numThreads = ts->NumberOfThreads;
+  // the points whose owner, as computed by vtkPolyDataNormalsSortPointPolys,
+  // is this thread
+  vtkIdType begin =
+    (ts->NumberOfPoints*threadId + numThreads - 1)/numThreads;
+  vtkIdType end =
+    (ts->NumberOfPoints*(threadId + 1) + numThreads - 1)/numThreads;
+  float *normals = ts->PointNormals;
+  const float *polyNormal = ts->PolyNormals;
+  vtkIdType i;
+  int j;
+
+  if (numThreads == 1)
+    {
+    for (vtkIdType *pts=ts->Connectivity; pts < ts->ConnectivityEnd;
+         polyNormal += 3)
+      {
+      vtkIdType npts = *pts++;
+      for (i=0; i < npts; i++, pts++)
+        {
+        float *vertNormal = normals + 3*(*pts);
+        for (j=0; j < 3; j++)
+          {
+          vertNormal[j] = static_cast<float>(
+            static_cast<double>(vertNormal[j]) + polyNormal[j]);
+          }
+        }
+      }
+    }
+  else
+    {
+    // the lists of the threads come in polygon order
+    for (int t=0; t < numThreads; t++)
+      {
+      vtkstd::vector<vtkIdType> &list =
+        ts->PointPolys[t*numThreads + threadId];
+      for (size_t k=0; k < list.size(); k += 2)
+        {
+        const float *cellNormal = polyNormal + 3*list[k];
+        const vtkIdType *pts = ts->Connectivity + list[k+1];
+        vtkIdType npts = *pts++;
+        for (i=0; i < npts; i++, pts++)
+          {
+          if (*pts >= begin && *pts < end)
+            {
+            float *vertNormal = normals + 3*(*pts);
+            for (j=0; j < 3; j++)
+              {
+              vertNormal[j] = static_cast<float>(
+                static_cast<double>(vertNormal[j]) + cellNormal[j]);
+              }
+            }
+          }
+        }
+      vtkstd::vector<vtkIdType>().swap(list);
+      }
+    }
+
+  for (i=begin; i < end; i++)
+    {
+    double vertNormal[3];
+    for (j=0; j < 3; j++)
+      {
+      vertNormal[j] = normals[3*i + j];
+      }
+    double length = vtkMath::Norm(vertNormal);
+    if (length != 0.0)
+      {
+      for (j=0; j < 3; j++)
+        {
+        normals[3*i + j] =
+          static_cast<float>(vertNormal[j] / length * ts->FlipDirection);
+        }
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+}
+
+
 // Construct with feature angle=30, splitting and consistency turned on, 
 // flipNormals turned off, and non-manifold traversal turned on.
 vtkPolyDataNormals::vtkPolyDataNormals()
@@ -41,6 +275,7 @@ vtkPolyDataNormals::vtkPolyDataNormals()
   this->ComputeCellNormals = 0;
   this->NonManifoldTraversal = 1;
   this->AutoOrientNormals = 0;
+  this->NumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
   // some internal data
   this->NumFlips = 0;
 }
@@ -64,12 +299,10 @@ int vtkPolyDataNormals::RequestData(
   vtkPolyData *output = vtkPolyData::SafeDownCast(
     outInfo->Get(vtkDataObject::DATA_OBJECT()));
 
-  int j;
   vtkIdType npts = 0;
   vtkIdType i;
   vtkIdType *pts = 0;
   vtkIdType numNewPts;
-  double polyNormal[3], vertNormal[3], length;
   double flipDirection=1.0;
   vtkIdType numPolys, numStrips;
   vtkIdType cellId;
@@ -142,7 +375,15 @@ int vtkPolyDataNormals::RequestData(
     this->OldMesh->SetPolys(inPolys);
     polys = inPolys;
     }
-  this->OldMesh->BuildLinks();
+
+  // Without reordering nor splitting, the polygons are left untouched: the
+  // links and the copy of the polygons are not needed.
+  int modifyPolys = 
+    this->Consistency || this->Splitting || this->AutoOrientNormals;
+  if ( modifyPolys )
+    {
+    this->OldMesh->BuildLinks();
+    }
   this->UpdateProgress(0.10);
   
   pd = input->GetPointData();
@@ -152,11 +393,19 @@ int vtkPolyDataNormals::RequestData(
     
   this->NewMesh = vtkPolyData::New();
   this->NewMesh->SetPoints(inPts);
-  // create a copy because we're modifying it
-  newPolys = vtkCellArray::New();
-  newPolys->DeepCopy(polys);
-  this->NewMesh->SetPolys(newPolys);
-  this->NewMesh->BuildCells(); //builds connectivity
+  if ( modifyPolys )
+    {
+    // create a copy because we're modifying it
+    newPolys = vtkCellArray::New();
+    newPolys->DeepCopy(polys);
+    this->NewMesh->SetPolys(newPolys);
+    this->NewMesh->BuildCells(); //builds connectivity
+    }
+  else
+    {
+    newPolys = polys;
+    newPolys->Register(this);
+    }
 
   // The visited array keeps track of which polygons have been visited.
   //
@@ -308,6 +557,36 @@ int vtkPolyDataNormals::RequestData(
   
   this->UpdateProgress(0.333);
 
+  //  The normals are computed by NumberOfThreads threads, each of them
+  //  handling a range of polygons or of points.
+  //
+  int numThreads = this->NumberOfThreads;
+  int maxThreads = vtkMultiThreader::GetGlobalMaximumNumberOfThreads();
+  if (maxThreads > 0 && numThreads > maxThreads)
+    {
+    numThreads = maxThreads;
+    }
+  if (numThreads > numPolys / VTK_POLYDATA_NORMALS_MIN_POLYS_PER_THREAD)
+    {
+    numThreads = static_cast<int>(
+      numPolys / VTK_POLYDATA_NORMALS_MIN_POLYS_PER_THREAD);
+    }
+  if (numThreads < 1)
+    {
+    numThreads = 1;
+    }
+  vtkMultiThreader *threader = vtkMultiThreader::New();
+  threader->SetNumberOfThreads(numThreads);
+
+  vtkPolyDataNormalsThreadStruct ts;
+  ts.Filter = this;
+  ts.Points = inPts;
+  ts.NumberOfPolys = numPolys;
+  ts.NumberOfThreads = numThreads;
+  ts.Connectivity = newPolys->GetPointer();
+  ts.ConnectivityEnd = ts.Connectivity + newPolys->GetNumberOfConnectivityEntries();
+  vtkPolyDataNormalsFindFirstPolys(&ts);
+
   //  Initial pass to compute polygon normals without effects of neighbors
   //
   this->PolyNormals = vtkFloatArray::New();
@@ -315,21 +594,11 @@ int vtkPolyDataNormals::RequestData(
   this->PolyNormals->Allocate(3*numPolys);
   this->PolyNormals->SetName("Normals");
   this->PolyNormals->SetNumberOfTuples(numPolys);
+  memset(this->PolyNormals->GetPointer(0), 0, 3*numPolys*sizeof(float));
 
-  for (cellId=0, newPolys->InitTraversal(); newPolys->GetNextCell(npts,pts); 
-       cellId++ )
-    {
-    if ((cellId % 1000) == 0)
-      {
-      this->UpdateProgress (0.333 + 0.333 * (double) cellId / (double) numPolys);
-      if (this->GetAbortExecute())
-        {
-        break; 
-        }
-      }
-    vtkPolygon::ComputeNormal(inPts, npts, pts, n);
-    this->PolyNormals->SetTuple(cellId,n);
-    }
+  ts.PolyNormals = this->PolyNormals->GetPointer(0);
+  threader->SetSingleMethod(vtkPolyDataNormalsPolyNormals, &ts);
+  threader->SingleMethodExecute();
 
   // Split mesh if sharp features
   if ( this->Splitting ) 
@@ -408,36 +677,24 @@ int vtkPolyDataNormals::RequestData(
 
   if (this->ComputePointNormals)
     {
-    for (cellId=0, newPolys->InitTraversal(); newPolys->GetNextCell(npts,pts); 
-          cellId++ )
+    // the splitting may have changed the connectivity
+    ts.Connectivity = newPolys->GetPointer();
+    ts.ConnectivityEnd = 
+      ts.Connectivity + newPolys->GetNumberOfConnectivityEntries();
+    ts.NumberOfPoints = numNewPts;
+    ts.PointNormals = newNormals->GetPointer(0);
+    ts.FlipDirection = flipDirection;
+    if (numThreads > 1)
       {
-      this->PolyNormals->GetTuple(cellId, polyNormal);
-
-      for (i=0; i < npts; i++) 
-        {
-        newNormals->GetTuple(pts[i], vertNormal);
-        for (j=0; j < 3; j++)
-          {
-          n[j] = vertNormal[j] + polyNormal[j];
-          }
-        newNormals->SetTuple(pts[i],n);
-        }
-      }
-
-    for (i=0; i < numNewPts; i++) 
-      {
-      newNormals->GetTuple(i, vertNormal);
-      length = vtkMath::Norm(vertNormal);
-      if (length != 0.0) 
-        {
-        for (j=0; j < 3; j++)
-          {
-          n[j] = vertNormal[j] / length * flipDirection;
-          }
-        }
-      newNormals->SetTuple(i,n);
+      vtkPolyDataNormalsFindFirstPolys(&ts);
+      ts.PointPolys.resize(numThreads*numThreads);
+      threader->SetSingleMethod(vtkPolyDataNormalsSortPointPolys, &ts);
+      threader->SingleMethodExecute();
       }
+    threader->SetSingleMethod(vtkPolyDataNormalsPointNormals, &ts);
+    threader->SingleMethodExecute();
     }
+  threader->Delete();
 
   //  Update ourselves.  If no new nodes have been created (i.e., no
   //  splitting), we can simply pass data through.
@@ -729,5 +986,6 @@ void vtkPolyDataNormals::PrintSelf(ostream& os, vtkIndent indent)
      << (this->ComputeCellNormals ? "On\n" : "Off\n");
   os << indent << "Non-manifold Traversal: " 
      << (this->NonManifoldTraversal ? "On\n" : "Off\n");
+  os << indent << "Number Of Threads: " << this->NumberOfThreads << "\n";
 }
 
@@ -24,6 +24,12 @@
 // averaging them at shared points. When sharp edges are present, the edges
 // are split and new points generated to prevent blurry edges (due to 
 // Gouraud shading).
+//
+// The polygon normals and their averages at the points are computed by
+// several threads (see NumberOfThreads), with the same result as a single
+// thread. When the polygons are known to be consistently ordered, turning
+// off Consistency and Splitting (and AutoOrientNormals) also saves building
+// the point-to-cell links and copying the polygons.
 
 // .SECTION Caveats
 // Normals are computed only for polygons and triangle strips. Normals are
@@ -114,6 +120,13 @@ public:
   vtkSetMacro(NonManifoldTraversal,int);
   vtkGetMacro(NonManifoldTraversal,int);
   vtkBooleanMacro(NonManifoldTraversal,int);
+
+  // Description:
+  // Set/Get the number of threads computing the polygon and point normals.
+  // Small meshes use fewer threads. The normals do not depend on this
+  // number. The default is vtkMultiThreader::GetGlobalDefaultNumberOfThreads().
+  vtkSetClampMacro(NumberOfThreads,int,1,VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads,int);
   
 protected:
   vtkPolyDataNormals();
@@ -131,6 +144,7 @@ protected:
   int ComputePointNormals;
   int ComputeCellNormals;
   int NumFlips;
+  int NumberOfThreads;
 
 private:
   vtkIdList *Wave;
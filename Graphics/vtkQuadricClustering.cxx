@@ -18,18 +18,28 @@
 #include "vtkCellData.h"
 #include "vtkExecutive.h"
 #include "vtkFeatureEdges.h"
+#include "vtkFloatArray.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkMath.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
 #include "vtkPolyData.h"
+#include "vtkStreamingDemandDrivenPipeline.h"
 #include "vtkTimerLog.h"
 #include "vtkTriangle.h"
+#include <vtksys/hash_map.hxx> // quadrics of the occupied bins
 #include <vtksys/hash_set.hxx> // keep track of inserted triangles
+#include <vtkstd/vector>
 
 vtkStandardNewMacro(vtkQuadricClustering);
 
+// Number of triangles whose quadrics are computed and accumulated together
+#define VTK_QUADRIC_CLUSTERING_TRIANGLES_PER_BATCH 100000
+// Minimum number of triangles or bins processed by each thread
+#define VTK_QUADRIC_CLUSTERING_MIN_ITEMS_PER_THREAD 10000
+
 //----------------------------------------------------------------------------
 // PIMPLd STL set for keeping track of inserted cells
 struct vtkQuadricClusteringIdTypeHash {
@@ -38,6 +48,393 @@ struct vtkQuadricClusteringIdTypeHash {
 class vtkQuadricClusteringCellSet : public vtksys::hash_set<vtkIdType, vtkQuadricClusteringIdTypeHash> {};
 typedef vtkQuadricClusteringCellSet::iterator vtkQuadricClusteringCellSetIterator;
 
+//----------------------------------------------------------------------------
+// The quadric of a bin.
+struct vtkQuadricClusteringPointQuadric
+{
+  vtkQuadricClusteringPointQuadric():VertexId(-1),Dimension(255),
+                                     InVertexCell(0) {}
+
+  vtkIdType VertexId;
+  // Dimension is supposed to be a flag representing the dimension of the
+  // cells contributing to the quadric.  Lines: 1, Triangles: 2 (and points
+  // 0 in the future?)
+  unsigned char Dimension;
+  // Set when the vertex of the bin is used by an output vertex cell.
+  unsigned char InVertexCell;
+  double Quadric[9];
+};
+
+//----------------------------------------------------------------------------
+// PIMPLd STL hash map holding the quadrics of the occupied bins only.  The
+// quadrics do not move when bins are added.
+class vtkQuadricClusteringBinMap : public vtksys::hash_map<vtkIdType, vtkQuadricClusteringPointQuadric, vtkQuadricClusteringIdTypeHash> {};
+typedef vtkQuadricClusteringBinMap::iterator vtkQuadricClusteringBinMapIterator;
+
+//----------------------------------------------------------------------------
+// Add a quadric to a bin, unless cells of a lower dimension already
+// contributed to it.  Cells of a lower dimension clear the quadric of
+// higher dimensional ones.
+static inline void vtkQuadricClusteringAddQuadric(
+  vtkQuadricClusteringPointQuadric *bin, unsigned char dimension,
+  const double quadric[9])
+{
+  int i;
+  if (bin->Dimension > dimension)
+    {
+    bin->Dimension = dimension;
+    for (i = 0; i < 9; i++)
+      {
+      bin->Quadric[i] = 0.0;
+      }
+    }
+  if (bin->Dimension == dimension)
+    {
+    for (i = 0; i < 9; i++)
+      {
+      bin->Quadric[i] += (quadric[i] * 100000000.0);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// The triangles of polygons and strips are processed in batches.  The bins
+// and quadrics of the triangles of a batch are computed by several threads.
+// The bins are then looked up and the output triangles inserted in order.
+// Finally, each thread adds the quadrics to the bins it owns, in triangle
+// order, so that the sums do not depend on the number of threads.  The
+// corners of each owner are listed while the quadrics are computed, so
+// that no thread goes through all the triangles.
+class vtkQuadricClusteringTriangles
+{
+public:
+  vtkQuadricClusteringTriangles(vtkQuadricClustering *filter,
+                                vtkPoints *points, int geometryFlag,
+                                vtkPolyData *input, vtkPolyData *output) :
+    Filter(filter), Points(points), GeometryFlag(geometryFlag),
+    Input(input), Output(output), NumberOfThreads(1)
+    {
+    }
+
+  // Queue a triangle of an input cell, and process the batch if it is full.
+  void Add(vtkIdType pt0, vtkIdType pt1, vtkIdType pt2, vtkIdType cellId)
+    {
+    this->PointIds.push_back(pt0);
+    this->PointIds.push_back(pt1);
+    this->PointIds.push_back(pt2);
+    this->CellIds.push_back(cellId);
+    if (this->CellIds.size() >= VTK_QUADRIC_CLUSTERING_TRIANGLES_PER_BATCH)
+      {
+      this->Flush();
+      }
+    }
+
+  void Flush();
+  void ComputeQuadrics(int threadId);
+  void AccumulateQuadrics(int threadId);
+
+private:
+  vtkQuadricClustering *Filter;
+  vtkPoints *Points;
+  int GeometryFlag;
+  vtkPolyData *Input;
+  vtkPolyData *Output;
+  int NumberOfThreads;
+
+  // three point ids per triangle and the input cell of each triangle
+  vtkstd::vector<vtkIdType> PointIds;
+  vtkstd::vector<vtkIdType> CellIds;
+  // three bin ids, three bins (NULL when the triangle is skipped) and the
+  // quadric of each triangle
+  vtkstd::vector<vtkIdType> BinIds;
+  vtkstd::vector<vtkQuadricClusteringPointQuadric *> Bins;
+  vtkstd::vector<double> Quadrics;
+  // with several threads, Corners[t*NumberOfThreads + p] holds the corners
+  // of the triangles of thread t whose bins are owned by thread p
+  vtkstd::vector<vtkstd::vector<vtkIdType> > Corners;
+};
+
+//----------------------------------------------------------------------------
+static VTK_THREAD_RETURN_TYPE vtkQuadricClusteringComputeQuadrics(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  static_cast<vtkQuadricClusteringTriangles *>(info->UserData)->
+    ComputeQuadrics(info->ThreadID);
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+static VTK_THREAD_RETURN_TYPE vtkQuadricClusteringAccumulateQuadrics(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  static_cast<vtkQuadricClusteringTriangles *>(info->UserData)->
+    AccumulateQuadrics(info->ThreadID);
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+// Choose the number of threads processing numItems items.
+static int vtkQuadricClusteringNumberOfThreads(int numThreads,
+                                               vtkIdType numItems)
+{
+  int maxThreads = vtkMultiThreader::GetGlobalMaximumNumberOfThreads();
+  if (maxThreads > 0 && numThreads > maxThreads)
+    {
+    numThreads = maxThreads;
+    }
+  if (numThreads > numItems / VTK_QUADRIC_CLUSTERING_MIN_ITEMS_PER_THREAD)
+    {
+    numThreads = static_cast<int>(
+      numItems / VTK_QUADRIC_CLUSTERING_MIN_ITEMS_PER_THREAD);
+    }
+  return (numThreads < 1 ? 1 : numThreads);
+}
+
+//----------------------------------------------------------------------------
+// Hash the points and compute the quadric of a contiguous range of
+// triangles.
+void vtkQuadricClusteringTriangles::ComputeQuadrics(int threadId)
+{
+  vtkIdType numTris = static_cast<vtkIdType>(this->CellIds.size());
+  vtkIdType begin = numTris*threadId/this->NumberOfThreads;
+  vtkIdType end = numTris*(threadId + 1)/this->NumberOfThreads;
+  double pts[3][3], quadric4x4[4][4];
+  int i;
+  vtkstd::vector<vtkIdType> *corners = NULL;
+  if (this->NumberOfThreads > 1)
+    {
+    corners = &this->Corners[threadId*this->NumberOfThreads];
+    for (i = 0; i < this->NumberOfThreads; i++)
+      {
+      corners[i].clear();
+      }
+    }
+
+  for (vtkIdType triId = begin; triId < end; triId++)
+    {
+    vtkIdType *binIds = &this->BinIds[3*triId];
+    for (i = 0; i < 3; i++)
+      {
+      this->Points->GetPoint(this->PointIds[3*triId + i], pts[i]);
+      binIds[i] = this->Filter->HashPoint(pts[i]);
+      }
+    // Only triangles that traverse three bins are added when the internal
+    // triangles are not used.
+    if (this->Filter->UseInternalTriangles == 0 &&
+        (binIds[0] == binIds[1] || binIds[0] == binIds[2] ||
+         binIds[1] == binIds[2]))
+      {
+      continue;
+      }
+    vtkTriangle::ComputeQuadric(pts[0], pts[1], pts[2], quadric4x4);
+    double *quadric = &this->Quadrics[9*triId];
+    quadric[0] = quadric4x4[0][0];
+    quadric[1] = quadric4x4[0][1];
+    quadric[2] = quadric4x4[0][2];
+    quadric[3] = quadric4x4[0][3];
+    quadric[4] = quadric4x4[1][1];
+    quadric[5] = quadric4x4[1][2];
+    quadric[6] = quadric4x4[1][3];
+    quadric[7] = quadric4x4[2][2];
+    quadric[8] = quadric4x4[2][3];
+    if (corners)
+      {
+      for (i = 0; i < 3; i++)
+        {
+        corners[binIds[i] % this->NumberOfThreads].push_back(3*triId + i);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Add the quadrics of the triangles to the bins owned by a thread.
+void vtkQuadricClusteringTriangles::AccumulateQuadrics(int threadId)
+{
+  if (this->NumberOfThreads == 1)
+    {
+    vtkIdType numCorners = static_cast<vtkIdType>(this->Bins.size());
+    for (vtkIdType corner = 0; corner < numCorners; corner++)
+      {
+      if (this->Bins[corner])
+        {
+        vtkQuadricClusteringAddQuadric(this->Bins[corner], 2,
+                                       &this->Quadrics[9*(corner/3)]);
+        }
+      }
+    return;
+    }
+
+  // the corners of the threads come in triangle order
+  for (int t = 0; t < this->NumberOfThreads; t++)
+    {
+    vtkstd::vector<vtkIdType> &corners =
+      this->Corners[t*this->NumberOfThreads + threadId];
+    for (size_t i = 0; i < corners.size(); i++)
+      {
+      vtkIdType corner = corners[i];
+      vtkQuadricClusteringAddQuadric(this->Bins[corner], 2,
+                                     &this->Quadrics[9*(corner/3)]);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkQuadricClusteringTriangles::Flush()
+{
+  vtkIdType numTris = static_cast<vtkIdType>(this->CellIds.size());
+  if (numTris == 0)
+    {
+    return;
+    }
+  this->BinIds.resize(3*numTris);
+  this->Bins.resize(3*numTris);
+  this->Quadrics.resize(9*numTris);
+
+  vtkMultiThreader *threader = NULL;
+  this->NumberOfThreads = vtkQuadricClusteringNumberOfThreads(
+    this->Filter->NumberOfThreads, numTris);
+  if (this->NumberOfThreads > 1)
+    {
+    this->Corners.resize(this->NumberOfThreads*this->NumberOfThreads);
+    threader = vtkMultiThreader::New();
+    threader->SetNumberOfThreads(this->NumberOfThreads);
+    threader->SetSingleMethod(vtkQuadricClusteringComputeQuadrics, this);
+    threader->SingleMethodExecute();
+    }
+  else
+    {
+    this->ComputeQuadrics(0);
+    }
+
+  // Look up (or create) the bins and insert the output triangles, in order.
+  // Neighboring triangles share bins: the last bins found are cached.
+  vtkQuadricClusteringBinMap *bins = this->Filter->QuadricArray;
+  vtkIdType cachedBinIds[64];
+  vtkQuadricClusteringPointQuadric *cachedBins[64];
+  vtkIdType triPtIds[3];
+  int i;
+  for (i = 0; i < 64; i++)
+    {
+    cachedBinIds[i] = -1;
+    }
+  for (vtkIdType triId = 0; triId < numTris; triId++)
+    {
+    vtkIdType *binIds = &this->BinIds[3*triId];
+    vtkQuadricClusteringPointQuadric **triBins = &this->Bins[3*triId];
+    if (this->Filter->UseInternalTriangles == 0 &&
+        (binIds[0] == binIds[1] || binIds[0] == binIds[2] ||
+         binIds[1] == binIds[2]))
+      {
+      triBins[0] = triBins[1] = triBins[2] = NULL;
+      continue;
+      }
+    for (i = 0; i < 3; i++)
+      {
+      int slot = static_cast<int>(binIds[i] & 63);
+      if (cachedBinIds[slot] != binIds[i])
+        {
+        cachedBinIds[slot] = binIds[i];
+        cachedBins[slot] = &(*bins)[binIds[i]];
+        }
+      triBins[i] = cachedBins[slot];
+      }
+    if (this->GeometryFlag)
+      {
+      for (i = 0; i < 3; i++)
+        {
+        // Get the vertex from each bin.
+        if (triBins[i]->VertexId == -1)
+          {
+          triBins[i]->VertexId = this->Filter->NumberOfBinsUsed;
+          this->Filter->NumberOfBinsUsed++;
+          }
+        triPtIds[i] = triBins[i]->VertexId;
+        }
+      this->Filter->InsertTriangle(binIds, triPtIds, this->CellIds[triId],
+                                   this->Input, this->Output);
+      }
+    }
+
+  if (threader)
+    {
+    threader->SetSingleMethod(vtkQuadricClusteringAccumulateQuadrics, this);
+    threader->SingleMethodExecute();
+    threader->Delete();
+    }
+  else
+    {
+    this->AccumulateQuadrics(0);
+    }
+
+  this->PointIds.clear();
+  this->CellIds.clear();
+}
+
+//----------------------------------------------------------------------------
+// The representative points of the bins used by the output, computed by
+// several threads.  Each point is written at the vertex id of its bin.
+class vtkQuadricClusteringPoints
+{
+public:
+  void ComputePoints(int threadId);
+
+  vtkQuadricClustering *Filter;
+  int NumberOfThreads;
+  vtkstd::vector<vtkIdType> BinIds;
+  vtkstd::vector<vtkQuadricClusteringPointQuadric *> Bins;
+  float *Points;
+};
+
+//----------------------------------------------------------------------------
+static VTK_THREAD_RETURN_TYPE vtkQuadricClusteringComputePoints(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  static_cast<vtkQuadricClusteringPoints *>(info->UserData)->
+    ComputePoints(info->ThreadID);
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+void vtkQuadricClusteringPoints::ComputePoints(int threadId)
+{
+  vtkIdType numBins = static_cast<vtkIdType>(this->Bins.size());
+  vtkIdType begin = numBins*threadId/this->NumberOfThreads;
+  vtkIdType end = numBins*(threadId + 1)/this->NumberOfThreads;
+  double step = (double)(end - begin) / 10.0;
+  if (step < 1000.0)
+    {
+    step = 1000.0;
+    }
+  double cstep = 0;
+  double newPt[3];
+
+  for (vtkIdType i = begin; i < end; i++)
+    {
+    // only the calling thread reports progress
+    if (threadId == 0 && cstep > step)
+      {
+      cstep = 0;
+      this->Filter->UpdateProgress(0.8 + 0.2*(i - begin)/(end - begin));
+      if (this->Filter->GetAbortExecute())
+        {
+        break;
+        }
+      }
+    ++cstep;
+
+    vtkQuadricClusteringPointQuadric *bin = this->Bins[i];
+    this->Filter->ComputeRepresentativePoint(bin->Quadric, this->BinIds[i],
+                                             newPt);
+    float *pt = this->Points + 3*bin->VertexId;
+    pt[0] = static_cast<float>(newPt[0]);
+    pt[1] = static_cast<float>(newPt[1]);
+    pt[2] = static_cast<float>(newPt[2]);
+    }
+}
 
 //----------------------------------------------------------------------------
 // Construct with default NumberOfDivisions to 50, DivisionSpacing to 1
@@ -53,6 +450,10 @@ vtkQuadricClustering::vtkQuadricClustering()
   this->NumberOfXDivisions = 50;
   this->NumberOfYDivisions = 50;
   this->NumberOfZDivisions = 50;
+  this->NumberOfDivisions[0] = 50;
+  this->NumberOfDivisions[1] = 50;
+  this->NumberOfDivisions[2] = 50;
+  this->SliceSize = 2500;
   this->QuadricArray = NULL;
   this->NumberOfBinsUsed = 0;
   this->AbortExecute = 0;
@@ -79,6 +480,7 @@ vtkQuadricClustering::vtkQuadricClustering()
 
   this->OutputTriangleArray = NULL;
   this->OutputLines = NULL;
+  this->OutputVerts = NULL;
 
   // Used for matching boundaries.
   this->FeatureEdges = vtkFeatureEdges::New();
@@ -89,6 +491,9 @@ vtkQuadricClustering::vtkQuadricClustering()
   this->InCellCount = this->OutCellCount = 0;
   this->CopyCellData = 0;
 
+  this->NumberOfStreamDivisions = 1;
+  this->NumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+
   this->GetInformation()->Set(vtkAlgorithm::PRESERVES_RANGES(), 1);
   this->GetInformation()->Set(vtkAlgorithm::PRESERVES_BOUNDS(), 1);
 }
@@ -107,7 +512,7 @@ vtkQuadricClustering::~vtkQuadricClustering()
     }
   if (this->QuadricArray)
     {
-    delete [] this->QuadricArray;
+    delete this->QuadricArray;
     this->QuadricArray = NULL;
     }
   if (this->OutputTriangleArray)
@@ -120,6 +525,11 @@ vtkQuadricClustering::~vtkQuadricClustering()
     this->OutputLines->Delete();
     this->OutputLines = NULL;
     }
+  if (this->OutputVerts)
+    {
+    this->OutputVerts->Delete();
+    this->OutputVerts = NULL;
+    }
 }
 
 //----------------------------------------------------------------------------
@@ -144,6 +554,11 @@ int vtkQuadricClustering::RequestData(
 
   vtkTimerLog *tlog=NULL;
 
+  if (inInfo && this->NumberOfStreamDivisions > 1)
+    {
+    return this->StreamPieces(inInfo, output);
+    }
+
   if (!input || (input->GetNumberOfPoints() == 0))
     {
     // The user may be calling StartAppend, Append, and EndAppend explicitly.
@@ -191,7 +606,6 @@ int vtkQuadricClustering::RequestData(
 
   this->StartAppend(input->GetBounds());
   this->UpdateProgress(.2);
-  this->SliceSize = this->NumberOfDivisions[0]*this->NumberOfDivisions[1];
 
   this->Append(input);
   if (this->UseFeatureEdges)
@@ -211,7 +625,7 @@ int vtkQuadricClustering::RequestData(
   // Free up some memory.
   if (this->QuadricArray)
     {
-    delete [] this->QuadricArray;
+    delete this->QuadricArray;
     this->QuadricArray = NULL;
     } 
 
@@ -225,6 +639,136 @@ int vtkQuadricClustering::RequestData(
   return 1;
 }
 
+//----------------------------------------------------------------------------
+int vtkQuadricClustering::RequestUpdateExtent(
+  vtkInformation *vtkNotUsed(request),
+  vtkInformationVector **inputVector,
+  vtkInformationVector *outputVector)
+{
+  // get the info objects
+  vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
+  vtkInformation *outInfo = outputVector->GetInformationObject(0);
+
+  // When streaming, only the first piece is requested here.  The other
+  // pieces are requested by RequestData.
+  if (inInfo && this->NumberOfStreamDivisions > 1)
+    {
+    int outPiece = outInfo->Get(
+      vtkStreamingDemandDrivenPipeline::UPDATE_PIECE_NUMBER());
+    int outNumPieces = outInfo->Get(
+      vtkStreamingDemandDrivenPipeline::UPDATE_NUMBER_OF_PIECES());
+    inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_PIECE_NUMBER(),
+                outPiece * this->NumberOfStreamDivisions);
+    inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_NUMBER_OF_PIECES(),
+                outNumPieces * this->NumberOfStreamDivisions);
+    inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_NUMBER_OF_GHOST_LEVELS(), 0);
+    }
+
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+// Update the input with each of the NumberOfStreamDivisions pieces in turn
+// and append it.  Only one piece is in memory at a time, besides the
+// quadrics of the occupied bins.
+int vtkQuadricClustering::StreamPieces(vtkInformation *inInfo,
+                                       vtkPolyData *output)
+{
+  vtkPolyData *input = vtkPolyData::SafeDownCast(
+    inInfo->Get(vtkDataObject::DATA_OBJECT()));
+  if (!input)
+    {
+    return 1;
+    }
+  int numPieces = this->NumberOfStreamDivisions;
+  int outPiece = output->GetUpdatePiece();
+  int outNumPieces = output->GetUpdateNumberOfPieces();
+  int i, j;
+  double bounds[6];
+
+  // The bins cover the whole input.  When its bounds are not provided by
+  // the pipeline, the pieces are read a first time to compute them.
+  double *wholeBounds = 
+    inInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_BOUNDING_BOX());
+  if (wholeBounds && wholeBounds[0] <= wholeBounds[1] &&
+      wholeBounds[2] <= wholeBounds[3] && wholeBounds[4] <= wholeBounds[5])
+    {
+    for (j = 0; j < 6; j++)
+      {
+      bounds[j] = wholeBounds[j];
+      }
+    }
+  else
+    {
+    bounds[0] = bounds[2] = bounds[4] = VTK_DOUBLE_MAX;
+    bounds[1] = bounds[3] = bounds[5] = -VTK_DOUBLE_MAX;
+    for (i = 0; i < numPieces; i++)
+      {
+      inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_PIECE_NUMBER(),
+                  outPiece * numPieces + i);
+      inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_NUMBER_OF_PIECES(),
+                  outNumPieces * numPieces);
+      input->Update();
+      if (input->GetNumberOfPoints() > 0)
+        {
+        double *pieceBounds = input->GetBounds();
+        for (j = 0; j < 3; j++)
+          {
+          bounds[2*j] = (pieceBounds[2*j] < bounds[2*j] ?
+                         pieceBounds[2*j] : bounds[2*j]);
+          bounds[2*j+1] = (pieceBounds[2*j+1] > bounds[2*j+1] ?
+                           pieceBounds[2*j+1] : bounds[2*j+1]);
+          }
+        }
+      }
+    if (bounds[0] > bounds[1])
+      {
+      // Empty input.
+      return 1;
+      }
+    }
+
+  // The size of the whole input is unknown: the divisions are used as is.
+  this->NumberOfDivisions[0] = this->NumberOfXDivisions;
+  this->NumberOfDivisions[1] = this->NumberOfYDivisions;
+  this->NumberOfDivisions[2] = this->NumberOfZDivisions;
+  if (this->UseInputPoints)
+    {
+    vtkWarningMacro("UseInputPoints is ignored when streaming.");
+    }
+
+  int started = 0;
+  for (i = 0; i < numPieces && !this->GetAbortExecute(); i++)
+    {
+    inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_PIECE_NUMBER(),
+                outPiece * numPieces + i);
+    inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_NUMBER_OF_PIECES(),
+                outNumPieces * numPieces);
+    input->Update();
+    if (input->GetNumberOfPoints() == 0 || input->CheckAttributes())
+      {
+      continue;
+      }
+    if (!started)
+      {
+      this->StartAppend(bounds);
+      started = 1;
+      }
+    this->Append(input);
+    if (this->UseFeatureEdges)
+      { // Adjust bin points that contain boundary edges.
+      this->AppendFeatureQuadrics(input, output);
+      }
+    }
+
+  if (started)
+    {
+    this->EndAppend();
+    }
+
+  return 1;
+}
+
 //----------------------------------------------------------------------------
 void vtkQuadricClustering::StartAppend(double *bounds)
 {
@@ -288,9 +832,15 @@ void vtkQuadricClustering::StartAppend(double *bounds)
     this->OutputLines = NULL;
     //vtkWarningMacro("Array already created.  Did you call EndAppend?");
     }
+  if (this->OutputVerts)
+    {
+    this->OutputVerts->Delete();
+    this->OutputVerts = NULL;
+    }
 
   this->OutputTriangleArray = vtkCellArray::New();
   this->OutputLines = vtkCellArray::New();
+  this->OutputVerts = vtkCellArray::New();
 
   this->XBinSize = (this->Bounds[1]-this->Bounds[0])/this->NumberOfDivisions[0];
   this->YBinSize = (this->Bounds[3]-this->Bounds[2])/this->NumberOfDivisions[1];
@@ -299,22 +849,16 @@ void vtkQuadricClustering::StartAppend(double *bounds)
   this->XBinStep = (this->XBinSize > 0.0) ? (1.0/this->XBinSize) : 0.0;
   this->YBinStep = (this->YBinSize > 0.0) ? (1.0/this->YBinSize) : 0.0;
   this->ZBinStep = (this->ZBinSize > 0.0) ? (1.0/this->ZBinSize) : 0.0;
+  this->SliceSize = this->NumberOfDivisions[0]*this->NumberOfDivisions[1];
 
+  // Only the bins that are hit are stored.
   this->NumberOfBinsUsed = 0;
   if (this->QuadricArray)
     {
-    delete [] this->QuadricArray;
+    delete this->QuadricArray;
     this->QuadricArray = NULL;
     }
-  this->QuadricArray = 
-    new vtkQuadricClustering::PointQuadric[this->NumberOfDivisions[0] *
-                                          this->NumberOfDivisions[1] *
-                                          this->NumberOfDivisions[2]];
-  if (this->QuadricArray == NULL)
-    {
-    vtkErrorMacro("Could not allocate quadric grid.");
-    return;
-    }
+  this->QuadricArray = new vtkQuadricClusteringBinMap;
 
   vtkInformation *inInfo = this->GetExecutive()->GetInputInformation(0, 0);
   vtkInformation *outInfo = this->GetExecutive()->GetOutputInformation(0);
@@ -343,7 +887,8 @@ void vtkQuadricClustering::Append(vtkPolyData *pd)
   vtkPoints *inputPoints = pd->GetPoints();
   
   // Check for mis-use of the Append methods.
-  if (this->OutputTriangleArray == NULL || this->OutputLines == NULL)
+  if (this->OutputTriangleArray == NULL || this->OutputLines == NULL ||
+      this->OutputVerts == NULL)
     {
     vtkDebugMacro("Missing Array:  Did you call StartAppend?");
     return;
@@ -354,10 +899,15 @@ void vtkQuadricClustering::Append(vtkPolyData *pd)
   vtkPolyData *output = vtkPolyData::SafeDownCast(
     outInfo->Get(vtkDataObject::DATA_OBJECT()));
 
+  // The cell data of the output cells is copied from the cells of this
+  // piece.
+  this->InCellCount = 0;
+
   inputVerts = pd->GetVerts();
   if (inputVerts)
     {
     this->AddVertices(inputVerts, inputPoints, 1, pd, output);
+    this->AppendVertexGeometry(pd, output);
     }
   this->UpdateProgress(.40);
 
@@ -390,8 +940,8 @@ void vtkQuadricClustering::AddPolygons(vtkCellArray *polys, vtkPoints *points,
   int j;
   vtkIdType *ptIds = 0;
   vtkIdType numPts = 0;
-  double pts0[3], pts1[3], pts2[3];
-  vtkIdType binIds[3];
+  vtkQuadricClusteringTriangles triangles(this, points, geometryFlag,
+                                          input, output);
 
   double total = polys->GetNumberOfCells();
   double curr = 0;
@@ -404,15 +954,9 @@ void vtkQuadricClustering::AddPolygons(vtkCellArray *polys, vtkPoints *points,
 
   for ( polys->InitTraversal(); polys->GetNextCell(numPts, ptIds); )
     {
-    points->GetPoint(ptIds[0],pts0);
-    binIds[0] = this->HashPoint(pts0);
     for (j=0; j < numPts-2; j++)//creates triangles; assumes poly is convex
       {
-      points->GetPoint(ptIds[j+1],pts1);
-      binIds[1] = this->HashPoint(pts1);
-      points->GetPoint(ptIds[j+2],pts2);
-      binIds[2] = this->HashPoint(pts2);
-      this->AddTriangle(binIds, pts0, pts1, pts2, geometryFlag, input, output);
+      triangles.Add(ptIds[0], ptIds[j+1], ptIds[j+2], this->InCellCount);
       }
     ++this->InCellCount;
     if ( curr > cstep )
@@ -422,6 +966,7 @@ void vtkQuadricClustering::AddPolygons(vtkCellArray *polys, vtkPoints *points,
       }
     curr += 1;
     }//for all polygons
+  triangles.Flush();
 }
 
 //----------------------------------------------------------------------------
@@ -432,33 +977,28 @@ void vtkQuadricClustering::AddStrips(vtkCellArray *strips, vtkPoints *points,
   int j;
   vtkIdType *ptIds = 0;
   vtkIdType numPts = 0;
-  double pts[3][3];
-  vtkIdType binIds[3];
+  vtkIdType triPtIds[3];
   int odd;  // Used to flip order of every other triangle in a strip.
+  vtkQuadricClusteringTriangles triangles(this, points, geometryFlag,
+                                          input, output);
 
   for ( strips->InitTraversal(); strips->GetNextCell(numPts, ptIds); )
     {
-    points->GetPoint(ptIds[0], pts[0]);
-    binIds[0] = this->HashPoint(pts[0]);
-    points->GetPoint(ptIds[1], pts[1]);
-    binIds[1] = this->HashPoint(pts[1]);
+    triPtIds[0] = ptIds[0];
+    triPtIds[1] = ptIds[1];
     // This internal loop handles triangle strips.
     odd = 0;
     for (j = 2; j < numPts; ++j)
       {
-      points->GetPoint(ptIds[j], pts[2]);
-      binIds[2] = this->HashPoint(pts[2]);
-      this->AddTriangle(binIds, pts[0], pts[1], pts[2], geometryFlag, input,
-                        output);
-      pts[odd][0] = pts[2][0];
-      pts[odd][1] = pts[2][1];
-      pts[odd][2] = pts[2][2];
-      binIds[odd] = binIds[2];
+      triPtIds[2] = ptIds[j];
+      triangles.Add(triPtIds[0], triPtIds[1], triPtIds[2], this->InCellCount);
+      triPtIds[odd] = triPtIds[2];
       // Toggle odd.
       odd = odd ? 0 : 1;
       }
     ++this->InCellCount;
     }
+  triangles.Flush();
 }
 
 //----------------------------------------------------------------------------
@@ -488,7 +1028,7 @@ void vtkQuadricClustering::AddTriangle(vtkIdType *binIds, double *pt0, double *p
   int i;
   vtkIdType triPtIds[3];
   double quadric[9], quadric4x4[4][4];
-  vtkIdType minIdx, midIdx, maxIdx, idx;
+  vtkQuadricClusteringPointQuadric *bin;
 
   // Special condition for fast execution.
   // Only add triangles that traverse three bins to quadrics.
@@ -514,19 +1054,11 @@ void vtkQuadricClustering::AddTriangle(vtkIdType *binIds, double *pt0, double *p
   quadric[8] = quadric4x4[2][3];
 
   // Add the quadric to each of the three corner bins.
+  // Points and segments supercede triangles.
   for (i = 0; i < 3; ++i)
     {
-    // If the current quadric is not initialized, then clear it out.
-    if (this->QuadricArray[binIds[i]].Dimension > 2)
-      {
-      this->QuadricArray[binIds[i]].Dimension = 2; 
-      // Initialize the coeff
-      this->InitializeQuadric(this->QuadricArray[binIds[i]].Quadric);
-      }
-    if (this->QuadricArray[binIds[i]].Dimension == 2)
-      { // Points and segments supercede triangles.
-      this->AddQuadric(binIds[i], quadric);
-      }
+    vtkQuadricClusteringAddQuadric(&(*this->QuadricArray)[binIds[i]], 2,
+                                   quadric);
     }
 
   if (geometryFlag)
@@ -535,86 +1067,99 @@ void vtkQuadricClustering::AddTriangle(vtkIdType *binIds, double *pt0, double *p
     for (i = 0; i < 3; i++)
       {
       // Get the vertex from each bin.
-      if (this->QuadricArray[binIds[i]].VertexId == -1)
+      bin = &(*this->QuadricArray)[binIds[i]];
+      if (bin->VertexId == -1)
         {
-        this->QuadricArray[binIds[i]].VertexId = this->NumberOfBinsUsed;
+        bin->VertexId = this->NumberOfBinsUsed;
         this->NumberOfBinsUsed++;
         }
-      triPtIds[i] = this->QuadricArray[binIds[i]].VertexId;
+      triPtIds[i] = bin->VertexId;
       }
-    // This comparison could just as well be on triPtIds.
-    if (binIds[0] != binIds[1] && binIds[0] != binIds[2] &&
-        binIds[1] != binIds[2])
+    this->InsertTriangle(binIds, triPtIds, this->InCellCount, input, output);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkQuadricClustering::InsertTriangle(vtkIdType *binIds,
+                                          vtkIdType *triPtIds,
+                                          vtkIdType inCellId,
+                                          vtkPolyData *input,
+                                          vtkPolyData *output)
+{
+  vtkIdType minIdx, midIdx, maxIdx, idx;
+
+  // This comparison could just as well be on triPtIds.
+  if (binIds[0] != binIds[1] && binIds[0] != binIds[2] &&
+      binIds[1] != binIds[2])
+    {
+    if ( this->PreventDuplicateCells )
       {
-      if ( this->PreventDuplicateCells )
+      minIdx = ( binIds[0]<binIds[1] ? (binIds[0]<binIds[2] ? 0 : 2) :
+                 (binIds[1]<binIds[2] ? 1 : 2) );
+      midIdx = 0;
+      maxIdx = 0;
+      switch ( minIdx )
         {
-        minIdx = ( binIds[0]<binIds[1] ? (binIds[0]<binIds[2] ? 0 : 2) :
-                   (binIds[1]<binIds[2] ? 1 : 2) );
-        midIdx = 0;
-        maxIdx = 0;
-        switch ( minIdx )
-          {
-          case 0:
-            if ( binIds[1] > binIds[2] )
-              {
-              maxIdx = 1;
-              midIdx = 2;
-              }
-            else
-              {
-              maxIdx = 2;
-              midIdx = 1;
-              }
-            break;
-          case 1:
-            if ( binIds[0] > binIds[2] )
-              {
-              maxIdx = 0;
-              midIdx = 2;
-              }
-            else
-              {
-              maxIdx = 2;
-              midIdx = 0;
-              }
-            break;
-          case 2:
-            if ( binIds[0] > binIds[1] )
-              {
-              maxIdx = 0;
-              midIdx = 1;
-              }
-            else
-              {
-              maxIdx = 1;
-              midIdx = 0;
-              }
-            break;
-          }
-        idx = binIds[minIdx] + this->NumberOfBins*binIds[midIdx] + 
-              this->NumberOfBins*this->NumberOfBins*binIds[maxIdx];
-        if ( this->CellSet->find(idx) == this->CellSet->end() )
-          {
-          this->CellSet->insert(idx);
-          this->OutputTriangleArray->InsertNextCell(3, triPtIds);
-          if (this->CopyCellData && input)
+        case 0:
+          if ( binIds[1] > binIds[2] )
+            {
+            maxIdx = 1;
+            midIdx = 2;
+            }
+          else
             {
-            output->GetCellData()->
-              CopyData(input->GetCellData(), this->InCellCount,this->OutCellCount++);
-            }//if cell data
-          }//if not a duplicate
+            maxIdx = 2;
+            midIdx = 1;
+            }
+          break;
+        case 1:
+          if ( binIds[0] > binIds[2] )
+            {
+            maxIdx = 0;
+            midIdx = 2;
+            }
+          else
+            {
+            maxIdx = 2;
+            midIdx = 0;
+            }
+          break;
+        case 2:
+          if ( binIds[0] > binIds[1] )
+            {
+            maxIdx = 0;
+            midIdx = 1;
+            }
+          else
+            {
+            maxIdx = 1;
+            midIdx = 0;
+            }
+          break;
         }
-      else //don't check for duplicates
+      idx = binIds[minIdx] + this->NumberOfBins*binIds[midIdx] + 
+            this->NumberOfBins*this->NumberOfBins*binIds[maxIdx];
+      if ( this->CellSet->find(idx) == this->CellSet->end() )
         {
+        this->CellSet->insert(idx);
         this->OutputTriangleArray->InsertNextCell(3, triPtIds);
         if (this->CopyCellData && input)
           {
           output->GetCellData()->
-            CopyData(input->GetCellData(), this->InCellCount,this->OutCellCount++);
+            CopyData(input->GetCellData(), inCellId, this->OutCellCount++);
           }//if cell data
-        }//don't check for duplicates
-      }//if not duplicate vertices
-    }//if this should be inserted
+        }//if not a duplicate
+      }
+    else //don't check for duplicates
+      {
+      this->OutputTriangleArray->InsertNextCell(3, triPtIds);
+      if (this->CopyCellData && input)
+        {
+        output->GetCellData()->
+          CopyData(input->GetCellData(), inCellId, this->OutCellCount++);
+        }//if cell data
+      }//don't check for duplicates
+    }//if not duplicate vertices
 }
 
 //----------------------------------------------------------------------------
@@ -720,17 +1265,9 @@ void vtkQuadricClustering::AddEdge(vtkIdType *binIds, double *pt0, double *pt1,
 
   for (i = 0; i < 2; ++i)
     {
-    // If the current quadric is from triangles (or not initialized), then clear it out.
-    if (this->QuadricArray[binIds[i]].Dimension > 1)
-      {
-      this->QuadricArray[binIds[i]].Dimension = 1; 
-      // Initialize the coeff
-      this->InitializeQuadric(this->QuadricArray[binIds[i]].Quadric);
-      }
-    if (this->QuadricArray[binIds[i]].Dimension == 1)
-      { // Points supercede segements.
-      this->AddQuadric(binIds[i], q);
-      }
+    // If the current quadric is from triangles (or not initialized), then
+    // clear it out.  Points supercede segements.
+    vtkQuadricClusteringAddQuadric(&(*this->QuadricArray)[binIds[i]], 1, q);
     }
 
   if (geometryFlag)
@@ -739,12 +1276,14 @@ void vtkQuadricClustering::AddEdge(vtkIdType *binIds, double *pt0, double *pt1,
     for (i = 0; i < 2; i++)
       {
       // Get the vertex from each bin.
-      if (this->QuadricArray[binIds[i]].VertexId == -1)
+      vtkQuadricClusteringPointQuadric *bin =
+        &(*this->QuadricArray)[binIds[i]];
+      if (bin->VertexId == -1)
         {
-        this->QuadricArray[binIds[i]].VertexId = this->NumberOfBinsUsed;
+        bin->VertexId = this->NumberOfBinsUsed;
         this->NumberOfBinsUsed++;
         }
-      edgePtIds[i] = this->QuadricArray[binIds[i]].VertexId;
+      edgePtIds[i] = bin->VertexId;
       }
     // This comparison could just as well be on edgePtIds.
     if (binIds[0] != binIds[1])
@@ -838,25 +1377,17 @@ void vtkQuadricClustering::AddVertex(vtkIdType binId, double *pt,
   q[8] = -pt[2];
 
   // If the current quadric is from triangles, edges (or not initialized),
-  // then clear it out.
-  if (this->QuadricArray[binId].Dimension > 0)
-    {
-    this->QuadricArray[binId].Dimension = 0; 
-    // Initialize the coeff
-    this->InitializeQuadric(this->QuadricArray[binId].Quadric);
-    }
-  if (this->QuadricArray[binId].Dimension == 0)
-    { // Points supercede all other types of quadrics.
-    this->AddQuadric(binId, q);
-    }
+  // then clear it out.  Points supercede all other types of quadrics.
+  vtkQuadricClusteringPointQuadric *bin = &(*this->QuadricArray)[binId];
+  vtkQuadricClusteringAddQuadric(bin, 0, q);
 
   if (geometryFlag)
     {
     // Now add the vert to the geometry.
     // Get the vertex from the bin.
-    if (this->QuadricArray[binId].VertexId == -1)
+    if (bin->VertexId == -1)
       {
-      this->QuadricArray[binId].VertexId = this->NumberOfBinsUsed;
+      bin->VertexId = this->NumberOfBinsUsed;
       this->NumberOfBinsUsed++;
 
       if (this->CopyCellData && input)
@@ -872,7 +1403,7 @@ void vtkQuadricClustering::AddVertex(vtkIdType binId, double *pt,
 //----------------------------------------------------------------------------
 void vtkQuadricClustering::AddQuadric(vtkIdType binId, double quadric[9])
 {
-  double *q = this->QuadricArray[binId].Quadric;
+  double *q = (*this->QuadricArray)[binId].Quadric;
   
   for (int i=0; i<9; i++)
     {
@@ -928,32 +1459,15 @@ vtkIdType vtkQuadricClustering::HashPoint(double point[3])
 //----------------------------------------------------------------------------
 void vtkQuadricClustering::EndAppend()
 {
-  vtkInformation *inInfo = this->GetExecutive()->GetInputInformation(0, 0);
   vtkInformation *outInfo = this->GetExecutive()->GetOutputInformation(0);
-  vtkPolyData *input = 0;
-  if (inInfo)
-    {
-    input = vtkPolyData::SafeDownCast(
-      inInfo->Get(vtkDataObject::DATA_OBJECT()));
-    }
   vtkPolyData *output = vtkPolyData::SafeDownCast(
     outInfo->Get(vtkDataObject::DATA_OBJECT()));
 
-  vtkIdType i, numBuckets;
-  int abortExecute=0;
   vtkPoints *outputPoints;
-  double newPt[3];
-  numBuckets = this->NumberOfDivisions[0] * this->NumberOfDivisions[1] * 
-                this->NumberOfDivisions[2];
-  double step = (double)numBuckets / 10.0;
-  if (step < 1000.0)
-    {
-    step = 1000.0;
-    }
-  double cstep = 0;
   
   // Check for mis use of the Append methods.
-  if (this->OutputTriangleArray == NULL || this->OutputLines == NULL)
+  if (this->OutputTriangleArray == NULL || this->OutputLines == NULL ||
+      this->OutputVerts == NULL)
     {
     vtkDebugMacro("Missing Array:  Did you call StartAppend?");
     return;
@@ -966,24 +1480,38 @@ void vtkQuadricClustering::EndAppend()
     this->CellSet = NULL;
     }
 
-  // Compute the representative points for each bin
-  outputPoints = vtkPoints::New();
-  for (i = 0; !abortExecute && i < numBuckets; i++ )
+  // Compute the representative points for each bin used by the output.
+  vtkQuadricClusteringPoints points;
+  points.Filter = this;
+  points.BinIds.reserve(this->NumberOfBinsUsed);
+  points.Bins.reserve(this->NumberOfBinsUsed);
+  for (vtkQuadricClusteringBinMapIterator it = this->QuadricArray->begin();
+       it != this->QuadricArray->end(); ++it)
     {
-    if (cstep > step)
+    if (it->second.VertexId != -1)
       {
-      cstep = 0;
-      vtkDebugMacro(<<"Finding point in bin #" << i);
-      this->UpdateProgress (0.8+0.2*i/numBuckets);
-      abortExecute = this->GetAbortExecute();
+      points.BinIds.push_back(it->first);
+      points.Bins.push_back(&it->second);
       }
-    ++cstep;
+    }
 
-    if (this->QuadricArray[i].VertexId != -1)
-      {
-      this->ComputeRepresentativePoint(this->QuadricArray[i].Quadric, i, newPt);
-      outputPoints->InsertPoint(this->QuadricArray[i].VertexId, newPt);
-      }
+  outputPoints = vtkPoints::New();
+  outputPoints->SetNumberOfPoints(this->NumberOfBinsUsed);
+  points.Points = vtkFloatArray::SafeDownCast(
+    outputPoints->GetData())->GetPointer(0);
+  points.NumberOfThreads = vtkQuadricClusteringNumberOfThreads(
+    this->NumberOfThreads, this->NumberOfBinsUsed);
+  if (points.NumberOfThreads > 1)
+    {
+    vtkMultiThreader *threader = vtkMultiThreader::New();
+    threader->SetNumberOfThreads(points.NumberOfThreads);
+    threader->SetSingleMethod(vtkQuadricClusteringComputePoints, &points);
+    threader->SingleMethodExecute();
+    threader->Delete();
+    }
+  else
+    {
+    points.ComputePoints(0);
     }
 
   // Set up the output data object.
@@ -1004,7 +1532,7 @@ void vtkQuadricClustering::EndAppend()
   this->OutputLines->Delete();
   this->OutputLines = NULL;
 
-  this->EndAppendVertexGeometry(input, output);
+  this->EndAppendVertexGeometry(NULL, output);
 
   // Tell the data is is up to date 
   // (in case the user calls this method directly).
@@ -1013,7 +1541,7 @@ void vtkQuadricClustering::EndAppend()
   // Free the quadric array.
   if (this->QuadricArray)
     {
-    delete [] this->QuadricArray;
+    delete this->QuadricArray;
     this->QuadricArray = NULL;
     }
 }
@@ -1276,7 +1804,8 @@ void vtkQuadricClustering::EndAppendUsingPoints(vtkPolyData *input,
     }
 
   // Check for misuse of the Append methods.
-  if (this->OutputTriangleArray == NULL || this->OutputLines == NULL)
+  if (this->OutputTriangleArray == NULL || this->OutputLines == NULL ||
+      this->OutputVerts == NULL)
     {
     vtkDebugMacro("Missing Array:  Did you call StartAppend?");
     return;
@@ -1310,7 +1839,8 @@ void vtkQuadricClustering::EndAppendUsingPoints(vtkPolyData *input,
     {
     inputPoints->GetPoint(i, pt);
     binId = this->HashPoint(pt);
-    outPtId = this->QuadricArray[binId].VertexId;
+    vtkQuadricClusteringBinMapIterator bin = this->QuadricArray->find(binId);
+    outPtId = (bin == this->QuadricArray->end() ? -1 : bin->second.VertexId);
     // Sanity check.
     if (outPtId == -1)
       {
@@ -1323,7 +1853,7 @@ void vtkQuadricClustering::EndAppendUsingPoints(vtkPolyData *input,
     // Compute the error for this point.  Note: the constant term is ignored.
     // It will be the same for every point in this bin, and it
     // is not stored in the quadric array anyway.
-    q = this->QuadricArray[binId].Quadric;
+    q = bin->second.Quadric;
     e = q[0]*pt[0]*pt[0] + 2.0*q[1]*pt[0]*pt[1] + 2.0*q[2]*pt[0]*pt[2] + 2.0*q[3]*pt[0]
           + q[4]*pt[1]*pt[1] + 2.0*q[5]*pt[1]*pt[2] + 2.0*q[6]*pt[1]
           + q[7]*pt[2]*pt[2] + 2.0*q[8]*pt[2];
@@ -1354,7 +1884,7 @@ void vtkQuadricClustering::EndAppendUsingPoints(vtkPolyData *input,
 
   if (this->QuadricArray)
     {
-    delete [] this->QuadricArray;
+    delete this->QuadricArray;
     this->QuadricArray = NULL;
     }
 
@@ -1364,10 +1894,10 @@ void vtkQuadricClustering::EndAppendUsingPoints(vtkPolyData *input,
 //----------------------------------------------------------------------------
 // This is not a perfect implementation, because it does not determine
 // which vertex cell is the best for a bin.  The first detected is used.
-void vtkQuadricClustering::EndAppendVertexGeometry(vtkPolyData *input,
-                                                   vtkPolyData *output)
+void vtkQuadricClustering::AppendVertexGeometry(vtkPolyData *input,
+                                                vtkPolyData *output)
 {
-  vtkCellArray *inVerts, *outVerts;
+  vtkCellArray *inVerts;
   vtkIdType *tmp = NULL;
   int        tmpLength = 0;
   int        tmpIdx;
@@ -1379,7 +1909,6 @@ void vtkQuadricClustering::EndAppendVertexGeometry(vtkPolyData *input,
   vtkIdType binId, cellId, outCellId;
 
   inVerts = input->GetVerts();
-  outVerts = vtkCellArray::New();
 
   for (cellId=0, inVerts->InitTraversal(); inVerts->GetNextCell(numPts, ptIds); cellId++)
     {
@@ -1397,11 +1926,16 @@ void vtkQuadricClustering::EndAppendVertexGeometry(vtkPolyData *input,
       {
       input->GetPoint(ptIds[j], pt);
       binId = this->HashPoint(pt);
-      outPtId = this->QuadricArray[binId].VertexId;
-      if (outPtId >= 0)
+      vtkQuadricClusteringBinMapIterator bin = this->QuadricArray->find(binId);
+      if (bin == this->QuadricArray->end())
         {
-        // Do not use this point.  Destroy infomration in Quadric array.
-        this->QuadricArray[binId].VertexId = -1;
+        continue;
+        }
+      outPtId = bin->second.VertexId;
+      if (outPtId >= 0 && !bin->second.InVertexCell)
+        {
+        // Do not use this point again.
+        bin->second.InVertexCell = 1;
         tmp[tmpIdx] = outPtId;
         ++tmpIdx;
         }
@@ -1409,7 +1943,7 @@ void vtkQuadricClustering::EndAppendVertexGeometry(vtkPolyData *input,
     if (tmpIdx > 0)
       {
       // add poly vertex to output.
-      outCellId = outVerts->InsertNextCell(tmpIdx, tmp);
+      outCellId = this->OutputVerts->InsertNextCell(tmpIdx, tmp);
       output->GetCellData()->
         CopyData(input->GetCellData(), cellId, outCellId);
       }
@@ -1419,12 +1953,18 @@ void vtkQuadricClustering::EndAppendVertexGeometry(vtkPolyData *input,
     {
     delete [] tmp;
     }
+}
 
-  if (outVerts->GetNumberOfCells() > 0)
+//----------------------------------------------------------------------------
+void vtkQuadricClustering::EndAppendVertexGeometry(
+  vtkPolyData *vtkNotUsed(input), vtkPolyData *output)
+{
+  if (this->OutputVerts->GetNumberOfCells() > 0)
     {
-    output->SetVerts(outVerts);
+    output->SetVerts(this->OutputVerts);
     }
-  outVerts->Delete();
+  this->OutputVerts->Delete();
+  this->OutputVerts = NULL;
 }
 
 
@@ -1618,5 +2158,8 @@ void vtkQuadricClustering::PrintSelf(ostream& os, vtkIndent indent)
 
   os << indent << "Prevent Duplicate Cells : " 
      << (this->PreventDuplicateCells ? "On\n" : "Off\n");
+  os << indent << "Number Of Stream Divisions: "
+     << this->NumberOfStreamDivisions << endl;
+  os << indent << "Number Of Threads: " << this->NumberOfThreads << endl;
 }
 
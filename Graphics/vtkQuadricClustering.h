@@ -56,6 +56,15 @@
 // this approach does not fit into the visualization architecture and requires
 // manual control, it has the advantage that extremely large data can be 
 // processed in pieces and appended to the filter piece-by-piece.
+//
+// The same can be done within the pipeline by setting
+// NumberOfStreamDivisions. The filter then requests that many pieces from
+// its input, one after the other, and appends each of them. Only one piece
+// of the input is in memory at a time. The quadrics are kept in a sparse map
+// holding only the occupied bins, so that fine binnings of surfaces need
+// memory in proportion to the output rather than to the number of bins.
+// The quadrics of triangles are computed and accumulated by several threads
+// (see NumberOfThreads), with the same result as a single thread.
 
 
 // .SECTION Caveats
@@ -73,6 +82,10 @@
 // Note that for certain types of geometry (e.g., a mostly 2D plane with
 // jitter in the normal direction), the decimator can perform badly. In this
 // sitation, set the number of bins in the normal direction to one.
+//
+// When streaming, the number of divisions is not adjusted to the size of the
+// input, UseInputPoints is ignored, and the feature edges are those of each
+// piece.
 
 // .SECTION See Also
 // vtkQuadricDecimation vtkDecimatePro vtkDecimate vtkQuadricLODActor
@@ -85,7 +98,10 @@
 class vtkCellArray;
 class vtkFeatureEdges;
 class vtkPoints;
+class vtkQuadricClusteringBinMap;
 class vtkQuadricClusteringCellSet;
+class vtkQuadricClusteringPoints;
+class vtkQuadricClusteringTriangles;
 
 
 class VTK_GRAPHICS_EXPORT vtkQuadricClustering : public vtkPolyDataAlgorithm
@@ -213,13 +229,35 @@ public:
   vtkGetMacro(PreventDuplicateCells,int);
   vtkBooleanMacro(PreventDuplicateCells,int);
 
+  // Description:
+  // Set/Get the number of pieces requested from the input and appended one
+  // after the other. When it is larger than one, the bins are built on the
+  // WHOLE_BOUNDING_BOX of the input if its source provides it. Otherwise the
+  // pieces are read once more beforehand to compute their bounds. The
+  // default is 1 (no streaming).
+  vtkSetClampMacro(NumberOfStreamDivisions,int,1,VTK_INT_MAX);
+  vtkGetMacro(NumberOfStreamDivisions,int);
+
+  // Description:
+  // Set/Get the number of threads computing the quadrics of the triangles
+  // and the representative points of the bins. Small inputs use fewer
+  // threads. The output does not depend on this number. The default is
+  // vtkMultiThreader::GetGlobalDefaultNumberOfThreads().
+  vtkSetClampMacro(NumberOfThreads,int,1,VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads,int);
+
 protected:
   vtkQuadricClustering();
   ~vtkQuadricClustering();
 
   int RequestData(vtkInformation *, vtkInformationVector **, vtkInformationVector *);
+  int RequestUpdateExtent(vtkInformation *, vtkInformationVector **, vtkInformationVector *);
   int FillInputPortInformation(int, vtkInformation *);
 
+  // Description:
+  // Request each piece of the input in turn and append it.
+  int StreamPieces(vtkInformation *inInfo, vtkPolyData *output);
+
   // Description:
   // Given a point, determine what bin it falls into.
   vtkIdType HashPoint(double point[3]);
@@ -239,6 +277,13 @@ protected:
   void AddTriangle(vtkIdType *binIds, double *pt0, double *pt1, double *pt2,
                    int geometeryFlag, vtkPolyData *input, vtkPolyData *output);
 
+  // Description:
+  // Add the triangle joining the vertices of three distinct bins to the
+  // output, unless it is a duplicate.
+  void InsertTriangle(vtkIdType *binIds, vtkIdType *triPtIds,
+                      vtkIdType inCellId, vtkPolyData *input,
+                      vtkPolyData *output);
+
   // Description:
   // Add edges to the quadric array.  If geometry flag is on then
   // edges are added to the output.
@@ -278,8 +323,11 @@ protected:
   int UseInputPoints;
 
   // Description:
-  // This method sets the verticies of the output.
-  // It duplicates the structure of the input cells (but decimiated).
+  // These methods set the verticies of the output.
+  // They duplicate the structure of the input cells (but decimiated).
+  // AppendVertexGeometry is called by Append for each piece, and
+  // EndAppendVertexGeometry passes the vertices to the output.
+  void AppendVertexGeometry(vtkPolyData *input, vtkPolyData *output);
   void EndAppendVertexGeometry(vtkPolyData *input, vtkPolyData *output);
 
   // Unfinished option to handle boundary edges differently.
@@ -319,27 +367,15 @@ protected:
   double ZBinStep;
   vtkIdType SliceSize; //eliminate one multiplication
 
-  //BTX
-  struct PointQuadric 
-  {
-    PointQuadric():VertexId(-1),Dimension(255) {}
-    
-    vtkIdType VertexId;
-    // Dimension is supposed to be a flag representing the dimension of the
-    // cells contributing to the quadric.  Lines: 1, Triangles: 2 (and points
-    // 0 in the future?)
-    unsigned char Dimension;
-    double Quadric[9];
-  };
-  //ETX
-
-  PointQuadric* QuadricArray;
+  // The quadrics of the occupied bins, indexed by bin id.
+  vtkQuadricClusteringBinMap *QuadricArray;
   vtkIdType NumberOfBinsUsed;
 
   // Have to make these instance variables if we are going to allow
   // the algorithm to be driven by the Append methods.
   vtkCellArray *OutputTriangleArray;
   vtkCellArray *OutputLines;
+  vtkCellArray *OutputVerts;
 
   vtkFeatureEdges *FeatureEdges;
   vtkPoints *FeaturePoints;
@@ -349,6 +385,14 @@ protected:
   int InCellCount;
   int OutCellCount;
 
+  int NumberOfStreamDivisions;
+  int NumberOfThreads;
+
+  //BTX
+  friend class vtkQuadricClusteringPoints;
+  friend class vtkQuadricClusteringTriangles;
+  //ETX
+
 private:
   vtkQuadricClustering(const vtkQuadricClustering&);  // Not implemented.
   void operator=(const vtkQuadricClustering&);  // Not implemented.
@@ -49,14 +49,439 @@
 #include "vtkMath.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkPolyData.h"
 #include "vtkPointData.h"
 #include "vtkPriorityQueue.h"
 #include "vtkTriangle.h"
 
+#include <vtkstd/algorithm>
+#include <vtkstd/utility>
+#include <vtkstd/vector>
+
 vtkStandardNewMacro(vtkQuadricDecimation);
 
+// Minimum number of points or edges processed by each thread of the
+// parallel decimation
+#define VTK_QUADRIC_DECIMATION_MIN_ITEMS_PER_THREAD 1000
+
+//----------------------------------------------------------------------------
+// One pass of the parallel decimation. The edges of the remaining triangles
+// are gathered and their costs computed by several threads. The cheapest
+// edges whose neighborhoods (the points of the triangles using either end
+// point) do not overlap are then chosen, in the order of their costs, and
+// collapsed by the threads: the collapses touch disjoint sets of points and
+// triangles. Each step gives the same result whatever the number of
+// threads.
+class vtkQuadricDecimationPass
+{
+public:
+  vtkQuadricDecimationPass(vtkQuadricDecimation *filter);
+  ~vtkQuadricDecimationPass();
+
+  // Collapse at most maxCollapses edges; return the number of triangles
+  // deleted, and the number of edges collapsed in numCollapses.
+  vtkIdType Execute(vtkIdType maxCollapses, vtkIdType &numCollapses);
+
+  void FindEdges(int threadId);
+  void ComputeCosts(int threadId);
+  void SortCosts(int threadId);
+  void CollapseEdges(int threadId);
+
+private:
+  enum { FIND_EDGES, COMPUTE_COSTS, SORT_COSTS, COLLAPSE_EDGES };
+  void RunThreads(int step, vtkIdType numItems);
+  static VTK_THREAD_RETURN_TYPE ThreadMethod(void *arg);
+
+  // temporary quadric and matrices of the cost computations
+  struct Workspace
+  {
+    Workspace(int numComponents) : Quad(11 + 4*numComponents),
+      B(3 + numComponents), A(3 + numComponents),
+      Data((3 + numComponents)*(3 + numComponents))
+      {
+      for (int i = 0; i < 3 + numComponents; i++)
+        {
+        this->A[i] = &this->Data[i*(3 + numComponents)];
+        }
+      }
+    vtkstd::vector<double> Quad;
+    vtkstd::vector<double> B;
+    vtkstd::vector<double *> A;
+    vtkstd::vector<double> Data;
+  };
+
+  double ComputeCost(vtkIdType edgeId, double *x, Workspace &work);
+  int IsFree(vtkIdType ptId);
+  void Mark(vtkIdType ptId);
+  vtkIdType SelectEdges(vtkIdType maxCollapses);
+
+  vtkQuadricDecimation *Filter;
+  vtkPolyData *Mesh;
+  vtkMultiThreader *Threader;
+  int Step;
+  int NumberOfThreads;
+  vtkIdType NumberOfItems;
+  vtkIdList *CellIds[VTK_MAX_THREADS];
+
+  // the edges found by each thread, then by all of them (two point ids per
+  // edge, the first one being kept by the collapse)
+  vtkstd::vector<vtkIdType> ThreadEdges[VTK_MAX_THREADS];
+  vtkstd::vector<vtkIdType> Edges;
+  // the costs and ids of the edges, sorted by cost then by id
+  vtkstd::vector<vtkstd::pair<double, vtkIdType> > Costs;
+  // the chosen edges, the points given to them and the number of triangles
+  // each collapse deletes
+  vtkstd::vector<vtkIdType> Chosen;
+  vtkstd::vector<double> Targets;
+  vtkstd::vector<int> NumberOfDeleted;
+  // the points in the neighborhood of a chosen edge
+  vtkstd::vector<unsigned char> Marked;
+  vtkstd::vector<vtkIdType> MarkedIds;
+};
+
+//----------------------------------------------------------------------------
+vtkQuadricDecimationPass::vtkQuadricDecimationPass(
+  vtkQuadricDecimation *filter)
+{
+  this->Filter = filter;
+  this->Mesh = filter->Mesh;
+  this->Threader = vtkMultiThreader::New();
+  this->Step = FIND_EDGES;
+  this->NumberOfThreads = 1;
+  this->NumberOfItems = 0;
+  for (int i = 0; i < VTK_MAX_THREADS; i++)
+    {
+    this->CellIds[i] = NULL;
+    }
+  this->Marked.resize(this->Mesh->GetNumberOfPoints(), 0);
+}
+
+//----------------------------------------------------------------------------
+vtkQuadricDecimationPass::~vtkQuadricDecimationPass()
+{
+  this->Threader->Delete();
+  for (int i = 0; i < VTK_MAX_THREADS; i++)
+    {
+    if (this->CellIds[i])
+      {
+      this->CellIds[i]->Delete();
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkQuadricDecimationPass::ThreadMethod(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkQuadricDecimationPass *self =
+    static_cast<vtkQuadricDecimationPass *>(info->UserData);
+  switch (self->Step)
+    {
+    case FIND_EDGES:
+      self->FindEdges(info->ThreadID);
+      break;
+    case COMPUTE_COSTS:
+      self->ComputeCosts(info->ThreadID);
+      break;
+    case SORT_COSTS:
+      self->SortCosts(info->ThreadID);
+      break;
+    case COLLAPSE_EDGES:
+      self->CollapseEdges(info->ThreadID);
+      break;
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+// Run a step over numItems items, split in contiguous ranges among the
+// threads.
+void vtkQuadricDecimationPass::RunThreads(int step, vtkIdType numItems)
+{
+  int numThreads = this->Filter->NumberOfThreads;
+  int maxThreads = vtkMultiThreader::GetGlobalMaximumNumberOfThreads();
+  if (maxThreads > 0 && numThreads > maxThreads)
+    {
+    numThreads = maxThreads;
+    }
+  if (numThreads > numItems / VTK_QUADRIC_DECIMATION_MIN_ITEMS_PER_THREAD)
+    {
+    numThreads = static_cast<int>(
+      numItems / VTK_QUADRIC_DECIMATION_MIN_ITEMS_PER_THREAD);
+    }
+  if (numThreads < 1)
+    {
+    numThreads = 1;
+    }
+  this->Step = step;
+  this->NumberOfThreads = numThreads;
+  this->NumberOfItems = numItems;
+  if (numThreads > 1)
+    {
+    this->Threader->SetNumberOfThreads(numThreads);
+    this->Threader->SetSingleMethod(vtkQuadricDecimationPass::ThreadMethod,
+                                    this);
+    this->Threader->SingleMethodExecute();
+    }
+  else
+    {
+    vtkMultiThreader::ThreadInfo info;
+    info.ThreadID = 0;
+    info.UserData = this;
+    vtkQuadricDecimationPass::ThreadMethod(&info);
+    }
+}
+
+//----------------------------------------------------------------------------
+// Gather the edges of the triangles using a range of points, each edge being
+// found from its smaller point id.
+void vtkQuadricDecimationPass::FindEdges(int threadId)
+{
+  vtkIdType begin = this->NumberOfItems*threadId/this->NumberOfThreads;
+  vtkIdType end = this->NumberOfItems*(threadId + 1)/this->NumberOfThreads;
+  vtkstd::vector<vtkIdType> &edges = this->ThreadEdges[threadId];
+  unsigned short ncells, i;
+  vtkIdType *cells, npts, *pts, j;
+
+  edges.clear();
+  for (vtkIdType ptId = begin; ptId < end; ptId++)
+    {
+    vtkstd::vector<vtkIdType>::size_type first = edges.size();
+    this->Mesh->GetPointCells(ptId, ncells, cells);
+    for (i = 0; i < ncells; i++)
+      {
+      this->Mesh->GetCellPoints(cells[i], npts, pts);
+      for (j = 0; j < npts; j++)
+        {
+        if (pts[j] > ptId &&
+            vtkstd::find(edges.begin() + first, edges.end(), pts[j]) ==
+            edges.end())
+          {
+          edges.push_back(ptId);
+          edges.push_back(pts[j]);
+          }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Compute the cost, and the point it is given to, of an edge.
+double vtkQuadricDecimationPass::ComputeCost(vtkIdType edgeId, double *x,
+                                             Workspace &work)
+{
+  vtkQuadricDecimation *filter = this->Filter;
+  vtkIdType pt0Id = this->Edges[2*edgeId];
+  vtkIdType pt1Id = this->Edges[2*edgeId + 1];
+
+  if (filter->AttributeErrorMetric)
+    {
+    return filter->ComputeCost2(pt0Id, pt1Id, x, &work.Quad[0], &work.B[0],
+                                &work.A[0]);
+    }
+  return filter->ComputeCost(pt0Id, pt1Id, x, &work.Quad[0]);
+}
+
+//----------------------------------------------------------------------------
+// Compute the costs of a range of edges.
+void vtkQuadricDecimationPass::ComputeCosts(int threadId)
+{
+  vtkIdType begin = this->NumberOfItems*threadId/this->NumberOfThreads;
+  vtkIdType end = this->NumberOfItems*(threadId + 1)/this->NumberOfThreads;
+  Workspace work(this->Filter->NumberOfComponents);
+  vtkstd::vector<double> x(3 + this->Filter->NumberOfComponents);
+
+  for (vtkIdType edgeId = begin; edgeId < end; edgeId++)
+    {
+    this->Costs[edgeId].first = this->ComputeCost(edgeId, &x[0], work);
+    this->Costs[edgeId].second = edgeId;
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkQuadricDecimationPass::SortCosts(int threadId)
+{
+  vtkIdType begin = this->NumberOfItems*threadId/this->NumberOfThreads;
+  vtkIdType end = this->NumberOfItems*(threadId + 1)/this->NumberOfThreads;
+  vtkstd::sort(this->Costs.begin() + begin, this->Costs.begin() + end);
+}
+
+//----------------------------------------------------------------------------
+// Collapse a range of the chosen edges. Their neighborhoods are disjoint:
+// the triangles, links and quadrics each collapse modifies are not used by
+// the others. The points are moved afterwards by the calling thread.
+void vtkQuadricDecimationPass::CollapseEdges(int threadId)
+{
+  vtkIdType begin = this->NumberOfItems*threadId/this->NumberOfThreads;
+  vtkIdType end = this->NumberOfItems*(threadId + 1)/this->NumberOfThreads;
+  vtkQuadricDecimation *filter = this->Filter;
+
+  for (vtkIdType i = begin; i < end; i++)
+    {
+    vtkIdType edgeId = this->Chosen[i];
+    vtkIdType pt0Id = this->Edges[2*edgeId];
+    vtkIdType pt1Id = this->Edges[2*edgeId + 1];
+    filter->AddQuadric(pt1Id, pt0Id);
+    this->NumberOfDeleted[i] =
+      filter->CollapseEdge(pt0Id, pt1Id, this->CellIds[threadId]);
+    }
+}
+
+//----------------------------------------------------------------------------
+// Return whether none of the points of the triangles using ptId is marked.
+int vtkQuadricDecimationPass::IsFree(vtkIdType ptId)
+{
+  unsigned short ncells, i;
+  vtkIdType *cells, npts, *pts, j;
+
+  this->Mesh->GetPointCells(ptId, ncells, cells);
+  for (i = 0; i < ncells; i++)
+    {
+    this->Mesh->GetCellPoints(cells[i], npts, pts);
+    for (j = 0; j < npts; j++)
+      {
+      if (this->Marked[pts[j]])
+        {
+        return 0;
+        }
+      }
+    }
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+// Mark the points of the triangles using ptId.
+void vtkQuadricDecimationPass::Mark(vtkIdType ptId)
+{
+  unsigned short ncells, i;
+  vtkIdType *cells, npts, *pts, j;
+
+  this->Mesh->GetPointCells(ptId, ncells, cells);
+  for (i = 0; i < ncells; i++)
+    {
+    this->Mesh->GetCellPoints(cells[i], npts, pts);
+    for (j = 0; j < npts; j++)
+      {
+      if (!this->Marked[pts[j]])
+        {
+        this->Marked[pts[j]] = 1;
+        this->MarkedIds.push_back(pts[j]);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Choose, from the cheapest, the edges whose neighborhoods do not overlap
+// the ones of the edges already chosen, and whose collapse does not flip a
+// triangle.
+vtkIdType vtkQuadricDecimationPass::SelectEdges(vtkIdType maxCollapses)
+{
+  vtkstd::vector<vtkIdType>::size_type i;
+  int dim = 3 + this->Filter->NumberOfComponents;
+  Workspace work(this->Filter->NumberOfComponents);
+  vtkstd::vector<double> x(dim);
+
+  this->Chosen.clear();
+  this->Targets.clear();
+  for (i = 0; i < this->Costs.size() &&
+         static_cast<vtkIdType>(this->Chosen.size()) < maxCollapses; i++)
+    {
+    vtkIdType edgeId = this->Costs[i].second;
+    vtkIdType pt0Id = this->Edges[2*edgeId];
+    vtkIdType pt1Id = this->Edges[2*edgeId + 1];
+    if (!this->Marked[pt0Id] && !this->Marked[pt1Id] &&
+        this->IsFree(pt0Id) && this->IsFree(pt1Id))
+      {
+      this->ComputeCost(edgeId, &x[0], work);
+      if (this->Filter->IsGoodPlacement(pt0Id, pt1Id, &x[0]))
+        {
+        this->Mark(pt0Id);
+        this->Mark(pt1Id);
+        this->Chosen.push_back(edgeId);
+        this->Targets.insert(this->Targets.end(), x.begin(), x.end());
+        }
+      }
+    }
+
+  for (i = 0; i < this->MarkedIds.size(); i++)
+    {
+    this->Marked[this->MarkedIds[i]] = 0;
+    }
+  this->MarkedIds.clear();
+  return static_cast<vtkIdType>(this->Chosen.size());
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkQuadricDecimationPass::Execute(vtkIdType maxCollapses,
+                                            vtkIdType &numCollapses)
+{
+  vtkIdType i, numEdges, numDeleted = 0;
+  int t, width;
+
+  // gather the edges in the order of their first point
+  this->RunThreads(FIND_EDGES, this->Mesh->GetNumberOfPoints());
+  this->Edges.clear();
+  for (t = 0; t < this->NumberOfThreads; t++)
+    {
+    this->Edges.insert(this->Edges.end(), this->ThreadEdges[t].begin(),
+                       this->ThreadEdges[t].end());
+    }
+  numEdges = static_cast<vtkIdType>(this->Edges.size() / 2);
+  numCollapses = 0;
+  if (numEdges == 0)
+    {
+    return 0;
+    }
+
+  this->Costs.resize(numEdges);
+  this->RunThreads(COMPUTE_COSTS, numEdges);
+
+  // sort the edges by cost: each thread sorts a range, then the ranges are
+  // merged
+  this->RunThreads(SORT_COSTS, numEdges);
+  int numRanges = this->NumberOfThreads;
+  for (width = 1; width < numRanges; width *= 2)
+    {
+    for (t = 0; t + width < numRanges; t += 2*width)
+      {
+      int last = (t + 2*width < numRanges ? t + 2*width : numRanges);
+      vtkstd::inplace_merge(
+        this->Costs.begin() + numEdges*t/numRanges,
+        this->Costs.begin() + numEdges*(t + width)/numRanges,
+        this->Costs.begin() + numEdges*last/numRanges);
+      }
+    }
+
+  numCollapses = this->SelectEdges(maxCollapses);
+  if (numCollapses == 0)
+    {
+    return 0;
+    }
+
+  int dim = 3 + this->Filter->NumberOfComponents;
+  this->NumberOfDeleted.resize(numCollapses);
+  for (t = 0; t < this->Filter->NumberOfThreads; t++)
+    {
+    if (!this->CellIds[t])
+      {
+      this->CellIds[t] = vtkIdList::New();
+      }
+    }
+  this->RunThreads(COLLAPSE_EDGES, numCollapses);
+
+  // move the points kept, with their attributes
+  for (i = 0; i < numCollapses; i++)
+    {
+    this->Filter->SetPointAttributeArray(this->Edges[2*this->Chosen[i]],
+                                         &this->Targets[dim*i]);
+    numDeleted += this->NumberOfDeleted[i];
+    }
+  return numDeleted;
+}
 
 //----------------------------------------------------------------------------
 vtkQuadricDecimation::vtkQuadricDecimation()
@@ -86,6 +511,10 @@ vtkQuadricDecimation::vtkQuadricDecimation()
   this->TensorsWeight = 0.1;
 
   this->ActualReduction = 0.0;
+
+  this->ParallelCollapse = 0;
+  this->PassReduction = 0.25;
+  this->NumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
 }
 
 //----------------------------------------------------------------------------
@@ -239,24 +668,27 @@ int vtkQuadricDecimation::RequestData(
   this->ErrorQuadrics = 
     new vtkQuadricDecimation::ErrorQuadric[numPts];
   
-  vtkDebugMacro(<<"Computing Edges");
-  this->Edges->InitEdgeInsertion(numPts, 1); // storing edge id as attribute
-  this->EdgeCosts->Allocate(this->Mesh->GetPolys()->GetNumberOfCells() * 3);
-  for (i = 0; i <  this->Mesh->GetNumberOfCells(); i++) 
+  if (!this->ParallelCollapse)
     {
-    this->Mesh->GetCellPoints(i, npts, pts); 
-      
-    for (j = 0; j < 3; j++)
+    vtkDebugMacro(<<"Computing Edges");
+    this->Edges->InitEdgeInsertion(numPts, 1); // storing edge id as attribute
+    this->EdgeCosts->Allocate(this->Mesh->GetPolys()->GetNumberOfCells() * 3);
+    for (i = 0; i <  this->Mesh->GetNumberOfCells(); i++) 
       {
-      if (this->Edges->IsEdge(pts[j], pts[(j+1)%3]) == -1)
+      this->Mesh->GetCellPoints(i, npts, pts); 
+      
+      for (j = 0; j < 3; j++)
         {
-        // If this edge has not been processed, get an id for it, add it to
-        // the edge list (Edges), and add its endpoints to the EndPoint1List
-        // and EndPoint2List (the 2 endpoints to different lists).
-        edgeId = this->Edges->GetNumberOfEdges();
-        this->Edges->InsertEdge(pts[j], pts[(j+1)%3], edgeId);
-        this->EndPoint1List->InsertId(edgeId, pts[j]);
-        this->EndPoint2List->InsertId(edgeId, pts[(j+1)%3]);
+        if (this->Edges->IsEdge(pts[j], pts[(j+1)%3]) == -1)
+          {
+          // If this edge has not been processed, get an id for it, add it to
+          // the edge list (Edges), and add its endpoints to the EndPoint1List
+          // and EndPoint2List (the 2 endpoints to different lists).
+          edgeId = this->Edges->GetNumberOfEdges();
+          this->Edges->InsertEdge(pts[j], pts[(j+1)%3], edgeId);
+          this->EndPoint1List->InsertId(edgeId, pts[j]);
+          this->EndPoint2List->InsertId(edgeId, pts[(j+1)%3]);
+          }
         }
       }
     }
@@ -287,71 +719,80 @@ int vtkQuadricDecimation::RequestData(
   this->AddBoundaryConstraints();
   this->UpdateProgress(0.15);
   
-  vtkDebugMacro(<<"Computing Costs");
-  // Compute the cost of and target point for collapsing each edge.
-  for (i = 0; i < this->Edges->GetNumberOfEdges(); i++)
-    {
-    if (this->AttributeErrorMetric) 
-      {
-      cost = this->ComputeCost2(i, x);
-      }
-    else
-      {
-      cost = this->ComputeCost(i, x);
-      }
-    this->EdgeCosts->Insert(cost, i);
-    this->TargetPoints->InsertTuple(i, x);
-    }
-  this->UpdateProgress(0.20);
-
-  // Okay collapse edges until desired reduction is reached
   this->ActualReduction = 0.0;
   this->NumberOfEdgeCollapses = 0;
-  edgeId = this->EdgeCosts->Pop(0,cost);
-
-  int abort = 0;
-  while ( !abort && edgeId >= 0 && cost < VTK_DOUBLE_MAX &&
-         this->ActualReduction < this->TargetReduction ) 
+  cost = 0.0;
+  if (this->ParallelCollapse)
+    {
+    vtkDebugMacro(<<"Collapsing edges in parallel passes");
+    numDeletedTris = this->CollapseEdgesInPasses(numTris);
+    }
+  else
     {
-    if ( ! (this->NumberOfEdgeCollapses % 10000) ) 
+    vtkDebugMacro(<<"Computing Costs");
+    // Compute the cost of and target point for collapsing each edge.
+    for (i = 0; i < this->Edges->GetNumberOfEdges(); i++)
       {
-      vtkDebugMacro(<<"Collapsing edge#" << this->NumberOfEdgeCollapses);
-      this->UpdateProgress (0.20 + 0.80*this->NumberOfEdgeCollapses/numPts);
-      abort = this->GetAbortExecute();
+      if (this->AttributeErrorMetric) 
+        {
+        cost = this->ComputeCost2(i, x);
+        }
+      else
+        {
+        cost = this->ComputeCost(i, x);
+        }
+      this->EdgeCosts->Insert(cost, i);
+      this->TargetPoints->InsertTuple(i, x);
       }
+    this->UpdateProgress(0.20);
 
-    endPtIds[0] = this->EndPoint1List->GetId(edgeId);
-    endPtIds[1] = this->EndPoint2List->GetId(edgeId);
-    this->TargetPoints->GetTuple(edgeId, x);
+    // Okay collapse edges until desired reduction is reached
+    edgeId = this->EdgeCosts->Pop(0,cost);
 
-    // check for a poorly placed point
-    if ( !this->IsGoodPlacement(endPtIds[0], endPtIds[1], x)) 
+    int abort = 0;
+    while ( !abort && edgeId >= 0 && cost < VTK_DOUBLE_MAX &&
+           this->ActualReduction < this->TargetReduction ) 
       {
-      vtkDebugMacro(<<"Poor placement detected " << edgeId << " " <<  cost);
-      // return the point to the queue but with the max cost so that 
-      // when it is recomputed it will be reconsidered
-      this->EdgeCosts->Insert(VTK_DOUBLE_MAX, edgeId);
+      if ( ! (this->NumberOfEdgeCollapses % 10000) ) 
+        {
+        vtkDebugMacro(<<"Collapsing edge#" << this->NumberOfEdgeCollapses);
+        this->UpdateProgress (0.20 + 0.80*this->NumberOfEdgeCollapses/numPts);
+        abort = this->GetAbortExecute();
+        }
 
-      edgeId = this->EdgeCosts->Pop(0, cost);
-      continue;
-      }
+      endPtIds[0] = this->EndPoint1List->GetId(edgeId);
+      endPtIds[1] = this->EndPoint2List->GetId(edgeId);
+      this->TargetPoints->GetTuple(edgeId, x);
+
+      // check for a poorly placed point
+      if ( !this->IsGoodPlacement(endPtIds[0], endPtIds[1], x)) 
+        {
+        vtkDebugMacro(<<"Poor placement detected " << edgeId << " " <<  cost);
+        // return the point to the queue but with the max cost so that 
+        // when it is recomputed it will be reconsidered
+        this->EdgeCosts->Insert(VTK_DOUBLE_MAX, edgeId);
+
+        edgeId = this->EdgeCosts->Pop(0, cost);
+        continue;
+        }
     
-    this->NumberOfEdgeCollapses++;
+      this->NumberOfEdgeCollapses++;
         
-    // Set the new coordinates of point0.
-    this->SetPointAttributeArray(endPtIds[0], x);
-    vtkDebugMacro(<<"Cost: " << cost << " Edge: " 
-                  << endPtIds[0] << " " << endPtIds[1]);
+      // Set the new coordinates of point0.
+      this->SetPointAttributeArray(endPtIds[0], x);
+      vtkDebugMacro(<<"Cost: " << cost << " Edge: " 
+                    << endPtIds[0] << " " << endPtIds[1]);
     
-    // Merge the quadrics of the two points.
-    this->AddQuadric(endPtIds[1], endPtIds[0]);
+      // Merge the quadrics of the two points.
+      this->AddQuadric(endPtIds[1], endPtIds[0]);
     
-    this->UpdateEdgeData(endPtIds[0], endPtIds[1]);
+      this->UpdateEdgeData(endPtIds[0], endPtIds[1]);
     
-    // Update the output triangles.
-    numDeletedTris += this->CollapseEdge(endPtIds[0], endPtIds[1]);
-    this->ActualReduction = (double) numDeletedTris / numTris;
-    edgeId = this->EdgeCosts->Pop(0, cost);
+      // Update the output triangles.
+      numDeletedTris += this->CollapseEdge(endPtIds[0], endPtIds[1]);
+      this->ActualReduction = (double) numDeletedTris / numTris;
+      edgeId = this->EdgeCosts->Pop(0, cost);
+      }
     }
 
   vtkDebugMacro(<<"Number Of Edge Collapses: "
@@ -405,6 +846,45 @@ int vtkQuadricDecimation::RequestData(
   return 1;
 }
 
+//----------------------------------------------------------------------------
+vtkIdType vtkQuadricDecimation::CollapseEdgesInPasses(vtkIdType numTris)
+{
+  vtkQuadricDecimationPass pass(this);
+  vtkIdType numDeletedTris = 0, numCollapses, maxCollapses, neededCollapses;
+  vtkIdType targetTris = 
+    static_cast<vtkIdType>(ceil(this->TargetReduction * numTris));
+
+  while ( numDeletedTris < targetTris && !this->GetAbortExecute() )
+    {
+    // a collapse usually deletes two triangles
+    maxCollapses = static_cast<vtkIdType>(
+      this->PassReduction * (numTris - numDeletedTris) / 2);
+    neededCollapses = (targetTris - numDeletedTris + 1) / 2;
+    if (maxCollapses > neededCollapses)
+      {
+      maxCollapses = neededCollapses;
+      }
+    if (maxCollapses < 1)
+      {
+      maxCollapses = 1;
+      }
+
+    numDeletedTris += pass.Execute(maxCollapses, numCollapses);
+    if (numCollapses == 0)
+      {
+      break;
+      }
+    this->NumberOfEdgeCollapses += numCollapses;
+    this->ActualReduction = (double) numDeletedTris / numTris;
+    vtkDebugMacro(<<"Collapsed " << numCollapses << " edges, reduction: "
+                  << this->ActualReduction);
+    this->UpdateProgress(0.20 + 
+                         0.80*this->ActualReduction/this->TargetReduction);
+    }
+
+  return numDeletedTris;
+}
+
 //----------------------------------------------------------------------------
 void vtkQuadricDecimation::InitializeQuadrics(vtkIdType numPts)
 {
@@ -789,6 +1269,15 @@ void vtkQuadricDecimation::UpdateEdgeData(vtkIdType pt0Id, vtkIdType pt1Id)
 
 //----------------------------------------------------------------------------
 double vtkQuadricDecimation::ComputeCost(vtkIdType edgeId, double *x)
+{
+  return this->ComputeCost(this->EndPoint1List->GetId(edgeId),
+                           this->EndPoint2List->GetId(edgeId),
+                           x, this->TempQuad);
+}
+
+//----------------------------------------------------------------------------
+double vtkQuadricDecimation::ComputeCost(vtkIdType pt0Id, vtkIdType pt1Id,
+                                         double *x, double *quad)
 {
   static const double errorNumber = 1e-10;
   double temp[3], A[3][3], b[3];
@@ -800,25 +1289,25 @@ double vtkQuadricDecimation::ComputeCost(vtkIdType edgeId, double *x)
   double v[3],  c, norm, normTemp,  temp2[3];
   double pt1[3], pt2[3];
 
-  pointIds[0] = this->EndPoint1List->GetId(edgeId);
-  pointIds[1] = this->EndPoint2List->GetId(edgeId);
+  pointIds[0] = pt0Id;
+  pointIds[1] = pt1Id;
   
   for (i = 0; i < 11 + 4 * this->NumberOfComponents; i++)
     {
-    this->TempQuad[i] = this->ErrorQuadrics[pointIds[0]].Quadric[i] +
+    quad[i] = this->ErrorQuadrics[pointIds[0]].Quadric[i] +
       this->ErrorQuadrics[pointIds[1]].Quadric[i];
     }
 
-  A[0][0] = this->TempQuad[0];
-  A[0][1] = A[1][0] = this->TempQuad[1];
-  A[0][2] = A[2][0] = this->TempQuad[2];
-  A[1][1] = this->TempQuad[4];
-  A[1][2] = A[2][1] = this->TempQuad[5];
-  A[2][2] = this->TempQuad[7];
+  A[0][0] = quad[0];
+  A[0][1] = A[1][0] = quad[1];
+  A[0][2] = A[2][0] = quad[2];
+  A[1][1] = quad[4];
+  A[1][2] = A[2][1] = quad[5];
+  A[2][2] = quad[7];
 
-  b[0] = -this->TempQuad[3];
-  b[1] = -this->TempQuad[6];
-  b[2] = -this->TempQuad[8];
+  b[0] = -quad[3];
+  b[1] = -quad[6];
+  b[2] = -quad[8];
    
   norm = vtkMath::Norm(A[0]);
   normTemp = vtkMath::Norm(A[1]);
@@ -872,7 +1361,7 @@ double vtkQuadricDecimation::ComputeCost(vtkIdType edgeId, double *x)
   
   // Compute the cost
   // x'*quad*x
-  index = this->TempQuad;
+  index = quad;
   for (i = 0; i < 4; i++) 
     {
     cost += (*index++)*newPoint[i]*newPoint[i];
@@ -888,6 +1377,16 @@ double vtkQuadricDecimation::ComputeCost(vtkIdType edgeId, double *x)
 
 //----------------------------------------------------------------------------
 double vtkQuadricDecimation::ComputeCost2(vtkIdType edgeId, double *x)
+{
+  return this->ComputeCost2(this->EndPoint1List->GetId(edgeId),
+                            this->EndPoint2List->GetId(edgeId),
+                            x, this->TempQuad, this->TempB, this->TempA);
+}
+
+//----------------------------------------------------------------------------
+double vtkQuadricDecimation::ComputeCost2(vtkIdType pt0Id, vtkIdType pt1Id,
+                                          double *x, double *quad,
+                                          double *B, double **A)
 {
   // this function is so ugly because the functionality of converting an QEM
   // into a dence matrix was not extracted into a separate function and
@@ -898,34 +1397,34 @@ double vtkQuadricDecimation::ComputeCost2(vtkIdType edgeId, double *x)
   int i, j;
   int solveOk;
 
-  pointIds[0] = this->EndPoint1List->GetId(edgeId);
-  pointIds[1] = this->EndPoint2List->GetId(edgeId);
+  pointIds[0] = pt0Id;
+  pointIds[1] = pt1Id;
 
   for (i = 0; i < 11 + 4 * this->NumberOfComponents; i++)  
     {
-    this->TempQuad[i] = this->ErrorQuadrics[pointIds[0]].Quadric[i] +
+    quad[i] = this->ErrorQuadrics[pointIds[0]].Quadric[i] +
       this->ErrorQuadrics[pointIds[1]].Quadric[i];
     }
   
   // copy the temp quad into TempA
   // converting from the sparce matrix format into a dence
-  this->TempA[0][0] = this->TempQuad[0];
-  this->TempA[0][1] = this->TempA[1][0] = this->TempQuad[1];
-  this->TempA[0][2] = this->TempA[2][0] = this->TempQuad[2];
-  this->TempA[1][1] = this->TempQuad[4];
-  this->TempA[1][2] = this->TempA[2][1] = this->TempQuad[5];
-  this->TempA[2][2] = this->TempQuad[7];
+  A[0][0] = quad[0];
+  A[0][1] = A[1][0] = quad[1];
+  A[0][2] = A[2][0] = quad[2];
+  A[1][1] = quad[4];
+  A[1][2] = A[2][1] = quad[5];
+  A[2][2] = quad[7];
   
-  this->TempB[0] = -this->TempQuad[3];
-  this->TempB[1] = -this->TempQuad[6];
-  this->TempB[2] = -this->TempQuad[8];
+  B[0] = -quad[3];
+  B[1] = -quad[6];
+  B[2] = -quad[8];
 
   for (i = 3; i < 3 +  this->NumberOfComponents; i++) 
     {
-    this->TempA[0][i] = this->TempA[i][0] = this->TempQuad[11+4*(i-3)];
-    this->TempA[1][i] = this->TempA[i][1] = this->TempQuad[11+4*(i-3)+1];
-    this->TempA[2][i] = this->TempA[i][2] = this->TempQuad[11+4*(i-3)+2];
-    this->TempB[i] = -this->TempQuad[11+4*(i-3)+3];
+    A[0][i] = A[i][0] = quad[11+4*(i-3)];
+    A[1][i] = A[i][1] = quad[11+4*(i-3)+1];
+    A[2][i] = A[i][2] = quad[11+4*(i-3)+2];
+    B[i] = -quad[11+4*(i-3)+3];
     }
 
   for (i = 3; i < 3 +  this->NumberOfComponents; i++) 
@@ -934,38 +1433,38 @@ double vtkQuadricDecimation::ComputeCost2(vtkIdType edgeId, double *x)
       {
       if (i == j)
         {
-        this->TempA[i][j] = this->TempQuad[10];
+        A[i][j] = quad[10];
         }
       else 
         {
-        this->TempA[i][j] = 0;
+        A[i][j] = 0;
         }
       }
     }
   
   for (i = 0; i < 3 + this->NumberOfComponents; i++) 
     {
-    x[i] = this->TempB[i];
+    x[i] = B[i];
     }
   
   // solve A*x = b
   // this clobers A
   // need to develop a quality of the solution test??
-  solveOk = vtkMath::SolveLinearSystem(this->TempA, x, 3 +  this->NumberOfComponents);
+  solveOk = vtkMath::SolveLinearSystem(A, x, 3 +  this->NumberOfComponents);
   
   // need to copy back into A
-  this->TempA[0][0] = this->TempQuad[0];
-  this->TempA[0][1] = this->TempA[1][0] = this->TempQuad[1];
-  this->TempA[0][2] = this->TempA[2][0] = this->TempQuad[2];
-  this->TempA[1][1] = this->TempQuad[4];
-  this->TempA[1][2] = this->TempA[2][1] = this->TempQuad[5];
-  this->TempA[2][2] = this->TempQuad[7];
+  A[0][0] = quad[0];
+  A[0][1] = A[1][0] = quad[1];
+  A[0][2] = A[2][0] = quad[2];
+  A[1][1] = quad[4];
+  A[1][2] = A[2][1] = quad[5];
+  A[2][2] = quad[7];
  
   for (i = 3; i < 3 +  this->NumberOfComponents; i++) 
     {
-    this->TempA[0][i] = this->TempA[i][0] = this->TempQuad[11+4*(i-3)];
-    this->TempA[1][i] = this->TempA[i][1] = this->TempQuad[11+4*(i-3)+1];
-    this->TempA[2][i] = this->TempA[i][2] = this->TempQuad[11+4*(i-3)+2];
+    A[0][i] = A[i][0] = quad[11+4*(i-3)];
+    A[1][i] = A[i][1] = quad[11+4*(i-3)+1];
+    A[2][i] = A[i][2] = quad[11+4*(i-3)+2];
     }
 
   for (i = 3; i < 3 +  this->NumberOfComponents; i++) 
@@ -974,11 +1473,11 @@ double vtkQuadricDecimation::ComputeCost2(vtkIdType edgeId, double *x)
       {
       if (i == j)
         {
-        this->TempA[i][j] = this->TempQuad[10]; 
+        A[i][j] = quad[10]; 
         }
       else 
         {
-        this->TempA[i][j] = 0;
+        A[i][j] = 0;
         }
       }
     }
@@ -1011,7 +1510,7 @@ double vtkQuadricDecimation::ComputeCost2(vtkIdType edgeId, double *x)
       temp2[i] = 0;
       for (j = 0; j < 3 + this->NumberOfComponents; ++j) 
         {
-        temp2[i] += this->TempA[i][j]*v[j];
+        temp2[i] += A[i][j]*v[j];
         }
       }
       
@@ -1029,13 +1528,13 @@ double vtkQuadricDecimation::ComputeCost2(vtkIdType edgeId, double *x)
         temp[i] = 0;
         for (j = 0; j < 3 + this->NumberOfComponents; ++j) 
           {
-          temp[i] += this->TempA[i][j]*pt1[j];
+          temp[i] += A[i][j]*pt1[j];
           }
         }
           
       for (i = 0; i < 3 + this->NumberOfComponents; i++)
         {
-        temp[i] = this->TempB[i] - temp[i];
+        temp[i] = B[i] - temp[i];
         }
           
       for (i = 0; i < 3 + this->NumberOfComponents; i++)
@@ -1069,32 +1568,39 @@ double vtkQuadricDecimation::ComputeCost2(vtkIdType edgeId, double *x)
   // x'*A*x - 2*b*x + d
   for (i = 0; i < 3+this->NumberOfComponents; i++) 
     {
-    cost += this->TempA[i][i]*x[i]*x[i];
+    cost += A[i][i]*x[i]*x[i];
     for (j = i+1; j < 3+this->NumberOfComponents; j++) 
       {
-      cost += 2.0*this->TempA[i][j]*x[i]*x[j];
+      cost += 2.0*A[i][j]*x[i]*x[j];
       }
     }
   for (i = 0; i < 3+this->NumberOfComponents; i++) 
     {
-    cost -=  2.0 * this->TempB[i]*x[i];
+    cost -=  2.0 * B[i]*x[i];
     }
       
-  cost += this->TempQuad[9];
+  cost += quad[9];
 
   return cost;
 }
 
 
 int vtkQuadricDecimation::CollapseEdge(vtkIdType pt0Id, vtkIdType pt1Id) 
+{
+  return this->CollapseEdge(pt0Id, pt1Id, this->CollapseCellIds);
+}
+
+//----------------------------------------------------------------------------
+int vtkQuadricDecimation::CollapseEdge(vtkIdType pt0Id, vtkIdType pt1Id,
+                                       vtkIdList *cellIds)
 {
   int j, numDeleted=0;
   vtkIdType i, npts, *pts, cellId;
 
-  this->Mesh->GetPointCells(pt0Id, this->CollapseCellIds);
-  for (i = 0; i < this->CollapseCellIds->GetNumberOfIds(); i++) 
+  this->Mesh->GetPointCells(pt0Id, cellIds);
+  for (i = 0; i < cellIds->GetNumberOfIds(); i++) 
     {
-    cellId = this->CollapseCellIds->GetId(i);
+    cellId = cellIds->GetId(i);
     this->Mesh->GetCellPoints(cellId, npts, pts);
     for (j = 0; j < 3; j++) 
       {
@@ -1107,11 +1613,11 @@ int vtkQuadricDecimation::CollapseEdge(vtkIdType pt0Id, vtkIdType pt1Id)
       }
     }
 
-  this->Mesh->GetPointCells(pt1Id, this->CollapseCellIds);
-  this->Mesh->ResizeCellList(pt0Id, this->CollapseCellIds->GetNumberOfIds());
-  for (i=0; i < this->CollapseCellIds->GetNumberOfIds(); i++)
+  this->Mesh->GetPointCells(pt1Id, cellIds);
+  this->Mesh->ResizeCellList(pt0Id, cellIds->GetNumberOfIds());
+  for (i=0; i < cellIds->GetNumberOfIds(); i++)
     {
-    cellId = this->CollapseCellIds->GetId(i);
+    cellId = cellIds->GetId(i);
     this->Mesh->GetCellPoints(cellId, npts, pts);
     // making sure we don't already have the triangle we're about to
     // change this one to
@@ -1373,4 +1879,9 @@ void vtkQuadricDecimation::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "Normals Weight: " << this->NormalsWeight << "\n";
   os << indent << "TCoords Weight: " << this->TCoordsWeight << "\n";
   os << indent << "Tensors Weight: " << this->TensorsWeight << "\n";
+
+  os << indent << "Parallel Collapse: " 
+     << (this->ParallelCollapse ? "On\n" : "Off\n");
+  os << indent << "Pass Reduction: " << this->PassReduction << "\n";
+  os << indent << "Number Of Threads: " << this->NumberOfThreads << "\n";
 }
@@ -38,6 +38,13 @@
 // taking into account variation in attributes (i.e., scalars, vectors, and
 // so on).
 //
+// With ParallelCollapse on, the priority queue is replaced by passes over
+// all the edges. Each pass collapses the cheapest edges whose neighborhoods
+// do not overlap, with several threads (see NumberOfThreads). The quadrics,
+// attributes and boundary constraints are the same as in the serial
+// algorithm, but the order of the collapses differs, so the meshes differ
+// slightly. With several cores, large meshes are decimated faster this way.
+//
 // This paper is based on the work of Garland and Heckbert who first
 // presented the quadric error measure at Siggraph '97 "Surface
 // Simplification Using Quadric Error Metrics". For details of the algorithm
@@ -124,6 +131,30 @@ public:
   // filter has executed.
   vtkGetMacro(ActualReduction, double);
 
+  // Description:
+  // Turn on/off the parallel decimation. When on, the edges are collapsed in
+  // passes instead of one at a time from the priority queue: each pass
+  // collapses the cheapest edges whose neighborhoods do not overlap, with
+  // NumberOfThreads threads. Off by default.
+  vtkSetMacro(ParallelCollapse, int);
+  vtkGetMacro(ParallelCollapse, int);
+  vtkBooleanMacro(ParallelCollapse, int);
+
+  // Description:
+  // Set/Get the largest fraction of the remaining triangles that a pass of
+  // the parallel decimation may delete. Smaller fractions collapse the
+  // edges in an order closer to the priority queue, at the cost of more
+  // passes. The default is 0.25.
+  vtkSetClampMacro(PassReduction, double, 0.0, 1.0);
+  vtkGetMacro(PassReduction, double);
+
+  // Description:
+  // Set/Get the number of threads of the parallel decimation. The result
+  // does not depend on this number. The default is
+  // vtkMultiThreader::GetGlobalDefaultNumberOfThreads().
+  vtkSetClampMacro(NumberOfThreads, int, 1, VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads, int);
+
 protected:
   vtkQuadricDecimation();
   ~vtkQuadricDecimation();
@@ -132,8 +163,15 @@ protected:
 
   // Description:
   // Do the dirty work of eliminating the edge; return the number of
-  // triangles deleted.
+  // triangles deleted. The second form uses cellIds as temporary list, so
+  // that threads can collapse edges.
   int CollapseEdge(vtkIdType pt0Id, vtkIdType pt1Id);
+  int CollapseEdge(vtkIdType pt0Id, vtkIdType pt1Id, vtkIdList *cellIds);
+
+  // Description:
+  // Collapse edges in parallel passes until the target reduction is
+  // reached; return the number of triangles deleted.
+  vtkIdType CollapseEdgesInPasses(vtkIdType numTris);
 
   // Description:
   // Compute quadric for all vertices
@@ -158,6 +196,14 @@ protected:
   double ComputeCost(vtkIdType edgeId, double *x);
   double ComputeCost2(vtkIdType edgeId, double *x);
 
+  // Description:
+  // Same as above, for the edge from pt0Id to pt1Id and with the temporary
+  // quadric (and matrices) given, so that threads can compute costs.
+  double ComputeCost(vtkIdType pt0Id, vtkIdType pt1Id, double *x,
+                     double *quad);
+  double ComputeCost2(vtkIdType pt0Id, vtkIdType pt1Id, double *x,
+                      double *quad, double *B, double **A);
+
   // Description:
   // Find all edges that will have an endpoint change ids because of an edge
   // collapse.  p1Id and p2Id are the endpoints of the edge.  p2Id is the
@@ -200,6 +246,10 @@ protected:
   double TCoordsWeight;
   double TensorsWeight;
 
+  int    ParallelCollapse;
+  double PassReduction;
+  int    NumberOfThreads;
+
   int               NumberOfEdgeCollapses;
   vtkEdgeTable     *Edges;
   vtkIdList        *EndPoint1List;
@@ -228,6 +278,10 @@ protected:
   double **TempA;
   double *TempData;
 
+  //BTX
+  friend class vtkQuadricDecimationPass;
+  //ETX
+
 private:
   vtkQuadricDecimation(const vtkQuadricDecimation&);  // Not implemented.
   void operator=(const vtkQuadricDecimation&);  // Not implemented.
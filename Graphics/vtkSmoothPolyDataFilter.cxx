@@ -28,6 +28,8 @@
 #include "vtkStreamingDemandDrivenPipeline.h"
 #include "vtkTriangleFilter.h"
 
+#include <vtkstd/vector>
+
 vtkStandardNewMacro(vtkSmoothPolyDataFilter);
 
 // The following code defines a helper class for performing mesh smoothing
@@ -187,7 +189,7 @@ int vtkSmoothPolyDataFilter::RequestData(
   vtkIdType npts = 0;
   vtkIdType *pts = 0;
   vtkIdType p1, p2;
-  double x[3], y[3], deltaX[3], xNew[3], conv, maxDist, dist, factor;
+  double x[3], deltaX[3], xNew[3], conv, maxDist, dist, factor;
   double x1[3], x2[3], x3[3], l1[3], l2[3];
   double CosFeatureAngle; //Cosine of angle between adjacent polys
   double CosEdgeAngle; // Cosine of angle between adjacent edges
@@ -512,11 +514,36 @@ int vtkSmoothPolyDataFilter::RequestData(
                 << numBEdges << " boundary edge vertices\n\t"
                 << numFixed << " fixed vertices\n\t");
 
+  // Compress the connectivity of the vertices that can move into flat
+  // offsets and neighbor ids, which the iterations sweep instead of the
+  // lists. Fixed vertices get no neighbors.
+  vtkstd::vector<vtkIdType> offsets(numPts+1);
+  vtkstd::vector<vtkIdType> neighborIds;
+  for (i=0; i<numPts; i++)
+    {
+    offsets[i] = static_cast<vtkIdType>(neighborIds.size());
+    if ( Verts[i].edges != NULL )
+      {
+      if ( Verts[i].type != VTK_FIXED_VERTEX )
+        {
+        npts = Verts[i].edges->GetNumberOfIds();
+        pts = Verts[i].edges->GetPointer(0);
+        neighborIds.insert(neighborIds.end(), pts, pts + npts);
+        }
+      Verts[i].edges->Delete();
+      Verts[i].edges = NULL;
+      }
+    }
+  offsets[numPts] = static_cast<vtkIdType>(neighborIds.size());
+  neighborIds.push_back(0); // so that the array is never empty
+  const vtkIdType *neighbors = &neighborIds[0];
+
   vtkDebugMacro(<<"Beginning smoothing iterations...");
 
   // We've setup the topology...now perform Laplacian smoothing
   //
   newPts = vtkPoints::New();
+  newPts->SetDataTypeToFloat();
   newPts->SetNumberOfPoints(numPts);
 
   // If Source defined, we do constrained smoothing (that is, points are 
@@ -547,6 +574,9 @@ int vtkSmoothPolyDataFilter::RequestData(
       }
     }
 
+  // The points are smoothed in place, in a flat array: a point moves with
+  // the neighbors already moved during the iteration.
+  float *ptsData = static_cast<float *>(newPts->GetVoidPointer(0));
   factor = this->RelaxationFactor;
   for ( maxDist=VTK_DOUBLE_MAX, iterationNumber=0, abortExecute=0; 
   maxDist > conv && iterationNumber < this->NumberOfIterations && !abortExecute;
@@ -566,14 +596,18 @@ int vtkSmoothPolyDataFilter::RequestData(
     maxDist=0.0;
     for (i=0; i<numPts; i++) 
       {
-      if ( Verts[i].type != VTK_FIXED_VERTEX && Verts[i].edges != NULL &&
-      (npts = Verts[i].edges->GetNumberOfIds()) > 0 )
+      if ( (npts = offsets[i+1] - offsets[i]) > 0 )
         {
-        newPts->GetPoint(i, x); //use current points
-        deltaX[0] = deltaX[1] = deltaX[2] = 0.0;
+        float *xPtr = ptsData + 3*i;
+        for (k=0; k<3; k++) //use current points
+          {
+          x[k] = xPtr[k];
+          deltaX[k] = 0.0;
+          }
+        const vtkIdType *nei = neighbors + offsets[i];
         for (j=0; j<npts; j++)
           {
-          newPts->GetPoint(Verts[i].edges->GetId(j), y);
+          const float *y = ptsData + 3*nei[j];
           for (k=0; k<3; k++)
             {
             deltaX[k] += (y[k] - x[k]) / npts;
@@ -608,7 +642,10 @@ int vtkSmoothPolyDataFilter::RequestData(
             }
           }
 
-        newPts->SetPoint(i,xNew);
+        for (k=0; k<3; k++)
+          {
+          xPtr[k] = static_cast<float>(xNew[k]);
+          }
         if ( (dist = vtkMath::Norm(deltaX)) > maxDist )
           {
           maxDist = dist;
@@ -616,6 +653,7 @@ int vtkSmoothPolyDataFilter::RequestData(
         }//if can move point
       }//for all points
     } //for not converged or within iteration count
+  newPts->Modified();
 
   vtkDebugMacro(<<"Performed " << iterationNumber << " smoothing passes");
   if ( source )
@@ -674,14 +712,6 @@ int vtkSmoothPolyDataFilter::RequestData(
   output->SetStrips(input->GetStrips());
 
   //free up connectivity storage
-  for (i=0; i<numPts; i++)
-    {
-    if ( Verts[i].edges != NULL ) 
-      {
-      Verts[i].edges->Delete();
-      Verts[i].edges = NULL;
-      }
-    }
   delete [] Verts;
 
   return 1;
@@ -31,6 +31,11 @@
 // v).  The process repeats for each vertex. This pass over the list of
 // vertices is a single iteration. Many iterations (generally around 20 or
 // so) are repeated until the desired result is obtained.
+//
+// Once the topology is known, the connectivity array is compressed into
+// flat offset and neighbor arrays, and the iterations sweep a flat array of
+// coordinates. Each vertex is moved in place, using the neighbors already
+// moved during the same iteration.
 // 
 // There are some special instance variables used to control the execution
 // of this filter. (These ivars basically control what vertices can be
@@ -0,0 +1,756 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    vtkSpatialReorderFilter.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "vtkSpatialReorderFilter.h"
+
+#include "vtkCellArray.h"
+#include "vtkCellData.h"
+#include "vtkIdTypeArray.h"
+#include "vtkInformation.h"
+#include "vtkInformationVector.h"
+#include "vtkMultiThreader.h"
+#include "vtkObjectFactory.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+#include "vtkUnsignedCharArray.h"
+#include "vtkUnstructuredGrid.h"
+
+#include <vtkstd/algorithm>
+#include <vtkstd/vector>
+
+#include <string.h>
+
+vtkStandardNewMacro(vtkSpatialReorderFilter);
+
+// Number of bits of each quantized coordinate; three of them fit in the
+// 64 bit curve keys.
+#define VTK_SPATIAL_REORDER_BITS 21
+
+// Below this many items the threading overhead is not worth it
+#define VTK_SPATIAL_REORDER_MIN_PER_THREAD 1024
+
+namespace
+{
+// A curve key and the id of the point or cell it was computed for.  Ties
+// are broken by id so that the order is fully determined.
+struct vtkSpatialReorderItem
+{
+  vtkTypeUInt64 Key;
+  vtkIdType Id;
+  bool operator<(const vtkSpatialReorderItem &other) const
+    {
+    return this->Key < other.Key ||
+      (this->Key == other.Key && this->Id < other.Id);
+    }
+};
+
+// Shared state of the threaded passes
+struct vtkSpatialReorderThreadStruct
+{
+  int CurveType;
+  vtkIdType Number;
+  double Origin[3];
+  double Scale[3];
+  vtkPoints *Points;
+  vtkIdType *Connectivity;
+  vtkIdType *Offsets;
+  vtkIdType *NewToOld;
+  vtkIdType *PointMap;
+  vtkIdType *NewConnectivity;
+  vtkIdType *NewOffsets;
+  vtkSpatialReorderItem *Items;
+  unsigned char *Source;
+  unsigned char *Destination;
+  int TupleSize;
+};
+
+//----------------------------------------------------------------------------
+// Spread the low 21 bits of v so that there are two zero bits between
+// each of them.
+inline vtkTypeUInt64 vtkSpatialReorderSpreadBits(vtkTypeUInt64 v)
+{
+  v &= 0x1fffff;
+  v = (v | (v << 32)) & 0x1f00000000ffffULL;
+  v = (v | (v << 16)) & 0x1f0000ff0000ffULL;
+  v = (v | (v << 8))  & 0x100f00f00f00f00fULL;
+  v = (v | (v << 4))  & 0x10c30c30c30c30c3ULL;
+  v = (v | (v << 2))  & 0x1249249249249249ULL;
+  return v;
+}
+
+//----------------------------------------------------------------------------
+// Compute the curve key of a point.  The Hilbert index is obtained with
+// Skilling's transform ("Programming the Hilbert curve", 2004), which
+// turns the coordinates into a transposed index that is then interleaved
+// exactly like a Morton code.
+inline vtkTypeUInt64 vtkSpatialReorderComputeKey(
+  vtkSpatialReorderThreadStruct *str, const double x[3])
+{
+  const unsigned int maxCoord = (1u << VTK_SPATIAL_REORDER_BITS) - 1;
+  unsigned int X[3];
+  int i;
+  for (i=0; i < 3; i++)
+    {
+    double q = (x[i] - str->Origin[i]) * str->Scale[i];
+    X[i] = (q <= 0.0) ? 0 :
+      (q >= maxCoord ? maxCoord : static_cast<unsigned int>(q));
+    }
+
+  if (str->CurveType == VTK_SPATIAL_REORDER_HILBERT)
+    {
+    const unsigned int M = 1u << (VTK_SPATIAL_REORDER_BITS - 1);
+    unsigned int P, Q, t;
+    // inverse undo
+    for (Q = M; Q > 1; Q >>= 1)
+      {
+      P = Q - 1;
+      for (i=0; i < 3; i++)
+        {
+        if (X[i] & Q)
+          {
+          X[0] ^= P;
+          }
+        else
+          {
+          t = (X[0] ^ X[i]) & P;
+          X[0] ^= t;
+          X[i] ^= t;
+          }
+        }
+      }
+    // Gray encode
+    X[1] ^= X[0];
+    X[2] ^= X[1];
+    t = 0;
+    for (Q = M; Q > 1; Q >>= 1)
+      {
+      if (X[2] & Q)
+        {
+        t ^= Q - 1;
+        }
+      }
+    X[0] ^= t;
+    X[1] ^= t;
+    X[2] ^= t;
+    }
+
+  return (vtkSpatialReorderSpreadBits(X[0]) << 2) |
+    (vtkSpatialReorderSpreadBits(X[1]) << 1) |
+    vtkSpatialReorderSpreadBits(X[2]);
+}
+
+//----------------------------------------------------------------------------
+inline void vtkSpatialReorderThreadRange(vtkMultiThreader::ThreadInfo *info,
+                                         vtkIdType num, vtkIdType &begin,
+                                         vtkIdType &end)
+{
+  begin = num * info->ThreadID / info->NumberOfThreads;
+  end = num * (info->ThreadID + 1) / info->NumberOfThreads;
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkSpatialReorderPointKeys(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkSpatialReorderThreadStruct *str =
+    static_cast<vtkSpatialReorderThreadStruct *>(info->UserData);
+
+  vtkIdType begin, end;
+  vtkSpatialReorderThreadRange(info, str->Number, begin, end);
+  double x[3];
+  for (vtkIdType ptId = begin; ptId < end; ptId++)
+    {
+    str->Points->GetPoint(ptId, x);
+    str->Items[ptId].Key = vtkSpatialReorderComputeKey(str, x);
+    str->Items[ptId].Id = ptId;
+    }
+  // sort this thread's share; the shares are merged afterwards
+  vtkstd::sort(str->Items + begin, str->Items + end);
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkSpatialReorderCellKeys(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkSpatialReorderThreadStruct *str =
+    static_cast<vtkSpatialReorderThreadStruct *>(info->UserData);
+
+  vtkIdType begin, end;
+  vtkSpatialReorderThreadRange(info, str->Number, begin, end);
+  double x[3], center[3];
+  for (vtkIdType cellId = begin; cellId < end; cellId++)
+    {
+    vtkIdType *cell = str->Connectivity + str->Offsets[cellId];
+    vtkIdType npts = cell[0];
+    center[0] = str->Origin[0];
+    center[1] = str->Origin[1];
+    center[2] = str->Origin[2];
+    if (npts > 0)
+      {
+      center[0] = center[1] = center[2] = 0.0;
+      for (vtkIdType i=1; i <= npts; i++)
+        {
+        str->Points->GetPoint(cell[i], x);
+        center[0] += x[0];
+        center[1] += x[1];
+        center[2] += x[2];
+        }
+      center[0] /= npts;
+      center[1] /= npts;
+      center[2] /= npts;
+      }
+    str->Items[cellId].Key = vtkSpatialReorderComputeKey(str, center);
+    str->Items[cellId].Id = cellId;
+    }
+  vtkstd::sort(str->Items + begin, str->Items + end);
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkSpatialReorderCopyCells(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkSpatialReorderThreadStruct *str =
+    static_cast<vtkSpatialReorderThreadStruct *>(info->UserData);
+
+  vtkIdType begin, end;
+  vtkSpatialReorderThreadRange(info, str->Number, begin, end);
+  for (vtkIdType newId = begin; newId < end; newId++)
+    {
+    vtkIdType *src = str->Connectivity + str->Offsets[str->NewToOld[newId]];
+    vtkIdType *dst = str->NewConnectivity + str->NewOffsets[newId];
+    vtkIdType npts = src[0];
+    dst[0] = npts;
+    if (str->PointMap)
+      {
+      for (vtkIdType i=1; i <= npts; i++)
+        {
+        dst[i] = str->PointMap[src[i]];
+        }
+      }
+    else
+      {
+      memcpy(dst + 1, src + 1, npts * sizeof(vtkIdType));
+      }
+    }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkSpatialReorderCopyTuples(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkSpatialReorderThreadStruct *str =
+    static_cast<vtkSpatialReorderThreadStruct *>(info->UserData);
+
+  vtkIdType begin, end;
+  vtkSpatialReorderThreadRange(info, str->Number, begin, end);
+  size_t size = static_cast<size_t>(str->TupleSize);
+  for (vtkIdType newId = begin; newId < end; newId++)
+    {
+    memcpy(str->Destination + size * newId,
+           str->Source + size * str->NewToOld[newId], size);
+    }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+int vtkSpatialReorderNumberOfThreads(int maxThreads, vtkIdType num)
+{
+  vtkIdType numThreads = num / VTK_SPATIAL_REORDER_MIN_PER_THREAD;
+  if (numThreads > maxThreads)
+    {
+    numThreads = maxThreads;
+    }
+  return numThreads < 1 ? 1 : static_cast<int>(numThreads);
+}
+
+//----------------------------------------------------------------------------
+void vtkSpatialReorderExecute(vtkThreadFunctionType f,
+                              vtkSpatialReorderThreadStruct *str,
+                              int numThreads)
+{
+  vtkMultiThreader *threader = vtkMultiThreader::New();
+  threader->SetNumberOfThreads(numThreads);
+  threader->SetSingleMethod(f, str);
+  threader->SingleMethodExecute();
+  threader->Delete();
+}
+
+//----------------------------------------------------------------------------
+// Compute and sort the keys, then merge the sorted shares of the threads
+// and extract the ids.
+void vtkSpatialReorderSort(vtkThreadFunctionType f,
+                           vtkSpatialReorderThreadStruct *str,
+                           int numThreads, vtkIdType *newToOld)
+{
+  vtkIdType num = str->Number;
+  vtkstd::vector<vtkSpatialReorderItem> items(num);
+  str->Items = &items[0];
+  vtkSpatialReorderExecute(f, str, numThreads);
+
+  // merge neighboring shares, doubling the share width every round; the
+  // boundaries are the same as those of vtkSpatialReorderThreadRange
+  for (int width = 1; width < numThreads; width *= 2)
+    {
+    for (int first = 0; first + width < numThreads; first += 2*width)
+      {
+      int last = first + 2*width;
+      if (last > numThreads)
+        {
+        last = numThreads;
+        }
+      vtkIdType begin = num * first / numThreads;
+      vtkIdType middle = num * (first + width) / numThreads;
+      vtkIdType end = num * last / numThreads;
+      vtkstd::inplace_merge(items.begin() + begin, items.begin() + middle,
+                            items.begin() + end);
+      }
+    }
+
+  for (vtkIdType i=0; i < num; i++)
+    {
+    newToOld[i] = items[i].Id;
+    }
+}
+}
+
+//----------------------------------------------------------------------------
+vtkSpatialReorderFilter::vtkSpatialReorderFilter()
+{
+  this->CurveType = VTK_SPATIAL_REORDER_HILBERT;
+  this->ReorderPoints = 1;
+  this->ReorderCells = 1;
+  this->GenerateOriginalPointIds = 0;
+  this->GenerateOriginalCellIds = 0;
+  this->NumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+}
+
+//----------------------------------------------------------------------------
+const char *vtkSpatialReorderFilter::GetCurveTypeAsString()
+{
+  if (this->CurveType == VTK_SPATIAL_REORDER_MORTON)
+    {
+    return "Morton";
+    }
+  return "Hilbert";
+}
+
+//----------------------------------------------------------------------------
+int vtkSpatialReorderFilter::FillInputPortInformation(int,
+                                                      vtkInformation *info)
+{
+  info->Set(vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(), "vtkPolyData");
+  info->Append(vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(),
+               "vtkUnstructuredGrid");
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+// Set up the quantization of the coordinates over the bounds.
+static void vtkSpatialReorderInitialize(vtkSpatialReorderThreadStruct *str,
+                                        int curveType, const double bounds[6])
+{
+  const double maxCoord = (1u << VTK_SPATIAL_REORDER_BITS) - 1;
+  str->CurveType = curveType;
+  for (int i=0; i < 3; i++)
+    {
+    double width = bounds[2*i+1] - bounds[2*i];
+    str->Origin[i] = bounds[2*i];
+    str->Scale[i] = (width > 0.0) ? maxCoord / width : 0.0;
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkSpatialReorderFilter::SortPoints(vtkPoints *points,
+                                         const double bounds[6],
+                                         vtkIdType *newToOld)
+{
+  vtkSpatialReorderThreadStruct str;
+  vtkSpatialReorderInitialize(&str, this->CurveType, bounds);
+  str.Number = points->GetNumberOfPoints();
+  str.Points = points;
+  vtkSpatialReorderSort(vtkSpatialReorderPointKeys, &str,
+    vtkSpatialReorderNumberOfThreads(this->NumberOfThreads, str.Number),
+    newToOld);
+}
+
+//----------------------------------------------------------------------------
+void vtkSpatialReorderFilter::SortCells(vtkPoints *points,
+                                        const double bounds[6],
+                                        vtkIdType *connectivity,
+                                        vtkIdType *offsets,
+                                        vtkIdType numCells,
+                                        vtkIdType *newToOld)
+{
+  vtkSpatialReorderThreadStruct str;
+  vtkSpatialReorderInitialize(&str, this->CurveType, bounds);
+  str.Number = numCells;
+  str.Points = points;
+  str.Connectivity = connectivity;
+  str.Offsets = offsets;
+  vtkSpatialReorderSort(vtkSpatialReorderCellKeys, &str,
+    vtkSpatialReorderNumberOfThreads(this->NumberOfThreads, numCells),
+    newToOld);
+}
+
+//----------------------------------------------------------------------------
+void vtkSpatialReorderFilter::PermuteConnectivity(vtkIdType *connectivity,
+                                                  vtkIdType *offsets,
+                                                  vtkIdType numCells,
+                                                  vtkIdType *newToOld,
+                                                  vtkIdType *pointMap,
+                                                  vtkIdType *newConnectivity,
+                                                  vtkIdType *newOffsets)
+{
+  // the new offsets are a prefix sum of the cell sizes in the new order
+  vtkIdType loc = 0;
+  for (vtkIdType newId=0; newId < numCells; newId++)
+    {
+    newOffsets[newId] = loc;
+    loc += connectivity[offsets[newToOld[newId]]] + 1;
+    }
+  newOffsets[numCells] = loc;
+
+  vtkSpatialReorderThreadStruct str;
+  str.Number = numCells;
+  str.Connectivity = connectivity;
+  str.Offsets = offsets;
+  str.NewToOld = newToOld;
+  str.PointMap = pointMap;
+  str.NewConnectivity = newConnectivity;
+  str.NewOffsets = newOffsets;
+  vtkSpatialReorderExecute(vtkSpatialReorderCopyCells, &str,
+    vtkSpatialReorderNumberOfThreads(this->NumberOfThreads, numCells));
+}
+
+//----------------------------------------------------------------------------
+// Copy array newToOld[i] of in to tuple i of out.  Arrays with fixed size
+// tuples are copied in parallel; bit and string arrays are copied
+// serially.
+static void vtkSpatialReorderPermuteArray(vtkAbstractArray *in,
+                                          vtkAbstractArray *out,
+                                          vtkIdType *newToOld, vtkIdType num,
+                                          int numThreads)
+{
+  out->SetNumberOfComponents(in->GetNumberOfComponents());
+  out->SetNumberOfTuples(num);
+  if (num < 1)
+    {
+    return;
+    }
+  if (in->IsA("vtkDataArray") && in->GetDataType() != VTK_BIT)
+    {
+    vtkSpatialReorderThreadStruct str;
+    str.Number = num;
+    str.NewToOld = newToOld;
+    str.Source = static_cast<unsigned char *>(in->GetVoidPointer(0));
+    str.Destination = static_cast<unsigned char *>(out->GetVoidPointer(0));
+    str.TupleSize = in->GetDataTypeSize() * in->GetNumberOfComponents();
+    vtkSpatialReorderExecute(vtkSpatialReorderCopyTuples, &str,
+      vtkSpatialReorderNumberOfThreads(numThreads, num));
+    }
+  else
+    {
+    for (vtkIdType i=0; i < num; i++)
+      {
+      out->SetTuple(i, newToOld[i], in);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkSpatialReorderFilter::PermuteAttributes(vtkDataSetAttributes *in,
+                                                vtkDataSetAttributes *out,
+                                                vtkIdType *newToOld,
+                                                vtkIdType num)
+{
+  out->Initialize();
+  for (int i=0; i < in->GetNumberOfArrays(); i++)
+    {
+    vtkAbstractArray *inArray = in->GetAbstractArray(i);
+    vtkAbstractArray *outArray = inArray->NewInstance();
+    outArray->SetName(inArray->GetName());
+    vtkSpatialReorderPermuteArray(inArray, outArray, newToOld, num,
+                                  this->NumberOfThreads);
+    int idx = out->AddArray(outArray);
+    outArray->Delete();
+    int attributeType = in->IsArrayAnAttribute(i);
+    if (attributeType >= 0)
+      {
+      out->SetActiveAttribute(idx, attributeType);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Compute the location of each cell in a connectivity array.
+static void vtkSpatialReorderCellOffsets(vtkCellArray *cells,
+                                         vtkstd::vector<vtkIdType> &offsets)
+{
+  vtkIdType numCells = cells->GetNumberOfCells();
+  vtkIdType *conn = cells->GetPointer();
+  offsets.resize(numCells + 1);
+  vtkIdType loc = 0;
+  for (vtkIdType cellId=0; cellId < numCells; cellId++)
+    {
+    offsets[cellId] = loc;
+    loc += conn[loc] + 1;
+    }
+  offsets[numCells] = loc;
+}
+
+//----------------------------------------------------------------------------
+static void vtkSpatialReorderAddIds(vtkDataSetAttributes *attributes,
+                                    const char *name, vtkIdType *ids,
+                                    vtkIdType num)
+{
+  vtkIdTypeArray *originalIds = vtkIdTypeArray::New();
+  originalIds->SetName(name);
+  originalIds->SetNumberOfValues(num);
+  if (num > 0)
+    {
+    memcpy(originalIds->GetPointer(0), ids, num * sizeof(vtkIdType));
+    }
+  attributes->AddArray(originalIds);
+  originalIds->Delete();
+}
+
+//----------------------------------------------------------------------------
+int vtkSpatialReorderFilter::RequestData(
+  vtkInformation *vtkNotUsed(request),
+  vtkInformationVector **inputVector,
+  vtkInformationVector *outputVector)
+{
+  // get the info objects
+  vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
+  vtkInformation *outInfo = outputVector->GetInformationObject(0);
+
+  // get the input and output
+  vtkPointSet *input = vtkPointSet::SafeDownCast(
+    inInfo->Get(vtkDataObject::DATA_OBJECT()));
+  vtkPointSet *output = vtkPointSet::SafeDownCast(
+    outInfo->Get(vtkDataObject::DATA_OBJECT()));
+
+  vtkPolyData *inputPD = vtkPolyData::SafeDownCast(input);
+  vtkUnstructuredGrid *inputUG = vtkUnstructuredGrid::SafeDownCast(input);
+  vtkPoints *inPts = input->GetPoints();
+
+  if (!inPts || (!inputPD && !inputUG))
+    {
+    vtkDebugMacro(<<"Nothing to reorder");
+    output->ShallowCopy(input);
+    return 1;
+    }
+  if (inputUG && inputUG->GetFaces())
+    {
+    vtkWarningMacro(<<"Polyhedral cells are not supported, "
+                    "passing the input through");
+    output->ShallowCopy(input);
+    return 1;
+    }
+
+  vtkDebugMacro(<<"Reordering along a " << this->GetCurveTypeAsString()
+                << " curve");
+
+  output->Initialize();
+  vtkIdType numPts = inPts->GetNumberOfPoints();
+  vtkIdType numCells = input->GetNumberOfCells();
+  double bounds[6];
+  inPts->GetBounds(bounds);
+
+  // Order the points
+  vtkIdType i;
+  vtkstd::vector<vtkIdType> pointNewToOld(numPts + 1);
+  vtkstd::vector<vtkIdType> pointMap;
+  if (this->ReorderPoints && numPts > 0)
+    {
+    this->SortPoints(inPts, bounds, &pointNewToOld[0]);
+    pointMap.resize(numPts);
+    for (i=0; i < numPts; i++)
+      {
+      pointMap[pointNewToOld[i]] = i;
+      }
+    }
+  else
+    {
+    for (i=0; i < numPts; i++)
+      {
+      pointNewToOld[i] = i;
+      }
+    }
+  vtkIdType *pointMapPtr = pointMap.empty() ? NULL : &pointMap[0];
+
+  vtkPoints *newPts = inPts->NewInstance();
+  newPts->SetDataType(inPts->GetDataType());
+  vtkSpatialReorderPermuteArray(inPts->GetData(), newPts->GetData(),
+                                &pointNewToOld[0], numPts,
+                                this->NumberOfThreads);
+  output->SetPoints(newPts);
+  newPts->Delete();
+
+  this->PermuteAttributes(input->GetPointData(), output->GetPointData(),
+                          &pointNewToOld[0], numPts);
+  this->UpdateProgress(0.3);
+
+  // Order the cells, building the new connectivity
+  vtkstd::vector<vtkIdType> cellNewToOld(numCells + 1);
+  vtkstd::vector<vtkIdType> offsets;
+  vtkstd::vector<vtkIdType> newOffsets;
+  if (inputPD)
+    {
+    vtkPolyData *outputPD = vtkPolyData::SafeDownCast(output);
+    vtkCellArray *inCells[4];
+    inCells[0] = inputPD->GetVerts();
+    inCells[1] = inputPD->GetLines();
+    inCells[2] = inputPD->GetPolys();
+    inCells[3] = inputPD->GetStrips();
+
+    // vtkPolyData numbers verts first, then lines, polys and strips;
+    // each group is sorted separately
+    vtkIdType firstCell = 0;
+    for (int type=0; type < 4; type++)
+      {
+      vtkIdType num = inCells[type]->GetNumberOfCells();
+      vtkIdType *newToOld = &cellNewToOld[firstCell];
+      vtkSpatialReorderCellOffsets(inCells[type], offsets);
+      vtkIdType *conn = inCells[type]->GetPointer();
+      if (this->ReorderCells && num > 1)
+        {
+        this->SortCells(inPts, bounds, conn, &offsets[0], num, newToOld);
+        }
+      else
+        {
+        for (i=0; i < num; i++)
+          {
+          newToOld[i] = i;
+          }
+        }
+
+      vtkCellArray *newCells = vtkCellArray::New();
+      vtkIdType size = offsets[num];
+      vtkIdType *newConn = newCells->WritePointer(num, size);
+      newOffsets.resize(num + 1);
+      this->PermuteConnectivity(conn, &offsets[0], num, newToOld,
+                                pointMapPtr, newConn, &newOffsets[0]);
+      switch (type)
+        {
+        case 0: outputPD->SetVerts(newCells); break;
+        case 1: outputPD->SetLines(newCells); break;
+        case 2: outputPD->SetPolys(newCells); break;
+        case 3: outputPD->SetStrips(newCells); break;
+        }
+      newCells->Delete();
+
+      // turn the group's local ids into cell ids
+      for (i=0; i < num; i++)
+        {
+        newToOld[i] += firstCell;
+        }
+      firstCell += num;
+      }
+    }
+  else
+    {
+    vtkUnstructuredGrid *outputUG = vtkUnstructuredGrid::SafeDownCast(output);
+    vtkCellArray *inCells = inputUG->GetCells();
+    if (inCells && numCells > 0)
+      {
+      vtkSpatialReorderCellOffsets(inCells, offsets);
+      vtkIdType *conn = inCells->GetPointer();
+      if (this->ReorderCells && numCells > 1)
+        {
+        this->SortCells(inPts, bounds, conn, &offsets[0], numCells,
+                        &cellNewToOld[0]);
+        }
+      else
+        {
+        for (i=0; i < numCells; i++)
+          {
+          cellNewToOld[i] = i;
+          }
+        }
+
+      vtkCellArray *newCells = vtkCellArray::New();
+      vtkIdType *newConn =
+        newCells->WritePointer(numCells, offsets[numCells]);
+      newOffsets.resize(numCells + 1);
+      this->PermuteConnectivity(conn, &offsets[0], numCells,
+                                &cellNewToOld[0], pointMapPtr, newConn,
+                                &newOffsets[0]);
+      vtkIdTypeArray *newLocations = vtkIdTypeArray::New();
+      newLocations->SetNumberOfValues(numCells);
+      memcpy(newLocations->GetPointer(0), &newOffsets[0],
+             numCells * sizeof(vtkIdType));
+
+      vtkUnsignedCharArray *inTypes = inputUG->GetCellTypesArray();
+      vtkUnsignedCharArray *newTypes = vtkUnsignedCharArray::New();
+      newTypes->SetNumberOfValues(numCells);
+      for (i=0; i < numCells; i++)
+        {
+        newTypes->SetValue(i, inTypes->GetValue(cellNewToOld[i]));
+        }
+
+      outputUG->SetCells(newTypes, newLocations, newCells);
+      newCells->Delete();
+      newLocations->Delete();
+      newTypes->Delete();
+      }
+    }
+  this->UpdateProgress(0.8);
+
+  this->PermuteAttributes(input->GetCellData(), output->GetCellData(),
+                          &cellNewToOld[0], numCells);
+  output->GetFieldData()->PassData(input->GetFieldData());
+
+  if (this->GenerateOriginalPointIds)
+    {
+    vtkSpatialReorderAddIds(output->GetPointData(), "vtkOriginalPointIds",
+                            &pointNewToOld[0], numPts);
+    }
+  if (this->GenerateOriginalCellIds)
+    {
+    vtkSpatialReorderAddIds(output->GetCellData(), "vtkOriginalCellIds",
+                            &cellNewToOld[0], numCells);
+    }
+
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+void vtkSpatialReorderFilter::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "Curve Type: " << this->GetCurveTypeAsString() << "\n";
+  os << indent << "Reorder Points: "
+     << (this->ReorderPoints ? "On\n" : "Off\n");
+  os << indent << "Reorder Cells: "
+     << (this->ReorderCells ? "On\n" : "Off\n");
+  os << indent << "Generate Original Point Ids: "
+     << (this->GenerateOriginalPointIds ? "On\n" : "Off\n");
+  os << indent << "Generate Original Cell Ids: "
+     << (this->GenerateOriginalCellIds ? "On\n" : "Off\n");
+  os << indent << "Number Of Threads: " << this->NumberOfThreads << "\n";
+}
@@ -0,0 +1,154 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    vtkSpatialReorderFilter.h
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// .NAME vtkSpatialReorderFilter - reorder points and cells along a space filling curve
+// .SECTION Description
+// vtkSpatialReorderFilter renumbers the points and cells of a vtkPolyData
+// or vtkUnstructuredGrid so that entities close in space are also close
+// in memory.  Points are sorted by the position of their coordinates
+// along a Morton (Z-order) or Hilbert curve, and cells by the position
+// of their centroid.  The connectivity is remapped and all point and
+// cell attribute arrays are permuted accordingly.  The geometry and
+// topology of the output are otherwise identical to the input.
+//
+// The curve keys, the sorting and the copying of the arrays are split
+// over NumberOfThreads threads.  Ties are broken by the original id, so
+// the result does not depend on the number of threads.
+//
+// For vtkPolyData the cells stay grouped by type (verts, lines, polys
+// and strips), since vtkPolyData numbers its cells in that order; each
+// group is sorted on its own.
+//
+// Optionally the original point and cell ids are stored in arrays
+// named "vtkOriginalPointIds" and "vtkOriginalCellIds".
+
+// .SECTION Caveats
+// Unstructured grids with polyhedral cells are passed through unchanged.
+
+// .SECTION See Also
+// vtkCleanPolyData vtkKdTree
+
+#ifndef __vtkSpatialReorderFilter_h
+#define __vtkSpatialReorderFilter_h
+
+#include "vtkPointSetAlgorithm.h"
+
+#define VTK_SPATIAL_REORDER_MORTON  0
+#define VTK_SPATIAL_REORDER_HILBERT 1
+
+class vtkCellArray;
+class vtkDataSetAttributes;
+class vtkIdTypeArray;
+class vtkPoints;
+
+class VTK_GRAPHICS_EXPORT vtkSpatialReorderFilter : public vtkPointSetAlgorithm
+{
+public:
+  static vtkSpatialReorderFilter *New();
+  vtkTypeMacro(vtkSpatialReorderFilter,vtkPointSetAlgorithm);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  // Description:
+  // Specify the space filling curve used to order points and cells.
+  // The Hilbert curve (the default) gives better locality, the Morton
+  // curve is cheaper to compute.
+  vtkSetClampMacro(CurveType,int,
+                   VTK_SPATIAL_REORDER_MORTON,VTK_SPATIAL_REORDER_HILBERT);
+  vtkGetMacro(CurveType,int);
+  void SetCurveTypeToMorton()
+    {this->SetCurveType(VTK_SPATIAL_REORDER_MORTON);}
+  void SetCurveTypeToHilbert()
+    {this->SetCurveType(VTK_SPATIAL_REORDER_HILBERT);}
+  const char *GetCurveTypeAsString();
+
+  // Description:
+  // Turn on/off reordering of the points.  Default is on.
+  vtkSetMacro(ReorderPoints,int);
+  vtkGetMacro(ReorderPoints,int);
+  vtkBooleanMacro(ReorderPoints,int);
+
+  // Description:
+  // Turn on/off reordering of the cells.  Default is on.
+  vtkSetMacro(ReorderCells,int);
+  vtkGetMacro(ReorderCells,int);
+  vtkBooleanMacro(ReorderCells,int);
+
+  // Description:
+  // Turn on/off the "vtkOriginalPointIds" point data array holding the
+  // input id of each output point.  Default is off.
+  vtkSetMacro(GenerateOriginalPointIds,int);
+  vtkGetMacro(GenerateOriginalPointIds,int);
+  vtkBooleanMacro(GenerateOriginalPointIds,int);
+
+  // Description:
+  // Turn on/off the "vtkOriginalCellIds" cell data array holding the
+  // input id of each output cell.  Default is off.
+  vtkSetMacro(GenerateOriginalCellIds,int);
+  vtkGetMacro(GenerateOriginalCellIds,int);
+  vtkBooleanMacro(GenerateOriginalCellIds,int);
+
+  // Description:
+  // Number of threads used to compute the keys and permute the data.
+  // The default is vtkMultiThreader::GetGlobalDefaultNumberOfThreads().
+  vtkSetClampMacro(NumberOfThreads,int,1,VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads,int);
+
+protected:
+  vtkSpatialReorderFilter();
+  ~vtkSpatialReorderFilter() {};
+
+  virtual int RequestData(vtkInformation *, vtkInformationVector **,
+                          vtkInformationVector *);
+  virtual int FillInputPortInformation(int port, vtkInformation *info);
+
+  // Description:
+  // Compute the order of the points.  newToOld is filled with the input
+  // id of each output point.
+  void SortPoints(vtkPoints *points, const double bounds[6],
+                  vtkIdType *newToOld);
+
+  // Description:
+  // Compute the order of the cells of a connectivity array, with
+  // offsets giving the location of each cell in the array.
+  void SortCells(vtkPoints *points, const double bounds[6],
+                 vtkIdType *connectivity, vtkIdType *offsets,
+                 vtkIdType numCells, vtkIdType *newToOld);
+
+  // Description:
+  // Build the reordered connectivity.  pointMap maps input to output
+  // point ids and may be NULL.  newOffsets receives numCells+1 values,
+  // the location of each cell in newConnectivity.
+  void PermuteConnectivity(vtkIdType *connectivity, vtkIdType *offsets,
+                           vtkIdType numCells, vtkIdType *newToOld,
+                           vtkIdType *pointMap, vtkIdType *newConnectivity,
+                           vtkIdType *newOffsets);
+
+  // Description:
+  // Copy all the arrays of in to out, tuple newToOld[i] going to tuple i.
+  void PermuteAttributes(vtkDataSetAttributes *in, vtkDataSetAttributes *out,
+                         vtkIdType *newToOld, vtkIdType num);
+
+  int CurveType;
+  int ReorderPoints;
+  int ReorderCells;
+  int GenerateOriginalPointIds;
+  int GenerateOriginalCellIds;
+  int NumberOfThreads;
+
+private:
+  vtkSpatialReorderFilter(const vtkSpatialReorderFilter&);  // Not implemented.
+  void operator=(const vtkSpatialReorderFilter&);  // Not implemented.
+};
+
+#endif
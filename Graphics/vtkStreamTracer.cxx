@@ -34,6 +34,7 @@ PURPOSE.  See the above copyright notice for more information.
 #include "vtkCellLocatorInterpolatedVelocityField.h"
 #include "vtkMath.h"
 #include "vtkMultiBlockDataSet.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
 #include "vtkPointSet.h"
@@ -44,6 +45,11 @@ PURPOSE.  See the above copyright notice for more information.
 #include "vtkRungeKutta45.h"
 #include "vtkSmartPointer.h"
 
+#include <vtkstd/vector>
+
+// Fewer seeds than this per thread are integrated serially.
+#define VTK_STREAM_TRACER_MIN_SEEDS_PER_THREAD 16
+
 vtkStandardNewMacro(vtkStreamTracer);
 vtkCxxSetObjectMacro(vtkStreamTracer,Integrator,vtkInitialValueProblemSolver);
 vtkCxxSetObjectMacro(vtkStreamTracer,InterpolatorPrototype,vtkAbstractInterpolatedVelocityField);
@@ -78,6 +84,8 @@ vtkStreamTracer::vtkStreamTracer()
 
   this->InterpolatorPrototype = 0;
 
+  this->NumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+
   this->SetNumberOfInputPorts(2);
 
   // by default process active point vectors
@@ -458,14 +466,37 @@ int vtkStreamTracer::RequestData(
     if (vectors)
       {
       const char *vecName = vectors->GetName();
-      double propagation = 0;
-      vtkIdType numSteps = 0;
-      this->Integrate(input0, output,
-                      seeds, seedIds,
-                      integrationDirections,
-                      lastPoint, func,
-                      maxCellSize, vecName,
-                      propagation, numSteps);
+      int numThreads = this->NumberOfThreads;
+      int maxThreads = vtkMultiThreader::GetGlobalMaximumNumberOfThreads();
+      if (maxThreads > 0 && numThreads > maxThreads)
+        {
+        numThreads = maxThreads;
+        }
+      vtkIdType maxSeedThreads = seedIds->GetNumberOfIds() /
+        VTK_STREAM_TRACER_MIN_SEEDS_PER_THREAD;
+      if (numThreads > maxSeedThreads)
+        {
+        numThreads = static_cast<int>(maxSeedThreads);
+        }
+      if (numThreads > 1)
+        {
+        this->IntegrateInParallel(input0, output,
+                                  seeds, seedIds,
+                                  integrationDirections,
+                                  func, maxCellSize, vecName,
+                                  numThreads);
+        }
+      else
+        {
+        double propagation = 0;
+        vtkIdType numSteps = 0;
+        this->Integrate(input0, output,
+                        seeds, seedIds,
+                        integrationDirections,
+                        lastPoint, func,
+                        maxCellSize, vecName,
+                        propagation, numSteps);
+        }
       }
     func->Delete();
     seeds->Delete();
@@ -569,7 +600,8 @@ void vtkStreamTracer::Integrate(vtkDataSet *input0,
                                 int maxCellSize,
                                 const char *vecName,
                                 double& inPropagation,
-                                vtkIdType& inNumSteps)
+                                vtkIdType& inNumSteps,
+                                int reportProgress)
 {
   int i;
   vtkIdType numLines = seedIds->GetNumberOfIds();
@@ -670,7 +702,10 @@ void vtkStreamTracer::Integrate(vtkDataSet *input0,
     {
 
     double progress = static_cast<double>(currentLine)/numLines;
-    this->UpdateProgress(progress);
+    if (reportProgress)
+      {
+      this->UpdateProgress(progress);
+      }
 
     switch (integrationDirections->GetValue(currentLine))
       {
@@ -782,9 +817,12 @@ void vtkStreamTracer::Integrate(vtkDataSet *input0,
 
       if ( numSteps++ % 1000 == 1 )
         {
-        progress =
-          ( currentLine + propagation / this->MaximumPropagation ) / numLines;
-        this->UpdateProgress(progress);
+        if (reportProgress)
+          {
+          progress = ( currentLine + propagation / this->MaximumPropagation )
+            / numLines;
+          this->UpdateProgress(progress);
+          }
 
         if (this->GetAbortExecute())
           {
@@ -817,7 +855,10 @@ void vtkStreamTracer::Integrate(vtkDataSet *input0,
           }
         maxStep = stepSize.Interval;
         }
-      this->LastUsedStepSize = stepSize.Interval;
+      if (reportProgress)
+        {
+        this->LastUsedStepSize = stepSize.Interval;
+        }
 
       // Calculate the next step using the integrator provided
       // Break if the next point is out of bounds.
@@ -1020,6 +1061,258 @@ void vtkStreamTracer::Integrate(vtkDataSet *input0,
   return;
 }
 
+namespace
+{
+// Per range inputs and outputs of the threads.  Range i holds seeds
+// [i*numSeeds/numThreads, (i+1)*numSeeds/numThreads).
+struct vtkStreamTracerThreadStruct
+{
+  vtkStreamTracer *Filter;
+  vtkDataSet *Input0;
+  vtkDataArray *SeedSource;
+  vtkIdList **SeedIds;
+  vtkIntArray **IntegrationDirections;
+  vtkAbstractInterpolatedVelocityField **Functions;
+  vtkPolyData **Outputs;
+  int MaxCellSize;
+  const char *VecName;
+};
+}
+
+VTK_THREAD_RETURN_TYPE vtkStreamTracer::ThreadedIntegrate( void *arg )
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkStreamTracerThreadStruct *str =
+    static_cast<vtkStreamTracerThreadStruct *>(info->UserData);
+
+  // The calling thread (thread 0) takes the last range, so that the
+  // progress it reports and the LastUsedStepSize it leaves are those of
+  // the end of the integration.
+  int range = (info->ThreadID + info->NumberOfThreads - 1) %
+    info->NumberOfThreads;
+  double lastPoint[3];
+  double propagation = 0;
+  vtkIdType numSteps = 0;
+  str->Filter->Integrate(str->Input0, str->Outputs[range],
+                         str->SeedSource, str->SeedIds[range],
+                         str->IntegrationDirections[range],
+                         lastPoint, str->Functions[range],
+                         str->MaxCellSize, str->VecName,
+                         propagation, numSteps, info->ThreadID == 0);
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+void vtkStreamTracer::IntegrateInParallel(vtkDataSet *input0,
+                                          vtkPolyData* output,
+                                          vtkDataArray* seedSource,
+                                          vtkIdList* seedIds,
+                                          vtkIntArray* integrationDirections,
+                                          vtkAbstractInterpolatedVelocityField* func,
+                                          int maxCellSize,
+                                          const char *vecName,
+                                          int numThreads)
+{
+  // The datasets given to func by CheckInputs(), in the same order
+  vtkstd::vector<vtkDataSet *> inputs;
+  vtkCompositeDataIterator* iter = this->InputData->NewIterator();
+  for (iter->GoToFirstItem(); !iter->IsDoneWithTraversal();
+       iter->GoToNextItem())
+    {
+    vtkDataSet* inp = vtkDataSet::SafeDownCast(iter->GetCurrentDataObject());
+    if (inp && inp->GetPointData()->GetVectors(vecName))
+      {
+      inputs.push_back(inp);
+      }
+    }
+  iter->Delete();
+
+  // Build the lazily created search structures of the datasets (point
+  // locator, cells and links, bounds) so that the threads only read them.
+  // Datasets searched through cell locators only need their cells.
+  vtkCellLocatorInterpolatedVelocityField *cellLocatorFunc =
+    vtkCellLocatorInterpolatedVelocityField::SafeDownCast(func);
+  vtkGenericCell* cell = vtkGenericCell::New();
+  double* weights = new double[maxCellSize > 0 ? maxCellSize : 1];
+  size_t k;
+  for (k=0; k < inputs.size(); k++)
+    {
+    vtkDataSet* inp = inputs[k];
+    if (inp->GetNumberOfCells() > 0)
+      {
+      inp->GetCell(0, cell);
+      if (!cellLocatorFunc)
+        {
+        double x[3], pcoords[3];
+        int subId;
+        inp->GetPoint(0, x);
+        inp->FindCell(x, 0, cell, -1, 0.0, subId, pcoords, weights);
+        }
+      }
+    inp->GetLength();
+    }
+  delete [] weights;
+  cell->Delete();
+
+  // Each range gets its own interpolator, hence its own cell cache
+  vtkIdType numSeeds = seedIds->GetNumberOfIds();
+  vtkIdList** rangeSeedIds = new vtkIdList* [numThreads];
+  vtkIntArray** rangeDirections = new vtkIntArray* [numThreads];
+  vtkAbstractInterpolatedVelocityField** functions =
+    new vtkAbstractInterpolatedVelocityField* [numThreads];
+  vtkPolyData** outputs = new vtkPolyData* [numThreads];
+  int range;
+  for (range=0; range < numThreads; range++)
+    {
+    vtkIdType begin = numSeeds*range/numThreads;
+    vtkIdType end = numSeeds*(range + 1)/numThreads;
+    rangeSeedIds[range] = vtkIdList::New();
+    rangeSeedIds[range]->SetNumberOfIds(end - begin);
+    rangeDirections[range] = vtkIntArray::New();
+    rangeDirections[range]->SetNumberOfTuples(end - begin);
+    for (vtkIdType i=begin; i < end; i++)
+      {
+      rangeSeedIds[range]->SetId(i - begin, seedIds->GetId(i));
+      rangeDirections[range]->SetValue(i - begin,
+                                       integrationDirections->GetValue(i));
+      }
+
+    functions[range] = func->NewInstance();
+    functions[range]->CopyParameters(func);
+    functions[range]->SelectVectors(vecName);
+    for (k=0; k < inputs.size(); k++)
+      {
+      functions[range]->AddDataSet(inputs[k]);
+      }
+    if (cellLocatorFunc)
+      {
+      vtkCellLocatorInterpolatedVelocityField::SafeDownCast(functions[range])
+        ->ShareCellLocators(cellLocatorFunc);
+      }
+
+    outputs[range] = vtkPolyData::New();
+    }
+
+  vtkStreamTracerThreadStruct str;
+  str.Filter = this;
+  str.Input0 = input0;
+  str.SeedSource = seedSource;
+  str.SeedIds = rangeSeedIds;
+  str.IntegrationDirections = rangeDirections;
+  str.Functions = functions;
+  str.Outputs = outputs;
+  str.MaxCellSize = maxCellSize;
+  str.VecName = vecName;
+
+  // Normals depend on the whole streamline only, they are generated once
+  // the ranges are merged.
+  bool generateNormals = this->GenerateNormalsInIntegrate;
+  this->GenerateNormalsInIntegrate = false;
+
+  vtkMultiThreader* threader = vtkMultiThreader::New();
+  threader->SetNumberOfThreads(numThreads);
+  threader->SetSingleMethod(vtkStreamTracer::ThreadedIntegrate, &str);
+  threader->SingleMethodExecute();
+  threader->Delete();
+
+  this->GenerateNormalsInIntegrate = generateNormals;
+
+  // A range without points was aborted or could not integrate at all
+  int complete = 1;
+  for (range=0; range < numThreads; range++)
+    {
+    if (!outputs[range]->GetPoints())
+      {
+      complete = 0;
+      }
+    }
+
+  if (complete)
+    {
+    // Merge the ranges in seed order.  The point data arrays of all
+    // ranges were allocated alike, the ones of the first range are
+    // extended with the tuples of the others.
+    vtkPoints* outputPoints = vtkPoints::New();
+    vtkDataArray* pointData = outputPoints->GetData();
+    vtkCellArray* outputLines = vtkCellArray::New();
+    vtkIntArray* retVals = vtkIntArray::New();
+    retVals->SetName("ReasonForTermination");
+    vtkDataSetAttributes* outputPD = output->GetPointData();
+    outputPD->ShallowCopy(outputs[0]->GetPointData());
+    int numArrays = outputPD->GetNumberOfArrays();
+
+    vtkIdType offset = 0;
+    for (range=0; range < numThreads; range++)
+      {
+      vtkPolyData* part = outputs[range];
+      vtkDataArray* partPointData = part->GetPoints()->GetData();
+      vtkIdType numPartPts = partPointData->GetNumberOfTuples();
+      vtkIdType i;
+      for (i=0; i < numPartPts; i++)
+        {
+        pointData->InsertNextTuple(i, partPointData);
+        }
+
+      vtkDataSetAttributes* partPD = part->GetPointData();
+      for (int a=0; range > 0 && a < numArrays; a++)
+        {
+        vtkAbstractArray* array = outputPD->GetAbstractArray(a);
+        vtkAbstractArray* partArray = partPD->GetAbstractArray(a);
+        for (i=0; i < numPartPts; i++)
+          {
+          array->InsertNextTuple(i, partArray);
+          }
+        }
+
+      vtkCellArray* partLines = part->GetLines();
+      vtkIdType npts, *pts;
+      for (partLines->InitTraversal(); partLines->GetNextCell(npts, pts); )
+        {
+        outputLines->InsertNextCell(npts);
+        for (i=0; i < npts; i++)
+          {
+          outputLines->InsertCellPoint(pts[i] + offset);
+          }
+        }
+
+      vtkIntArray* partRetVals = vtkIntArray::SafeDownCast(
+        part->GetCellData()->GetArray("ReasonForTermination"));
+      for (i=0; partRetVals && i < partRetVals->GetNumberOfTuples(); i++)
+        {
+        retVals->InsertNextValue(partRetVals->GetValue(i));
+        }
+      offset += numPartPts;
+      }
+
+    output->SetPoints(outputPoints);
+    if ( offset > 1 )
+      {
+      output->SetLines(outputLines);
+      if (this->GenerateNormalsInIntegrate)
+        {
+        this->GenerateNormals(output, 0, vecName);
+        }
+      output->GetCellData()->AddArray(retVals);
+      }
+    outputPoints->Delete();
+    outputLines->Delete();
+    retVals->Delete();
+    output->Squeeze();
+    }
+
+  for (range=0; range < numThreads; range++)
+    {
+    rangeSeedIds[range]->Delete();
+    rangeDirections[range]->Delete();
+    functions[range]->Delete();
+    outputs[range]->Delete();
+    }
+  delete [] rangeSeedIds;
+  delete [] rangeDirections;
+  delete [] functions;
+  delete [] outputs;
+}
+
 void vtkStreamTracer::GenerateNormals(vtkPolyData* output, double* firstNormal,
                                       const char *vecName)
 {
@@ -1230,6 +1523,7 @@ void vtkStreamTracer::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "Vorticity computation: "
      << (this->ComputeVorticity ? " On" : " Off") << endl;
   os << indent << "Rotation scale: " << this->RotationScale << endl;
+  os << indent << "Number of threads: " << this->NumberOfThreads << endl;
 }
 
 vtkExecutive* vtkStreamTracer::CreateDefaultExecutive()
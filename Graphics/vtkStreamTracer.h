@@ -67,6 +67,20 @@
 // a source object, traces will be generated from each point in the source
 // that is inside the dataset.
 //
+// The seeds are spread over NumberOfThreads threads, each integrating a
+// contiguous range of seeds with its own copy of the velocity field
+// interpolator. The search structures of the input (point or cell
+// locators, cell links) are built once before the threads start and are
+// then shared read-only. The streamlines are merged in seed order, so the
+// output is the same as with a single thread.
+//
+// .SECTION Caveats
+// When the input is a composite dataset whose blocks overlap, the search
+// for the first point of a streamline starts from the block in which the
+// previous streamline of the same thread ended. In that case a point lying
+// in several blocks may be interpolated from another block than with a
+// single thread.
+//
 // .SECTION See Also
 // vtkRibbonFilter vtkRuledSurfaceFilter vtkInitialValueProblemSolver
 // vtkRungeKutta2 vtkRungeKutta4 vtkRungeKutta45 vtkTemporalStreamTracer
@@ -286,6 +300,12 @@ public:
   // integration is of the same class as this prototype.
   void SetInterpolatorPrototype( vtkAbstractInterpolatedVelocityField * ivf );
 
+  // Description:
+  // Number of threads the seeds are integrated with. The default is
+  // vtkMultiThreader::GetGlobalDefaultNumberOfThreads().
+  vtkSetClampMacro(NumberOfThreads,int,1,VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads,int);
+
   // Description:
   // Set the type of the velocity field interpolator to determine whether
   // vtkInterpolatedVelocityField (INTERPOLATOR_WITH_DATASET_POINT_LOCATOR) or
@@ -313,6 +333,12 @@ protected:
 
   void CalculateVorticity( vtkGenericCell* cell, double pcoords[3],
                            vtkDoubleArray* cellVectors, double vorticity[3] );
+
+  // Description:
+  // Integrate a streamline from each seed into output. If reportProgress
+  // is off, neither progress events nor LastUsedStepSize are updated, so
+  // that several threads can integrate at once with their own output and
+  // func.
   void Integrate(vtkDataSet *input,
                  vtkPolyData* output,
                  vtkDataArray* seedSource,
@@ -323,7 +349,24 @@ protected:
                  int maxCellSize,
                  const char *vecFieldName,
                  double& propagation,
-                 vtkIdType& numSteps);
+                 vtkIdType& numSteps,
+                 int reportProgress=1);
+
+  // Description:
+  // Integrate the seeds with numThreads threads, each calling Integrate()
+  // on a contiguous range of seeds, and merge their streamlines into
+  // output in seed order. Only the calling thread, which integrates the
+  // last range, reports progress and sets LastUsedStepSize.
+  void IntegrateInParallel(vtkDataSet *input0,
+                           vtkPolyData* output,
+                           vtkDataArray* seedSource,
+                           vtkIdList* seedIds,
+                           vtkIntArray* integrationDirections,
+                           vtkAbstractInterpolatedVelocityField* func,
+                           int maxCellSize,
+                           const char *vecFieldName,
+                           int numThreads);
+  static VTK_THREAD_RETURN_TYPE ThreadedIntegrate( void *arg );
   void SimpleIntegrate(double seed[3],
                        double lastPoint[3],
                        double stepSize,
@@ -384,6 +427,8 @@ protected:
 
   vtkCompositeDataSet* InputData;
 
+  int NumberOfThreads;
+
 private:
   vtkStreamTracer(const vtkStreamTracer&);  // Not implemented.
   void operator=(const vtkStreamTracer&);  // Not implemented.
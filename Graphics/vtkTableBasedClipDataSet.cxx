@@ -57,9 +57,15 @@
 #include "vtkRectilinearGrid.h"
 #include "vtkUnstructuredGrid.h"
 #include "vtkGenericCell.h"
+#include "vtkMultiThreader.h"
 
 #include "vtkTableBasedClipCases.h"
 
+#include <vtkstd/vector>
+
+// Minimum number of cells clipped by each thread.
+#define VTK_TABLE_BASED_CLIP_MIN_CELLS_PER_THREAD 10000
+
 vtkStandardNewMacro( vtkTableBasedClipDataSet );
 vtkCxxSetObjectMacro( vtkTableBasedClipDataSet, ClipFunction, vtkImplicitFunction );
 
@@ -467,6 +473,7 @@ class vtkTableBasedClipperShapeList
     int            GetTotalNumberOfShapes() const;
     int            GetNumberOfLists() const;
     int            GetList(int, const int *& ) const;
+    void           AddShape( const int * );
   protected:
     int         ** list;
     int            currentList;
@@ -633,6 +640,8 @@ class  vtkTableBasedClipperVolumeFromVolume :
     void     AddVertex(int z, int v0)
              { this->vertices.AddVertex( z, v0 ); }
 
+    void     Append( const vtkTableBasedClipperVolumeFromVolume & );
+
   protected:
     vtkTableBasedClipperCentroidPointList centroid_list;
     vtkTableBasedClipperHexList     hexes;
@@ -827,6 +836,42 @@ int  vtkTableBasedClipperShapeList::GetTotalNumberOfShapes() const
   return numFullLists * shapesPerList + numExtra;
 }
 
+void vtkTableBasedClipperShapeList::AddShape( const int * shape )
+{
+  if ( currentShape >= shapesPerList )
+    {
+    if (  ( currentList + 1 ) >= listSize  )
+      {
+      int ** tmpList = new int * [ 2 * listSize ];
+      for ( int i = 0; i < listSize; i ++ )
+        {
+        tmpList[i] = list[i];
+        }
+          
+      for ( int i = listSize; i < listSize * 2; i ++ )
+        {
+        tmpList[i] = NULL;
+        }
+          
+      listSize *= 2;
+      delete [] list;
+      list = tmpList;
+      }
+ 
+    currentList ++;
+    list[ currentList ] = new int[  ( shapeSize + 1 ) * shapesPerList  ];
+    currentShape = 0;
+    }
+ 
+  // the cell id followed by the point ids
+  int idx = ( shapeSize + 1 ) * currentShape;
+  for ( int i = 0; i <= shapeSize; i ++ )
+    {
+    list[ currentList ][ idx + i ] = shape[i];
+    }
+  currentShape ++;
+}
+
 vtkTableBasedClipperHexList::vtkTableBasedClipperHexList()
     : vtkTableBasedClipperShapeList( 8 )
 {
@@ -1197,6 +1242,86 @@ void vtkTableBasedClipperVertexList::AddVertex( int cellId, int v1 )
   currentShape ++;
 }
 
+// Map a point id of a volume appended to another one: the edge points are
+// looked up in edgeLookup and the centroid points follow the centroids
+// already present.
+inline int vtkTableBasedClipperAppendedPointId( int pt, int numPrevPts,
+  int centroidOffset, const vtkstd::vector< int > & edgeLookup )
+{
+  if ( pt < 0 )
+    {
+    return pt - centroidOffset;
+    }
+  if ( pt >= numPrevPts )
+    {
+    return numPrevPts + edgeLookup[ pt - numPrevPts ];
+    }
+  return pt;
+}
+
+// Append the edge points, centroid points and shapes of a volume clipped
+// from the same input. The edge points are added through the hash table so
+// that those shared with this volume are not duplicated.
+void vtkTableBasedClipperVolumeFromVolume::
+     Append( const vtkTableBasedClipperVolumeFromVolume & other )
+{
+  int   i, j, k, l;
+  
+  vtkstd::vector< int > edgeLookup( other.pt_list.GetTotalNumberOfPoints() );
+  int ptIdx  = 0;
+  int nLists = other.pt_list.GetNumberOfLists();
+  for ( i = 0; i < nLists; i ++ )
+    {
+    const TableBasedClipperPointEntry * pe_list = NULL;
+    int nPts = other.pt_list.GetList( i, pe_list );
+    for ( j = 0; j < nPts; j ++ )
+      {
+      edgeLookup[ ptIdx ++ ] = edges.AddPoint
+        ( pe_list[j].ptIds[0], pe_list[j].ptIds[1], pe_list[j].percent );
+      }
+    }
+    
+  int centroidOffset = centroid_list.GetTotalNumberOfPoints();
+  nLists = other.centroid_list.GetNumberOfLists();
+  for ( i = 0; i < nLists; i ++ )
+    {
+    const TableBasedClipperCentroidPointEntry * ce_list = NULL;
+    int nPts = other.centroid_list.GetList( i, ce_list );
+    for ( j = 0; j < nPts; j ++ )
+      {
+      int ptIds[8];
+      for ( k = 0; k < ce_list[j].nPts; k ++ )
+        {
+        ptIds[k] = vtkTableBasedClipperAppendedPointId
+          ( ce_list[j].ptIds[k], numPrevPts, centroidOffset, edgeLookup );
+        }
+      centroid_list.AddPoint( ce_list[j].nPts, ptIds );
+      }
+    }
+    
+  for ( i = 0; i < nshapes; i ++ )
+    {
+    int npts_per_shape = shapes[i]->GetShapeSize();
+    nLists = other.shapes[i]->GetNumberOfLists();
+    for ( j = 0; j < nLists; j ++ )
+      {
+      const int * list;
+      int listSize = other.shapes[i]->GetList( j, list );
+      for ( k = 0; k < listSize; k ++ )
+        {
+        int shape[9];
+        shape[0] = *list ++; // the cell id
+        for ( l = 1; l <= npts_per_shape; l ++ )
+          {
+          shape[l] = vtkTableBasedClipperAppendedPointId
+                     ( *list ++, numPrevPts, centroidOffset, edgeLookup );
+          }
+        shapes[i]->AddShape( shape );
+        }
+      }
+    }
+}
+
 void vtkTableBasedClipperVolumeFromVolume::
      ConstructDataSet( vtkPointData * inPD, vtkCellData * inCD, 
                        vtkUnstructuredGrid * output, double * pts_ptr )
@@ -1569,551 +1694,291 @@ inline void GetPoint( double * pt, const double * X, const double * Y,
 // ============================================================================
 
 
-//-----------------------------------------------------------------------------
-// Construct with user-specified implicit function; InsideOut turned off; value
-// set to 0.0; and generate clip scalars turned off.
-vtkTableBasedClipDataSet::vtkTableBasedClipDataSet( vtkImplicitFunction * cf )
-{
-  this->Locator      = NULL;
-  this->ClipFunction = cf;
-  
-  // setup a callback to report progress
-  this->InternalProgressObserver = vtkCallbackCommand::New();
-  this->InternalProgressObserver->SetCallback
-        ( &vtkTableBasedClipDataSet::InternalProgressCallbackFunction );
-  this->InternalProgressObserver->SetClientData( this );
-  
-  this->Value     = 0.0;
-  this->InsideOut = 0;
-  this->MergeTolerance        = 0.01;
-  this->UseValueAsOffset      = true;
-  this->GenerateClipScalars   = 0;
-  this->GenerateClippedOutput = 0;
-
-  this->SetNumberOfOutputPorts( 2 );
-  vtkUnstructuredGrid * output2 = vtkUnstructuredGrid::New();
-  this->GetExecutive()->SetOutputData( 1, output2 );
-  output2->Delete();
-  output2 = NULL;
-
-  // process active point scalars by default
-  this->SetInputArrayToProcess
-        ( 0, 0, 0, vtkDataObject::FIELD_ASSOCIATION_POINTS,
-          vtkDataSetAttributes::SCALARS );
-
-  this->GetInformation()->Set( vtkAlgorithm::PRESERVES_RANGES(), 1 );
-  this->GetInformation()->Set( vtkAlgorithm::PRESERVES_BOUNDS(), 1 );
-}
-
-//-----------------------------------------------------------------------------
-vtkTableBasedClipDataSet::~vtkTableBasedClipDataSet()
-{
-  if ( this->Locator )
-    {
-    this->Locator->UnRegister( this );
-    this->Locator = NULL;
-    }
-  this->SetClipFunction( NULL );
-  this->InternalProgressObserver->Delete();
-  this->InternalProgressObserver = NULL;
-}
+// ============================================================================
+// ================= vtkTableBasedClipperCellClipping (begin) =================
+// ============================================================================
 
-//-----------------------------------------------------------------------------
-void vtkTableBasedClipDataSet::InternalProgressCallbackFunction
-   ( vtkObject * arg, unsigned long, void * clientdata, void * )
-{
-  reinterpret_cast < vtkTableBasedClipDataSet * > ( clientdata )
-    ->InternalProgressCallback(  static_cast < vtkAlgorithm * > ( arg )  );
-}
 
 //-----------------------------------------------------------------------------
-void vtkTableBasedClipDataSet::InternalProgressCallback
-   ( vtkAlgorithm * algorithm )
-{
-  double progress = algorithm->GetProgress();
-  this->UpdateProgress( progress );
+// Clip cells [firstCell, lastCell) of a structured or rectilinear grid of
+// gridDims points into visItVFV. Returns 0 if an invalid output shape or
+// point was found in the clip cases.
+static int vtkTableBasedClipperClipStructuredCells( const int gridDims[3],
+  vtkDataArray * clipAray, double isoValue, int insideOut,
+  vtkIdType firstCell, vtkIdType lastCell,
+  vtkTableBasedClipperVolumeFromVolume * visItVFV )
+{
+  int   j;
+  int   isValid     = 1;
+  int   isTwoDim    = int( gridDims[2] <= 1 );
+  int   shiftLUT[3][8] = { 
+                           { 0, 1, 1, 0, 0, 1, 1, 0 },
+                           { 0, 0, 1, 1, 0, 0, 1, 1 },
+                           { 0, 0, 0, 0, 1, 1, 1, 1 }
+                         };
+  int   numbPnts    = 0;
+  int   cellDims[3] = { gridDims[0] - 1, gridDims[1] - 1, gridDims[2] - 1 };
+  int   cyStride    = cellDims[0];
+  int   czStride    = cellDims[0] * cellDims[1];
+  int   pyStride    = gridDims[0];
+  int   pzStride    = gridDims[0] * gridDims[1];
+  int   i;
   
-  if ( this->AbortExecute )
-    {
-    algorithm->SetAbortExecute( 1 );
-    }
-}
-
-//-----------------------------------------------------------------------------
-unsigned long vtkTableBasedClipDataSet::GetMTime()
-{
-  unsigned long time;
-  unsigned long mTime = this->Superclass::GetMTime();
-
-  if ( this->ClipFunction != NULL )
+  for ( i = int( firstCell ); i < lastCell; i ++ )
     {
-    time  = this->ClipFunction->GetMTime();
-    mTime = ( time > mTime ? time : mTime );
-    }
+    int    caseIndx = 0;
+    int    theCellI = i % cellDims[0];
+    int    theCellJ = ( i / cyStride ) % cellDims[1];
+    int    theCellK = ( i / czStride );
+    double grdDiffs[8];
+       
+    numbPnts = isTwoDim ? 4 : 8;
     
-  if ( this->Locator != NULL )
-    {
-    time  = this->Locator->GetMTime();
-    mTime = ( time > mTime ? time : mTime );
-    }
-
-  return mTime;
-}
+    for ( j = numbPnts - 1; j >= 0; j -- )
+      {
+      int pntIndex = ( theCellI + shiftLUT[0][j] ) + 
+                     ( theCellJ + shiftLUT[1][j] ) * pyStride +
+                     ( theCellK + shiftLUT[2][j] ) * pzStride;
+                 
+      grdDiffs[j]  = clipAray->GetComponent( pntIndex, 0 ) - isoValue;
+      caseIndx    += (  ( grdDiffs[j] >= 0.0 ) ? 1 : 0  );
+      caseIndx   <<= (  1 - ( !j )  );
+      }
 
-vtkUnstructuredGrid *vtkTableBasedClipDataSet::GetClippedOutput()
-{
-  if ( !this->GenerateClippedOutput )
-    {
-    return NULL;
-    }
+    int             nOutputs;
+    int             intrpIds[4];
+    unsigned char * thisCase = NULL;
     
-  return vtkUnstructuredGrid::SafeDownCast
-        (  this->GetExecutive()->GetOutputData( 1 )  );
-}
-
-//-----------------------------------------------------------------------------
-void vtkTableBasedClipDataSet::SetLocator
-   ( vtkIncrementalPointLocator * locator )
-{
-  if ( this->Locator == locator)
-    {
-    return;
-    }
-  
-  if ( this->Locator )
-    {
-    this->Locator->UnRegister( this );
-    this->Locator = NULL;
-    }
-
-  if ( locator )
-    {
-    locator->Register( this );
-    }
-
-  this->Locator = locator;
-  this->Modified();
-}
-
-//-----------------------------------------------------------------------------
-void vtkTableBasedClipDataSet::CreateDefaultLocator()
-{
-  if ( this->Locator == NULL )
-    {
-    this->Locator = vtkMergePoints::New();
-    this->Locator->Register( this );
-    this->Locator->Delete();
-    }
-}
+    if ( isTwoDim )
+      {
+      thisCase = &vtkTableBasedClipperClipTables::ClipShapesQua
+               [  vtkTableBasedClipperClipTables::StartClipShapesQua[ caseIndx ]  ];
+      nOutputs = vtkTableBasedClipperClipTables::NumClipShapesQua[ caseIndx ];
+      }
+    else
+      {
+      thisCase = &vtkTableBasedClipperClipTables::ClipShapesHex
+               [  vtkTableBasedClipperClipTables::StartClipShapesHex[ caseIndx ]  ];
+      nOutputs = vtkTableBasedClipperClipTables::NumClipShapesHex[ caseIndx ];
+      }
 
-//-----------------------------------------------------------------------------
-int vtkTableBasedClipDataSet::FillInputPortInformation
-  ( int, vtkInformation * info )
-{
-  info->Set( vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(), "vtkDataSet" );
-  return 1;
-}
-
-//------------------------------------------------------------------------------
-int vtkTableBasedClipDataSet::ProcessRequest( vtkInformation* request,
-    vtkInformationVector ** inputVector, vtkInformationVector * outputVector )
-{
-  if (   request->Has(  vtkStreamingDemandDrivenPipeline::
-                        REQUEST_UPDATE_EXTENT_INFORMATION()  )   
-     )
-    {
-    // compute the priority for this UpdateExtent
-    double           priorVal = 1;
-    vtkInformation * inputInf = inputVector[0]->GetInformationObject( 0 );
-    vtkInformation * outInfor = outputVector->GetInformationObject( 0 );
-    
-    if (   inputInf->Has(  vtkStreamingDemandDrivenPipeline::PRIORITY()  )   )
-      {
-      priorVal = inputInf->Get( vtkStreamingDemandDrivenPipeline::PRIORITY() );
-      }
-      
-    if ( !priorVal )
+    for ( j = 0; j < nOutputs; j ++ )
       {
-      inputInf = NULL;
-      outInfor = NULL;
-      return 1;
-      }
+      int      nCellPts = 0;
+      int      intrpIdx = -1;
+      int      theColor = -1;
+      unsigned char theShape = *thisCase ++;
       
-    // Get bounds and evaluate implicit function. If all bounds
-    // evaluate to a value smaller than input value, this piece
-    // has priority set to 0.
+      switch ( theShape )
+        {
+        case ST_HEX:
+          nCellPts = 8;
+          theColor = *thisCase ++;
+          break;
+          
+        case ST_WDG:
+          nCellPts = 6;
+          theColor = *thisCase ++;
+          break;
+          
+        case ST_PYR:
+          nCellPts = 5;
+          theColor = *thisCase ++;
+          break;
+          
+        case ST_TET:
+          nCellPts = 4;
+          theColor = *thisCase ++;
+          break;
+          
+        case ST_QUA:
+          nCellPts = 4;
+          theColor = *thisCase ++;
+          break;
+          
+        case ST_TRI:
+          nCellPts = 3;
+          theColor = *thisCase ++;
+          break;
+          
+        case ST_LIN:
+          nCellPts = 2;
+          theColor = *thisCase ++;
+          break;
+          
+        case ST_VTX:
+          nCellPts = 1;
+          theColor = *thisCase ++;
+          break;
+          
+        case ST_PNT:
+          intrpIdx = *thisCase ++;
+          theColor = *thisCase ++;
+          nCellPts = *thisCase ++;
+          break;
+          
+        default:
+          isValid = 0;
+        }
 
-    double        priority   = 1;
-    double      * wholeBox   = NULL;
-    static double boundBox[] = { -1.0, 1.0, -1.0, 1.0, -1.0, 1.0 };
+      if ( (!insideOut && theColor == COLOR0 ) ||
+           ( insideOut && theColor == COLOR1 )
+         )
+        {
+        // We don't want this one; it's the wrong side.
+        thisCase += nCellPts;
+        continue;
+        }
 
-    // determine geometric bounds of this piece
-    wholeBox = inputInf->Get
-               ( vtkStreamingDemandDrivenPipeline::PIECE_BOUNDING_BOX() );
-    if ( !wholeBox )
-      {
-      wholeBox = inputInf->Get
-                 ( vtkStreamingDemandDrivenPipeline::WHOLE_BOUNDING_BOX() );
-      }
-      
-    if ( wholeBox )
-      {
-      boundBox[0] = wholeBox[0];
-      boundBox[1] = wholeBox[1];
-      boundBox[2] = wholeBox[2];
-      boundBox[3] = wholeBox[3];
-      boundBox[4] = wholeBox[4];
-      boundBox[5] = wholeBox[5];
-      wholeBox    = NULL;
-      }
-    else
-      {
-      //try to figure out geometric bounds
-      double * originPt = inputInf->Get( vtkDataObject::ORIGIN() );
-      double * spacings = inputInf->Get( vtkDataObject::SPACING() );
-      int    * subXtent = inputInf->Get
-                          ( vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT() );
-                           
-      if ( originPt && spacings && subXtent )
+      int   shapeIds[8];
+      for ( int p = 0; p < nCellPts; p ++ )
         {
-        boundBox[0] = originPt[0] + subXtent[0] * spacings[0];
-        boundBox[1] = originPt[0] + subXtent[1] * spacings[0];
-        boundBox[2] = originPt[1] + subXtent[2] * spacings[1];
-        boundBox[3] = originPt[1] + subXtent[3] * spacings[1];
-        boundBox[4] = originPt[2] + subXtent[4] * spacings[2];
-        boundBox[5] = originPt[2] + subXtent[5] * spacings[2];
-        originPt    = NULL;
-        spacings    = NULL;
-        subXtent    = NULL;
+        unsigned char pntIndex = *thisCase ++;
+        
+        if ( pntIndex <= P7 )
+          {
+          // We know pt P0 must be >P0 since we already
+          // assume P0 == 0.  This is why we do not
+          // bother subtracting P0 from pt here.
+          shapeIds[p] = 
+                      (   (  theCellI + shiftLUT[0][ pntIndex ]  ) +
+                          (  theCellJ + shiftLUT[1][ pntIndex ]  ) * pyStride +
+                          (  theCellK + shiftLUT[2][ pntIndex ]  ) * pzStride
+                      );
+          }
+        else 
+        if ( pntIndex >= EA && pntIndex <= EL )
+          {
+          int  pt1Index = vtkTableBasedClipperTriangulationTables::
+                          HexVerticesFromEdges[ pntIndex - EA ][0];
+          int  pt2Index = vtkTableBasedClipperTriangulationTables::
+                          HexVerticesFromEdges[ pntIndex - EA ][1];
+          
+          if ( pt2Index < pt1Index )
+            {
+            int temp = pt2Index;
+            pt2Index = pt1Index;
+            pt1Index = temp;
+            }
+          
+          double pt1ToPt2 = grdDiffs[ pt2Index] - grdDiffs[ pt1Index ];
+          double pt1ToIso = 0.0 - grdDiffs[ pt1Index ];
+          double p1Weight = 1.0 - pt1ToIso / pt1ToPt2;
+                                  
+          int    pntIndx1 = 
+                 (   (  theCellI + shiftLUT[0][ pt1Index ] ) +
+                     (  theCellJ + shiftLUT[1][ pt1Index ]  ) * pyStride +
+                     (  theCellK + shiftLUT[2][ pt1Index ]  ) * pzStride
+                 );
+          int    pntIndx2 = 
+                 (   (  theCellI + shiftLUT[0][ pt2Index ]  ) +
+                     (  theCellJ + shiftLUT[1][ pt2Index ]  ) * pyStride +
+                     (  theCellK + shiftLUT[2][ pt2Index ]  ) * pzStride
+                 );
+                  
+          shapeIds[p] = visItVFV->AddPoint( pntIndx1, pntIndx2, p1Weight );
+          }
+        else 
+        if ( pntIndex >= N0 && pntIndex <= N3 )
+          {
+          shapeIds[p] = intrpIds[ pntIndex - N0 ];
+          }
+        else
+          {
+          isValid = 0;
+          }
         }
-      else
+
+      switch ( theShape )
         {
-        outInfor->Set( vtkStreamingDemandDrivenPipeline::PRIORITY(), priorVal );
-        inputInf = NULL;
-        outInfor = NULL;
-        originPt = NULL;
-        spacings = NULL;
-        subXtent = NULL;
-        return 1;
+        case ST_HEX:
+          visItVFV->AddHex( i, shapeIds[0], shapeIds[1], 
+                               shapeIds[2], shapeIds[3], shapeIds[4], 
+                               shapeIds[5], shapeIds[6], shapeIds[7] );
+          break;
+          
+        case ST_WDG:
+          visItVFV->AddWedge( i, shapeIds[0], shapeIds[1], shapeIds[2],
+                                 shapeIds[3], shapeIds[4], shapeIds[5] );
+          break;
+          
+        case ST_PYR:
+          visItVFV->AddPyramid( i, shapeIds[0], shapeIds[1],
+                                   shapeIds[2], shapeIds[3], shapeIds[4] );
+          break;
+          
+        case ST_TET:
+          visItVFV->AddTet( i, shapeIds[0], shapeIds[1], 
+                               shapeIds[2], shapeIds[3] );
+          break;
+          
+        case ST_QUA:
+          visItVFV->AddQuad( i, shapeIds[0], shapeIds[1], 
+                                shapeIds[2], shapeIds[3] );
+          break;
+          
+        case ST_TRI:
+          visItVFV->AddTri( i, shapeIds[0], shapeIds[1], shapeIds[2] );
+          break;
+          
+        case ST_LIN:
+          visItVFV->AddLine( i, shapeIds[0], shapeIds[1] );
+          break;
+          
+        case ST_VTX:
+          visItVFV->AddVertex( i, shapeIds[0] );
+          break;
+          
+        case ST_PNT:
+          intrpIds[ intrpIdx ] = visItVFV->AddCentroidPoint
+                                           ( nCellPts, shapeIds );
+          break;
         }
       }
+      
+    thisCase = NULL;
+    }
+  
+  return isValid;
+}
 
-    vtkPlane * clipFunc = vtkPlane::SafeDownCast( this->GetClipFunction() );
-    if ( !clipFunc )
-      {
-      outInfor->Set( vtkStreamingDemandDrivenPipeline::PRIORITY(), priorVal );
-      inputInf = NULL;
-      outInfor = NULL;
-      return 1;
-      }
-
-    static double boxValue[8];
-    boxValue[0] = clipFunc->EvaluateFunction
-                            ( boundBox[0], boundBox[2], boundBox[4] );
-    boxValue[1] = clipFunc->EvaluateFunction
-                            ( boundBox[0], boundBox[2], boundBox[5] );
-    boxValue[2] = clipFunc->EvaluateFunction
-                            ( boundBox[0], boundBox[3], boundBox[4] );
-    boxValue[3] = clipFunc->EvaluateFunction
-                            ( boundBox[0], boundBox[3], boundBox[5] );
-    boxValue[4] = clipFunc->EvaluateFunction
-                            ( boundBox[1], boundBox[2], boundBox[4] );
-    boxValue[5] = clipFunc->EvaluateFunction
-                            ( boundBox[1], boundBox[2], boundBox[5] );
-    boxValue[6] = clipFunc->EvaluateFunction
-                            ( boundBox[1], boundBox[3], boundBox[4] );
-    boxValue[7] = clipFunc->EvaluateFunction
-                            ( boundBox[1], boundBox[3], boundBox[5] );
-    clipFunc    = NULL;
-
-    priority = 0;
-    for ( int i = 0; i < 8; i ++ )
-      {
-      if ( boxValue[i] > this->Value )
-        {
-        priority = priorVal;
-        break;
-        }
-      }
-    outInfor->Set( vtkStreamingDemandDrivenPipeline::PRIORITY(), priority );
-    
-    inputInf = NULL;
-    outInfor = NULL;
-    return 1;
-    }
-
-  //all other requests handled by superclass
-  return this->Superclass::ProcessRequest( request, inputVector, outputVector );
-}
-
-//-----------------------------------------------------------------------------
-int vtkTableBasedClipDataSet::RequestData( vtkInformation * vtkNotUsed( request ),
-    vtkInformationVector ** inputVector, vtkInformationVector * outputVector )
-{
-  // input and output information objects
-  vtkInformation * inputInf = inputVector[0]->GetInformationObject( 0 );
-  vtkInformation * outInfor = outputVector->GetInformationObject( 0 );
-
-  // Get the input of which we have to create a copy since the clipper requires
-  // that InterpolateAllocate() be invoked for the output based on its input in
-  // terms of the point data. If the input and output arrays are different, 
-  // vtkCell3D's Clip will fail. The last argument of InterpolateAllocate makes
-  // sure that arrays are shallow-copied from theInput to cpyInput.
-  vtkDataSet * theInput = vtkDataSet::SafeDownCast
-                          (  inputInf->Get( vtkDataObject::DATA_OBJECT() )  );
-  vtkSmartPointer< vtkDataSet > cpyInput;
-  cpyInput.TakeReference( theInput->NewInstance() );
-  cpyInput->CopyStructure( theInput  );
-  cpyInput->GetCellData()->PassData( theInput->GetCellData() );
-  cpyInput->GetPointData()
-          ->InterpolateAllocate( theInput->GetPointData(), 0, 0, 1 );
-
-  // get the output (the remaining and the clipped parts)
-  vtkUnstructuredGrid * outputUG = vtkUnstructuredGrid::SafeDownCast
-                        (  outInfor->Get( vtkDataObject::DATA_OBJECT() )  );
-  
-  inputInf = NULL;
-  outInfor = NULL;
-  theInput = NULL;
-  vtkDebugMacro( << "Clipping dataset" << endl );
-
-  
-  int  i;
-  vtkIdType  numbPnts = cpyInput->GetNumberOfPoints();
-
-  // handling exceptions
-  if ( numbPnts < 1 )
-    {
-    vtkDebugMacro( << "No data to clip" << endl );
-    outputUG = NULL;
-    return 1;
-    }
-
-  if ( !this->ClipFunction && this->GenerateClipScalars )
-    {
-    vtkErrorMacro( << "Cannot generate clip scalars "
-                   << "if no clip function defined" << endl );
-    outputUG = NULL;
-    return 1;
-    }
-
-
-  vtkDataArray   * clipAray = NULL;
-  vtkDoubleArray * pScalars = NULL;
-
-  // check whether the cells are clipped with input scalars or a clip function
-  if ( this->ClipFunction )
-    {
-    pScalars = vtkDoubleArray::New();
-    pScalars->SetNumberOfTuples( numbPnts );
-    pScalars->SetName( "ClipDataSetScalars" );
-    
-    // enable clipDataSetScalars to be passed to the output
-    if ( this->GenerateClipScalars )
-      {
-      cpyInput->GetPointData()->SetScalars( pScalars );
-      }
-      
-    for ( i = 0; i < numbPnts; i ++ )
-      {
-      double s = this->ClipFunction->FunctionValue(  cpyInput->GetPoint( i )  );
-      pScalars->SetTuple1( i, s );
-      }
-      
-    clipAray = pScalars;
-    }
-  else //using input scalars
-    {
-    clipAray = this->GetInputArrayToProcess( 0, inputVector );
-    if ( !clipAray ) 
-      {
-      vtkErrorMacro( << "no input scalars." << endl );
-      return 1;
-      }
-    }
-    
-  
-  int    gridType = cpyInput->GetDataObjectType(); 
-  double isoValue = ( !this->ClipFunction || this->UseValueAsOffset ) 
-                    ?  this->Value  :  0.0;               
-  if ( gridType == VTK_IMAGE_DATA || gridType == VTK_STRUCTURED_POINTS )
-    {
-    int   numbDims;
-    int * dataDims = vtkImageData::SafeDownCast( cpyInput )->GetDimensions();
-    for ( numbDims = 3, i = 0; i < 3; i ++ )
-      {
-      numbDims -= (  ( dataDims[i] <= 1 ) ? 1 : 0  );
-      }
-    dataDims = NULL;
-      
-    if ( numbDims == 3 )
-      {
-      this->ClipImageData( cpyInput.GetPointer(), clipAray, isoValue, outputUG );
-      }
-    }
-  else              
-  if ( gridType == VTK_POLY_DATA )
-    {
-    this->ClipPolyData( cpyInput.GetPointer(), clipAray, isoValue, outputUG );
-    }
-  else
-  if ( gridType == VTK_RECTILINEAR_GRID )
-    {
-    this->ClipRectilinearGridData( cpyInput.GetPointer(), clipAray, 
-                                   isoValue, outputUG );
-    }
-  else
-  if ( gridType == VTK_STRUCTURED_GRID )
-    {
-    this->ClipStructuredGridData( cpyInput.GetPointer(), clipAray, 
-                                  isoValue, outputUG );
-    }
-  else
-  if ( gridType == VTK_UNSTRUCTURED_GRID )
-    {
-    this->ClipUnstructuredGridData( cpyInput.GetPointer(), clipAray, 
-                                    isoValue, outputUG );
-    }
-  else
-    {
-    this->ClipDataSet( cpyInput.GetPointer(), clipAray, outputUG );
-    }
-    
-  outputUG->Squeeze();
-  
-  if ( pScalars )
-    {
-    pScalars->Delete();
-    }
-  pScalars = NULL;
-  outputUG = NULL;
-  clipAray = NULL;
-  
-  return 1;
-}
-
-//-----------------------------------------------------------------------------
-void vtkTableBasedClipDataSet::ClipDataSet( vtkDataSet * pDataSet, 
-     vtkDataArray * clipAray, vtkUnstructuredGrid * unstruct )
-{
-  vtkClipDataSet * clipData = vtkClipDataSet::New();
-  clipData->SetInput( pDataSet );
-  clipData->SetValue( this->Value );
-  clipData->SetInsideOut( this->InsideOut );
-  clipData->SetClipFunction( this->ClipFunction );
-  clipData->SetUseValueAsOffset( this->UseValueAsOffset );
-  clipData->SetGenerateClipScalars( this->GenerateClipScalars );
-  
-  if ( !this->ClipFunction )
-    {
-    pDataSet->GetPointData()->SetScalars( clipAray );
-    }
-    
-  clipData->Update();
-  unstruct->ShallowCopy( clipData->GetOutput() );
-  
-  clipData->Delete();
-  clipData = NULL;
-}
-
-//-----------------------------------------------------------------------------
-void vtkTableBasedClipDataSet::ClipImageData( vtkDataSet * inputGrd, 
-     vtkDataArray * clipAray, double isoValue, vtkUnstructuredGrid * outputUG )
-{
-  int                  i, j;
-  int                  dataDims[3];
-  double               spacings[3];
-  double               tmpValue = 0.0;
-  double             * dataBBox = NULL;
-  vtkImageData       * volImage = NULL;
-  vtkDoubleArray     * pxCoords = NULL;
-  vtkDoubleArray     * pyCoords = NULL;
-  vtkDoubleArray     * pzCoords = NULL;
-  vtkRectilinearGrid * rectGrid = NULL;
-  
-  volImage = vtkImageData::SafeDownCast( inputGrd );
-  volImage->GetDimensions( dataDims );
-  volImage->GetSpacing( spacings );
-  dataBBox = volImage->GetBounds();
-  
-  pxCoords = vtkDoubleArray::New();
-  pyCoords = vtkDoubleArray::New();
-  pzCoords = vtkDoubleArray::New();
-  vtkDoubleArray * tmpArays[3] = { pxCoords, pyCoords, pzCoords };
-  for ( j = 0; j < 3; j ++ )
-    {
-    tmpArays[j]->SetNumberOfComponents( 1 );
-    tmpArays[j]->SetNumberOfTuples( dataDims[j] );
-    for ( tmpValue  = dataBBox[ j << 1 ], i = 0; i < dataDims[j]; i ++, 
-          tmpValue += spacings[j] )
-      {
-      tmpArays[j]->SetComponent( i, 0, tmpValue );
-      }
-    tmpArays[j] = NULL;
-    }
-    
-  rectGrid = vtkRectilinearGrid::New();
-  rectGrid->SetDimensions( dataDims );
-  rectGrid->SetXCoordinates( pxCoords );
-  rectGrid->SetYCoordinates( pyCoords );
-  rectGrid->SetZCoordinates( pzCoords );
-  rectGrid->GetPointData()->ShallowCopy( volImage->GetPointData() );
-  rectGrid->GetCellData()->ShallowCopy( volImage->GetCellData() );
-  
-  this->ClipRectilinearGridData( rectGrid, clipAray, isoValue, outputUG );
-  
-  pxCoords->Delete();
-  pyCoords->Delete();
-  pzCoords->Delete();
-  rectGrid->Delete();
-  pxCoords = NULL;
-  pyCoords = NULL;
-  pzCoords = NULL;
-  rectGrid = NULL;
-  volImage = NULL;
-  dataBBox = NULL;
-}
-
-//-----------------------------------------------------------------------------
-void vtkTableBasedClipDataSet::ClipPolyData( vtkDataSet * inputGrd, 
-     vtkDataArray * clipAray, double isoValue, vtkUnstructuredGrid * outputUG )
-{
-  vtkPolyData * polyData = vtkPolyData::SafeDownCast( inputGrd );
-  int           numCells = polyData->GetNumberOfCells();
-
-  vtkTableBasedClipperVolumeFromVolume   * visItVFV = new
-  vtkTableBasedClipperVolumeFromVolume(    polyData->GetNumberOfPoints(),
-     int(   pow(  double( numCells ),  double( 0.6667f )  )   ) * 5 + 100    );
-
-  vtkUnstructuredGrid * specials = vtkUnstructuredGrid::New();
-  specials->SetPoints( polyData->GetPoints() );
-  specials->GetPointData()->ShallowCopy( polyData->GetPointData() );
-  specials->Allocate( numCells );
-
-  vtkIdType   i, j;
-  vtkIdType   numbPnts = 0;
-  int         numCants = 0;  // number of cells not clipped by this filter
-  
-  for ( i = 0; i < numCells; i ++ )
-    {
-    int         cellType = polyData->GetCellType( i );
-    bool        bCanClip = false;
-    vtkIdType * pntIndxs = NULL;
-    polyData->GetCellPoints( i, numbPnts, pntIndxs );
-    
-    switch ( cellType )
+//-----------------------------------------------------------------------------
+// Clip cells [firstCell, lastCell) of an unstructured grid into visItVFV.
+// The ids of the cells that the clip tables do not handle are appended to
+// specialIds. Returns 0 if an invalid output shape or point was found in the
+// clip cases.
+static int vtkTableBasedClipperClipUnstructuredCells
+  ( vtkUnstructuredGrid * unstruct, vtkDataArray * clipAray, double isoValue,
+    int insideOut, vtkIdType firstCell, vtkIdType lastCell,
+    vtkTableBasedClipperVolumeFromVolume * visItVFV,
+    vtkstd::vector< vtkIdType > & specialIds )
+{
+  vtkIdType   i, j;
+  vtkIdType   numbPnts = 0;
+  int         isValid  = 1;
+  
+  for ( i = firstCell; i < lastCell; i ++ )
+    {
+    int         cellType = unstruct->GetCellType( i );
+    vtkIdType * pntIndxs = NULL;
+    unstruct->GetCellPoints( i, numbPnts, pntIndxs );
+    
+    bool     bCanClip = false;
+    switch ( cellType )
       {
       case VTK_TETRA:
       case VTK_PYRAMID:
       case VTK_WEDGE:
       case VTK_HEXAHEDRON:
+      case VTK_VOXEL:
       case VTK_TRIANGLE:
       case VTK_QUAD:
+      case VTK_PIXEL:
       case VTK_LINE:
       case VTK_VERTEX:
            bCanClip = true;
            break;
-                       
+                        
       default:
            bCanClip = false;
            break;
@@ -2121,22 +1986,23 @@ void vtkTableBasedClipDataSet::ClipPolyData( vtkDataSet * inputGrd,
  
     if ( bCanClip )
       {
-      double    grdDiffs[8];
-      int       caseIndx = 0;
+      int    caseIndx = 0;
+      double grdDiffs[8];
       
-      for ( j = numbPnts - 1; j >= 0; j -- )
-        {   
+      for ( j = numbPnts-1; j >= 0; j -- )
+        {                 
         grdDiffs[j] = clipAray->GetComponent( pntIndxs[j], 0 ) - isoValue;
         caseIndx   += (  ( grdDiffs[j] >= 0.0 ) ? 1 : 0  );
         caseIndx  <<= (  1 - ( !j )  );
         }
 
-      int             startIdx = 0;
-      int             nOutputs = 0;
-      typedef int     EDGEIDXS[2];
-      EDGEIDXS      * edgeVtxs = NULL;
-      unsigned char * thisCase = NULL;
+      int               startIdx = 0;
+      int               nOutputs = 0;
+      typedef const int EDGEIDXS[2];
+      EDGEIDXS        * edgeVtxs = NULL;
+      unsigned char   * thisCase = NULL;
 
+      // start index, split case, number of output, and vertices from edges
       switch ( cellType )
         {
         case VTK_TETRA:
@@ -2171,6 +2037,14 @@ void vtkTableBasedClipDataSet::ClipPolyData( vtkDataSet * inputGrd,
                      vtkTableBasedClipperTriangulationTables::HexVerticesFromEdges;
           break;
           
+        case VTK_VOXEL:
+          startIdx = vtkTableBasedClipperClipTables::StartClipShapesVox[ caseIndx ];
+          thisCase =&vtkTableBasedClipperClipTables::ClipShapesVox[ startIdx ];
+          nOutputs = vtkTableBasedClipperClipTables::NumClipShapesVox[ caseIndx ];
+          edgeVtxs = ( EDGEIDXS * ) 
+                     vtkTableBasedClipperTriangulationTables::VoxVerticesFromEdges;
+          break;
+          
         case VTK_TRIANGLE:
           startIdx = vtkTableBasedClipperClipTables::StartClipShapesTri[ caseIndx ];
           thisCase =&vtkTableBasedClipperClipTables::ClipShapesTri[ startIdx ];
@@ -2187,908 +2061,876 @@ void vtkTableBasedClipDataSet::ClipPolyData( vtkDataSet * inputGrd,
                      vtkTableBasedClipperTriangulationTables::QuadVerticesFromEdges;
           break;
           
+        case VTK_PIXEL:
+          startIdx = vtkTableBasedClipperClipTables::StartClipShapesPix[ caseIndx ];
+          thisCase =&vtkTableBasedClipperClipTables::ClipShapesPix[ startIdx ];
+          nOutputs = vtkTableBasedClipperClipTables::NumClipShapesPix[ caseIndx ];
+          edgeVtxs = ( EDGEIDXS * ) 
+                     vtkTableBasedClipperTriangulationTables::PixelVerticesFromEdges;
+          break;
+          
         case VTK_LINE:
           startIdx = vtkTableBasedClipperClipTables::StartClipShapesLin[ caseIndx ];
           thisCase =&vtkTableBasedClipperClipTables::ClipShapesLin[ startIdx ];
           nOutputs = vtkTableBasedClipperClipTables::NumClipShapesLin[ caseIndx ];
           edgeVtxs = ( EDGEIDXS * ) 
-                     vtkTableBasedClipperTriangulationTables::LineVerticesFromEdges;
-          break;
-          
-        case VTK_VERTEX:
-          startIdx = vtkTableBasedClipperClipTables::StartClipShapesVtx[ caseIndx ];
-          thisCase =&vtkTableBasedClipperClipTables::ClipShapesVtx[ startIdx ];
-          nOutputs = vtkTableBasedClipperClipTables::NumClipShapesVtx[ caseIndx ];
-          edgeVtxs = NULL;
-          break;
-        }
-
-      int  intrpIds[4];
-      for ( j = 0; j < nOutputs; j ++ )
-        {
-        int      nCellPts = 0;
-        int      intrpIdx = -1;
-        int      theColor = -1;
-        unsigned char theShape = *thisCase ++;
-        
-        switch ( theShape )
-          {
-          case ST_HEX:
-            nCellPts = 8;
-            theColor = *thisCase ++;
-            break;
-            
-          case ST_WDG:
-            nCellPts = 6;
-            theColor = *thisCase ++;
-            break;
-            
-          case ST_PYR:
-            nCellPts = 5;
-            theColor = *thisCase ++;
-            break;
-          case ST_TET:
-            nCellPts = 4;
-            theColor = *thisCase ++;
-            break;
-            
-          case ST_QUA:
-            nCellPts = 4;
-            theColor = *thisCase ++;
-            break;
-            
-          case ST_TRI:
-            nCellPts = 3;
-            theColor = *thisCase ++;
-            break;
-            
-          case ST_LIN:
-            nCellPts = 2;
-            theColor = *thisCase ++;
-            break;
-            
-          case ST_VTX:
-            nCellPts = 1;
-            theColor = *thisCase ++;
-            break;
-            
-          case ST_PNT:
-            intrpIdx = *thisCase ++;
-            theColor = *thisCase ++;
-            nCellPts = *thisCase ++;
-            break;
-            
-          default:
-            vtkErrorMacro( << "An invalid output shape was found in "
-                           << "the ClipCases." << endl );
-          }
-
-        if ( (!this->InsideOut && theColor == COLOR0 ) ||
-             ( this->InsideOut && theColor == COLOR1 )
-           )
-          {
-          // We don't want this one; it's the wrong side.
-          thisCase += nCellPts;
-          continue;
-          }
-
-        int   shapeIds[8];
-        for ( int p = 0; p < nCellPts; p ++ )
-          {
-          unsigned char pntIndex = *thisCase ++;
-          
-          if ( pntIndex <= P7 )
-            {
-            shapeIds[p] = pntIndxs[ pntIndex ];
-            }
-          else 
-          if ( pntIndex >= EA && pntIndex <= EL )
-            {
-            int pt1Index = edgeVtxs[ pntIndex - EA ][0];
-            int pt2Index = edgeVtxs[ pntIndex - EA ][1];
-            if ( pt2Index < pt1Index )
-              {
-              int temp = pt2Index;
-              pt2Index = pt1Index;
-              pt1Index = temp;
-              }
-            double pt1ToPt2 = grdDiffs[ pt2Index ] - grdDiffs[ pt1Index ];
-            double pt1ToIso = 0.0 - grdDiffs[ pt1Index ];
-            double p1Weight = 1.0 - pt1ToIso / pt1ToPt2;
-
-            int    pntIndx1 = pntIndxs[ pt1Index ];
-            int    pntIndx2 = pntIndxs[ pt2Index ];
-            
-            shapeIds[p] = visItVFV->AddPoint( pntIndx1, pntIndx2, p1Weight );
-            }
-          else 
-          if ( pntIndex >= N0 && pntIndex <= N3 )
-            {
-            shapeIds[p] = intrpIds[ pntIndex - N0 ];
-            }
-          else
-            {
-            vtkErrorMacro( << "An invalid output point value "
-                           << "was found in the ClipCases." << endl );
-            }
-          }
-
+                     vtkTableBasedClipperTriangulationTables::LineVerticesFromEdges;
+          break;
+          
+        case VTK_VERTEX:
+          startIdx = vtkTableBasedClipperClipTables::StartClipShapesVtx[ caseIndx ];
+          thisCase =&vtkTableBasedClipperClipTables::ClipShapesVtx[ startIdx ];
+          nOutputs = vtkTableBasedClipperClipTables::NumClipShapesVtx[ caseIndx ];
+          edgeVtxs = NULL;
+          break;
+        }
+      
+      int   intrpIds[4];
+      for ( j = 0; j < nOutputs; j ++ )
+        {   
+        int      nCellPts = 0;
+        int      theColor = -1;
+        int      intrpIdx = -1;
+        unsigned char theShape = *thisCase ++;
+        
+        // number of points and color
         switch ( theShape )
           {
           case ST_HEX:
-            visItVFV->AddHex( i, shapeIds[0], shapeIds[1], 
-                                 shapeIds[2], shapeIds[3], shapeIds[4], 
-                                 shapeIds[5], shapeIds[6], shapeIds[7] );
+            nCellPts = 8;
+            theColor = *thisCase ++;
             break;
             
           case ST_WDG:
-            visItVFV->AddWedge( i, shapeIds[0], shapeIds[1], shapeIds[2],
-                                   shapeIds[3], shapeIds[4], shapeIds[5] );
+            nCellPts = 6;
+            theColor = *thisCase ++;
             break;
             
           case ST_PYR:
-            visItVFV->AddPyramid( i, shapeIds[0], shapeIds[1],
-                                     shapeIds[2], shapeIds[3], shapeIds[4] );
+            nCellPts = 5;
+            theColor = *thisCase ++;
             break;
             
           case ST_TET:
-            visItVFV->AddTet( i, shapeIds[0], shapeIds[1], 
-                                 shapeIds[2], shapeIds[3] );
+            nCellPts = 4;
+            theColor = *thisCase ++;
             break;
             
           case ST_QUA:
-            visItVFV->AddQuad( i, shapeIds[0], shapeIds[1], 
-                                  shapeIds[2], shapeIds[3] );
+            nCellPts = 4;
+            theColor = *thisCase ++;
             break;
             
           case ST_TRI:
-            visItVFV->AddTri( i, shapeIds[0], shapeIds[1], shapeIds[2] );
+            nCellPts = 3;
+            theColor = *thisCase ++;
             break;
             
           case ST_LIN:
-            visItVFV->AddLine( i, shapeIds[0], shapeIds[1] );
+            nCellPts = 2;
+            theColor = *thisCase ++;
             break;
             
           case ST_VTX:
-            visItVFV->AddVertex( i, shapeIds[0] );
+            nCellPts = 1;
+            theColor = *thisCase ++;
             break;
             
           case ST_PNT:
-            intrpIds[intrpIdx] = visItVFV->AddCentroidPoint( nCellPts, shapeIds );
-            break;
-          }
-        }
-        
-      edgeVtxs = NULL;
-      thisCase = NULL;
-      }
-    else
-      {
-      if ( numCants == 0 )
-        {
-        specials->GetCellData()
-                ->CopyAllocate( polyData->GetCellData(), numCells );
-        }
-
-      specials->InsertNextCell( cellType, numbPnts, pntIndxs );
-      specials->GetCellData()
-              ->CopyData( polyData->GetCellData(), i, numCants );
-      numCants ++;
-      }
-      
-    pntIndxs = NULL;
-    }
-  
-
-  int         toDelete = 0;
-  double    * theCords = NULL;
-  vtkPoints * inputPts = polyData->GetPoints();
-  if ( inputPts->GetDataType() == VTK_DOUBLE )
-    {
-    theCords = static_cast < double * > (  inputPts->GetVoidPointer( 0 )  );
-    }
-  else
-    {
-    toDelete = 1;
-    numbPnts = inputPts->GetNumberOfPoints();
-    theCords = new double [ numbPnts * 3 ];
-    for ( i = 0; i < numbPnts; i ++ )
-      {
-      inputPts->GetPoint( i, theCords + ( i << 1 ) + i );
-      }
-    }
-  inputPts = NULL;
-  
-
-  if ( numCants > 0 )
-    {
-    vtkUnstructuredGrid * vtkUGrid  = vtkUnstructuredGrid::New();
-    this->ClipDataSet( specials, clipAray, vtkUGrid );
-    
-    vtkUnstructuredGrid * visItGrd = vtkUnstructuredGrid::New();
-    visItVFV->ConstructDataSet( polyData->GetPointData(), 
-                                polyData->GetCellData(), visItGrd, theCords );
-
-    vtkAppendFilter * appender = vtkAppendFilter::New();
-    appender->AddInput( vtkUGrid );
-    appender->AddInput( visItGrd );
-    appender->Update();
-
-    outputUG->ShallowCopy( appender->GetOutput() );
-    
-    appender->Delete();
-    vtkUGrid->Delete();
-    visItGrd->Delete();
-    appender = NULL;
-    vtkUGrid = NULL;
-    visItGrd = NULL;
-    }
-  else
-    {
-    visItVFV->ConstructDataSet( polyData->GetPointData(), 
-                                polyData->GetCellData(), outputUG, theCords );
-    }
-
-
-  specials->Delete();
-  delete visItVFV;
-  if ( toDelete )
-    {
-    delete [] theCords;
-    }
-  specials = NULL;
-  visItVFV = NULL;
-  theCords = NULL;
-  polyData = NULL;
-}
-
-//-----------------------------------------------------------------------------
-void vtkTableBasedClipDataSet::ClipRectilinearGridData( vtkDataSet * inputGrd, 
-     vtkDataArray * clipAray, double isoValue, vtkUnstructuredGrid * outputUG )
-{
-  vtkRectilinearGrid * rectGrid = vtkRectilinearGrid::SafeDownCast( inputGrd );
-  
-  int   i, j;
-  int   numCells = 0;
-  int   isTwoDim = 0;
-  int   rectDims[3];
-  rectGrid->GetDimensions( rectDims );
-  isTwoDim = int( rectDims[2] <= 1 );
-  numCells = rectGrid->GetNumberOfCells();
-
-  vtkTableBasedClipperVolumeFromVolume   * visItVFV = new
-  vtkTableBasedClipperVolumeFromVolume(    rectGrid->GetNumberOfPoints(),
-      int(   pow(  double( numCells ), double( 0.6667f )  )   ) * 5 + 100    );
-
-  int   shiftLUT[3][8] = { 
-                           { 0, 1, 1, 0, 0, 1, 1, 0 },
-                           { 0, 0, 1, 1, 0, 0, 1, 1 },
-                           { 0, 0, 0, 0, 1, 1, 1, 1 }
-                         };
-  int   cellDims[3] = { rectDims[0] - 1, rectDims[1] - 1, rectDims[2] - 1 };
-  int   cyStride    = cellDims[0];
-  int   czStride    = cellDims[0] * cellDims[1];
-  int   pyStride    = rectDims[0];
-  int   pzStride    = rectDims[0] * rectDims[1];
-  
-  for ( i = 0; i < numCells; i ++ )
-    {     
-    int    caseIndx = 0;   
-    int    nCellPts = isTwoDim ? 4 : 8;
-    int    theCellI =   i % cellDims[0];
-    int    theCellJ = ( i / cyStride ) % cellDims[1];
-    int    theCellK = ( i / czStride );
-    double grdDiffs[8];
-    
-    for ( j = nCellPts - 1; j >= 0; j -- )
-      {   
-      grdDiffs[j] = clipAray->GetComponent
-                              (  ( theCellK + shiftLUT[2][j] ) * pzStride + 
-                                 ( theCellJ + shiftLUT[1][j] ) * pyStride + 
-                                 ( theCellI + shiftLUT[0][j] ),  0 
-                              ) - isoValue;
-      caseIndx   += (  ( grdDiffs[j] >= 0.0 ) ? 1 : 0  );
-      caseIndx  <<= (  1 - ( !j )  );
-      }
-
-    int             nOutputs;
-    int             intrpIds[4];
-    unsigned char * thisCase = NULL;
-    
-    if ( isTwoDim )
-      {
-      thisCase = &vtkTableBasedClipperClipTables::ClipShapesQua
-               [  vtkTableBasedClipperClipTables::StartClipShapesQua[ caseIndx ]  ];
-      nOutputs = vtkTableBasedClipperClipTables::NumClipShapesQua[ caseIndx ];
-      }
-    else
-      {
-      thisCase = &vtkTableBasedClipperClipTables::ClipShapesHex
-               [  vtkTableBasedClipperClipTables::StartClipShapesHex[ caseIndx ]  ];
-      nOutputs = vtkTableBasedClipperClipTables::NumClipShapesHex[ caseIndx ];
-      }
-
-    for ( j = 0; j < nOutputs; j++ )
-      {
-      int      intrpIdx = -1;
-      int      theColor = -1;
-      unsigned char theShape = *thisCase ++;
-      
-      nCellPts = 0;
-      switch ( theShape )
-        {
-        case ST_HEX:
-          nCellPts = 8;
-          theColor = *thisCase ++;
-          break;
-          
-        case ST_WDG:
-          nCellPts = 6;
-          theColor = *thisCase ++;
-          break;
-          
-        case ST_PYR:
-          nCellPts = 5;
-          theColor = *thisCase ++;
-          break;
-          
-        case ST_TET:
-          nCellPts = 4;
-          theColor = *thisCase ++;
-          break;
-          
-        case ST_QUA:
-          nCellPts = 4;
-          theColor = *thisCase ++;
-          break;
-          
-        case ST_TRI:
-          nCellPts = 3;
-          theColor = *thisCase ++;
-          break;
-          
-        case ST_LIN:
-          nCellPts = 2;
-          theColor = *thisCase ++;
-          break;
-          
-        case ST_VTX:
-          nCellPts = 1;
-          theColor = *thisCase ++;
-          break;
-          
-        case ST_PNT:
-          intrpIdx = *thisCase ++;
-          theColor = *thisCase ++;
-          nCellPts = *thisCase ++;
-          break;
-          
-        default:
-          vtkErrorMacro( << "An invalid output shape was found in "
-                         << "the ClipCases." << endl );
-        }
-
-      if ( (!this->InsideOut && theColor == COLOR0 ) ||
-           ( this->InsideOut && theColor == COLOR1 )
-         )
-        {
-        // We don't want this one; it's the wrong side.
-        thisCase += nCellPts;
-        continue;
-        }
-
-      int   shapeIds[8];
-      for ( int p = 0; p < nCellPts; p ++ )
-        {
-        unsigned char pntIndex = *thisCase ++;
+            intrpIdx = *thisCase ++;
+            theColor = *thisCase ++;
+            nCellPts = *thisCase ++;
+            break;
+            
+          default:
+            isValid = 0;
+          }
         
-        if ( pntIndex <= P7 )
+        if ( (!insideOut && theColor == COLOR0 ) ||
+             ( insideOut && theColor == COLOR1 )
+           )
           {
-          // We know pt P0 must be >P0 since we already
-          // assume P0 == 0.  This is why we do not
-          // bother subtracting P0 from pt here.
-          shapeIds[p] = 
-                      (   (  theCellI + shiftLUT[0][ pntIndex ]  ) +
-                          (  theCellJ + shiftLUT[1][ pntIndex ]  ) * pyStride +
-                          (  theCellK + shiftLUT[2][ pntIndex ]  ) * pzStride
-                      );
+          // We don't want this one; it's the wrong side.
+          thisCase += nCellPts;
+          continue; 
           }
-        else 
-        if ( pntIndex >= EA && pntIndex <= EL )
+        
+        int   shapeIds[8];
+        for ( int p = 0; p < nCellPts; p ++ )
           {
-          int pt1Index = vtkTableBasedClipperTriangulationTables::
-                         HexVerticesFromEdges[ pntIndex - EA ][0];
-          int pt2Index = vtkTableBasedClipperTriangulationTables::
-                         HexVerticesFromEdges[ pntIndex - EA ][1];
+          unsigned char pntIndex = *thisCase ++;
           
-          if ( pt2Index < pt1Index )
+          if ( pntIndex <= P7 )
             {
-            int temp = pt2Index;
-            pt2Index = pt1Index;
-            pt1Index = temp;
+            // We know pt P0 must be >P0 since we already
+            // assume P0 == 0.  This is why we do not
+            // bother subtracting P0 from pt here.
+            shapeIds[p] = pntIndxs[ pntIndex ];
             }
-            
-          double pt1ToPt2 = grdDiffs[ pt2Index ] - grdDiffs[ pt1Index ];
-          double pt1ToIso = 0.0 - grdDiffs[ pt1Index ];
-          double p1Weight = 1.0 - pt1ToIso / pt1ToPt2;
-
-          int    pntIndx1 = 
-                 (   (  theCellI + shiftLUT[0][ pt1Index ]  ) +
-                     (  theCellJ + shiftLUT[1][ pt1Index ]  ) * pyStride +
-                     (  theCellK + shiftLUT[2][ pt1Index ]  ) * pzStride
-                 );
-          int    pntIndx2 = 
-                 (   (  theCellI + shiftLUT[0][ pt2Index ]  ) +
-                     (  theCellJ + shiftLUT[1][ pt2Index ]  ) * pyStride +
-                     (  theCellK + shiftLUT[2][ pt2Index ]  ) * pzStride
-                 );
-
-          /* We may have physically (though not logically) degenerate cells
-          // if p1Weight == 0 or p1Weight == 1. We could pretty easily and 
-          // mostly safely clamp percent to the range [1e-4, 1 - 1e-4].
-          if( p1Weight == 1.0) 
+          else 
+          if ( pntIndex >= EA && pntIndex <= EL )
             {
-            shapeIds[p] = pntIndx1;
+            int  pt1Index = edgeVtxs[ pntIndex-EA ][0];
+            int  pt2Index = edgeVtxs[ pntIndex-EA ][1];
+            if ( pt2Index < pt1Index )
+              {
+              int temp = pt2Index;
+              pt2Index = pt1Index;
+              pt1Index = temp;
+              }
+            double pt1ToPt2 = grdDiffs[ pt2Index ] - grdDiffs[ pt1Index ];
+            double pt1ToIso = 0.0 - grdDiffs[ pt1Index ];
+            double p1Weight = 1.0 - pt1ToIso / pt1ToPt2;
+
+            int    pntIndx1 = pntIndxs[ pt1Index ];
+            int    pntIndx2 = pntIndxs[ pt2Index ];
+            
+            shapeIds[p] = visItVFV->AddPoint( pntIndx1, pntIndx2, p1Weight );
             }
           else 
-          if( p1Weight == 0.0 ) 
+          if ( pntIndex >= N0 && pntIndex <= N3 )
             {
-            shapeIds[p] = pntIndx2;
+            shapeIds[p] = intrpIds[ pntIndex - N0 ];
             }
           else
-          
             {
-            shapeIds[p] = visItVFV->AddPoint( pntIndx1, pntIndx2, p1Weight );
+            isValid = 0;
             }
-          */
-          
-          // Turning on the above code segment, the alternative, would cause
-          // a bug with a synthetic Wavelet dataset (vtkImageData) when the
-          // the clipping plane (x/y/z axis) is positioned exactly at (0,0,0).
-          // The problem occurs in the form of an open 'box', as opposed to an
-          // expected closed one. This is due to the use of hash instead of a
-          // point-locator based detection of duplicate points.
-          shapeIds[p] = visItVFV->AddPoint( pntIndx1, pntIndx2, p1Weight );
-          }
-        else 
-        if ( pntIndex >= N0 && pntIndex <= N3 )
-          {
-          shapeIds[p] = intrpIds[ pntIndex - N0 ];
           }
-        else
+        
+        switch ( theShape )
           {
-          vtkErrorMacro( << "An invalid output point value "
-                         << "was found in the ClipCases." << endl );
+          case ST_HEX:
+            visItVFV->AddHex( i, shapeIds[0], shapeIds[1], 
+                                 shapeIds[2], shapeIds[3], shapeIds[4], 
+                                 shapeIds[5], shapeIds[6], shapeIds[7] );
+            break;
+            
+          case ST_WDG:
+            visItVFV->AddWedge( i, shapeIds[0], shapeIds[1], shapeIds[2],
+                                   shapeIds[3], shapeIds[4], shapeIds[5] );
+            break;
+            
+          case ST_PYR:
+            visItVFV->AddPyramid( i, shapeIds[0], shapeIds[1],
+                                     shapeIds[2], shapeIds[3], shapeIds[4] );
+            break;
+            
+          case ST_TET:
+            visItVFV->AddTet( i, shapeIds[0], shapeIds[1], 
+                                 shapeIds[2], shapeIds[3] );
+            break;
+            
+          case ST_QUA:
+            visItVFV->AddQuad( i, shapeIds[0], shapeIds[1], 
+                                  shapeIds[2], shapeIds[3] );
+            break;
+            
+          case ST_TRI:
+            visItVFV->AddTri( i, shapeIds[0], shapeIds[1], shapeIds[2] );
+            break;
+            
+          case ST_LIN:
+            visItVFV->AddLine( i, shapeIds[0], shapeIds[1] ); 
+            break;
+            
+          case ST_VTX:
+            visItVFV->AddVertex( i, shapeIds[0] );
+            break;
+            
+          case ST_PNT:
+            intrpIds[ intrpIdx ] = visItVFV->AddCentroidPoint
+                                             ( nCellPts, shapeIds );
+            break;
           }
         }
-
-      switch ( theShape )
-        {
-        case ST_HEX:
-          visItVFV->AddHex( i, shapeIds[0], shapeIds[1], 
-                               shapeIds[2], shapeIds[3], shapeIds[4], 
-                               shapeIds[5], shapeIds[6], shapeIds[7] );
-          break;
-          
-        case ST_WDG:
-          visItVFV->AddWedge( i, shapeIds[0], shapeIds[1], shapeIds[2],
-                                 shapeIds[3], shapeIds[4], shapeIds[5] );
-          break;
-          
-        case ST_PYR:
-          visItVFV->AddPyramid( i, shapeIds[0], shapeIds[1],
-                                   shapeIds[2], shapeIds[3], shapeIds[4] );
-          break;
-          
-        case ST_TET:
-          visItVFV->AddTet( i, shapeIds[0], shapeIds[1], 
-                               shapeIds[2], shapeIds[3] );
-          break;
-          
-        case ST_QUA:
-          visItVFV->AddQuad( i, shapeIds[0], shapeIds[1], 
-                                shapeIds[2], shapeIds[3] );
-          break;
-          
-        case ST_TRI:
-          visItVFV->AddTri( i, shapeIds[0], shapeIds[1], shapeIds[2] );
-          break;
-          
-        case ST_LIN:
-          visItVFV->AddLine( i, shapeIds[0], shapeIds[1] );
-          break;
-          
-        case ST_VTX:
-          visItVFV->AddVertex( i, shapeIds[0] );
-          break;
-          
-        case ST_PNT:
-          intrpIds[ intrpIdx ] = visItVFV->AddCentroidPoint
-                                           ( nCellPts, shapeIds );
-          break;
-        }
+        
+      edgeVtxs = NULL;
+      thisCase = NULL;
+      }
+    else
+      {
+      // polyhedra and the cells the tables do not handle
+      specialIds.push_back( i );
       }
       
-    thisCase = NULL;
+    pntIndxs = NULL;
     }
   
+  return isValid;
+}
+
+// ---- vtkTableBasedClipperThreadStruct (begin)
+struct vtkTableBasedClipperThreadStruct
+{
+  vtkUnstructuredGrid * Unstructured; // NULL for structured grids
+  int                 * Dims;
+  vtkDataArray        * ClipArray;
+  double                IsoValue;
+  int                   InsideOut;
+  vtkIdType             NumberOfCells;
+  int                   NumberOfThreads;
+  vtkstd::vector< vtkTableBasedClipperVolumeFromVolume * > Volumes;
+  vtkstd::vector< vtkstd::vector< vtkIdType > > SpecialIds;
+  vtkstd::vector< int > IsValid;
+};
+// ---- vtkTableBasedClipperThreadStruct (end)
+
+// Each thread clips a contiguous batch of cells into its own volume.
+static VTK_THREAD_RETURN_TYPE vtkTableBasedClipperThreadedClip( void * arg )
+{
+  vtkMultiThreader::ThreadInfo * info = 
+    static_cast< vtkMultiThreader::ThreadInfo * >( arg );
+  vtkTableBasedClipperThreadStruct * ts = 
+    static_cast< vtkTableBasedClipperThreadStruct * >( info->UserData );
+  int threadId = info->ThreadID;
   
-  int            toDelete    = 0;
-  double       * theCords[3] = { NULL, NULL, NULL };
-  vtkDataArray * theArays[3] = { NULL, NULL, NULL };
+  vtkIdType firstCell = ts->NumberOfCells * threadId / ts->NumberOfThreads;
+  vtkIdType lastCell  = ts->NumberOfCells * ( threadId + 1 ) 
+                        / ts->NumberOfThreads;
+  if ( ts->Unstructured )
+    {
+    ts->IsValid[ threadId ] = vtkTableBasedClipperClipUnstructuredCells
+      ( ts->Unstructured, ts->ClipArray, ts->IsoValue, ts->InsideOut,
+        firstCell, lastCell, ts->Volumes[ threadId ], 
+        ts->SpecialIds[ threadId ] );
+    }
+  else
+    {
+    ts->IsValid[ threadId ] = vtkTableBasedClipperClipStructuredCells
+      ( ts->Dims, ts->ClipArray, ts->IsoValue, ts->InsideOut,
+        firstCell, lastCell, ts->Volumes[ threadId ] );
+    }
+    
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//-----------------------------------------------------------------------------
+// Clip all the cells of a structured or rectilinear grid (unstruct is NULL)
+// or of an unstructured grid into visItVFV. Large grids are split into
+// batches of cells clipped concurrently into separate volumes that are then
+// appended to visItVFV in cell order, so that the output is the same for
+// any number of threads. Returns 0 if an invalid output shape or point was
+// found in the clip cases.
+static int vtkTableBasedClipperClipCells( vtkUnstructuredGrid * unstruct,
+  int * dims, vtkDataArray * clipAray, double isoValue, int insideOut,
+  vtkIdType numCells, int numThreads, 
+  vtkTableBasedClipperVolumeFromVolume * visItVFV, int numPts,
+  vtkstd::vector< vtkIdType > & specialIds )
+{
+  int maxThreads = vtkMultiThreader::GetGlobalMaximumNumberOfThreads();
+  if ( maxThreads > 0 && numThreads > maxThreads )
+    {
+    numThreads = maxThreads;
+    }
+  if ( numThreads > numCells / VTK_TABLE_BASED_CLIP_MIN_CELLS_PER_THREAD )
+    {
+    numThreads = int( numCells / VTK_TABLE_BASED_CLIP_MIN_CELLS_PER_THREAD );
+    }
+    
+  if ( numThreads <= 1 )
+    {
+    if ( unstruct )
+      {
+      return vtkTableBasedClipperClipUnstructuredCells( unstruct, clipAray, 
+               isoValue, insideOut, 0, numCells, visItVFV, specialIds );
+      }
+    return vtkTableBasedClipperClipStructuredCells
+             ( dims, clipAray, isoValue, insideOut, 0, numCells, visItVFV );
+    }
+    
+  int   i;
+  int   batchSize = int( numCells / numThreads ) + 1;
+  vtkTableBasedClipperThreadStruct ts;
+  ts.Unstructured    = unstruct;
+  ts.Dims            = dims;
+  ts.ClipArray       = clipAray;
+  ts.IsoValue        = isoValue;
+  ts.InsideOut       = insideOut;
+  ts.NumberOfCells   = numCells;
+  ts.NumberOfThreads = numThreads;
+  ts.Volumes.resize( numThreads );
+  ts.SpecialIds.resize( numThreads );
+  ts.IsValid.resize( numThreads, 1 );
+  for ( i = 0; i < numThreads; i ++ )
+    {
+    ts.Volumes[i] = new vtkTableBasedClipperVolumeFromVolume( numPts,
+      int(   pow(  double( batchSize ), double( 0.6667f )  )   ) * 5 + 100 );
+    }
+  
+  vtkMultiThreader * threader = vtkMultiThreader::New();
+  threader->SetNumberOfThreads( numThreads );
+  threader->SetSingleMethod( vtkTableBasedClipperThreadedClip, &ts );
+  threader->SingleMethodExecute();
+  threader->Delete();
+  threader = NULL;
+  
+  // Append the batches in order: the edge points shared between batches are
+  // merged through the edge hash of visItVFV, keeping the first occurrence.
+  int   isValid = 1;
+  for ( i = 0; i < numThreads; i ++ )
+    {
+    visItVFV->Append( *ts.Volumes[i] );
+    delete ts.Volumes[i];
+    ts.Volumes[i] = NULL;
+    specialIds.insert( specialIds.end(), ts.SpecialIds[i].begin(), 
+                       ts.SpecialIds[i].end() );
+    isValid = isValid && ts.IsValid[i];
+    }
+    
+  return isValid;
+}
+// ============================================================================
+// ================== vtkTableBasedClipperCellClipping (end) ==================
+// ============================================================================
+
+
+//-----------------------------------------------------------------------------
+// Construct with user-specified implicit function; InsideOut turned off; value
+// set to 0.0; and generate clip scalars turned off.
+vtkTableBasedClipDataSet::vtkTableBasedClipDataSet( vtkImplicitFunction * cf )
+{
+  this->Locator      = NULL;
+  this->ClipFunction = cf;
+  
+  // setup a callback to report progress
+  this->InternalProgressObserver = vtkCallbackCommand::New();
+  this->InternalProgressObserver->SetCallback
+        ( &vtkTableBasedClipDataSet::InternalProgressCallbackFunction );
+  this->InternalProgressObserver->SetClientData( this );
+  
+  this->Value     = 0.0;
+  this->InsideOut = 0;
+  this->MergeTolerance        = 0.01;
+  this->UseValueAsOffset      = true;
+  this->GenerateClipScalars   = 0;
+  this->GenerateClippedOutput = 0;
+  this->NumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+
+  this->SetNumberOfOutputPorts( 2 );
+  vtkUnstructuredGrid * output2 = vtkUnstructuredGrid::New();
+  this->GetExecutive()->SetOutputData( 1, output2 );
+  output2->Delete();
+  output2 = NULL;
+
+  // process active point scalars by default
+  this->SetInputArrayToProcess
+        ( 0, 0, 0, vtkDataObject::FIELD_ASSOCIATION_POINTS,
+          vtkDataSetAttributes::SCALARS );
+
+  this->GetInformation()->Set( vtkAlgorithm::PRESERVES_RANGES(), 1 );
+  this->GetInformation()->Set( vtkAlgorithm::PRESERVES_BOUNDS(), 1 );
+}
+
+//-----------------------------------------------------------------------------
+vtkTableBasedClipDataSet::~vtkTableBasedClipDataSet()
+{
+  if ( this->Locator )
+    {
+    this->Locator->UnRegister( this );
+    this->Locator = NULL;
+    }
+  this->SetClipFunction( NULL );
+  this->InternalProgressObserver->Delete();
+  this->InternalProgressObserver = NULL;
+}
+
+//-----------------------------------------------------------------------------
+void vtkTableBasedClipDataSet::InternalProgressCallbackFunction
+   ( vtkObject * arg, unsigned long, void * clientdata, void * )
+{
+  reinterpret_cast < vtkTableBasedClipDataSet * > ( clientdata )
+    ->InternalProgressCallback(  static_cast < vtkAlgorithm * > ( arg )  );
+}
+
+//-----------------------------------------------------------------------------
+void vtkTableBasedClipDataSet::InternalProgressCallback
+   ( vtkAlgorithm * algorithm )
+{
+  double progress = algorithm->GetProgress();
+  this->UpdateProgress( progress );
   
-  if ( rectGrid->GetXCoordinates()->GetDataType() == VTK_DOUBLE &&
-       rectGrid->GetYCoordinates()->GetDataType() == VTK_DOUBLE &&
-       rectGrid->GetZCoordinates()->GetDataType() == VTK_DOUBLE
-     )
+  if ( this->AbortExecute )
     {
-    theCords[0] = static_cast < double * > 
-                  (  rectGrid->GetXCoordinates()->GetVoidPointer( 0 )  );
-    theCords[1] = static_cast < double * > 
-                  (  rectGrid->GetYCoordinates()->GetVoidPointer( 0 )  );
-    theCords[2] = static_cast < double * >
-                  (  rectGrid->GetZCoordinates()->GetVoidPointer( 0 )  );
+    algorithm->SetAbortExecute( 1 );
     }
-  else
+}
+
+//-----------------------------------------------------------------------------
+unsigned long vtkTableBasedClipDataSet::GetMTime()
+{
+  unsigned long time;
+  unsigned long mTime = this->Superclass::GetMTime();
+
+  if ( this->ClipFunction != NULL )
     {
-    toDelete    = 1;
-    theArays[0] = rectGrid->GetXCoordinates();
-    theArays[1] = rectGrid->GetYCoordinates();
-    theArays[2] = rectGrid->GetZCoordinates();
-    for ( j = 0; j < 3; j ++ )
-      {
-      theCords[j] = new double [ rectDims[j] ];
-      for ( i = 0; i < rectDims[j]; i ++ )
-        {
-        theCords[j][i] = theArays[j]->GetComponent( i, 0 );
-        }
-      theArays[j] = NULL;
-      }
+    time  = this->ClipFunction->GetMTime();
+    mTime = ( time > mTime ? time : mTime );
+    }
+    
+  if ( this->Locator != NULL )
+    {
+    time  = this->Locator->GetMTime();
+    mTime = ( time > mTime ? time : mTime );
     }
 
-  visItVFV->ConstructDataSet
-            ( rectGrid->GetPointData(), rectGrid->GetCellData(), 
-              outputUG, rectDims, theCords[0], theCords[1], theCords[2] );
-              
-  delete visItVFV;
-  visItVFV = NULL;
-  rectGrid = NULL;
-  
-  for ( i = 0; i < 3; i ++ )
+  return mTime;
+}
+
+vtkUnstructuredGrid *vtkTableBasedClipDataSet::GetClippedOutput()
+{
+  if ( !this->GenerateClippedOutput )
     {
-    if ( toDelete )
-      {
-      delete [] theCords[i];
-      }
-    theCords[i] = NULL;
+    return NULL;
     }
+    
+  return vtkUnstructuredGrid::SafeDownCast
+        (  this->GetExecutive()->GetOutputData( 1 )  );
 }
 
 //-----------------------------------------------------------------------------
-void vtkTableBasedClipDataSet::ClipStructuredGridData( vtkDataSet * inputGrd, 
-     vtkDataArray * clipAray, double isoValue, vtkUnstructuredGrid * outputUG )
+void vtkTableBasedClipDataSet::SetLocator
+   ( vtkIncrementalPointLocator * locator )
 {
-  vtkStructuredGrid * strcGrid = vtkStructuredGrid::SafeDownCast( inputGrd );
+  if ( this->Locator == locator)
+    {
+    return;
+    }
   
-  int   i, j;
-  int   isTwoDim    = 0;
-  int   numCells    = 0;
-  int   gridDims[3] = { 0, 0, 0 };
-  strcGrid->GetDimensions( gridDims );
-  isTwoDim = int( gridDims[2] <= 1 );
-  numCells = strcGrid->GetNumberOfCells();
+  if ( this->Locator )
+    {
+    this->Locator->UnRegister( this );
+    this->Locator = NULL;
+    }
 
-  vtkTableBasedClipperVolumeFromVolume  *  visItVFV = new
-  vtkTableBasedClipperVolumeFromVolume(    strcGrid->GetNumberOfPoints(),
-      int(   pow(  double( numCells ), double( 0.6667f )  )   ) * 5 + 100    );
+  if ( locator )
+    {
+    locator->Register( this );
+    }
 
-  
-  int   shiftLUT[3][8] = { 
-                           { 0, 1, 1, 0, 0, 1, 1, 0 },
-                           { 0, 0, 1, 1, 0, 0, 1, 1 },
-                           { 0, 0, 0, 0, 1, 1, 1, 1 }
-                         };
-  int   numbPnts    = 0;
-  int   cellDims[3] = { gridDims[0] - 1, gridDims[1] - 1, gridDims[2] - 1 };
-  int   cyStride    = cellDims[0];
-  int   czStride    = cellDims[0] * cellDims[1];
-  int   pyStride    = gridDims[0];
-  int   pzStride    = gridDims[0] * gridDims[1];
-  
-  for ( i = 0; i < numCells; i ++ )
+  this->Locator = locator;
+  this->Modified();
+}
+
+//-----------------------------------------------------------------------------
+void vtkTableBasedClipDataSet::CreateDefaultLocator()
+{
+  if ( this->Locator == NULL )
     {
-    int    caseIndx = 0;
-    int    theCellI = i % cellDims[0];
-    int    theCellJ = ( i / cyStride ) % cellDims[1];
-    int    theCellK = ( i / czStride );
-    double grdDiffs[8];
-       
-    numbPnts = isTwoDim ? 4 : 8;
-    
-    for ( j = numbPnts - 1; j >= 0; j -- )
-      {
-      int pntIndex = ( theCellI + shiftLUT[0][j] ) + 
-                     ( theCellJ + shiftLUT[1][j] ) * pyStride +
-                     ( theCellK + shiftLUT[2][j] ) * pzStride;
-                 
-      grdDiffs[j]  = clipAray->GetComponent( pntIndex, 0 ) - isoValue;
-      caseIndx    += (  ( grdDiffs[j] >= 0.0 ) ? 1 : 0  );
-      caseIndx   <<= (  1 - ( !j )  );
-      }
+    this->Locator = vtkMergePoints::New();
+    this->Locator->Register( this );
+    this->Locator->Delete();
+    }
+}
 
-    int             nOutputs;
-    int             intrpIds[4];
-    unsigned char * thisCase = NULL;
+//-----------------------------------------------------------------------------
+int vtkTableBasedClipDataSet::FillInputPortInformation
+  ( int, vtkInformation * info )
+{
+  info->Set( vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(), "vtkDataSet" );
+  return 1;
+}
+
+//------------------------------------------------------------------------------
+int vtkTableBasedClipDataSet::ProcessRequest( vtkInformation* request,
+    vtkInformationVector ** inputVector, vtkInformationVector * outputVector )
+{
+  if (   request->Has(  vtkStreamingDemandDrivenPipeline::
+                        REQUEST_UPDATE_EXTENT_INFORMATION()  )   
+     )
+    {
+    // compute the priority for this UpdateExtent
+    double           priorVal = 1;
+    vtkInformation * inputInf = inputVector[0]->GetInformationObject( 0 );
+    vtkInformation * outInfor = outputVector->GetInformationObject( 0 );
     
-    if ( isTwoDim )
+    if (   inputInf->Has(  vtkStreamingDemandDrivenPipeline::PRIORITY()  )   )
       {
-      thisCase = &vtkTableBasedClipperClipTables::ClipShapesQua
-               [  vtkTableBasedClipperClipTables::StartClipShapesQua[ caseIndx ]  ];
-      nOutputs = vtkTableBasedClipperClipTables::NumClipShapesQua[ caseIndx ];
+      priorVal = inputInf->Get( vtkStreamingDemandDrivenPipeline::PRIORITY() );
       }
-    else
+      
+    if ( !priorVal )
       {
-      thisCase = &vtkTableBasedClipperClipTables::ClipShapesHex
-               [  vtkTableBasedClipperClipTables::StartClipShapesHex[ caseIndx ]  ];
-      nOutputs = vtkTableBasedClipperClipTables::NumClipShapesHex[ caseIndx ];
+      inputInf = NULL;
+      outInfor = NULL;
+      return 1;
       }
-
-    for ( j = 0; j < nOutputs; j ++ )
-      {
-      int      nCellPts = 0;
-      int      intrpIdx = -1;
-      int      theColor = -1;
-      unsigned char theShape = *thisCase ++;
       
-      switch ( theShape )
-        {
-        case ST_HEX:
-          nCellPts = 8;
-          theColor = *thisCase ++;
-          break;
-          
-        case ST_WDG:
-          nCellPts = 6;
-          theColor = *thisCase ++;
-          break;
-          
-        case ST_PYR:
-          nCellPts = 5;
-          theColor = *thisCase ++;
-          break;
-          
-        case ST_TET:
-          nCellPts = 4;
-          theColor = *thisCase ++;
-          break;
-          
-        case ST_QUA:
-          nCellPts = 4;
-          theColor = *thisCase ++;
-          break;
-          
-        case ST_TRI:
-          nCellPts = 3;
-          theColor = *thisCase ++;
-          break;
-          
-        case ST_LIN:
-          nCellPts = 2;
-          theColor = *thisCase ++;
-          break;
-          
-        case ST_VTX:
-          nCellPts = 1;
-          theColor = *thisCase ++;
-          break;
-          
-        case ST_PNT:
-          intrpIdx = *thisCase ++;
-          theColor = *thisCase ++;
-          nCellPts = *thisCase ++;
-          break;
-          
-        default:
-          vtkErrorMacro( << "An invalid output shape was found in "
-                         << "the ClipCases." << endl );
-        }
+    // Get bounds and evaluate implicit function. If all bounds
+    // evaluate to a value smaller than input value, this piece
+    // has priority set to 0.
+
+    double        priority   = 1;
+    double      * wholeBox   = NULL;
+    static double boundBox[] = { -1.0, 1.0, -1.0, 1.0, -1.0, 1.0 };
 
-      if ( (!this->InsideOut && theColor == COLOR0 ) ||
-           ( this->InsideOut && theColor == COLOR1 )
-         )
+    // determine geometric bounds of this piece
+    wholeBox = inputInf->Get
+               ( vtkStreamingDemandDrivenPipeline::PIECE_BOUNDING_BOX() );
+    if ( !wholeBox )
+      {
+      wholeBox = inputInf->Get
+                 ( vtkStreamingDemandDrivenPipeline::WHOLE_BOUNDING_BOX() );
+      }
+      
+    if ( wholeBox )
+      {
+      boundBox[0] = wholeBox[0];
+      boundBox[1] = wholeBox[1];
+      boundBox[2] = wholeBox[2];
+      boundBox[3] = wholeBox[3];
+      boundBox[4] = wholeBox[4];
+      boundBox[5] = wholeBox[5];
+      wholeBox    = NULL;
+      }
+    else
+      {
+      //try to figure out geometric bounds
+      double * originPt = inputInf->Get( vtkDataObject::ORIGIN() );
+      double * spacings = inputInf->Get( vtkDataObject::SPACING() );
+      int    * subXtent = inputInf->Get
+                          ( vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT() );
+                           
+      if ( originPt && spacings && subXtent )
         {
-        // We don't want this one; it's the wrong side.
-        thisCase += nCellPts;
-        continue;
+        boundBox[0] = originPt[0] + subXtent[0] * spacings[0];
+        boundBox[1] = originPt[0] + subXtent[1] * spacings[0];
+        boundBox[2] = originPt[1] + subXtent[2] * spacings[1];
+        boundBox[3] = originPt[1] + subXtent[3] * spacings[1];
+        boundBox[4] = originPt[2] + subXtent[4] * spacings[2];
+        boundBox[5] = originPt[2] + subXtent[5] * spacings[2];
+        originPt    = NULL;
+        spacings    = NULL;
+        subXtent    = NULL;
         }
-
-      int   shapeIds[8];
-      for ( int p = 0; p < nCellPts; p ++ )
+      else
         {
-        unsigned char pntIndex = *thisCase ++;
-        
-        if ( pntIndex <= P7 )
-          {
-          // We know pt P0 must be >P0 since we already
-          // assume P0 == 0.  This is why we do not
-          // bother subtracting P0 from pt here.
-          shapeIds[p] = 
-                      (   (  theCellI + shiftLUT[0][ pntIndex ]  ) +
-                          (  theCellJ + shiftLUT[1][ pntIndex ]  ) * pyStride +
-                          (  theCellK + shiftLUT[2][ pntIndex ]  ) * pzStride
-                      );
-          }
-        else 
-        if ( pntIndex >= EA && pntIndex <= EL )
-          {
-          int  pt1Index = vtkTableBasedClipperTriangulationTables::
-                          HexVerticesFromEdges[ pntIndex - EA ][0];
-          int  pt2Index = vtkTableBasedClipperTriangulationTables::
-                          HexVerticesFromEdges[ pntIndex - EA ][1];
-          
-          if ( pt2Index < pt1Index )
-            {
-            int temp = pt2Index;
-            pt2Index = pt1Index;
-            pt1Index = temp;
-            }
-          
-          double pt1ToPt2 = grdDiffs[ pt2Index] - grdDiffs[ pt1Index ];
-          double pt1ToIso = 0.0 - grdDiffs[ pt1Index ];
-          double p1Weight = 1.0 - pt1ToIso / pt1ToPt2;
-                                  
-          int    pntIndx1 = 
-                 (   (  theCellI + shiftLUT[0][ pt1Index ] ) +
-                     (  theCellJ + shiftLUT[1][ pt1Index ]  ) * pyStride +
-                     (  theCellK + shiftLUT[2][ pt1Index ]  ) * pzStride
-                 );
-          int    pntIndx2 = 
-                 (   (  theCellI + shiftLUT[0][ pt2Index ]  ) +
-                     (  theCellJ + shiftLUT[1][ pt2Index ]  ) * pyStride +
-                     (  theCellK + shiftLUT[2][ pt2Index ]  ) * pzStride
-                 );
-                  
-          shapeIds[p] = visItVFV->AddPoint( pntIndx1, pntIndx2, p1Weight );
-          }
-        else 
-        if ( pntIndex >= N0 && pntIndex <= N3 )
-          {
-          shapeIds[p] = intrpIds[ pntIndex - N0 ];
-          }
-        else
-          {
-          vtkErrorMacro( << "An invalid output point value "
-                         << "was found in the ClipCases." << endl );
-          }
+        outInfor->Set( vtkStreamingDemandDrivenPipeline::PRIORITY(), priorVal );
+        inputInf = NULL;
+        outInfor = NULL;
+        originPt = NULL;
+        spacings = NULL;
+        subXtent = NULL;
+        return 1;
         }
+      }
 
-      switch ( theShape )
+    vtkPlane * clipFunc = vtkPlane::SafeDownCast( this->GetClipFunction() );
+    if ( !clipFunc )
+      {
+      outInfor->Set( vtkStreamingDemandDrivenPipeline::PRIORITY(), priorVal );
+      inputInf = NULL;
+      outInfor = NULL;
+      return 1;
+      }
+
+    static double boxValue[8];
+    boxValue[0] = clipFunc->EvaluateFunction
+                            ( boundBox[0], boundBox[2], boundBox[4] );
+    boxValue[1] = clipFunc->EvaluateFunction
+                            ( boundBox[0], boundBox[2], boundBox[5] );
+    boxValue[2] = clipFunc->EvaluateFunction
+                            ( boundBox[0], boundBox[3], boundBox[4] );
+    boxValue[3] = clipFunc->EvaluateFunction
+                            ( boundBox[0], boundBox[3], boundBox[5] );
+    boxValue[4] = clipFunc->EvaluateFunction
+                            ( boundBox[1], boundBox[2], boundBox[4] );
+    boxValue[5] = clipFunc->EvaluateFunction
+                            ( boundBox[1], boundBox[2], boundBox[5] );
+    boxValue[6] = clipFunc->EvaluateFunction
+                            ( boundBox[1], boundBox[3], boundBox[4] );
+    boxValue[7] = clipFunc->EvaluateFunction
+                            ( boundBox[1], boundBox[3], boundBox[5] );
+    clipFunc    = NULL;
+
+    priority = 0;
+    for ( int i = 0; i < 8; i ++ )
+      {
+      if ( boxValue[i] > this->Value )
         {
-        case ST_HEX:
-          visItVFV->AddHex( i, shapeIds[0], shapeIds[1], 
-                               shapeIds[2], shapeIds[3], shapeIds[4], 
-                               shapeIds[5], shapeIds[6], shapeIds[7] );
-          break;
-          
-        case ST_WDG:
-          visItVFV->AddWedge( i, shapeIds[0], shapeIds[1], shapeIds[2],
-                                 shapeIds[3], shapeIds[4], shapeIds[5] );
-          break;
-          
-        case ST_PYR:
-          visItVFV->AddPyramid( i, shapeIds[0], shapeIds[1],
-                                   shapeIds[2], shapeIds[3], shapeIds[4] );
-          break;
-          
-        case ST_TET:
-          visItVFV->AddTet( i, shapeIds[0], shapeIds[1], 
-                               shapeIds[2], shapeIds[3] );
-          break;
-          
-        case ST_QUA:
-          visItVFV->AddQuad( i, shapeIds[0], shapeIds[1], 
-                                shapeIds[2], shapeIds[3] );
-          break;
-          
-        case ST_TRI:
-          visItVFV->AddTri( i, shapeIds[0], shapeIds[1], shapeIds[2] );
-          break;
-          
-        case ST_LIN:
-          visItVFV->AddLine( i, shapeIds[0], shapeIds[1] );
-          break;
-          
-        case ST_VTX:
-          visItVFV->AddVertex( i, shapeIds[0] );
-          break;
-          
-        case ST_PNT:
-          intrpIds[ intrpIdx ] = visItVFV->AddCentroidPoint
-                                           ( nCellPts, shapeIds );
-          break;
+        priority = priorVal;
+        break;
         }
       }
+    outInfor->Set( vtkStreamingDemandDrivenPipeline::PRIORITY(), priority );
+    
+    inputInf = NULL;
+    outInfor = NULL;
+    return 1;
+    }
+
+  //all other requests handled by superclass
+  return this->Superclass::ProcessRequest( request, inputVector, outputVector );
+}
+
+//-----------------------------------------------------------------------------
+int vtkTableBasedClipDataSet::RequestData( vtkInformation * vtkNotUsed( request ),
+    vtkInformationVector ** inputVector, vtkInformationVector * outputVector )
+{
+  // input and output information objects
+  vtkInformation * inputInf = inputVector[0]->GetInformationObject( 0 );
+  vtkInformation * outInfor = outputVector->GetInformationObject( 0 );
+
+  // Get the input of which we have to create a copy since the clipper requires
+  // that InterpolateAllocate() be invoked for the output based on its input in
+  // terms of the point data. If the input and output arrays are different, 
+  // vtkCell3D's Clip will fail. The last argument of InterpolateAllocate makes
+  // sure that arrays are shallow-copied from theInput to cpyInput.
+  vtkDataSet * theInput = vtkDataSet::SafeDownCast
+                          (  inputInf->Get( vtkDataObject::DATA_OBJECT() )  );
+  vtkSmartPointer< vtkDataSet > cpyInput;
+  cpyInput.TakeReference( theInput->NewInstance() );
+  cpyInput->CopyStructure( theInput  );
+  cpyInput->GetCellData()->PassData( theInput->GetCellData() );
+  cpyInput->GetPointData()
+          ->InterpolateAllocate( theInput->GetPointData(), 0, 0, 1 );
+
+  // get the output (the remaining and the clipped parts)
+  vtkUnstructuredGrid * outputUG = vtkUnstructuredGrid::SafeDownCast
+                        (  outInfor->Get( vtkDataObject::DATA_OBJECT() )  );
+  
+  inputInf = NULL;
+  outInfor = NULL;
+  theInput = NULL;
+  vtkDebugMacro( << "Clipping dataset" << endl );
+
+  
+  int  i;
+  vtkIdType  numbPnts = cpyInput->GetNumberOfPoints();
+
+  // handling exceptions
+  if ( numbPnts < 1 )
+    {
+    vtkDebugMacro( << "No data to clip" << endl );
+    outputUG = NULL;
+    return 1;
+    }
+
+  if ( !this->ClipFunction && this->GenerateClipScalars )
+    {
+    vtkErrorMacro( << "Cannot generate clip scalars "
+                   << "if no clip function defined" << endl );
+    outputUG = NULL;
+    return 1;
+    }
+
+
+  vtkDataArray   * clipAray = NULL;
+  vtkDoubleArray * pScalars = NULL;
+
+  // check whether the cells are clipped with input scalars or a clip function
+  if ( this->ClipFunction )
+    {
+    pScalars = vtkDoubleArray::New();
+    pScalars->SetNumberOfTuples( numbPnts );
+    pScalars->SetName( "ClipDataSetScalars" );
+    
+    // enable clipDataSetScalars to be passed to the output
+    if ( this->GenerateClipScalars )
+      {
+      cpyInput->GetPointData()->SetScalars( pScalars );
+      }
       
-    thisCase = NULL;
+    for ( i = 0; i < numbPnts; i ++ )
+      {
+      double s = this->ClipFunction->FunctionValue(  cpyInput->GetPoint( i )  );
+      pScalars->SetTuple1( i, s );
+      }
+      
+    clipAray = pScalars;
     }
-  
-  int         toDelete = 0;
-  double    * theCords = NULL;
-  vtkPoints * inputPts = strcGrid->GetPoints();
-  if ( inputPts->GetDataType() == VTK_DOUBLE )
+  else //using input scalars
     {
-    theCords = static_cast < double * > (  inputPts->GetVoidPointer( 0 )  );
+    clipAray = this->GetInputArrayToProcess( 0, inputVector );
+    if ( !clipAray ) 
+      {
+      vtkErrorMacro( << "no input scalars." << endl );
+      return 1;
+      }
     }
-  else
+    
+  
+  int    gridType = cpyInput->GetDataObjectType(); 
+  double isoValue = ( !this->ClipFunction || this->UseValueAsOffset ) 
+                    ?  this->Value  :  0.0;               
+  if ( gridType == VTK_IMAGE_DATA || gridType == VTK_STRUCTURED_POINTS )
     {
-    toDelete = 1;
-    numbPnts = inputPts->GetNumberOfPoints();
-    theCords = new double [ numbPnts * 3 ];
-    for ( i = 0; i < numbPnts; i ++ )
+    int   numbDims;
+    int * dataDims = vtkImageData::SafeDownCast( cpyInput )->GetDimensions();
+    for ( numbDims = 3, i = 0; i < 3; i ++ )
       {
-      inputPts->GetPoint( i, theCords + ( i << 1 ) + i );
+      numbDims -= (  ( dataDims[i] <= 1 ) ? 1 : 0  );
+      }
+    dataDims = NULL;
+      
+    if ( numbDims == 3 )
+      {
+      this->ClipImageData( cpyInput.GetPointer(), clipAray, isoValue, outputUG );
       }
     }
-  inputPts = NULL;
+  else              
+  if ( gridType == VTK_POLY_DATA )
+    {
+    this->ClipPolyData( cpyInput.GetPointer(), clipAray, isoValue, outputUG );
+    }
+  else
+  if ( gridType == VTK_RECTILINEAR_GRID )
+    {
+    this->ClipRectilinearGridData( cpyInput.GetPointer(), clipAray, 
+                                   isoValue, outputUG );
+    }
+  else
+  if ( gridType == VTK_STRUCTURED_GRID )
+    {
+    this->ClipStructuredGridData( cpyInput.GetPointer(), clipAray, 
+                                  isoValue, outputUG );
+    }
+  else
+  if ( gridType == VTK_UNSTRUCTURED_GRID )
+    {
+    this->ClipUnstructuredGridData( cpyInput.GetPointer(), clipAray, 
+                                    isoValue, outputUG );
+    }
+  else
+    {
+    this->ClipDataSet( cpyInput.GetPointer(), clipAray, outputUG );
+    }
+    
+  outputUG->Squeeze();
   
-  visItVFV->ConstructDataSet( strcGrid->GetPointData(), 
-                              strcGrid->GetCellData(), outputUG, theCords );
+  if ( pScalars )
+    {
+    pScalars->Delete();
+    }
+  pScalars = NULL;
+  outputUG = NULL;
+  clipAray = NULL;
   
+  return 1;
+}
+
+//-----------------------------------------------------------------------------
+void vtkTableBasedClipDataSet::ClipDataSet( vtkDataSet * pDataSet, 
+     vtkDataArray * clipAray, vtkUnstructuredGrid * unstruct )
+{
+  vtkClipDataSet * clipData = vtkClipDataSet::New();
+  clipData->SetInput( pDataSet );
+  clipData->SetValue( this->Value );
+  clipData->SetInsideOut( this->InsideOut );
+  clipData->SetClipFunction( this->ClipFunction );
+  clipData->SetUseValueAsOffset( this->UseValueAsOffset );
+  clipData->SetGenerateClipScalars( this->GenerateClipScalars );
   
-  delete visItVFV;
-  if ( toDelete )
+  if ( !this->ClipFunction )
     {
-    delete [] theCords;
+    pDataSet->GetPointData()->SetScalars( clipAray );
     }
-  visItVFV = NULL;
-  theCords = NULL;
-  strcGrid = NULL;
+    
+  clipData->Update();
+  unstruct->ShallowCopy( clipData->GetOutput() );
+  
+  clipData->Delete();
+  clipData = NULL;
 }
 
 //-----------------------------------------------------------------------------
-void vtkTableBasedClipDataSet::ClipUnstructuredGridData( vtkDataSet * inputGrd, 
+void vtkTableBasedClipDataSet::ClipImageData( vtkDataSet * inputGrd, 
      vtkDataArray * clipAray, double isoValue, vtkUnstructuredGrid * outputUG )
-{ 
-  vtkUnstructuredGrid * unstruct = vtkUnstructuredGrid::SafeDownCast( inputGrd );
+{
+  int                  i, j;
+  int                  dataDims[3];
+  double               spacings[3];
+  double               tmpValue = 0.0;
+  double             * dataBBox = NULL;
+  vtkImageData       * volImage = NULL;
+  vtkDoubleArray     * pxCoords = NULL;
+  vtkDoubleArray     * pyCoords = NULL;
+  vtkDoubleArray     * pzCoords = NULL;
+  vtkRectilinearGrid * rectGrid = NULL;
   
-  vtkIdType   i, j;
-  vtkIdType   numbPnts = 0;
-  int         numCants = 0; // number of cells not clipped by this filter
-  int         numCells = unstruct->GetNumberOfCells();
+  volImage = vtkImageData::SafeDownCast( inputGrd );
+  volImage->GetDimensions( dataDims );
+  volImage->GetSpacing( spacings );
+  dataBBox = volImage->GetBounds();
   
-  // volume from volume
+  pxCoords = vtkDoubleArray::New();
+  pyCoords = vtkDoubleArray::New();
+  pzCoords = vtkDoubleArray::New();
+  vtkDoubleArray * tmpArays[3] = { pxCoords, pyCoords, pzCoords };
+  for ( j = 0; j < 3; j ++ )
+    {
+    tmpArays[j]->SetNumberOfComponents( 1 );
+    tmpArays[j]->SetNumberOfTuples( dataDims[j] );
+    for ( tmpValue  = dataBBox[ j << 1 ], i = 0; i < dataDims[j]; i ++, 
+          tmpValue += spacings[j] )
+      {
+      tmpArays[j]->SetComponent( i, 0, tmpValue );
+      }
+    tmpArays[j] = NULL;
+    }
+    
+  rectGrid = vtkRectilinearGrid::New();
+  rectGrid->SetDimensions( dataDims );
+  rectGrid->SetXCoordinates( pxCoords );
+  rectGrid->SetYCoordinates( pyCoords );
+  rectGrid->SetZCoordinates( pzCoords );
+  rectGrid->GetPointData()->ShallowCopy( volImage->GetPointData() );
+  rectGrid->GetCellData()->ShallowCopy( volImage->GetCellData() );
+  
+  this->ClipRectilinearGridData( rectGrid, clipAray, isoValue, outputUG );
+  
+  pxCoords->Delete();
+  pyCoords->Delete();
+  pzCoords->Delete();
+  rectGrid->Delete();
+  pxCoords = NULL;
+  pyCoords = NULL;
+  pzCoords = NULL;
+  rectGrid = NULL;
+  volImage = NULL;
+  dataBBox = NULL;
+}
+
+//-----------------------------------------------------------------------------
+void vtkTableBasedClipDataSet::ClipPolyData( vtkDataSet * inputGrd, 
+     vtkDataArray * clipAray, double isoValue, vtkUnstructuredGrid * outputUG )
+{
+  vtkPolyData * polyData = vtkPolyData::SafeDownCast( inputGrd );
+  int           numCells = polyData->GetNumberOfCells();
+
   vtkTableBasedClipperVolumeFromVolume   * visItVFV = new
-  vtkTableBasedClipperVolumeFromVolume(    unstruct->GetNumberOfPoints(), 
-      int(   pow(  double( numCells ), double( 0.6667f )  )   ) * 5 + 100    );
+  vtkTableBasedClipperVolumeFromVolume(    polyData->GetNumberOfPoints(),
+     int(   pow(  double( numCells ),  double( 0.6667f )  )   ) * 5 + 100    );
 
-  // the stuffs that can not be clipped by this filter
   vtkUnstructuredGrid * specials = vtkUnstructuredGrid::New();
-  specials->SetPoints( unstruct->GetPoints() );
-  specials->GetPointData()->ShallowCopy( unstruct->GetPointData() );
+  specials->SetPoints( polyData->GetPoints() );
+  specials->GetPointData()->ShallowCopy( polyData->GetPointData() );
   specials->Allocate( numCells );
 
+  vtkIdType   i, j;
+  vtkIdType   numbPnts = 0;
+  int         numCants = 0;  // number of cells not clipped by this filter
+  
   for ( i = 0; i < numCells; i ++ )
     {
-    int         cellType = unstruct->GetCellType( i );
+    int         cellType = polyData->GetCellType( i );
+    bool        bCanClip = false;
     vtkIdType * pntIndxs = NULL;
-    unstruct->GetCellPoints( i, numbPnts, pntIndxs );
+    polyData->GetCellPoints( i, numbPnts, pntIndxs );
     
-    bool     bCanClip = false;
     switch ( cellType )
       {
       case VTK_TETRA:
       case VTK_PYRAMID:
       case VTK_WEDGE:
       case VTK_HEXAHEDRON:
-      case VTK_VOXEL:
       case VTK_TRIANGLE:
       case VTK_QUAD:
-      case VTK_PIXEL:
       case VTK_LINE:
       case VTK_VERTEX:
            bCanClip = true;
            break;
-                        
+                       
       default:
            bCanClip = false;
            break;
@@ -3096,23 +2938,22 @@ void vtkTableBasedClipDataSet::ClipUnstructuredGridData( vtkDataSet * inputGrd,
  
     if ( bCanClip )
       {
-      int    caseIndx = 0;
-      double grdDiffs[8];
+      double    grdDiffs[8];
+      int       caseIndx = 0;
       
-      for ( j = numbPnts-1; j >= 0; j -- )
-        {                 
+      for ( j = numbPnts - 1; j >= 0; j -- )
+        {   
         grdDiffs[j] = clipAray->GetComponent( pntIndxs[j], 0 ) - isoValue;
         caseIndx   += (  ( grdDiffs[j] >= 0.0 ) ? 1 : 0  );
         caseIndx  <<= (  1 - ( !j )  );
         }
 
-      int               startIdx = 0;
-      int               nOutputs = 0;
-      typedef const int EDGEIDXS[2];
-      EDGEIDXS        * edgeVtxs = NULL;
-      unsigned char   * thisCase = NULL;
+      int             startIdx = 0;
+      int             nOutputs = 0;
+      typedef int     EDGEIDXS[2];
+      EDGEIDXS      * edgeVtxs = NULL;
+      unsigned char * thisCase = NULL;
 
-      // start index, split case, number of output, and vertices from edges
       switch ( cellType )
         {
         case VTK_TETRA:
@@ -3147,14 +2988,6 @@ void vtkTableBasedClipDataSet::ClipUnstructuredGridData( vtkDataSet * inputGrd,
                      vtkTableBasedClipperTriangulationTables::HexVerticesFromEdges;
           break;
           
-        case VTK_VOXEL:
-          startIdx = vtkTableBasedClipperClipTables::StartClipShapesVox[ caseIndx ];
-          thisCase =&vtkTableBasedClipperClipTables::ClipShapesVox[ startIdx ];
-          nOutputs = vtkTableBasedClipperClipTables::NumClipShapesVox[ caseIndx ];
-          edgeVtxs = ( EDGEIDXS * ) 
-                     vtkTableBasedClipperTriangulationTables::VoxVerticesFromEdges;
-          break;
-          
         case VTK_TRIANGLE:
           startIdx = vtkTableBasedClipperClipTables::StartClipShapesTri[ caseIndx ];
           thisCase =&vtkTableBasedClipperClipTables::ClipShapesTri[ startIdx ];
@@ -3171,14 +3004,6 @@ void vtkTableBasedClipDataSet::ClipUnstructuredGridData( vtkDataSet * inputGrd,
                      vtkTableBasedClipperTriangulationTables::QuadVerticesFromEdges;
           break;
           
-        case VTK_PIXEL:
-          startIdx = vtkTableBasedClipperClipTables::StartClipShapesPix[ caseIndx ];
-          thisCase =&vtkTableBasedClipperClipTables::ClipShapesPix[ startIdx ];
-          nOutputs = vtkTableBasedClipperClipTables::NumClipShapesPix[ caseIndx ];
-          edgeVtxs = ( EDGEIDXS * ) 
-                     vtkTableBasedClipperTriangulationTables::PixelVerticesFromEdges;
-          break;
-          
         case VTK_LINE:
           startIdx = vtkTableBasedClipperClipTables::StartClipShapesLin[ caseIndx ];
           thisCase =&vtkTableBasedClipperClipTables::ClipShapesLin[ startIdx ];
@@ -3194,16 +3019,15 @@ void vtkTableBasedClipDataSet::ClipUnstructuredGridData( vtkDataSet * inputGrd,
           edgeVtxs = NULL;
           break;
         }
-      
-      int   intrpIds[4];
+
+      int  intrpIds[4];
       for ( j = 0; j < nOutputs; j ++ )
-        {   
+        {
         int      nCellPts = 0;
-        int      theColor = -1;
         int      intrpIdx = -1;
+        int      theColor = -1;
         unsigned char theShape = *thisCase ++;
         
-        // number of points and color
         switch ( theShape )
           {
           case ST_HEX:
@@ -3220,7 +3044,6 @@ void vtkTableBasedClipDataSet::ClipUnstructuredGridData( vtkDataSet * inputGrd,
             nCellPts = 5;
             theColor = *thisCase ++;
             break;
-            
           case ST_TET:
             nCellPts = 4;
             theColor = *thisCase ++;
@@ -3253,19 +3076,19 @@ void vtkTableBasedClipDataSet::ClipUnstructuredGridData( vtkDataSet * inputGrd,
             break;
             
           default:
-            vtkErrorMacro( << "An invalid output shape was found "
-                           << "in the ClipCases." << endl );
+            vtkErrorMacro( << "An invalid output shape was found in "
+                           << "the ClipCases." << endl );
           }
-        
+
         if ( (!this->InsideOut && theColor == COLOR0 ) ||
              ( this->InsideOut && theColor == COLOR1 )
            )
           {
           // We don't want this one; it's the wrong side.
           thisCase += nCellPts;
-          continue; 
+          continue;
           }
-        
+
         int   shapeIds[8];
         for ( int p = 0; p < nCellPts; p ++ )
           {
@@ -3273,16 +3096,13 @@ void vtkTableBasedClipDataSet::ClipUnstructuredGridData( vtkDataSet * inputGrd,
           
           if ( pntIndex <= P7 )
             {
-            // We know pt P0 must be >P0 since we already
-            // assume P0 == 0.  This is why we do not
-            // bother subtracting P0 from pt here.
             shapeIds[p] = pntIndxs[ pntIndex ];
             }
           else 
           if ( pntIndex >= EA && pntIndex <= EL )
             {
-            int  pt1Index = edgeVtxs[ pntIndex-EA ][0];
-            int  pt2Index = edgeVtxs[ pntIndex-EA ][1];
+            int pt1Index = edgeVtxs[ pntIndex - EA ][0];
+            int pt2Index = edgeVtxs[ pntIndex - EA ][1];
             if ( pt2Index < pt1Index )
               {
               int temp = pt2Index;
@@ -3305,11 +3125,11 @@ void vtkTableBasedClipDataSet::ClipUnstructuredGridData( vtkDataSet * inputGrd,
             }
           else
             {
-            vtkErrorMacro( << "An invalid output point value was found "
-                           << "in the ClipCases." << endl );
+            vtkErrorMacro( << "An invalid output point value "
+                           << "was found in the ClipCases." << endl );
             }
           }
-        
+
         switch ( theShape )
           {
           case ST_HEX:
@@ -3343,7 +3163,7 @@ void vtkTableBasedClipDataSet::ClipUnstructuredGridData( vtkDataSet * inputGrd,
             break;
             
           case ST_LIN:
-            visItVFV->AddLine( i, shapeIds[0], shapeIds[1] ); 
+            visItVFV->AddLine( i, shapeIds[0], shapeIds[1] );
             break;
             
           case ST_VTX:
@@ -3351,8 +3171,7 @@ void vtkTableBasedClipDataSet::ClipUnstructuredGridData( vtkDataSet * inputGrd,
             break;
             
           case ST_PNT:
-            intrpIds[ intrpIdx ] = visItVFV->AddCentroidPoint
-                                             ( nCellPts, shapeIds );
+            intrpIds[intrpIdx] = visItVFV->AddCentroidPoint( nCellPts, shapeIds );
             break;
           }
         }
@@ -3360,34 +3179,277 @@ void vtkTableBasedClipDataSet::ClipUnstructuredGridData( vtkDataSet * inputGrd,
       edgeVtxs = NULL;
       thisCase = NULL;
       }
-    else if (cellType == VTK_POLYHEDRON)
+    else
       {
       if ( numCants == 0 )
         {
-          specials->GetCellData()
-                  ->CopyAllocate( unstruct->GetCellData(), numCells );
+        specials->GetCellData()
+                ->CopyAllocate( polyData->GetCellData(), numCells );
         }
-      vtkIdType nfaces, *facePtIds;
-      unstruct->GetFaceStream(i, nfaces, facePtIds);
-      specials->InsertNextCell(cellType, nfaces, facePtIds);
+
+      specials->InsertNextCell( cellType, numbPnts, pntIndxs );
       specials->GetCellData()
-              ->CopyData( unstruct->GetCellData(), i, numCants );
+              ->CopyData( polyData->GetCellData(), i, numCants );
       numCants ++;
       }
-    else
+      
+    pntIndxs = NULL;
+    }
+  
+
+  int         toDelete = 0;
+  double    * theCords = NULL;
+  vtkPoints * inputPts = polyData->GetPoints();
+  if ( inputPts->GetDataType() == VTK_DOUBLE )
+    {
+    theCords = static_cast < double * > (  inputPts->GetVoidPointer( 0 )  );
+    }
+  else
+    {
+    toDelete = 1;
+    numbPnts = inputPts->GetNumberOfPoints();
+    theCords = new double [ numbPnts * 3 ];
+    for ( i = 0; i < numbPnts; i ++ )
       {
-      if ( numCants == 0 )
+      inputPts->GetPoint( i, theCords + ( i << 1 ) + i );
+      }
+    }
+  inputPts = NULL;
+  
+
+  if ( numCants > 0 )
+    {
+    vtkUnstructuredGrid * vtkUGrid  = vtkUnstructuredGrid::New();
+    this->ClipDataSet( specials, clipAray, vtkUGrid );
+    
+    vtkUnstructuredGrid * visItGrd = vtkUnstructuredGrid::New();
+    visItVFV->ConstructDataSet( polyData->GetPointData(), 
+                                polyData->GetCellData(), visItGrd, theCords );
+
+    vtkAppendFilter * appender = vtkAppendFilter::New();
+    appender->AddInput( vtkUGrid );
+    appender->AddInput( visItGrd );
+    appender->Update();
+
+    outputUG->ShallowCopy( appender->GetOutput() );
+    
+    appender->Delete();
+    vtkUGrid->Delete();
+    visItGrd->Delete();
+    appender = NULL;
+    vtkUGrid = NULL;
+    visItGrd = NULL;
+    }
+  else
+    {
+    visItVFV->ConstructDataSet( polyData->GetPointData(), 
+                                polyData->GetCellData(), outputUG, theCords );
+    }
+
+
+  specials->Delete();
+  delete visItVFV;
+  if ( toDelete )
+    {
+    delete [] theCords;
+    }
+  specials = NULL;
+  visItVFV = NULL;
+  theCords = NULL;
+  polyData = NULL;
+}
+
+//-----------------------------------------------------------------------------
+void vtkTableBasedClipDataSet::ClipRectilinearGridData( vtkDataSet * inputGrd, 
+     vtkDataArray * clipAray, double isoValue, vtkUnstructuredGrid * outputUG )
+{
+  vtkRectilinearGrid * rectGrid = vtkRectilinearGrid::SafeDownCast( inputGrd );
+  
+  int   i, j;
+  int   numCells = 0;
+  int   rectDims[3];
+  rectGrid->GetDimensions( rectDims );
+  numCells = rectGrid->GetNumberOfCells();
+
+  vtkTableBasedClipperVolumeFromVolume   * visItVFV = new
+  vtkTableBasedClipperVolumeFromVolume(    rectGrid->GetNumberOfPoints(),
+      int(   pow(  double( numCells ), double( 0.6667f )  )   ) * 5 + 100    );
+
+  vtkstd::vector< vtkIdType > specialIds;
+  if (  !vtkTableBasedClipperClipCells( NULL, rectDims, clipAray, isoValue,
+          this->InsideOut, numCells, this->NumberOfThreads, visItVFV,
+          rectGrid->GetNumberOfPoints(), specialIds )  )
+    {
+    vtkErrorMacro( << "An invalid output shape or point value was found "
+                   << "in the ClipCases." << endl );
+    }
+  
+  int            toDelete    = 0;
+  double       * theCords[3] = { NULL, NULL, NULL };
+  vtkDataArray * theArays[3] = { NULL, NULL, NULL };
+  
+  if ( rectGrid->GetXCoordinates()->GetDataType() == VTK_DOUBLE &&
+       rectGrid->GetYCoordinates()->GetDataType() == VTK_DOUBLE &&
+       rectGrid->GetZCoordinates()->GetDataType() == VTK_DOUBLE
+     )
+    {
+    theCords[0] = static_cast < double * > 
+                  (  rectGrid->GetXCoordinates()->GetVoidPointer( 0 )  );
+    theCords[1] = static_cast < double * > 
+                  (  rectGrid->GetYCoordinates()->GetVoidPointer( 0 )  );
+    theCords[2] = static_cast < double * >
+                  (  rectGrid->GetZCoordinates()->GetVoidPointer( 0 )  );
+    }
+  else
+    {
+    toDelete    = 1;
+    theArays[0] = rectGrid->GetXCoordinates();
+    theArays[1] = rectGrid->GetYCoordinates();
+    theArays[2] = rectGrid->GetZCoordinates();
+    for ( j = 0; j < 3; j ++ )
+      {
+      theCords[j] = new double [ rectDims[j] ];
+      for ( i = 0; i < rectDims[j]; i ++ )
         {
-          specials->GetCellData()
-                  ->CopyAllocate( unstruct->GetCellData(), numCells );
+        theCords[j][i] = theArays[j]->GetComponent( i, 0 );
         }
+      theArays[j] = NULL;
+      }
+    }
+
+  visItVFV->ConstructDataSet
+            ( rectGrid->GetPointData(), rectGrid->GetCellData(), 
+              outputUG, rectDims, theCords[0], theCords[1], theCords[2] );
+              
+  delete visItVFV;
+  visItVFV = NULL;
+  rectGrid = NULL;
+  
+  for ( i = 0; i < 3; i ++ )
+    {
+    if ( toDelete )
+      {
+      delete [] theCords[i];
+      }
+    theCords[i] = NULL;
+    }
+}
+
+//-----------------------------------------------------------------------------
+void vtkTableBasedClipDataSet::ClipStructuredGridData( vtkDataSet * inputGrd, 
+     vtkDataArray * clipAray, double isoValue, vtkUnstructuredGrid * outputUG )
+{
+  vtkStructuredGrid * strcGrid = vtkStructuredGrid::SafeDownCast( inputGrd );
+  
+  int   i;
+  int   numCells    = 0;
+  int   gridDims[3] = { 0, 0, 0 };
+  strcGrid->GetDimensions( gridDims );
+  numCells = strcGrid->GetNumberOfCells();
+
+  vtkTableBasedClipperVolumeFromVolume  *  visItVFV = new
+  vtkTableBasedClipperVolumeFromVolume(    strcGrid->GetNumberOfPoints(),
+      int(   pow(  double( numCells ), double( 0.6667f )  )   ) * 5 + 100    );
+
+  int   numbPnts    = 0;
+  
+  vtkstd::vector< vtkIdType > specialIds;
+  if (  !vtkTableBasedClipperClipCells( NULL, gridDims, clipAray, isoValue,
+          this->InsideOut, numCells, this->NumberOfThreads, visItVFV,
+          strcGrid->GetNumberOfPoints(), specialIds )  )
+    {
+    vtkErrorMacro( << "An invalid output shape or point value was found "
+                   << "in the ClipCases." << endl );
+    }
+  
+  int         toDelete = 0;
+  double    * theCords = NULL;
+  vtkPoints * inputPts = strcGrid->GetPoints();
+  if ( inputPts->GetDataType() == VTK_DOUBLE )
+    {
+    theCords = static_cast < double * > (  inputPts->GetVoidPointer( 0 )  );
+    }
+  else
+    {
+    toDelete = 1;
+    numbPnts = inputPts->GetNumberOfPoints();
+    theCords = new double [ numbPnts * 3 ];
+    for ( i = 0; i < numbPnts; i ++ )
+      {
+      inputPts->GetPoint( i, theCords + ( i << 1 ) + i );
+      }
+    }
+  inputPts = NULL;
+  
+  visItVFV->ConstructDataSet( strcGrid->GetPointData(), 
+                              strcGrid->GetCellData(), outputUG, theCords );
+  
+  
+  delete visItVFV;
+  if ( toDelete )
+    {
+    delete [] theCords;
+    }
+  visItVFV = NULL;
+  theCords = NULL;
+  strcGrid = NULL;
+}
+
+//-----------------------------------------------------------------------------
+void vtkTableBasedClipDataSet::ClipUnstructuredGridData( vtkDataSet * inputGrd, 
+     vtkDataArray * clipAray, double isoValue, vtkUnstructuredGrid * outputUG )
+{ 
+  vtkUnstructuredGrid * unstruct = vtkUnstructuredGrid::SafeDownCast( inputGrd );
+  
+  vtkIdType   i, j;
+  vtkIdType   numbPnts = 0;
+  int         numCants = 0; // number of cells not clipped by this filter
+  int         numCells = unstruct->GetNumberOfCells();
+  
+  // volume from volume
+  vtkTableBasedClipperVolumeFromVolume   * visItVFV = new
+  vtkTableBasedClipperVolumeFromVolume(    unstruct->GetNumberOfPoints(), 
+      int(   pow(  double( numCells ), double( 0.6667f )  )   ) * 5 + 100    );
+
+  // the stuffs that can not be clipped by this filter
+  vtkUnstructuredGrid * specials = vtkUnstructuredGrid::New();
+  specials->SetPoints( unstruct->GetPoints() );
+  specials->GetPointData()->ShallowCopy( unstruct->GetPointData() );
+  specials->Allocate( numCells );
+
+  vtkstd::vector< vtkIdType > specialIds;
+  if (  !vtkTableBasedClipperClipCells( unstruct, NULL, clipAray, isoValue,
+          this->InsideOut, numCells, this->NumberOfThreads, visItVFV,
+          unstruct->GetNumberOfPoints(), specialIds )  )
+    {
+    vtkErrorMacro( << "An invalid output shape or point value was found "
+                   << "in the ClipCases." << endl );
+    }
+  
+  numCants = static_cast< int >( specialIds.size() );
+  if ( numCants > 0 )
+    {
+    specials->GetCellData()
+            ->CopyAllocate( unstruct->GetCellData(), numCells );
+    }
+  for ( j = 0; j < numCants; j ++ )
+    {
+    i = specialIds[j];
+    int cellType = unstruct->GetCellType( i );
+    if ( cellType == VTK_POLYHEDRON )
+      {
+      vtkIdType nfaces, *facePtIds;
+      unstruct->GetFaceStream( i, nfaces, facePtIds );
+      specials->InsertNextCell( cellType, nfaces, facePtIds );
+      }
+    else
+      {
+      vtkIdType * pntIndxs = NULL;
+      unstruct->GetCellPoints( i, numbPnts, pntIndxs );
       specials->InsertNextCell( cellType, numbPnts, pntIndxs );
-      specials->GetCellData()
-              ->CopyData( unstruct->GetCellData(), i, numCants );
-      numCants ++;
       }
-      
-    pntIndxs = NULL;
+    specials->GetCellData()
+            ->CopyData( unstruct->GetCellData(), i, j );
     }
   
   int         toDelete = 0;
@@ -3485,4 +3547,6 @@ void vtkTableBasedClipDataSet::PrintSelf( ostream & os, vtkIndent indent )
 
   os << indent << "UseValueAsOffset: " 
      << (this->UseValueAsOffset ? "On\n" : "Off\n");
+
+  os << indent << "Number Of Threads: " << this->NumberOfThreads << "\n";
 }
@@ -68,6 +68,12 @@
 //  advantages are gained by adopting the unique clipping and triangulation tables
 //  proposed by VisIt.
 //
+//  The cells of unstructured, structured and rectilinear grids (and of image 
+//  data) can be clipped by several threads (see NumberOfThreads), each of them
+//  handling a contiguous batch of cells. The points shared by the batches are
+//  merged afterwards, in cell order, so the output is the same as the one 
+//  obtained with a single thread.
+//
 // .SECTION Caveats
 //  vtkTableBasedClipDataSet makes use of a hash table (that is provided by class
 //  maintained by internal class vtkTableBasedClipperDataSetFromVolume) to achieve
@@ -187,6 +193,14 @@ public:
   // Return the clipped output.
   vtkUnstructuredGrid * GetClippedOutput();
 
+  // Description:
+  // Set/Get the number of threads used to clip the cells of unstructured,
+  // structured and rectilinear grids (and of image data). Small grids are 
+  // clipped with fewer threads. The output does not depend on this number.
+  // The default is vtkMultiThreader::GetGlobalDefaultNumberOfThreads().
+  vtkSetClampMacro( NumberOfThreads, int, 1, VTK_MAX_THREADS );
+  vtkGetMacro( NumberOfThreads, int );
+
   // Description:
   // Overridden to process REQUEST_UPDATE_EXTENT_INFORMATION.
   virtual int ProcessRequest( vtkInformation *,
@@ -262,6 +276,7 @@ protected:
   bool   UseValueAsOffset;
   double Value;
   double MergeTolerance;
+  int    NumberOfThreads;
   vtkCallbackCommand         * InternalProgressObserver;
   vtkImplicitFunction        * ClipFunction;
   vtkIncrementalPointLocator * Locator;
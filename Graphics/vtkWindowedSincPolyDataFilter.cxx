@@ -20,6 +20,7 @@
 #include "vtkMath.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
 #include "vtkPolyData.h"
@@ -27,6 +28,8 @@
 #include "vtkTriangle.h"
 #include "vtkTriangleFilter.h"
 
+#include <vtkstd/vector>
+
 vtkStandardNewMacro(vtkWindowedSincPolyDataFilter);
 
 // Construct object with number of iterations 20; passband .1;
@@ -50,6 +53,8 @@ vtkWindowedSincPolyDataFilter::vtkWindowedSincPolyDataFilter()
   this->GenerateErrorVectors = 0;
 
   this->NormalizeCoordinates = 0;
+
+  this->NumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
 }
 
 #define VTK_SIMPLE_VERTEX 0
@@ -63,6 +68,179 @@ typedef struct _vtkMeshVertex
   char      type;
   vtkIdList *edges; // connected edges (list of connected point ids)
 } vtkMeshVertex, *vtkMeshVertexPtr;
+
+// Minimum number of points smoothed by each thread
+#define VTK_WINDOWED_SINC_MIN_POINTS_PER_THREAD 10000
+
+namespace
+{
+// The data shared by the threads running a smoothing iteration
+struct vtkWindowedSincPolyDataFilterThreadStruct
+{
+  vtkIdType NumberOfPoints;
+  int NumberOfThreads;
+  const vtkMeshVertex *Verts;
+  // compressed connectivity: the points connected to point i are
+  // Neighbors[Offsets[i]] to Neighbors[Offsets[i+1]-1]
+  const vtkIdType *Offsets;
+  const vtkIdType *Neighbors;
+  // the four vectors of points of the iteration, as flat xyz arrays
+  float *X0;
+  float *X1;
+  float *X2;
+  float *X3;
+  const double *C;
+  int IterationNumber;
+};
+
+// First iteration over a contiguous range of points: x1 = x0 - 0.5 L(x0)
+// and x3 = c0 x0 + c1 x1, where L(x) is the negative of the laplacian.
+VTK_THREAD_RETURN_TYPE vtkWindowedSincPolyDataFilterFirstIteration(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkWindowedSincPolyDataFilterThreadStruct *ts =
+    static_cast<vtkWindowedSincPolyDataFilterThreadStruct *>(info->UserData);
+  int threadId = info->ThreadID;
+  vtkIdType begin = ts->NumberOfPoints*threadId/ts->NumberOfThreads;
+  vtkIdType end = ts->NumberOfPoints*(threadId + 1)/ts->NumberOfThreads;
+  const float *x0 = ts->X0;
+  float *x1 = ts->X1;
+  float *x3 = ts->X3;
+  const double *c = ts->C;
+  double x[3], deltaX[3];
+  int k;
+
+  for (vtkIdType i=begin; i < end; i++)
+    {
+    const vtkIdType *nei = ts->Neighbors + ts->Offsets[i];
+    vtkIdType npts = ts->Offsets[i+1] - ts->Offsets[i];
+    if ( npts > 0 )
+      {
+      // point is allowed to move
+      for (k=0; k<3; k++)
+        {
+        x[k] = x0[3*i+k];
+        deltaX[k] = 0.0;
+        }
+
+      // calculate the negative of the laplacian
+      for (vtkIdType j=0; j<npts; j++) //for all connected points
+        {
+        const float *y = x0 + 3*nei[j];
+        for (k=0; k<3; k++)
+          {
+          deltaX[k] += (x[k] - y[k]) / npts;
+          }
+        }
+      for (k=0; k<3; k++)
+        {
+        deltaX[k] = x[k] - 0.5*deltaX[k];
+        x1[3*i+k] = static_cast<float>(deltaX[k]);
+        }
+
+      if (ts->Verts[i].type == VTK_FIXED_VERTEX)
+        {
+        for (k=0; k<3; k++)
+          {
+          x3[3*i+k] = x0[3*i+k];
+          }
+        }
+      else
+        {
+        for (k=0; k<3; k++)
+          {
+          x3[3*i+k] = static_cast<float>(c[0]*x[k] + c[1]*deltaX[k]);
+          }
+        }
+      }//if can move point
+    else
+      {
+      // point is not allowed to move, just use the old point...
+      // (zero out the Laplacian)
+      for (k=0; k<3; k++)
+        {
+        x1[3*i+k] = 0.0f;
+        x3[3*i+k] = x0[3*i+k];
+        }
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+// Next iterations over a contiguous range of points: x2 = 2 x1 - x0 -
+// L(x1) and x3 = x3 + cj x2. They only read the neighbors in x1 and write
+// the points of the range, so that the threads do not depend on each other.
+VTK_THREAD_RETURN_TYPE vtkWindowedSincPolyDataFilterIteration(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkWindowedSincPolyDataFilterThreadStruct *ts =
+    static_cast<vtkWindowedSincPolyDataFilterThreadStruct *>(info->UserData);
+  int threadId = info->ThreadID;
+  vtkIdType begin = ts->NumberOfPoints*threadId/ts->NumberOfThreads;
+  vtkIdType end = ts->NumberOfPoints*(threadId + 1)/ts->NumberOfThreads;
+  const float *x0 = ts->X0;
+  const float *x1 = ts->X1;
+  float *x2 = ts->X2;
+  float *x3 = ts->X3;
+  double cj = ts->C[ts->IterationNumber];
+  double p_x0[3], p_x1[3], deltaX[3];
+  int k;
+
+  for (vtkIdType i=begin; i < end; i++)
+    {
+    const vtkIdType *nei = ts->Neighbors + ts->Offsets[i];
+    vtkIdType npts = ts->Offsets[i+1] - ts->Offsets[i];
+    if ( npts > 0 )
+      {
+      // point is allowed to move
+      for (k=0; k<3; k++)
+        {
+        p_x0[k] = x0[3*i+k];
+        p_x1[k] = x1[3*i+k];
+        deltaX[k] = 0.0;
+        }
+
+      // calculate the negative laplacian of x1
+      for (vtkIdType j=0; j<npts; j++)
+        {
+        const float *y = x1 + 3*nei[j];
+        for (k=0; k<3; k++)
+          {
+          deltaX[k] += (p_x1[k] - y[k]) / npts;
+          }
+        }//for all connected points
+
+      // Taubin:  x2 = (x1 - x0) + (x1 - x2)
+      for (k=0; k<3; k++)
+        {
+        deltaX[k] = p_x1[k] - p_x0[k] + p_x1[k] - deltaX[k];
+        x2[3*i+k] = static_cast<float>(deltaX[k]);
+        }
+
+      // smooth the vertex (x3 = x3 + cj x2)
+      if (ts->Verts[i].type != VTK_FIXED_VERTEX)
+        {
+        for (k=0; k<3; k++)
+          {
+          x3[3*i+k] = static_cast<float>(x3[3*i+k] + cj*deltaX[k]);
+          }
+        }
+      }//if can move point
+    else
+      {
+      // point is not allowed to move: zero out the Laplacian. (Its x1 was
+      // zeroed by the previous iteration.)
+      for (k=0; k<3; k++)
+        {
+        x2[3*i+k] = 0.0f;
+        }
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+}
     
 int vtkWindowedSincPolyDataFilter::RequestData(
   vtkInformation *vtkNotUsed(request),
@@ -84,7 +262,6 @@ int vtkWindowedSincPolyDataFilter::RequestData(
   vtkIdType npts = 0;
   vtkIdType *pts = 0;
   vtkIdType p1, p2;
-  double x[3], y[3], deltaX[3], xNew[3];
   double x1[3], x2[3], x3[3], l1[3], l2[3];
   double CosFeatureAngle; //Cosine of angle between adjacent polys
   double CosEdgeAngle; // Cosine of angle between adjacent edges
@@ -98,7 +275,7 @@ int vtkWindowedSincPolyDataFilter::RequestData(
   vtkMeshVertexPtr Verts;
 
   // variables specific to windowed sinc interpolation
-  double theta_pb, k_pb, sigma, p_x0[3], p_x1[3], p_x3[3];
+  double theta_pb, k_pb, sigma;
   double *w, *c, *cprime;
   int zero, one, two, three;
   
@@ -428,6 +605,25 @@ int vtkWindowedSincPolyDataFilter::RequestData(
                 << numFEdges << " feature edge vertices\n\t"
                 << numBEdges << " boundary edge vertices\n\t"
                 << numFixed << " fixed vertices\n\t");
+
+  // Compress the connectivity array into flat offsets and neighbor ids,
+  // which the iterations sweep instead of the lists.
+  vtkstd::vector<vtkIdType> offsets(numPts+1);
+  vtkstd::vector<vtkIdType> neighborIds;
+  for (i=0; i<numPts; i++)
+    {
+    offsets[i] = static_cast<vtkIdType>(neighborIds.size());
+    if ( Verts[i].edges != NULL )
+      {
+      npts = Verts[i].edges->GetNumberOfIds();
+      pts = Verts[i].edges->GetPointer(0);
+      neighborIds.insert(neighborIds.end(), pts, pts + npts);
+      Verts[i].edges->Delete();
+      Verts[i].edges = NULL;
+      }
+    }
+  offsets[numPts] = static_cast<vtkIdType>(neighborIds.size());
+  neighborIds.push_back(0); // so that the array is never empty
 //
 // Perform Windowed Sinc function interpolation
 //
@@ -436,14 +632,12 @@ int vtkWindowedSincPolyDataFilter::RequestData(
   // need 4 vectors of points
   zero=0; one=1; two=2; three=3;
 
-  newPts[0] = vtkPoints::New();
-  newPts[0]->SetNumberOfPoints(numPts);
-  newPts[1] = vtkPoints::New();
-  newPts[1]->SetNumberOfPoints(numPts);
-  newPts[2] = vtkPoints::New();
-  newPts[2]->SetNumberOfPoints(numPts);
-  newPts[3] = vtkPoints::New();
-  newPts[3]->SetNumberOfPoints(numPts);
+  for (j=0; j<4; j++)
+    {
+    newPts[j] = vtkPoints::New();
+    newPts[j]->SetDataTypeToFloat();
+    newPts[j]->SetNumberOfPoints(numPts);
+    }
 
   // Get the center and length of the input dataset
   double *inCenter = input->GetCenter();
@@ -490,9 +684,6 @@ int vtkWindowedSincPolyDataFilter::RequestData(
   c = new double[this->NumberOfIterations+1];
   cprime = new double[this->NumberOfIterations+1];
 
-  double zerovector[3];
-  zerovector[0] = zerovector[1] = zerovector[2] = 0.0;    
-
   //
   // Calculate the weights and the Chebychev coefficients c.
   //
@@ -578,56 +769,50 @@ int vtkWindowedSincPolyDataFilter::RequestData(
     vtkErrorMacro(<< "An optimal offset for the smoothing filter could not be found.  Unpredictable smoothing/shrinkage may result.");
     }
   
-  // first iteration
-  for (i=0; i<numPts; i++) 
+  // The iterations are run by NumberOfThreads threads, each of them
+  // smoothing a range of points.
+  int numThreads = this->NumberOfThreads;
+  int maxThreads = vtkMultiThreader::GetGlobalMaximumNumberOfThreads();
+  if (maxThreads > 0 && numThreads > maxThreads)
     {
-    if ( Verts[i].edges != NULL &&
-         (npts = Verts[i].edges->GetNumberOfIds()) > 0 )
-      {
-      // point is allowed to move
-      newPts[zero]->GetPoint(i, x); //use current points
-      deltaX[0] = deltaX[1] = deltaX[2] = 0.0;
-      
-      // calculate the negative of the laplacian
-      for (j=0; j<npts; j++) //for all connected points
-        {
-        newPts[zero]->GetPoint(Verts[i].edges->GetId(j), y);
-        for (k=0; k<3; k++)
-          {
-          deltaX[k] += (x[k] - y[k]) / npts;
-          }
-        }
-      // newPts[one] = newPts[zero] - 0.5 newPts[one]
-      for (k=0; k<3; k++)
-        {
-        deltaX[k] = x[k] - 0.5*deltaX[k];
-        }
-      newPts[one]->SetPoint(i, deltaX);
-      
-      // calculate newPts[three] = c0 newPts[zero] + c1 newPts[one]
-      for (k=0; k < 3; k++)
-        {
-        deltaX[k] = c[0]*x[k] + c[1]*deltaX[k];
-        }
-      if (Verts[i].type == VTK_FIXED_VERTEX)
-        {
-        newPts[three]->SetPoint(i, newPts[zero]->GetPoint(i));
-        }
-      else
-        {
-        newPts[three]->SetPoint(i, deltaX);
-        }
-      }//if can move point
-    else
-      {
-      // point is not allowed to move, just use the old point...
-      // (zero out the Laplacian)
-      newPts[one]->SetPoint(i, zerovector);
-      newPts[three]->SetPoint(i, newPts[zero]->GetPoint(i));
-      }
-    }//for all points
-  
+    numThreads = maxThreads;
+    }
+  if (numThreads > numPts / VTK_WINDOWED_SINC_MIN_POINTS_PER_THREAD)
+    {
+    numThreads = static_cast<int>(
+      numPts / VTK_WINDOWED_SINC_MIN_POINTS_PER_THREAD);
+    }
+  if (numThreads < 1)
+    {
+    numThreads = 1;
+    }
+  vtkMultiThreader *threader = vtkMultiThreader::New();
+  threader->SetNumberOfThreads(numThreads);
+
+  float *ptsData[4];
+  for (j=0; j<4; j++)
+    {
+    ptsData[j] = static_cast<float *>(newPts[j]->GetVoidPointer(0));
+    }
+  vtkWindowedSincPolyDataFilterThreadStruct ts;
+  ts.NumberOfPoints = numPts;
+  ts.NumberOfThreads = numThreads;
+  ts.Verts = Verts;
+  ts.Offsets = &offsets[0];
+  ts.Neighbors = &neighborIds[0];
+  ts.X0 = ptsData[zero];
+  ts.X1 = ptsData[one];
+  ts.X2 = ptsData[two];
+  ts.X3 = ptsData[three];
+  ts.C = c;
+  ts.IterationNumber = 1;
+
+  // first iteration
+  threader->SetSingleMethod(vtkWindowedSincPolyDataFilterFirstIteration, &ts);
+  threader->SingleMethodExecute();
+
   // for the rest of the iterations
+  threader->SetSingleMethod(vtkWindowedSincPolyDataFilterIteration, &ts);
   for ( iterationNumber=2, abortExecute=0;
         iterationNumber <= this->NumberOfIterations && !abortExecute;
         iterationNumber++ )
@@ -641,54 +826,12 @@ int vtkWindowedSincPolyDataFilter::RequestData(
         break;
         }
       }
-    
-    for (i=0; i<numPts; i++) 
-      {
-      if ( Verts[i].edges != NULL &&
-           (npts = Verts[i].edges->GetNumberOfIds()) > 0 )
-        {
-        // point is allowed to move
-        newPts[zero]->GetPoint(i, p_x0); //use current points
-        newPts[one]->GetPoint(i, p_x1);
-        
-        deltaX[0] = deltaX[1] = deltaX[2] = 0.0;
-        
-        // calculate the negative laplacian of x1
-        for (j=0; j<npts; j++)
-          {
-          newPts[one]->GetPoint(Verts[i].edges->GetId(j), y);
-          for (k=0; k<3; k++)
-            {
-            deltaX[k] += (p_x1[k] - y[k]) / npts;
-            }
-          }//for all connected points
-        
-        // Taubin:  x2 = (x1 - x0) + (x1 - x2)
-        for (k=0; k<3; k++)
-          {
-          deltaX[k] = p_x1[k] - p_x0[k] + p_x1[k] - deltaX[k];
-          }
-        newPts[two]->SetPoint(i, deltaX);
 
-        // smooth the vertex (x3 = x3 + cj x2)
-        newPts[three]->GetPoint(i, p_x3);
-        for (k=0;k<3;k++) 
-          {
-          xNew[k] = p_x3[k] + c[iterationNumber] * deltaX[k];
-          }
-        if (Verts[i].type != VTK_FIXED_VERTEX)
-          {
-          newPts[three]->SetPoint(i,xNew);
-          }
-        }//if can move point
-      else
-        {
-        // point is not allowed to move, just use the old point...
-        // (zero out the Laplacian)
-        newPts[one]->SetPoint(i, zerovector);
-        newPts[two]->SetPoint(i, zerovector);
-        }
-      }//for all points
+    ts.X0 = ptsData[zero];
+    ts.X1 = ptsData[one];
+    ts.X2 = ptsData[two];
+    ts.IterationNumber = iterationNumber;
+    threader->SingleMethodExecute();
 
     // update the pointers. three is always three. all other pointers
     // shift by one and wrap.
@@ -697,6 +840,8 @@ int vtkWindowedSincPolyDataFilter::RequestData(
     two = (1+two)%3;
     
     }//for all iterations or until converge
+  threader->Delete();
+  newPts[three]->Modified();
   
   // move the iteration count back down so that it matches the
   // actual number of iterations executed
@@ -781,13 +926,12 @@ int vtkWindowedSincPolyDataFilter::RequestData(
   output->SetStrips(input->GetStrips());
 
   // finally delete the constructed (local) mesh
-  inMesh->Delete();
-  
-  //free up connectivity storage
-  for (i=0; i<numPts; i++)
+  if (inMesh)
     {
-    if ( Verts[i].edges != NULL ) {Verts[i].edges->Delete();}
+    inMesh->Delete();
     }
+  
+  //free up connectivity storage
   delete [] Verts;
 
   return 1;
@@ -807,4 +951,5 @@ void vtkWindowedSincPolyDataFilter::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "Nonmanifold Smoothing: " << (this->NonManifoldSmoothing ? "On\n" : "Off\n");
   os << indent << "Generate Error Scalars: " << (this->GenerateErrorScalars ? "On\n" : "Off\n");
   os << indent << "Generate Error Vectors: " << (this->GenerateErrorVectors ? "On\n" : "Off\n");
+  os << indent << "Number Of Threads: " << this->NumberOfThreads << "\n";
 }
@@ -123,6 +123,12 @@
 // ivar GenerateErrorVectors is on, then a vector representing change in 
 // position is computed.
 //
+// The connectivity array is compressed into flat offset and neighbor arrays
+// once the topology is known, and the iterations sweep flat coordinate
+// arrays. Each iteration only reads the points of the previous ones, so
+// the points are smoothed by several threads (see NumberOfThreads) with
+// the same result as a single thread.
+//
 // .SECTION Caveats
 // The smoothing operation reduces high frequency information in the
 // geometry of the mesh. With excessive smoothing important details may be
@@ -216,6 +222,13 @@ public:
   vtkSetMacro(GenerateErrorVectors,int);
   vtkGetMacro(GenerateErrorVectors,int);
   vtkBooleanMacro(GenerateErrorVectors,int);
+
+  // Description:
+  // Set/Get the number of threads running the smoothing iterations. Small
+  // meshes use fewer threads. The smoothed points do not depend on this
+  // number. The default is vtkMultiThreader::GetGlobalDefaultNumberOfThreads().
+  vtkSetClampMacro(NumberOfThreads,int,1,VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads,int);
   
  protected:
   vtkWindowedSincPolyDataFilter();
@@ -233,6 +246,7 @@ public:
   int GenerateErrorScalars;
   int GenerateErrorVectors;
   int NormalizeCoordinates;
+  int NumberOfThreads;
 private:
   vtkWindowedSincPolyDataFilter(const vtkWindowedSincPolyDataFilter&);  // Not implemented.
   void operator=(const vtkWindowedSincPolyDataFilter&);  // Not implemented.
@@ -19,6 +19,8 @@
 #include "vtkCellArray.h"
 #include "vtkCellData.h"
 #include "vtkFloatArray.h"
+#include "vtkIdTypeArray.h"
+#include "vtkMergeCoincidentPoints.h"
 #include "vtkMergePoints.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
@@ -42,6 +44,7 @@ vtkSTLReader::vtkSTLReader()
 {
   this->FileName = NULL;
   this->Merging = 1;
+  this->ParallelMerging = 0;
   this->ScalarTags = 0;
   this->Locator = NULL;
 
@@ -165,18 +168,38 @@ int vtkSTLReader::RequestData(
       mergedScalars->Allocate(newPolys->GetSize());
       }
 
-    if ( this->Locator == NULL )
+    // The points of the facets are stored in the order the locator
+    // would see them, so merging them all at once gives the same ids.
+    vtkIdTypeArray *mergeMap = NULL;
+    if ( this->ParallelMerging )
       {
-      this->CreateDefaultLocator();
+      vtkMergeCoincidentPoints *merger = vtkMergeCoincidentPoints::New();
+      mergeMap = vtkIdTypeArray::New();
+      merger->MergePoints(newPts, mergeMap, mergedPts);
+      merger->Delete();
+      }
+    else
+      {
+      if ( this->Locator == NULL )
+        {
+        this->CreateDefaultLocator();
+        }
+      this->Locator->InitPointInsertion (mergedPts, newPts->GetBounds());
       }
-    this->Locator->InitPointInsertion (mergedPts, newPts->GetBounds());
 
     for (newPolys->InitTraversal(); newPolys->GetNextCell(npts,pts); )
       {
       for (i=0; i < 3; i++)
         {
-        newPts->GetPoint(pts[i],x);
-        this->Locator->InsertUniquePoint(x, nodes[i]);
+        if ( mergeMap )
+          {
+          nodes[i] = mergeMap->GetValue(pts[i]);
+          }
+        else
+          {
+          newPts->GetPoint(pts[i],x);
+          this->Locator->InsertUniquePoint(x, nodes[i]);
+          }
         }
 
       if ( nodes[0] != nodes[1] &&
@@ -192,6 +215,10 @@ int vtkSTLReader::RequestData(
       nextCell++;
       }
 
+    if ( mergeMap )
+      {
+      mergeMap->Delete();
+      }
     newPts->Delete();
     newPolys->Delete();
     if (newScalars) 
@@ -420,6 +447,8 @@ void vtkSTLReader::PrintSelf(ostream& os, vtkIndent indent)
      << (this->FileName ? this->FileName : "(none)") << "\n";
 
   os << indent << "Merging: " << (this->Merging ? "On\n" : "Off\n");
+  os << indent << "ParallelMerging: "
+     << (this->ParallelMerging ? "On\n" : "Off\n");
   os << indent << "ScalarTags: " << (this->ScalarTags ? "On\n" : "Off\n");
   os << indent << "Locator: ";
   if ( this->Locator )
@@ -65,6 +65,15 @@ public:
   vtkGetMacro(Merging,int);
   vtkBooleanMacro(Merging,int);
 
+  // Description:
+  // Turn on/off merging the points in bulk, with multiple threads, using
+  // vtkMergeCoincidentPoints instead of the Locator.  The output is the
+  // same as with the default vtkMergePoints locator; any Locator set is
+  // ignored.  Default is off.
+  vtkSetMacro(ParallelMerging,int);
+  vtkGetMacro(ParallelMerging,int);
+  vtkBooleanMacro(ParallelMerging,int);
+
   // Description:
   // Turn on/off tagging of solids with scalars.
   vtkSetMacro(ScalarTags,int);
@@ -87,6 +96,7 @@ protected:
 
   char *FileName;
   int Merging;
+  int ParallelMerging;
   int ScalarTags;
   vtkIncrementalPointLocator *Locator;
 
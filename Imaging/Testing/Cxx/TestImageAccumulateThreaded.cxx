@@ -0,0 +1,257 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestImageAccumulateThreaded.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Checks the joint and per-component histograms and the statistics of
+// vtkImageAccumulate against a direct count, with and without a stencil,
+// reversed or not, ignoring zero or not, for integers counted per value
+// and for other types, whatever the number of threads.
+
+#include "vtkImageAccumulate.h"
+#include "vtkImageData.h"
+#include "vtkImageStencilData.h"
+#include "vtkPointData.h"
+
+#include <vtkstd/vector>
+
+#include <math.h>
+
+static int Extent[6] = {-3, 40, 2, 33, 0, 12};
+
+static vtkImageData *MakeImage(int scalarType, int numComponents)
+{
+  vtkImageData *image = vtkImageData::New();
+  image->SetExtent(Extent);
+  image->SetScalarType(scalarType);
+  image->SetNumberOfScalarComponents(numComponents);
+  image->AllocateScalars();
+  vtkDataArray *scalars = image->GetPointData()->GetScalars();
+  vtkIdType numValues = scalars->GetNumberOfTuples()*numComponents;
+  for (vtkIdType i=0; i < numValues; i++)
+    {
+    // a smooth pattern with noise, and zeros
+    double noise = ((i*7919) % 101)/100.0 - 0.5;
+    double value = 60*sin(0.003*i) + 20*noise;
+    if (scalarType == VTK_UNSIGNED_CHAR)
+      {
+      value = floor(value + 100);
+      }
+    else if (scalarType != VTK_FLOAT && scalarType != VTK_DOUBLE)
+      {
+      value = floor(value);
+      }
+    scalars->SetComponent(i / numComponents, i % numComponents,
+                          (i % 13 == 0 ? 0 : value));
+    }
+  return image;
+}
+
+// The stencil has up to two spans per row, and no span in some rows.
+static void StencilSpans(int j, int k, int spans[4])
+{
+  spans[0] = Extent[0] + (3*j + k) % 7;
+  spans[1] = spans[0] + 10 + (j + k) % 19;
+  spans[2] = spans[1] + 3;
+  spans[3] = spans[2] + (j*k) % 5;
+  if ((j + k) % 5 == 0)
+    {
+    spans[1] = spans[0] - 1;
+    spans[3] = spans[2] - 1;
+    }
+}
+
+static vtkImageStencilData *MakeStencil()
+{
+  vtkImageStencilData *stencil = vtkImageStencilData::New();
+  stencil->SetExtent(Extent);
+  stencil->AllocateExtents();
+  for (int k=Extent[4]; k <= Extent[5]; k++)
+    {
+    for (int j=Extent[2]; j <= Extent[3]; j++)
+      {
+      int spans[4];
+      StencilSpans(j, k, spans);
+      for (int s=0; s < 4; s += 2)
+        {
+        if (spans[s] <= spans[s+1])
+          {
+          stencil->InsertNextExtent(spans[s], spans[s+1], j, k);
+          }
+        }
+      }
+    }
+  return stencil;
+}
+
+// Count the histogram and the statistics directly, and return the number
+// of differences with the output of the filter.
+static int CheckHistogram(vtkImageData *image, int useStencil,
+                          vtkImageAccumulate *filter)
+{
+  int numC = image->GetNumberOfScalarComponents();
+  int perComponent =
+    (filter->GetHistogramMode() == VTK_ACCUMULATE_PER_COMPONENT);
+  double *origin = filter->GetComponentOrigin();
+  double *spacing = filter->GetComponentSpacing();
+  int *binExt = filter->GetComponentExtent();
+  int numBins[3] = {binExt[1] - binExt[0] + 1, binExt[3] - binExt[2] + 1,
+                    binExt[5] - binExt[4] + 1};
+  vtkstd::vector<vtkIdType> bins(perComponent ? numBins[0]*numC :
+                                 numBins[0]*numBins[1]*numBins[2], 0);
+  double sum[3] = {0, 0, 0}, sumSqr[3] = {0, 0, 0};
+  double min[3] = {VTK_DOUBLE_MAX, VTK_DOUBLE_MAX, VTK_DOUBLE_MAX};
+  double max[3] = {VTK_DOUBLE_MIN, VTK_DOUBLE_MIN, VTK_DOUBLE_MIN};
+  vtkIdType count = 0;
+  for (int k=Extent[4]; k <= Extent[5]; k++)
+    {
+    for (int j=Extent[2]; j <= Extent[3]; j++)
+      {
+      int spans[4];
+      StencilSpans(j, k, spans);
+      for (int i=Extent[0]; i <= Extent[1]; i++)
+        {
+        if (useStencil)
+          {
+          bool inside = ((i >= spans[0] && i <= spans[1]) ||
+                         (i >= spans[2] && i <= spans[3]));
+          if (inside == (useStencil == 2))
+            {
+            continue;
+            }
+          }
+        vtkIdType bin = 0;
+        vtkIdType stride = 1;
+        bool inRange = true;
+        for (int c=0; c < numC; c++)
+          {
+          double v = image->GetScalarComponentAsDouble(i, j, k, c);
+          if (c < 3 && (!filter->GetIgnoreZero() || v != 0))
+            {
+            sum[c] += v;
+            sumSqr[c] += v*v;
+            min[c] = (v < min[c] ? v : min[c]);
+            max[c] = (v > max[c] ? v : max[c]);
+            count++;
+            }
+          int axis = (perComponent ? 0 : c);
+          int idx = static_cast<int>(floor((v - origin[axis])/spacing[axis]));
+          idx -= binExt[2*axis];
+          if (perComponent)
+            {
+            if (idx >= 0 && idx < numBins[0])
+              {
+              bins[c*numBins[0] + idx]++;
+              }
+            continue;
+            }
+          inRange = inRange && idx >= 0 && idx < numBins[c];
+          bin += idx*stride;
+          stride *= numBins[c];
+          }
+        if (!perComponent && inRange)
+          {
+          bins[bin]++;
+          }
+        }
+      }
+    }
+
+  int numErrors = 0;
+  vtkDataArray *output = filter->GetOutput()->GetPointData()->GetScalars();
+  if (output->GetNumberOfTuples() != static_cast<vtkIdType>(bins.size()))
+    {
+    return 1;
+    }
+  for (size_t b=0; b < bins.size(); b++)
+    {
+    numErrors += (output->GetComponent(static_cast<vtkIdType>(b), 0) !=
+                  bins[b]);
+    }
+  numErrors += (filter->GetVoxelCount() != count);
+  for (int c=0; c < 3 && c < numC; c++)
+    {
+    double n = static_cast<double>(count);
+    double mean = sum[c]/n;
+    double std = sqrt((sumSqr[c] - mean*mean*n)/(n - 1));
+    numErrors += (filter->GetMin()[c] != min[c]);
+    numErrors += (filter->GetMax()[c] != max[c]);
+    numErrors += (fabs(filter->GetMean()[c] - mean) > 1e-9*(1 + fabs(mean)));
+    numErrors += (fabs(filter->GetStandardDeviation()[c] - std) >
+                  1e-9*(1 + std));
+    }
+  return numErrors;
+}
+
+int TestImageAccumulateThreaded(int, char *[])
+{
+  int rval = 0;
+
+  // Chars of 1 or all components are counted per value first.
+  int types[5] = {VTK_UNSIGNED_CHAR, VTK_SIGNED_CHAR, VTK_SHORT, VTK_FLOAT,
+                  VTK_DOUBLE};
+  int numComponents[5] = {1, 2, 2, 3, 5};
+  int modes[5] = {VTK_ACCUMULATE_JOINT, VTK_ACCUMULATE_PER_COMPONENT,
+                  VTK_ACCUMULATE_JOINT, VTK_ACCUMULATE_JOINT,
+                  VTK_ACCUMULATE_PER_COMPONENT};
+
+  vtkImageAccumulate *serial = vtkImageAccumulate::New();
+  serial->SetNumberOfThreads(1);
+  vtkImageAccumulate *threaded = vtkImageAccumulate::New();
+  threaded->SetNumberOfThreads(4);
+  threaded->SetSplitModeToBlock();
+  threaded->SetOutputScalarTypeToIdType();
+  vtkImageAccumulate *filters[2] = {serial, threaded};
+  vtkImageStencilData *stencil = MakeStencil();
+  for (int t=0; t < 5; t++)
+    {
+    vtkImageData *image = MakeImage(types[t], numComponents[t]);
+    for (int f=0; f < 2; f++)
+      {
+      // bins of 4 values from -20 on, so that some values are left out
+      filters[f]->SetInput(image);
+      filters[f]->SetHistogramMode(modes[t]);
+      filters[f]->SetComponentOrigin(-20.0, -20.0, -20.0);
+      filters[f]->SetComponentSpacing(4.0, 4.0, 4.0);
+      filters[f]->SetComponentExtent(0, 39, 0, (numComponents[t] > 1 ? 9 : 0),
+                                     0, (numComponents[t] > 2 ? 4 : 0));
+      for (int s=0; s < 3; s++)
+        {
+        filters[f]->SetStencil(s ? stencil : 0);
+        filters[f]->SetReverseStencil(s == 2);
+        for (int ignoreZero=0; ignoreZero < 2; ignoreZero++)
+          {
+          filters[f]->SetIgnoreZero(ignoreZero);
+          filters[f]->Update();
+          int numErrors = CheckHistogram(image, s, filters[f]);
+          if (numErrors)
+            {
+            cerr << image->GetScalarTypeAsString() << " "
+                 << numComponents[t] << " components "
+                 << filters[f]->GetHistogramModeAsString()
+                 << (s ? (s == 2 ? " reversed stencil" : " stencil") : "")
+                 << (ignoreZero ? " ignore zero" : "") << " with "
+                 << filters[f]->GetNumberOfThreads() << " threads: "
+                 << numErrors << " wrong bins or statistics" << endl;
+            rval++;
+            }
+          }
+        }
+      }
+    image->Delete();
+    }
+
+  stencil->Delete();
+  serial->Delete();
+  threaded->Delete();
+  return rval;
+}
@@ -0,0 +1,200 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestImageConnectedComponents.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Checks the labels, sizes and extents of vtkImageConnectedComponents
+// against a flood fill, for every connectivity, with and without separate
+// values, in volumes and images, whatever the number of threads.
+
+#include "vtkIdTypeArray.h"
+#include "vtkImageConnectedComponents.h"
+#include "vtkImageData.h"
+#include "vtkIntArray.h"
+#include "vtkPointData.h"
+
+#include <vtkstd/vector>
+
+static vtkImageData *MakeImage(int maxZ)
+{
+  vtkImageData *image = vtkImageData::New();
+  image->SetExtent(-2, 29, 3, 25, 1, maxZ);
+  image->SetScalarType(VTK_SHORT);
+  image->AllocateScalars();
+  short *ptr = static_cast<short *>(image->GetScalarPointer());
+  vtkIdType numPoints = image->GetNumberOfPoints();
+  for (vtkIdType ptId=0; ptId < numPoints; ptId++)
+    {
+    // about half the voxels are set, to one of three values
+    unsigned int hash = static_cast<unsigned int>(ptId)*2654435761u;
+    hash ^= hash >> 13;
+    ptr[ptId] = static_cast<short>((hash % 7) < 3 ? 0 : 1 + (hash % 3));
+    }
+  return image;
+}
+
+// Label the regions by flood fill, in the order of their first voxel.
+static vtkIdType FloodFill(vtkImageData *image, int connectivity,
+                           int separate, vtkstd::vector<vtkIdType> &labels)
+{
+  int dims[3];
+  image->GetDimensions(dims);
+  short *ptr = static_cast<short *>(image->GetScalarPointer());
+  vtkIdType numPoints = image->GetNumberOfPoints();
+  labels.assign(numPoints, 0);
+  vtkstd::vector<vtkIdType> stack;
+  vtkIdType numLabels = 0;
+  for (vtkIdType seed=0; seed < numPoints; seed++)
+    {
+    if (ptr[seed] == 0 || labels[seed] != 0)
+      {
+      continue;
+      }
+    labels[seed] = ++numLabels;
+    stack.push_back(seed);
+    while (!stack.empty())
+      {
+      vtkIdType ptId = stack.back();
+      stack.pop_back();
+      int ijk[3] = {static_cast<int>(ptId % dims[0]),
+                    static_cast<int>((ptId / dims[0]) % dims[1]),
+                    static_cast<int>(ptId / dims[0] / dims[1])};
+      for (int dz=-1; dz <= 1; dz++)
+        {
+        for (int dy=-1; dy <= 1; dy++)
+          {
+          for (int dx=-1; dx <= 1; dx++)
+            {
+            int distance = (dx != 0) + (dy != 0) + (dz != 0);
+            int n[3] = {ijk[0] + dx, ijk[1] + dy, ijk[2] + dz};
+            if (distance == 0 || (distance == 2 && connectivity < 18) ||
+                (distance == 3 && connectivity < 26) ||
+                n[0] < 0 || n[0] >= dims[0] || n[1] < 0 || n[1] >= dims[1] ||
+                n[2] < 0 || n[2] >= dims[2])
+              {
+              continue;
+              }
+            vtkIdType neighbor = n[0] + dims[0]*(n[1] +
+              static_cast<vtkIdType>(dims[1])*n[2]);
+            if (ptr[neighbor] != 0 && labels[neighbor] == 0 &&
+                (!separate || ptr[neighbor] == ptr[ptId]))
+              {
+              labels[neighbor] = numLabels;
+              stack.push_back(neighbor);
+              }
+            }
+          }
+        }
+      }
+    }
+  return numLabels;
+}
+
+// Returns the number of wrong labels, sizes and extents.
+static int CheckLabels(vtkImageData *image,
+                       vtkImageConnectedComponents *filter,
+                       const vtkstd::vector<vtkIdType> &labels,
+                       vtkIdType numLabels)
+{
+  if (filter->GetNumberOfLabels() != numLabels)
+    {
+    return 1;
+    }
+  int ext[6];
+  image->GetExtent(ext);
+  vtkDataArray *output = filter->GetOutput()->GetPointData()->GetScalars();
+  vtkstd::vector<vtkIdType> sizes(numLabels, 0);
+  vtkstd::vector<int> extents(6*numLabels);
+  int numErrors = 0;
+  vtkIdType ptId = 0;
+  for (int k=ext[4]; k <= ext[5]; k++)
+    {
+    for (int j=ext[2]; j <= ext[3]; j++)
+      {
+      for (int i=ext[0]; i <= ext[1]; i++, ptId++)
+        {
+        vtkIdType label = labels[ptId];
+        numErrors += (output->GetComponent(ptId, 0) != label);
+        if (label == 0)
+          {
+          continue;
+          }
+        int *extent = &extents[6*(label - 1)];
+        if (sizes[label - 1]++ == 0)
+          {
+          extent[0] = extent[1] = i;
+          extent[2] = extent[3] = j;
+          extent[4] = extent[5] = k;
+          }
+        extent[0] = (i < extent[0] ? i : extent[0]);
+        extent[1] = (i > extent[1] ? i : extent[1]);
+        extent[2] = (j < extent[2] ? j : extent[2]);
+        extent[3] = (j > extent[3] ? j : extent[3]);
+        extent[5] = k;
+        }
+      }
+    }
+  for (vtkIdType label=0; label < numLabels; label++)
+    {
+    numErrors += (filter->GetLabelSizes()->GetValue(label) != sizes[label]);
+    for (int c=0; c < 6; c++)
+      {
+      numErrors += (filter->GetLabelExtents()->GetComponent(label, c) !=
+                    extents[6*label + c]);
+      }
+    }
+  return numErrors;
+}
+
+int TestImageConnectedComponents(int, char *[])
+{
+  int rval = 0;
+
+  vtkImageConnectedComponents *filter = vtkImageConnectedComponents::New();
+  int connectivities[3] = {6, 18, 26};
+  int threads[3] = {1, 3, 4};
+  for (int maxZ=1; maxZ <= 14; maxZ += 13)
+    {
+    vtkImageData *image = MakeImage(maxZ);
+    filter->SetInput(image);
+    for (int c=0; c < 3; c++)
+      {
+      for (int separate=0; separate < 2; separate++)
+        {
+        vtkstd::vector<vtkIdType> labels;
+        vtkIdType numLabels = FloodFill(image, connectivities[c], separate,
+                                        labels);
+        for (int t=0; t < 3; t++)
+          {
+          filter->SetConnectivity(connectivities[c]);
+          filter->SetSeparateValues(separate);
+          filter->SetNumberOfThreads(threads[t]);
+          filter->SetOutputScalarType(t == 2 ? VTK_ID_TYPE : VTK_INT);
+          filter->Update();
+          int numErrors = CheckLabels(image, filter, labels, numLabels);
+          if (numErrors)
+            {
+            cerr << (maxZ == 1 ? "Image" : "Volume") << " connectivity "
+                 << connectivities[c] << (separate ? " separate" : "")
+                 << " with " << threads[t] << " threads: " << numErrors
+                 << " wrong labels, sizes or extents" << endl;
+            rval++;
+            }
+          }
+        }
+      }
+    image->Delete();
+    }
+
+  filter->Delete();
+  return rval;
+}
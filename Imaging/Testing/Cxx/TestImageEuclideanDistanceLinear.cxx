@@ -0,0 +1,205 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestImageEuclideanDistanceLinear.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Checks that the linear algorithm of vtkImageEuclideanDistance gives the
+// same distances as Saito's algorithm whatever the number of threads, that
+// its feature indices point to voxels at these distances, and that signed
+// distances are negative inside the objects.
+
+#include "vtkIdTypeArray.h"
+#include "vtkImageData.h"
+#include "vtkImageEuclideanDistance.h"
+#include "vtkPointData.h"
+
+#include <math.h>
+
+static vtkImageData *MakeImage(double spacing[3])
+{
+  vtkImageData *image = vtkImageData::New();
+  image->SetExtent(-3, 36, 2, 30, 0, 16);
+  image->SetSpacing(spacing);
+  image->SetScalarType(VTK_UNSIGNED_CHAR);
+  image->AllocateScalars();
+  vtkDataArray *scalars = image->GetPointData()->GetScalars();
+  vtkIdType ptId = 0;
+  for (int k=0; k <= 16; k++)
+    {
+    for (int j=2; j <= 30; j++)
+      {
+      for (int i=-3; i <= 36; i++)
+        {
+        // a ball, a slab and a few scattered voxels are the zero voxels
+        int di = i - 20, dj = j - 12, dk = k - 9;
+        int zero = (di*di + dj*dj + dk*dk < 30 || (i == 0 && k < 8) ||
+                    (i*7 + j*13 + k*31) % 97 == 0);
+        scalars->SetComponent(ptId++, 0, (zero ? 0 : 1));
+        }
+      }
+    }
+  return image;
+}
+
+// Returns the largest difference between the scalars of a and b.
+static double CompareScalars(vtkImageData *a, vtkImageData *b)
+{
+  vtkDataArray *da = a->GetPointData()->GetScalars();
+  vtkDataArray *db = b->GetPointData()->GetScalars();
+  double maxDiff = 0;
+  for (vtkIdType ptId=0; ptId < da->GetNumberOfTuples(); ptId++)
+    {
+    double diff = fabs(da->GetComponent(ptId, 0) - db->GetComponent(ptId, 0));
+    maxDiff = (diff > maxDiff ? diff : maxDiff);
+    }
+  return maxDiff;
+}
+
+// Returns the number of voxels whose feature is not a voxel of the other
+// kind at the absolute value of their distance, or has a wrong sign.
+static int CheckFeatures(vtkImageData *input, vtkImageData *output,
+                         int isSigned)
+{
+  vtkIdTypeArray *features = vtkIdTypeArray::SafeDownCast(
+    output->GetPointData()->GetArray("FeatureIndices"));
+  if (!features)
+    {
+    return 1;
+    }
+  vtkDataArray *scalars = input->GetPointData()->GetScalars();
+  vtkDataArray *distances = output->GetPointData()->GetScalars();
+  int dims[3];
+  input->GetDimensions(dims);
+  double *spacing = input->GetSpacing();
+  int numErrors = 0;
+  for (vtkIdType ptId=0; ptId < input->GetNumberOfPoints(); ptId++)
+    {
+    double value = scalars->GetComponent(ptId, 0);
+    double distance = distances->GetComponent(ptId, 0);
+    vtkIdType feature = features->GetValue(ptId);
+    if (value == 0 && !isSigned)
+      {
+      numErrors += (feature != ptId || distance != 0);
+      continue;
+      }
+    if (feature < 0 || feature >= input->GetNumberOfPoints() ||
+        (scalars->GetComponent(feature, 0) == 0) == (value == 0) ||
+        (distance < 0) != (value == 0))
+      {
+      numErrors++;
+      continue;
+      }
+    double d2 = 0;
+    for (int axis=0; axis < 3; axis++)
+      {
+      vtkIdType stride = (axis == 0 ? 1 : (axis == 1 ? dims[0] :
+                                           dims[0]*dims[1]));
+      int delta = static_cast<int>((feature / stride) % dims[axis] -
+                                   (ptId / stride) % dims[axis]);
+      d2 += delta*delta*spacing[axis]*spacing[axis];
+      }
+    numErrors += (fabs(d2 - fabs(distance)) > 1e-9*d2);
+    }
+  return numErrors;
+}
+
+int TestImageEuclideanDistanceLinear(int, char *[])
+{
+  int rval = 0;
+
+  vtkImageEuclideanDistance *saito = vtkImageEuclideanDistance::New();
+  vtkImageEuclideanDistance *serial = vtkImageEuclideanDistance::New();
+  serial->SetAlgorithmToLinear();
+  serial->SetNumberOfThreads(1);
+  vtkImageEuclideanDistance *threaded = vtkImageEuclideanDistance::New();
+  threaded->SetAlgorithmToLinear();
+  threaded->SetNumberOfThreads(4);
+  vtkImageEuclideanDistance *filters[3] = {saito, serial, threaded};
+
+  // Isotropic distances are exact, anisotropic ones are up to rounding.
+  double spacings[2][3] = {{1.0, 1.0, 1.0}, {0.7, 1.3, 2.1}};
+  for (int s=0; s < 2; s++)
+    {
+    vtkImageData *image = MakeImage(spacings[s]);
+    for (int dim=1; dim <= 3; dim++)
+      {
+      for (int f=0; f < 3; f++)
+        {
+        filters[f]->SetInput(image);
+        filters[f]->SetDimensionality(dim);
+        filters[f]->Update();
+        }
+      if (CompareScalars(serial->GetOutput(), threaded->GetOutput()) != 0)
+        {
+        cerr << "Spacing " << s << " " << dim
+             << "D distances depend on the number of threads" << endl;
+        rval++;
+        }
+      double maxDiff = CompareScalars(saito->GetOutput(),
+                                      threaded->GetOutput());
+      if (s == 0 ? maxDiff != 0 : maxDiff > 1e-9)
+        {
+        cerr << "Spacing " << s << " " << dim
+             << "D distances differ from Saito's by " << maxDiff << endl;
+        rval++;
+        }
+      }
+
+    // Feature indices, with and without signed distances, and the
+    // distances outside the objects do not change with the sign.
+    threaded->ComputeFeatureIndicesOn();
+    for (int isSigned=0; isSigned < 2; isSigned++)
+      {
+      threaded->SetSignedDistance(isSigned);
+      threaded->Update();
+      int numErrors = CheckFeatures(image, threaded->GetOutput(), isSigned);
+      if (numErrors)
+        {
+        cerr << "Spacing " << s << (isSigned ? " signed" : "") << ": "
+             << numErrors << " wrong feature indices" << endl;
+        rval++;
+        }
+      }
+    vtkDataArray *distances =
+      threaded->GetOutput()->GetPointData()->GetScalars();
+    vtkDataArray *expected = saito->GetOutput()->GetPointData()->GetScalars();
+    int numErrors = 0;
+    for (vtkIdType ptId=0; ptId < distances->GetNumberOfTuples(); ptId++)
+      {
+      double d = distances->GetComponent(ptId, 0);
+      numErrors += (d > 0 && fabs(d - expected->GetComponent(ptId, 0)) >
+                    1e-9*d);
+      }
+    if (numErrors)
+      {
+      cerr << "Spacing " << s << ": " << numErrors
+           << " signed distances differ outside the objects" << endl;
+      rval++;
+      }
+
+    // The arrays of the options go away with the options.
+    threaded->SignedDistanceOff();
+    threaded->ComputeFeatureIndicesOff();
+    threaded->Update();
+    if (threaded->GetOutput()->GetPointData()->GetNumberOfArrays() != 1)
+      {
+      cerr << "Arrays are left in the output" << endl;
+      rval++;
+      }
+    image->Delete();
+    }
+
+  saito->Delete();
+  serial->Delete();
+  threaded->Delete();
+  return rval;
+}
@@ -0,0 +1,288 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestImageFFTMixedRadix.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Checks the transforms of vtkImageFourierFilter against a direct discrete
+// Fourier transform for lengths with every kind of factor, and that
+// vtkImageFFT transforms real and complex volumes correctly whatever the
+// number of threads and the update extent, and is inverted by vtkImageRFFT.
+// The pieces of images split along the rows, so that the rows of real
+// images are paired across pieces.
+
+#include "vtkImageData.h"
+#include "vtkImageFFT.h"
+#include "vtkImageRFFT.h"
+#include "vtkMath.h"
+#include "vtkPointData.h"
+
+#include <vtkstd/vector>
+
+#include <math.h>
+
+// The direct transform of length n of the elements of in that are stride
+// apart, with the sign fb of the exponent, unscaled.
+static void DirectDFT(const vtkImageComplex *in, vtkImageComplex *out,
+                      int n, int stride, int fb)
+{
+  for (int k=0; k < n; k++)
+    {
+    double real = 0.0;
+    double imag = 0.0;
+    for (int j=0; j < n; j++)
+      {
+      double theta = -fb*vtkMath::DoubleTwoPi()*((j*k) % n)/n;
+      const vtkImageComplex &c = in[j*stride];
+      real += c.Real*cos(theta) - c.Imag*sin(theta);
+      imag += c.Real*sin(theta) + c.Imag*cos(theta);
+      }
+    out[k*stride].Real = real;
+    out[k*stride].Imag = imag;
+    }
+}
+
+static double Signal(int i, int j, int k, int c)
+{
+  return floor(100.0*sin(0.7*i + 1.3*c)*cos(0.4*j + 0.2*k) + 7.0*(i % 3));
+}
+
+static vtkImageData *MakeVolume(int scalarType, int numComponents,
+                                int maxZ)
+{
+  vtkImageData *image = vtkImageData::New();
+  image->SetExtent(0, 11, -2, 12, 1, maxZ);
+  image->SetScalarType(scalarType);
+  image->SetNumberOfScalarComponents(numComponents);
+  image->AllocateScalars();
+  vtkDataArray *scalars = image->GetPointData()->GetScalars();
+  vtkIdType ptId = 0;
+  for (int k=1; k <= maxZ; k++)
+    {
+    for (int j=-2; j <= 12; j++)
+      {
+      for (int i=0; i <= 11; i++)
+        {
+        for (int c=0; c < numComponents; c++)
+          {
+          scalars->SetComponent(ptId, c, Signal(i, j, k, c));
+          }
+        ptId++;
+        }
+      }
+    }
+  return image;
+}
+
+// Returns the largest difference between the complex scalars of a and b
+// over the extent ext, which both contain.
+static double CompareImages(vtkImageData *a, vtkImageData *b, int ext[6])
+{
+  double maxDiff = 0;
+  for (int k=ext[4]; k <= ext[5]; k++)
+    {
+    for (int j=ext[2]; j <= ext[3]; j++)
+      {
+      for (int i=ext[0]; i <= ext[1]; i++)
+        {
+        for (int c=0; c < 2; c++)
+          {
+          double diff = fabs(a->GetScalarComponentAsDouble(i, j, k, c) -
+                             b->GetScalarComponentAsDouble(i, j, k, c));
+          maxDiff = (diff > maxDiff ? diff : maxDiff);
+          }
+        }
+      }
+    }
+  return maxDiff;
+}
+
+// Returns the largest difference between the transform of the volume and
+// its direct transform along every axis.
+static double CompareToDirectDFT(vtkImageData *volume, vtkImageData *output)
+{
+  int dims[3];
+  volume->GetDimensions(dims);
+  int numComponents = volume->GetNumberOfScalarComponents();
+  vtkDataArray *scalars = volume->GetPointData()->GetScalars();
+  vtkIdType numPoints = volume->GetNumberOfPoints();
+  vtkstd::vector<vtkImageComplex> data(numPoints);
+  vtkstd::vector<vtkImageComplex> row(numPoints);
+  vtkIdType ptId;
+  for (ptId=0; ptId < numPoints; ptId++)
+    {
+    data[ptId].Real = scalars->GetComponent(ptId, 0);
+    data[ptId].Imag = (numComponents > 1 ? scalars->GetComponent(ptId, 1) : 0);
+    }
+  vtkIdType strides[3] = {1, dims[0], dims[0]*dims[1]};
+  for (int axis=0; axis < 3; axis++)
+    {
+    for (ptId=0; ptId < numPoints; ptId++)
+      {
+      vtkIdType ijk[3] = {ptId % dims[0], (ptId / dims[0]) % dims[1],
+                          ptId / (dims[0]*dims[1])};
+      if (ijk[axis] == 0)
+        {
+        DirectDFT(&data[ptId], &row[ptId], dims[axis], strides[axis], 1);
+        }
+      }
+    data.swap(row);
+    }
+  vtkDataArray *transform = output->GetPointData()->GetScalars();
+  double maxDiff = 0;
+  for (ptId=0; ptId < numPoints; ptId++)
+    {
+    double diff = fabs(transform->GetComponent(ptId, 0) - data[ptId].Real) +
+      fabs(transform->GetComponent(ptId, 1) - data[ptId].Imag);
+    maxDiff = (diff > maxDiff ? diff : maxDiff);
+    }
+  return maxDiff;
+}
+
+int TestImageFFTMixedRadix(int, char *[])
+{
+  int rval = 0;
+
+  // Lengths with factors of 4, 2, 3, 5 and other primes, in both
+  // directions.
+  vtkImageFFT *fft = vtkImageFFT::New();
+  int lengths[10] = {49, 64, 97, 120, 121, 143, 210, 243, 250, 256};
+  for (int l=-40; l < 10; l++)
+    {
+    int n = (l < 0 ? l + 41 : lengths[l]);
+    vtkstd::vector<vtkImageComplex> in(n), copy(n), out(n), expected(n);
+    double norm = 0;
+    for (int i=0; i < n; i++)
+      {
+      in[i].Real = sin(0.37*i*i + 0.5);
+      in[i].Imag = cos(1.1*i);
+      norm += fabs(in[i].Real) + fabs(in[i].Imag);
+      }
+    for (int fb=1; fb >= -1; fb -= 2)
+      {
+      DirectDFT(&in[0], &expected[0], n, 1, fb);
+      copy = in;
+      if (fb == 1)
+        {
+        fft->ExecuteFft(&copy[0], &out[0], n);
+        }
+      else
+        {
+        fft->ExecuteRfft(&copy[0], &out[0], n);
+        }
+      double maxDiff = 0;
+      for (int i=0; i < n; i++)
+        {
+        double scale = (fb == 1 ? 1.0 : n);
+        double diff = fabs(scale*out[i].Real - expected[i].Real) +
+          fabs(scale*out[i].Imag - expected[i].Imag);
+        maxDiff = (diff > maxDiff ? diff : maxDiff);
+        }
+      if (maxDiff > 1e-12*norm)
+        {
+        cerr << (fb == 1 ? "FFT" : "RFFT") << " of length " << n
+             << " differs from the direct transform by " << maxDiff << endl;
+        rval++;
+        }
+      }
+    }
+  fft->Delete();
+
+  // Volumes of 12x15x7 points, real and complex, and a real image.
+  vtkImageFFT *serial = vtkImageFFT::New();
+  serial->SetNumberOfThreads(1);
+  vtkImageFFT *threaded = vtkImageFFT::New();
+  threaded->SetNumberOfThreads(4);
+  vtkImageRFFT *reverse = vtkImageRFFT::New();
+  reverse->SetInputConnection(threaded->GetOutputPort());
+  int types[3] = {VTK_SHORT, VTK_FLOAT, VTK_DOUBLE};
+  int numComponents[3] = {1, 2, 1};
+  for (int t=0; t < 3; t++)
+    {
+    int maxZ = (t < 2 ? 7 : 1);
+    int wholeExt[6] = {0, 11, -2, 12, 1, maxZ};
+    vtkImageData *volume = MakeVolume(types[t], numComponents[t], maxZ);
+    serial->SetInput(volume);
+    serial->Update();
+    threaded->SetInput(volume);
+    threaded->UpdateWholeExtent();
+    if (CompareImages(serial->GetOutput(), threaded->GetOutput(),
+                      wholeExt) != 0)
+      {
+      cerr << volume->GetScalarTypeAsString()
+           << " transform depends on the number of threads" << endl;
+      rval++;
+      }
+    double maxDiff = CompareToDirectDFT(volume, serial->GetOutput());
+    if (maxDiff > 1e-8)
+      {
+      cerr << volume->GetScalarTypeAsString()
+           << " transform differs from the direct transform by "
+           << maxDiff << endl;
+      rval++;
+      }
+
+    // The reverse transform gives the volume back.
+    reverse->Update();
+    vtkImageData *output = reverse->GetOutput();
+    maxDiff = 0;
+    for (int k=wholeExt[4]; k <= wholeExt[5]; k++)
+      {
+      for (int j=wholeExt[2]; j <= wholeExt[3]; j++)
+        {
+        for (int i=wholeExt[0]; i <= wholeExt[1]; i++)
+          {
+          for (int c=0; c < 2; c++)
+            {
+            double value = (c < numComponents[t] ? Signal(i, j, k, c) : 0);
+            double diff = fabs(output->GetScalarComponentAsDouble(i, j, k, c)
+                               - value);
+            maxDiff = (diff > maxDiff ? diff : maxDiff);
+            }
+          }
+        }
+      }
+    if (maxDiff > 1e-10)
+      {
+      cerr << volume->GetScalarTypeAsString()
+           << " reverse transform differs from the volume by "
+           << maxDiff << endl;
+      rval++;
+      }
+
+    // A piece that starts and ends between paired rows is the same as
+    // the piece of the whole transform, up to rounding.
+    vtkImageData *whole = vtkImageData::New();
+    whole->DeepCopy(serial->GetOutput());
+    int pieceExt[6] = {2, 9, -1, 8, 3, 5};
+    if (maxZ == 1)
+      {
+      pieceExt[4] = pieceExt[5] = 1;
+      }
+    threaded->GetOutput()->SetUpdateExtent(pieceExt);
+    threaded->GetOutput()->Update();
+    maxDiff = CompareImages(threaded->GetOutput(), whole, pieceExt);
+    if (maxDiff > 1e-9)
+      {
+      cerr << volume->GetScalarTypeAsString()
+           << " piece differs from the whole transform by " << maxDiff
+           << endl;
+      rval++;
+      }
+    whole->Delete();
+    volume->Delete();
+    }
+
+  serial->Delete();
+  threaded->Delete();
+  reverse->Delete();
+  return rval;
+}
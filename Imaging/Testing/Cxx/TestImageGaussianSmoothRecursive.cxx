@@ -0,0 +1,257 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestImageGaussianSmoothRecursive.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Checks the recursive filter of vtkImageGaussianSmooth: it gives the same
+// output whatever the number of threads and the update extent, nearly the
+// same output as a wide kernel away from the borders, keeps constant
+// images constant, and differentiates ramps and parabolas.
+
+#include "vtkImageData.h"
+#include "vtkImageGaussianSmooth.h"
+#include "vtkPointData.h"
+
+#include <math.h>
+
+static vtkImageData *MakeImage(int scalarType, int numComponents)
+{
+  vtkImageData *image = vtkImageData::New();
+  image->SetExtent(-3, 58, 2, 53, 0, 47);
+  image->SetScalarType(scalarType);
+  image->SetNumberOfScalarComponents(numComponents);
+  image->AllocateScalars();
+  return image;
+}
+
+// Set the scalars from a function of the point indices.
+static void FillImage(vtkImageData *image, double (*func)(int, int, int, int))
+{
+  int ext[6];
+  image->GetExtent(ext);
+  vtkDataArray *scalars = image->GetPointData()->GetScalars();
+  vtkIdType ptId = 0;
+  for (int k=ext[4]; k <= ext[5]; k++)
+    {
+    for (int j=ext[2]; j <= ext[3]; j++)
+      {
+      for (int i=ext[0]; i <= ext[1]; i++)
+        {
+        for (int c=0; c < scalars->GetNumberOfComponents(); c++)
+          {
+          scalars->SetComponent(ptId, c, func(i, j, k, c));
+          }
+        ptId++;
+        }
+      }
+    }
+}
+
+static double Waves(int i, int j, int k, int c)
+{
+  return 100.0 + 60.0*sin(0.3*i + c)*cos(0.25*j) + 0.8*k*(c + 1);
+}
+
+static double Ramp(int i, int j, int k, int)
+{
+  return 2.0*i - 3.0*j + 0.5*k;
+}
+
+static double Parabola(int i, int, int, int)
+{
+  return 0.25*i*i;
+}
+
+static double Constant(int, int, int, int)
+{
+  return 255.0;
+}
+
+// Returns the largest difference between a and b over the extent ext,
+// which both contain.
+static double CompareImages(vtkImageData *a, vtkImageData *b, int ext[6])
+{
+  double maxDiff = 0;
+  int numComponents = a->GetNumberOfScalarComponents();
+  for (int k=ext[4]; k <= ext[5]; k++)
+    {
+    for (int j=ext[2]; j <= ext[3]; j++)
+      {
+      for (int i=ext[0]; i <= ext[1]; i++)
+        {
+        for (int c=0; c < numComponents; c++)
+          {
+          double diff = fabs(a->GetScalarComponentAsDouble(i, j, k, c) -
+                             b->GetScalarComponentAsDouble(i, j, k, c));
+          maxDiff = (diff > maxDiff ? diff : maxDiff);
+          }
+        }
+      }
+    }
+  return maxDiff;
+}
+
+// Returns the largest difference between the scalars of image over the
+// extent ext and the value.
+static double CompareToValue(vtkImageData *image, int ext[6], double value)
+{
+  double maxDiff = 0;
+  for (int k=ext[4]; k <= ext[5]; k++)
+    {
+    for (int j=ext[2]; j <= ext[3]; j++)
+      {
+      for (int i=ext[0]; i <= ext[1]; i++)
+        {
+        double diff = fabs(image->GetScalarComponentAsDouble(i, j, k, 0) -
+                           value);
+        maxDiff = (diff > maxDiff ? diff : maxDiff);
+        }
+      }
+    }
+  return maxDiff;
+}
+
+int TestImageGaussianSmoothRecursive(int, char *[])
+{
+  int rval = 0;
+  int wholeExt[6] = {-3, 58, 2, 53, 0, 47};
+
+  vtkImageGaussianSmooth *serial = vtkImageGaussianSmooth::New();
+  serial->UseRecursiveFilterOn();
+  serial->SetNumberOfThreads(1);
+  vtkImageGaussianSmooth *threaded = vtkImageGaussianSmooth::New();
+  threaded->UseRecursiveFilterOn();
+  threaded->SetNumberOfThreads(4);
+  vtkImageGaussianSmooth *kernel = vtkImageGaussianSmooth::New();
+  kernel->SetRadiusFactors(5.0, 5.0, 5.0);
+  vtkImageGaussianSmooth *filters[3] = {serial, threaded, kernel};
+
+  // The two filters agree within about 1% away from the borders, where
+  // the kernel is clipped instead of replicating the edge, and up to the
+  // truncation of integer values by the kernel after each axis.
+  int types[3] = {VTK_UNSIGNED_CHAR, VTK_SHORT, VTK_FLOAT};
+  for (int t=0; t < 3; t++)
+    {
+    vtkImageData *image = MakeImage(types[t], 1 + (t == 1));
+    FillImage(image, Waves);
+    for (int dim=1; dim <= 3; dim++)
+      {
+      for (int f=0; f < 3; f++)
+        {
+        filters[f]->SetInput(image);
+        filters[f]->SetDimensionality(dim);
+        filters[f]->SetStandardDeviations(3.0, 2.5, 2.0);
+        filters[f]->Update();
+        }
+      if (CompareImages(serial->GetOutput(), threaded->GetOutput(),
+                        wholeExt) != 0)
+        {
+        cerr << image->GetScalarTypeAsString() << " " << dim
+             << "D output depends on the number of threads" << endl;
+        rval++;
+        }
+      int interior[6] = {12, 43, 15, 40, 10, 37};
+      double maxDiff = CompareImages(serial->GetOutput(), kernel->GetOutput(),
+                                     interior);
+      if (maxDiff > dim + 1.0)
+        {
+        cerr << image->GetScalarTypeAsString() << " " << dim
+             << "D output differs from the kernel by " << maxDiff << endl;
+        rval++;
+        }
+      }
+
+    // A piece of the output is the same as the piece of the whole output.
+    vtkImageData *whole = vtkImageData::New();
+    whole->DeepCopy(serial->GetOutput());
+    int pieceExt[6] = {5, 30, 20, 53, 11, 12};
+    threaded->GetOutput()->SetUpdateExtent(pieceExt);
+    threaded->GetOutput()->Update();
+    if (CompareImages(threaded->GetOutput(), whole, pieceExt) != 0)
+      {
+      cerr << image->GetScalarTypeAsString()
+           << " piece differs from the whole output" << endl;
+      rval++;
+      }
+    whole->Delete();
+    threaded->GetOutput()->SetUpdateExtent(wholeExt);
+    image->Delete();
+    }
+
+  // Constant images stay constant up to the borders, even with deviations
+  // larger than the image.
+  vtkImageData *constant = MakeImage(VTK_UNSIGNED_CHAR, 1);
+  FillImage(constant, Constant);
+  threaded->SetInput(constant);
+  threaded->SetDimensionality(3);
+  threaded->SetStandardDeviations(40.0, 6.0, 0.3);
+  threaded->Update();
+  if (CompareToValue(threaded->GetOutput(), wholeExt, 255.0) != 0)
+    {
+    cerr << "Constant image is not constant" << endl;
+    rval++;
+    }
+  constant->Delete();
+
+  // Derivatives of a ramp along each axis, and second derivative of a
+  // parabola along x, far enough from the borders.
+  vtkImageData *ramp = MakeImage(VTK_FLOAT, 1);
+  FillImage(ramp, Ramp);
+  threaded->SetInput(ramp);
+  threaded->SetStandardDeviations(2.0, 2.0, 1.5);
+  int interior[6] = {25, 30, 25, 30, 20, 27};
+  double slopes[3] = {2.0, -3.0, 0.5};
+  for (int axis=0; axis < 3; axis++)
+    {
+    int orders[3] = {0, 0, 0};
+    orders[axis] = 1;
+    threaded->SetDerivativeOrders(orders);
+    threaded->Update();
+    double maxDiff = CompareToValue(threaded->GetOutput(), interior,
+                                    slopes[axis]);
+    if (maxDiff > 1e-3)
+      {
+      cerr << "Derivative along axis " << axis << " differs by "
+           << maxDiff << endl;
+      rval++;
+      }
+    }
+  ramp->Delete();
+
+  vtkImageData *parabola = MakeImage(VTK_DOUBLE, 1);
+  FillImage(parabola, Parabola);
+  threaded->SetInput(parabola);
+  threaded->SetDerivativeOrders(2, 0, 0);
+  threaded->Update();
+  double maxDiff = CompareToValue(threaded->GetOutput(), interior, 0.5);
+  if (maxDiff > 1e-3)
+    {
+    cerr << "Second derivative differs by " << maxDiff << endl;
+    rval++;
+    }
+  parabola->Delete();
+
+  // orders are clamped to 0..2 when set
+  threaded->SetDerivativeOrders(5, -1, 2);
+  int *orders = threaded->GetDerivativeOrders();
+  if (orders[0] != 2 || orders[1] != 0 || orders[2] != 2)
+    {
+    cerr << "Derivative orders (5, -1, 2) were set to (" << orders[0]
+         << ", " << orders[1] << ", " << orders[2] << ")" << endl;
+    rval++;
+    }
+
+  serial->Delete();
+  threaded->Delete();
+  kernel->Delete();
+  return rval;
+}
@@ -0,0 +1,155 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestImageMedian3DRank.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Checks that vtkImageMedian3D picks the right rank of the neighborhood,
+// clipped by the borders of the image, for odd and even kernels, with the
+// sliding histogram of integer values and with the sort of other values,
+// whatever the number of threads.
+
+#include "vtkImageData.h"
+#include "vtkImageMedian3D.h"
+#include "vtkPointData.h"
+
+#include <vtkstd/algorithm>
+#include <vtkstd/vector>
+
+#include <math.h>
+
+static vtkImageData *MakeImage(int scalarType, int numComponents,
+                               double scale, double offset)
+{
+  vtkImageData *image = vtkImageData::New();
+  image->SetExtent(-4, 19, 3, 18, 0, 11);
+  image->SetScalarType(scalarType);
+  image->SetNumberOfScalarComponents(numComponents);
+  image->AllocateScalars();
+  vtkDataArray *scalars = image->GetPointData()->GetScalars();
+  vtkIdType numValues = scalars->GetNumberOfTuples()*numComponents;
+  for (vtkIdType i=0; i < numValues; i++)
+    {
+    // a smooth pattern with noise
+    double noise = ((i*7919) % 101)/100.0 - 0.5;
+    double value = sin(0.05*i) + 0.8*noise;
+    scalars->SetComponent(i / numComponents, i % numComponents,
+                          floor(scale*value) + offset);
+    }
+  return image;
+}
+
+// Returns the number of output values that are not the given rank of
+// the clipped neighborhood of the input.
+static int CheckRank(vtkImageData *input, vtkImageData *output,
+                     int kernelSize[3], double rank)
+{
+  int ext[6];
+  input->GetExtent(ext);
+  int numComponents = input->GetNumberOfScalarComponents();
+  vtkstd::vector<double> hood;
+  int numErrors = 0;
+  for (int k=ext[4]; k <= ext[5]; k++)
+    {
+    for (int j=ext[2]; j <= ext[3]; j++)
+      {
+      for (int i=ext[0]; i <= ext[1]; i++)
+        {
+        int ijk[3] = {i, j, k};
+        int hoodExt[6];
+        for (int axis=0; axis < 3; axis++)
+          {
+          hoodExt[2*axis] = ijk[axis] - kernelSize[axis]/2;
+          hoodExt[2*axis+1] = hoodExt[2*axis] + kernelSize[axis] - 1;
+          hoodExt[2*axis] = vtkstd::max(hoodExt[2*axis], ext[2*axis]);
+          hoodExt[2*axis+1] = vtkstd::min(hoodExt[2*axis+1], ext[2*axis+1]);
+          }
+        for (int c=0; c < numComponents; c++)
+          {
+          hood.clear();
+          for (int hk=hoodExt[4]; hk <= hoodExt[5]; hk++)
+            {
+            for (int hj=hoodExt[2]; hj <= hoodExt[3]; hj++)
+              {
+              for (int hi=hoodExt[0]; hi <= hoodExt[1]; hi++)
+                {
+                hood.push_back(
+                  input->GetScalarComponentAsDouble(hi, hj, hk, c));
+                }
+              }
+            }
+          vtkstd::sort(hood.begin(), hood.end());
+          int n = static_cast<int>(hood.size());
+          double expected = hood[static_cast<int>(rank*(n - 1) + 0.5)];
+          if (output->GetScalarComponentAsDouble(i, j, k, c) != expected)
+            {
+            numErrors++;
+            }
+          }
+        }
+      }
+    }
+  return numErrors;
+}
+
+int TestImageMedian3DRank(int, char *[])
+{
+  int rval = 0;
+
+  // Integer types use the histogram, unless their range is too large.
+  int types[4] = {VTK_UNSIGNED_CHAR, VTK_SHORT, VTK_INT, VTK_FLOAT};
+  int numComponents[4] = {1, 2, 1, 1};
+  double scales[4] = {80.0, 20000.0, 100000.0, 10.0};
+  double offsets[4] = {127.0, 0.0, 0.0, 0.0};
+  int kernelSizes[3][3] = {{3, 3, 3}, {4, 1, 5}, {1, 6, 2}};
+  double ranks[4] = {0.5, 0.0, 1.0, 0.3};
+
+  vtkImageMedian3D *serial = vtkImageMedian3D::New();
+  serial->SetNumberOfThreads(1);
+  vtkImageMedian3D *threaded = vtkImageMedian3D::New();
+  threaded->SetNumberOfThreads(4);
+  threaded->SetDesiredBytesPerPiece(1024);
+  vtkImageMedian3D *filters[2] = {serial, threaded};
+  for (int t=0; t < 4; t++)
+    {
+    vtkImageData *image = MakeImage(types[t], numComponents[t], scales[t],
+                                    offsets[t]);
+    for (int k=0; k < 3; k++)
+      {
+      for (int r=0; r < 4; r++)
+        {
+        for (int f=0; f < 2; f++)
+          {
+          int *size = kernelSizes[k];
+          filters[f]->SetInput(image);
+          filters[f]->SetKernelSize(size[0], size[1], size[2]);
+          filters[f]->SetRank(ranks[r]);
+          filters[f]->Update();
+          int numErrors = CheckRank(image, filters[f]->GetOutput(), size,
+                                    ranks[r]);
+          if (numErrors)
+            {
+            cerr << image->GetScalarTypeAsString() << " kernel " << size[0]
+                 << "x" << size[1] << "x" << size[2] << " rank " << ranks[r]
+                 << " with " << filters[f]->GetNumberOfThreads()
+                 << " threads: " << numErrors << " wrong values" << endl;
+            rval++;
+            }
+          }
+        }
+      }
+    image->Delete();
+    }
+
+  serial->Delete();
+  threaded->Delete();
+  return rval;
+}
@@ -0,0 +1,409 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestImageStencilDataOperations.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Checks the operations of vtkImageStencilData against masks of voxels,
+// and checks that vtkImplicitFunctionToImageStencil and
+// vtkImageToImageStencil give the same stencils whatever the number of
+// threads, when only a part of the stencil is requested, and for scalars
+// of bits.
+
+#include "vtkBitArray.h"
+#include "vtkImageData.h"
+#include "vtkImageStencilData.h"
+#include "vtkImageToImageStencil.h"
+#include "vtkImplicitFunctionToImageStencil.h"
+#include "vtkPointData.h"
+#include "vtkShortArray.h"
+#include "vtkSphere.h"
+
+#include <vtkstd/vector>
+
+// All the stencils are within this box.
+static const int Box[6] = { -6, 45, -3, 22, -2, 7 };
+
+// A mask of the voxels of the box.
+class StencilMask
+{
+public:
+  StencilMask() : Voxels((Box[1] - Box[0] + 1)*(Box[3] - Box[2] + 1)*
+                         (Box[5] - Box[4] + 1), 0) {};
+
+  char &operator()(int x, int y, int z)
+    {
+    return this->Voxels[((z - Box[4])*(Box[3] - Box[2] + 1) +
+                         (y - Box[2]))*(Box[1] - Box[0] + 1) + (x - Box[0])];
+    }
+
+  vtkstd::vector<char> Voxels;
+};
+
+// Make the mask of a stencil, and check that its extents are sorted and
+// separated.
+static int MaskFromStencil(vtkImageStencilData *stencil, StencilMask &mask)
+{
+  int extent[6];
+  stencil->GetExtent(extent);
+  int rval = 0;
+  for (int z = extent[4]; z <= extent[5]; z++)
+    {
+    for (int y = extent[2]; y <= extent[3]; y++)
+      {
+      int iter = 0, r1, r2, last = extent[0] - 2;
+      while (stencil->GetNextExtent(r1, r2, extent[0], extent[1],
+                                    y, z, iter))
+        {
+        if (r1 > r2)
+          {
+          continue;
+          }
+        if (r1 <= last + 1)
+          {
+          rval = 1;
+          }
+        for (int x = r1; x <= r2; x++)
+          {
+          mask(x, y, z) = 1;
+          }
+        last = r2;
+        }
+      }
+    }
+  return rval;
+}
+
+// Count the voxels that differ between a stencil and a mask.
+static int CompareStencil(vtkImageStencilData *stencil, StencilMask &mask,
+                          const char *name)
+{
+  StencilMask stencilMask;
+  int unsorted = MaskFromStencil(stencil, stencilMask);
+  int numErrors = 0;
+  for (size_t i = 0; i < mask.Voxels.size(); i++)
+    {
+    numErrors += (mask.Voxels[i] != stencilMask.Voxels[i]);
+    }
+  if (numErrors || unsorted)
+    {
+    cerr << name << ": " << numErrors << " voxels differ from the mask"
+         << (unsorted ? ", and the extents are not separated" : "") << endl;
+    return 1;
+    }
+  return 0;
+}
+
+// Make a random stencil by adding and removing runs of voxels, some of
+// them across the extent of the stencil, along with its mask.
+static vtkImageStencilData *MakeStencil(const int extent[6], int seed,
+                                        StencilMask &mask)
+{
+  vtkImageStencilData *stencil = vtkImageStencilData::New();
+  stencil->SetExtent(const_cast<int *>(extent));
+  stencil->AllocateExtents();
+  unsigned int state = seed;
+  for (int z = extent[4]; z <= extent[5]; z++)
+    {
+    for (int y = extent[2]; y <= extent[3]; y++)
+      {
+      int numRuns = (y % 7 == 0 ? 40 : 6);
+      for (int i = 0; i < numRuns; i++)
+        {
+        state = state*1103515245 + 12345;
+        int r1 = extent[0] + (state >> 8) % (extent[1] - extent[0] + 1);
+        int r2 = r1 + (state >> 20) % 9;
+        r2 = (r2 < extent[1] ? r2 : extent[1]);
+        int remove = ((state >> 4) % 3 == 0);
+        if (remove)
+          {
+          r1 -= 2;
+          stencil->RemoveExtent(r1, r2, y, z);
+          }
+        else
+          {
+          stencil->InsertAndMergeExtent(r1, r2, y, z);
+          }
+        for (int x = (r1 > extent[0] ? r1 : extent[0]); x <= r2; x++)
+          {
+          mask(x, y, z) = !remove;
+          }
+        }
+      }
+    }
+  return stencil;
+}
+
+int TestImageStencilDataOperations(int, char *[])
+{
+  int rval = 0;
+  int extentA[6] = { 0, 30, 0, 15, 0, 4 };
+  int extentB[6] = { 10, 45, -3, 8, 2, 7 };
+  int extentC[6] = { 5, 20, 3, 10, 1, 3 };
+
+  StencilMask maskA, maskB, maskC;
+  vtkImageStencilData *stencilA = MakeStencil(extentA, 1, maskA);
+  vtkImageStencilData *stencilB = MakeStencil(extentB, 2, maskB);
+  vtkImageStencilData *stencilC = MakeStencil(extentC, 3, maskC);
+  rval += CompareStencil(stencilA, maskA, "InsertAndMergeExtent");
+  rval += CompareStencil(stencilB, maskB, "RemoveExtent");
+
+  vtkImageStencilData *stencil = vtkImageStencilData::New();
+  stencil->DeepCopy(stencilA);
+  rval += CompareStencil(stencil, maskA, "DeepCopy");
+
+  // Add within the extent, and outside of it.
+  StencilMask mask = maskA;
+  for (size_t i = 0; i < mask.Voxels.size(); i++)
+    {
+    mask.Voxels[i] |= maskC.Voxels[i];
+    }
+  stencil->Add(stencilC);
+  rval += CompareStencil(stencil, mask, "Add within the extent");
+  for (size_t i = 0; i < mask.Voxels.size(); i++)
+    {
+    mask.Voxels[i] |= maskB.Voxels[i];
+    }
+  stencil->Add(stencilB);
+  rval += CompareStencil(stencil, mask, "Add outside of the extent");
+  int *extent = stencil->GetExtent();
+  if (extent[0] != 0 || extent[1] != 45 || extent[2] != -3 ||
+      extent[3] != 15 || extent[4] != 0 || extent[5] != 7)
+    {
+    cerr << "Add: the extent does not hold both stencils" << endl;
+    rval++;
+    }
+
+  // Subtract, and replace.
+  stencil->DeepCopy(stencilA);
+  for (size_t i = 0; i < mask.Voxels.size(); i++)
+    {
+    mask.Voxels[i] = (maskA.Voxels[i] && !maskB.Voxels[i]);
+    }
+  stencil->Subtract(stencilB);
+  rval += CompareStencil(stencil, mask, "Subtract");
+
+  stencil->DeepCopy(stencilA);
+  mask = maskA;
+  for (int z = extentB[4]; z <= extentA[5]; z++)
+    {
+    for (int y = extentA[2]; y <= extentB[3]; y++)
+      {
+      for (int x = extentB[0]; x <= extentA[1]; x++)
+        {
+        mask(x, y, z) = maskB(x, y, z);
+        }
+      }
+    }
+  stencil->Replace(stencilB);
+  rval += CompareStencil(stencil, mask, "Replace");
+
+  // Clip, which must tell whether something was removed.
+  stencil->DeepCopy(stencilA);
+  int clipExtent[6] = { 4, 25, 2, 40, -5, 3 };
+  mask = maskA;
+  for (int z = extentA[4]; z <= extentA[5]; z++)
+    {
+    for (int y = extentA[2]; y <= extentA[3]; y++)
+      {
+      for (int x = extentA[0]; x <= extentA[1]; x++)
+        {
+        mask(x, y, z) &= (x >= clipExtent[0] && x <= clipExtent[1] &&
+                          y >= clipExtent[2] && y <= clipExtent[3] &&
+                          z >= clipExtent[4] && z <= clipExtent[5]);
+        }
+      }
+    }
+  if (!stencil->Clip(clipExtent) || stencil->Clip(clipExtent))
+    {
+    cerr << "Clip: wrong report of the removal of extents" << endl;
+    rval++;
+    }
+  rval += CompareStencil(stencil, mask, "Clip");
+  clipExtent[0] = 6;
+  for (int z = extentA[4]; z <= extentA[5]; z++)
+    {
+    for (int y = extentA[2]; y <= extentA[3]; y++)
+      {
+      mask(4, y, z) = mask(5, y, z) = 0;
+      }
+    }
+  if (!stencil->Clip(clipExtent))
+    {
+    cerr << "Clip: the removal of extents along x was not reported" << endl;
+    rval++;
+    }
+  rval += CompareStencil(stencil, mask, "Clip along x");
+
+  // Extents that continue the previous one are merged with it.
+  stencil->SetExtent(extentA);
+  stencil->AllocateExtents();
+  mask.Voxels.assign(mask.Voxels.size(), 0);
+  for (int x = 0; x < 30; x += 3)
+    {
+    stencil->InsertNextExtent(x, x + 1, 5, 2);
+    stencil->InsertNextExtent(x + 2, x + 2, 5, 2);
+    mask(x, 5, 2) = mask(x + 1, 5, 2) = mask(x + 2, 5, 2) = 1;
+    }
+  rval += CompareStencil(stencil, mask, "InsertNextExtent");
+  int iter = 0, r1, r2;
+  stencil->GetNextExtent(r1, r2, 0, 30, 5, 2, iter);
+  if (r1 != 0 || r2 != 29)
+    {
+    cerr << "InsertNextExtent: adjacent extents were not merged" << endl;
+    rval++;
+    }
+
+  stencil->Delete();
+  stencilA->Delete();
+  stencilB->Delete();
+  stencilC->Delete();
+
+  // A sphere, evaluated by one or several threads, then in part.
+  int wholeExtent[6] = { -6, 40, -3, 22, -2, 7 };
+  vtkSphere *sphere = vtkSphere::New();
+  sphere->SetCenter(12.3, 8.7, 2.2);
+  sphere->SetRadius(9.5);
+  mask.Voxels.assign(mask.Voxels.size(), 0);
+  for (int z = wholeExtent[4]; z <= wholeExtent[5]; z++)
+    {
+    for (int y = wholeExtent[2]; y <= wholeExtent[3]; y++)
+      {
+      for (int x = wholeExtent[0]; x <= wholeExtent[1]; x++)
+        {
+        double point[3];
+        point[0] = x*0.5 + 1.0;
+        point[1] = y*1.0;
+        point[2] = z*2.0 - 1.0;
+        mask(x, y, z) = (sphere->FunctionValue(point) < 0);
+        }
+      }
+    }
+  int subExtent[6] = { 2, 18, 0, 22, 1, 5 };
+  StencilMask subMask;
+  for (int z = subExtent[4]; z <= subExtent[5]; z++)
+    {
+    for (int y = subExtent[2]; y <= subExtent[3]; y++)
+      {
+      for (int x = subExtent[0]; x <= subExtent[1]; x++)
+        {
+        subMask(x, y, z) = mask(x, y, z);
+        }
+      }
+    }
+  for (int threads = 1; threads <= 4; threads += 3)
+    {
+    for (int part = 0; part < 2; part++)
+      {
+      vtkImplicitFunctionToImageStencil *functionToStencil =
+        vtkImplicitFunctionToImageStencil::New();
+      functionToStencil->SetInput(sphere);
+      functionToStencil->SetOutputOrigin(1.0, 0.0, -1.0);
+      functionToStencil->SetOutputSpacing(0.5, 1.0, 2.0);
+      functionToStencil->SetOutputWholeExtent(wholeExtent);
+      functionToStencil->SetNumberOfThreads(threads);
+      if (part)
+        {
+        functionToStencil->GetOutput()->SetUpdateExtent(subExtent);
+        }
+      functionToStencil->Update();
+      rval += CompareStencil(functionToStencil->GetOutput(),
+                             (part ? subMask : mask),
+                             (part ? "Sphere within an extent" :
+                              threads == 1 ? "Sphere with one thread" :
+                              "Sphere with several threads"));
+      functionToStencil->Delete();
+      }
+    }
+  sphere->Delete();
+
+  // An image of two components, thresholded by its first one.
+  vtkImageData *image = vtkImageData::New();
+  image->SetExtent(wholeExtent);
+  vtkShortArray *scalars = vtkShortArray::New();
+  scalars->SetNumberOfComponents(2);
+  mask.Voxels.assign(mask.Voxels.size(), 0);
+  for (int z = wholeExtent[4]; z <= wholeExtent[5]; z++)
+    {
+    for (int y = wholeExtent[2]; y <= wholeExtent[3]; y++)
+      {
+      for (int x = wholeExtent[0]; x <= wholeExtent[1]; x++)
+        {
+        short value = static_cast<short>((x*x + 3*y*z + 7*x*y) % 101);
+        scalars->InsertNextValue(value);
+        scalars->InsertNextValue(50);
+        mask(x, y, z) = (value >= 20 && value <= 60);
+        subMask(x, y, z) = 0;
+        if (x >= subExtent[0] && x <= subExtent[1] &&
+            y >= subExtent[2] && y <= subExtent[3] &&
+            z >= subExtent[4] && z <= subExtent[5])
+          {
+          subMask(x, y, z) = mask(x, y, z);
+          }
+        }
+      }
+    }
+  image->GetPointData()->SetScalars(scalars);
+  scalars->Delete();
+  for (int threads = 1; threads <= 3; threads += 2)
+    {
+    for (int part = 0; part < 2; part++)
+      {
+      vtkImageToImageStencil *imageToStencil = vtkImageToImageStencil::New();
+      imageToStencil->SetInput(image);
+      imageToStencil->ThresholdBetween(20, 60);
+      imageToStencil->SetNumberOfThreads(threads);
+      if (part)
+        {
+        imageToStencil->GetOutput()->SetUpdateExtent(subExtent);
+        }
+      imageToStencil->Update();
+      rval += CompareStencil(imageToStencil->GetOutput(),
+                             (part ? subMask : mask),
+                             (part ? "Threshold within an extent" :
+                              threads == 1 ? "Threshold with one thread" :
+                              "Threshold with several threads"));
+      extent = imageToStencil->GetOutput()->GetExtent();
+      if (part && (extent[0] != subExtent[0] || extent[1] != subExtent[1] ||
+                   extent[4] != subExtent[4] || extent[5] != subExtent[5]))
+        {
+        cerr << "Threshold: the stencil is not limited to the update extent"
+             << endl;
+        rval++;
+        }
+      imageToStencil->Delete();
+      }
+    }
+
+  // The same threshold, as bits, which are read through the array.
+  vtkBitArray *bits = vtkBitArray::New();
+  bits->SetNumberOfComponents(2);
+  for (vtkIdType i = 0; i < image->GetNumberOfPoints(); i++)
+    {
+    short value = static_cast<short>(image->GetPointData()->GetScalars()->
+                                     GetComponent(i, 0));
+    bits->InsertNextValue(value >= 20 && value <= 60);
+    bits->InsertNextValue(0);
+    }
+  image->GetPointData()->SetScalars(bits);
+  bits->Delete();
+  vtkImageToImageStencil *bitsToStencil = vtkImageToImageStencil::New();
+  bitsToStencil->SetInput(image);
+  bitsToStencil->ThresholdByUpper(1);
+  bitsToStencil->SetNumberOfThreads(2);
+  bitsToStencil->Update();
+  rval += CompareStencil(bitsToStencil->GetOutput(), mask,
+                         "Threshold of bits");
+  bitsToStencil->Delete();
+  image->Delete();
+
+  return rval;
+}
@@ -0,0 +1,297 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestSplattersThreaded.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Checks that vtkGaussianSplatter and vtkShepardMethod give the same
+// volumes whatever the number of threads, for every kernel and
+// accumulation mode, and checks splats and global Shepard interpolation
+// against a direct evaluation at each voxel.
+
+#include "vtkFloatArray.h"
+#include "vtkGaussianSplatter.h"
+#include "vtkImageData.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+#include "vtkShepardMethod.h"
+
+#include <math.h>
+
+// The points are denser near one corner, and some of them have no normal.
+static vtkPolyData *MakePoints(vtkIdType numPts)
+{
+  vtkPoints *points = vtkPoints::New();
+  vtkFloatArray *normals = vtkFloatArray::New();
+  normals->SetNumberOfComponents(3);
+  vtkFloatArray *scalars = vtkFloatArray::New();
+  for (vtkIdType ptId=0; ptId < numPts; ptId++)
+    {
+    double u = ((ptId*7919) % 1009)/1009.0;
+    double v = ((ptId*104729) % 1013)/1013.0;
+    double w = ((ptId*1299709) % 1019)/1019.0;
+    points->InsertNextPoint(u*u, v, 0.2 + 0.8*w*w);
+    double n[3] = {v - 0.5, w - 0.5, 2*u};
+    if (ptId % 11 == 0)
+      {
+      n[0] = n[1] = n[2] = 0.0;
+      }
+    normals->InsertNextTuple(n);
+    scalars->InsertNextValue(1.0 + sin(10*u) + v);
+    }
+  vtkPolyData *data = vtkPolyData::New();
+  data->SetPoints(points);
+  data->GetPointData()->SetNormals(normals);
+  data->GetPointData()->SetScalars(scalars);
+  points->Delete();
+  normals->Delete();
+  scalars->Delete();
+  return data;
+}
+
+// Returns the number of voxels that differ between a and b by more than
+// tol times the largest absolute value.
+static int CompareScalars(vtkImageData *a, vtkImageData *b, double tol)
+{
+  vtkDataArray *da = a->GetPointData()->GetScalars();
+  vtkDataArray *db = b->GetPointData()->GetScalars();
+  if (da->GetNumberOfTuples() != db->GetNumberOfTuples())
+    {
+    return 1;
+    }
+  double scale = 0;
+  vtkIdType ptId;
+  for (ptId=0; ptId < da->GetNumberOfTuples(); ptId++)
+    {
+    double value = fabs(da->GetComponent(ptId, 0));
+    scale = (value > scale ? value : scale);
+    }
+  int numErrors = 0;
+  for (ptId=0; ptId < da->GetNumberOfTuples(); ptId++)
+    {
+    numErrors += (fabs(da->GetComponent(ptId, 0) -
+                       db->GetComponent(ptId, 0)) > tol*scale);
+    }
+  return numErrors;
+}
+
+// Evaluate splats at each voxel, combined in the order of the points,
+// without capping.  The elliptical splats must fit in spherical ones, with
+// an eccentricity below 1.
+static vtkImageData *SplatDirectly(vtkPolyData *data,
+                                   vtkGaussianSplatter *splatter)
+{
+  vtkImageData *image = vtkImageData::New();
+  image->DeepCopy(splatter->GetOutput());
+  vtkDataArray *scalars = data->GetPointData()->GetScalars();
+  vtkDataArray *normals = (splatter->GetNormalWarping() ?
+                           data->GetPointData()->GetNormals() : 0);
+  double e2 = splatter->GetEccentricity()*splatter->GetEccentricity();
+  vtkDataArray *values = image->GetPointData()->GetScalars();
+  double *bounds = splatter->GetModelBounds();
+  double radius = splatter->GetRadius()*(bounds[1] - bounds[0]);
+  double radius2 = radius*radius;
+  for (vtkIdType voxel=0; voxel < image->GetNumberOfPoints(); voxel++)
+    {
+    double x[3], p[3];
+    image->GetPoint(voxel, x);
+    int visited = 0;
+    double value = splatter->GetNullValue();
+    for (vtkIdType ptId=0; ptId < data->GetNumberOfPoints(); ptId++)
+      {
+      data->GetPoint(ptId, p);
+      double dist2 = ((x[0] - p[0])*(x[0] - p[0]) +
+                      (x[1] - p[1])*(x[1] - p[1]) +
+                      (x[2] - p[2])*(x[2] - p[2]));
+      if (normals)
+        {
+        // a null normal flattens the splat in every direction
+        double n[3];
+        normals->GetTuple(ptId, n);
+        double mag = sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+        double z = ((x[0] - p[0])*n[0] + (x[1] - p[1])*n[1] +
+                    (x[2] - p[2])*n[2])/(mag == 0 ? 1.0 : mag);
+        dist2 = (dist2 - z*z)/e2 + z*z;
+        }
+      if (dist2 > radius2)
+        {
+        continue;
+        }
+      double s = splatter->GetScaleFactor()*
+        (splatter->GetScalarWarping() ? scalars->GetComponent(ptId, 0) : 1.0)*
+        exp(splatter->GetExponentFactor()*dist2/radius2);
+      if (!visited++)
+        {
+        value = s;
+        }
+      else if (splatter->GetAccumulationMode() == VTK_ACCUMULATION_MODE_MIN)
+        {
+        value = (s < value ? s : value);
+        }
+      else if (splatter->GetAccumulationMode() == VTK_ACCUMULATION_MODE_MAX)
+        {
+        value = (s > value ? s : value);
+        }
+      else
+        {
+        value += s;
+        }
+      }
+    values->SetComponent(voxel, 0, value);
+    }
+  return image;
+}
+
+// Interpolate all the points at each voxel by inverse squared distances.
+static vtkImageData *InterpolateDirectly(vtkPolyData *data,
+                                         vtkShepardMethod *shepard)
+{
+  vtkImageData *image = vtkImageData::New();
+  image->DeepCopy(shepard->GetOutput());
+  vtkDataArray *scalars = data->GetPointData()->GetScalars();
+  vtkDataArray *values = image->GetPointData()->GetScalars();
+  for (vtkIdType voxel=0; voxel < image->GetNumberOfPoints(); voxel++)
+    {
+    double x[3], p[3];
+    image->GetPoint(voxel, x);
+    double sum = 0, weights = 0;
+    for (vtkIdType ptId=0; ptId < data->GetNumberOfPoints(); ptId++)
+      {
+      data->GetPoint(ptId, p);
+      double dist2 = ((x[0] - p[0])*(x[0] - p[0]) +
+                      (x[1] - p[1])*(x[1] - p[1]) +
+                      (x[2] - p[2])*(x[2] - p[2]));
+      sum += scalars->GetComponent(ptId, 0)/dist2;
+      weights += 1.0/dist2;
+      }
+    values->SetComponent(voxel, 0, sum/weights);
+    }
+  return image;
+}
+
+int TestSplattersThreaded(int, char *[])
+{
+  int rval = 0;
+  vtkPolyData *data = MakePoints(400);
+  int threads[3] = {1, 3, 4};
+  const char *modes[3] = {"min", "max", "sum"};
+
+  // Gaussian splats, elliptical or not, scaled by the scalars or not.
+  vtkGaussianSplatter *splatters[3];
+  for (int t=0; t < 3; t++)
+    {
+    splatters[t] = vtkGaussianSplatter::New();
+    splatters[t]->SetInput(data);
+    splatters[t]->SetSampleDimensions(23, 19, 31);
+    splatters[t]->SetRadius(0.15);
+    splatters[t]->SetNullValue(-1.0);
+    splatters[t]->SetNumberOfThreads(threads[t]);
+    }
+  for (int mode=0; mode < 3; mode++)
+    {
+    for (int warp=0; warp < 4; warp++)
+      {
+      for (int t=0; t < 3; t++)
+        {
+        // the bounds computed from the input are kept, so reset them
+        splatters[t]->SetModelBounds(0.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+        splatters[t]->SetAccumulationMode(mode);
+        splatters[t]->SetNormalWarping(warp & 1);
+        splatters[t]->SetEccentricity(2.5);
+        splatters[t]->SetScaleFactor(1.0);
+        splatters[t]->SetScalarWarping(warp >> 1);
+        splatters[t]->SetCapping(warp == 3);
+        splatters[t]->Update();
+        }
+      for (int t=1; t < 3; t++)
+        {
+        int numErrors = CompareScalars(splatters[0]->GetOutput(),
+                                       splatters[t]->GetOutput(), 0.0);
+        if (numErrors)
+          {
+          cerr << "Gaussian splats, " << modes[mode] << " mode, warping "
+               << warp << ", with " << threads[t] << " threads: "
+               << numErrors << " voxels differ from one thread" << endl;
+          rval++;
+          }
+        }
+      }
+
+    // Spherical or flattened splats, scaled or not, within fixed bounds.
+    vtkGaussianSplatter *splatter = splatters[2];
+    splatter->SetModelBounds(0.0, 1.0, 0.0, 1.0, 0.0, 1.0);
+    splatter->SetNormalWarping(mode > 0);
+    splatter->SetEccentricity(0.5);
+    splatter->SetScalarWarping(mode != 1);
+    splatter->SetScaleFactor(1.5);
+    splatter->CappingOff();
+    splatter->Update();
+    vtkImageData *image = SplatDirectly(data, splatter);
+    int numErrors = CompareScalars(image, splatter->GetOutput(), 1e-12);
+    if (numErrors)
+      {
+      cerr << (mode > 0 ? "Elliptical" : "Spherical") << " splats, "
+           << modes[mode] << " mode: " << numErrors
+           << " voxels differ from a direct evaluation" << endl;
+      rval++;
+      }
+    image->Delete();
+    }
+  for (int t=0; t < 3; t++)
+    {
+    splatters[t]->Delete();
+    }
+
+  // Shepard's method, within a distance or from all points.
+  vtkShepardMethod *shepards[3];
+  for (int t=0; t < 3; t++)
+    {
+    shepards[t] = vtkShepardMethod::New();
+    shepards[t]->SetInput(data);
+    shepards[t]->SetSampleDimensions(17, 21, 26);
+    shepards[t]->SetMaximumDistance(0.1);
+    shepards[t]->SetNullValue(-1.0);
+    shepards[t]->SetNumberOfThreads(threads[t]);
+    shepards[t]->Update();
+    }
+  for (int t=1; t < 3; t++)
+    {
+    int numErrors = CompareScalars(shepards[0]->GetOutput(),
+                                   shepards[t]->GetOutput(), 0.0);
+    if (numErrors)
+      {
+      cerr << "Shepard's method with " << threads[t] << " threads: "
+           << numErrors << " voxels differ from one thread" << endl;
+      rval++;
+      }
+    }
+  vtkShepardMethod *shepard = shepards[2];
+  shepard->SetModelBounds(0.0, 1.0, 0.0, 1.0, 0.0, 1.0);
+  shepard->SetMaximumDistance(1.0);
+  shepard->Update();
+  vtkImageData *image = InterpolateDirectly(data, shepard);
+  int numErrors = CompareScalars(image, shepard->GetOutput(), 1e-5);
+  if (numErrors)
+    {
+    cerr << "Shepard's method: " << numErrors
+         << " voxels differ from a direct interpolation" << endl;
+    rval++;
+    }
+  image->Delete();
+  for (int t=0; t < 3; t++)
+    {
+    shepards[t]->Delete();
+    }
+
+  data->Delete();
+  return rval;
+}
@@ -0,0 +1,264 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestThreadedImageSplitModes.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Checks that the slab, beam and block split modes of
+// vtkThreadedImageAlgorithm process every output point exactly once, that
+// beams and blocks outnumber the threads, and that vtkImageGaussianSmooth,
+// vtkImageConvolve and vtkImageReslice give the same output in every mode
+// and report a progress that never goes back.
+
+#include "vtkCommand.h"
+#include "vtkCriticalSection.h"
+#include "vtkImageConvolve.h"
+#include "vtkImageData.h"
+#include "vtkImageGaussianSmooth.h"
+#include "vtkImageReslice.h"
+#include "vtkObjectFactory.h"
+#include "vtkPointData.h"
+#include "vtkThreadedImageAlgorithm.h"
+
+#include <vtkstd/vector>
+
+#include <math.h>
+
+// Counts how many times each output point is processed.
+class vtkSplitCounter : public vtkThreadedImageAlgorithm
+{
+public:
+  static vtkSplitCounter *New();
+  vtkTypeMacro(vtkSplitCounter,vtkThreadedImageAlgorithm);
+
+  vtkstd::vector<int> Counts;
+  int NumberOfPieces;
+
+protected:
+  vtkSplitCounter() {}
+
+  virtual int RequestData(vtkInformation *request,
+                          vtkInformationVector **inputVector,
+                          vtkInformationVector *outputVector)
+    {
+    vtkImageData *input = vtkImageData::SafeDownCast(this->GetInput());
+    this->Counts.assign(input->GetNumberOfPoints(), 0);
+    this->NumberOfPieces = 0;
+    return this->Superclass::RequestData(request, inputVector, outputVector);
+    }
+
+  virtual void ThreadedExecute(vtkImageData *inData, vtkImageData *,
+                               int ext[6], int)
+    {
+    for (int k=ext[4]; k <= ext[5]; k++)
+      {
+      for (int j=ext[2]; j <= ext[3]; j++)
+        {
+        for (int i=ext[0]; i <= ext[1]; i++)
+          {
+          int ijk[3] = {i, j, k};
+          this->Counts[inData->ComputePointId(ijk)]++;
+          }
+        }
+      }
+    this->Lock.Lock();
+    this->NumberOfPieces++;
+    this->Lock.Unlock();
+    }
+
+  vtkSimpleCriticalSection Lock;
+};
+
+vtkStandardNewMacro(vtkSplitCounter);
+
+// Records whether the progress of a filter ever decreases.
+class vtkProgressChecker : public vtkCommand
+{
+public:
+  static vtkProgressChecker *New() { return new vtkProgressChecker; }
+
+  virtual void Execute(vtkObject *, unsigned long, void *callData)
+    {
+    double progress = *static_cast<double *>(callData);
+    if (progress < this->Progress)
+      {
+      this->Decreased = 1;
+      }
+    this->Progress = progress;
+    }
+
+  void Reset()
+    {
+    this->Progress = 0.0;
+    this->Decreased = 0;
+    }
+
+  double Progress;
+  int Decreased;
+
+protected:
+  vtkProgressChecker() { this->Reset(); }
+};
+
+static vtkImageData *MakeImage(int nx, int ny, int nz)
+{
+  vtkImageData *image = vtkImageData::New();
+  image->SetExtent(0, nx-1, 0, ny-1, 0, nz-1);
+  image->SetScalarTypeToFloat();
+  image->SetNumberOfScalarComponents(1);
+  image->AllocateScalars();
+  float *s = static_cast<float *>(image->GetScalarPointer());
+  for (int k=0; k < nz; k++)
+    {
+    for (int j=0; j < ny; j++)
+      {
+      for (int i=0; i < nx; i++)
+        {
+        *s++ = static_cast<float>(sin(0.3*i)*cos(0.2*j) + 0.05*k);
+        }
+      }
+    }
+  return image;
+}
+
+static int CompareImages(vtkImageData *a, vtkImageData *b, const char *name)
+{
+  vtkDataArray *da = a->GetPointData()->GetScalars();
+  vtkDataArray *db = b->GetPointData()->GetScalars();
+  if (da->GetNumberOfTuples() != db->GetNumberOfTuples() ||
+      da->GetNumberOfComponents() != db->GetNumberOfComponents())
+    {
+    cerr << name << ": output sizes differ" << endl;
+    return 1;
+    }
+  for (vtkIdType t=0; t < da->GetNumberOfTuples(); t++)
+    {
+    for (int c=0; c < da->GetNumberOfComponents(); c++)
+      {
+      if (da->GetComponent(t, c) != db->GetComponent(t, c))
+        {
+        cerr << name << ": outputs differ at point " << t << endl;
+        return 1;
+        }
+      }
+    }
+  return 0;
+}
+
+int TestThreadedImageSplitModes(int, char *[])
+{
+  int rval = 0;
+
+  // a volume, and a 2D image with few rows
+  vtkImageData *volume = MakeImage(61, 47, 33);
+  vtkImageData *flat = MakeImage(1500, 3, 1);
+  vtkImageData *images[2] = {volume, flat};
+
+  vtkSplitCounter *counter = vtkSplitCounter::New();
+  counter->SetDesiredBytesPerPiece(4096);
+  for (int image=0; image < 2; image++)
+    {
+    counter->SetInput(images[image]);
+    for (int mode=VTK_IMAGE_SPLIT_SLAB; mode <= VTK_IMAGE_SPLIT_BLOCK; mode++)
+      {
+      for (int threads=1; threads <= 8; threads += 3)
+        {
+        counter->SetSplitMode(mode);
+        counter->SetNumberOfThreads(threads);
+        counter->Modified();
+        counter->Update();
+        for (size_t i=0; i < counter->Counts.size(); i++)
+          {
+          if (counter->Counts[i] != 1)
+            {
+            cerr << counter->GetSplitModeAsString() << " mode with "
+                 << threads << " threads processes point " << i << " "
+                 << counter->Counts[i] << " times" << endl;
+            rval++;
+            break;
+            }
+          }
+        // beams of the flat image are limited by its rows
+        int minPieces = 1;
+        if (mode != VTK_IMAGE_SPLIT_SLAB)
+          {
+          minPieces = (image == 0 ? threads + 1 : 3);
+          }
+        if (counter->NumberOfPieces < minPieces ||
+            (mode == VTK_IMAGE_SPLIT_SLAB && counter->NumberOfPieces > threads))
+          {
+          cerr << counter->GetSplitModeAsString() << " mode with "
+               << threads << " threads makes " << counter->NumberOfPieces
+               << " pieces" << endl;
+          rval++;
+          }
+        }
+      }
+    }
+  counter->Delete();
+
+  // The filters give the same output as a single slab in their default
+  // split modes.
+  vtkImageGaussianSmooth *smooth = vtkImageGaussianSmooth::New();
+  smooth->SetStandardDeviations(2.0, 1.5, 1.0);
+  vtkImageConvolve *convolve = vtkImageConvolve::New();
+  double kernel[27];
+  for (int i=0; i < 27; i++)
+    {
+    kernel[i] = 1.0/(1 + (i % 5));
+    }
+  convolve->SetKernel3x3x3(kernel);
+  vtkImageReslice *reslice = vtkImageReslice::New();
+  reslice->SetResliceAxesDirectionCosines(0.8, 0.6, 0.0, -0.6, 0.8, 0.0,
+                                          0.0, 0.0, 1.0);
+  reslice->SetInterpolationModeToLinear();
+  vtkThreadedImageAlgorithm *filters[3] = {smooth, convolve, reslice};
+  const char *names[3] = {"vtkImageGaussianSmooth", "vtkImageConvolve",
+                          "vtkImageReslice"};
+  int modes[3] = {VTK_IMAGE_SPLIT_BLOCK, VTK_IMAGE_SPLIT_BLOCK,
+                  VTK_IMAGE_SPLIT_BEAM};
+  vtkProgressChecker *checker = vtkProgressChecker::New();
+  for (int f=0; f < 3; f++)
+    {
+    vtkThreadedImageAlgorithm *filter = filters[f];
+    if (filter->GetSplitMode() != modes[f])
+      {
+      cerr << names[f] << " splits into " << filter->GetSplitModeAsString()
+           << "s" << endl;
+      rval++;
+      }
+    filter->SetInput(volume);
+    filter->SetDesiredBytesPerPiece(8192);
+    filter->SetNumberOfThreads(4);
+    filter->AddObserver(vtkCommand::ProgressEvent, checker);
+    checker->Reset();
+    filter->Update();
+    filter->RemoveObserver(checker);
+    if (checker->Decreased)
+      {
+      cerr << names[f] << " reports a decreasing progress" << endl;
+      rval++;
+      }
+    vtkImageData *output = vtkImageData::New();
+    output->DeepCopy(filter->GetOutput());
+    filter->SetSplitModeToSlab();
+    filter->SetNumberOfThreads(1);
+    filter->Update();
+    rval += CompareImages(filter->GetOutput(), output, names[f]);
+    output->Delete();
+    filter->Delete();
+    }
+  checker->Delete();
+
+  volume->Delete();
+  flat->Delete();
+  return rval;
+}
@@ -18,10 +18,13 @@
 #include "vtkImageData.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkStreamingDemandDrivenPipeline.h"
 #include "vtkPointData.h"
 
+#include <vtkstd/vector>
+
 #include <math.h>
 
 vtkStandardNewMacro(vtkGaussianSplatter);
@@ -102,6 +105,251 @@ int vtkGaussianSplatter::RequestInformation (
   return 1;
 }
 
+//----------------------------------------------------------------------------
+// The volume is split into slabs of slices along z.  The points are binned
+// by the slabs that their footprints overlap: each thread bins a range of
+// points into its own lists, so that the lists of the threads, taken in
+// turn, keep the order of the points.  Each slab is then splatted by one
+// thread, so that the voxels are combined without locks in the same order
+// whatever the number of threads.
+namespace
+{
+struct vtkGaussianSplatterStruct
+{
+  vtkGaussianSplatter *Filter;
+  int Pass;
+  vtkDataSet *Input;
+  vtkDataArray *Normals;
+  vtkDataArray *Scalars;
+  double *Output;
+  char *Visited;
+  int Dimensions[3];
+  double Origin[3];
+  double Spacing[3];
+  double SplatDistance[3];
+  double Radius2;
+  double Eccentricity2;
+  double ExponentFactor;
+  double ScaleFactor;
+  double NullValue;
+  int AccumulationMode;
+  int NumberOfThreads;
+  int NumberOfSlabs;
+  vtkstd::vector<int> SlabStart;
+  vtkstd::vector<int> SlabOfSlice;
+  vtkstd::vector<vtkstd::vector<vtkIdType> > Bins;
+};
+}
+
+//----------------------------------------------------------------------------
+// Determine the splat footprint of a point, and return 0 if it is empty.
+static int vtkGaussianSplatterFootprint(vtkGaussianSplatterStruct *ts,
+                                        const double p[3], int min[3],
+                                        int max[3])
+{
+  for (int i=0; i<3; i++)
+    {
+    double loc = (p[i] - ts->Origin[i]) / ts->Spacing[i];
+    min[i] = static_cast<int>(floor(loc - ts->SplatDistance[i]));
+    max[i] = static_cast<int>(ceil(loc + ts->SplatDistance[i]));
+    if ( min[i] < 0 )
+      {
+      min[i] = 0;
+      }
+    if ( max[i] >= ts->Dimensions[i] )
+      {
+      max[i] = ts->Dimensions[i] - 1;
+      }
+    }
+  return (min[0] <= max[0] && min[1] <= max[1] && min[2] <= max[2]);
+}
+
+//----------------------------------------------------------------------------
+// Splat a point into the slices from k0 to k1.  The distance is spherical,
+// or ellipsoidal around the normal of the point.
+static void vtkGaussianSplatterSplatPoint(vtkGaussianSplatterStruct *ts,
+                                          vtkIdType ptId, int k0, int k1)
+{
+  double p[3];
+  int min[3], max[3];
+  ts->Input->GetPoint(ptId, p);
+  if ( !vtkGaussianSplatterFootprint(ts, p, min, max) )
+    {
+    return;
+    }
+  min[2] = (min[2] > k0 ? min[2] : k0);
+  max[2] = (max[2] < k1 ? max[2] : k1);
+
+  double n[3] = {0.0, 0.0, 0.0};
+  double mag = 1.0;
+  if ( ts->Normals )
+    {
+    ts->Normals->GetTuple(ptId, n);
+    if ( (mag = n[0]*n[0] + n[1]*n[1] + n[2]*n[2]) != 1.0 )
+      {
+      mag = (mag == 0.0 ? 1.0 : sqrt(mag));
+      }
+    }
+  double factor = ts->ScaleFactor;
+  if ( ts->Scalars )
+    {
+    factor = ts->ScaleFactor * ts->Scalars->GetComponent(ptId, 0);
+    }
+
+  vtkIdType sliceSize =
+    static_cast<vtkIdType>(ts->Dimensions[0])*ts->Dimensions[1];
+  double cx[3];
+  for (int k=min[2]; k<=max[2]; k++)
+    {
+    cx[2] = ts->Origin[2] + ts->Spacing[2]*k;
+    for (int j=min[1]; j<=max[1]; j++)
+      {
+      cx[1] = ts->Origin[1] + ts->Spacing[1]*j;
+      vtkIdType idx = min[0] + j*ts->Dimensions[0] + k*sliceSize;
+      for (int i=min[0]; i<=max[0]; i++, idx++)
+        {
+        cx[0] = ts->Origin[0] + ts->Spacing[0]*i;
+        double v[3] = {cx[0] - p[0], cx[1] - p[1], cx[2] - p[2]};
+        double dist2 = v[0]*v[0] + v[1]*v[1] + v[2]*v[2];
+        if ( ts->Normals )
+          {
+          double z2 = (v[0]*n[0] + v[1]*n[1] + v[2]*n[2])/mag;
+          z2 = z2*z2;
+          dist2 = (dist2 - z2)/ts->Eccentricity2 + z2;
+          }
+        if ( dist2 > ts->Radius2 )
+          {
+          continue;
+          }
+
+        double s = factor * exp(ts->ExponentFactor*dist2/ts->Radius2);
+        if ( !ts->Visited[idx] )
+          {
+          ts->Visited[idx] = 1;
+          ts->Output[idx] = s;
+          continue;
+          }
+        double t = ts->Output[idx];
+        switch (ts->AccumulationMode)
+          {
+          case VTK_ACCUMULATION_MODE_MIN:
+            ts->Output[idx] = (t < s ? t : s);
+            break;
+          case VTK_ACCUMULATION_MODE_MAX:
+            ts->Output[idx] = (t > s ? t : s);
+            break;
+          case VTK_ACCUMULATION_MODE_SUM:
+            ts->Output[idx] = t + s;
+            break;
+          }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Bin a range of points by slab.
+static void vtkGaussianSplatterBinPoints(vtkGaussianSplatterStruct *ts,
+                                         int threadId)
+{
+  vtkIdType numPts = ts->Input->GetNumberOfPoints();
+  vtkIdType endId = numPts*(threadId + 1)/ts->NumberOfThreads;
+  vtkstd::vector<vtkIdType> *bins = &ts->Bins[threadId*ts->NumberOfSlabs];
+  double p[3];
+  int min[3], max[3];
+  for (vtkIdType ptId = numPts*threadId/ts->NumberOfThreads; ptId < endId;
+       ptId++)
+    {
+    ts->Input->GetPoint(ptId, p);
+    if ( vtkGaussianSplatterFootprint(ts, p, min, max) )
+      {
+      for (int slab = ts->SlabOfSlice[min[2]];
+           slab <= ts->SlabOfSlice[max[2]]; slab++)
+        {
+        bins[slab].push_back(ptId);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Splat the points of a slab, which are all the points when there is only
+// one slab.  The slab is cleared even when execution is aborted.
+static void vtkGaussianSplatterSplatSlab(vtkGaussianSplatterStruct *ts,
+                                         int slab, int report)
+{
+  int k0 = ts->SlabStart[slab];
+  int k1 = ts->SlabStart[slab + 1] - 1;
+  vtkIdType sliceSize =
+    static_cast<vtkIdType>(ts->Dimensions[0])*ts->Dimensions[1];
+  for (vtkIdType idx = k0*sliceSize; idx < (k1 + 1)*sliceSize; idx++)
+    {
+    ts->Output[idx] = ts->NullValue;
+    ts->Visited[idx] = 0;
+    }
+  if ( ts->Filter->GetAbortExecute() )
+    {
+    return;
+    }
+
+  if ( ts->NumberOfSlabs == 1 )
+    {
+    vtkIdType numPts = ts->Input->GetNumberOfPoints();
+    vtkIdType progressInterval = numPts/20 + 1;
+    for (vtkIdType ptId=0; ptId < numPts; ptId++)
+      {
+      if ( !(ptId % progressInterval) )
+        {
+        ts->Filter->UpdateProgress(static_cast<double>(ptId)/numPts);
+        if ( ts->Filter->GetAbortExecute() )
+          {
+          break;
+          }
+        }
+      vtkGaussianSplatterSplatPoint(ts, ptId, k0, k1);
+      }
+    return;
+    }
+
+  for (int threadId=0; threadId < ts->NumberOfThreads; threadId++)
+    {
+    vtkstd::vector<vtkIdType> &bin =
+      ts->Bins[threadId*ts->NumberOfSlabs + slab];
+    for (size_t b=0; b < bin.size(); b++)
+      {
+      vtkGaussianSplatterSplatPoint(ts, bin[b], k0, k1);
+      }
+    }
+  if ( report )
+    {
+    ts->Filter->UpdateProgress(static_cast<double>(slab + 1)/
+                               ts->NumberOfSlabs);
+    }
+}
+
+//----------------------------------------------------------------------------
+static VTK_THREAD_RETURN_TYPE vtkGaussianSplatterThread(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkGaussianSplatterStruct *ts =
+    static_cast<vtkGaussianSplatterStruct *>(info->UserData);
+  int threadId = info->ThreadID;
+  if ( ts->Pass == 0 )
+    {
+    vtkGaussianSplatterBinPoints(ts, threadId);
+    }
+  else
+    {
+    for (int slab = threadId; slab < ts->NumberOfSlabs;
+         slab += ts->NumberOfThreads)
+      {
+      vtkGaussianSplatterSplatSlab(ts, slab, threadId == 0);
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
 //----------------------------------------------------------------------------
 int vtkGaussianSplatter::RequestData(
   vtkInformation* vtkNotUsed( request ),
@@ -112,27 +360,21 @@ int vtkGaussianSplatter::RequestData(
   vtkInformation *outInfo = outputVector->GetInformationObject(0);
   vtkImageData *output = vtkImageData::SafeDownCast(
     outInfo->Get(vtkDataObject::DATA_OBJECT()));
-  
+
   output->SetExtent(
     outInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT()));
   output->AllocateScalars();
-  
-  vtkIdType numPts, numNewPts, ptId, idx, i;
-  int j, k;
-  int min[3], max[3];
+
+  vtkIdType numPts;
   vtkPointData *pd;
-  vtkDataArray *inNormals=NULL;
-  vtkDataArray *inScalars=NULL;
-  double loc[3], dist2, cx[3];
-  vtkDoubleArray *newScalars = 
+  vtkDoubleArray *newScalars =
     vtkDoubleArray::SafeDownCast(output->GetPointData()->GetScalars());
   newScalars->SetName("SplatterValues");
-  
+
   vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
   vtkDataSet *input = vtkDataSet::SafeDownCast(
     inInfo->Get(vtkDataObject::DATA_OBJECT()));
-  int sliceSize=this->SampleDimensions[0]*this->SampleDimensions[1];
-  
+
   vtkDebugMacro(<< "Splatting data");
 
   //  Make sure points are available
@@ -149,110 +391,76 @@ int vtkGaussianSplatter::RequestData(
   //
   this->Eccentricity2 = this->Eccentricity * this->Eccentricity;
 
-  numNewPts = this->SampleDimensions[0] * this->SampleDimensions[1] *
-              this->SampleDimensions[2];
-  for (i=0; i<numNewPts; i++)
-    {
-    newScalars->SetTuple(i,&this->NullValue);
-    }
-  this->Visited = new char[numNewPts];
-  for (i=0; i < numNewPts; i++)
-    {
-    this->Visited[i] = 0;
-    }
-
   output->SetDimensions(this->GetSampleDimensions());
   this->ComputeModelBounds(input,output, outInfo);
 
-  //  Set up function pointers to sample functions
-  //
+  vtkGaussianSplatterStruct ts;
+  ts.Filter = this;
+  ts.Input = input;
   pd = input->GetPointData();
-  if ( this->NormalWarping && (inNormals=pd->GetNormals()) != NULL )
+  ts.Normals = (this->NormalWarping ? pd->GetNormals() : NULL);
+  ts.Scalars = (this->ScalarWarping ? pd->GetScalars() : NULL);
+  ts.Output = newScalars->GetPointer(0);
+  for (int i=0; i<3; i++)
     {
-    this->Sample = &vtkGaussianSplatter::EccentricGaussian;
+    ts.Dimensions[i] = this->SampleDimensions[i];
+    ts.Origin[i] = this->Origin[i];
+    ts.Spacing[i] = this->Spacing[i];
+    ts.SplatDistance[i] = this->SplatDistance[i];
     }
-  else
+  ts.Radius2 = this->Radius2;
+  ts.Eccentricity2 = this->Eccentricity2;
+  ts.ExponentFactor = this->ExponentFactor;
+  ts.ScaleFactor = this->ScaleFactor;
+  ts.NullValue = this->NullValue;
+  ts.AccumulationMode = this->AccumulationMode;
+  vtkstd::vector<char> visited(newScalars->GetNumberOfTuples());
+  ts.Visited = &visited[0];
+
+  // A few slabs per thread balance the points, which are seldom spread
+  // evenly.  The points are only binned when there are several slabs.
+  int numThreads = this->NumberOfThreads;
+  int maxThreads = vtkMultiThreader::GetGlobalMaximumNumberOfThreads();
+  if ( maxThreads > 0 && numThreads > maxThreads )
     {
-    this->Sample = &vtkGaussianSplatter::Gaussian;
+    numThreads = maxThreads;
     }
-
-  if ( this->ScalarWarping && (inScalars=pd->GetScalars()) != NULL )
+  numThreads = (numThreads < this->SampleDimensions[2] ? numThreads :
+                this->SampleDimensions[2]);
+  ts.NumberOfThreads = (numThreads < 1 ? 1 : numThreads);
+  ts.NumberOfSlabs = (ts.NumberOfThreads == 1 ? 1 : 4*ts.NumberOfThreads);
+  ts.NumberOfSlabs = (ts.NumberOfSlabs < this->SampleDimensions[2] ?
+                      ts.NumberOfSlabs : this->SampleDimensions[2]);
+  ts.SlabStart.resize(ts.NumberOfSlabs + 1);
+  ts.SlabOfSlice.resize(this->SampleDimensions[2]);
+  for (int slab=0; slab <= ts.NumberOfSlabs; slab++)
     {
-    this->SampleFactor = &vtkGaussianSplatter::ScalarSampling;
+    ts.SlabStart[slab] = static_cast<int>(
+      static_cast<vtkIdType>(this->SampleDimensions[2])*slab/
+      ts.NumberOfSlabs);
     }
-  else
+  for (int slab=0; slab < ts.NumberOfSlabs; slab++)
     {
-    this->SampleFactor = &vtkGaussianSplatter::PositionSampling;
-    this->S = 0.0; //position sampling does not require S to be defined
-                   //but this makes purify happy.
+    for (int k=ts.SlabStart[slab]; k < ts.SlabStart[slab + 1]; k++)
+      {
+      ts.SlabOfSlice[k] = slab;
+      }
     }
 
   // Traverse all points - splatting each into the volume.
   // For each point, determine which voxel it is in.  Then determine
   // the subvolume that the splat is contained in, and process that.
   //
-  int abortExecute=0;
-  vtkIdType progressInterval = numPts/20 + 1;
-  for (ptId=0; ptId < numPts && !abortExecute; ptId++)
+  this->Threader->SetNumberOfThreads(ts.NumberOfThreads);
+  this->Threader->SetSingleMethod(vtkGaussianSplatterThread, &ts);
+  if ( ts.NumberOfSlabs > 1 )
     {
-    if ( ! (ptId % progressInterval) )
-      {
-      vtkDebugMacro(<<"Inserting point #" << ptId);
-      this->UpdateProgress (static_cast<double>(ptId)/numPts);
-      abortExecute = this->GetAbortExecute();
-      }
-
-    this->P = input->GetPoint(ptId);
-    if ( inNormals != NULL )
-      {
-      this->N = inNormals->GetTuple(ptId);
-      }
-    if ( inScalars != NULL )
-      {
-      this->S = inScalars->GetComponent(ptId,0);
-      }
-
-    // Determine the voxel that the point is in
-    for (i=0; i<3; i++)  
-      {
-      loc[i] = (this->P[i] - this->Origin[i]) / this->Spacing[i];
-      }
-
-    // Determine splat footprint
-    for (i=0; i<3; i++)
-      {
-      min[i] = static_cast<int>(floor(static_cast<double>(loc[i])-this->SplatDistance[i]));
-      max[i] = static_cast<int>(ceil(static_cast<double>(loc[i])+this->SplatDistance[i]));
-      if ( min[i] < 0 )
-        {
-        min[i] = 0;
-        }
-      if ( max[i] >= this->SampleDimensions[i] )
-        {
-        max[i] = this->SampleDimensions[i] - 1;
-        }
-      }
-    
-    // Loop over all sample points in volume within footprint and
-    // evaluate the splat
-    for (k=min[2]; k<=max[2]; k++)
-      {
-      cx[2] = this->Origin[2] + this->Spacing[2]*k;
-      for (j=min[1]; j<=max[1]; j++)
-        {
-        cx[1] = this->Origin[1] + this->Spacing[1]*j;
-        for (i=min[0]; i<=max[0]; i++)
-          {
-          cx[0] = this->Origin[0] + this->Spacing[0]*i;
-          if ( (dist2=(this->*Sample)(cx)) <= this->Radius2 ) 
-            {
-            idx = i + j*this->SampleDimensions[0] + k*sliceSize;
-            this->SetScalar(idx,dist2, newScalars);
-            }//if within splat radius
-          }
-        }
-      }//within splat footprint
-    }//for all input points
+    ts.Bins.resize(ts.NumberOfThreads*ts.NumberOfSlabs);
+    ts.Pass = 0;
+    this->Threader->SingleMethodExecute();
+    }
+  ts.Pass = 1;
+  this->Threader->SingleMethodExecute();
 
   // If capping is turned on, set the distances of the outside of the volume
   // to the CapValue.
@@ -264,10 +472,6 @@ int vtkGaussianSplatter::RequestData(
 
   vtkDebugMacro(<< "Splatted " << input->GetNumberOfPoints() << " points");
 
-  // Update self and release memeory
-  //
-  delete [] this->Visited;
-
   return 1;
 }
 
@@ -455,84 +659,6 @@ void vtkGaussianSplatter::Cap(vtkDoubleArray *s)
     }
 }
 
-//----------------------------------------------------------------------------
-//
-//  Gaussian sampling
-//
-double vtkGaussianSplatter::Gaussian (double cx[3])
-{
-  return ((cx[0]-P[0])*(cx[0]-P[0]) + (cx[1]-P[1])*(cx[1]-P[1]) +
-          (cx[2]-P[2])*(cx[2]-P[2]) );
-}
-    
-//----------------------------------------------------------------------------
-//
-//  Ellipsoidal Gaussian sampling
-//
-double vtkGaussianSplatter::EccentricGaussian (double cx[3])
-{
-  double   v[3], r2, z2, rxy2, mag;
-
-  v[0] = cx[0] - this->P[0];
-  v[1] = cx[1] - this->P[1];
-  v[2] = cx[2] - this->P[2];
-
-  r2 = v[0]*v[0] + v[1]*v[1] + v[2]*v[2];
-
-  if ( (mag=this->N[0]*this->N[0]+
-            this->N[1]*this->N[1]+
-            this->N[2]*this->N[2]) != 1.0  ) 
-    {
-    if ( mag == 0.0 )
-      {
-      mag = 1.0;
-      }
-    else
-      {
-      mag = sqrt(mag);
-      }
-    }
-
-  z2 = (v[0]*this->N[0] + v[1]*this->N[1] + v[2]*this->N[2])/mag;
-  z2 = z2*z2;
-
-  rxy2 = r2 - z2;
-
-  return (rxy2/this->Eccentricity2 + z2);
-}
-    
-//----------------------------------------------------------------------------
-void vtkGaussianSplatter::SetScalar(int idx, double dist2, 
-                                    vtkDoubleArray *newScalars)
-{
-  double v = (this->*SampleFactor)(this->S) * exp(
-    static_cast<double>
-    (this->ExponentFactor*(dist2)/(this->Radius2)));
-
-  if ( ! this->Visited[idx] )
-    {
-    this->Visited[idx] = 1;
-    newScalars->SetTuple(idx,&v);
-    }
-  else
-    {
-    double s = newScalars->GetValue(idx);
-    switch (this->AccumulationMode)
-      {
-      case VTK_ACCUMULATION_MODE_MIN:
-        newScalars->SetTuple(idx,(s < v ? &s : &v));
-        break;
-      case VTK_ACCUMULATION_MODE_MAX:
-        newScalars->SetTuple(idx,(s > v ? &s : &v));
-        break;
-      case VTK_ACCUMULATION_MODE_SUM:
-        s += v;
-        newScalars->SetTuple(idx,&s);
-        break;
-      }
-    }//not first visit
-}
-
 //----------------------------------------------------------------------------
 const char *vtkGaussianSplatter::GetAccumulationModeAsString()
 {
@@ -48,6 +48,12 @@
 // volume rendered to generate a visualization. It can be used to create
 // surfaces from point distributions, or to create structure (i.e.,
 // topology) when none exists.
+//
+// The volume is split into slabs along z, and the points are binned by
+// the slabs their splats overlap, in their order.  Each slab is then
+// splatted by one thread, which combines the splats of each voxel in the
+// order of the points, so that the output does not depend on the number
+// of threads.
 
 // .SECTION Caveats
 // The input to this filter is any dataset type. This filter can be used 
@@ -64,7 +70,7 @@
 #ifndef __vtkGaussianSplatter_h
 #define __vtkGaussianSplatter_h
 
-#include "vtkImageAlgorithm.h"
+#include "vtkThreadedImageAlgorithm.h"
 
 #define VTK_ACCUMULATION_MODE_MIN 0
 #define VTK_ACCUMULATION_MODE_MAX 1
@@ -72,10 +78,11 @@
 
 class vtkDoubleArray;
 
-class VTK_IMAGING_EXPORT vtkGaussianSplatter : public vtkImageAlgorithm 
+class VTK_IMAGING_EXPORT vtkGaussianSplatter :
+  public vtkThreadedImageAlgorithm
 {
 public:
-  vtkTypeMacro(vtkGaussianSplatter,vtkImageAlgorithm);
+  vtkTypeMacro(vtkGaussianSplatter,vtkThreadedImageAlgorithm);
   void PrintSelf(ostream& os, vtkIndent indent);
 
   // Description:
@@ -210,24 +217,10 @@ protected:
   double CapValue; // value to use for capping
   int AccumulationMode; // how to combine scalar values
 
-  double Gaussian(double x[3]);  
-  double EccentricGaussian(double x[3]);  
-  double ScalarSampling(double s) 
-    {return this->ScaleFactor * s;}
-  double PositionSampling(double) 
-    {return this->ScaleFactor;}
-  void SetScalar(int idx, double dist2, vtkDoubleArray *newScalars);
-
 //BTX
 private:
   double Radius2;
-  double (vtkGaussianSplatter::*Sample)(double x[3]);
-  double (vtkGaussianSplatter::*SampleFactor)(double s);
-  char *Visited;
   double Eccentricity2;
-  double *P;
-  double *N;
-  double S;
   double Origin[3];
   double Spacing[3];
   double SplatDistance[3];
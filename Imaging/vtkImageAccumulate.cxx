@@ -14,15 +14,19 @@
 =========================================================================*/
 #include "vtkImageAccumulate.h"
 
+#include "vtkDataSetAttributes.h"
 #include "vtkImageData.h"
 #include "vtkImageStencilData.h"
 #include "vtkImageStencilIterator.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkMath.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkStreamingDemandDrivenPipeline.h"
 
+#include <vtkstd/vector>
+
 #include <math.h>
 
 vtkStandardNewMacro(vtkImageAccumulate);
@@ -39,6 +43,8 @@ vtkImageAccumulate::vtkImageAccumulate()
     this->ComponentExtent[idx*2+1] = 0;
     }
   this->ComponentExtent[1] = 255;
+  this->HistogramMode = VTK_ACCUMULATE_JOINT;
+  this->OutputScalarType = VTK_INT;
 
   this->ReverseStencil = 0;
 
@@ -124,56 +130,110 @@ vtkImageStencilData *vtkImageAccumulate::GetStencil()
 
 
 //----------------------------------------------------------------------------
-// This templated function executes the filter for any type of data.
-template <class T>
-void vtkImageAccumulateExecute(vtkImageAccumulate *self,
-                               vtkImageData *inData, T *,
-                               vtkImageData *outData, int *outPtr,
-                               double min[3], double max[3],
-                               double mean[3],
-                               double standardDeviation[3],
-                               vtkIdType *voxelCount,
-                               int* updateExtent)
+// The partial histogram and statistics of each thread.  The first thread
+// counts into the output, the others into bins of the output type, or all
+// count each value of each component when the values are binned afterwards.
+namespace
 {
-  // variables used to compute statistics (filter handles max 3 components)
-  double sum[3];
-  sum[0] = sum[1] = sum[2] = 0.0;
-  double sumSqr[3];
-  sumSqr[0] = sumSqr[1] = sumSqr[2] = 0.0;
-  min[0] = min[1] = min[2] = VTK_DOUBLE_MAX;
-  max[0] = max[1] = max[2] = VTK_DOUBLE_MIN;
-  standardDeviation[0] = standardDeviation[1] = standardDeviation[2] = 0.0;
-  *voxelCount = 0;
-
-  // input's number of components is used as output dimensionality
-  int numC = inData->GetNumberOfScalarComponents();
-
-  // get information for output data
-  int outExtent[6];
-  outData->GetExtent(outExtent);
-  vtkIdType outIncs[3];
-  outData->GetIncrements(outIncs);
-  double origin[3];
-  outData->GetOrigin(origin);
-  double spacing[3];
-  outData->GetSpacing(spacing);
+struct vtkImageAccumulateThreadData
+{
+  void *Bins;
+  vtkstd::vector<int> IntBins;
+  vtkstd::vector<vtkIdType> IdTypeBins;
+  vtkstd::vector<vtkIdType> ValueCounts;
+  double Sum[3];
+  double SumSqr[3];
+  double Min[3];
+  double Max[3];
+  vtkIdType VoxelCount;
+};
+
+struct vtkImageAccumulateStruct
+{
+  vtkImageAccumulate *Filter;
+  vtkImageData *Input;
+  vtkImageStencilData *Stencil;
+  void *OutPtr;
+  int OutputScalarType;
+  int Extent[6];
+  int NumberOfComponents;
+  int PerComponent;
+  int ReverseStencil;
+  int IgnoreZero;
+  double Origin[3];
+  double Spacing[3];
+  int BinExtent[6];
+  vtkIdType BinIncrements[3];
+  vtkIdType NumberOfBins;
+  int CountValues;
+  int ValueMin;
+  vtkIdType NumberOfValues;
+  int NumberOfThreads;
+  vtkstd::vector<vtkImageAccumulateThreadData> Threads;
+};
+}
 
-  // zero count in every bin
-  vtkIdType size = 1;
-  size *= (outExtent[1] - outExtent[0] + 1);
-  size *= (outExtent[3] - outExtent[2] + 1);
-  size *= (outExtent[5] - outExtent[4] + 1);
-  for (vtkIdType j = 0; j < size; j++)
+//----------------------------------------------------------------------------
+// Gather the statistics of one value of one component.
+static inline void vtkImageAccumulateAddValue(double v, int idxC,
+                                              double sum[3],
+                                              double sumSqr[3],
+                                              double min[3], double max[3],
+                                              vtkIdType &voxelCount)
+{
+  sum[idxC] += v;
+  sumSqr[idxC] += v*v;
+  if (v > max[idxC])
+    {
+    max[idxC] = v;
+    }
+  if (v < min[idxC])
     {
-    outPtr[j] = 0;
+    min[idxC] = v;
     }
+  voxelCount++;
+}
 
-  vtkImageStencilData *stencil = self->GetStencil();
-  bool reverseStencil = (self->GetReverseStencil() != 0);
-  bool ignoreZero = (self->GetIgnoreZero() != 0);
+//----------------------------------------------------------------------------
+// Bin the pixels of one piece into the partial histogram of the thread,
+// and gather the statistics of the first 3 components.
+template <class T, class OT>
+void vtkImageAccumulateBinPiece(vtkImageAccumulateStruct *ts,
+                                vtkImageAccumulateThreadData *td,
+                                int extent[6], int threadId, T *, OT *bins)
+{
+  int numC = ts->NumberOfComponents;
+  int numStats = (numC < 3 ? numC : 3);
+  bool perComponent = (ts->PerComponent != 0);
+  bool reverseStencil = (ts->ReverseStencil != 0);
+  bool ignoreZero = (ts->IgnoreZero != 0);
+
+  // local copies, which the counts cannot alias
+  double origin[3], spacing[3];
+  int binExt[6];
+  vtkIdType binIncs[3];
+  for (int idx = 0; idx < 3; ++idx)
+    {
+    origin[idx] = ts->Origin[idx];
+    spacing[idx] = ts->Spacing[idx];
+    binExt[2*idx] = ts->BinExtent[2*idx];
+    binExt[2*idx+1] = ts->BinExtent[2*idx+1];
+    binIncs[idx] = ts->BinIncrements[idx];
+    }
+  vtkIdType numBinsX = binExt[1] - binExt[0] + 1;
 
-  vtkImageStencilIterator<T> inIter(inData, stencil, updateExtent, self);
+  // the statistics are kept locally, away from the other threads
+  double sum[3], sumSqr[3], min[3], max[3];
+  for (int idxC = 0; idxC < 3; ++idxC)
+    {
+    sum[idxC] = sumSqr[idxC] = 0.0;
+    min[idxC] = td->Min[idxC];
+    max[idxC] = td->Max[idxC];
+    }
+  vtkIdType voxelCount = 0;
 
+  vtkImageStencilIterator<T> inIter(ts->Input, ts->Stencil, extent,
+                                    ts->Filter, threadId);
   while (!inIter.IsAtEnd())
     {
     if (inIter.IsInStencil() ^ reverseStencil)
@@ -181,95 +241,301 @@ void vtkImageAccumulateExecute(vtkImageAccumulate *self,
       T *inPtr = inIter.BeginSpan();
       T *spanEndPtr = inIter.EndSpan();
 
-      while (inPtr != spanEndPtr)
+      if (perComponent)
         {
-        // find the bin for this pixel.
-        bool outOfBounds = false;
-        int *outPtrC = outPtr;
-        for (int idxC = 0; idxC < numC; ++idxC)
+        // each component has its own row of bins
+        while (inPtr != spanEndPtr)
           {
-          double v = static_cast<double>(*inPtr++);
-          if (!ignoreZero || v != 0)
+          for (int idxC = 0; idxC < numC; ++idxC)
             {
-            // gather statistics
-            sum[idxC] += v;
-            sumSqr[idxC] += v*v;
-            if (v > max[idxC])
+            double v = static_cast<double>(*inPtr++);
+            if (idxC < numStats && (!ignoreZero || v != 0))
               {
-              max[idxC] = v;
+              vtkImageAccumulateAddValue(v, idxC, sum, sumSqr, min, max,
+                                         voxelCount);
               }
-            if (v < min[idxC])
+            int outIdx = vtkMath::Floor((v - origin[0]) / spacing[0]);
+            if (outIdx >= binExt[0] && outIdx <= binExt[1])
               {
-              min[idxC] = v;
+              ++bins[idxC*numBinsX + outIdx - binExt[0]];
               }
-            (*voxelCount)++;
             }
+          }
+        }
+      else
+        {
+        while (inPtr != spanEndPtr)
+          {
+          // find the bin for this pixel.
+          bool outOfBounds = false;
+          OT *binPtr = bins;
+          for (int idxC = 0; idxC < numC; ++idxC)
+            {
+            double v = static_cast<double>(*inPtr++);
+            if (!ignoreZero || v != 0)
+              {
+              vtkImageAccumulateAddValue(v, idxC, sum, sumSqr, min, max,
+                                         voxelCount);
+              }
 
-          // compute the index
-          int outIdx = vtkMath::Floor((v - origin[idxC]) / spacing[idxC]);
+            // compute the index
+            int outIdx = vtkMath::Floor((v - origin[idxC]) / spacing[idxC]);
 
-          // verify that it is in range
-          if (outIdx >= outExtent[idxC*2] && outIdx <= outExtent[idxC*2+1])
-            {
-            outPtrC += (outIdx - outExtent[idxC*2]) * outIncs[idxC];
+            // verify that it is in range
+            if (outIdx >= binExt[idxC*2] && outIdx <= binExt[idxC*2+1])
+              {
+              binPtr += (outIdx - binExt[idxC*2]) * binIncs[idxC];
+              }
+            else
+              {
+              outOfBounds = true;
+              }
             }
-          else
+
+          // increment the bin
+          if (!outOfBounds)
             {
-            outOfBounds = true;
+            ++(*binPtr);
             }
           }
+        }
+      }
+
+    inIter.NextSpan();
+    }
+
+  for (int idxC = 0; idxC < 3; ++idxC)
+    {
+    td->Sum[idxC] += sum[idxC];
+    td->SumSqr[idxC] += sumSqr[idxC];
+    td->Min[idxC] = min[idxC];
+    td->Max[idxC] = max[idxC];
+    }
+  td->VoxelCount += voxelCount;
+}
+
+//----------------------------------------------------------------------------
+// Count the pixels of each value of each component of one piece of 8 or
+// 16 bit integers.  The values are binned after the threads are done.
+template <class T>
+void vtkImageAccumulateCountPiece(vtkImageAccumulateStruct *ts,
+                                  vtkImageAccumulateThreadData *td,
+                                  int extent[6], int threadId, T *)
+{
+  int numC = ts->NumberOfComponents;
+  bool reverseStencil = (ts->ReverseStencil != 0);
+  int valueMin = ts->ValueMin;
+  vtkIdType *counts = &td->ValueCounts[0];
 
-        // increment the bin
-        if (!outOfBounds)
+  vtkImageStencilIterator<T> inIter(ts->Input, ts->Stencil, extent,
+                                    ts->Filter, threadId);
+  while (!inIter.IsAtEnd())
+    {
+    if (inIter.IsInStencil() ^ reverseStencil)
+      {
+      T *inPtr = inIter.BeginSpan();
+      T *spanEndPtr = inIter.EndSpan();
+      if (numC == 1)
+        {
+        while (inPtr != spanEndPtr)
+          {
+          ++counts[static_cast<int>(*inPtr++) - valueMin];
+          }
+        }
+      else
+        {
+        while (inPtr != spanEndPtr)
           {
-          ++(*outPtrC);
+          vtkIdType *countsC = counts;
+          for (int idxC = 0; idxC < numC; ++idxC)
+            {
+            ++countsC[static_cast<int>(*inPtr++) - valueMin];
+            countsC += ts->NumberOfValues;
+            }
           }
         }
       }
 
     inIter.NextSpan();
     }
+}
 
-  // initialize the statistics
-  mean[0] = 0;
-  mean[1] = 0;
-  mean[2] = 0;
+//----------------------------------------------------------------------------
+template <class T>
+void vtkImageAccumulateDispatch(vtkImageAccumulateStruct *ts,
+                                vtkImageAccumulateThreadData *td,
+                                int extent[6], int threadId, T *inPtr)
+{
+  if (ts->OutputScalarType == VTK_INT)
+    {
+    vtkImageAccumulateBinPiece(ts, td, extent, threadId, inPtr,
+                               static_cast<int *>(td->Bins));
+    }
+  else
+    {
+    vtkImageAccumulateBinPiece(ts, td, extent, threadId, inPtr,
+                               static_cast<vtkIdType *>(td->Bins));
+    }
+}
 
-  standardDeviation[0] = 0;
-  standardDeviation[1] = 0;
-  standardDeviation[2] = 0;
+//----------------------------------------------------------------------------
+// Accumulate the piece of the thread into its partial histogram.
+static VTK_THREAD_RETURN_TYPE vtkImageAccumulateThread(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkImageAccumulateStruct *ts =
+    static_cast<vtkImageAccumulateStruct *>(info->UserData);
+  int threadId = info->ThreadID;
+  vtkImageAccumulateThreadData *td = &ts->Threads[threadId];
+
+  for (int idxC = 0; idxC < 3; ++idxC)
+    {
+    td->Sum[idxC] = 0.0;
+    td->SumSqr[idxC] = 0.0;
+    td->Min[idxC] = VTK_DOUBLE_MAX;
+    td->Max[idxC] = VTK_DOUBLE_MIN;
+    }
+  td->VoxelCount = 0;
+  td->Bins = ts->OutPtr;
+  if (ts->CountValues)
+    {
+    td->ValueCounts.assign(ts->NumberOfComponents*ts->NumberOfValues, 0);
+    }
+  else if (threadId > 0 && ts->OutputScalarType == VTK_INT)
+    {
+    td->IntBins.assign(ts->NumberOfBins, 0);
+    td->Bins = &td->IntBins[0];
+    }
+  else if (threadId > 0)
+    {
+    td->IdTypeBins.assign(ts->NumberOfBins, 0);
+    td->Bins = &td->IdTypeBins[0];
+    }
 
-  if (*voxelCount != 0) // avoid the div0
+  int pieceExt[6];
+  int numPieces = ts->Filter->SplitExtent(pieceExt, ts->Extent, threadId,
+                                          ts->NumberOfThreads);
+  if (threadId >= numPieces || pieceExt[1] < pieceExt[0] ||
+      pieceExt[3] < pieceExt[2] || pieceExt[5] < pieceExt[4])
     {
-    double n = static_cast<double>(*voxelCount);
-    mean[0] = sum[0]/n;
-    mean[1] = sum[1]/n;
-    mean[2] = sum[2]/n;
+    return VTK_THREAD_RETURN_VALUE;
+    }
 
-    if (*voxelCount - 1 != 0) // avoid the div0
+  if (ts->CountValues)
+    {
+    switch (ts->Input->GetScalarType())
       {
-      double m = static_cast<double>(*voxelCount - 1);
-      standardDeviation[0] = sqrt((sumSqr[0] - mean[0]*mean[0]*n)/m);
-      standardDeviation[1] = sqrt((sumSqr[1] - mean[1]*mean[1]*n)/m);
-      standardDeviation[2] = sqrt((sumSqr[2] - mean[2]*mean[2]*n)/m);
+      case VTK_CHAR:
+        vtkImageAccumulateCountPiece(ts, td, pieceExt, threadId,
+                                     static_cast<char *>(0));
+        break;
+      case VTK_SIGNED_CHAR:
+        vtkImageAccumulateCountPiece(ts, td, pieceExt, threadId,
+                                     static_cast<signed char *>(0));
+        break;
+      case VTK_UNSIGNED_CHAR:
+        vtkImageAccumulateCountPiece(ts, td, pieceExt, threadId,
+                                     static_cast<unsigned char *>(0));
+        break;
+      case VTK_SHORT:
+        vtkImageAccumulateCountPiece(ts, td, pieceExt, threadId,
+                                     static_cast<short *>(0));
+        break;
+      case VTK_UNSIGNED_SHORT:
+        vtkImageAccumulateCountPiece(ts, td, pieceExt, threadId,
+                                     static_cast<unsigned short *>(0));
+        break;
       }
+    return VTK_THREAD_RETURN_VALUE;
     }
 
+  switch (ts->Input->GetScalarType())
+    {
+    vtkTemplateMacro(
+      vtkImageAccumulateDispatch(ts, td, pieceExt, threadId,
+                                 static_cast<VTK_TT *>(0)));
+    }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+// Bin the values counted by the threads into the output, and gather their
+// statistics.
+template <class OT>
+void vtkImageAccumulateBinValues(vtkImageAccumulateStruct *ts, OT *outPtr)
+{
+  int numC = ts->NumberOfComponents;
+  int numThreads = ts->NumberOfThreads;
+  vtkImageAccumulateThreadData *td = &ts->Threads[0];
+  const int *binExt = ts->BinExtent;
+  vtkIdType numBinsX = binExt[1] - binExt[0] + 1;
+  for (int idxC = 0; idxC < numC; ++idxC)
+    {
+    vtkIdType offset = idxC*ts->NumberOfValues;
+    for (vtkIdType i = 0; i < ts->NumberOfValues; ++i)
+      {
+      vtkIdType count = 0;
+      for (int t = 0; t < numThreads; ++t)
+        {
+        count += ts->Threads[t].ValueCounts[offset + i];
+        }
+      if (count == 0)
+        {
+        continue;
+        }
+      double v = static_cast<double>(ts->ValueMin + i);
+      if (idxC < 3 && (!ts->IgnoreZero || v != 0))
+        {
+        double n = static_cast<double>(count);
+        td->Sum[idxC] += v*n;
+        td->SumSqr[idxC] += v*v*n;
+        if (v > td->Max[idxC])
+          {
+          td->Max[idxC] = v;
+          }
+        if (v < td->Min[idxC])
+          {
+          td->Min[idxC] = v;
+          }
+        td->VoxelCount += count;
+        }
+      int outIdx = vtkMath::Floor((v - ts->Origin[0]) / ts->Spacing[0]);
+      if (outIdx >= binExt[0] && outIdx <= binExt[1])
+        {
+        outPtr[idxC*numBinsX + outIdx - binExt[0]] += static_cast<OT>(count);
+        }
+      }
+    }
 }
 
+//----------------------------------------------------------------------------
+// Add the partial histograms of the other threads to the one of the first
+// thread, which is the output.
+template <class OT>
+void vtkImageAccumulateAddBins(vtkImageAccumulateStruct *ts, OT *outPtr)
+{
+  for (int t = 1; t < ts->NumberOfThreads; ++t)
+    {
+    OT *bins = static_cast<OT *>(ts->Threads[t].Bins);
+    for (vtkIdType i = 0; i < ts->NumberOfBins; ++i)
+      {
+      outPtr[i] += bins[i];
+      }
+    }
+}
 
 //----------------------------------------------------------------------------
 // This method is passed a input and output Data, and executes the filter
-// algorithm to fill the output from the input.
-// It just executes a switch statement to call the correct function for
-// the Datas data types.
+// algorithm to fill the output from the input.  The threads fill partial
+// histograms of their pieces, which are added up in thread order.
 int vtkImageAccumulate::RequestData(
   vtkInformation* vtkNotUsed( request ),
   vtkInformationVector** inputVector,
   vtkInformationVector* outputVector)
 {
-  void *inPtr;
-  void *outPtr;
+  int idx;
 
   // get the input
   vtkInformation* in1Info = inputVector[0]->GetInformationObject(0);
@@ -289,61 +555,231 @@ int vtkImageAccumulate::RequestData(
   outData->SetExtent(outData->GetWholeExtent());
   outData->AllocateScalars();
 
-  vtkDataArray *inArray = this->GetInputArrayToProcess(0,inputVector);
-  inPtr = inData->GetArrayPointerForExtent(inArray, uExt);
-  outPtr = outData->GetScalarPointer();
+  int numC = inData->GetNumberOfScalarComponents();
+  int perComponent = (this->HistogramMode == VTK_ACCUMULATE_PER_COMPONENT);
 
   // Components turned into x, y and z
-  if (inData->GetNumberOfScalarComponents() > 3)
+  if (numC > 3 && !perComponent)
     {
-    vtkErrorMacro("This filter can handle up to 3 components");
+    vtkErrorMacro("This filter can handle up to 3 components, "
+                  "or more in the per-component histogram mode");
     return 1;
     }
 
-  // this filter expects that output is type int.
-  if (outData->GetScalarType() != VTK_INT)
+  // this filter expects that output is type int or vtkIdType.
+  int outType = outData->GetScalarType();
+  if (outType != VTK_INT && outType != VTK_ID_TYPE)
     {
-    vtkErrorMacro(<< "Execute: out ScalarType " << outData->GetScalarType()
-                  << " must be int\n");
+    vtkErrorMacro(<< "Execute: out ScalarType " << outType
+                  << " must be int or vtkIdType\n");
     return 1;
     }
 
-  switch (inData->GetScalarType())
+  for (idx = 0; idx < 3; ++idx)
+    {
+    this->Min[idx] = VTK_DOUBLE_MAX;
+    this->Max[idx] = VTK_DOUBLE_MIN;
+    this->Mean[idx] = 0.0;
+    this->StandardDeviation[idx] = 0.0;
+    }
+  this->VoxelCount = 0;
+
+  vtkImageAccumulateStruct ts;
+  ts.Filter = this;
+  ts.Input = inData;
+  ts.Stencil = this->GetStencil();
+  ts.ReverseStencil = this->ReverseStencil;
+  ts.IgnoreZero = this->IgnoreZero;
+  ts.PerComponent = perComponent;
+  outData->GetOrigin(ts.Origin);
+  outData->GetSpacing(ts.Spacing);
+  outData->GetExtent(ts.BinExtent);
+  ts.NumberOfBins = outData->GetNumberOfPoints();
+  ts.BinIncrements[0] = 1;
+  ts.BinIncrements[1] = ts.BinExtent[1] - ts.BinExtent[0] + 1;
+  ts.BinIncrements[2] =
+    ts.BinIncrements[1]*(ts.BinExtent[3] - ts.BinExtent[2] + 1);
+  ts.NumberOfComponents = numC;
+  if (perComponent && numC != ts.BinExtent[3] - ts.BinExtent[2] + 1)
+    {
+    vtkErrorMacro("Execute: the output has "
+                  << (ts.BinExtent[3] - ts.BinExtent[2] + 1)
+                  << " rows of bins for " << numC << " components");
+    return 1;
+    }
+  for (idx = 0; idx < 6; ++idx)
+    {
+    ts.Extent[idx] = uExt[idx];
+    }
+  vtkIdType numPixels = 1;
+  for (idx = 0; idx < 3; ++idx)
+    {
+    numPixels *= (uExt[2*idx+1] - uExt[2*idx] + 1);
+    }
+  if (numPixels <= 0 || ts.NumberOfBins <= 0 || numC <= 0)
+    {
+    numPixels = 0;
+    }
+
+  // 8 and 16 bit integers are counted per value when there are fewer
+  // values than pixels, the bins of 1 or all components are then only
+  // computed once per value.
+  int inType = inData->GetScalarType();
+  ts.ValueMin = static_cast<int>(inData->GetScalarTypeMin());
+  ts.NumberOfValues = static_cast<vtkIdType>(inData->GetScalarTypeMax()) -
+    ts.ValueMin + 1;
+  ts.CountValues = ((inType == VTK_CHAR || inType == VTK_SIGNED_CHAR ||
+                     inType == VTK_UNSIGNED_CHAR || inType == VTK_SHORT ||
+                     inType == VTK_UNSIGNED_SHORT) &&
+                    (numC == 1 || perComponent) &&
+                    ts.NumberOfValues <= numPixels);
+
+  // Each thread should have at least as many values to accumulate as its
+  // partial histogram has bins.
+  vtkIdType binsPerThread = (ts.CountValues ?
+                             ts.NumberOfComponents*ts.NumberOfValues :
+                             ts.NumberOfBins);
+  int numThreads = this->NumberOfThreads;
+  int maxThreads = vtkMultiThreader::GetGlobalMaximumNumberOfThreads();
+  if (maxThreads > 0 && numThreads > maxThreads)
+    {
+    numThreads = maxThreads;
+    }
+  if (numPixels > 0 && numThreads > numPixels*numC/binsPerThread)
+    {
+    numThreads = static_cast<int>(numPixels*numC/binsPerThread);
+    }
+  ts.NumberOfThreads = (numThreads < 1 ? 1 : numThreads);
+  ts.Threads.resize(ts.NumberOfThreads);
+
+  // zero count in every bin
+  ts.OutPtr = outData->GetScalarPointer();
+  ts.OutputScalarType = outType;
+  if (ts.NumberOfBins > 0)
+    {
+    memset(ts.OutPtr, 0, ts.NumberOfBins*outData->GetScalarSize());
+    }
+
+  if (numPixels > 0)
     {
-    vtkTemplateMacro(vtkImageAccumulateExecute( this,
-                                                inData,
-                                                static_cast<VTK_TT *>(inPtr),
-                                                outData,
-                                                static_cast<int *>(outPtr),
-                                                this->Min, this->Max,
-                                                this->Mean,
-                                                this->StandardDeviation,
-                                                &this->VoxelCount,
-                                                uExt ));
-    default:
-      vtkErrorMacro(<< "Execute: Unknown ScalarType");
-      return 1;
+    this->Threader->SetNumberOfThreads(ts.NumberOfThreads);
+    this->Threader->SetSingleMethod(vtkImageAccumulateThread, &ts);
+    this->Threader->SingleMethodExecute();
+
+    // add up the partial histograms and statistics in thread order
+    vtkImageAccumulateThreadData *td = &ts.Threads[0];
+    if (ts.CountValues && outType == VTK_INT)
+      {
+      vtkImageAccumulateBinValues(&ts, static_cast<int *>(ts.OutPtr));
+      }
+    else if (ts.CountValues)
+      {
+      vtkImageAccumulateBinValues(&ts, static_cast<vtkIdType *>(ts.OutPtr));
+      }
+    else if (outType == VTK_INT)
+      {
+      vtkImageAccumulateAddBins(&ts, static_cast<int *>(ts.OutPtr));
+      }
+    else
+      {
+      vtkImageAccumulateAddBins(&ts, static_cast<vtkIdType *>(ts.OutPtr));
+      }
+    for (int t = 1; t < ts.NumberOfThreads; ++t)
+      {
+      vtkImageAccumulateThreadData *partial = &ts.Threads[t];
+      for (idx = 0; idx < 3; ++idx)
+        {
+        td->Sum[idx] += partial->Sum[idx];
+        td->SumSqr[idx] += partial->SumSqr[idx];
+        td->Min[idx] = (partial->Min[idx] < td->Min[idx] ?
+                        partial->Min[idx] : td->Min[idx]);
+        td->Max[idx] = (partial->Max[idx] > td->Max[idx] ?
+                        partial->Max[idx] : td->Max[idx]);
+        }
+      td->VoxelCount += partial->VoxelCount;
+      }
+    for (idx = 0; idx < 3; ++idx)
+      {
+      this->Min[idx] = td->Min[idx];
+      this->Max[idx] = td->Max[idx];
+      }
+    this->VoxelCount = td->VoxelCount;
+
+    if (this->VoxelCount != 0) // avoid the div0
+      {
+      double n = static_cast<double>(this->VoxelCount);
+      for (idx = 0; idx < 3; ++idx)
+        {
+        this->Mean[idx] = td->Sum[idx]/n;
+        }
+
+      if (this->VoxelCount - 1 != 0) // avoid the div0
+        {
+        double m = static_cast<double>(this->VoxelCount - 1);
+        for (idx = 0; idx < 3; ++idx)
+          {
+          this->StandardDeviation[idx] =
+            sqrt((td->SumSqr[idx] - this->Mean[idx]*this->Mean[idx]*n)/m);
+          }
+        }
+      }
     }
 
   return 1;
 }
 
 
+//----------------------------------------------------------------------------
+const char *vtkImageAccumulate::GetHistogramModeAsString()
+{
+  if (this->HistogramMode == VTK_ACCUMULATE_PER_COMPONENT)
+    {
+    return "PerComponent";
+    }
+  return "Joint";
+}
+
 //----------------------------------------------------------------------------
 int vtkImageAccumulate::RequestInformation (
   vtkInformation* vtkNotUsed(request),
-  vtkInformationVector** vtkNotUsed(inputVector),
+  vtkInformationVector** inputVector,
   vtkInformationVector* outputVector)
 {
   // get the info objects
+  vtkInformation* inInfo = inputVector[0]->GetInformationObject(0);
   vtkInformation* outInfo = outputVector->GetInformationObject(0);
 
-  outInfo->Set(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(),
-               this->ComponentExtent,6);
-  outInfo->Set(vtkDataObject::ORIGIN(),this->ComponentOrigin,3);
-  outInfo->Set(vtkDataObject::SPACING(),this->ComponentSpacing,3);
+  if (this->HistogramMode == VTK_ACCUMULATE_PER_COMPONENT)
+    {
+    // one row of x bins per component
+    int numComponents = 1;
+    vtkInformation *inScalarInfo = vtkDataObject::GetActiveFieldInformation(
+      inInfo, vtkDataObject::FIELD_ASSOCIATION_POINTS,
+      vtkDataSetAttributes::SCALARS);
+    if (inScalarInfo &&
+        inScalarInfo->Has(vtkDataObject::FIELD_NUMBER_OF_COMPONENTS()))
+      {
+      numComponents =
+        inScalarInfo->Get(vtkDataObject::FIELD_NUMBER_OF_COMPONENTS());
+      }
+    int extent[6] = {this->ComponentExtent[0], this->ComponentExtent[1],
+                     0, numComponents - 1, 0, 0};
+    double origin[3] = {this->ComponentOrigin[0], 0.0, 0.0};
+    double spacing[3] = {this->ComponentSpacing[0], 1.0, 1.0};
+    outInfo->Set(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), extent, 6);
+    outInfo->Set(vtkDataObject::ORIGIN(), origin, 3);
+    outInfo->Set(vtkDataObject::SPACING(), spacing, 3);
+    }
+  else
+    {
+    outInfo->Set(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(),
+                 this->ComponentExtent,6);
+    outInfo->Set(vtkDataObject::ORIGIN(),this->ComponentOrigin,3);
+    outInfo->Set(vtkDataObject::SPACING(),this->ComponentSpacing,3);
+    }
 
-  vtkDataObject::SetPointDataActiveScalarInfo(outInfo, VTK_INT, 1);
+  vtkDataObject::SetPointDataActiveScalarInfo(outInfo,
+                                              this->OutputScalarType, 1);
   return 1;
 }
 
@@ -419,6 +855,9 @@ void vtkImageAccumulate::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "ReverseStencil: " << (this->ReverseStencil ?
                                          "On\n" : "Off\n");
   os << indent << "IgnoreZero: " << (this->IgnoreZero ? "On" : "Off") << "\n";
+  os << indent << "HistogramMode: " << this->GetHistogramModeAsString()
+     << "\n";
+  os << indent << "OutputScalarType: " << this->OutputScalarType << "\n";
 
   os << indent << "ComponentOrigin: ( "
      << this->ComponentOrigin[0] << ", "
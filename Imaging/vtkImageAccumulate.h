@@ -19,8 +19,16 @@
 // with each bin.  The output is this "scatter plot" (histogram values for 1D).
 // The dimensionality of the output depends on how many components the
 // input pixels have.  Input pixels with one component generate a 1D histogram.
-// This filter can only handle images with 1 to 3 scalar components.
-// The input can be any type, but the output is always int.
+// This joint histogram can only handle images with 1 to 3 scalar
+// components.  In the per-component histogram mode, each component of
+// any number of components is binned separately instead, into one row
+// of the output.
+// The input can be any type, the output is int or vtkIdType.
+//
+// The image is split among threads, which count the pixels of their
+// pieces in partial histograms that are added up at the end.  Images
+// of 8 and 16 bit integers count the pixels of each value first, and
+// bin the values afterwards.
 // Some statistics are computed on the pixel values at the same time.
 // The SetStencil and ReverseStencil
 // functions allow the statistics to be computed on an arbitrary
@@ -36,15 +44,18 @@
 #ifndef __vtkImageAccumulate_h
 #define __vtkImageAccumulate_h
 
-#include "vtkImageAlgorithm.h"
+#include "vtkThreadedImageAlgorithm.h"
 
 class vtkImageStencilData;
 
-class VTK_IMAGING_EXPORT vtkImageAccumulate : public vtkImageAlgorithm
+#define VTK_ACCUMULATE_JOINT 0
+#define VTK_ACCUMULATE_PER_COMPONENT 1
+
+class VTK_IMAGING_EXPORT vtkImageAccumulate : public vtkThreadedImageAlgorithm
 {
 public:
   static vtkImageAccumulate *New();
-  vtkTypeMacro(vtkImageAccumulate,vtkImageAlgorithm);
+  vtkTypeMacro(vtkImageAccumulate,vtkThreadedImageAlgorithm);
   void PrintSelf(ostream& os, vtkIndent indent);
 
   // Description:
@@ -82,6 +93,29 @@ public:
   void GetComponentExtent(int extent[6]);
   int *GetComponentExtent() {return this->ComponentExtent;}
 
+  // Description:
+  // Set/Get whether the components are binned together into one joint
+  // histogram, or separately.  In the per-component mode, the bins of
+  // component i are the row y = i of the output, and all components use
+  // the x values of the component origin, spacing and extent.
+  // Initial value is joint.
+  vtkSetClampMacro(HistogramMode, int, VTK_ACCUMULATE_JOINT,
+                   VTK_ACCUMULATE_PER_COMPONENT);
+  vtkGetMacro(HistogramMode, int);
+  void SetHistogramModeToJoint()
+    {this->SetHistogramMode(VTK_ACCUMULATE_JOINT);}
+  void SetHistogramModeToPerComponent()
+    {this->SetHistogramMode(VTK_ACCUMULATE_PER_COMPONENT);}
+  const char *GetHistogramModeAsString();
+
+  // Description:
+  // Set/Get the scalar type of the counts: VTK_INT or VTK_ID_TYPE, for
+  // bins of more than 2^31 pixels.  Initial value is VTK_INT.
+  vtkSetMacro(OutputScalarType, int);
+  vtkGetMacro(OutputScalarType, int);
+  void SetOutputScalarTypeToInt() {this->SetOutputScalarType(VTK_INT);}
+  void SetOutputScalarTypeToIdType()
+    {this->SetOutputScalarType(VTK_ID_TYPE);}
 
   // Description:
   // Use a stencil to specify which voxels to accumulate.
@@ -100,6 +134,7 @@ public:
   // Description:
   // Get the statistics information for the data.
   // The values only make sense after the execution of the filter.
+  // They are computed for the first 3 components.
   // Initial values are 0.
   vtkGetVector3Macro(Min, double);
   vtkGetVector3Macro(Max, double);
@@ -120,6 +155,8 @@ protected:
   double ComponentSpacing[3];
   double ComponentOrigin[3];
   int ComponentExtent[6];
+  int HistogramMode;
+  int OutputScalarType;
 
   virtual int RequestUpdateExtent(vtkInformation*,
                                    vtkInformationVector**,
@@ -0,0 +1,716 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    vtkImageConnectedComponents.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "vtkImageConnectedComponents.h"
+
+#include "vtkIdTypeArray.h"
+#include "vtkImageData.h"
+#include "vtkInformation.h"
+#include "vtkInformationVector.h"
+#include "vtkIntArray.h"
+#include "vtkMultiThreader.h"
+#include "vtkObjectFactory.h"
+#include "vtkPointData.h"
+#include "vtkStreamingDemandDrivenPipeline.h"
+
+#include <vtkstd/vector>
+
+vtkStandardNewMacro(vtkImageConnectedComponents);
+
+// The largest number of voxels of a block, so that its provisional labels
+// fit in ints.
+#define VTK_CONNECTED_COMPONENTS_MAX_BLOCK (1 << 30)
+
+//----------------------------------------------------------------------------
+vtkImageConnectedComponents::vtkImageConnectedComponents()
+{
+  this->Connectivity = 6;
+  this->SeparateValues = 0;
+  this->OutputScalarType = VTK_INT;
+  this->NumberOfLabels = 0;
+  this->LabelSizes = vtkIdTypeArray::New();
+  this->LabelExtents = vtkIntArray::New();
+  this->LabelExtents->SetNumberOfComponents(6);
+}
+
+//----------------------------------------------------------------------------
+vtkImageConnectedComponents::~vtkImageConnectedComponents()
+{
+  this->LabelSizes->Delete();
+  this->LabelExtents->Delete();
+}
+
+//----------------------------------------------------------------------------
+int vtkImageConnectedComponents::RequestInformation(
+  vtkInformation *vtkNotUsed(request),
+  vtkInformationVector **vtkNotUsed(inputVector),
+  vtkInformationVector *outputVector)
+{
+  vtkInformation *outInfo = outputVector->GetInformationObject(0);
+  vtkDataObject::SetPointDataActiveScalarInfo(outInfo,
+                                              this->OutputScalarType, 1);
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+// The regions may cross the whole image, which is labeled at once.
+int vtkImageConnectedComponents::RequestUpdateExtent(
+  vtkInformation *vtkNotUsed(request),
+  vtkInformationVector **inputVector,
+  vtkInformationVector *vtkNotUsed(outputVector))
+{
+  vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
+  int extent[6] = {0, -1, 0, -1, 0, -1};
+  inInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), extent);
+  inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), extent, 6);
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+// Each block of rows is labeled with provisional labels from 1 on, whose
+// parents in the union-find forest are smaller labels, or themselves for
+// the roots.  The provisional labels are numbered across blocks from the
+// offset of each block on, and the pairs of labels that touch the blocks
+// before are kept to merge them.
+namespace
+{
+struct vtkImageConnectedComponentsBlock
+{
+  vtkIdType FirstRow;
+  vtkIdType EndRow;
+  vtkIdType Offset;
+  vtkstd::vector<vtkIdType> Parents;
+  vtkstd::vector<vtkIdType> Counts;
+  vtkstd::vector<int> Extents;
+  vtkstd::vector<vtkIdType> Pairs;
+};
+
+struct vtkImageConnectedComponentsStruct
+{
+  vtkImageConnectedComponents *Filter;
+  int Pass;
+  void *InPtr;
+  int InputScalarType;
+  vtkIdType InIncrements[3];
+  void *OutPtr;
+  int OutputScalarType;
+  // where the final labels go: OutPtr, or a vtkIdType array when there are
+  // more regions than ints can label
+  void *LabelPtr;
+  int Extent[6];
+  int Dimensions[3];
+  int NumberOfNeighbors;
+  int Neighbors[13][3];
+  int NextToPrevious[13];
+  int SeparateValues;
+  vtkstd::vector<vtkImageConnectedComponentsBlock> Blocks;
+  vtkstd::vector<vtkIdType> Labels;
+  int NumberOfThreads;
+};
+
+// A neighbor of the voxels of a row, as offsets of the input and the
+// output pointers and along x, and whether it is also a neighbor of the
+// previous voxel of the row.
+struct vtkImageConnectedComponentsNeighbor
+{
+  vtkIdType InOffset;
+  vtkIdType OutOffset;
+  int Dx;
+  int NextToPrevious;
+};
+}
+
+//----------------------------------------------------------------------------
+static vtkIdType vtkImageConnectedComponentsFind(vtkIdType *parents,
+                                                 vtkIdType label)
+{
+  while (parents[label] != label)
+    {
+    parents[label] = parents[parents[label]];
+    label = parents[label];
+    }
+  return label;
+}
+
+// The larger root gets the smaller one as parent, so that the roots are
+// the first labels of their regions.  Returns the root of both.
+static vtkIdType vtkImageConnectedComponentsUnion(vtkIdType *parents,
+                                                  vtkIdType a, vtkIdType b)
+{
+  a = vtkImageConnectedComponentsFind(parents, a);
+  b = vtkImageConnectedComponentsFind(parents, b);
+  if (a < b)
+    {
+    parents[b] = a;
+    return a;
+    }
+  parents[a] = b;
+  return b;
+}
+
+//----------------------------------------------------------------------------
+// Gets the neighbors of the voxels of a row among the rows from firstRow
+// to endRow, and returns their number.
+static int vtkImageConnectedComponentsRowNeighbors(
+  vtkImageConnectedComponentsStruct *ts, vtkIdType row, vtkIdType firstRow,
+  vtkIdType endRow, vtkImageConnectedComponentsNeighbor *neighbors)
+{
+  int nx = ts->Dimensions[0];
+  int ny = ts->Dimensions[1];
+  int j = static_cast<int>(row % ny);
+  int k = static_cast<int>(row / ny);
+  int n = 0;
+  for (int m = 0; m < ts->NumberOfNeighbors; m++)
+    {
+    int *delta = ts->Neighbors[m];
+    int jj = j + delta[1];
+    int kk = k + delta[2];
+    vtkIdType neighborRow = jj + static_cast<vtkIdType>(kk)*ny;
+    if (jj < 0 || jj >= ny || kk < 0 || kk >= ts->Dimensions[2] ||
+        neighborRow < firstRow || neighborRow >= endRow)
+      {
+      continue;
+      }
+    neighbors[n].InOffset = delta[0]*ts->InIncrements[0] +
+      delta[1]*ts->InIncrements[1] + delta[2]*ts->InIncrements[2];
+    neighbors[n].OutOffset = delta[0] +
+      (neighborRow - row)*static_cast<vtkIdType>(nx);
+    neighbors[n].Dx = delta[0];
+    neighbors[n].NextToPrevious = ts->NextToPrevious[m];
+    n++;
+    }
+  return n;
+}
+
+//----------------------------------------------------------------------------
+// Label the voxels of a block with provisional labels, connecting them to
+// their neighbors in the rows before, then point all labels to their root.
+template <class IT, class OT>
+void vtkImageConnectedComponentsLabelBlock(
+  vtkImageConnectedComponentsStruct *ts,
+  vtkImageConnectedComponentsBlock *block, IT *inPtr, OT *outPtr, int report)
+{
+  int nx = ts->Dimensions[0];
+  int ny = ts->Dimensions[1];
+  vtkIdType inInc0 = ts->InIncrements[0];
+  int separate = ts->SeparateValues;
+  vtkImageConnectedComponentsNeighbor neighbors[13];
+
+  block->Parents.assign(1, 0);
+  block->Counts.assign(1, 0);
+  block->Extents.assign(6, 0);
+  vtkIdType numRows = block->EndRow - block->FirstRow;
+  vtkIdType progressStep = numRows/20 + 1;
+
+  for (vtkIdType row = block->FirstRow; row < block->EndRow; row++)
+    {
+    int numNeighbors = vtkImageConnectedComponentsRowNeighbors(
+      ts, row, block->FirstRow, block->EndRow, neighbors);
+    int j = static_cast<int>(row % ny);
+    int k = static_cast<int>(row / ny);
+    IT *inRow = inPtr + j*ts->InIncrements[1] + k*ts->InIncrements[2];
+    OT *outRow = outPtr + row*nx;
+    for (int i = 0; i < nx; i++)
+      {
+      IT *inVoxel = inRow + i*inInc0;
+      IT value = *inVoxel;
+      if (value == 0)
+        {
+        outRow[i] = 0;
+        continue;
+        }
+      // The voxel gets the root of the labels of its neighbors, which
+      // saves merging them again with its own neighbors.  When it is
+      // connected to the previous voxel, the neighbors of both have been
+      // merged already.
+      vtkIdType label = 0;
+      int connected = (i > 0 && outRow[i-1] != 0 &&
+                       (!separate || inVoxel[-inInc0] == value));
+      if (connected)
+        {
+        label = vtkImageConnectedComponentsFind(&block->Parents[0],
+                                                outRow[i-1]);
+        }
+      for (int m = 0; m < numNeighbors; m++)
+        {
+        int ii = i + neighbors[m].Dx;
+        if (ii < 0 || ii >= nx || (connected && neighbors[m].NextToPrevious))
+          {
+          continue;
+          }
+        vtkIdType neighborLabel = outRow[i + neighbors[m].OutOffset];
+        if (neighborLabel == 0 || neighborLabel == label ||
+            (separate && inVoxel[neighbors[m].InOffset] != value))
+          {
+          continue;
+          }
+        if (label == 0)
+          {
+          label = vtkImageConnectedComponentsFind(&block->Parents[0],
+                                                  neighborLabel);
+          }
+        else
+          {
+          label = vtkImageConnectedComponentsUnion(&block->Parents[0], label,
+                                                   neighborLabel);
+          }
+        }
+      if (label == 0)
+        {
+        label = static_cast<vtkIdType>(block->Parents.size());
+        block->Parents.push_back(label);
+        block->Counts.push_back(0);
+        int extent[6] = {i, i, j, j, k, k};
+        block->Extents.insert(block->Extents.end(), extent, extent + 6);
+        }
+      outRow[i] = static_cast<OT>(label);
+      block->Counts[label]++;
+      int *extent = &block->Extents[6*label];
+      extent[0] = (i < extent[0] ? i : extent[0]);
+      extent[1] = (i > extent[1] ? i : extent[1]);
+      extent[2] = (j < extent[2] ? j : extent[2]);
+      extent[3] = (j > extent[3] ? j : extent[3]);
+      extent[5] = k;
+      }
+
+    if (report && (row - block->FirstRow + 1) % progressStep == 0)
+      {
+      ts->Filter->UpdateProgress(
+        0.6*(row - block->FirstRow + 1)/numRows);
+      }
+    }
+
+  // The parents are smaller labels, so they are resolved first.
+  vtkIdType numLabels = static_cast<vtkIdType>(block->Parents.size());
+  for (vtkIdType label = 1; label < numLabels; label++)
+    {
+    block->Parents[label] = block->Parents[block->Parents[label]];
+    }
+}
+
+//----------------------------------------------------------------------------
+// Find the pairs of provisional labels that touch between the first rows
+// of a block and the blocks before.
+template <class IT, class OT>
+void vtkImageConnectedComponentsBlockPairs(
+  vtkImageConnectedComponentsStruct *ts, int blockId, IT *inPtr, OT *outPtr)
+{
+  vtkImageConnectedComponentsBlock *block = &ts->Blocks[blockId];
+  int nx = ts->Dimensions[0];
+  int ny = ts->Dimensions[1];
+  vtkIdType inInc0 = ts->InIncrements[0];
+  int separate = ts->SeparateValues;
+  vtkImageConnectedComponentsNeighbor neighbors[13];
+  block->Pairs.clear();
+
+  // the neighbors are at most one slice and one row before
+  vtkIdType endRow = block->FirstRow + ny + 1;
+  endRow = (endRow < block->EndRow ? endRow : block->EndRow);
+  for (vtkIdType row = block->FirstRow; row < endRow; row++)
+    {
+    int numNeighbors = vtkImageConnectedComponentsRowNeighbors(
+      ts, row, 0, block->FirstRow, neighbors);
+    int j = static_cast<int>(row % ny);
+    int k = static_cast<int>(row / ny);
+    IT *inRow = inPtr + j*ts->InIncrements[1] + k*ts->InIncrements[2];
+    OT *outRow = outPtr + row*nx;
+    for (int m = 0; m < numNeighbors; m++)
+      {
+      vtkIdType neighborRow = row + (neighbors[m].OutOffset -
+                                     neighbors[m].Dx)/nx;
+      int neighborBlockId = blockId - 1;
+      while (ts->Blocks[neighborBlockId].FirstRow > neighborRow)
+        {
+        neighborBlockId--;
+        }
+      vtkImageConnectedComponentsBlock *neighborBlock =
+        &ts->Blocks[neighborBlockId];
+      vtkIdType lastA = 0;
+      vtkIdType lastB = 0;
+      for (int i = 0; i < nx; i++)
+        {
+        int ii = i + neighbors[m].Dx;
+        vtkIdType label = outRow[i];
+        if (label == 0 || ii < 0 || ii >= nx)
+          {
+          continue;
+          }
+        vtkIdType neighborLabel = outRow[i + neighbors[m].OutOffset];
+        if (neighborLabel == 0 ||
+            (separate && inRow[i*inInc0 + neighbors[m].InOffset] !=
+             inRow[i*inInc0]))
+          {
+          continue;
+          }
+        vtkIdType a = block->Offset + block->Parents[label];
+        vtkIdType b = neighborBlock->Offset +
+          neighborBlock->Parents[neighborLabel];
+        if (a != lastA || b != lastB)
+          {
+          block->Pairs.push_back(a);
+          block->Pairs.push_back(b);
+          lastA = a;
+          lastB = b;
+          }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Replace the provisional labels of a block by the final labels.
+template <class PT, class OT>
+void vtkImageConnectedComponentsRelabelBlock(
+  vtkImageConnectedComponentsStruct *ts,
+  vtkImageConnectedComponentsBlock *block, const PT *provPtr, OT *outPtr,
+  int report)
+{
+  int nx = ts->Dimensions[0];
+  const vtkIdType *labels = &ts->Labels[block->Offset];
+  vtkIdType numRows = block->EndRow - block->FirstRow;
+  vtkIdType progressStep = numRows/20 + 1;
+  for (vtkIdType row = block->FirstRow; row < block->EndRow; row++)
+    {
+    const PT *provRow = provPtr + row*nx;
+    OT *outRow = outPtr + row*nx;
+    for (int i = 0; i < nx; i++)
+      {
+      outRow[i] = (provRow[i] != 0 ?
+                   static_cast<OT>(labels[provRow[i]]) : 0);
+      }
+    if (report && (row - block->FirstRow + 1) % progressStep == 0)
+      {
+      ts->Filter->UpdateProgress(
+        0.7 + 0.3*(row - block->FirstRow + 1)/numRows);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+template <class IT, class OT>
+void vtkImageConnectedComponentsExecuteBlock(
+  vtkImageConnectedComponentsStruct *ts, int blockId, IT *inPtr, OT *outPtr,
+  int report)
+{
+  vtkImageConnectedComponentsBlock *block = &ts->Blocks[blockId];
+  if (ts->Pass == 0)
+    {
+    vtkImageConnectedComponentsLabelBlock(ts, block, inPtr, outPtr, report);
+    }
+  else if (ts->Pass == 1)
+    {
+    if (blockId > 0)
+      {
+      vtkImageConnectedComponentsBlockPairs(ts, blockId, inPtr, outPtr);
+      }
+    }
+  else if (ts->LabelPtr == ts->OutPtr)
+    {
+    vtkImageConnectedComponentsRelabelBlock(ts, block, outPtr, outPtr,
+                                            report);
+    }
+  else
+    {
+    vtkImageConnectedComponentsRelabelBlock(
+      ts, block, outPtr, static_cast<vtkIdType *>(ts->LabelPtr), report);
+    }
+}
+
+template <class IT>
+void vtkImageConnectedComponentsDispatch(
+  vtkImageConnectedComponentsStruct *ts, int blockId, IT *inPtr, int report)
+{
+  if (ts->OutputScalarType == VTK_INT)
+    {
+    vtkImageConnectedComponentsExecuteBlock(
+      ts, blockId, inPtr, static_cast<int *>(ts->OutPtr), report);
+    }
+  else
+    {
+    vtkImageConnectedComponentsExecuteBlock(
+      ts, blockId, inPtr, static_cast<vtkIdType *>(ts->OutPtr), report);
+    }
+}
+
+//----------------------------------------------------------------------------
+// Execute the pass for the blocks of the thread.
+static VTK_THREAD_RETURN_TYPE vtkImageConnectedComponentsThread(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkImageConnectedComponentsStruct *ts =
+    static_cast<vtkImageConnectedComponentsStruct *>(info->UserData);
+  int threadId = info->ThreadID;
+  int numBlocks = static_cast<int>(ts->Blocks.size());
+
+  for (int blockId = threadId;
+       blockId < numBlocks && !ts->Filter->GetAbortExecute();
+       blockId += ts->NumberOfThreads)
+    {
+    int report = (blockId == 0);
+    switch (ts->InputScalarType)
+      {
+      vtkTemplateMacro(
+        vtkImageConnectedComponentsDispatch(
+          ts, blockId, static_cast<VTK_TT *>(ts->InPtr), report));
+      }
+    }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+// The blocks are labeled and paired in parallel, the pairs are merged and
+// the final labels and statistics computed serially, over the provisional
+// labels only, and the final labels are written in parallel.
+int vtkImageConnectedComponents::RequestData(
+  vtkInformation *vtkNotUsed(request),
+  vtkInformationVector **inputVector,
+  vtkInformationVector *outputVector)
+{
+  vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
+  vtkImageData *inData = vtkImageData::SafeDownCast(
+    inInfo->Get(vtkDataObject::DATA_OBJECT()));
+  vtkInformation *outInfo = outputVector->GetInformationObject(0);
+  vtkImageData *outData = vtkImageData::SafeDownCast(
+    outInfo->Get(vtkDataObject::DATA_OBJECT()));
+
+  this->NumberOfLabels = 0;
+  this->LabelSizes->Initialize();
+  this->LabelExtents->Initialize();
+  this->LabelExtents->SetNumberOfComponents(6);
+
+  if (this->OutputScalarType != VTK_INT &&
+      this->OutputScalarType != VTK_ID_TYPE)
+    {
+    vtkErrorMacro("Execute: OutputScalarType must be VTK_INT or "
+                  "VTK_ID_TYPE.");
+    return 1;
+    }
+  if (this->Connectivity != 6 && this->Connectivity != 18 &&
+      this->Connectivity != 26)
+    {
+    vtkErrorMacro("Execute: Connectivity must be 6, 18 or 26.");
+    return 1;
+    }
+
+  outData->SetExtent(outData->GetWholeExtent());
+  outData->AllocateScalars();
+
+  vtkImageConnectedComponentsStruct ts;
+  outData->GetExtent(ts.Extent);
+  outData->GetDimensions(ts.Dimensions);
+  vtkIdType numRows =
+    static_cast<vtkIdType>(ts.Dimensions[1])*ts.Dimensions[2];
+  if (ts.Dimensions[0] <= 0 || numRows <= 0)
+    {
+    return 1;
+    }
+
+  vtkDataArray *inArray = this->GetInputArrayToProcess(0, inputVector);
+  if (!inArray)
+    {
+    vtkErrorMacro("Execute: No scalars to label.");
+    return 1;
+    }
+  ts.Filter = this;
+  ts.InPtr = inData->GetArrayPointerForExtent(inArray, ts.Extent);
+  ts.InputScalarType = inArray->GetDataType();
+  inData->GetArrayIncrements(inArray, ts.InIncrements);
+  ts.OutPtr = outData->GetScalarPointer();
+  ts.OutputScalarType = this->OutputScalarType;
+  ts.LabelPtr = ts.OutPtr;
+  ts.SeparateValues = this->SeparateValues;
+
+  // The neighbors before each voxel along the rows.
+  ts.NumberOfNeighbors = 0;
+  for (int dz = -1; dz <= 0; dz++)
+    {
+    for (int dy = -1; dy <= (dz < 0 ? 1 : 0); dy++)
+      {
+      for (int dx = -1; dx <= (dz < 0 || dy < 0 ? 1 : -1); dx++)
+        {
+        int distance = (dx != 0) + (dy != 0) + (dz != 0);
+        if ((distance == 1) ||
+            (distance == 2 && this->Connectivity >= 18) ||
+            (distance == 3 && this->Connectivity == 26))
+          {
+          // also a neighbor of the previous voxel, at (-1, 0, 0)?
+          int d = (dx + 1 != 0) + (dy != 0) + (dz != 0);
+          ts.NextToPrevious[ts.NumberOfNeighbors] = (dx + 1 <= 1) &&
+            ((d <= 1) || (d == 2 && this->Connectivity >= 18) ||
+             (d == 3 && this->Connectivity == 26));
+          int *delta = ts.Neighbors[ts.NumberOfNeighbors++];
+          delta[0] = dx;
+          delta[1] = dy;
+          delta[2] = dz;
+          }
+        }
+      }
+    }
+
+  // One block per thread, unless the provisional labels of the blocks
+  // would not fit in ints.
+  int numThreads = this->NumberOfThreads;
+  int maxThreads = vtkMultiThreader::GetGlobalMaximumNumberOfThreads();
+  if (maxThreads > 0 && numThreads > maxThreads)
+    {
+    numThreads = maxThreads;
+    }
+  if (numThreads > numRows)
+    {
+    numThreads = static_cast<int>(numRows);
+    }
+  ts.NumberOfThreads = (numThreads < 1 ? 1 : numThreads);
+  vtkIdType rowsPerBlock = VTK_CONNECTED_COMPONENTS_MAX_BLOCK/ts.Dimensions[0];
+  rowsPerBlock = (rowsPerBlock < 1 ? 1 : rowsPerBlock);
+  vtkIdType numBlocks = (numRows + rowsPerBlock - 1)/rowsPerBlock;
+  numBlocks = (numBlocks > ts.NumberOfThreads ? numBlocks :
+               ts.NumberOfThreads);
+  ts.Blocks.resize(numBlocks);
+  for (vtkIdType b = 0; b < numBlocks; b++)
+    {
+    ts.Blocks[b].FirstRow = numRows*b/numBlocks;
+    ts.Blocks[b].EndRow = numRows*(b + 1)/numBlocks;
+    }
+
+  this->Threader->SetNumberOfThreads(ts.NumberOfThreads);
+  this->Threader->SetSingleMethod(vtkImageConnectedComponentsThread, &ts);
+  ts.Pass = 0;
+  this->Threader->SingleMethodExecute();
+  if (this->AbortExecute)
+    {
+    return 1;
+    }
+
+  vtkIdType numProvisional = 0;
+  vtkIdType b;
+  for (b = 0; b < numBlocks; b++)
+    {
+    ts.Blocks[b].Offset = numProvisional;
+    numProvisional += static_cast<vtkIdType>(ts.Blocks[b].Parents.size()) - 1;
+    }
+  ts.Pass = 1;
+  this->Threader->SingleMethodExecute();
+
+  // Merge the provisional labels of all blocks, from 1 on.
+  vtkstd::vector<vtkIdType> parents(numProvisional + 1);
+  parents[0] = 0;
+  for (b = 0; b < numBlocks; b++)
+    {
+    vtkImageConnectedComponentsBlock *block = &ts.Blocks[b];
+    vtkIdType n = static_cast<vtkIdType>(block->Parents.size());
+    for (vtkIdType label = 1; label < n; label++)
+      {
+      parents[block->Offset + label] = block->Offset + block->Parents[label];
+      }
+    }
+  for (b = 0; b < numBlocks; b++)
+    {
+    vtkstd::vector<vtkIdType> &pairs = ts.Blocks[b].Pairs;
+    for (size_t p = 0; p < pairs.size(); p += 2)
+      {
+      vtkImageConnectedComponentsUnion(&parents[0], pairs[p], pairs[p+1]);
+      }
+    vtkstd::vector<vtkIdType>().swap(pairs);
+    }
+
+  // The roots are the first labels of their regions, so the final labels
+  // are numbered in order, and the other labels follow their parents.
+  ts.Labels.resize(numProvisional + 1);
+  ts.Labels[0] = 0;
+  vtkIdType numLabels = 0;
+  for (vtkIdType label = 1; label <= numProvisional; label++)
+    {
+    vtkIdType parent = parents[label];
+    ts.Labels[label] = (parent == label ? ++numLabels : ts.Labels[parent]);
+    }
+  vtkstd::vector<vtkIdType>().swap(parents);
+
+  // The provisional labels of the blocks fit in ints, but the final labels
+  // may not: they are then written to a new array of vtkIdType.
+  vtkIdTypeArray *idLabels = NULL;
+  if (this->OutputScalarType == VTK_INT && numLabels > VTK_INT_MAX)
+    {
+    vtkDebugMacro("Execute: " << numLabels << " regions do not fit in "
+                  "ints, the labels are of type vtkIdType.");
+    idLabels = vtkIdTypeArray::New();
+    idLabels->SetNumberOfTuples(numRows*ts.Dimensions[0]);
+    ts.LabelPtr = idLabels->GetPointer(0);
+    }
+
+  this->NumberOfLabels = numLabels;
+  this->LabelSizes->SetNumberOfTuples(numLabels);
+  this->LabelExtents->SetNumberOfTuples(numLabels);
+  vtkIdType *sizes = this->LabelSizes->GetPointer(0);
+  int *extents = this->LabelExtents->GetPointer(0);
+  for (vtkIdType label = 0; label < numLabels; label++)
+    {
+    sizes[label] = 0;
+    int *extent = extents + 6*label;
+    extent[0] = extent[2] = extent[4] = VTK_INT_MAX;
+    extent[1] = extent[3] = extent[5] = VTK_INT_MIN;
+    }
+  for (b = 0; b < numBlocks; b++)
+    {
+    vtkImageConnectedComponentsBlock *block = &ts.Blocks[b];
+    vtkIdType n = static_cast<vtkIdType>(block->Parents.size());
+    for (vtkIdType label = 1; label < n; label++)
+      {
+      vtkIdType index = ts.Labels[block->Offset + label] - 1;
+      sizes[index] += block->Counts[label];
+      const int *blockExtent = &block->Extents[6*label];
+      int *extent = extents + 6*index;
+      for (int axis = 0; axis < 3; axis++)
+        {
+        int lo = blockExtent[2*axis] + ts.Extent[2*axis];
+        int hi = blockExtent[2*axis+1] + ts.Extent[2*axis];
+        extent[2*axis] = (lo < extent[2*axis] ? lo : extent[2*axis]);
+        extent[2*axis+1] = (hi > extent[2*axis+1] ? hi : extent[2*axis+1]);
+        }
+      }
+    vtkstd::vector<vtkIdType>().swap(block->Parents);
+    vtkstd::vector<vtkIdType>().swap(block->Counts);
+    vtkstd::vector<int>().swap(block->Extents);
+    }
+  this->UpdateProgress(0.7);
+
+  ts.Pass = 2;
+  this->Threader->SingleMethodExecute();
+
+  if (idLabels)
+    {
+    vtkDataArray *scalars = outData->GetPointData()->GetScalars();
+    idLabels->SetName(scalars->GetName());
+    outData->GetPointData()->SetScalars(idLabels);
+    outData->SetScalarType(VTK_ID_TYPE);
+    idLabels->Delete();
+    }
+
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageConnectedComponents::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "Connectivity: " << this->Connectivity << "\n";
+  os << indent << "SeparateValues: "
+     << (this->SeparateValues ? "On\n" : "Off\n");
+  os << indent << "OutputScalarType: " << this->OutputScalarType << "\n";
+  os << indent << "NumberOfLabels: " << this->NumberOfLabels << "\n";
+  os << indent << "LabelSizes: " << this->LabelSizes << "\n";
+  os << indent << "LabelExtents: " << this->LabelExtents << "\n";
+}
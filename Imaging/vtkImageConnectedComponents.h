@@ -0,0 +1,118 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    vtkImageConnectedComponents.h
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// .NAME vtkImageConnectedComponents - Label the connected regions of an image.
+// .SECTION Description
+// vtkImageConnectedComponents gives every connected region of non-zero
+// voxels of its input a label, from 1 on in the order of the first voxel
+// of each region along the rows, and the background the label 0.  Voxels
+// are neighbors when they share a face (6-connectivity), a face or an edge
+// (18-connectivity) or any corner (26-connectivity); in 2D images these
+// are the 4 and the 8-connectivities.  When SeparateValues is on, only
+// neighbors of equal values are connected, so that each region of a
+// segmentation with several labels is labeled separately.
+//
+// The whole image is labeled at once by threads, each of which labels
+// blocks of rows with provisional labels whose equivalences are kept in
+// a union-find forest.  The provisional labels that touch across blocks
+// are then merged, and the final labels replace them.  The number of
+// voxels and the extent of each region are computed at the same time.
+//
+// The labels are ints, unless the output scalar type is set to vtkIdType
+// or there are more regions than ints can label, in which case the labels
+// are vtkIdTypes.  Only the first component of the input is considered.
+// .SECTION see also
+// vtkImageSeedConnectivity vtkImageIslandRemoval2D
+
+#ifndef __vtkImageConnectedComponents_h
+#define __vtkImageConnectedComponents_h
+
+#include "vtkThreadedImageAlgorithm.h"
+
+class vtkIdTypeArray;
+class vtkIntArray;
+
+class VTK_IMAGING_EXPORT vtkImageConnectedComponents :
+  public vtkThreadedImageAlgorithm
+{
+public:
+  static vtkImageConnectedComponents *New();
+  vtkTypeMacro(vtkImageConnectedComponents,vtkThreadedImageAlgorithm);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  // Description:
+  // Set/Get the connectivity of the voxels: 6, 18 or 26.  Initial value
+  // is 6.
+  vtkSetMacro(Connectivity, int);
+  vtkGetMacro(Connectivity, int);
+  void SetConnectivityTo6() { this->SetConnectivity(6); }
+  void SetConnectivityTo18() { this->SetConnectivity(18); }
+  void SetConnectivityTo26() { this->SetConnectivity(26); }
+
+  // Description:
+  // Connect only the neighbors of equal values.  Initial value is off.
+  vtkSetMacro(SeparateValues, int);
+  vtkGetMacro(SeparateValues, int);
+  vtkBooleanMacro(SeparateValues, int);
+
+  // Description:
+  // Set/Get the scalar type of the labels: VTK_INT or VTK_ID_TYPE.
+  // Initial value is VTK_INT.  The labels are of type VTK_ID_TYPE anyway
+  // when there are more than VTK_INT_MAX regions.
+  vtkSetMacro(OutputScalarType, int);
+  vtkGetMacro(OutputScalarType, int);
+  void SetOutputScalarTypeToInt() {this->SetOutputScalarType(VTK_INT);}
+  void SetOutputScalarTypeToIdType()
+    {this->SetOutputScalarType(VTK_ID_TYPE);}
+
+  // Description:
+  // Get the number of regions labeled by the last execution.
+  vtkGetMacro(NumberOfLabels, vtkIdType);
+
+  // Description:
+  // Get the number of voxels of each region: tuple i is for label i+1.
+  vtkIdTypeArray *GetLabelSizes() { return this->LabelSizes; }
+
+  // Description:
+  // Get the extent (xmin, xmax, ymin, ymax, zmin, zmax) of each region:
+  // tuple i is for label i+1.
+  vtkIntArray *GetLabelExtents() { return this->LabelExtents; }
+
+protected:
+  vtkImageConnectedComponents();
+  ~vtkImageConnectedComponents();
+
+  int Connectivity;
+  int SeparateValues;
+  int OutputScalarType;
+  vtkIdType NumberOfLabels;
+  vtkIdTypeArray *LabelSizes;
+  vtkIntArray *LabelExtents;
+
+  virtual int RequestInformation(vtkInformation *,
+                                 vtkInformationVector **,
+                                 vtkInformationVector *);
+  virtual int RequestUpdateExtent(vtkInformation *,
+                                  vtkInformationVector **,
+                                  vtkInformationVector *);
+  virtual int RequestData(vtkInformation *,
+                          vtkInformationVector **,
+                          vtkInformationVector *);
+
+private:
+  vtkImageConnectedComponents(const vtkImageConnectedComponents&);  // Not implemented.
+  void operator=(const vtkImageConnectedComponents&);  // Not implemented.
+};
+
+#endif
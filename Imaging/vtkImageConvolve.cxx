@@ -41,6 +41,9 @@ vtkImageConvolve::vtkImageConvolve()
     }
   kernel[4] = 1.0; 
   this->SetKernel3x3(kernel);
+
+  // Blocks keep the neighborhoods of the kernel in cache.
+  this->SplitMode = VTK_IMAGE_SPLIT_BLOCK;
 }
 
 //----------------------------------------------------------------------------
@@ -355,7 +358,7 @@ void vtkImageConvolveExecute(vtkImageConvolve *self,
            outIdx1 <= outMax1 && !self->AbortExecute; 
            ++outIdx1)
         {
-        if (!id)
+        if (!id && self->GetSplitMode() == VTK_IMAGE_SPLIT_SLAB)
           {
           if (!(count%target))
             {
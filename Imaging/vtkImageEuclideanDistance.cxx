@@ -14,12 +14,18 @@
 =========================================================================*/
 #include "vtkImageEuclideanDistance.h"
 
+#include "vtkDoubleArray.h"
+#include "vtkIdTypeArray.h"
 #include "vtkImageData.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
+#include "vtkPointData.h"
 #include "vtkStreamingDemandDrivenPipeline.h"
 
+#include <vtkstd/vector>
+
 #include <math.h>
 
 vtkStandardNewMacro(vtkImageEuclideanDistance);
@@ -32,6 +38,8 @@ vtkImageEuclideanDistance::vtkImageEuclideanDistance()
   this->Initialize = 1;
   this->ConsiderAnisotropy = 1;
   this->Algorithm = VTK_EDT_SAITO;
+  this->SignedDistance = 0;
+  this->ComputeFeatureIndices = 0;
 }
 
 //----------------------------------------------------------------------------
@@ -554,6 +562,399 @@ void vtkImageEuclideanDistanceExecuteSaitoCached(
   free(temp);
   free(sq);
 }
+
+//----------------------------------------------------------------------------
+// The linear algorithm transforms the rows along the axis of the iteration
+// one after the other, the distances and feature indices of the voxels
+// outside the objects, and of the voxels inside them for signed distances.
+// The rows are copied to contiguous buffers by beams of neighbors, so that
+// the rows along the slower axes are read and written a cache line at a
+// time.
+#define VTK_EDT_LINEAR_BEAM_WIDTH 16
+
+namespace
+{
+struct vtkImageEuclideanDistanceLinearStruct
+{
+  vtkImageEuclideanDistance *Filter;
+  int NumberOfTransforms;
+  double *Inputs[2];
+  double *Distances[2];
+  vtkIdType *Features[2];
+  int Length;
+  vtkIdType Increment;
+  int RowsPerOuter;
+  int RowsPerBeam;
+  int BeamsPerOuter;
+  vtkIdType RowIncrement;
+  vtkIdType OuterIncrement;
+  vtkIdType NumberOfBeams;
+  double SquaredSpacing;
+  double MaximumDistance;
+  int NumberOfThreads;
+};
+}
+
+//----------------------------------------------------------------------------
+// Computes the squared distances d of a row of n voxels as the lower
+// envelope of the parabolas f[q] + s2*(p - q)^2, as in Felzenszwalb and
+// Huttenlocher. The distances of maxDist or more have no parabola. The
+// feature indices feat, if any, are those g of the parabolas. The buffers
+// v, zn and zd hold n values.
+static void vtkImageEuclideanDistanceLinearRow(const double *f,
+                                               const vtkIdType *g, int n,
+                                               double s2, double maxDist,
+                                               int *v, double *zn, double *zd,
+                                               double *d, vtkIdType *feat)
+{
+  // When the distances are only zeros and maxDist, as they are along the
+  // first axis, each voxel takes the nearest zero on either side.
+  int q;
+  for (q = 0; q < n && (f[q] == 0 || f[q] >= maxDist); q++)
+    {
+    }
+  if (q == n)
+    {
+    int left = -1;
+    for (q = 0; q < n; q++)
+      {
+      left = (f[q] == 0 ? q : left);
+      v[q] = left;
+      }
+    int right = -1;
+    for (int p = n - 1; p >= 0; p--)
+      {
+      right = (f[p] == 0 ? p : right);
+      int r = v[p];
+      if (r < 0 || (right >= 0 && right - p < p - r))
+        {
+        r = right;
+        }
+      double dp = (r < 0 ? maxDist : s2*(p - r)*(p - r));
+      d[p] = (dp < maxDist ? dp : maxDist);
+      if (feat)
+        {
+        feat[p] = (dp < maxDist && g ? g[r] : -1);
+        }
+      }
+    return;
+    }
+
+  // The parabola v[k] is the lowest from zn[k]/zd[k] on. The fractions are
+  // compared without dividing, and the first one is minus infinity.
+  int k = -1;
+  double num = -1.0;
+  double den = 0.0;
+  for (q = 0; q < n; q++)
+    {
+    if (f[q] >= maxDist)
+      {
+      continue;
+      }
+    double fq = f[q] + s2*q*q;
+    while (k >= 0)
+      {
+      int r = v[k];
+      num = fq - (f[r] + s2*r*r);
+      den = 2*s2*(q - r);
+      if (num*zd[k] > zn[k]*den)
+        {
+        break;
+        }
+      k--;
+      }
+    if (k < 0)
+      {
+      num = -1.0;
+      den = 0.0;
+      }
+    v[++k] = q;
+    zn[k] = num;
+    zd[k] = den;
+    }
+
+  int j = 0;
+  for (int p = 0; p < n; p++)
+    {
+    double dist = maxDist;
+    vtkIdType id = -1;
+    if (k >= 0)
+      {
+      while (j < k && zn[j+1] < p*zd[j+1])
+        {
+        j++;
+        }
+      int r = v[j];
+      double dp = f[r] + s2*(p - r)*(p - r);
+      if (dp < maxDist)
+        {
+        dist = dp;
+        id = (g ? g[r] : -1);
+        }
+      }
+    d[p] = dist;
+    if (feat)
+      {
+      feat[p] = id;
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Copy a beam of rows of n values, inc apart along the rows and rowInc
+// apart across them, to or from a buffer of consecutive rows.
+template <class T>
+void vtkImageEuclideanDistanceLoadBeam(const T *ptr, vtkIdType inc,
+                                       vtkIdType rowInc, int n, int rows,
+                                       T *buffer)
+{
+  for (int q = 0; q < n; q++)
+    {
+    const T *rowPtr = ptr + q*inc;
+    for (int b = 0; b < rows; b++)
+      {
+      buffer[b*n + q] = rowPtr[b*rowInc];
+      }
+    }
+}
+
+template <class T>
+void vtkImageEuclideanDistanceStoreBeam(const T *buffer, int n, int rows,
+                                        T *ptr, vtkIdType inc,
+                                        vtkIdType rowInc)
+{
+  for (int q = 0; q < n; q++)
+    {
+    T *rowPtr = ptr + q*inc;
+    for (int b = 0; b < rows; b++)
+      {
+      rowPtr[b*rowInc] = buffer[b*n + q];
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Transform a contiguous range of beams of rows along the axis.
+static VTK_THREAD_RETURN_TYPE vtkImageEuclideanDistanceLinearThread(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkImageEuclideanDistanceLinearStruct *ts =
+    static_cast<vtkImageEuclideanDistanceLinearStruct *>(info->UserData);
+  int threadId = info->ThreadID;
+  vtkIdType begin = ts->NumberOfBeams*threadId/ts->NumberOfThreads;
+  vtkIdType end = ts->NumberOfBeams*(threadId + 1)/ts->NumberOfThreads;
+
+  int n = ts->Length;
+  int size = n*ts->RowsPerBeam;
+  vtkstd::vector<double> f(size);
+  vtkstd::vector<double> d(size);
+  vtkstd::vector<vtkIdType> g(size);
+  vtkstd::vector<vtkIdType> feat(size);
+  vtkstd::vector<int> v(n);
+  vtkstd::vector<double> zn(n);
+  vtkstd::vector<double> zd(n);
+
+  for (vtkIdType beam = begin;
+       beam < end && !ts->Filter->GetAbortExecute(); beam++)
+    {
+    int firstRow = static_cast<int>(beam % ts->BeamsPerOuter)*ts->RowsPerBeam;
+    int rows = ts->RowsPerOuter - firstRow;
+    rows = (rows < ts->RowsPerBeam ? rows : ts->RowsPerBeam);
+    vtkIdType offset = firstRow*ts->RowIncrement +
+      (beam / ts->BeamsPerOuter)*ts->OuterIncrement;
+    for (int i = 0; i < ts->NumberOfTransforms; i++)
+      {
+      vtkIdType *features = ts->Features[i];
+      vtkImageEuclideanDistanceLoadBeam(ts->Inputs[i] + offset,
+                                        ts->Increment, ts->RowIncrement,
+                                        n, rows, &f[0]);
+      if (features)
+        {
+        vtkImageEuclideanDistanceLoadBeam(features + offset, ts->Increment,
+                                          ts->RowIncrement, n, rows, &g[0]);
+        }
+      for (int b = 0; b < rows; b++)
+        {
+        vtkImageEuclideanDistanceLinearRow(
+          &f[b*n], (features ? &g[b*n] : 0), n, ts->SquaredSpacing,
+          ts->MaximumDistance, &v[0], &zn[0], &zd[0], &d[b*n], &feat[b*n]);
+        }
+      vtkImageEuclideanDistanceStoreBeam(&d[0], n, rows,
+                                         ts->Distances[i] + offset,
+                                         ts->Increment, ts->RowIncrement);
+      if (features)
+        {
+        vtkImageEuclideanDistanceStoreBeam(&feat[0], n, rows,
+                                           features + offset, ts->Increment,
+                                           ts->RowIncrement);
+        }
+      }
+    }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+// The distances inPtr, of the output or of the previous iteration, are
+// transformed into the output. The arrays of the inside distances and of
+// the feature indices are created by the first iteration and passed along
+// by the others, and the last one merges the inside distances into the
+// output for signed distances.
+void vtkImageEuclideanDistance::ExecuteLinear(vtkImageData *inData,
+                                              double *inPtr,
+                                              vtkImageData *outData)
+{
+  vtkPointData *outPD = outData->GetPointData();
+  double *distances = static_cast<double *>(outData->GetScalarPointer());
+  vtkIdType numPts = outData->GetNumberOfPoints();
+  double maxDist = this->MaximumDistance;
+  int computeFeatures = (this->ComputeFeatureIndices != 0);
+  int signedDistance = (this->SignedDistance != 0);
+
+  vtkDoubleArray *inside = 0;
+  vtkIdTypeArray *features = 0;
+  vtkIdTypeArray *insideFeatures = 0;
+  vtkIdType ptId;
+  if (this->Iteration == 0)
+    {
+    if (signedDistance)
+      {
+      inside = vtkDoubleArray::New();
+      inside->SetName("InsideDistances");
+      inside->SetNumberOfTuples(numPts);
+      for (ptId = 0; ptId < numPts; ptId++)
+        {
+        inside->SetValue(ptId, (distances[ptId] == 0 ? maxDist : 0.0));
+        }
+      outPD->AddArray(inside);
+      inside->Delete();
+      }
+    for (int i = 0; i < 1 + signedDistance && computeFeatures; i++)
+      {
+      double *d = (i == 0 ? distances : inside->GetPointer(0));
+      vtkIdTypeArray *array = vtkIdTypeArray::New();
+      array->SetName(i == 0 ? "FeatureIndices" : "InsideFeatureIndices");
+      array->SetNumberOfTuples(numPts);
+      for (ptId = 0; ptId < numPts; ptId++)
+        {
+        array->SetValue(ptId, (d[ptId] < maxDist ? ptId : -1));
+        }
+      outPD->AddArray(array);
+      array->Delete();
+      }
+    }
+  else if (inData != outData)
+    {
+    vtkPointData *inPD = inData->GetPointData();
+    const char *names[3] =
+      {"InsideDistances", "FeatureIndices", "InsideFeatureIndices"};
+    for (int i = 0; i < 3; i++)
+      {
+      if (inPD->GetArray(names[i]))
+        {
+        outPD->AddArray(inPD->GetArray(names[i]));
+        }
+      }
+    }
+  if (signedDistance)
+    {
+    inside = vtkDoubleArray::SafeDownCast(outPD->GetArray("InsideDistances"));
+    }
+  if (computeFeatures)
+    {
+    features =
+      vtkIdTypeArray::SafeDownCast(outPD->GetArray("FeatureIndices"));
+    if (signedDistance)
+      {
+      insideFeatures = vtkIdTypeArray::SafeDownCast(
+        outPD->GetArray("InsideFeatureIndices"));
+      }
+    }
+  if ((signedDistance && !inside) || (computeFeatures && !features) ||
+      (computeFeatures && signedDistance && !insideFeatures))
+    {
+    vtkErrorMacro(<< "Execute: Missing arrays of the previous iteration.");
+    return;
+    }
+
+  vtkImageEuclideanDistanceLinearStruct ts;
+  ts.Filter = this;
+  ts.NumberOfTransforms = 1 + signedDistance;
+  ts.Inputs[0] = inPtr;
+  ts.Inputs[1] = (inside ? inside->GetPointer(0) : 0);
+  ts.Distances[0] = distances;
+  ts.Distances[1] = (inside ? inside->GetPointer(0) : 0);
+  ts.Features[0] = (features ? features->GetPointer(0) : 0);
+  ts.Features[1] = (insideFeatures ? insideFeatures->GetPointer(0) : 0);
+  ts.MaximumDistance = maxDist;
+
+  // The rows are along the axis of the iteration, and ordered like the
+  // voxels along the two other axes. The rows along x are contiguous, and
+  // are not gathered in beams.
+  int axis = this->Iteration;
+  int rowAxis = (axis == 0 ? 1 : 0);
+  int outerAxis = 3 - axis - rowAxis;
+  int dims[3];
+  outData->GetDimensions(dims);
+  vtkIdType *incs = outData->GetIncrements();
+  ts.Length = dims[axis];
+  ts.Increment = incs[axis];
+  ts.RowsPerOuter = dims[rowAxis];
+  ts.RowIncrement = incs[rowAxis];
+  ts.OuterIncrement = incs[outerAxis];
+  ts.RowsPerBeam = (axis == 0 ? 1 : VTK_EDT_LINEAR_BEAM_WIDTH);
+  ts.RowsPerBeam = (ts.RowsPerBeam < dims[rowAxis] ? ts.RowsPerBeam :
+                    dims[rowAxis]);
+  ts.BeamsPerOuter = (dims[rowAxis] + ts.RowsPerBeam - 1)/ts.RowsPerBeam;
+  ts.NumberOfBeams = static_cast<vtkIdType>(ts.BeamsPerOuter)*dims[outerAxis];
+
+  double spacing = 1.0;
+  if (this->ConsiderAnisotropy)
+    {
+    spacing = outData->GetSpacing()[axis];
+    }
+  ts.SquaredSpacing = spacing*spacing;
+
+  int numThreads = this->NumberOfThreads;
+  int maxThreads = vtkMultiThreader::GetGlobalMaximumNumberOfThreads();
+  if (maxThreads > 0 && numThreads > maxThreads)
+    {
+    numThreads = maxThreads;
+    }
+  if (numThreads > ts.NumberOfBeams)
+    {
+    numThreads = static_cast<int>(ts.NumberOfBeams);
+    }
+  ts.NumberOfThreads = (numThreads < 1 ? 1 : numThreads);
+
+  if (ts.Length > 0 && ts.NumberOfBeams > 0)
+    {
+    this->Threader->SetNumberOfThreads(ts.NumberOfThreads);
+    this->Threader->SetSingleMethod(vtkImageEuclideanDistanceLinearThread,
+                                    &ts);
+    this->Threader->SingleMethodExecute();
+    }
+
+  // The voxels of the objects get minus their distance to the outside.
+  if (this->Iteration == this->NumberOfIterations - 1 && signedDistance)
+    {
+    double *insideDistances = inside->GetPointer(0);
+    for (ptId = 0; ptId < numPts; ptId++)
+      {
+      if (distances[ptId] == 0)
+        {
+        distances[ptId] = -insideDistances[ptId];
+        if (features)
+          {
+          features->SetValue(ptId, insideFeatures->GetValue(ptId));
+          }
+        }
+      }
+    outPD->RemoveArray("InsideDistances");
+    outPD->RemoveArray("InsideFeatureIndices");
+    }
+}
 //----------------------------------------------------------------------------
 void vtkImageEuclideanDistance::AllocateOutputScalars(vtkImageData *outData)
 {
@@ -611,6 +1012,26 @@ int vtkImageEuclideanDistance::IterativeRequestData(
     return 1;
     }
   
+  // The options of the linear algorithm are not supported by the others.
+  int algorithm = this->Algorithm;
+  if (this->SignedDistance || this->ComputeFeatureIndices)
+    {
+    algorithm = VTK_EDT_LINEAR;
+    }
+
+  // Remove the arrays left by previous executions with other options.
+  vtkPointData *outPD = outData->GetPointData();
+  if (algorithm != VTK_EDT_LINEAR || !this->ComputeFeatureIndices)
+    {
+    outPD->RemoveArray("FeatureIndices");
+    }
+  if (algorithm != VTK_EDT_LINEAR || !this->SignedDistance)
+    {
+    outPD->RemoveArray("InsideDistances");
+    outPD->RemoveArray("InsideFeatureIndices");
+    }
+
+  double *linearInPtr = static_cast<double *>(outPtr);
   if ( this->GetIteration() == 0 )
     {
     switch (inData->GetScalarType())
@@ -626,6 +1047,15 @@ int vtkImageEuclideanDistance::IterativeRequestData(
         return 1;
       } 
     } 
+  else if ( algorithm == VTK_EDT_LINEAR &&
+            inData->GetScalarType() == VTK_DOUBLE &&
+            inData->GetNumberOfScalarComponents() == 1 &&
+            memcmp(inData->GetExtent(), outExt, 6*sizeof(int)) == 0 )
+    {
+    // The linear algorithm reads the distances of the previous iteration
+    // itself.
+    linearInPtr = static_cast<double *>(inPtr);
+    }
   else 
     { 
     if( inData != outData )
@@ -641,7 +1071,7 @@ int vtkImageEuclideanDistance::IterativeRequestData(
     }
   
   // Call the specific algorithms. 
-  switch( this->GetAlgorithm() ) 
+  switch( algorithm ) 
     {
     case VTK_EDT_SAITO:
       vtkImageEuclideanDistanceExecuteSaito( this, outData, outExt, 
@@ -651,6 +1081,9 @@ int vtkImageEuclideanDistance::IterativeRequestData(
       vtkImageEuclideanDistanceExecuteSaitoCached( this, outData, outExt, 
                                                    static_cast<double *>(outPtr) );
       break;
+    case VTK_EDT_LINEAR:
+      this->ExecuteLinear( inData, linearInPtr, outData );
+      break;
     default:
       vtkErrorMacro(<< "Execute: Unknown Algorithm");
     }
@@ -741,11 +1174,20 @@ void vtkImageEuclideanDistance::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "Initialize: " << this->Initialize << "\n";
   os << indent << "Maximum Distance: " << this->MaximumDistance << "\n";
 
+  os << indent << "Signed Distance: " 
+     << (this->SignedDistance ? "On\n" : "Off\n");
+  os << indent << "Compute Feature Indices: " 
+     << (this->ComputeFeatureIndices ? "On\n" : "Off\n");
+
   os << indent << "Algorithm: ";
   if ( this->Algorithm == VTK_EDT_SAITO )
     {
     os << "Saito\n";
     }
+  else if ( this->Algorithm == VTK_EDT_LINEAR )
+    {
+    os << "Linear\n";
+    }
   else 
     {
     os << "Saito Cached\n";
@@ -29,6 +29,13 @@
 // slow it very significantly. In that case, one should use 
 // ::SetAlgorithmToSaitoCached() instead for better performance. 
 //
+// The linear algorithm, ::SetAlgorithmToLinear(), computes the lower
+// envelope of the parabolas centered on the voxels of each row. Its
+// complexity is O(N) in the number N of voxels, independent of the
+// distances, and it shares the rows of each axis between threads. It can
+// also give signed distances and the index of the nearest feature voxel of
+// each voxel.
+//
 // References:
 //
 // T. Saito and J.I. Toriwaki. New algorithms for Euclidean distance 
@@ -38,6 +45,10 @@
 // O. Cuisenaire. Distance Transformation: fast algorithms and applications
 // to medical image processing. PhD Thesis, Universite catholique de Louvain,
 // October 1999. http://ltswww.epfl.ch/~cuisenai/papers/oc_thesis.pdf 
+//
+// P. F. Felzenszwalb and D. P. Huttenlocher. Distance Transforms of
+// Sampled Functions. Cornell Computing and Information Science Technical
+// Report TR2004-1963, September 2004.
  
 
 #ifndef __vtkImageEuclideanDistance_h
@@ -47,6 +58,7 @@
 
 #define VTK_EDT_SAITO_CACHED 0
 #define VTK_EDT_SAITO 1 
+#define VTK_EDT_LINEAR 2
 
 class VTK_IMAGING_EXPORT vtkImageEuclideanDistance : public vtkImageDecomposeFilter
 {
@@ -92,6 +104,7 @@ public:
   // Selects a Euclidean DT algorithm. 
   // 1. Saito
   // 2. Saito-cached 
+  // 3. Linear (lower envelope of parabolas, threaded)
   // More algorithms will be added later on. 
   vtkSetMacro(Algorithm, int);
   vtkGetMacro(Algorithm, int);
@@ -99,6 +112,26 @@ public:
     { this->SetAlgorithm(VTK_EDT_SAITO); } 
   void SetAlgorithmToSaitoCached () 
     { this->SetAlgorithm(VTK_EDT_SAITO_CACHED); }   
+  void SetAlgorithmToLinear () 
+    { this->SetAlgorithm(VTK_EDT_LINEAR); }   
+
+  // Description:
+  // When SignedDistance is on, the voxels of zero value get minus the
+  // square of their distance to the nearest non-zero voxel instead of
+  // zero. Default is off. The linear algorithm is always used.
+  vtkSetMacro(SignedDistance, int);
+  vtkGetMacro(SignedDistance, int);
+  vtkBooleanMacro(SignedDistance, int);
+
+  // Description:
+  // When ComputeFeatureIndices is on, the output point data gets a
+  // "FeatureIndices" array with the point id of the nearest zero voxel of
+  // each voxel (of the nearest non-zero voxel for the zero voxels of a
+  // signed distance), or -1 where there is none closer than
+  // MaximumDistance. Default is off. The linear algorithm is always used.
+  vtkSetMacro(ComputeFeatureIndices, int);
+  vtkGetMacro(ComputeFeatureIndices, int);
+  vtkBooleanMacro(ComputeFeatureIndices, int);
 
   virtual int IterativeRequestData(vtkInformation*,
                                    vtkInformationVector**,
@@ -112,6 +145,12 @@ protected:
   int Initialize;
   int ConsiderAnisotropy;
   int Algorithm;
+  int SignedDistance;
+  int ComputeFeatureIndices;
+
+  // Computes the distances along the axis of the current iteration.
+  void ExecuteLinear(vtkImageData *inData, double *inPtr,
+                     vtkImageData *outData);
 
   // Replaces "EnlargeOutputUpdateExtent"
   virtual void AllocateOutputScalars(vtkImageData *outData);
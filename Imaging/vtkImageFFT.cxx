@@ -58,7 +58,12 @@ int vtkImageFFT::IterativeRequestUpdateExtent(
 
 //----------------------------------------------------------------------------
 // This templated execute method handles any type input, but the output
-// is always doubles.
+// is always doubles.  The rows are transformed in batches of neighbouring
+// rows along axis 1, interleaved so that each stage of the transform runs
+// across the batch.  Real rows are transformed in pairs, as the real and
+// imaginary parts of one complex row, and separated with the symmetry of
+// their transforms.  The pairs are aligned on the extent of the data so
+// that each row has the same partner whatever the piece.
 template <class T>
 void vtkImageFFTExecute(vtkImageFFT *self,
                         vtkImageData *inData, int inExt[6], T *inPtr,
@@ -68,25 +73,30 @@ void vtkImageFFTExecute(vtkImageFFT *self,
   vtkImageComplex *inComplex;
   vtkImageComplex *outComplex;
   vtkImageComplex *pComplex;
+  vtkImageFourierPlan plan;
   //
-  int inMin0, inMax0;
+  int inMin0, inMax0, dataMin1, dataMax1;
   vtkIdType inInc0, inInc1, inInc2;
-  T *inPtr0, *inPtr1, *inPtr2;
+  T *inPtr0, *inPtr2, *imagPtr;
   //
   int outMin0, outMax0, outMin1, outMax1, outMin2, outMax2;
   vtkIdType outInc0, outInc1, outInc2;
-  double *outPtr0, *outPtr1, *outPtr2;
+  double *outPtr0, *outPtr2;
   //
   int idx0, idx1, idx2, inSize0, numberOfComponents;
+  int rowsPerArray, numRows, numArrays, array, row, k;
   unsigned long count = 0;
+  unsigned long nextProgress = 0;
   unsigned long target;
   double startProgress;
 
-  startProgress =
-    self->GetIteration()/static_cast<double>(self->GetNumberOfIterations());
-
+  startProgress = self->GetIteration()/
+    static_cast<double>(self->GetNumberOfIterations());
+  
   // Reorder axes (The outs here are just placeholdes
   self->PermuteExtent(inExt, inMin0, inMax0, outMin1,outMax1,outMin2,outMax2);
+  self->PermuteExtent(inData->GetExtent(), idx0, idx0, dataMin1, dataMax1,
+                      idx2, idx2);
   self->PermuteExtent(outExt, outMin0,outMax0,outMin1,outMax1,outMin2,outMax2);
   self->PermuteIncrements(inData->GetIncrements(), inInc0, inInc1, inInc2);
   self->PermuteIncrements(outData->GetIncrements(), outInc0, outInc1, outInc2);
@@ -100,10 +110,12 @@ void vtkImageFFTExecute(vtkImageFFT *self,
     vtkGenericWarningMacro("No real components");
     return;
     }
+  rowsPerArray = (numberOfComponents == 1 ? 2 : 1);
 
   // Allocate the arrays of complex numbers
-  inComplex = new vtkImageComplex[inSize0];
-  outComplex = new vtkImageComplex[inSize0];
+  self->InitializeFftPlan(&plan, inSize0);
+  inComplex = new vtkImageComplex[inSize0*VTK_IMAGE_FOURIER_BATCH_SIZE];
+  outComplex = new vtkImageComplex[inSize0*VTK_IMAGE_FOURIER_BATCH_SIZE];
 
   target = static_cast<unsigned long>((outMax2-outMin2+1)*(outMax1-outMin1+1)
                                       * self->GetNumberOfIterations() / 50.0);
@@ -114,48 +126,114 @@ void vtkImageFFTExecute(vtkImageFFT *self,
   outPtr2 = outPtr;
   for (idx2 = outMin2; idx2 <= outMax2; ++idx2)
     {
-    inPtr1 = inPtr2;
-    outPtr1 = outPtr2;
-    for (idx1 = outMin1; !self->AbortExecute && idx1 <= outMax1; ++idx1)
+    idx1 = outMin1;
+    if (rowsPerArray == 2 && ((outMin1 - dataMin1) & 1))
+      { // this row is paired with the previous one
+      --idx1;
+      }
+    for (; !self->AbortExecute && idx1 <= outMax1;
+         idx1 += rowsPerArray*VTK_IMAGE_FOURIER_BATCH_SIZE)
       {
       if (!id) 
         {
-        if (!(count%target))
+        if (count >= nextProgress)
           {
           self->UpdateProgress(count/(50.0*target) + startProgress);
+          nextProgress += target;
           }
-        count++;
+        count += rowsPerArray*VTK_IMAGE_FOURIER_BATCH_SIZE;
         }
+      numRows = outMax1 - idx1 + 1;
+      if (numRows > rowsPerArray*VTK_IMAGE_FOURIER_BATCH_SIZE)
+        {
+        numRows = rowsPerArray*VTK_IMAGE_FOURIER_BATCH_SIZE;
+        }
+      else if (rowsPerArray == 2 && (numRows & 1) && outMax1 < dataMax1)
+        { // read the partner of the last row
+        ++numRows;
+        }
+      numArrays = (numRows + rowsPerArray - 1) / rowsPerArray;
+
       // copy into complex numbers
-      inPtr0 = inPtr1;
-      pComplex = inComplex;
-      for (idx0 = inMin0; idx0 <= inMax0; ++idx0)
+      for (array = 0; array < numArrays; ++array)
         {
-        pComplex->Real = static_cast<double>(*inPtr0);
-        pComplex->Imag = 0.0;
-        if (numberOfComponents > 1)
-          { // yes we have an imaginary input
-          pComplex->Imag = static_cast<double>(inPtr0[1]);;
+        row = idx1 + array*rowsPerArray;
+        inPtr0 = inPtr2 + (row - outMin1)*inInc1;
+        pComplex = inComplex + array;
+        if (rowsPerArray == 2 && row + 1 >= idx1 + numRows)
+          { // no partner: the imaginary part is zero
+          for (idx0 = inMin0; idx0 <= inMax0; ++idx0)
+            {
+            pComplex->Real = static_cast<double>(*inPtr0);
+            pComplex->Imag = 0.0;
+            inPtr0 += inInc0;
+            pComplex += numArrays;
+            }
+          }
+        else
+          { // the imaginary part is the partner, or the second component
+          imagPtr = inPtr0 + (rowsPerArray == 2 ? inInc1 : 1);
+          for (idx0 = inMin0; idx0 <= inMax0; ++idx0)
+            {
+            pComplex->Real = static_cast<double>(*inPtr0);
+            pComplex->Imag = static_cast<double>(*imagPtr);
+            inPtr0 += inInc0;
+            imagPtr += inInc0;
+            pComplex += numArrays;
+            }
           }
-        inPtr0 += inInc0;
-        ++pComplex;
         }
-      
-      // Call the method that performs the fft
-      self->ExecuteFft(inComplex, outComplex, inSize0);
+
+      // Call the method that performs the FFT
+      self->ExecuteFftBatch(&plan, inComplex, outComplex, numArrays, 1);
 
       // copy into output
-      outPtr0 = outPtr1;
-      pComplex = outComplex + (outMin0 - inMin0);
-      for (idx0 = outMin0; idx0 <= outMax0; ++idx0)
+      for (array = 0; array < numArrays; ++array)
         {
-        *outPtr0 = static_cast<double>(pComplex->Real);
-        outPtr0[1] = static_cast<double>(pComplex->Imag);
-        outPtr0 += outInc0;
-        ++pComplex;
+        row = idx1 + array*rowsPerArray;
+        if (rowsPerArray == 1)
+          {
+          outPtr0 = outPtr2 + (row - outMin1)*outInc1;
+          pComplex = outComplex + (outMin0 - inMin0)*numArrays + array;
+          for (idx0 = outMin0; idx0 <= outMax0; ++idx0)
+            {
+            *outPtr0 = pComplex->Real;
+            outPtr0[1] = pComplex->Imag;
+            outPtr0 += outInc0;
+            pComplex += numArrays;
+            }
+          continue;
+          }
+        // The transforms A and B of a pair of real rows a and b are
+        // A(k) = (Z(k) + conj(Z(N-k)))/2 and B(k) = (Z(k) - conj(Z(N-k)))/2i
+        // where Z is the transform of a + ib.
+        for (; row <= idx1 + array*2 + 1; ++row)
+          {
+          if (row < outMin1 || row > outMax1)
+            {
+            continue;
+            }
+          outPtr0 = outPtr2 + (row - outMin1)*outInc1;
+          for (idx0 = outMin0; idx0 <= outMax0; ++idx0)
+            {
+            k = idx0 - inMin0;
+            vtkImageComplex z = outComplex[k*numArrays + array];
+            vtkImageComplex zn =
+              outComplex[((inSize0 - k) % inSize0)*numArrays + array];
+            if (row == idx1 + array*2)
+              {
+              *outPtr0 = 0.5*(z.Real + zn.Real);
+              outPtr0[1] = 0.5*(z.Imag - zn.Imag);
+              }
+            else
+              {
+              *outPtr0 = 0.5*(z.Imag + zn.Imag);
+              outPtr0[1] = 0.5*(zn.Real - z.Real);
+              }
+            outPtr0 += outInc0;
+            }
+          }
         }
-      inPtr1 += inInc1;
-      outPtr1 += outInc1;
       }
     inPtr2 += inInc2;
     outPtr2 += outInc2;
@@ -163,6 +241,7 @@ void vtkImageFFTExecute(vtkImageFFT *self,
     
   delete [] inComplex;
   delete [] outComplex;
+  self->ReleaseFftPlan(&plan);
 }
 
 
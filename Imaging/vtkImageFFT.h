@@ -17,11 +17,12 @@
 // vtkImageFFT implements a  fast Fourier transform.  The input
 // can have real or complex data in any components and data types, but
 // the output is always complex doubles with real values in component0, and
-// imaginary values in component1.  The filter is fastest for images that
-// have power of two sizes.  The filter uses a butterfly fitlers for each
-// prime factor of the dimension.  This makes images with prime number dimensions 
-// (i.e. 17x17) much slower to compute.  Multi dimensional (i.e volumes) 
-// FFT's are decomposed so that each axis executes in series.
+// imaginary values in component1.  The filter is fastest for images whose
+// sizes have no prime factors other than 2, 3 and 5.  The filter uses a
+// butterfly for each prime factor of the dimension.  This makes images with
+// large prime number dimensions (i.e. 127x127) much slower to compute.
+// Multi dimensional (i.e volumes) FFT's are decomposed so that each axis
+// executes in series, on batches of neighbouring rows.
 
 
 #ifndef __vtkImageFFT_h
@@ -14,208 +14,406 @@
 =========================================================================*/
 #include "vtkImageFourierFilter.h"
 
+#include "vtkMath.h"
+
 #include <math.h>
 
 
 
 /*=========================================================================
         Vectors of complex numbers.
+
+  The transform is a Stockham autosort FFT: each stage of radix p splits
+  the sub-transforms of length n into p sub-transforms of length m = n/p,
+  reading the input in natural order and writing the output so that no
+  reordering is needed at the end.  The stages alternate between the input
+  and the output arrays.  Element j of the stage arrays is a group of
+  'stride' consecutive complex numbers, which all get the same operations:
+  the stride starts at the number of interleaved arrays of the batch, and
+  is multiplied by the radix after each stage.
 =========================================================================*/
 
 //----------------------------------------------------------------------------
-// This function calculates one step of a FFT.
-// It is specialized for a factor of 2. 
-// It is engineered for no decimation.
-// (forward: fb = 1, backward: fb = -1)
-void vtkImageFourierFilter::ExecuteFftStep2(vtkImageComplex *p_in, 
-                                            vtkImageComplex *p_out, 
-                                            int N, int bsize, int fb)
+// Multiplies c by the twiddle factor w, conjugated for the backward
+// transform (fb = -1).
+static inline void vtkImageFourierFilterTwiddle(vtkImageComplex &c,
+                                                const vtkImageComplex &w,
+                                                double fb)
+{
+  double wImag = fb*w.Imag;
+  double real = c.Real*w.Real - c.Imag*wImag;
+  c.Imag = c.Real*wImag + c.Imag*w.Real;
+  c.Real = real;
+}
+
+//----------------------------------------------------------------------------
+// One stage of radix 2.
+static void vtkImageFourierFilterStage2(const vtkImageComplex *x,
+                                        vtkImageComplex *y, int m,
+                                        int stride, const vtkImageComplex *w,
+                                        double fb)
 {
-  int i1, i2;
-  vtkImageComplex *p1, *p2, *p3;
-  vtkImageComplex q, fact1, fact, temp;
-  
-  /* Copy the links with no factors. */
-  p1 = p_in;
-  p3 = p_out;
-  for(i1 = 0; i1 < N / (bsize * 2); ++i1)   // loop 0->1
+  for (int q = 0; q < m; ++q)
     {
-    p2 = p1;
-    for(i2 = 0; i2 < bsize; ++i2)    // loop 0->2
-      {
-      *p3 = *p2;         // out[0] = in[0];  out[1] = in[1];
-      ++p2;
-      ++p3;
-      }
-    p2 = p1;
-    for(i2 = 0; i2 < bsize; ++i2)
+    const vtkImageComplex *x0 = x + stride*q;
+    const vtkImageComplex *x1 = x0 + stride*m;
+    vtkImageComplex *y0 = y + stride*2*q;
+    vtkImageComplex *y1 = y0 + stride;
+    for (int u = 0; u < stride; ++u)
       {
-      *p3 = *p2;         // out[2] = in[0];   out[3] = in[1];
-      ++p2;
-      ++p3;
+      vtkImageComplex a = x0[u];
+      vtkImageComplex b = x1[u];
+      vtkImageComplexAdd(a, b, y0[u]);
+      vtkImageComplexSubtract(a, b, y1[u]);
+      vtkImageFourierFilterTwiddle(y1[u], w[q], fb);
       }
-    p1 = p1 + bsize;
     }
-  
-  /* Add the links with factors. */
-  fact1.Real = 1.0;
-  fact1.Imag = 0.0;
-  q.Real = 0.0;
-  q.Imag = -2.0 * 3.141592654 * static_cast<float>(fb)
-    / static_cast<float>(bsize * 2);
-  vtkImageComplexExponential(q, q);
-  p3 = p_out;
-  for(i1 = 0; i1 < N / (bsize * 2); ++i1)
+}
+
+//----------------------------------------------------------------------------
+// One stage of radix 3.
+static void vtkImageFourierFilterStage3(const vtkImageComplex *x,
+                                        vtkImageComplex *y, int m,
+                                        int stride, const vtkImageComplex *w,
+                                        double fb)
+{
+  // -fb*sin(2*pi/3), the imaginary part of the first root of unity
+  double s = -fb*0.86602540378443864676;
+  for (int q = 0; q < m; ++q)
     {
-    fact = fact1;
-    p2 = p1;
-    for(i2 = 0; i2 < bsize; ++i2)
+    const vtkImageComplex *x0 = x + stride*q;
+    const vtkImageComplex *x1 = x0 + stride*m;
+    const vtkImageComplex *x2 = x1 + stride*m;
+    vtkImageComplex *y0 = y + stride*3*q;
+    vtkImageComplex *y1 = y0 + stride;
+    vtkImageComplex *y2 = y1 + stride;
+    const vtkImageComplex *wq = w + 2*q;
+    for (int u = 0; u < stride; ++u)
       {
-      vtkImageComplexMultiply(fact, *p2, temp);
-      vtkImageComplexAdd(temp, *p3, *p3);
-      vtkImageComplexMultiply(q, fact, fact);
-      ++p2;    // out[0] += in[2];   out[1] += -i*in[3];
-      ++p3;
+      vtkImageComplex a = x0[u];
+      vtkImageComplex t1, t2, m1;
+      vtkImageComplexAdd(x1[u], x2[u], t1);
+      vtkImageComplexSubtract(x1[u], x2[u], t2);
+      vtkImageComplexAdd(a, t1, y0[u]);
+      m1.Real = a.Real - 0.5*t1.Real;
+      m1.Imag = a.Imag - 0.5*t1.Imag;
+      // i*s*t2
+      double mReal = -s*t2.Imag;
+      double mImag = s*t2.Real;
+      vtkImageComplexEuclidSet(y1[u], m1.Real + mReal, m1.Imag + mImag);
+      vtkImageComplexEuclidSet(y2[u], m1.Real - mReal, m1.Imag - mImag);
+      vtkImageFourierFilterTwiddle(y1[u], wq[0], fb);
+      vtkImageFourierFilterTwiddle(y2[u], wq[1], fb);
       }
-    p2 = p1;
-    for(i2 = 0; i2 < bsize; ++i2)
+    }
+}
+
+//----------------------------------------------------------------------------
+// One stage of radix 4.
+static void vtkImageFourierFilterStage4(const vtkImageComplex *x,
+                                        vtkImageComplex *y, int m,
+                                        int stride, const vtkImageComplex *w,
+                                        double fb)
+{
+  for (int q = 0; q < m; ++q)
+    {
+    const vtkImageComplex *x0 = x + stride*q;
+    const vtkImageComplex *x1 = x0 + stride*m;
+    const vtkImageComplex *x2 = x1 + stride*m;
+    const vtkImageComplex *x3 = x2 + stride*m;
+    vtkImageComplex *y0 = y + stride*4*q;
+    vtkImageComplex *y1 = y0 + stride;
+    vtkImageComplex *y2 = y1 + stride;
+    vtkImageComplex *y3 = y2 + stride;
+    const vtkImageComplex *wq = w + 3*q;
+    for (int u = 0; u < stride; ++u)
       {
-      vtkImageComplexMultiply(fact, *p2, temp);
-      vtkImageComplexAdd(temp, *p3, *p3);
-      vtkImageComplexMultiply(q, fact, fact);
-      ++p2;
-      ++p3;
+      vtkImageComplex t0, t1, t2, t3;
+      vtkImageComplexAdd(x0[u], x2[u], t0);
+      vtkImageComplexSubtract(x0[u], x2[u], t1);
+      vtkImageComplexAdd(x1[u], x3[u], t2);
+      // -i*fb*(x1 - x3)
+      double dReal = x1[u].Real - x3[u].Real;
+      double dImag = x1[u].Imag - x3[u].Imag;
+      vtkImageComplexEuclidSet(t3, fb*dImag, -fb*dReal);
+      vtkImageComplexAdd(t0, t2, y0[u]);
+      vtkImageComplexAdd(t1, t3, y1[u]);
+      vtkImageComplexSubtract(t0, t2, y2[u]);
+      vtkImageComplexSubtract(t1, t3, y3[u]);
+      vtkImageFourierFilterTwiddle(y1[u], wq[0], fb);
+      vtkImageFourierFilterTwiddle(y2[u], wq[1], fb);
+      vtkImageFourierFilterTwiddle(y3[u], wq[2], fb);
       }
-    p1 = p1 + bsize;
     }
 }
 
 //----------------------------------------------------------------------------
-// This function calculates one step of a FFT (using any factor).
-// It is engineered for no decimation.
-//  N: length of arrays 
-//  bsize: Size of FFT so far (should be scaled by n after this step)
-//  n: size of this steps butterfly.
-//  fb: forward: fb = 1, backward: fb = -1 
-void vtkImageFourierFilter::ExecuteFftStepN(vtkImageComplex *p_in, 
-                                            vtkImageComplex *p_out,
-                                            int N, int bsize, int n, int fb)
+// One stage of radix 5.
+static void vtkImageFourierFilterStage5(const vtkImageComplex *x,
+                                        vtkImageComplex *y, int m,
+                                        int stride, const vtkImageComplex *w,
+                                        double fb)
 {
-  int i0, i1, i2, i3;
-  vtkImageComplex *p1, *p2, *p3;
-  vtkImageComplex q, fact, temp;
-
-  p3 = p_out; 
-  for(i0 = 0; i0 < N; ++i0)
+  // cosines and sines of 2*pi/5 and 4*pi/5
+  const double c1 = 0.30901699437494742410;
+  const double c2 = -0.80901699437494742410;
+  double s1 = fb*0.95105651629515357212;
+  double s2 = fb*0.58778525229247312917;
+  for (int q = 0; q < m; ++q)
     {
-    p3->Real = 0.0;
-    p3->Imag = 0.0;
-    ++p3;
+    const vtkImageComplex *x0 = x + stride*q;
+    const vtkImageComplex *x1 = x0 + stride*m;
+    const vtkImageComplex *x2 = x1 + stride*m;
+    const vtkImageComplex *x3 = x2 + stride*m;
+    const vtkImageComplex *x4 = x3 + stride*m;
+    vtkImageComplex *y0 = y + stride*5*q;
+    vtkImageComplex *y1 = y0 + stride;
+    vtkImageComplex *y2 = y1 + stride;
+    vtkImageComplex *y3 = y2 + stride;
+    vtkImageComplex *y4 = y3 + stride;
+    const vtkImageComplex *wq = w + 4*q;
+    for (int u = 0; u < stride; ++u)
+      {
+      vtkImageComplex a = x0[u];
+      vtkImageComplex t1, t2, t3, t4;
+      vtkImageComplexAdd(x1[u], x4[u], t1);
+      vtkImageComplexAdd(x2[u], x3[u], t2);
+      vtkImageComplexSubtract(x1[u], x4[u], t3);
+      vtkImageComplexSubtract(x2[u], x3[u], t4);
+      vtkImageComplexEuclidSet(y0[u], a.Real + t1.Real + t2.Real,
+                               a.Imag + t1.Imag + t2.Imag);
+      double m1Real = a.Real + c1*t1.Real + c2*t2.Real;
+      double m1Imag = a.Imag + c1*t1.Imag + c2*t2.Imag;
+      double m2Real = a.Real + c2*t1.Real + c1*t2.Real;
+      double m2Imag = a.Imag + c2*t1.Imag + c1*t2.Imag;
+      // -i*(s1*t3 + s2*t4) and -i*(s2*t3 - s1*t4)
+      double n1Real = s1*t3.Imag + s2*t4.Imag;
+      double n1Imag = -(s1*t3.Real + s2*t4.Real);
+      double n2Real = s2*t3.Imag - s1*t4.Imag;
+      double n2Imag = -(s2*t3.Real - s1*t4.Real);
+      vtkImageComplexEuclidSet(y1[u], m1Real + n1Real, m1Imag + n1Imag);
+      vtkImageComplexEuclidSet(y4[u], m1Real - n1Real, m1Imag - n1Imag);
+      vtkImageComplexEuclidSet(y2[u], m2Real + n2Real, m2Imag + n2Imag);
+      vtkImageComplexEuclidSet(y3[u], m2Real - n2Real, m2Imag - n2Imag);
+      vtkImageFourierFilterTwiddle(y1[u], wq[0], fb);
+      vtkImageFourierFilterTwiddle(y2[u], wq[1], fb);
+      vtkImageFourierFilterTwiddle(y3[u], wq[2], fb);
+      vtkImageFourierFilterTwiddle(y4[u], wq[3], fb);
+      }
     }
-  
-  p1 = p_in;
-  for(i0 = 0; i0 < n; ++i0)
+}
+
+//----------------------------------------------------------------------------
+// One stage of any radix p, with the p roots of unity.
+static void vtkImageFourierFilterStageN(const vtkImageComplex *x,
+                                        vtkImageComplex *y, int p, int m,
+                                        int stride, const vtkImageComplex *w,
+                                        const vtkImageComplex *roots,
+                                        double fb)
+{
+  for (int q = 0; q < m; ++q)
     {
-    q.Real = 0.0;
-    q.Imag = -2.0 * 3.141592654 * static_cast<float>(i0) *
-      static_cast<float>(fb) / static_cast<float>(bsize*n);
-    vtkImageComplexExponential(q, q);
-    p3 = p_out;
-    for(i1 = 0; i1 < N / (bsize * n); ++i1)
+    const vtkImageComplex *x0 = x + stride*q;
+    for (int k = 0; k < p; ++k)
       {
-      fact.Real = 1.0;
-      fact.Imag = 0.0;
-      for(i3 = 0; i3 < n; ++i3)
+      vtkImageComplex *yk = y + stride*(p*q + k);
+      for (int u = 0; u < stride; ++u)
         {
-        p2 = p1;
-        for(i2 = 0; i2 < bsize; ++i2)
+        yk[u] = x0[u];
+        }
+      for (int r = 1; r < p; ++r)
+        {
+        const vtkImageComplex *xr = x0 + stride*m*r;
+        vtkImageComplex root = roots[(r*k) % p];
+        root.Imag *= fb;
+        for (int u = 0; u < stride; ++u)
           {
-          vtkImageComplexMultiply(fact, *p2, temp);
-          vtkImageComplexAdd(temp, *p3, *p3);
-          vtkImageComplexMultiply(q, fact, fact);
-          ++p2;
-          ++p3;
+          yk[u].Real += root.Real*xr[u].Real - root.Imag*xr[u].Imag;
+          yk[u].Imag += root.Real*xr[u].Imag + root.Imag*xr[u].Real;
+          }
+        }
+      if (k > 0)
+        {
+        const vtkImageComplex &wqk = w[(p - 1)*q + k - 1];
+        for (int u = 0; u < stride; ++u)
+          {
+          vtkImageFourierFilterTwiddle(yk[u], wqk, fb);
           }
         }
-      
-      p1 = p1 + bsize;
       }
     }
 }
 
-
-
 //----------------------------------------------------------------------------
-// This function calculates the whole fft (or rfft) of an array.
-// The contents of the input array are changed.
-// It is engineered for no decimation so input and output cannot be equal.
-// (fb = 1) => fft, (fb = -1) => rfft;
-void vtkImageFourierFilter::ExecuteFftForwardBackward(vtkImageComplex *in, 
-                                                      vtkImageComplex *out, 
-                                                      int N, int fb)
+// N is split into factors of 4 first, then 2, 3, 5 and any other prime.
+// The twiddle factors of a stage of radix p that splits sub-transforms of
+// length n are exp(-2*pi*i*q*k/n) for q < n/p and 0 < k < p, followed for
+// the radices without a specialized butterfly by the p roots of unity.
+void vtkImageFourierFilter::InitializeFftPlan(vtkImageFourierPlan *plan,
+                                              int N)
 {
-  vtkImageComplex *p1, *p2, *p3;
-  int block_size = 1;
-  int rest_size = N;
+  int rest = N;
   int n = 2;
-  int idx;
+  int idx, size, p, m, q, k;
 
-  // If this is a reverse transform (scale accordingly).
-  if(fb == -1)
-    {  
-    p1 = in;
-    for(idx = 0; idx < N; ++idx)
+  plan->N = N;
+  plan->NumberOfFactors = 0;
+  while (rest % 4 == 0)
+    {
+    plan->Factors[plan->NumberOfFactors++] = 4;
+    rest = rest / 4;
+    }
+  while (rest > 1)
+    {
+    if ((rest % n) == 0)
       {
-      p1->Real = p1->Real / static_cast<float>(N);
-      p1->Imag = p1->Imag / static_cast<float>(N);
-      ++p1;
+      plan->Factors[plan->NumberOfFactors++] = n;
+      rest = rest / n;
       }
+    else
+      {
+      n = (n == 2 ? 3 : n + 2);
+      }
+    }
+
+  size = 1;
+  n = N;
+  for (idx = 0; idx < plan->NumberOfFactors; ++idx)
+    {
+    p = plan->Factors[idx];
+    m = n / p;
+    size += m*(p - 1) + (p > 5 ? p : 0);
+    n = m;
     }
-  p1 = in;
-  p2 = out;
-  while(block_size < N && n <= N)
+  plan->Twiddles = new vtkImageComplex[size];
+
+  vtkImageComplex *w = plan->Twiddles;
+  n = N;
+  for (idx = 0; idx < plan->NumberOfFactors; ++idx)
     {
-    if((rest_size % n) == 0)
+    p = plan->Factors[idx];
+    m = n / p;
+    double theta = -vtkMath::DoubleTwoPi() / static_cast<double>(n);
+    for (q = 0; q < m; ++q)
       {
-      // n is a prime factor, perform one "butterfly" stage of the fft.
-      if(n == 2)
+      for (k = 1; k < p; ++k)
         {
-        this->ExecuteFftStep2(p1, p2, N, block_size, fb);
+        vtkImageComplexPolarSet(*w, 1.0, theta*(q*k));
+        ++w;
         }
-      else
+      }
+    if (p > 5)
+      {
+      theta = -vtkMath::DoubleTwoPi() / static_cast<double>(p);
+      for (k = 0; k < p; ++k)
         {
-        this->ExecuteFftStepN(p1, p2, N, block_size, n, fb);
+        vtkImageComplexPolarSet(*w, 1.0, theta*k);
+        ++w;
         }
-      block_size = block_size * n;
-      rest_size = rest_size / n;
-      // switch input and output.
-      p3 = p1;
-      p1 = p2;
-      p2 = p3;
       }
-    else
+    n = m;
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkImageFourierFilter::ReleaseFftPlan(vtkImageFourierPlan *plan)
+{
+  delete [] plan->Twiddles;
+  plan->Twiddles = 0;
+}
+
+//----------------------------------------------------------------------------
+// This function calculates the fft (or rfft) of count interleaved arrays.
+// The contents of the input array are changed.
+// (fb = 1) => fft, (fb = -1) => rfft;
+void vtkImageFourierFilter::ExecuteFftBatch(vtkImageFourierPlan *plan,
+                                            vtkImageComplex *in,
+                                            vtkImageComplex *out,
+                                            int count, int fb)
+{
+  vtkImageComplex *p1 = in;
+  vtkImageComplex *p2 = out;
+  vtkImageComplex *p3;
+  const vtkImageComplex *w = plan->Twiddles;
+  int n = plan->N;
+  int stride = count;
+  double sign = static_cast<double>(fb);
+  int idx, p, m;
+
+  for (idx = 0; idx < plan->NumberOfFactors; ++idx)
+    {
+    p = plan->Factors[idx];
+    m = n / p;
+    switch (p)
+      {
+      case 2:
+        vtkImageFourierFilterStage2(p1, p2, m, stride, w, sign);
+        break;
+      case 3:
+        vtkImageFourierFilterStage3(p1, p2, m, stride, w, sign);
+        break;
+      case 4:
+        vtkImageFourierFilterStage4(p1, p2, m, stride, w, sign);
+        break;
+      case 5:
+        vtkImageFourierFilterStage5(p1, p2, m, stride, w, sign);
+        break;
+      default:
+        vtkImageFourierFilterStageN(p1, p2, p, m, stride, w,
+                                    w + m*(p - 1), sign);
+      }
+    w += m*(p - 1) + (p > 5 ? p : 0);
+    stride *= p;
+    n = m;
+    // switch input and output.
+    p3 = p1;
+    p1 = p2;
+    p2 = p3;
+    }
+
+  // If this is a reverse transform (scale accordingly), and if the results
+  // ended up in the input, copy to output.
+  int size = plan->N*count;
+  if (fb == -1)
+    {
+    double scale = 1.0 / static_cast<double>(plan->N);
+    for (idx = 0; idx < size; ++idx)
       {
-      // n is not a prime factor. increment n to see if n+1 is.
-      ++n;
+      vtkImageComplexScale(out[idx], scale, p1[idx]);
       }
     }
-  // If the results ended up in the input, copy to output.
-  if(p1 != out)
+  else if (p1 != out)
     {
-    for(n = 0; n < N; ++n)
+    for (idx = 0; idx < size; ++idx)
       {
-      *out++ = *p1++;
+      out[idx] = p1[idx];
       }
     }
 }
 
+//----------------------------------------------------------------------------
+// This function calculates the whole fft (or rfft) of an array.
+// The contents of the input array are changed.
+// The input and output cannot be equal.
+// (fb = 1) => fft, (fb = -1) => rfft;
+void vtkImageFourierFilter::ExecuteFftForwardBackward(vtkImageComplex *in,
+                                                      vtkImageComplex *out,
+                                                      int N, int fb)
+{
+  vtkImageFourierPlan plan;
+
+  this->InitializeFftPlan(&plan, N);
+  this->ExecuteFftBatch(&plan, in, out, 1, fb);
+  this->ReleaseFftPlan(&plan);
+}
+
 
 
 //----------------------------------------------------------------------------
 // This function calculates the whole fft of an array.
 // The contents of the input array are changed.
 // (It is engineered for no decimation)
-void vtkImageFourierFilter::ExecuteFft(vtkImageComplex *in, 
+void vtkImageFourierFilter::ExecuteFft(vtkImageComplex *in,
                                        vtkImageComplex *out, int N)
 {
   this->ExecuteFftForwardBackward(in, out, N, 1);
@@ -225,10 +423,8 @@ void vtkImageFourierFilter::ExecuteFft(vtkImageComplex *in,
 // This function calculates the whole fft of an array.
 // The contents of the input array are changed.
 // (It is engineered for no decimation)
-void vtkImageFourierFilter::ExecuteRfft(vtkImageComplex *in, 
+void vtkImageFourierFilter::ExecuteRfft(vtkImageComplex *in,
                                         vtkImageComplex *out, int N)
 {
   this->ExecuteFftForwardBackward(in, out, N, -1);
 }
- 
-
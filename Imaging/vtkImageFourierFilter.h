@@ -18,6 +18,13 @@
 // this superclass is a container for methods that manipulate these structure
 // including fast Fourier transforms.  Complex numbers may become a class.
 // This should really be a helper class.
+//
+// The transforms use a mixed-radix algorithm with butterflies specialized
+// for the factors 2, 3, 4 and 5, and a generic butterfly for other prime
+// factors.  The factors and twiddle factors of a transform length are
+// computed once in a vtkImageFourierPlan, and batches of rows are
+// transformed together, interleaved, so that each stage of the transform
+// runs across the whole batch.
 #ifndef __vtkImageFourierFilter_h
 #define __vtkImageFourierFilter_h
 
@@ -80,6 +87,18 @@ typedef struct{
   cOut.Imag = tmp * sin(cIn.Imag); \
 }
 
+// The factors of a transform length, in the order of the stages of the
+// transform, and the twiddle factors of each stage.
+typedef struct{
+    int N;
+    int NumberOfFactors;
+    int Factors[32];
+    vtkImageComplex *Twiddles;
+  } vtkImageFourierPlan;
+
+// The number of rows transformed together by vtkImageFFT and vtkImageRFFT.
+#define VTK_IMAGE_FOURIER_BATCH_SIZE 16
+
 /******************* End of COMPLEX number stuff ********************/
 //ETX
 
@@ -105,6 +124,20 @@ public:
   // (It is engineered for no decimation)
   void ExecuteRfft(vtkImageComplex *in, vtkImageComplex *out, int N);
 
+  // Description:
+  // Computes the factors and twiddle factors of transforms of length N.
+  // ReleaseFftPlan frees them.
+  void InitializeFftPlan(vtkImageFourierPlan *plan, int N);
+  void ReleaseFftPlan(vtkImageFourierPlan *plan);
+
+  // Description:
+  // This function calculates the fft (fb = 1) or rfft (fb = -1) of count
+  // arrays of the length of the plan at once.  The arrays are interleaved:
+  // element i of array b is in[i*count + b].  The contents of the input
+  // array are changed.
+  void ExecuteFftBatch(vtkImageFourierPlan *plan, vtkImageComplex *in,
+                       vtkImageComplex *out, int count, int fb);
+
   //ETX
   
 protected:
@@ -112,10 +145,6 @@ protected:
   ~vtkImageFourierFilter() {};
 
   //BTX
-  void ExecuteFftStep2(vtkImageComplex *p_in, vtkImageComplex *p_out, 
-                       int N, int bsize, int fb);
-  void ExecuteFftStepN(vtkImageComplex *p_in, vtkImageComplex *p_out,
-                       int N, int bsize, int n, int fb);
   void ExecuteFftForwardBackward(vtkImageComplex *in, vtkImageComplex *out, 
                                  int N, int fb);
   //ETX
@@ -17,8 +17,12 @@
 #include "vtkImageData.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkStreamingDemandDrivenPipeline.h"
+#include "vtkTypeTraits.h"
+
+#include <vtkstd/vector>
 
 #include <math.h>
 
@@ -34,6 +38,14 @@ vtkImageGaussianSmooth::vtkImageGaussianSmooth()
   this->RadiusFactors[0] = 1.5;
   this->RadiusFactors[1] = 1.5;
   this->RadiusFactors[2] = 1.5;
+  this->UseRecursiveFilter = 0;
+  this->DerivativeOrders[0] = 0;
+  this->DerivativeOrders[1] = 0;
+  this->DerivativeOrders[2] = 0;
+
+  // Blocks keep the intermediate results of each piece in cache.
+  this->SplitMode = VTK_IMAGE_SPLIT_BLOCK;
+  this->DesiredBytesPerPiece = 262144;
 }
 
 //----------------------------------------------------------------------------
@@ -41,6 +53,29 @@ vtkImageGaussianSmooth::~vtkImageGaussianSmooth()
 {
 }
 
+//----------------------------------------------------------------------------
+// Each order is clamped to 0..2, the derivatives the recursive filter
+// computes.
+void vtkImageGaussianSmooth::SetDerivativeOrders(int x, int y, int z)
+{
+  int orders[3];
+  orders[0] = (x < 0 ? 0 : (x > 2 ? 2 : x));
+  orders[1] = (y < 0 ? 0 : (y > 2 ? 2 : y));
+  orders[2] = (z < 0 ? 0 : (z > 2 ? 2 : z));
+  vtkDebugMacro(<< this->GetClassName() << " (" << this
+                << "): setting DerivativeOrders to (" << orders[0] << ","
+                << orders[1] << "," << orders[2] << ")");
+  if (this->DerivativeOrders[0] != orders[0] ||
+      this->DerivativeOrders[1] != orders[1] ||
+      this->DerivativeOrders[2] != orders[2])
+    {
+    this->DerivativeOrders[0] = orders[0];
+    this->DerivativeOrders[1] = orders[1];
+    this->DerivativeOrders[2] = orders[2];
+    this->Modified();
+    }
+}
+
 //----------------------------------------------------------------------------
 void vtkImageGaussianSmooth::PrintSelf(ostream& os, vtkIndent indent)
 {
@@ -61,6 +96,14 @@ void vtkImageGaussianSmooth::PrintSelf(ostream& os, vtkIndent indent)
      << this->StandardDeviations[0] << ", "
      << this->StandardDeviations[1] << ", "
      << this->StandardDeviations[2] << " )\n";
+
+  os << indent << "UseRecursiveFilter: "
+     << (this->UseRecursiveFilter ? "On\n" : "Off\n");
+
+  os << indent << "DerivativeOrders: ( "
+     << this->DerivativeOrders[0] << ", "
+     << this->DerivativeOrders[1] << ", "
+     << this->DerivativeOrders[2] << " )\n";
 }
 
 //----------------------------------------------------------------------------
@@ -125,6 +168,13 @@ void vtkImageGaussianSmooth::InternalRequestUpdateExtent(int *inExt,
   // Expand filtered axes
   for (idx = 0; idx < this->Dimensionality; ++idx)
     {
+    // the recursive filter runs along whole rows
+    if (this->UseRecursiveFilter)
+      {
+      inExt[idx*2] = wholeExtent[idx*2];
+      inExt[idx*2+1] = wholeExtent[idx*2+1];
+      continue;
+      }
     radius = static_cast<int>(this->StandardDeviations[idx]
                               * this->RadiusFactors[idx]);
     inExt[idx*2] -= radius;
@@ -366,7 +416,7 @@ void vtkImageGaussianSmooth::ExecuteAxis(int axis,
 void vtkImageGaussianSmooth::ThreadedRequestData(
   vtkInformation *vtkNotUsed(request),
   vtkInformationVector **inputVector,
-  vtkInformationVector *outputVector,
+  vtkInformationVector *vtkNotUsed(outputVector),
   vtkImageData ***inData,
   vtkImageData **outData,
   int outExt[6], int id)
@@ -376,9 +426,10 @@ void vtkImageGaussianSmooth::ThreadedRequestData(
   
   // for feed back, determine line target to get 50 progress update
   // update is called every target lines. Progress is computed from
-  // the number of pixels processed so far.
+  // the number of pixels processed so far. In beam and block modes the
+  // superclass reports the progress of the pieces instead.
   count = 0; target = 0; total = 0; cycle = 0;
-  if (id == 0)
+  if (id == 0 && this->SplitMode == VTK_IMAGE_SPLIT_SLAB)
     {
     // determine the number of pixels.
     total = this->Dimensionality * (outExt[1] - outExt[0] + 1) 
@@ -400,10 +451,10 @@ void vtkImageGaussianSmooth::ThreadedRequestData(
 
   // Decompose
   vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
-  vtkInformation *outInfo = outputVector->GetInformationObject(0);
   int wholeExt[6];
   inInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), wholeExt);
-  outInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), inExt);
+  // only the input needed by this piece is smoothed along the first axes
+  memcpy(inExt, outExt, 6*sizeof(int));
   this->InternalRequestUpdateExtent(inExt, wholeExt);
 
   switch (this->Dimensionality)
@@ -468,3 +519,612 @@ void vtkImageGaussianSmooth::ThreadedRequestData(
       break;
     }  
 }
+
+//----------------------------------------------------------------------------
+// The recursive filter processes beams of neighboring rows along the
+// filtered axis, so that its inner loops run across the rows of a beam.
+// The values of a beam are copied into a buffer of about this many doubles
+// per position along the axis.
+#define VTK_GAUSSIAN_SMOOTH_BEAM_WIDTH 64
+
+namespace
+{
+// The coefficients of the recursive filter along one axis:
+//   w[n] = B*x[n] + A[0]*w[n-1] + A[1]*w[n-2] + A[2]*w[n-3]
+// runs forward, then the same filter runs backward over w. When the input
+// is extended by its last value, the backward filter starts from
+//   y[N+i] = x[N-1] + sum_j M[i][j]*(w[N-1-j] - x[N-1]).
+struct vtkImageGaussianSmoothRecursiveAxis
+{
+  double B;
+  double A[3];
+  double M[3][3];
+  int DerivativeOrder;
+};
+
+// An image, or the temporary buffer, read or written by a pass
+struct vtkImageGaussianSmoothRecursiveImage
+{
+  char *Pointer; // at the first point of Extent
+  int Extent[6];
+  vtkIdType Increments[3];
+  int ScalarType;
+  int ScalarSize;
+};
+
+// The data shared by the threads filtering along one axis
+struct vtkImageGaussianSmoothRecursiveStruct
+{
+  vtkImageGaussianSmooth *Filter;
+  vtkImageGaussianSmoothRecursiveAxis Coefficients;
+  vtkImageGaussianSmoothRecursiveImage Input;
+  vtkImageGaussianSmoothRecursiveImage Output;
+  int NumberOfComponents;
+  int Axis;
+  // the rows of a beam are consecutive along LineAxis, and the beams are
+  // ordered along LineAxis then OuterAxis
+  int LineAxis;
+  int OuterAxis;
+  int Region[6]; // input range along Axis, rows along the other axes
+  int OutputRange[2]; // written along Axis
+  int LinesPerBeam;
+  int BeamsPerOuter;
+  vtkIdType NumberOfBeams;
+  int NumberOfThreads;
+  int Pass;
+  int NumberOfPasses;
+};
+}
+
+//----------------------------------------------------------------------------
+// The real part of 2*d/(d - 1)^2 for the pole d = rho*exp(i*phi), which is
+// its contribution to the variance of the forward-backward filter.
+static double vtkImageGaussianSmoothPoleVariance(double rho, double phi)
+{
+  double re = rho*cos(phi);
+  double im = rho*sin(phi);
+  double p = (re - 1)*(re - 1) - im*im;
+  double q = 2*(re - 1)*im;
+  return 2*(re*p + im*q)/(p*p + q*q);
+}
+
+//----------------------------------------------------------------------------
+// Compute the coefficients of the recursive gaussian of deviation 'sigma'.
+// The poles of van Vliet, Young and Verbeek (1998) are scaled so that the
+// impulse response has exactly the requested variance.
+static void vtkImageGaussianSmoothRecursiveCoefficients(
+  double sigma, vtkImageGaussianSmoothRecursiveAxis *axis)
+{
+  int i, j;
+  axis->B = 1.0;
+  for (i = 0; i < 3; i++)
+    {
+    axis->A[i] = 0.0;
+    for (j = 0; j < 3; j++)
+      {
+      axis->M[i][j] = 0.0;
+      }
+    }
+  if (sigma <= 0.0)
+    {
+    return;
+    }
+  if (sigma < 0.5)
+    {
+    sigma = 0.5;
+    }
+
+  // the poles for a scale of 1, as a complex pair and a real pole
+  const double rho0 = sqrt(1.40098*1.40098 + 1.00236*1.00236);
+  const double phi0 = atan2(1.00236, 1.40098);
+  const double d30 = 1.85132;
+
+  // the variance grows with the scale q, find q by bisection
+  double qmin = 0.0;
+  double qmax = 1.0;
+  for (;;)
+    {
+    double var = 2*vtkImageGaussianSmoothPoleVariance(pow(rho0, 1/qmax),
+                                                      phi0/qmax) +
+      vtkImageGaussianSmoothPoleVariance(pow(d30, 1/qmax), 0.0);
+    if (var >= sigma*sigma)
+      {
+      break;
+      }
+    qmin = qmax;
+    qmax *= 2;
+    }
+  for (i = 0; i < 100; i++)
+    {
+    double q = 0.5*(qmin + qmax);
+    double var = 2*vtkImageGaussianSmoothPoleVariance(pow(rho0, 1/q),
+                                                      phi0/q) +
+      vtkImageGaussianSmoothPoleVariance(pow(d30, 1/q), 0.0);
+    if (var < sigma*sigma)
+      {
+      qmin = q;
+      }
+    else
+      {
+      qmax = q;
+      }
+    }
+  double q = 0.5*(qmin + qmax);
+  double rho = pow(rho0, 1/q);
+  double c = rho*cos(phi0/q);
+  double d3 = pow(d30, 1/q);
+
+  double b0 = rho*rho*d3;
+  axis->A[0] = (rho*rho + 2*c*d3)/b0;
+  axis->A[1] = -(2*c + d3)/b0;
+  axis->A[2] = 1/b0;
+  axis->B = 1 - axis->A[0] - axis->A[1] - axis->A[2];
+
+  // For each of the last three values of the forward filter, extend the
+  // forward filter with a null input until it vanishes, then run the
+  // backward filter over this extension to get its initial values.
+  vtkstd::vector<double> ext;
+  for (j = 0; j < 3; j++)
+    {
+    double w1 = (j == 0), w2 = (j == 1), w3 = (j == 2);
+    ext.clear();
+    while (ext.size() < 1000000 &&
+           (fabs(w1) > 1e-20 || fabs(w2) > 1e-20 || fabs(w3) > 1e-20))
+      {
+      double w = axis->A[0]*w1 + axis->A[1]*w2 + axis->A[2]*w3;
+      ext.push_back(w);
+      w3 = w2;
+      w2 = w1;
+      w1 = w;
+      }
+    double y1 = 0, y2 = 0, y3 = 0;
+    for (size_t n = ext.size(); n > 0; n--)
+      {
+      double y = axis->B*ext[n-1] + axis->A[0]*y1 + axis->A[1]*y2 +
+        axis->A[2]*y3;
+      y3 = y2;
+      y2 = y1;
+      y1 = y;
+      }
+    axis->M[0][j] = y1;
+    axis->M[1][j] = y2;
+    axis->M[2][j] = y3;
+    }
+}
+
+//----------------------------------------------------------------------------
+// Filter the 'length' rows of 'width' values starting at 'row'. The three
+// rows before and after them are used as boundary values, and 'last'
+// holds one row of scratch space.
+static void vtkImageGaussianSmoothRecursiveRows(
+  const vtkImageGaussianSmoothRecursiveAxis &axis, double *row,
+  int length, int width, double *last)
+{
+  const double b = axis.B;
+  const double a1 = axis.A[0];
+  const double a2 = axis.A[1];
+  const double a3 = axis.A[2];
+  int i, j, n;
+
+  // the input is extended by its first value before the first row
+  for (i = 1; i <= 3; i++)
+    {
+    double *pre = row - i*width;
+    for (j = 0; j < width; j++)
+      {
+      pre[j] = row[j];
+      }
+    }
+  for (j = 0; j < width; j++)
+    {
+    last[j] = row[(length - 1)*width + j];
+    }
+
+  // forward
+  for (n = 0; n < length; n++)
+    {
+    double *w = row + n*width;
+    const double *w1 = w - width;
+    const double *w2 = w1 - width;
+    const double *w3 = w2 - width;
+    for (j = 0; j < width; j++)
+      {
+      w[j] = b*w[j] + a1*w1[j] + a2*w2[j] + a3*w3[j];
+      }
+    }
+
+  // initial values of the backward filter, from the forward state
+  const double *w1 = row + (length - 1)*width;
+  const double *w2 = w1 - width;
+  const double *w3 = w2 - width;
+  for (i = 0; i < 3; i++)
+    {
+    double *post = row + (length + i)*width;
+    const double *m = axis.M[i];
+    for (j = 0; j < width; j++)
+      {
+      double u = last[j];
+      post[j] = u + m[0]*(w1[j] - u) + m[1]*(w2[j] - u) + m[2]*(w3[j] - u);
+      }
+    }
+
+  // backward
+  for (n = length - 1; n >= 0; n--)
+    {
+    double *y = row + n*width;
+    const double *y1 = y + width;
+    const double *y2 = y1 + width;
+    const double *y3 = y2 + width;
+    for (j = 0; j < width; j++)
+      {
+      y[j] = b*y[j] + a1*y1[j] + a2*y2[j] + a3*y3[j];
+      }
+    }
+
+  // derivatives by central differences, replicating the edge rows
+  if (axis.DerivativeOrder > 0)
+    {
+    double *next = row + length*width;
+    for (j = 0; j < width; j++)
+      {
+      last[j] = row[j];
+      next[j] = row[(length - 1)*width + j];
+      }
+    for (n = 0; n < length; n++)
+      {
+      double *y = row + n*width;
+      const double *y1 = y + width;
+      if (axis.DerivativeOrder == 1)
+        {
+        for (j = 0; j < width; j++)
+          {
+          double y0 = y[j];
+          y[j] = 0.5*(y1[j] - last[j]);
+          last[j] = y0;
+          }
+        }
+      else
+        {
+        for (j = 0; j < width; j++)
+          {
+          double y0 = y[j];
+          y[j] = y1[j] - 2*y0 + last[j];
+          last[j] = y0;
+          }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Round and clamp the filtered values to the range of the output type.
+template <class T>
+inline void vtkImageGaussianSmoothRound(double val, T &out)
+{
+  if (val <= static_cast<double>(vtkTypeTraits<T>::Min()))
+    {
+    out = vtkTypeTraits<T>::Min();
+    }
+  else if (val >= static_cast<double>(vtkTypeTraits<T>::Max()))
+    {
+    out = vtkTypeTraits<T>::Max();
+    }
+  else
+    {
+    out = static_cast<T>(floor(val + 0.5));
+    }
+}
+
+inline void vtkImageGaussianSmoothRound(double val, float &out)
+{
+  out = static_cast<float>(val);
+}
+
+inline void vtkImageGaussianSmoothRound(double val, double &out)
+{
+  out = val;
+}
+
+//----------------------------------------------------------------------------
+// Copy 'lines' rows of 'length' values along the filtered axis into the
+// rows of the beam buffer, which are 'lines' times the number of
+// components wide.
+template <class T>
+void vtkImageGaussianSmoothLoadBeam(const T *inPtr, vtkIdType incA,
+                                    vtkIdType incL, int length, int lines,
+                                    int numComp, double *row)
+{
+  int width = lines*numComp;
+  for (int n = 0; n < length; n++)
+    {
+    const T *linePtr = inPtr + n*incA;
+    double *w = row + n*width;
+    for (int l = 0; l < lines; l++)
+      {
+      const T *ptr = linePtr + l*incL;
+      for (int c = 0; c < numComp; c++)
+        {
+        *w++ = static_cast<double>(ptr[c]);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Copy the rows 'begin' to 'begin + length - 1' of the beam buffer back to
+// the image.
+template <class T>
+void vtkImageGaussianSmoothStoreBeam(const double *row, int begin,
+                                     int length, T *outPtr, vtkIdType incA,
+                                     vtkIdType incL, int lines, int numComp)
+{
+  int width = lines*numComp;
+  for (int n = 0; n < length; n++)
+    {
+    T *linePtr = outPtr + n*incA;
+    const double *w = row + (begin + n)*width;
+    for (int l = 0; l < lines; l++)
+      {
+      T *ptr = linePtr + l*incL;
+      for (int c = 0; c < numComp; c++)
+        {
+        vtkImageGaussianSmoothRound(*w++, ptr[c]);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+static char *vtkImageGaussianSmoothRecursivePointer(
+  const vtkImageGaussianSmoothRecursiveImage &image, const int idx[3])
+{
+  return image.Pointer +
+    ((idx[0] - image.Extent[0])*image.Increments[0] +
+     (idx[1] - image.Extent[2])*image.Increments[1] +
+     (idx[2] - image.Extent[4])*image.Increments[2])*image.ScalarSize;
+}
+
+//----------------------------------------------------------------------------
+// Filter a contiguous range of beams along the axis.
+static VTK_THREAD_RETURN_TYPE vtkImageGaussianSmoothRecursiveThread(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkImageGaussianSmoothRecursiveStruct *ts =
+    static_cast<vtkImageGaussianSmoothRecursiveStruct *>(info->UserData);
+  int threadId = info->ThreadID;
+  vtkIdType begin = ts->NumberOfBeams*threadId/ts->NumberOfThreads;
+  vtkIdType end = ts->NumberOfBeams*(threadId + 1)/ts->NumberOfThreads;
+
+  int axis = ts->Axis;
+  int lineAxis = ts->LineAxis;
+  int outerAxis = ts->OuterAxis;
+  int numComp = ts->NumberOfComponents;
+  int length = ts->Region[2*axis+1] - ts->Region[2*axis] + 1;
+  int outBegin = ts->OutputRange[0] - ts->Region[2*axis];
+  int outLength = ts->OutputRange[1] - ts->OutputRange[0] + 1;
+
+  // three boundary rows on each side, and one row of scratch space
+  vtkstd::vector<double> buffer((length + 7)*ts->LinesPerBeam*numComp);
+
+  vtkIdType progressStep = (end - begin)/10 + 1;
+  for (vtkIdType beam = begin;
+       beam < end && !ts->Filter->GetAbortExecute(); beam++)
+    {
+    int outer = static_cast<int>(beam / ts->BeamsPerOuter);
+    int firstLine = ts->Region[2*lineAxis] +
+      static_cast<int>(beam % ts->BeamsPerOuter)*ts->LinesPerBeam;
+    int lines = ts->Region[2*lineAxis+1] - firstLine + 1;
+    lines = (lines < ts->LinesPerBeam ? lines : ts->LinesPerBeam);
+    int width = lines*numComp;
+
+    int idx[3];
+    idx[axis] = ts->Region[2*axis];
+    idx[lineAxis] = firstLine;
+    idx[outerAxis] = ts->Region[2*outerAxis] + outer;
+    void *inPtr = vtkImageGaussianSmoothRecursivePointer(ts->Input, idx);
+    idx[axis] = ts->OutputRange[0];
+    void *outPtr = vtkImageGaussianSmoothRecursivePointer(ts->Output, idx);
+
+    double *row = &buffer[3*width];
+    double *last = &buffer[(length + 6)*width];
+
+    switch (ts->Input.ScalarType)
+      {
+      vtkTemplateMacro(
+        vtkImageGaussianSmoothLoadBeam(static_cast<VTK_TT *>(inPtr),
+                                       ts->Input.Increments[axis],
+                                       ts->Input.Increments[lineAxis],
+                                       length, lines, numComp, row));
+      }
+    vtkImageGaussianSmoothRecursiveRows(ts->Coefficients, row, length, width,
+                                        last);
+    switch (ts->Output.ScalarType)
+      {
+      vtkTemplateMacro(
+        vtkImageGaussianSmoothStoreBeam(row, outBegin, outLength,
+                                        static_cast<VTK_TT *>(outPtr),
+                                        ts->Output.Increments[axis],
+                                        ts->Output.Increments[lineAxis],
+                                        lines, numComp));
+      }
+
+    if (threadId == 0 && (beam - begin + 1) % progressStep == 0)
+      {
+      ts->Filter->UpdateProgress(
+        (ts->Pass + static_cast<double>(beam - begin + 1)/(end - begin)) /
+        ts->NumberOfPasses);
+      }
+    }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+static void vtkImageGaussianSmoothRecursiveSetImage(
+  vtkImageData *data, vtkImageGaussianSmoothRecursiveImage *image)
+{
+  data->GetExtent(image->Extent);
+  vtkIdType *incs = data->GetIncrements();
+  image->Increments[0] = incs[0];
+  image->Increments[1] = incs[1];
+  image->Increments[2] = incs[2];
+  image->ScalarType = data->GetScalarType();
+  image->ScalarSize = data->GetScalarSize();
+  image->Pointer = static_cast<char *>(data->GetScalarPointer());
+}
+
+//----------------------------------------------------------------------------
+// The recursive filter needs whole rows along each axis, so instead of
+// splitting the output extent, each axis is filtered in turn over the whole
+// extent, by threads sharing its beams of rows. The intermediate results
+// are kept in a float buffer, or double for the scalar types of more than
+// 16 bits, which is the output itself when it has this type and extent.
+void vtkImageGaussianSmooth::RecursiveExecute(vtkImageData *inData,
+                                              int inExt[6],
+                                              vtkImageData *outData,
+                                              int outExt[6])
+{
+  int i;
+  int numAxes = this->Dimensionality;
+  int numComp = inData->GetNumberOfScalarComponents();
+  int scalarType = outData->GetScalarType();
+  int bufferType = VTK_DOUBLE;
+  if (scalarType == VTK_FLOAT || outData->GetScalarSize() <= 2)
+    {
+    bufferType = VTK_FLOAT;
+    }
+
+  vtkImageGaussianSmoothRecursiveImage input, output, temp;
+  vtkImageGaussianSmoothRecursiveSetImage(inData, &input);
+  vtkImageGaussianSmoothRecursiveSetImage(outData, &output);
+  temp = output;
+  vtkImageData *tempData = 0;
+  if (numAxes > 1 && (bufferType != scalarType ||
+                      memcmp(inExt, outExt, 6*sizeof(int)) != 0))
+    {
+    tempData = vtkImageData::New();
+    tempData->SetExtent(inExt);
+    tempData->SetNumberOfScalarComponents(numComp);
+    tempData->SetScalarType(bufferType);
+    tempData->AllocateScalars();
+    vtkImageGaussianSmoothRecursiveSetImage(tempData, &temp);
+    }
+
+  vtkImageGaussianSmoothRecursiveStruct ts;
+  ts.Filter = this;
+  ts.NumberOfComponents = numComp;
+  ts.NumberOfPasses = numAxes;
+  int maxThreads = vtkMultiThreader::GetGlobalMaximumNumberOfThreads();
+
+  for (int pass = 0; pass < numAxes && !this->AbortExecute; pass++)
+    {
+    int axis = pass;
+    ts.Pass = pass;
+    ts.Axis = axis;
+    ts.LineAxis = (axis == 0 ? 1 : 0);
+    ts.OuterAxis = 3 - axis - ts.LineAxis;
+    vtkImageGaussianSmoothRecursiveCoefficients(
+      this->StandardDeviations[axis], &ts.Coefficients);
+    ts.Coefficients.DerivativeOrder = this->DerivativeOrders[axis];
+
+    // Only the rows needed by the following passes are filtered: the axes
+    // still to be filtered over their whole extent, the others over the
+    // output extent.
+    ts.Input = (pass == 0 ? input : temp);
+    ts.Output = (pass == numAxes - 1 ? output : temp);
+    for (i = 0; i < 3; i++)
+      {
+      int *ext = ((i >= axis && i < numAxes) ? inExt : outExt);
+      ts.Region[2*i] = ext[2*i];
+      ts.Region[2*i+1] = ext[2*i+1];
+      }
+    int *range = (pass == numAxes - 1 ? outExt : inExt);
+    ts.OutputRange[0] = range[2*axis];
+    ts.OutputRange[1] = range[2*axis+1];
+
+    int numLines = ts.Region[2*ts.LineAxis+1] - ts.Region[2*ts.LineAxis] + 1;
+    int numOuter = ts.Region[2*ts.OuterAxis+1] -
+      ts.Region[2*ts.OuterAxis] + 1;
+    ts.LinesPerBeam = VTK_GAUSSIAN_SMOOTH_BEAM_WIDTH/numComp;
+    ts.LinesPerBeam = (ts.LinesPerBeam < 1 ? 1 : ts.LinesPerBeam);
+    ts.LinesPerBeam = (ts.LinesPerBeam < numLines ? ts.LinesPerBeam :
+                       numLines);
+    ts.BeamsPerOuter = (numLines + ts.LinesPerBeam - 1)/ts.LinesPerBeam;
+    ts.NumberOfBeams = static_cast<vtkIdType>(ts.BeamsPerOuter)*numOuter;
+
+    int numThreads = this->NumberOfThreads;
+    if (maxThreads > 0 && numThreads > maxThreads)
+      {
+      numThreads = maxThreads;
+      }
+    if (numThreads > ts.NumberOfBeams)
+      {
+      numThreads = static_cast<int>(ts.NumberOfBeams);
+      }
+    ts.NumberOfThreads = (numThreads < 1 ? 1 : numThreads);
+
+    this->Threader->SetNumberOfThreads(ts.NumberOfThreads);
+    this->Threader->SetSingleMethod(vtkImageGaussianSmoothRecursiveThread,
+                                    &ts);
+    this->Threader->SingleMethodExecute();
+    }
+
+  if (tempData)
+    {
+    tempData->Delete();
+    }
+}
+
+//----------------------------------------------------------------------------
+// The kernel filter is executed by the superclass over pieces of the
+// output extent, the recursive filter by RecursiveExecute().
+int vtkImageGaussianSmooth::RequestData(vtkInformation *request,
+                                        vtkInformationVector **inputVector,
+                                        vtkInformationVector *outputVector)
+{
+  if (!this->UseRecursiveFilter)
+    {
+    return this->Superclass::RequestData(request, inputVector, outputVector);
+    }
+
+  vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
+  vtkInformation *outInfo = outputVector->GetInformationObject(0);
+  vtkImageData *inData = vtkImageData::SafeDownCast(
+    inInfo->Get(vtkDataObject::DATA_OBJECT()));
+  vtkImageData *outData = vtkImageData::SafeDownCast(
+    outInfo->Get(vtkDataObject::DATA_OBJECT()));
+
+  int inExt[6], outExt[6], wholeExt[6];
+  outInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), outExt);
+  this->AllocateOutputData(outData, outExt);
+  this->CopyAttributeData(inData, outData, inputVector);
+
+  // this filter expects that input is the same type as output.
+  if (inData->GetScalarType() != outData->GetScalarType())
+    {
+    vtkErrorMacro("Execute: input ScalarType, "
+                  << inData->GetScalarType()
+                  << ", must match out ScalarType "
+                  << outData->GetScalarType());
+    return 1;
+    }
+  if (this->Dimensionality < 1 || this->Dimensionality > 3)
+    {
+    vtkErrorMacro("Execute: Dimensionality " << this->Dimensionality
+                  << " is not 1, 2 or 3");
+    return 1;
+    }
+  if (outExt[0] > outExt[1] || outExt[2] > outExt[3] ||
+      outExt[4] > outExt[5])
+    {
+    return 1;
+    }
+
+  inInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), wholeExt);
+  memcpy(inExt, outExt, 6*sizeof(int));
+  this->InternalRequestUpdateExtent(inExt, wholeExt);
+  this->RecursiveExecute(inData, inExt, outData, outExt);
+
+  return 1;
+}
@@ -16,6 +16,13 @@
 // .SECTION Description
 // vtkImageGaussianSmooth implements a convolution of the input image
 // with a gaussian. Supports from one to three dimensional convolutions.
+//
+// By default each axis is convolved with a gaussian kernel whose size, and
+// cost per pixel, grows with the standard deviation. With
+// UseRecursiveFilter on, each axis is instead filtered by a third order
+// recursive filter (Young and van Vliet) running forward then backward
+// along whole rows, whose cost per pixel does not depend on the standard
+// deviation, and which can compute the derivatives of the gaussian.
 
 #ifndef __vtkImageGaussianSmooth_h
 #define __vtkImageGaussianSmooth_h
@@ -69,6 +76,27 @@ public:
   vtkSetMacro(Dimensionality, int);
   vtkGetMacro(Dimensionality, int);
 
+  // Description:
+  // Turn on/off the recursive filter. It approximates the gaussian within
+  // about 1% for standard deviations of 2 pixels or more, and replicates
+  // the edge pixels of the whole extent instead of clipping the kernel.
+  // Deviations smaller than 0.5 pixel are rounded up to 0.5. The
+  // RadiusFactors are not used, and the whole extent of the filtered axes
+  // is requested from the input. Off by default.
+  vtkSetMacro(UseRecursiveFilter, int);
+  vtkGetMacro(UseRecursiveFilter, int);
+  vtkBooleanMacro(UseRecursiveFilter, int);
+
+  // Description:
+  // Set/Get the order (0, 1 or 2) of the derivative of the gaussian
+  // computed along each axis by the recursive filter, in pixel units.
+  // Orders outside 0..2 are clamped to that range when set. Unsigned
+  // outputs are clamped at zero. Default is (0, 0, 0).
+  void SetDerivativeOrders(int x, int y, int z);
+  void SetDerivativeOrders(int orders[3])
+    {this->SetDerivativeOrders(orders[0], orders[1], orders[2]);}
+  vtkGetVector3Macro(DerivativeOrders, int);
+
 protected:
   vtkImageGaussianSmooth();
   ~vtkImageGaussianSmooth();
@@ -76,6 +104,8 @@ protected:
   int Dimensionality;
   double StandardDeviations[3];
   double RadiusFactors[3];
+  int UseRecursiveFilter;
+  int DerivativeOrders[3];
   
   void ComputeKernel(double *kernel, int min, int max, double std);
   virtual int RequestUpdateExtent (vtkInformation *, vtkInformationVector **, vtkInformationVector *);
@@ -89,6 +119,12 @@ protected:
                            vtkInformationVector *outputVector,
                            vtkImageData ***inData, vtkImageData **outData,
                            int outExt[6], int id);
+
+  virtual int RequestData(vtkInformation *request,
+                          vtkInformationVector **inputVector,
+                          vtkInformationVector *outputVector);
+  void RecursiveExecute(vtkImageData *inData, int inExt[6],
+                        vtkImageData *outData, int outExt[6]);
   
 private:
   vtkImageGaussianSmooth(const vtkImageGaussianSmooth&);  // Not implemented.
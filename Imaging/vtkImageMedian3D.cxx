@@ -23,6 +23,9 @@
 #include "vtkPointData.h"
 #include "vtkStreamingDemandDrivenPipeline.h"
 
+#include <vtkstd/algorithm>
+#include <vtkstd/vector>
+
 vtkStandardNewMacro(vtkImageMedian3D);
 
 //-----------------------------------------------------------------------------
@@ -32,6 +35,9 @@ vtkImageMedian3D::vtkImageMedian3D()
   this->NumberOfElements = 0;
   this->SetKernelSize(1,1,1);
   this->HandleBoundaries = 1;
+  this->Rank = 0.5;
+  // the rows are processed whole
+  this->SplitMode = VTK_IMAGE_SPLIT_BEAM;
 }
 
 //-----------------------------------------------------------------------------
@@ -45,6 +51,7 @@ void vtkImageMedian3D::PrintSelf(ostream& os, vtkIndent indent)
   this->Superclass::PrintSelf(os, indent);
 
   os << indent << "NumberOfElements: " << this->NumberOfElements << endl;
+  os << indent << "Rank: " << this->Rank << endl;
 }
 
 //-----------------------------------------------------------------------------
@@ -81,106 +88,124 @@ void vtkImageMedian3D::SetKernelSize(int size0, int size1, int size2)
 }
 
 //-----------------------------------------------------------------------------
-// Add a sample to the median computation
-double *vtkImageMedian3DAccumulateMedian(int &UpNum, int &DownNum,
-                                         int &UpMax, int &DownMax,
-                                         int &NumNeighborhood,
-                                         double *Median, double val)
+// The values of at most this many integers are counted in a histogram.
+#define VTK_IMAGE_MEDIAN3D_MAX_BINS 65536
+
+namespace {
+
+// Counts of the integers of a range, grouped into blocks of about the
+// square root of the number of bins.  The bin of a rank is found by moving
+// from the block of the previous rank, then scanning its block.
+class vtkImageMedian3DHistogram
 {
-  int idx, max;
-  double temp, *ptr;
+public:
+  void Initialize(int numberOfBins)
+    {
+    this->BlockBits = 0;
+    while ((1 << (2*this->BlockBits)) < numberOfBins)
+      {
+      ++this->BlockBits;
+      }
+    this->Bins.assign(numberOfBins, 0);
+    this->Blocks.assign(((numberOfBins - 1) >> this->BlockBits) + 1, 0);
+    this->Block = 0;
+    this->Below = 0;
+    this->Count = 0;
+    }
+
+  void Add(int bin)
+    {
+    int block = bin >> this->BlockBits;
+    ++this->Bins[bin];
+    ++this->Blocks[block];
+    this->Below += (block < this->Block);
+    ++this->Count;
+    }
 
-  // special case: no samples yet 
-  if (UpNum == 0)
+  void Remove(int bin)
     {
-    *(Median) = val;
-    // length of up and down arrays inclusive of current 
-    UpNum = DownNum = 1; 
-    // median is gaurenteed to be in this range (length of array) 
-    DownMax = UpMax = (NumNeighborhood + 1) / 2;
-    return Median;
+    int block = bin >> this->BlockBits;
+    --this->Bins[bin];
+    --this->Blocks[block];
+    this->Below -= (block < this->Block);
+    --this->Count;
     }
 
-  // Case: value is above median 
-  if (val >= *(Median))
+  // Returns the bin of the value of the given rank, 0 being the smallest.
+  int GetBin(int rank)
     {
-    // move the median if necessary
-    if (UpNum > DownNum)
+    while (this->Below > rank)
       {
-      // Move the median Up one 
-      ++Median;
-      --UpNum;
-      ++DownNum;
-      --UpMax;
-      ++DownMax;
+      --this->Block;
+      this->Below -= this->Blocks[this->Block];
       }
-    // find the position for val in the sorted array
-    max = (UpNum < UpMax) ? UpNum : UpMax;
-    ptr = Median;
-    idx = 0;
-    while (idx < max && val >= *ptr)
+    while (this->Below + this->Blocks[this->Block] <= rank)
       {
-      ++ptr;
-      ++idx;
+      this->Below += this->Blocks[this->Block];
+      ++this->Block;
       }
-    // place val and move all others up
-    while (idx < max)
+    // scan the block from its nearest end
+    int bin;
+    int sum;
+    if (2*(rank - this->Below) < this->Blocks[this->Block])
       {
-      temp = *ptr;
-      *ptr = val;
-      val = temp;
-      ++ptr;
-      ++idx;
+      bin = this->Block << this->BlockBits;
+      sum = this->Below + this->Bins[bin];
+      while (sum <= rank)
+        {
+        sum += this->Bins[++bin];
+        }
+      }
+    else
+      {
+      bin = ((this->Block + 1) << this->BlockBits) - 1;
+      if (bin >= static_cast<int>(this->Bins.size()))
+        {
+        bin = static_cast<int>(this->Bins.size()) - 1;
+        }
+      sum = this->Below + this->Blocks[this->Block] - this->Bins[bin];
+      while (sum > rank)
+        {
+        sum -= this->Bins[--bin];
+        }
       }
-    *ptr = val;
-    // Update counts
-    ++UpNum;
-    --DownMax;
-    return Median;
+    return bin;
     }
 
-  // Case: value is below median 
-  // If we got here, val < *(Median)
+  int Count;
 
-  // move the median if necessary
-  if (DownNum > UpNum)
-    {
-    // Move the median Down one 
-    --Median;
-    --DownNum;
-    ++UpNum;
-    --DownMax;
-    ++UpMax;
-    }
-  // find the position for val in the sorted array
-  max = (DownNum < DownMax) ? DownNum : DownMax;
-  ptr = Median;
-  idx = 0;
-  while (idx < max && val <= *ptr)
-    {
-    --ptr;
-    ++idx;
-    }
-  // place val and move all others up
-  while (idx < max)
-    {
-    temp = *ptr;
-    *ptr = val;
-    val = temp;
-    --ptr;
-    ++idx;
-    }
-  *ptr = val;
-  // Update counts
-  ++DownNum;
-  --UpMax;
+private:
+  vtkstd::vector<int> Bins;
+  vtkstd::vector<int> Blocks;
+  int BlockBits;
+  int Block;
+  int Below;
+};
+
+} // end anonymous namespace
 
-  return Median;
+//-----------------------------------------------------------------------------
+template <class T>
+inline int vtkImageMedian3DIsInteger(T *)
+{
+  return (static_cast<T>(0.5) == static_cast<T>(0));
+}
+
+//-----------------------------------------------------------------------------
+// The index of the rank, as a fraction, among n sorted values.
+inline int vtkImageMedian3DRankIndex(double rank, int n)
+{
+  return static_cast<int>(rank*(n - 1) + 0.5);
 }
 
 //-----------------------------------------------------------------------------
 // This method contains the second switch statement that calls the correct
-// templated function for the mask types.
+// templated function for the mask types.  Each component of each row of
+// the output is computed in turn, with the neighborhood clipped by the
+// input extent.  Integer values are counted in a histogram when their
+// range is small enough: the histogram slides along the row, gaining and
+// losing one slice of the neighborhood per pixel.  Other values of the
+// neighborhood are copied and partially sorted for each pixel.
 template <class T>
 void vtkImageMedian3DExecute(vtkImageMedian3D *self,
                              vtkImageData *inData, T *inPtr, 
@@ -189,27 +214,18 @@ void vtkImageMedian3DExecute(vtkImageMedian3D *self,
                              vtkDataArray *inArray)
 {
   int *kernelMiddle, *kernelSize;
-  int NumberOfElements;
+  double rank;
   // For looping though output (and input) pixels.
   int outIdx0, outIdx1, outIdx2;
-  vtkIdType inInc0, inInc1, inInc2;
+  vtkIdType inInc[3], outInc[3];
   int outIdxC;
-  vtkIdType outIncX, outIncY, outIncZ;
-  T *inPtr0, *inPtr1, *inPtr2;
+  T *inPtr1, *outPtr0;
   // For looping through hood pixels
-  int hoodMin0, hoodMax0, hoodMin1, hoodMax1, hoodMin2, hoodMax2;
-  int hoodStartMin0, hoodStartMax0, hoodStartMin1, hoodStartMax1;
+  int hoodExt[6], hoodMin0, hoodMax0, hoodMin1, hoodMax1, hoodMin2, hoodMax2;
+  int newMin0, newMax0;
   int hoodIdx0, hoodIdx1, hoodIdx2;
   T *tmpPtr0, *tmpPtr1, *tmpPtr2;
-  // The portion of the out image that needs no boundary processing.
-  int middleMin0, middleMax0, middleMin1, middleMax1, middleMin2, middleMax2;
-  int numComp;
-  // variables for the median calc
-  int UpNum = 0;
-  int DownNum = 0;
-  int UpMax = 0;
-  int DownMax = 0;
-  double *Median;
+  int axis, numComp;
   int *inExt;
   unsigned long count = 0;
   unsigned long target;
@@ -219,65 +235,86 @@ void vtkImageMedian3DExecute(vtkImageMedian3D *self,
     return;
     }
   
-  double *Sort = new double[(self->GetNumberOfElements() + 8)];
-  
   // Get information to march through data
-  inData->GetIncrements(inInc0, inInc1, inInc2); 
-  outData->GetContinuousIncrements(outExt, outIncX, outIncY, outIncZ);
+  inData->GetArrayIncrements(inArray, inInc);
+  outData->GetIncrements(outInc);
   kernelMiddle = self->GetKernelMiddle();
   kernelSize = self->GetKernelSize();
+  rank = self->GetRank();
   
   numComp = inArray->GetNumberOfComponents();
 
-  hoodMin0 = outExt[0] - kernelMiddle[0]; 
-  hoodMin1 = outExt[2] - kernelMiddle[1]; 
-  hoodMin2 = outExt[4] - kernelMiddle[2]; 
-  hoodMax0 = kernelSize[0] + hoodMin0 - 1;
-  hoodMax1 = kernelSize[1] + hoodMin1 - 1;
-  hoodMax2 = kernelSize[2] + hoodMin2 - 1;
-  
-  // Clip by the input image extent
+  // The neighborhood of the whole output extent, clipped by the input
+  // image extent
   inExt = inData->GetExtent();
-  hoodMin0 = (hoodMin0 > inExt[0]) ? hoodMin0 : inExt[0];
-  hoodMin1 = (hoodMin1 > inExt[2]) ? hoodMin1 : inExt[2];
-  hoodMin2 = (hoodMin2 > inExt[4]) ? hoodMin2 : inExt[4];
-  hoodMax0 = (hoodMax0 < inExt[1]) ? hoodMax0 : inExt[1];
-  hoodMax1 = (hoodMax1 < inExt[3]) ? hoodMax1 : inExt[3];
-  hoodMax2 = (hoodMax2 < inExt[5]) ? hoodMax2 : inExt[5];
-
-  // Save the starting neighborhood dimensions (2 loops only once)
-  hoodStartMin0 = hoodMin0;    hoodStartMax0 = hoodMax0;
-  hoodStartMin1 = hoodMin1;    hoodStartMax1 = hoodMax1;
-  
-  // The portion of the output that needs no boundary computation.
-  middleMin0 = inExt[0] + kernelMiddle[0];
-  middleMax0 = inExt[1] - (kernelSize[0] - 1) + kernelMiddle[0];
-  middleMin1 = inExt[2] + kernelMiddle[1];
-  middleMax1 = inExt[3] - (kernelSize[1] - 1) + kernelMiddle[1];
-  middleMin2 = inExt[4] + kernelMiddle[2];
-  middleMax2 = inExt[5] - (kernelSize[2] - 1) + kernelMiddle[2];
-  
+  for (axis = 0; axis < 3; ++axis)
+    {
+    hoodExt[2*axis] = outExt[2*axis] - kernelMiddle[axis];
+    hoodExt[2*axis] = (hoodExt[2*axis] > inExt[2*axis]) ?
+      hoodExt[2*axis] : inExt[2*axis];
+    hoodExt[2*axis+1] = outExt[2*axis+1] - kernelMiddle[axis] +
+      kernelSize[axis] - 1;
+    hoodExt[2*axis+1] = (hoodExt[2*axis+1] < inExt[2*axis+1]) ?
+      hoodExt[2*axis+1] : inExt[2*axis+1];
+    }
+
+  // Find the range of integer values
+  T minValue = 0;
+  T maxValue = 0;
+  int useHistogram = vtkImageMedian3DIsInteger(inPtr);
+  if (useHistogram)
+    {
+    int rowSize = (hoodExt[1] - hoodExt[0] + 1)*numComp;
+    tmpPtr2 = inPtr + (hoodExt[0] - inExt[0])*inInc[0] +
+      (hoodExt[2] - inExt[2])*inInc[1] + (hoodExt[4] - inExt[4])*inInc[2];
+    minValue = maxValue = *tmpPtr2;
+    for (hoodIdx2 = hoodExt[4]; hoodIdx2 <= hoodExt[5]; ++hoodIdx2)
+      {
+      tmpPtr1 = tmpPtr2;
+      for (hoodIdx1 = hoodExt[2]; hoodIdx1 <= hoodExt[3]; ++hoodIdx1)
+        {
+        // all the components of the row
+        tmpPtr0 = tmpPtr1;
+        for (hoodIdx0 = 0; hoodIdx0 < rowSize; ++hoodIdx0)
+          {
+          minValue = (*tmpPtr0 < minValue ? *tmpPtr0 : minValue);
+          maxValue = (*tmpPtr0 > maxValue ? *tmpPtr0 : maxValue);
+          ++tmpPtr0;
+          }
+        tmpPtr1 += inInc[1];
+        }
+      tmpPtr2 += inInc[2];
+      }
+    useHistogram = (static_cast<double>(maxValue) -
+                    static_cast<double>(minValue) <
+                    VTK_IMAGE_MEDIAN3D_MAX_BINS);
+    }
+  vtkImageMedian3DHistogram histogram;
+  if (useHistogram)
+    {
+    histogram.Initialize(static_cast<int>(maxValue - minValue) + 1);
+    }
+  vtkstd::vector<T> hood;
+  if (!useHistogram)
+    {
+    hood.resize(self->GetNumberOfElements());
+    }
+
   target = static_cast<unsigned long>((outExt[5] - outExt[4] + 1)*
                                       (outExt[3] - outExt[2] + 1)/50.0);
   target++;
   
-  NumberOfElements = self->GetNumberOfElements();
-
   // loop through pixel of output
-  inPtr = static_cast<T *>(
-    inArray->GetVoidPointer((hoodMin0 - inExt[0])* inInc0 + 
-                            (hoodMin1 - inExt[2])* inInc1 +
-                            (hoodMin2 - inExt[4])* inInc2));
-  inPtr2 = inPtr;
   for (outIdx2 = outExt[4]; outIdx2 <= outExt[5]; ++outIdx2)
     {
-    inPtr1 = inPtr2;
-    hoodMin1 = hoodStartMin1;
-    hoodMax1 = hoodStartMax1;
+    hoodMin2 = outIdx2 - kernelMiddle[2];
+    hoodMin2 = (hoodMin2 > inExt[4]) ? hoodMin2 : inExt[4];
+    hoodMax2 = outIdx2 - kernelMiddle[2] + kernelSize[2] - 1;
+    hoodMax2 = (hoodMax2 < inExt[5]) ? hoodMax2 : inExt[5];
     for (outIdx1 = outExt[2]; 
          !self->AbortExecute && outIdx1 <= outExt[3]; ++outIdx1)
       {
-      if (!id) 
+      if (!id && self->GetSplitMode() == VTK_IMAGE_SPLIT_SLAB)
         {
         if (!(count%target))
           {
@@ -285,84 +322,106 @@ void vtkImageMedian3DExecute(vtkImageMedian3D *self,
           }
         count++;
         }
-      inPtr0 = inPtr1;
-      hoodMin0 = hoodStartMin0;
-      hoodMax0 = hoodStartMax0;
-      for (outIdx0 = outExt[0]; outIdx0 <= outExt[1]; ++outIdx0)
+      hoodMin1 = outIdx1 - kernelMiddle[1];
+      hoodMin1 = (hoodMin1 > inExt[2]) ? hoodMin1 : inExt[2];
+      hoodMax1 = outIdx1 - kernelMiddle[1] + kernelSize[1] - 1;
+      hoodMax1 = (hoodMax1 < inExt[3]) ? hoodMax1 : inExt[3];
+      for (outIdxC = 0; outIdxC < numComp; outIdxC++)
         {
-        for (outIdxC = 0; outIdxC < numComp; outIdxC++)
+        // the hood slices start at the first row, and the output at the
+        // first pixel of the row
+        inPtr1 = inPtr + (hoodMin1 - inExt[2])*inInc[1] +
+          (hoodMin2 - inExt[4])*inInc[2] + outIdxC;
+        outPtr0 = outPtr + (outIdx1 - outExt[2])*outInc[1] +
+          (outIdx2 - outExt[4])*outInc[2] + outIdxC;
+        hoodMin0 = outExt[0] - kernelMiddle[0];
+        hoodMin0 = (hoodMin0 > inExt[0]) ? hoodMin0 : inExt[0];
+        hoodMax0 = hoodMin0 - 1;
+        for (outIdx0 = outExt[0]; outIdx0 <= outExt[1]; ++outIdx0)
           {
-          // Compute median of neighborhood
-          // Note: For boundary, NumNeighborhood could be changed for
-          // a faster sort.
-          DownNum = UpNum = 0;
-          Median = Sort + (NumberOfElements / 2) + 4;
-          // loop through neighborhood pixels
-          tmpPtr2 = inPtr0 + outIdxC;
-          for (hoodIdx2 = hoodMin2; hoodIdx2 <= hoodMax2; ++hoodIdx2)
+          newMin0 = outIdx0 - kernelMiddle[0];
+          newMin0 = (newMin0 > inExt[0]) ? newMin0 : inExt[0];
+          newMax0 = outIdx0 - kernelMiddle[0] + kernelSize[0] - 1;
+          newMax0 = (newMax0 < inExt[1]) ? newMax0 : inExt[1];
+          if (useHistogram)
             {
-            tmpPtr1 = tmpPtr2;
-            for (hoodIdx1 = hoodMin1; hoodIdx1 <= hoodMax1; ++hoodIdx1)
+            // slide the histogram: add the new slices, remove the old ones
+            while (hoodMax0 < newMax0 || hoodMin0 < newMin0)
               {
-              tmpPtr0 = tmpPtr1;
-              for (hoodIdx0 = hoodMin0; hoodIdx0 <= hoodMax0; ++hoodIdx0)
+              int add = (hoodMax0 < newMax0);
+              hoodIdx0 = (add ? ++hoodMax0 : hoodMin0++);
+              tmpPtr2 = inPtr1 + (hoodIdx0 - inExt[0])*inInc[0];
+              for (hoodIdx2 = hoodMin2; hoodIdx2 <= hoodMax2; ++hoodIdx2)
                 {
-                // Add this pixel to the median
-                Median = vtkImageMedian3DAccumulateMedian(UpNum, DownNum, 
-                                                          UpMax, DownMax,
-                                                          NumberOfElements,
-                                                          Median,
-                                                          double(*tmpPtr0));
-                
-                tmpPtr0 += inInc0;
+                tmpPtr1 = tmpPtr2;
+                for (hoodIdx1 = hoodMin1; hoodIdx1 <= hoodMax1; ++hoodIdx1)
+                  {
+                  int bin = static_cast<int>(*tmpPtr1 - minValue);
+                  if (add)
+                    {
+                    histogram.Add(bin);
+                    }
+                  else
+                    {
+                    histogram.Remove(bin);
+                    }
+                  tmpPtr1 += inInc[1];
+                  }
+                tmpPtr2 += inInc[2];
                 }
-              tmpPtr1 += inInc1;
               }
-            tmpPtr2 += inInc2;
+            *outPtr0 = static_cast<T>(minValue + histogram.GetBin(
+              vtkImageMedian3DRankIndex(rank, histogram.Count)));
             }
-        
-          // Replace this pixel with the hood median
-          *outPtr = static_cast<T>(*Median);
-          outPtr++;
-          }
-        
-        // shift neighborhood considering boundaries
-        if (outIdx0 >= middleMin0)
-          {
-          inPtr0 += inInc0;
-          ++hoodMin0;
+          else
+            {
+            // copy the neighborhood and partially sort it
+            int n = 0;
+            tmpPtr2 = inPtr1 + (newMin0 - inExt[0])*inInc[0];
+            for (hoodIdx2 = hoodMin2; hoodIdx2 <= hoodMax2; ++hoodIdx2)
+              {
+              tmpPtr1 = tmpPtr2;
+              for (hoodIdx1 = hoodMin1; hoodIdx1 <= hoodMax1; ++hoodIdx1)
+                {
+                tmpPtr0 = tmpPtr1;
+                for (hoodIdx0 = newMin0; hoodIdx0 <= newMax0; ++hoodIdx0)
+                  {
+                  hood[n++] = *tmpPtr0;
+                  tmpPtr0 += inInc[0];
+                  }
+                tmpPtr1 += inInc[1];
+                }
+              tmpPtr2 += inInc[2];
+              }
+            typename vtkstd::vector<T>::iterator nth =
+              hood.begin() + vtkImageMedian3DRankIndex(rank, n);
+            vtkstd::nth_element(hood.begin(), nth, hood.begin() + n);
+            *outPtr0 = *nth;
+            }
+          outPtr0 += outInc[0];
           }
-        if (outIdx0 < middleMax0)
+
+        // empty the histogram for the next row
+        if (useHistogram)
           {
-          ++hoodMax0;
+          for (hoodIdx0 = hoodMin0; hoodIdx0 <= hoodMax0; ++hoodIdx0)
+            {
+            tmpPtr2 = inPtr1 + (hoodIdx0 - inExt[0])*inInc[0];
+            for (hoodIdx2 = hoodMin2; hoodIdx2 <= hoodMax2; ++hoodIdx2)
+              {
+              tmpPtr1 = tmpPtr2;
+              for (hoodIdx1 = hoodMin1; hoodIdx1 <= hoodMax1; ++hoodIdx1)
+                {
+                histogram.Remove(static_cast<int>(*tmpPtr1 - minValue));
+                tmpPtr1 += inInc[1];
+                }
+              tmpPtr2 += inInc[2];
+              }
+            }
           }
         }
-      // shift neighborhood considering boundaries
-      if (outIdx1 >= middleMin1)
-        {
-        inPtr1 += inInc1;
-        ++hoodMin1;
-        }
-      if (outIdx1 < middleMax1)
-        {
-        ++hoodMax1;
-        }
-      outPtr += outIncY;
       }
-    // shift neighborhood considering boundaries
-    if (outIdx2 >= middleMin2)
-      {
-      inPtr2 += inInc2;
-      ++hoodMin2;
-      }
-    if (outIdx2 < middleMax2)
-      {
-      ++hoodMax2;
-      }
-    outPtr += outIncZ;
     }
-
-  delete [] Sort;
 }
 
 //-----------------------------------------------------------------------------
@@ -18,7 +18,11 @@
 // median value from a rectangular neighborhood around that pixel.
 // Neighborhoods can be no more than 3 dimensional.  Setting one
 // axis of the neighborhood kernelSize to 1 changes the filter
-// into a 2D median.  
+// into a 2D median.  Any other rank of the neighborhood, such as the
+// minimum, the maximum or a percentile, can replace the median.
+// Integer values within a range of 65536 are counted in a histogram that
+// slides along the rows, so that the cost per pixel grows with the area of
+// a kernel slice instead of the volume of the kernel.
 
 
 #ifndef __vtkImageMedian3D_h
@@ -43,11 +47,19 @@ public:
   // Return the number of elements in the median mask
   vtkGetMacro(NumberOfElements,int);
 
+  // Description:
+  // Set/Get the rank of the value that replaces each pixel, as a fraction
+  // of the sorted neighborhood: 0 is the minimum, 0.5 the median (the
+  // default) and 1 the maximum.
+  vtkSetClampMacro(Rank,double,0.0,1.0);
+  vtkGetMacro(Rank,double);
+
 protected:
   vtkImageMedian3D();
   ~vtkImageMedian3D();
 
   int NumberOfElements;
+  double Rank;
 
   void ThreadedRequestData(vtkInformation *request,
                            vtkInformationVector **inputVector,
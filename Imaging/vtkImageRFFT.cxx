@@ -58,7 +58,9 @@ int vtkImageRFFT::IterativeRequestUpdateExtent(
 
 //----------------------------------------------------------------------------
 // This templated execute method handles any type input, but the output
-// is always doubles.
+// is always doubles.  The rows are transformed in batches of neighbouring
+// rows along axis 1, interleaved so that each stage of the transform runs
+// across the batch.
 template <class T>
 void vtkImageRFFTExecute(vtkImageRFFT *self,
                          vtkImageData *inData, int inExt[6], T *inPtr,
@@ -68,6 +70,7 @@ void vtkImageRFFTExecute(vtkImageRFFT *self,
   vtkImageComplex *inComplex;
   vtkImageComplex *outComplex;
   vtkImageComplex *pComplex;
+  vtkImageFourierPlan plan;
   //
   int inMin0, inMax0;
   vtkIdType inInc0, inInc1, inInc2;
@@ -77,8 +80,9 @@ void vtkImageRFFTExecute(vtkImageRFFT *self,
   vtkIdType outInc0, outInc1, outInc2;
   double *outPtr0, *outPtr1, *outPtr2;
   //
-  int idx0, idx1, idx2, inSize0, numberOfComponents;
+  int idx0, idx1, idx2, inSize0, numberOfComponents, numArrays, array;
   unsigned long count = 0;
+  unsigned long nextProgress = 0;
   unsigned long target;
   double startProgress;
 
@@ -102,8 +106,9 @@ void vtkImageRFFTExecute(vtkImageRFFT *self,
     }
 
   // Allocate the arrays of complex numbers
-  inComplex = new vtkImageComplex[inSize0];
-  outComplex = new vtkImageComplex[inSize0];
+  self->InitializeFftPlan(&plan, inSize0);
+  inComplex = new vtkImageComplex[inSize0*VTK_IMAGE_FOURIER_BATCH_SIZE];
+  outComplex = new vtkImageComplex[inSize0*VTK_IMAGE_FOURIER_BATCH_SIZE];
 
   target = static_cast<unsigned long>((outMax2-outMin2+1)*(outMax1-outMin1+1)
                                       * self->GetNumberOfIterations() / 50.0);
@@ -116,46 +121,59 @@ void vtkImageRFFTExecute(vtkImageRFFT *self,
     {
     inPtr1 = inPtr2;
     outPtr1 = outPtr2;
-    for (idx1 = outMin1; !self->AbortExecute && idx1 <= outMax1; ++idx1)
+    for (idx1 = outMin1; !self->AbortExecute && idx1 <= outMax1;
+         idx1 += VTK_IMAGE_FOURIER_BATCH_SIZE)
       {
+      numArrays = outMax1 - idx1 + 1;
+      if (numArrays > VTK_IMAGE_FOURIER_BATCH_SIZE)
+        {
+        numArrays = VTK_IMAGE_FOURIER_BATCH_SIZE;
+        }
       if (!id) 
         {
-        if (!(count%target))
+        if (count >= nextProgress)
           {
           self->UpdateProgress(count/(50.0*target) + startProgress);
+          nextProgress += target;
           }
-        count++;
+        count += numArrays;
         }
       // copy into complex numbers
-      inPtr0 = inPtr1;
-      pComplex = inComplex;
-      for (idx0 = inMin0; idx0 <= inMax0; ++idx0)
+      for (array = 0; array < numArrays; ++array)
         {
-        pComplex->Real = static_cast<double>(*inPtr0);
-        pComplex->Imag = 0.0;
-        if (numberOfComponents > 1)
-          { // yes we have an imaginary input
-          pComplex->Imag = static_cast<double>(inPtr0[1]);;
+        inPtr0 = inPtr1 + array*inInc1;
+        pComplex = inComplex + array;
+        for (idx0 = inMin0; idx0 <= inMax0; ++idx0)
+          {
+          pComplex->Real = static_cast<double>(*inPtr0);
+          pComplex->Imag = 0.0;
+          if (numberOfComponents > 1)
+            { // yes we have an imaginary input
+            pComplex->Imag = static_cast<double>(inPtr0[1]);;
+            }
+          inPtr0 += inInc0;
+          pComplex += numArrays;
           }
-        inPtr0 += inInc0;
-        ++pComplex;
         }
       
       // Call the method that performs the RFFT
-      self->ExecuteRfft(inComplex, outComplex, inSize0);
+      self->ExecuteFftBatch(&plan, inComplex, outComplex, numArrays, -1);
 
       // copy into output
-      outPtr0 = outPtr1;
-      pComplex = outComplex + (outMin0 - inMin0);
-      for (idx0 = outMin0; idx0 <= outMax0; ++idx0)
+      for (array = 0; array < numArrays; ++array)
         {
-        *outPtr0 = static_cast<double>(pComplex->Real);
-        outPtr0[1] = static_cast<double>(pComplex->Imag);
-        outPtr0 += outInc0;
-        ++pComplex;
+        outPtr0 = outPtr1 + array*outInc1;
+        pComplex = outComplex + (outMin0 - inMin0)*numArrays + array;
+        for (idx0 = outMin0; idx0 <= outMax0; ++idx0)
+          {
+          *outPtr0 = static_cast<double>(pComplex->Real);
+          outPtr0[1] = static_cast<double>(pComplex->Imag);
+          outPtr0 += outInc0;
+          pComplex += numArrays;
+          }
         }
-      inPtr1 += inInc1;
-      outPtr1 += outInc1;
+      inPtr1 += numArrays*inInc1;
+      outPtr1 += numArrays*outInc1;
       }
     inPtr2 += inInc2;
     outPtr2 += outInc2;
@@ -163,6 +181,7 @@ void vtkImageRFFTExecute(vtkImageRFFT *self,
     
   delete [] inComplex;
   delete [] outComplex;
+  self->ReleaseFftPlan(&plan);
 }
 
 
@@ -64,6 +64,14 @@ vtkCxxSetObjectMacro(vtkImageReslice,ResliceTransform,vtkAbstractTransform);
 #define VTK_RESLICE_I386_FLOOR
 #endif
 
+// With SSE2, the floors of whole rows of coordinates are computed two at
+// a time with the same bit-trick.
+
+#if defined VTK_RESLICE_64BIT_FLOOR && defined __SSE2__
+#define VTK_RESLICE_SSE2_FLOOR
+#include <emmintrin.h>
+#endif
+
 // We add a tolerance of 2^-17 (around 7.6e-6) so that float
 // values that are just less than the closest integer are
 // rounded up.  This adds robustness against rounding errors.
@@ -164,6 +172,9 @@ vtkImageReslice::vtkImageReslice()
   this->InterpolationMode = VTK_RESLICE_NEAREST; // no interpolation
   this->Optimization = 1; // turn off when you're paranoid 
 
+  // split into beams, which keep the whole output rows
+  this->SplitMode = VTK_IMAGE_SPLIT_BEAM;
+
   // default black background
   this->BackgroundColor[0] = 0;
   this->BackgroundColor[1] = 0;
@@ -1849,6 +1860,447 @@ void vtkGetResliceInterpFunc(vtkImageReslice *self,
 }
 
 
+//----------------------------------------------------------------------------
+// Row interpolation, used when the output indices are mapped to the input
+// indices by an affine transformation.  The input coordinates of the
+// output voxels of a row are computed in chunks, along with their floors
+// and fractions.  The voxels whose whole interpolation neighborhood lies
+// within the input extent are then interpolated without bounds checks nor
+// function calls, and the other ones are passed to the voxel interpolation
+// functions above, so that the results are the same as theirs.
+
+#define VTK_RESLICE_ROW_CHUNK 64
+
+template <class F>
+struct vtkImageResliceRowArgs
+{
+  const void *InPtr;
+  int InExt[6];
+  vtkIdType InInc[3];
+  int NumScalars;
+  int Mode;
+  const void *Background;
+  F XAxis[3];
+  int (*Interpolate)(void *&outPtr, const void *inPtr,
+                     const int inExt[6], const vtkIdType inInc[3],
+                     int numscalars, const F point[3],
+                     int mode, const void *background);
+};
+
+//----------------------------------------------------------------------------
+// Compute vtkResliceFloor() of the n values x0 + (i0 + i)*dx and put their
+// fractions in f, or if f is null compute vtkResliceRound() of them.
+template <class F>
+inline void vtkResliceFloorRow(F x0, F dx, int i0, int n, int *idx, F *f)
+{
+  for (int i = 0; i < n; i++)
+    {
+    F x = x0 + (i0 + i)*dx;
+    idx[i] = (f ? vtkResliceFloor(x, f[i]) : vtkResliceRound(x));
+    }
+}
+
+#ifdef VTK_RESLICE_SSE2_FLOOR
+inline void vtkResliceFloorRow(double x0, double dx, int i0, int n,
+                               int *idx, double *f)
+{
+  // Once 1.5*2^36 is added, the 16 lowest bits of the mantissa hold the
+  // fraction and the bits above them the integer part plus 2^35. Values
+  // too large for this are clamped, which keeps them out of the extent.
+  const __m128d offset = _mm_set1_pd(f ?
+    (103079215104.0 + VTK_RESLICE_FLOOR_TOL) :
+    (103079215104.5 + VTK_RESLICE_FLOOR_TOL));
+  const __m128d maxValue = _mm_set1_pd(1073741824.0);
+  const __m128d minValue = _mm_set1_pd(-1073741824.0);
+  const __m128d integerMask =
+    _mm_castsi128_pd(_mm_set1_epi64x(~static_cast<long long>(0xFFFF)));
+  const __m128i mantissaMask = _mm_set1_epi64x(0x000FFFFFFFFFFFFFLL);
+  const __m128i bias = _mm_set1_epi64x(34359738368LL);
+  const __m128d origin = _mm_set1_pd(x0);
+  const __m128d step = _mm_set1_pd(dx);
+  const __m128d two = _mm_set1_pd(2.0);
+  __m128d index = _mm_set_pd(i0 + 1, i0);
+
+  int i = 0;
+  for (; i + 1 < n; i += 2)
+    {
+    __m128d x = _mm_add_pd(origin, _mm_mul_pd(index, step));
+    x = _mm_min_pd(_mm_max_pd(x, minValue), maxValue);
+    __m128d y = _mm_add_pd(x, offset);
+    __m128i bits = _mm_and_si128(_mm_castpd_si128(y), mantissaMask);
+    bits = _mm_sub_epi64(_mm_srli_epi64(bits, 16), bias);
+    bits = _mm_shuffle_epi32(bits, _MM_SHUFFLE(3, 3, 2, 0));
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(idx + i), bits);
+    if (f)
+      {
+      _mm_storeu_pd(f + i, _mm_sub_pd(y, _mm_and_pd(y, integerMask)));
+      }
+    index = _mm_add_pd(index, two);
+    }
+  for (; i < n; i++)
+    {
+    double x = x0 + (i0 + i)*dx;
+    idx[i] = (f ? vtkResliceFloor(x, f[i]) : vtkResliceRound(x));
+    }
+}
+#endif
+
+//----------------------------------------------------------------------------
+template <class F, class T>
+struct vtkImageResliceRowInterpolate
+{
+  static void NearestNeighbor(const vtkImageResliceRowArgs<F> &args,
+                              void *&outPtr, const F point[3],
+                              int idXmin, int idXmax);
+
+  static void Trilinear(const vtkImageResliceRowArgs<F> &args,
+                        void *&outPtr, const F point[3],
+                        int idXmin, int idXmax);
+
+  static void Tricubic(const vtkImageResliceRowArgs<F> &args,
+                       void *&outPtr, const F point[3],
+                       int idXmin, int idXmax);
+
+  // interpolate output voxel idX with the voxel interpolation function
+  static void Fallback(const vtkImageResliceRowArgs<F> &args,
+                       T *&outPtr, const F point[3], int idX)
+    {
+    F inPoint[3];
+    inPoint[0] = point[0] + idX*args.XAxis[0];
+    inPoint[1] = point[1] + idX*args.XAxis[1];
+    inPoint[2] = point[2] + idX*args.XAxis[2];
+    void *outVoidPtr = outPtr;
+    args.Interpolate(outVoidPtr, args.InPtr, args.InExt, args.InInc,
+                     args.NumScalars, inPoint, args.Mode, args.Background);
+    outPtr = static_cast<T *>(outVoidPtr);
+    }
+};
+
+//----------------------------------------------------------------------------
+// nearest-neighbor interpolation of the output voxels idXmin to idXmax of
+// the row starting at the input coordinates 'point'
+template <class F, class T>
+void vtkImageResliceRowInterpolate<F, T>::NearestNeighbor(
+  const vtkImageResliceRowArgs<F> &args, void *&outVoidPtr,
+  const F point[3], int idXmin, int idXmax)
+{
+  const T *inPtr = static_cast<const T *>(args.InPtr);
+  T *outPtr = static_cast<T *>(outVoidPtr);
+  int numscalars = args.NumScalars;
+  int inExtX = args.InExt[1] - args.InExt[0] + 1;
+  int inExtY = args.InExt[3] - args.InExt[2] + 1;
+  int inExtZ = args.InExt[5] - args.InExt[4] + 1;
+  int idx[3][VTK_RESLICE_ROW_CHUNK];
+
+  for (int idX0 = idXmin; idX0 <= idXmax; idX0 += VTK_RESLICE_ROW_CHUNK)
+    {
+    int n = idXmax - idX0 + 1;
+    n = (n < VTK_RESLICE_ROW_CHUNK ? n : VTK_RESLICE_ROW_CHUNK);
+    for (int axis = 0; axis < 3; axis++)
+      {
+      vtkResliceFloorRow(point[axis], args.XAxis[axis], idX0, n, idx[axis],
+                         static_cast<F *>(0));
+      }
+
+    for (int i = 0; i < n; i++)
+      {
+      int inIdX0 = idx[0][i] - args.InExt[0];
+      int inIdY0 = idx[1][i] - args.InExt[2];
+      int inIdZ0 = idx[2][i] - args.InExt[4];
+
+      if (inIdX0 < 0 || inIdX0 >= inExtX ||
+          inIdY0 < 0 || inIdY0 >= inExtY ||
+          inIdZ0 < 0 || inIdZ0 >= inExtZ)
+        {
+        Fallback(args, outPtr, point, idX0 + i);
+        continue;
+        }
+
+      const T *tmpPtr = inPtr + (inIdX0*args.InInc[0] +
+                                 inIdY0*args.InInc[1] +
+                                 inIdZ0*args.InInc[2]);
+      int m = numscalars;
+      do
+        {
+        *outPtr++ = *tmpPtr++;
+        }
+      while (--m);
+      }
+    }
+
+  outVoidPtr = outPtr;
+}
+
+//----------------------------------------------------------------------------
+// trilinear interpolation of the output voxels idXmin to idXmax of the row
+// starting at the input coordinates 'point'
+template <class F, class T>
+void vtkImageResliceRowInterpolate<F, T>::Trilinear(
+  const vtkImageResliceRowArgs<F> &args, void *&outVoidPtr,
+  const F point[3], int idXmin, int idXmax)
+{
+  const T *inPtr = static_cast<const T *>(args.InPtr);
+  T *outPtr = static_cast<T *>(outVoidPtr);
+  int numscalars = args.NumScalars;
+  int inExtX = args.InExt[1] - args.InExt[0] + 1;
+  int inExtY = args.InExt[3] - args.InExt[2] + 1;
+  int inExtZ = args.InExt[5] - args.InExt[4] + 1;
+  int idx[3][VTK_RESLICE_ROW_CHUNK];
+  F frac[3][VTK_RESLICE_ROW_CHUNK];
+
+  for (int idX0 = idXmin; idX0 <= idXmax; idX0 += VTK_RESLICE_ROW_CHUNK)
+    {
+    int n = idXmax - idX0 + 1;
+    n = (n < VTK_RESLICE_ROW_CHUNK ? n : VTK_RESLICE_ROW_CHUNK);
+    for (int axis = 0; axis < 3; axis++)
+      {
+      vtkResliceFloorRow(point[axis], args.XAxis[axis], idX0, n, idx[axis],
+                         frac[axis]);
+      }
+
+    for (int i = 0; i < n; i++)
+      {
+      F fx = frac[0][i];
+      F fy = frac[1][i];
+      F fz = frac[2][i];
+
+      int inIdX0 = idx[0][i] - args.InExt[0];
+      int inIdY0 = idx[1][i] - args.InExt[2];
+      int inIdZ0 = idx[2][i] - args.InExt[4];
+
+      int inIdX1 = inIdX0 + (fx != 0);
+      int inIdY1 = inIdY0 + (fy != 0);
+      int inIdZ1 = inIdZ0 + (fz != 0);
+
+      if (inIdX0 < 0 || inIdX1 >= inExtX ||
+          inIdY0 < 0 || inIdY1 >= inExtY ||
+          inIdZ0 < 0 || inIdZ1 >= inExtZ)
+        {
+        Fallback(args, outPtr, point, idX0 + i);
+        continue;
+        }
+
+      vtkIdType factY0 = inIdY0*args.InInc[1];
+      vtkIdType factY1 = inIdY1*args.InInc[1];
+      vtkIdType factZ0 = inIdZ0*args.InInc[2];
+      vtkIdType factZ1 = inIdZ1*args.InInc[2];
+
+      vtkIdType i00 = factY0 + factZ0;
+      vtkIdType i01 = factY0 + factZ1;
+      vtkIdType i10 = factY1 + factZ0;
+      vtkIdType i11 = factY1 + factZ1;
+
+      F rx = 1 - fx;
+      F ry = 1 - fy;
+      F rz = 1 - fz;
+
+      F ryrz = ry*rz;
+      F fyrz = fy*rz;
+      F ryfz = ry*fz;
+      F fyfz = fy*fz;
+
+      const T *inPtr0 = inPtr + inIdX0*args.InInc[0];
+      const T *inPtr1 = inPtr + inIdX1*args.InInc[0];
+      int m = numscalars;
+      do
+        {
+        F result = (rx*(ryrz*inPtr0[i00] + ryfz*inPtr0[i01] +
+                        fyrz*inPtr0[i10] + fyfz*inPtr0[i11]) +
+                    fx*(ryrz*inPtr1[i00] + ryfz*inPtr1[i01] +
+                        fyrz*inPtr1[i10] + fyfz*inPtr1[i11]));
+
+        vtkResliceRound(result, *outPtr++);
+        inPtr0++;
+        inPtr1++;
+        }
+      while (--m);
+      }
+    }
+
+  outVoidPtr = outPtr;
+}
+
+//----------------------------------------------------------------------------
+// tricubic interpolation of the output voxels idXmin to idXmax of the row
+// starting at the input coordinates 'point'
+template <class F, class T>
+void vtkImageResliceRowInterpolate<F, T>::Tricubic(
+  const vtkImageResliceRowArgs<F> &args, void *&outVoidPtr,
+  const F point[3], int idXmin, int idXmax)
+{
+  const T *inPtr = static_cast<const T *>(args.InPtr);
+  T *outPtr = static_cast<T *>(outVoidPtr);
+  int numscalars = args.NumScalars;
+  int inExtX = args.InExt[1] - args.InExt[0] + 1;
+  int inExtY = args.InExt[3] - args.InExt[2] + 1;
+  int inExtZ = args.InExt[5] - args.InExt[4] + 1;
+  vtkIdType inIncX = args.InInc[0];
+  vtkIdType inIncY = args.InInc[1];
+  vtkIdType inIncZ = args.InInc[2];
+  // wrap and mirror always use cubic interpolation along x, and the
+  // other modes skip the neighbors that have null weights
+  int wrap = (args.Mode == VTK_RESLICE_WRAP ||
+              args.Mode == VTK_RESLICE_MIRROR);
+  int skip = (!wrap && args.Mode != VTK_RESLICE_BORDER);
+  int idx[3][VTK_RESLICE_ROW_CHUNK];
+  F frac[3][VTK_RESLICE_ROW_CHUNK];
+
+  for (int idX0 = idXmin; idX0 <= idXmax; idX0 += VTK_RESLICE_ROW_CHUNK)
+    {
+    int n = idXmax - idX0 + 1;
+    n = (n < VTK_RESLICE_ROW_CHUNK ? n : VTK_RESLICE_ROW_CHUNK);
+    for (int axis = 0; axis < 3; axis++)
+      {
+      vtkResliceFloorRow(point[axis], args.XAxis[axis], idX0, n, idx[axis],
+                         frac[axis]);
+      }
+
+    for (int i = 0; i < n; i++)
+      {
+      int inIdX0 = idx[0][i] - args.InExt[0];
+      int inIdY0 = idx[1][i] - args.InExt[2];
+      int inIdZ0 = idx[2][i] - args.InExt[4];
+
+      // all four neighbors along each axis must be within the extent
+      if (inIdX0 < 1 || inIdX0 + 2 >= inExtX ||
+          inIdY0 < 1 || inIdY0 + 2 >= inExtY ||
+          inIdZ0 < 1 || inIdZ0 + 2 >= inExtZ)
+        {
+        Fallback(args, outPtr, point, idX0 + i);
+        continue;
+        }
+
+      F fx = frac[0][i];
+      F fy = frac[1][i];
+      F fz = frac[2][i];
+
+      int fxIsNotZero = (fx != 0);
+      int fyIsNotZero = (fy != 0);
+      int fzIsNotZero = (fz != 0);
+
+      int i1 = (wrap ? 0 : 1 - fxIsNotZero);
+      int i2 = (wrap ? 3 : 1 + 2*fxIsNotZero);
+      int j1 = 1 - fyIsNotZero;
+      int j2 = 1 + 2*fyIsNotZero;
+      int k1 = 1 - fzIsNotZero;
+      int k2 = 1 + 2*fzIsNotZero;
+
+      F fX[4], fY[4], fZ[4];
+      vtkTricubicInterpCoeffs(fX, i1, i2, fx);
+      vtkTricubicInterpCoeffs(fY, j1, j2, fy);
+      vtkTricubicInterpCoeffs(fZ, k1, k2, fz);
+
+      vtkIdType factX[4], factY[4], factZ[4];
+      factX[1] = inIdX0*inIncX;
+      factX[0] = factX[1] - inIncX;
+      factX[2] = factX[1] + inIncX;
+      factX[3] = factX[2] + inIncX;
+
+      factY[1] = inIdY0*inIncY;
+      factY[0] = factY[1] - inIncY;
+      factY[2] = factY[1] + inIncY;
+      factY[3] = factY[2] + inIncY;
+
+      factZ[1] = inIdZ0*inIncZ;
+      factZ[0] = factZ[1] - inIncZ;
+      factZ[2] = factZ[1] + inIncZ;
+      factZ[3] = factZ[2] + inIncZ;
+
+      if (skip && !fxIsNotZero)
+        {
+        factX[0] = factX[2] = factX[3] = factX[1];
+        }
+
+      const T *tmpInPtr = inPtr;
+      int m = numscalars;
+      do // loop over components
+        {
+        F val = 0;
+        int k = k1;
+        do // loop over z
+          {
+          F ifz = fZ[k];
+          vtkIdType factz = factZ[k];
+          int j = j1;
+          do // loop over y
+            {
+            F ify = fY[j];
+            F fzy = ifz*ify;
+            vtkIdType factzy = factz + factY[j];
+            const T *tmpPtr = tmpInPtr + factzy;
+            val += fzy*(fX[0]*tmpPtr[factX[0]] +
+                        fX[1]*tmpPtr[factX[1]] +
+                        fX[2]*tmpPtr[factX[2]] +
+                        fX[3]*tmpPtr[factX[3]]);
+            }
+          while (++j <= j2);
+          }
+        while (++k <= k2);
+
+        vtkResliceClamp(val, *outPtr++);
+        tmpInPtr++;
+        }
+      while (--m);
+      }
+    }
+
+  outVoidPtr = outPtr;
+}
+
+//--------------------------------------------------------------------------
+// get the row interpolation function according to interpolation mode and
+// scalar type
+template <class F>
+void vtkGetResliceRowInterpFunc(vtkImageReslice *self,
+                                void (**interpolate)(
+                                  const vtkImageResliceRowArgs<F> &args,
+                                  void *&outPtr, const F point[3],
+                                  int idXmin, int idXmax))
+{
+  int dataType = self->GetOutput()->GetScalarType();
+  int interpolationMode = self->GetInterpolationMode();
+
+  switch (interpolationMode)
+    {
+    case VTK_RESLICE_NEAREST:
+      switch (dataType)
+        {
+        vtkTemplateAliasMacro(
+          *interpolate =
+            &(vtkImageResliceRowInterpolate<F, VTK_TT>::NearestNeighbor)
+          );
+        default:
+          *interpolate = 0;
+        }
+      break;
+    case VTK_RESLICE_LINEAR:
+    case VTK_RESLICE_RESERVED_2:
+      switch (dataType)
+        {
+        vtkTemplateAliasMacro(
+          *interpolate =
+            &(vtkImageResliceRowInterpolate<F, VTK_TT>::Trilinear)
+          );
+        default:
+          *interpolate = 0;
+        }
+      break;
+    case VTK_RESLICE_CUBIC:
+      switch (dataType)
+        {
+        vtkTemplateAliasMacro(
+          *interpolate =
+            &(vtkImageResliceRowInterpolate<F, VTK_TT>::Tricubic)
+          );
+        default:
+          *interpolate = 0;
+        }
+      break;
+    default:
+      *interpolate = 0;
+    }
+}
+
 //----------------------------------------------------------------------------
 // Some helper functions for 'RequestData'
 //----------------------------------------------------------------------------
@@ -2045,8 +2497,8 @@ void vtkImageResliceClearExecute(vtkImageReslice *self,
     {
     for (idY = outExt[2]; idY <= outExt[3]; idY++)
       {
-      if (id == 0) 
-        { // update the progress if this is the main thread
+      if (id == 0 && self->GetSplitMode() == VTK_IMAGE_SPLIT_SLAB)
+        { // the main thread updates the progress, in slab mode only
         if (!(count%target)) 
           {
           self->UpdateProgress(count/(50.0*target));
@@ -2151,8 +2603,8 @@ void vtkImageResliceExecute(vtkImageReslice *self,
     {
     for (idY = outExt[2]; idY <= outExt[3]; idY++)
       {
-      if (id == 0) 
-        { // update the progress if this is the main thread
+      if (id == 0 && self->GetSplitMode() == VTK_IMAGE_SPLIT_SLAB)
+        { // the main thread updates the progress, in slab mode only
         if (!(count%target)) 
           {
           self->UpdateProgress(count/(50.0*target));
@@ -2269,19 +2721,20 @@ void vtkOptimizedExecute(vtkImageReslice *self,
                      int numscalars, const F point[3],
                      int mode, const void *background);
   void (*setpixels)(void *&out, const void *in, int numscalars, int n);
+  void (*rowInterpolate)(const vtkImageResliceRowArgs<F> &args,
+                         void *&outPtr, const F point[3],
+                         int idXmin, int idXmax);
+  vtkImageResliceRowArgs<F> rowArgs;
 
   int mode = VTK_RESLICE_BACKGROUND;
-  int wrap = 0;
 
   if (self->GetMirror())
     {
     mode = VTK_RESLICE_MIRROR;
-    wrap = 1;
     }
   else if (self->GetWrap())
     {
     mode = VTK_RESLICE_WRAP;
-    wrap = 1;
     }
   else if (self->GetBorder())
     {
@@ -2295,13 +2748,6 @@ void vtkOptimizedExecute(vtkImageReslice *self,
     perspective = 1;
     }
 
-  int optimizeNearest = 0;
-  if (self->GetInterpolationMode() == VTK_RESLICE_NEAREST &&
-      !(wrap || newtrans || perspective))
-    {
-    optimizeNearest = 1;
-    }
-
   // find maximum input range
   inData->GetExtent(inExt);
 
@@ -2343,6 +2789,25 @@ void vtkOptimizedExecute(vtkImageReslice *self,
   vtkGetResliceInterpFunc(self, &interpolate);
   vtkGetSetPixelsFunc(self, &setpixels);
 
+  // affine transformations interpolate whole rows at a time
+  rowInterpolate = 0;
+  if (!(newtrans || perspective))
+    {
+    vtkGetResliceRowInterpFunc(self, &rowInterpolate);
+    }
+  rowArgs.InPtr = inPtr;
+  for (i = 0; i < 3; i++)
+    {
+    rowArgs.InExt[2*i] = inExt[2*i];
+    rowArgs.InExt[2*i+1] = inExt[2*i+1];
+    rowArgs.InInc[i] = inInc[i];
+    rowArgs.XAxis[i] = xAxis[i];
+    }
+  rowArgs.NumScalars = numscalars;
+  rowArgs.Mode = mode;
+  rowArgs.Background = background;
+  rowArgs.Interpolate = interpolate;
+
   // get the stencil
   vtkImageStencilData *stencil = self->GetStencil();
 
@@ -2361,7 +2826,7 @@ void vtkOptimizedExecute(vtkImageReslice *self,
       inPoint1[2] = inPoint0[2] + idY*yAxis[2];
       inPoint1[3] = inPoint0[3] + idY*yAxis[3];
       
-      if (!id) 
+      if (!id && self->GetSplitMode() == VTK_IMAGE_SPLIT_SLAB)
         {
         if (!(count%target)) 
           {
@@ -2376,7 +2841,11 @@ void vtkOptimizedExecute(vtkImageReslice *self,
                                      outPtr, background, numscalars, 
                                      setpixels, iter))
         {
-        if (!optimizeNearest)
+        if (rowInterpolate)
+          {
+          rowInterpolate(rowArgs, outPtr, inPoint1, idXmin, idXmax);
+          }
+        else
           {
           for (idX = idXmin; idX <= idXmax; idX++)
             {
@@ -2401,37 +2870,6 @@ void vtkOptimizedExecute(vtkImageReslice *self,
                         inPoint, mode, background);
             }
           }
-        else // optimize for nearest-neighbor interpolation
-          {
-          int inExtX = inExt[1] - inExt[0] + 1;
-          int inExtY = inExt[3] - inExt[2] + 1;
-          int inExtZ = inExt[5] - inExt[4] + 1;
-
-          for (int iidX = idXmin; iidX <= idXmax; iidX++)
-            {
-            void *inPtrTmp = background;
-
-            inPoint[0] = inPoint1[0] + iidX*xAxis[0];
-            inPoint[1] = inPoint1[1] + iidX*xAxis[1];
-            inPoint[2] = inPoint1[2] + iidX*xAxis[2];
-
-            int inIdX = vtkResliceRound(inPoint[0]) - inExt[0];
-            int inIdY = vtkResliceRound(inPoint[1]) - inExt[2];
-            int inIdZ = vtkResliceRound(inPoint[2]) - inExt[4];
-
-            if (inIdX >= 0 && inIdX < inExtX &&
-                inIdY >= 0 && inIdY < inExtY &&
-                inIdZ >= 0 && inIdZ < inExtZ)
-              {
-              inPtrTmp = static_cast<void *>(static_cast<char *>(inPtr) +
-                                             (inIdX*inInc[0] + 
-                                              inIdY*inInc[1] +
-                                              inIdZ*inInc[2])*scalarSize);
-              }
-
-            setpixels(outPtr, inPtrTmp, numscalars, 1);
-            }
-          }
         }
       outPtr = static_cast<void *>(
         static_cast<char *>(outPtr) + outIncY*scalarSize);
@@ -3329,8 +3767,8 @@ void vtkReslicePermuteExecute(vtkImageReslice *self,
       {
       int idY0 = idY*step;
 
-      if (id == 0) 
-        { // track progress if we are main thread
+      if (id == 0 && self->GetSplitMode() == VTK_IMAGE_SPLIT_SLAB)
+        { // the main thread tracks progress, in slab mode only
         if (!(count%target)) 
           {
           self->UpdateProgress(count/(50.0*target));
@@ -25,9 +25,112 @@
 
 #include <math.h>
 #include <vtkstd/algorithm>
+#include <vtkstd/vector>
 
 vtkStandardNewMacro(vtkImageStencilData);
 
+//----------------------------------------------------------------------------
+// The extent lists of the rows of a slice are carved out of blocks that
+// belong to the slice, so that the rows of different slices can be filled
+// by different threads.  The capacity of each list is a power of two, and
+// a list that outgrows it is moved to the free space at the end of the
+// blocks.  When the lists that were moved away take more than half the
+// space of the live ones, the slice is compacted instead of getting a new
+// block.
+class vtkImageStencilDataInternals
+{
+public:
+  struct Slice
+  {
+    vtkstd::vector<int *> Blocks;
+    int *Next;           // the free space of the last block
+    int *End;
+    vtkIdType Allocated; // the size of all the blocks
+    vtkIdType Used;      // the capacity of the lists of the rows
+  };
+
+  vtkImageStencilDataInternals() : RowsPerSlice(0) {};
+  ~vtkImageStencilDataInternals() { this->Reset(0, 0); };
+
+  // Free all the blocks, and make empty slices.
+  void Reset(int numSlices, int rowsPerSlice)
+    {
+    for (size_t i = 0; i < this->Slices.size(); i++)
+      {
+      this->FreeSlice(this->Slices[i]);
+      }
+    this->Slices.resize(numSlices);
+    for (int j = 0; j < numSlices; j++)
+      {
+      this->InitializeSlice(this->Slices[j]);
+      }
+    this->Capacities.assign(
+      static_cast<size_t>(numSlices)*rowsPerSlice, 0);
+    this->RowsPerSlice = rowsPerSlice;
+    }
+
+  static void InitializeSlice(Slice &slice)
+    {
+    slice.Blocks.clear();
+    slice.Next = NULL;
+    slice.End = NULL;
+    slice.Allocated = 0;
+    slice.Used = 0;
+    }
+
+  static void FreeSlice(Slice &slice)
+    {
+    for (size_t i = 0; i < slice.Blocks.size(); i++)
+      {
+      delete [] slice.Blocks[i];
+      }
+    InitializeSlice(slice);
+    }
+
+  // The slices, and the log2 of the capacity of each row, or zero if the
+  // row has no list.
+  vtkstd::vector<Slice> Slices;
+  vtkstd::vector<unsigned char> Capacities;
+  int RowsPerSlice;
+};
+
+//----------------------------------------------------------------------------
+// Combine two lists of extent boundaries into 'out', which must have room
+// for na + nb entries, and return the length of the result.  Each bit of
+// the operation tells whether a position is in the result, for the
+// position being in a list or not: bit (inA*2 + inB).
+static int vtkImageStencilDataCombine(const int *a, int na,
+                                      const int *b, int nb,
+                                      int operation, int *out)
+{
+  int i = 0, j = 0, n = 0;
+  int inA = 0, inB = 0, inOut = 0;
+  while (i < na || j < nb)
+    {
+    int x = ((j >= nb || (i < na && a[i] <= b[j])) ? a[i] : b[j]);
+    for (; i < na && a[i] == x; i++)
+      {
+      inA = !inA;
+      }
+    for (; j < nb && b[j] == x; j++)
+      {
+      inB = !inB;
+      }
+    int inResult = ((operation >> (2*inA + inB)) & 1);
+    if (inResult != inOut)
+      {
+      out[n++] = x;
+      inOut = inResult;
+      }
+    }
+  return n;
+}
+
+// The operations for vtkImageStencilDataCombine
+#define VTK_STENCIL_UNION        14
+#define VTK_STENCIL_DIFFERENCE    4
+#define VTK_STENCIL_INTERSECTION  8
+
 //----------------------------------------------------------------------------
 vtkImageStencilData::vtkImageStencilData()
 {
@@ -42,6 +145,7 @@ vtkImageStencilData::vtkImageStencilData()
   this->NumberOfExtentEntries = 0;
   this->ExtentLists = NULL;
   this->ExtentListLengths = NULL;
+  this->Internal = new vtkImageStencilDataInternals;
 
   this->Extent[0] = 0;
   this->Extent[1] = -1;
@@ -58,6 +162,7 @@ vtkImageStencilData::vtkImageStencilData()
 vtkImageStencilData::~vtkImageStencilData()
 {
   this->Initialize();
+  delete this->Internal;
 }
 
 //----------------------------------------------------------------------------
@@ -89,17 +194,21 @@ void vtkImageStencilData::PrintSelf(ostream& os, vtkIndent indent)
 
 //----------------------------------------------------------------------------
 void vtkImageStencilData::Initialize()
+{
+  this->ReleaseExtents();
+
+  if(this->Information)
+    {
+    int extent[6] = {0, -1, 0, -1, 0, -1};
+    memcpy(this->Extent, extent, 6*sizeof(int));
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkImageStencilData::ReleaseExtents()
 {
   if (this->ExtentLists)
     {
-    int n = this->NumberOfExtentEntries;
-    for (int i = 0; i < n; i++)
-      {
-      if (this->ExtentLists[i]) 
-        { 
-        delete [] this->ExtentLists[i]; 
-        }
-      }
     delete [] this->ExtentLists;
     }
   this->ExtentLists = NULL;
@@ -111,11 +220,7 @@ void vtkImageStencilData::Initialize()
     }
   this->ExtentListLengths = NULL;
 
-  if(this->Information)
-    {
-    int extent[6] = {0, -1, 0, -1, 0, -1};
-    memcpy(this->Extent, extent, 6*sizeof(int));
-    }
+  this->Internal->Reset(0, 0);
 }
 
 //----------------------------------------------------------------------------
@@ -230,67 +335,79 @@ void vtkImageStencilData::DeepCopy(vtkDataObject *o)
   vtkDataObject::DeepCopy(o);
 }
 
+//----------------------------------------------------------------------------
 //----------------------------------------------------------------------------
 void vtkImageStencilData::InternalImageStencilDataCopy(vtkImageStencilData *s)
 {
+  if (s == this)
+    {
+    return;
+    }
+
   // copy information that accompanies the data
   this->SetSpacing(s->Spacing);
   this->SetOrigin(s->Origin);
 
-  // delete old data
-  if (this->ExtentLists)
-    {
-    int n = this->NumberOfExtentEntries;
-    for (int i = 0; i < n; i++)
-      {
-      if (this->ExtentLists[i])
-        {
-        delete [] this->ExtentLists[i];
-        }
-      }
-    delete [] this->ExtentLists;
-    }
-  this->ExtentLists = NULL;
-  this->NumberOfExtentEntries = 0;
-
-  if (this->ExtentListLengths)
+  // make empty rows for the extent, then pack the lists of each slice
+  // into a single block
+  memcpy(this->Extent, s->GetExtent(), 6*sizeof(int));
+  this->AllocateExtents();
+  if (s->NumberOfExtentEntries != this->NumberOfExtentEntries)
     {
-    delete [] this->ExtentListLengths;
+    return;
     }
-  this->ExtentListLengths = NULL;
 
-  // copy new data
-  if (s->NumberOfExtentEntries != 0)
+  vtkImageStencilDataInternals *internal = this->Internal;
+  int rowsPerSlice = internal->RowsPerSlice;
+  int numSlices = static_cast<int>(internal->Slices.size());
+  for (int slice = 0; slice < numSlices; slice++)
     {
-    this->NumberOfExtentEntries = s->NumberOfExtentEntries;
-    int n = this->NumberOfExtentEntries;
-    this->ExtentListLengths = new int[n];
-    this->ExtentLists = new int *[n];
-    for (int i = 0; i < n; i++)
+    int firstRow = slice*rowsPerSlice;
+    int lastRow = firstRow + rowsPerSlice;
+    vtkIdType blockSize = 0;
+    int i;
+    for (i = firstRow; i < lastRow; i++)
       {
-      this->ExtentListLengths[i] = s->ExtentListLengths[i];
-      if (this->ExtentListLengths[i])
+      int m = s->ExtentListLengths[i];
+      if (m > 0)
         {
-        int m = this->ExtentListLengths[i];
-
-        int clistmaxlen = 2;
-        while (m > clistmaxlen)
+        unsigned char capacity = 1;
+        while ((1 << capacity) < m)
           {
-          clistmaxlen *= 2;
+          capacity++;
           }
-        this->ExtentLists[i] = new int[clistmaxlen];
+        internal->Capacities[i] = capacity;
+        blockSize += (1 << capacity);
+        }
+      }
+    if (blockSize == 0)
+      {
+      continue;
+      }
+
+    vtkImageStencilDataInternals::Slice &sliceData = internal->Slices[slice];
+    int *block = new int[blockSize];
+    sliceData.Blocks.push_back(block);
+    sliceData.Allocated = blockSize;
+    sliceData.Used = blockSize;
+    sliceData.Next = block + blockSize;
+    sliceData.End = block + blockSize;
+    for (i = firstRow; i < lastRow; i++)
+      {
+      int m = s->ExtentListLengths[i];
+      if (m > 0)
+        {
+        this->ExtentLists[i] = block;
+        this->ExtentListLengths[i] = m;
+        int *clist = s->ExtentLists[i];
         for (int j = 0; j < m; j++)
           {
-          this->ExtentLists[i][j] = s->ExtentLists[i][j];
+          block[j] = clist[j];
           }
-        }
-      else
-        {
-        this->ExtentLists[i] = 0;
+        block += (1 << internal->Capacities[i]);
         }
       }
     }
-  memcpy(this->Extent, s->GetExtent(), 6*sizeof(int));
 }
 
 //----------------------------------------------------------------------------
@@ -300,48 +417,200 @@ void vtkImageStencilData::AllocateExtents()
   this->GetExtent(extent);
   int ySize = (extent[3] - extent[2] + 1);
   int zSize = (extent[5] - extent[4] + 1);
+  if (ySize <= 0 || zSize <= 0)
+    {
+    ySize = 0;
+    zSize = 0;
+    }
 
   int numEntries = ySize*zSize;
   if (numEntries != this->NumberOfExtentEntries)
     {
-    if (this->NumberOfExtentEntries != 0)
+    this->ReleaseExtents();
+
+    this->NumberOfExtentEntries = numEntries;
+    if (numEntries)
+      {
+      this->ExtentLists = new int *[numEntries];
+      this->ExtentListLengths = new int[numEntries];
+      }
+    }
+
+  for (int i = 0; i < numEntries; i++)
+    {
+    this->ExtentListLengths[i] = 0;
+    this->ExtentLists[i] = NULL;
+    }
+  this->Internal->Reset(zSize, ySize);
+}
+
+//----------------------------------------------------------------------------
+unsigned long vtkImageStencilData::GetActualMemorySize()
+{
+  vtkIdType size = this->NumberOfExtentEntries*
+    static_cast<vtkIdType>(sizeof(int) + sizeof(int *) + 1);
+  vtkImageStencilDataInternals *internal = this->Internal;
+  for (size_t i = 0; i < internal->Slices.size(); i++)
+    {
+    size += internal->Slices[i].Allocated*sizeof(int);
+    }
+
+  return this->Superclass::GetActualMemorySize() +
+    static_cast<unsigned long>(size/1024);
+}
+
+//----------------------------------------------------------------------------
+// Make room in the extent list of the row at 'idx', which belongs to the
+// blocks of its slice.
+int *vtkImageStencilData::ResizeExtentList(int idx, int n)
+{
+  vtkImageStencilDataInternals *internal = this->Internal;
+  unsigned char oldCapacity = internal->Capacities[idx];
+  if (oldCapacity != 0 && n <= (1 << oldCapacity))
+    {
+    return this->ExtentLists[idx];
+    }
+
+  unsigned char capacity = 1;
+  while ((1 << capacity) < n)
+    {
+    capacity++;
+    }
+  int size = (1 << capacity);
+  int oldSize = (oldCapacity != 0 ? (1 << oldCapacity) : 0);
+  int slice = idx/internal->RowsPerSlice;
+  vtkImageStencilDataInternals::Slice &sliceData = internal->Slices[slice];
+  vtkIdType used = sliceData.Used + size - oldSize;
+
+  vtkIdType moved = (sliceData.Allocated - sliceData.Used -
+                     (sliceData.End - sliceData.Next));
+  if (sliceData.End - sliceData.Next < size && 2*moved > sliceData.Used)
+    {
+    // pack the lists into a new block, with some room for them to grow
+    vtkIdType blockSize = used + used/2;
+    blockSize = (blockSize > 64 ? blockSize : 64);
+    int *block = new int[blockSize];
+    int *next = block;
+    int firstRow = slice*internal->RowsPerSlice;
+    int lastRow = firstRow + internal->RowsPerSlice;
+    for (int i = firstRow; i < lastRow; i++)
       {
-      int n = this->NumberOfExtentEntries;
-      for (int i = 0; i < n; i++)
+      if (i == idx)
+        {
+        internal->Capacities[i] = capacity;
+        }
+      if (internal->Capacities[i] != 0)
         {
-        if (this->ExtentLists[i] != 0)
+        int *clist = this->ExtentLists[i];
+        int clistlen = this->ExtentListLengths[i];
+        for (int j = 0; j < clistlen; j++)
           {
-          delete [] this->ExtentLists[i];
+          next[j] = clist[j];
           }
+        this->ExtentLists[i] = next;
+        next += (1 << internal->Capacities[i]);
         }
-      delete [] this->ExtentLists;
-      delete [] this->ExtentListLengths;
       }
+    vtkImageStencilDataInternals::FreeSlice(sliceData);
+    sliceData.Blocks.push_back(block);
+    sliceData.Next = next;
+    sliceData.End = block + blockSize;
+    sliceData.Allocated = blockSize;
+    sliceData.Used = used;
+    return this->ExtentLists[idx];
+    }
 
-    this->NumberOfExtentEntries = numEntries;
-    this->ExtentLists = NULL;
-    this->ExtentListLengths = NULL;
+  if (sliceData.End - sliceData.Next < size)
+    {
+    // the blocks grow with the slice, to keep their number small
+    vtkIdType blockSize = (sliceData.Allocated > 64 ?
+                           sliceData.Allocated : 64);
+    blockSize = (blockSize > size ? blockSize : size);
+    int *block = new int[blockSize];
+    sliceData.Blocks.push_back(block);
+    sliceData.Next = block;
+    sliceData.End = block + blockSize;
+    sliceData.Allocated += blockSize;
+    }
+
+  int *newclist = sliceData.Next;
+  sliceData.Next += size;
+  sliceData.Used = used;
+  int *clist = this->ExtentLists[idx];
+  int clistlen = this->ExtentListLengths[idx];
+  for (int j = 0; j < clistlen; j++)
+    {
+    newclist[j] = clist[j];
+    }
+  internal->Capacities[idx] = capacity;
+  this->ExtentLists[idx] = newclist;
+  return newclist;
+}
 
-    if (numEntries)
+//----------------------------------------------------------------------------
+void vtkImageStencilData::CombineExtentList(int idx, const int *list, int n,
+                                            int operation)
+{
+  // most rows have few extents, so avoid allocating memory for them
+  int space[64];
+  vtkstd::vector<int> buffer;
+  int *result = space;
+  int clistlen = this->ExtentListLengths[idx];
+  if (clistlen + n > 64)
+    {
+    buffer.resize(clistlen + n);
+    result = &buffer[0];
+    }
+
+  int m = vtkImageStencilDataCombine(this->ExtentLists[idx], clistlen,
+                                     list, n, operation, result);
+  if (m > 0)
+    {
+    int *clist = this->ResizeExtentList(idx, m);
+    for (int j = 0; j < m; j++)
       {
-      this->ExtentLists = new int *[numEntries];
-      this->ExtentListLengths = new int[numEntries];
-      for (int i = 0; i < numEntries; i++)
-        {
-        this->ExtentListLengths[i] = 0;
-        this->ExtentLists[i] = NULL;
-        }
+      clist[j] = result[j];
       }
     }
-  else
+  this->ExtentListLengths[idx] = m;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageStencilData::CombineExtentLists(vtkImageStencilData *stencil,
+                                             const int extent[6],
+                                             int operation)
+{
+  if (this->NumberOfExtentEntries == 0 ||
+      stencil->NumberOfExtentEntries == 0)
+    {
+    return;
+    }
+
+  int yExt = this->Extent[3] - this->Extent[2] + 1;
+  int yExt1 = stencil->Extent[3] - stencil->Extent[2] + 1;
+  int xRange[2];
+  xRange[0] = extent[0];
+  xRange[1] = extent[1] + 1;
+  vtkstd::vector<int> clipped;
+
+  for (int idz = extent[4]; idz <= extent[5]; idz++)
     {
-    for (int i = 0; i < numEntries; i++)
+    for (int idy = extent[2]; idy <= extent[3]; idy++)
       {
-      if (this->ExtentListLengths[i] != 0)
+      int idx = yExt*(idz - this->Extent[4]) + (idy - this->Extent[2]);
+      int idx1 = yExt1*(idz - stencil->Extent[4]) + (idy - stencil->Extent[2]);
+      int n1 = stencil->ExtentListLengths[idx1];
+      if (n1 == 0)
         {
-        this->ExtentListLengths[i] = 0;
-        delete [] this->ExtentLists[i];
-        this->ExtentLists[i] = NULL;
+        continue;
+        }
+      clipped.resize(n1 + 2);
+      int n = vtkImageStencilDataCombine(stencil->ExtentLists[idx1], n1,
+                                         xRange, 2, VTK_STENCIL_INTERSECTION,
+                                         &clipped[0]);
+      if (n > 0)
+        {
+        this->CombineExtentList(idx, &clipped[0], n, operation);
         }
       }
     }
@@ -457,27 +726,12 @@ void vtkImageStencilData::Fill( void )
   int extent[6];
   this->GetExtent(extent);
 
-  int yExt = extent[3] - extent[2] + 1;
-  for (int idz=extent[4]; idz<=extent[5]; idz++)
+  for (int idx = 0; idx < this->NumberOfExtentEntries; idx++)
     {
-    int zIdx = idz - extent[4];
-    for (int idy = extent[2]; idy <= extent[3]; idy++)
-      {
-      int yIdx = idy - extent[2];
-
-      // get the ExtentList and ExtentListLength for this yIdx,zIdx
-      int incr = zIdx*yExt + yIdx;
-      this->ExtentListLengths[incr] = 0;
-      delete [] this->ExtentLists[incr];
-      this->ExtentLists[incr] = NULL;
-
-      int &clistlen = this->ExtentListLengths[incr];
-      int *&clist = this->ExtentLists[incr];
-    
-      clist = new int[2];
-      clist[clistlen++] = extent[0];
-      clist[clistlen++] = extent[1] + 1;
-      }
+    int *clist = this->ResizeExtentList(idx, 2);
+    clist[0] = extent[0];
+    clist[1] = extent[1] + 1;
+    this->ExtentListLengths[idx] = 2;
     }
 }
 
@@ -492,34 +746,20 @@ void vtkImageStencilData::InsertNextExtent(int r1, int r2, int yIdx, int zIdx)
   int incr = (yMax - yMin + 1)*(zIdx - zMin) + (yIdx - yMin);
 
   int &clistlen = this->ExtentListLengths[incr];
-  int *&clist = this->ExtentLists[incr];
+  int *clist = this->ExtentLists[incr];
 
-  // no space has been allocated yet
-  if (clistlen == 0)
-    {
-    clist = new int[2];
-    }
   // this extent continues the previous extent
-  else if (r1 == clist[clistlen-1]+1)
+  if (clistlen > 0 && r1 == clist[clistlen-1])
     {
-    clist[clistlen-1] = r2;
+    clist[clistlen-1] = r2 + 1;
     return;
     }
-  // check if clistlen is a power of two
-  else if ((clistlen & (clistlen-1)) == 0)
+
+  // the capacity is zero when no list has been allocated
+  if (clistlen + 2 > (1 << this->Internal->Capacities[incr]))
     {
-    // the allocated space is always the smallest power of two
-    // that is not less than the number of stored items, therefore
-    // we need to allocate space when clistlen is a power of two
-    int *newclist = new int[2*clistlen];
-    for (int k = 0; k < clistlen; k++)
-      {
-      newclist[k] = clist[k];
-      }
-    delete [] clist;
-    clist = newclist;
+    clist = this->ResizeExtentList(incr, clistlen + 2);
     }
-
   clist[clistlen] = r1;
   clist[clistlen + 1] = r2 + 1;
   clistlen += 2;
@@ -529,131 +769,32 @@ void vtkImageStencilData::InsertNextExtent(int r1, int r2, int yIdx, int zIdx)
 void vtkImageStencilData::InsertAndMergeExtent(int r1, int r2,
                                                int yIdx, int zIdx)
 {
+  if (r1 > r2)
+    {
+    return;
+    }
+
   // calculate the index into the extent array
   int yMin = this->Extent[2];
   int yMax = this->Extent[3];
   int zMin = this->Extent[4];
   int incr = (yMax - yMin + 1)*(zIdx - zMin) + (yIdx - yMin);
 
-  int &clistlen = this->ExtentListLengths[incr];
-  int *&clist = this->ExtentLists[incr];
-
-  if (clistlen == 0)
-    { // no space has been allocated yet
-    clist = new int[2];
-    clist[clistlen] = r1;
-    clist[clistlen + 1] = r2 + 1;
-    clistlen += 2;
-    return;
-    }
-  
-  for (int k = 0; k < clistlen; k+=2)
-    {
-    if ((r1 >= clist[k] && r1 < clist[k+1]) || 
-        (r2 >= clist[k] && r2 < clist[k+1]))
-      {
-      // An intersecting extent is already present. Merge with that one.
-      if (r1 < clist[k])
-        {
-        clist[k] = r1;
-        }
-      else if (r2 >= clist[k+1])
-        {
-        clist[k+1] = r2+1;
-        this->CollapseAdditionalIntersections(r2, k+2, clist, clistlen);
-        }
-      return;
-      }
-    else if (r1 < clist[k] && r2 >= clist[k+1])
-      {
-      clist[k]   = r1;
-      clist[k+1] = r2+1;
-      this->CollapseAdditionalIntersections(r2, k+2, clist, clistlen);
-      return;
-      }
-    }
-
-  // We will be inserting a unique extent...
-
-  // check whether more space is needed
-  // the allocated space is always the smallest power of two
-  // that is not less than the number of stored items, therefore
-  // we need to allocate space when clistlen is a power of two
-  if ((clistlen & (clistlen-1)) == 0)
-    {
-    int *newclist = new int[2*clistlen];
-    for (int k = 0; k < clistlen; k++)
-      {
-      newclist[k] = clist[k];
-      }
-    delete [] clist;
-    clist = newclist;
-    }
-
-  // shift to make room for the insertion
-  int insertIndex = clistlen;
-  clistlen += 2;
-  while (r1 < clist[insertIndex-1])
-    {
-    clist[insertIndex] = clist[insertIndex-2];
-    clist[insertIndex+1] = clist[insertIndex-1];
-    insertIndex -= 2;
-    }
-
-  clist[insertIndex] = r1;
-  clist[insertIndex+1] = r2 + 1;
-}
-
-
-//----------------------------------------------------------------------------
-void vtkImageStencilData::CollapseAdditionalIntersections(int r2, int idx,
-                                                          int *clist,
-                                                          int &clistlen)
-{
-  if (idx >= clistlen)
-    {
-    return;
-    }
-
-  int removeExtentStart = idx, removeExtentEnd = idx;
-  // overlap with any of the remainder of the list?
-  for (; idx < clistlen; idx+=2, removeExtentEnd+=2)
-    {
-    if (r2 < clist[idx])
-      {
-      if (idx == removeExtentStart)
-        {
-        // no additional overlap... thus no collapse
-        return;
-        }
-      break;
-      }
-    else if (r2 < clist[idx+1])
-      {
-      clist[removeExtentStart - 1] = clist[idx+1];
-      }
-    }
-
-  // collapse the list?
-  int i;
-  for (i = removeExtentEnd, idx = removeExtentStart; i < clistlen; i++, idx++)
-    {
-    clist[idx] = clist[i];
-    }
-  clistlen = idx;
+  int extent[2];
+  extent[0] = r1;
+  extent[1] = r2 + 1;
+  this->CombineExtentList(incr, extent, 2, VTK_STENCIL_UNION);
 }
 
 //----------------------------------------------------------------------------
 void vtkImageStencilData::RemoveExtent(int r1, int r2, int yIdx, int zIdx)
 {
-  int xMin = this->Extent[0];
-  int xMax = this->Extent[1];
   int yMin = this->Extent[2];
   int yMax = this->Extent[3];
   int zMin = this->Extent[4];
   int zMax = this->Extent[5];
 
-  if (zIdx < zMin || zIdx > zMax || yIdx < yMin || yIdx > yMax )
+  if (zIdx < zMin || zIdx > zMax || yIdx < yMin || yIdx > yMax || r1 > r2)
     {
     return;
     }
@@ -661,110 +802,10 @@ void vtkImageStencilData::RemoveExtent(int r1, int r2, int yIdx, int zIdx)
   // calculate the index into the extent array
   int incr = (yMax - yMin + 1)*(zIdx - zMin) + (yIdx - yMin);
 
-  int &clistlen = this->ExtentListLengths[incr];
-  int *&clist = this->ExtentLists[incr];
-
-  if (clistlen == 0)
-    { // nothing here.. nothing to remove
-    return;
-    }
-
-  if (r1 <= xMin && r2 >= xMax)
-    {
-    // remove the whole row.
-    clistlen = 0;
-    delete [] clist;
-    clist = NULL;
-    return;
-    }
-  
-  int length = clistlen;
-  for (int k = 0; k < length; k += 2)
-    {
-    if (r1 <=  clist[k] && r2 >= (clist[k+1]-1))
-      {  
-      // Remove this entry;
-      clistlen -= 2;
-
-      if (clistlen == 0)
-        {
-        delete [] clist;
-        clist = NULL;
-        return;
-        }
-
-      int clistmaxlen = 2;
-      while (clistlen > clistmaxlen)
-        {
-        clistmaxlen *= 2;
-        }
-      
-      if (clistmaxlen == clistlen)
-        {
-        int *newclist = new int[clistmaxlen];
-        for (int m = 0;   m < k;    m++)   { newclist[m]   = clist[m]; }
-        for (int m = k+2; m < length; m++) { newclist[m-2] = clist[m]; }
-        delete [] clist;
-        clist = newclist;
-        }
-      else
-        {
-        for (int m = k+2; m < length; m++) { clist[m-2] = clist[m]; }
-        }
-
-      length = clistlen;
-      if (k >= length)
-        {
-        return;
-        }
-      }
-     
-    if ((r1 >= clist[k] && r1 < clist[k+1]) || 
-        (r2 >= clist[k] && r2 < clist[k+1]))
-      {
-
-      bool split = false;  
-      int tmp = -1;    
-
-      // An intersecting extent is already present. Merge with that one.
-      if (r1 > clist[k])
-        {
-        tmp = clist[k+1];
-        clist[k+1] = r1;
-        split    = true;
-        }
-      if (split)
-        {
-        if (r2 < tmp-1)
-          {
-          // check whether more space is needed
-          // the allocated space is always the smallest power of two
-          // that is not less than the number of stored items, therefore
-          // we need to allocate space when clistlen is a power of two
-          if ((clistlen & (clistlen-1)) == 0)
-            {
-            int *newclist = new int[2*clistlen];
-            for (int m = 0; m < clistlen; m++)
-              {
-              newclist[m] = clist[m];
-              }
-            delete [] clist;
-            clist = newclist;
-            }
-          clist[clistlen] = r2+1;
-          clist[clistlen+1] = tmp;
-          clistlen += 2;
-          }
-        }
-      else
-        {
-        if (r2 < clist[k+1]-1)
-          {
-          clist[k] = r2+1;
-          }
-        }
-      }
-    }
+  int extent[2];
+  extent[0] = r1;
+  extent[1] = r2 + 1;
+  this->CombineExtentList(incr, extent, 2, VTK_STENCIL_DIFFERENCE);
 }
 
 //----------------------------------------------------------------------------
@@ -783,7 +824,7 @@ vtkImageStencilData* vtkImageStencilData::GetData(vtkInformationVector* v,
 //----------------------------------------------------------------------------
 void vtkImageStencilData::InternalAdd( vtkImageStencilData * stencil1 )
 {
-  int extent[6], extent1[6], extent2[6], r1, r2, idy, idz, iter=0;
+  int extent[6], extent1[6], extent2[6];
   stencil1->GetExtent(extent1);
   this->GetExtent(extent2);
   
@@ -794,36 +835,21 @@ void vtkImageStencilData::InternalAdd( vtkImageStencilData * stencil1 )
   extent[4] = (extent1[4] < extent2[4]) ? extent2[4] : extent1[4];
   extent[5] = (extent1[5] > extent2[5]) ? extent2[5] : extent1[5];
 
-  bool modified = false;
-  for (idz=extent[4]; idz<=extent[5]; idz++, iter=0)
-    {
-    for (idy = extent[2]; idy <= extent[3]; idy++, iter=0)
-      {
-      int moreSubExtents = 1;
-      while( moreSubExtents )
-        {
-        moreSubExtents = stencil1->GetNextExtent( 
-          r1, r2, extent[0], extent[1], idy, idz, iter);
-
-        if (r1 <= r2 ) // sanity check 
-          { 
-          this->InsertAndMergeExtent(r1, r2, idy, idz); 
-          modified = true;
-          }
-        }
-      }
-    }
-  
-  if (modified)
+  if (extent[0] > extent[1] ||
+      extent[2] > extent[3] ||
+      extent[4] > extent[5])
     {
-    this->Modified();
+    return;
     }
+
+  this->CombineExtentLists(stencil1, extent, VTK_STENCIL_UNION);
+  this->Modified();
 }
 
 //----------------------------------------------------------------------------
 void vtkImageStencilData::Add( vtkImageStencilData * stencil1 )
 {
-  int extent[6], extent1[6], extent2[6], r1, r2, idy, idz, iter=0;
+  int extent[6], extent1[6], extent2[6];
   stencil1->GetExtent(extent1);
   this->GetExtent(extent2);
 
@@ -844,12 +870,6 @@ void vtkImageStencilData::Add( vtkImageStencilData * stencil1 )
     return;
     }
 
-  // Need to reallocate extent lists. 
-  // 1. We will create a temporary stencil data.
-  // 2. Copy Self into this temporary stencil. 
-  // 3. Reallocate Self's extents to match the resized stencil. 
-  // 4. Merge stencil data from both into the Self.
-
   // Find the smallest bounding box large enough to hold both stencils.
   extent[0] = (extent1[0] > extent2[0]) ? extent2[0] : extent1[0];
   extent[1] = (extent1[1] < extent2[1]) ? extent2[1] : extent1[1];
@@ -858,57 +878,69 @@ void vtkImageStencilData::Add( vtkImageStencilData * stencil1 )
   extent[4] = (extent1[4] > extent2[4]) ? extent2[4] : extent1[4];
   extent[5] = (extent1[5] < extent2[5]) ? extent2[5] : extent1[5];
 
-  vtkImageStencilData *tmp = vtkImageStencilData::New();
-  tmp->DeepCopy(this);
-
-  this->SetExtent(extent);
-  this->AllocateExtents(); // Reallocate extents.
-
-  for (idz=extent2[4]; idz<=extent2[5]; idz++, iter=0)
+  // Make the tables of the rows for the larger extent, and move the lists
+  // of Self into them, along with the blocks of their slices.
+  vtkImageStencilDataInternals *internal = this->Internal;
+  int ySize = extent[3] - extent[2] + 1;
+  int zSize = extent[5] - extent[4] + 1;
+  int numEntries = ySize*zSize;
+  int *lengths = new int[numEntries];
+  int **lists = new int *[numEntries];
+  vtkstd::vector<unsigned char> capacities(numEntries, 0);
+  vtkstd::vector<vtkImageStencilDataInternals::Slice> slices(zSize);
+  int idx;
+  for (idx = 0; idx < numEntries; idx++)
     {
-    for (idy = extent2[2]; idy <= extent2[3]; idy++, iter=0)
-      {
-      int moreSubExtents = 1;
-      while( moreSubExtents )
-        {
-        moreSubExtents = tmp->GetNextExtent( 
-          r1, r2, extent[0], extent[1], idy, idz, iter);
-
-        if (r1 <= r2 ) // sanity check 
-          { 
-          this->InsertAndMergeExtent(r1, r2, idy, idz); 
-          }
-        }
-      }
+    lengths[idx] = 0;
+    lists[idx] = NULL;
+    }
+  for (int slice = 0; slice < zSize; slice++)
+    {
+    vtkImageStencilDataInternals::InitializeSlice(slices[slice]);
     }
-  
-  tmp->Delete();
 
-  for (idz=extent1[4]; idz<=extent1[5]; idz++, iter=0)
+  if (this->NumberOfExtentEntries != 0)
     {
-    for (idy = extent1[2]; idy <= extent1[3]; idy++, iter=0)
+    int yExt2 = extent2[3] - extent2[2] + 1;
+    for (int idz = extent2[4]; idz <= extent2[5]; idz++)
       {
-      int moreSubExtents = 1;
-      while( moreSubExtents )
+      slices[idz - extent[4]].Blocks.swap(
+        internal->Slices[idz - extent2[4]].Blocks);
+      slices[idz - extent[4]].Next = internal->Slices[idz - extent2[4]].Next;
+      slices[idz - extent[4]].End = internal->Slices[idz - extent2[4]].End;
+      slices[idz - extent[4]].Allocated =
+        internal->Slices[idz - extent2[4]].Allocated;
+      slices[idz - extent[4]].Used = internal->Slices[idz - extent2[4]].Used;
+      vtkImageStencilDataInternals::InitializeSlice(
+        internal->Slices[idz - extent2[4]]);
+      for (int idy = extent2[2]; idy <= extent2[3]; idy++)
         {
-        moreSubExtents = stencil1->GetNextExtent( 
-          r1, r2, extent[0], extent[1], idy, idz, iter);
-
-        if (r1 <= r2 ) // sanity check 
-          { 
-          this->InsertAndMergeExtent(r1, r2, idy, idz); 
-          }
+        int oldIdx = yExt2*(idz - extent2[4]) + (idy - extent2[2]);
+        idx = ySize*(idz - extent[4]) + (idy - extent[2]);
+        lengths[idx] = this->ExtentListLengths[oldIdx];
+        lists[idx] = this->ExtentLists[oldIdx];
+        capacities[idx] = internal->Capacities[oldIdx];
         }
       }
     }
 
+  this->ReleaseExtents();
+  this->NumberOfExtentEntries = numEntries;
+  this->ExtentListLengths = lengths;
+  this->ExtentLists = lists;
+  internal->Slices.swap(slices);
+  internal->Capacities.swap(capacities);
+  internal->RowsPerSlice = ySize;
+  this->SetExtent(extent);
+
+  this->InternalAdd(stencil1);
   this->Modified();
 } 
 
 //----------------------------------------------------------------------------
 void vtkImageStencilData::Subtract( vtkImageStencilData * stencil1 )
 {
-  int extent[6], extent1[6], extent2[6], r1, r2, idy, idz, iter=0;
+  int extent[6], extent1[6], extent2[6];
   stencil1->GetExtent(extent1);
   this->GetExtent(extent2);
 
@@ -928,37 +960,21 @@ void vtkImageStencilData::Subtract( vtkImageStencilData * stencil1 )
   extent[4] = (extent1[4] < extent2[4]) ? extent2[4] : extent1[4];
   extent[5] = (extent1[5] > extent2[5]) ? extent2[5] : extent1[5];
 
-  for (idz=extent[4]; idz<=extent[5]; idz++, iter=0)
-    {
-    for (idy = extent[2]; idy <= extent[3]; idy++, iter=0)
-      {
-      int moreSubExtents = 1;
-      while( moreSubExtents )
-        {
-        moreSubExtents = stencil1->GetNextExtent( 
-          r1, r2, extent[0], extent[1], idy, idz, iter);
-
-        if (r1 <= r2 ) // sanity check 
-          { 
-          this->RemoveExtent(r1, r2, idy, idz); 
-          }
-        }
-      }
-    }
-
+  this->CombineExtentLists(stencil1, extent, VTK_STENCIL_DIFFERENCE);
   this->Modified();
 } 
 
 //----------------------------------------------------------------------------
 void vtkImageStencilData::Replace( vtkImageStencilData * stencil1 )
 {
-  int extent[6], extent1[6], extent2[6], r1, r2, idy, idz, iter=0;
+  int extent[6], extent1[6], extent2[6];
   stencil1->GetExtent(extent1);
   this->GetExtent(extent2);
 
   if ((extent1[0] > extent2[1]) || (extent1[1] < extent2[0]) || 
       (extent1[2] > extent2[3]) || (extent1[3] < extent2[2]) || 
-      (extent1[4] > extent2[5]) || (extent1[5] < extent2[4]))
+      (extent1[4] > extent2[5]) || (extent1[5] < extent2[4]) ||
+      this->NumberOfExtentEntries == 0)
     {
     // The extents don't intersect.. No subraction needed
     return;
@@ -972,25 +988,20 @@ void vtkImageStencilData::Replace( vtkImageStencilData * stencil1 )
   extent[4] = (extent1[4] < extent2[4]) ? extent2[4] : extent1[4];
   extent[5] = (extent1[5] > extent2[5]) ? extent2[5] : extent1[5];
 
-  for (idz=extent[4]; idz<=extent[5]; idz++, iter=0)
+  // Clear the intersection, then add the stencil within it
+  int xRange[2];
+  xRange[0] = extent[0];
+  xRange[1] = extent[1] + 1;
+  int yExt = extent2[3] - extent2[2] + 1;
+  for (int idz = extent[4]; idz <= extent[5]; idz++)
     {
-    for (idy = extent[2]; idy <= extent[3]; idy++, iter=0)
+    for (int idy = extent[2]; idy <= extent[3]; idy++)
       {
-      this->RemoveExtent(extent[0], extent[1], idy, idz); 
-
-      int moreSubExtents = 1;
-      while( moreSubExtents )
-        {
-        moreSubExtents = stencil1->GetNextExtent( 
-          r1, r2, extent[0], extent[1], idy, idz, iter);
-
-        if (r1 <= r2 ) // sanity check 
-          { 
-          this->InsertAndMergeExtent(r1, r2, idy, idz);
-          }
-        }
+      int idx = yExt*(idz - extent2[4]) + (idy - extent2[2]);
+      this->CombineExtentList(idx, xRange, 2, VTK_STENCIL_DIFFERENCE);
       }
     }
+  this->CombineExtentLists(stencil1, extent, VTK_STENCIL_UNION);
 
   this->Modified();
 } 
@@ -1008,40 +1019,38 @@ int vtkImageStencilData::Clip( int extent[6] )
     return 0;
     }
 
-  bool removeXLeft  = (extent[0] > currentExtent[0]);
-  bool removeXRight = (extent[1] < currentExtent[1]);  
-  bool remove = false, removed = false;
-
-  for (idz=currentExtent[4]; idz<=currentExtent[5]; idz++)
+  // Empty the rows outside of the extents, and clip the others in x.
+  int xRange[2];
+  xRange[0] = extent[0];
+  xRange[1] = extent[1] + 1;
+  int removed = 0;
+  int idx = 0;
+  for (idz=currentExtent[4];
+       idz<=currentExtent[5] && this->NumberOfExtentEntries != 0; idz++)
     {
-    remove = (idz < extent[4] || idz > extent[5]);
-    for (idy = currentExtent[2]; idy <= currentExtent[3]; idy++)
+    bool remove = (idz < extent[4] || idz > extent[5]);
+    for (idy = currentExtent[2]; idy <= currentExtent[3]; idy++, idx++)
       {
+      int &clistlen = this->ExtentListLengths[idx];
+      int *clist = this->ExtentLists[idx];
+      if (clistlen == 0)
+        {
+        continue;
+        }
       if (remove || idy < extent[2] || idy > extent[3])
         {
-        // Remove everything at Y = idy, Z = idz.
-        this->RemoveExtent( currentExtent[0],currentExtent[1], idy, idz );
-        removed |= true;
+        clistlen = 0;
+        removed = 1;
         }
-      else
+      else if (clist[0] < xRange[0] || clist[clistlen-1] > xRange[1])
         {
-        if (removeXLeft)
-          {
-          // Clip on the left at Y = idy, Z = idz.
-          this->RemoveExtent( currentExtent[0], extent[0]-1, idy, idz );
-          removed |= true;
-          }
-        if (removeXRight)
-          {
-          // Clip on the right at Y = idy, Z = idz.
-          this->RemoveExtent( extent[1]+1, currentExtent[1], idy, idz );
-          removed |= true;
-          }
+        this->CombineExtentList(idx, xRange, 2, VTK_STENCIL_INTERSECTION);
+        removed = 1;
         }
       }
     }
 
-  return (removed ? 1 : 0);
+  return removed;
 }
 
 //----------------------------------------------------------------------------
@@ -18,6 +18,12 @@
 // efficient both in terms of speed and storage space.  The stencil extents
 // are stored for each x-row across the image (multiple extents per row if
 // necessary) and can be retrieved via the GetNextExtent() method.
+//
+// The extents of the rows of each slice are kept together in a few blocks
+// of memory that belong to the slice, rather than in an allocation per
+// row, so that large stencils stay compact.  The rows of different slices
+// can therefore be filled by different threads at the same time.  The
+// stencils are combined row by row, by merging their sorted extents.
 // .SECTION see also
 // vtkImageStencilSource vtkImageStencil
 
@@ -27,6 +33,8 @@
 
 #include "vtkDataObject.h"
 
+class vtkImageStencilDataInternals;
+
 class VTK_IMAGING_EXPORT vtkImageStencilData : public vtkDataObject
 {
 public:
@@ -62,9 +70,10 @@ public:
   // Description:
   // This method is used by vtkImageStencilDataSource to add an x 
   // sub extent [r1,r2] for the x row (yIdx,zIdx).  The specified sub
-  // extent must not intersect any other sub extents along the same x row.
-  // As well, r1 and r2 must both be within the total x extent
-  // [Extent[0],Extent[1]].
+  // extent must not intersect any other sub extents along the same x row,
+  // and must follow them.  As well, r1 and r2 must both be within the
+  // total x extent [Extent[0],Extent[1]].  Rows of different slices may
+  // be filled concurrently.
   void InsertNextExtent(int r1, int r2, int yIdx, int zIdx);
   
   // Description:
@@ -109,6 +118,10 @@ public:
   // vtkImageStencilSource.
   void AllocateExtents();
 
+  // Description:
+  // Return the memory used by the stencil in kilobytes.
+  virtual unsigned long GetActualMemorySize();
+
   // Description:
   // Fill the sub-extents.
   void Fill();
@@ -160,9 +173,28 @@ protected:
   // Merges portions of the stencil that are within Self's extents into 
   // itself. 
   virtual void InternalAdd( vtkImageStencilData * );
-  
-  void CollapseAdditionalIntersections(int r2, int idx, int *clist, 
-    int &clistlen);
+
+  // Description:
+  // Make room for n entries in the extent list of a row, given by its
+  // index in ExtentLists, and return the list.  The entries already in
+  // the list are kept.
+  int *ResizeExtentList(int idx, int n);
+
+  // Description:
+  // Replace the extent list of a row with its combination with a list
+  // of n entries.  The operation has a bit for each state of a position,
+  // (inRow*2 + inList), that is set if the position is in the result.
+  void CombineExtentList(int idx, const int *list, int n, int operation);
+
+  // Description:
+  // Combine the rows of a stencil, clipped to an extent that lies within
+  // both stencils, with the rows of this stencil.
+  void CombineExtentLists(vtkImageStencilData *stencil, const int extent[6],
+                          int operation);
+
+  // Description:
+  // Free the extent lists and the tables of the rows.
+  void ReleaseExtents();
 
   // Description:
   // The Spacing and Origin of the data.
@@ -172,10 +204,12 @@ protected:
   int Extent[6];
 
   // Description:
-  // The actual 'data' is stored here.
+  // The actual 'data' is stored here.  Each list holds the starts and the
+  // ends plus one of the sub extents of a row, in increasing order.
   int NumberOfExtentEntries;
   int *ExtentListLengths;
   int **ExtentLists;
+  vtkImageStencilDataInternals *Internal;
 
 private:
   vtkImageStencilData(const vtkImageStencilData&);  // Not implemented.
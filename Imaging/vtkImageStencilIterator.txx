@@ -303,8 +303,9 @@ void vtkImageStencilIterator<DType>::NextSpan()
       }
     else if (this->SpanEndPointer != this->EndPointer)
       {
-      // Move to the next slice
-      this->Pointer = this->SliceEndPointer + this->SliceEndIncrement;
+      // Move to the next slice, from the end of the last row
+      this->Pointer = this->SliceEndPointer + this->RowEndIncrement +
+        this->SliceEndIncrement;
       this->SliceEndPointer += this->SliceIncrement;
       this->RowEndPointer = this->Pointer +
         (this->RowIncrement - this->RowEndIncrement);
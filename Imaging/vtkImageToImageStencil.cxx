@@ -19,6 +19,7 @@
 #include "vtkImageStencilData.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
 #include "vtkStreamingDemandDrivenPipeline.h"
@@ -32,11 +33,15 @@ vtkImageToImageStencil::vtkImageToImageStencil()
 {
   this->UpperThreshold = VTK_LARGE_FLOAT;
   this->LowerThreshold = -VTK_LARGE_FLOAT;
+
+  this->Threader = vtkMultiThreader::New();
+  this->NumberOfThreads = this->Threader->GetNumberOfThreads();
 }
 
 //----------------------------------------------------------------------------
 vtkImageToImageStencil::~vtkImageToImageStencil()
 {
+  this->Threader->Delete();
 }
 
 //----------------------------------------------------------------------------
@@ -47,6 +52,7 @@ void vtkImageToImageStencil::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "Input: " << this->GetInput() << "\n";
   os << indent << "UpperThreshold: " << this->UpperThreshold << "\n";
   os << indent << "LowerThreshold: " << this->LowerThreshold << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
 }
 
 //----------------------------------------------------------------------------
@@ -111,40 +117,68 @@ void vtkImageToImageStencil::ThresholdBetween(double lower, double upper)
 }
 
 //----------------------------------------------------------------------------
-int vtkImageToImageStencil::RequestData(
-  vtkInformation *,
-  vtkInformationVector **inputVector,
-  vtkInformationVector *outputVector)
+// The slices of the stencil are split into one slab per thread, since the
+// rows of different slices can be filled at the same time.
+namespace
 {
-  vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
-  vtkInformation *outInfo = outputVector->GetInformationObject(0);
-  vtkImageData *inData = vtkImageData::SafeDownCast(
-    inInfo->Get(vtkDataObject::DATA_OBJECT()));
-  vtkImageStencilData *data = vtkImageStencilData::SafeDownCast(
-    outInfo->Get(vtkDataObject::DATA_OBJECT()));
+struct vtkImageToImageStencilStruct
+{
+  vtkImageToImageStencil *Filter;
+  vtkImageStencilData *Data;
+  vtkDataArray *Scalars;
+  void *InPtr;
+  int ScalarType;
+  int InExtent[6];
+  int NumberOfComponents;
+  int Extent[6];
+  double LowerThreshold;
+  double UpperThreshold;
+  int NumberOfThreads;
+};
+}
 
-  int extent[6];
-  inData->GetExtent(extent);
-  // output extent is always the input extent
-  this->AllocateOutputData(data, extent);
+//----------------------------------------------------------------------------
+// Get the first component of a tuple.  Scalars of a type that
+// vtkTemplateMacro does not handle, such as VTK_BIT, are read through
+// the vtkDataArray itself.
+template <class T>
+inline double vtkImageToImageStencilValue(T *inPtr, vtkIdType tupleId,
+                                          int numComponents)
+{
+  return static_cast<double>(inPtr[tupleId*numComponents]);
+}
 
-  vtkDataArray *inScalars = inData->GetPointData()->GetScalars();
-  double upperThreshold = this->UpperThreshold;
-  double lowerThreshold = this->LowerThreshold;
+inline double vtkImageToImageStencilValue(vtkDataArray *scalars,
+                                          vtkIdType tupleId, int)
+{
+  return scalars->GetComponent(tupleId, 0);
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+void vtkImageToImageStencilExecute(vtkImageToImageStencilStruct *ts,
+                                   T inPtr, int zMin, int zMax, int report)
+{
+  vtkImageStencilData *data = ts->Data;
+  int *extent = ts->Extent;
+  int *inExt = ts->InExtent;
+  int numComponents = ts->NumberOfComponents;
+  double upperThreshold = ts->UpperThreshold;
+  double lowerThreshold = ts->LowerThreshold;
 
   // for keeping track of progress
   unsigned long count = 0;
   unsigned long target = static_cast<unsigned long>(
-    (extent[5] - extent[4] + 1)*(extent[3] - extent[2] + 1)/50.0);
+    (zMax - zMin + 1)*(extent[3] - extent[2] + 1)/50.0);
   target++;
 
-  for (int idZ = extent[4]; idZ <= extent[5]; idZ++)
+  for (int idZ = zMin; idZ <= zMax; idZ++)
     {
     for (int idY = extent[2]; idY <= extent[3]; idY++)
       {
-      if (count%target == 0) 
+      if (report && count%target == 0)
         {
-        this->UpdateProgress(count/(50.0*target));
+        ts->Filter->UpdateProgress(count/(50.0*target));
         }
       count++;
 
@@ -152,15 +186,17 @@ int vtkImageToImageStencil::RequestData(
       int r1 = extent[0];
       int r2 = extent[1];
 
-      // index into scalar array
-      int idS = ((extent[1] - extent[0] + 1)*
-                 ((extent[3] - extent[2] + 1)*(idZ - extent[4]) +
-                  (idY - extent[2])));
+      // the scalars of the row, which may be within a larger input
+      vtkIdType tupleId =
+        (static_cast<vtkIdType>(inExt[3] - inExt[2] + 1)*(idZ - inExt[4]) +
+         (idY - inExt[2]))*(inExt[1] - inExt[0] + 1) +
+        (extent[0] - inExt[0]);
 
       for (int idX = extent[0]; idX <= extent[1]; idX++)
         {
         int newstate = 1;
-        double value = inScalars->GetComponent(idS++,0);
+        double value =
+          vtkImageToImageStencilValue(inPtr, tupleId++, numComponents);
         if (value >= lowerThreshold && value <= upperThreshold)
           {
           newstate = -1;
@@ -182,6 +218,101 @@ int vtkImageToImageStencil::RequestData(
         }
       } // for idY
     } // for idZ
+}
+
+//----------------------------------------------------------------------------
+static VTK_THREAD_RETURN_TYPE vtkImageToImageStencilThread(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkImageToImageStencilStruct *ts =
+    static_cast<vtkImageToImageStencilStruct *>(info->UserData);
+  int threadId = info->ThreadID;
+
+  vtkIdType numSlices = ts->Extent[5] - ts->Extent[4] + 1;
+  int zMin = ts->Extent[4] +
+    static_cast<int>(numSlices*threadId/ts->NumberOfThreads);
+  int zMax = ts->Extent[4] +
+    static_cast<int>(numSlices*(threadId + 1)/ts->NumberOfThreads) - 1;
+
+  switch (ts->ScalarType)
+    {
+    vtkTemplateMacro(
+      vtkImageToImageStencilExecute(ts, static_cast<VTK_TT *>(ts->InPtr),
+                                    zMin, zMax, threadId == 0));
+    default:
+      vtkImageToImageStencilExecute(ts, ts->Scalars, zMin, zMax,
+                                    threadId == 0);
+      break;
+    }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+int vtkImageToImageStencil::RequestData(
+  vtkInformation *,
+  vtkInformationVector **inputVector,
+  vtkInformationVector *outputVector)
+{
+  vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
+  vtkInformation *outInfo = outputVector->GetInformationObject(0);
+  vtkImageData *inData = vtkImageData::SafeDownCast(
+    inInfo->Get(vtkDataObject::DATA_OBJECT()));
+  vtkImageStencilData *data = vtkImageStencilData::SafeDownCast(
+    outInfo->Get(vtkDataObject::DATA_OBJECT()));
+
+  // output extent is the part of the update extent that is in the input
+  int extent[6], inExt[6];
+  outInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), extent);
+  inData->GetExtent(inExt);
+  for (int i = 0; i < 6; i += 2)
+    {
+    extent[i] = (extent[i] > inExt[i] ? extent[i] : inExt[i]);
+    extent[i+1] = (extent[i+1] < inExt[i+1] ? extent[i+1] : inExt[i+1]);
+    }
+  this->AllocateOutputData(data, extent);
+
+  if (extent[0] > extent[1] || extent[2] > extent[3] || extent[4] > extent[5])
+    {
+    return 1;
+    }
+
+  vtkDataArray *inScalars = inData->GetPointData()->GetScalars();
+  if (inScalars == NULL)
+    {
+    vtkErrorMacro("Execute: the input has no scalars");
+    return 1;
+    }
+
+  vtkImageToImageStencilStruct ts;
+  ts.Filter = this;
+  ts.Data = data;
+  ts.Scalars = inScalars;
+  ts.InPtr = inScalars->GetVoidPointer(0);
+  ts.ScalarType = inScalars->GetDataType();
+  ts.NumberOfComponents = inScalars->GetNumberOfComponents();
+  ts.LowerThreshold = this->LowerThreshold;
+  ts.UpperThreshold = this->UpperThreshold;
+  for (int j = 0; j < 6; j++)
+    {
+    ts.Extent[j] = extent[j];
+    ts.InExtent[j] = inExt[j];
+    }
+
+  int numThreads = this->NumberOfThreads;
+  int maxThreads = vtkMultiThreader::GetGlobalMaximumNumberOfThreads();
+  if (maxThreads > 0 && numThreads > maxThreads)
+    {
+    numThreads = maxThreads;
+    }
+  numThreads = (numThreads < extent[5] - extent[4] + 1 ? numThreads :
+                extent[5] - extent[4] + 1);
+  ts.NumberOfThreads = (numThreads < 1 ? 1 : numThreads);
+
+  this->Threader->SetNumberOfThreads(ts.NumberOfThreads);
+  this->Threader->SetSingleMethod(vtkImageToImageStencilThread, &ts);
+  this->Threader->SingleMethodExecute();
 
   return 1;
 }
@@ -196,10 +327,13 @@ int vtkImageToImageStencil::RequestInformation(
   vtkInformation *outInfo = outputVector->GetInformationObject(0);
 
   // whole extent is largest possible extent, because this filter
-  // can accommodate any update extent
-  static int wholeExtent[6] = { 0, VTK_LARGE_INTEGER >> 2,
-                                0, VTK_LARGE_INTEGER >> 2,
-                                0, VTK_LARGE_INTEGER >> 2 };
+  // can accommodate any update extent, including negative ones
+  static int wholeExtent[6] = { -(VTK_LARGE_INTEGER >> 2),
+                                VTK_LARGE_INTEGER >> 2,
+                                -(VTK_LARGE_INTEGER >> 2),
+                                VTK_LARGE_INTEGER >> 2,
+                                -(VTK_LARGE_INTEGER >> 2),
+                                VTK_LARGE_INTEGER >> 2 };
   double spacing[3];
   double origin[3];
 
@@ -226,11 +360,28 @@ int vtkImageToImageStencil::FillInputPortInformation(int,
 int vtkImageToImageStencil::RequestUpdateExtent(
   vtkInformation *,
   vtkInformationVector **inputVector,
-  vtkInformationVector *)
+  vtkInformationVector *outputVector)
 {
   vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
-  inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(),
-              inInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT()),
-              6);
+  vtkInformation *outInfo = outputVector->GetInformationObject(0);
+
+  // request only the part of the input that is within the update extent,
+  // or the whole input if there is none
+  int extent[6], wholeExtent[6];
+  outInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), extent);
+  inInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), wholeExtent);
+  for (int i = 0; i < 6; i += 2)
+    {
+    extent[i] = (extent[i] > wholeExtent[i] ? extent[i] : wholeExtent[i]);
+    extent[i+1] = (extent[i+1] < wholeExtent[i+1] ? extent[i+1] :
+                   wholeExtent[i+1]);
+    if (extent[i] > extent[i+1])
+      {
+      memcpy(extent, wholeExtent, 6*sizeof(int));
+      break;
+      }
+    }
+
+  inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), extent, 6);
   return 1;
 }
@@ -17,6 +17,9 @@
 // vtkImageToImageStencil will convert a vtkImageData into an stencil
 // that can be used with vtkImageStecil or other vtk classes that apply
 // a stencil to an image.
+//
+// Only the requested extent of the stencil is generated, from the same
+// extent of the input, and its slices are split between threads.
 // .SECTION see also
 // vtkImageStencil vtkImplicitFunctionToImageStencil vtkPolyDataToImageStencil
 
@@ -27,6 +30,7 @@
 #include "vtkImageStencilAlgorithm.h"
 
 class vtkImageData;
+class vtkMultiThreader;
 
 class VTK_IMAGING_EXPORT vtkImageToImageStencil : public vtkImageStencilAlgorithm
 {
@@ -59,6 +63,12 @@ public:
   vtkSetMacro(LowerThreshold, double);
   vtkGetMacro(LowerThreshold, double);
 
+  // Description:
+  // Get/Set the number of threads, each of which thresholds its own slab
+  // of slices.  Initial value is the number of processors.
+  vtkSetClampMacro(NumberOfThreads, int, 1, VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads, int);
+
 protected:
   vtkImageToImageStencil();
   ~vtkImageToImageStencil();
@@ -71,6 +81,9 @@ protected:
   double UpperThreshold;
   double LowerThreshold;
   double Threshold;
+
+  vtkMultiThreader *Threader;
+  int NumberOfThreads;
 private:
   vtkImageToImageStencil(const vtkImageToImageStencil&);  // Not implemented.
   void operator=(const vtkImageToImageStencil&);  // Not implemented.
@@ -19,6 +19,7 @@
 #include "vtkImageData.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkStreamingDemandDrivenPipeline.h"
 
@@ -35,12 +36,16 @@ vtkImplicitFunctionToImageStencil::vtkImplicitFunctionToImageStencil()
   this->Threshold = 0;
 
   this->Input = NULL;
+
+  this->Threader = vtkMultiThreader::New();
+  this->NumberOfThreads = 1;
 }
 
 //----------------------------------------------------------------------------
 vtkImplicitFunctionToImageStencil::~vtkImplicitFunctionToImageStencil()
 {
   this->SetInput(NULL);
+  this->Threader->Delete();
 }
 
 //----------------------------------------------------------------------------
@@ -51,45 +56,48 @@ void vtkImplicitFunctionToImageStencil::PrintSelf(ostream& os,
 
   os << indent << "Input: " << this->Input << "\n";
   os << indent << "Threshold: " << this->Threshold << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
 }
 
 //----------------------------------------------------------------------------
-// set up the clipping extents from an implicit function by brute force
-// (i.e. by evaluating the function at each and every voxel)
-int vtkImplicitFunctionToImageStencil::RequestData(
-  vtkInformation *request,
-  vtkInformationVector **inputVector,
-  vtkInformationVector *outputVector)
+// The slices of the stencil are split into one slab per thread, since the
+// rows of different slices can be filled at the same time.
+namespace
 {
-  this->Superclass::RequestData(request, inputVector, outputVector);
+struct vtkImplicitFunctionToImageStencilStruct
+{
+  vtkImplicitFunctionToImageStencil *Filter;
+  vtkImplicitFunction *Function;
+  vtkImageStencilData *Data;
+  double Threshold;
+  int Extent[6];
+  int NumberOfThreads;
+};
+}
 
-  vtkInformation *outInfo = outputVector->GetInformationObject(0);
-  vtkImageStencilData *data = vtkImageStencilData::SafeDownCast(
-    outInfo->Get(vtkDataObject::DATA_OBJECT()));
-  vtkImplicitFunction *function = this->Input;
+//----------------------------------------------------------------------------
+static void vtkImplicitFunctionToImageStencilExecute(
+  vtkImplicitFunctionToImageStencilStruct *ts, int zMin, int zMax,
+  int report)
+{
+  vtkImageStencilData *data = ts->Data;
+  vtkImplicitFunction *function = ts->Function;
   double *spacing = data->GetSpacing();
   double *origin = data->GetOrigin();
-  double threshold = this->Threshold;
-
-  // if the input is not set then punt
-  if (!function)
-    {
-    return 1;
-    }
+  double threshold = ts->Threshold;
+  int *extent = ts->Extent;
 
   // for conversion of (idX,idY,idZ) into (x,y,z)
   double point[3];
 
   // for keeping track of progress
   unsigned long count = 0;
-  int extent[6];
-  data->GetExtent(extent);
   unsigned long target = static_cast<unsigned long>(
-    (extent[5] - extent[4] + 1)*(extent[3] - extent[2] + 1)/50.0);
+    (zMax - zMin + 1)*(extent[3] - extent[2] + 1)/50.0);
   target++;
 
   // loop through all voxels
-  for (int idZ = extent[4]; idZ <= extent[5]; idZ++)
+  for (int idZ = zMin; idZ <= zMax; idZ++)
     {
     point[2] = idZ*spacing[2] + origin[2];
 
@@ -100,9 +108,9 @@ int vtkImplicitFunctionToImageStencil::RequestData(
       int r1 = extent[0];
       int r2 = extent[1];
 
-      if (count%target == 0) 
+      if (report && count%target == 0)
         {
-        this->UpdateProgress(count/(50.0*target));
+        ts->Filter->UpdateProgress(count/(50.0*target));
         }
       count++;
 
@@ -131,6 +139,85 @@ int vtkImplicitFunctionToImageStencil::RequestData(
         }
       } // for idY    
     } // for idZ
+}
+
+//----------------------------------------------------------------------------
+static VTK_THREAD_RETURN_TYPE vtkImplicitFunctionToImageStencilThread(
+  void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkImplicitFunctionToImageStencilStruct *ts =
+    static_cast<vtkImplicitFunctionToImageStencilStruct *>(info->UserData);
+  int threadId = info->ThreadID;
+
+  vtkIdType numSlices = ts->Extent[5] - ts->Extent[4] + 1;
+  int zMin = ts->Extent[4] +
+    static_cast<int>(numSlices*threadId/ts->NumberOfThreads);
+  int zMax = ts->Extent[4] +
+    static_cast<int>(numSlices*(threadId + 1)/ts->NumberOfThreads) - 1;
+  vtkImplicitFunctionToImageStencilExecute(ts, zMin, zMax, threadId == 0);
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+// set up the clipping extents from an implicit function by brute force
+// (i.e. by evaluating the function at each and every voxel)
+int vtkImplicitFunctionToImageStencil::RequestData(
+  vtkInformation *request,
+  vtkInformationVector **inputVector,
+  vtkInformationVector *outputVector)
+{
+  this->Superclass::RequestData(request, inputVector, outputVector);
+
+  vtkInformation *outInfo = outputVector->GetInformationObject(0);
+  vtkImageStencilData *data = vtkImageStencilData::SafeDownCast(
+    outInfo->Get(vtkDataObject::DATA_OBJECT()));
+
+  // if the input is not set then punt
+  if (!this->Input)
+    {
+    return 1;
+    }
+
+  vtkImplicitFunctionToImageStencilStruct ts;
+  ts.Filter = this;
+  ts.Function = this->Input;
+  ts.Data = data;
+  ts.Threshold = this->Threshold;
+  data->GetExtent(ts.Extent);
+  if (ts.Extent[0] > ts.Extent[1] || ts.Extent[2] > ts.Extent[3] ||
+      ts.Extent[4] > ts.Extent[5])
+    {
+    return 1;
+    }
+
+  int numThreads = this->NumberOfThreads;
+  int maxThreads = vtkMultiThreader::GetGlobalMaximumNumberOfThreads();
+  if (maxThreads > 0 && numThreads > maxThreads)
+    {
+    numThreads = maxThreads;
+    }
+  numThreads = (numThreads < ts.Extent[5] - ts.Extent[4] + 1 ? numThreads :
+                ts.Extent[5] - ts.Extent[4] + 1);
+  ts.NumberOfThreads = (numThreads < 1 ? 1 : numThreads);
+
+  // bring the transform of the function up to date before the threads
+  // evaluate it
+  if (ts.NumberOfThreads > 1)
+    {
+    double point[3];
+    point[0] = data->GetOrigin()[0];
+    point[1] = data->GetOrigin()[1];
+    point[2] = data->GetOrigin()[2];
+    ts.Function->FunctionValue(point);
+    }
+
+  this->Threader->SetNumberOfThreads(ts.NumberOfThreads);
+  this->Threader->SetSingleMethod(vtkImplicitFunctionToImageStencilThread,
+                                  &ts);
+  this->Threader->SingleMethodExecute();
 
   return 1;
 }
@@ -17,6 +17,9 @@
 // vtkImplicitFunctionToImageStencil will convert a vtkImplicitFunction into
 // a stencil that can be used with vtkImageStencil or with other classes
 // that apply a stencil to an image.
+//
+// The stencil is generated only for the requested extent, and its slices
+// can be split between threads.
 // .SECTION see also
 // vtkImplicitFunction vtkImageStencil vtkPolyDataToImageStencil
 
@@ -27,6 +30,7 @@
 #include "vtkImageStencilSource.h"
 
 class vtkImplicitFunction;
+class vtkMultiThreader;
 
 class VTK_IMAGING_EXPORT vtkImplicitFunctionToImageStencil : public vtkImageStencilSource
 {
@@ -45,6 +49,14 @@ public:
   vtkSetMacro(Threshold, double);
   vtkGetMacro(Threshold, double);
 
+  // Description:
+  // Set the number of threads, each of which evaluates the function over
+  // its own slab of slices.  Functions that keep state while they are
+  // evaluated, such as vtkImplicitDataSet and vtkImplicitVolume, must not
+  // be used with more than one thread.  Initial value is 1.
+  vtkSetClampMacro(NumberOfThreads, int, 1, VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads, int);
+
 protected:
   vtkImplicitFunctionToImageStencil();
   ~vtkImplicitFunctionToImageStencil();
@@ -55,6 +67,9 @@ protected:
   vtkImplicitFunction *Input;
   double Threshold;
 
+  vtkMultiThreader *Threader;
+  int NumberOfThreads;
+
 private:
   vtkImplicitFunctionToImageStencil(const vtkImplicitFunctionToImageStencil&);  // Not implemented.
   void operator=(const vtkImplicitFunctionToImageStencil&);  // Not implemented.
@@ -19,10 +19,13 @@
 #include "vtkMath.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkStreamingDemandDrivenPipeline.h"
 #include "vtkPointData.h"
 
+#include <vtkstd/vector>
+
 vtkStandardNewMacro(vtkShepardMethod);
 
 // Construct with sample dimensions=(50,50,50) and so that model bounds are
@@ -134,6 +137,216 @@ int vtkShepardMethod::RequestInformation (
   return 1;
 }
 
+// The volume is split into slabs of slices along z.  The points are binned
+// by the slabs within their maximum distance: each thread bins a range of
+// points into its own lists, so that the lists of the threads, taken in
+// turn, keep the order of the points.  Each slab is then interpolated by
+// one thread, so that the sums of the voxels are made without locks in the
+// same order whatever the number of threads.
+namespace
+{
+struct vtkShepardMethodStruct
+{
+  vtkShepardMethod *Filter;
+  int Pass;
+  vtkDataSet *Input;
+  vtkDataArray *Scalars;
+  float *Output;
+  double *Sum;
+  int Dimensions[3];
+  double Origin[3];
+  double Spacing[3];
+  double MaximumDistance;
+  double NullValue;
+  int NumberOfThreads;
+  int NumberOfSlabs;
+  vtkstd::vector<int> SlabStart;
+  vtkstd::vector<int> SlabOfSlice;
+  vtkstd::vector<vtkstd::vector<vtkIdType> > Bins;
+};
+}
+
+// Compute the bounds of the voxels within the maximum distance of a point,
+// and return 0 if there are none.
+static int vtkShepardMethodFootprint(vtkShepardMethodStruct *ts,
+                                     const double px[3], int min[3],
+                                     int max[3])
+{
+  for (int i=0; i<3; i++)
+    {
+    min[i] = static_cast<int>(
+      ((px[i] - ts->MaximumDistance) - ts->Origin[i]) / ts->Spacing[i]);
+    max[i] = static_cast<int>(
+      ((px[i] + ts->MaximumDistance) - ts->Origin[i]) / ts->Spacing[i]);
+    if (min[i] < 0)
+      {
+      min[i] = 0;
+      }
+    if (max[i] >= ts->Dimensions[i])
+      {
+      max[i] = ts->Dimensions[i] - 1;
+      }
+    }
+  return (min[0] <= max[0] && min[1] <= max[1] && min[2] <= max[2]);
+}
+
+// Add the inverse distance weighted scalar of a point to the slices from
+// k0 to k1.
+static void vtkShepardMethodSplatPoint(vtkShepardMethodStruct *ts,
+                                       vtkIdType ptId, int k0, int k1)
+{
+  double px[3], x[3];
+  int min[3], max[3];
+  ts->Input->GetPoint(ptId, px);
+  if ( !vtkShepardMethodFootprint(ts, px, min, max) )
+    {
+    return;
+    }
+  min[2] = (min[2] > k0 ? min[2] : k0);
+  max[2] = (max[2] < k1 ? max[2] : k1);
+  double inScalar = ts->Scalars->GetComponent(ptId, 0);
+
+  vtkIdType jkFactor =
+    static_cast<vtkIdType>(ts->Dimensions[0])*ts->Dimensions[1];
+  for (int k = min[2]; k <= max[2]; k++)
+    {
+    x[2] = ts->Spacing[2] * k + ts->Origin[2];
+    for (int j = min[1]; j <= max[1]; j++)
+      {
+      x[1] = ts->Spacing[1] * j + ts->Origin[1];
+      vtkIdType idx = jkFactor*k + ts->Dimensions[0]*j + min[0];
+      for (int i = min[0]; i <= max[0]; i++, idx++)
+        {
+        x[0] = ts->Spacing[0] * i + ts->Origin[0];
+        double distance2 = vtkMath::Distance2BetweenPoints(x,px);
+
+        if ( distance2 == 0.0 )
+          {
+          ts->Sum[idx] = VTK_DOUBLE_MAX;
+          ts->Output[idx] = VTK_FLOAT_MAX;
+          }
+        else
+          {
+          double s = ts->Output[idx];
+          ts->Sum[idx] += 1.0 / distance2;
+          ts->Output[idx] = static_cast<float>(s + inScalar/distance2);
+          }
+        }
+      }
+    }
+}
+
+// Bin a range of points by slab.
+static void vtkShepardMethodBinPoints(vtkShepardMethodStruct *ts,
+                                      int threadId)
+{
+  vtkIdType numPts = ts->Input->GetNumberOfPoints();
+  vtkIdType endId = numPts*(threadId + 1)/ts->NumberOfThreads;
+  vtkstd::vector<vtkIdType> *bins = &ts->Bins[threadId*ts->NumberOfSlabs];
+  double px[3];
+  int min[3], max[3];
+  for (vtkIdType ptId = numPts*threadId/ts->NumberOfThreads; ptId < endId;
+       ptId++)
+    {
+    ts->Input->GetPoint(ptId, px);
+    if ( vtkShepardMethodFootprint(ts, px, min, max) )
+      {
+      for (int slab = ts->SlabOfSlice[min[2]];
+           slab <= ts->SlabOfSlice[max[2]]; slab++)
+        {
+        bins[slab].push_back(ptId);
+        }
+      }
+    }
+}
+
+// Interpolate the voxels of a slab from its points, which are all the
+// points when there is only one slab.
+static void vtkShepardMethodSplatSlab(vtkShepardMethodStruct *ts, int slab,
+                                      int report)
+{
+  int k0 = ts->SlabStart[slab];
+  int k1 = ts->SlabStart[slab + 1] - 1;
+  vtkIdType jkFactor =
+    static_cast<vtkIdType>(ts->Dimensions[0])*ts->Dimensions[1];
+  vtkIdType idx;
+  for (idx = k0*jkFactor; idx < (k1 + 1)*jkFactor; idx++)
+    {
+    ts->Output[idx] = 0.0f;
+    ts->Sum[idx] = 0.0;
+    }
+
+  if ( ts->NumberOfSlabs == 1 )
+    {
+    vtkIdType numPts = ts->Input->GetNumberOfPoints();
+    for (vtkIdType ptId=0; ptId < numPts; ptId++)
+      {
+      if ( ! (ptId % 1000) )
+        {
+        ts->Filter->UpdateProgress(static_cast<double>(ptId)/numPts);
+        if ( ts->Filter->GetAbortExecute() )
+          {
+          break;
+          }
+        }
+      vtkShepardMethodSplatPoint(ts, ptId, k0, k1);
+      }
+    }
+  else if ( !ts->Filter->GetAbortExecute() )
+    {
+    for (int threadId=0; threadId < ts->NumberOfThreads; threadId++)
+      {
+      vtkstd::vector<vtkIdType> &bin =
+        ts->Bins[threadId*ts->NumberOfSlabs + slab];
+      for (size_t b=0; b < bin.size(); b++)
+        {
+        vtkShepardMethodSplatPoint(ts, bin[b], k0, k1);
+        }
+      }
+    if ( report )
+      {
+      ts->Filter->UpdateProgress(static_cast<double>(slab + 1)/
+                                 ts->NumberOfSlabs);
+      }
+    }
+
+  // Run through scalars and compute final values
+  //
+  for (idx = k0*jkFactor; idx < (k1 + 1)*jkFactor; idx++)
+    {
+    if ( ts->Sum[idx] != 0.0 )
+      {
+      ts->Output[idx] = static_cast<float>(ts->Output[idx]/ts->Sum[idx]);
+      }
+    else
+      {
+      ts->Output[idx] = static_cast<float>(ts->NullValue);
+      }
+    }
+}
+
+static VTK_THREAD_RETURN_TYPE vtkShepardMethodThread(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkShepardMethodStruct *ts =
+    static_cast<vtkShepardMethodStruct *>(info->UserData);
+  int threadId = info->ThreadID;
+  if ( ts->Pass == 0 )
+    {
+    vtkShepardMethodBinPoints(ts, threadId);
+    }
+  else
+    {
+    for (int slab = threadId; slab < ts->NumberOfSlabs;
+         slab += ts->NumberOfThreads)
+      {
+      vtkShepardMethodSplatSlab(ts, slab, threadId == 0);
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
 int vtkShepardMethod::RequestData(
   vtkInformation* vtkNotUsed( request ),
   vtkInformationVector** inputVector,
@@ -143,31 +356,25 @@ int vtkShepardMethod::RequestData(
   vtkInformation* inInfo = inputVector[0]->GetInformationObject(0);
   vtkDataSet *input = vtkDataSet::SafeDownCast(
     inInfo->Get(vtkDataObject::DATA_OBJECT()));
-  
+
   // get the output
   vtkInformation *outInfo = outputVector->GetInformationObject(0);
   vtkImageData *output = vtkImageData::SafeDownCast(
     outInfo->Get(vtkDataObject::DATA_OBJECT()));
-  
+
   // We need to allocate our own scalars since we are overriding
   // the superclasses "Execute()" method.
   output->SetExtent(output->GetWholeExtent());
   output->AllocateScalars();
-  
-  vtkIdType ptId, i;
-  int j, k;
-  double *px, x[3], s, *sum, spacing[3], origin[3];
-  
-  double maxDistance, distance2, inScalar;
+
+  double spacing[3], origin[3];
   vtkDataArray *inScalars;
-  vtkIdType numPts, numNewPts, idx;
-  int min[3], max[3];
-  int jkFactor;
-  vtkFloatArray *newScalars = 
+  vtkIdType numPts;
+  vtkFloatArray *newScalars =
     vtkFloatArray::SafeDownCast(output->GetPointData()->GetScalars());
 
   vtkDebugMacro(<< "Executing Shepard method");
-  
+
   // Check input
   //
   if ( (numPts=input->GetNumberOfPoints()) < 1 )
@@ -184,135 +391,69 @@ int vtkShepardMethod::RequestData(
 
   newScalars->SetName(inScalars->GetName());
 
-  // Allocate
-  //
-  numNewPts = this->SampleDimensions[0] * this->SampleDimensions[1] 
-              * this->SampleDimensions[2];
-
-  sum = new double[numNewPts];
-  for (i=0; i<numNewPts; i++) 
-    {
-    newScalars->SetComponent(i,0,0.0);
-    sum[i] = 0.0;
-    }
-
-  maxDistance = this->ComputeModelBounds(origin,spacing);
+  double maxDistance = this->ComputeModelBounds(origin,spacing);
   outInfo->Set(vtkDataObject::ORIGIN(),origin,3);
   outInfo->Set(vtkDataObject::SPACING(),spacing,3);
 
-
-  // Traverse all input points. 
-  // Each input point affects voxels within maxDistance.
-  //
-  int abortExecute=0;
-  for (ptId=0; ptId < numPts && !abortExecute; ptId++)
+  vtkShepardMethodStruct ts;
+  ts.Filter = this;
+  ts.Input = input;
+  ts.Scalars = inScalars;
+  ts.Output = newScalars->GetPointer(0);
+  vtkstd::vector<double> sum(newScalars->GetNumberOfTuples());
+  ts.Sum = &sum[0];
+  for (int i=0; i<3; i++)
     {
-    if ( ! (ptId % 1000) )
-      {
-      vtkDebugMacro(<<"Inserting point #" << ptId);
-      this->UpdateProgress (ptId/numPts);
-      if (this->GetAbortExecute())
-        {
-        abortExecute = 1;
-        break;
-        }
-      }
-
-    px = input->GetPoint(ptId);
-    inScalar = inScalars->GetComponent(ptId,0);
-    
-    for (i=0; i<3; i++) //compute dimensional bounds in data set
-      {
-      double amin = static_cast<double>(
-        (px[i] - maxDistance) - origin[i]) / spacing[i];
-      double amax = static_cast<double>(
-        (px[i] + maxDistance) - origin[i]) / spacing[i];
-      min[i] = static_cast<int>(amin);
-      max[i] = static_cast<int>(amax);
-      
-      if (min[i] < amin)
-        {
-        min[i]++; // round upward to nearest integer to get min[i]
-        }
-      if (max[i] > amax)
-        {
-        max[i]--; // round downward to nearest integer to get max[i]
-        }
-
-      if (min[i] < 0)
-        {
-        min[i] = 0; // valid range check
-        }
-      if (max[i] >= this->SampleDimensions[i]) 
-        {
-        max[i] = this->SampleDimensions[i] - 1;
-        }
-      }
-
-    for (i=0; i<3; i++) //compute dimensional bounds in data set
-      {
-      min[i] = static_cast<int>(
-        static_cast<double>((px[i] - maxDistance) - origin[i]) / spacing[i]);
-      max[i] = static_cast<int>(
-        static_cast<double>((px[i] + maxDistance) - origin[i]) / spacing[i]);
-      if (min[i] < 0)
-        {
-        min[i] = 0;
-        }
-      if (max[i] >= this->SampleDimensions[i]) 
-        {
-        max[i] = this->SampleDimensions[i] - 1;
-        }
-      }
-  
-    jkFactor = this->SampleDimensions[0]*this->SampleDimensions[1];
-    for (k = min[2]; k <= max[2]; k++) 
-      {
-      x[2] = spacing[2] * k + origin[2];
-      for (j = min[1]; j <= max[1]; j++)
-        {
-        x[1] = spacing[1] * j + origin[1];
-        for (i = min[0]; i <= max[0]; i++) 
-          {
-          x[0] = spacing[0] * i + origin[0];
-          idx = jkFactor*k + this->SampleDimensions[0]*j + i;
-
-          distance2 = vtkMath::Distance2BetweenPoints(x,px);
-
-          if ( distance2 == 0.0 )
-            {
-            sum[idx] = VTK_DOUBLE_MAX;
-            newScalars->SetComponent(idx,0,VTK_FLOAT_MAX);
-            }
-          else
-            {
-            s = newScalars->GetComponent(idx,0);
-            sum[idx] += 1.0 / distance2;
-            newScalars->SetComponent(idx,0,s+(inScalar/distance2));
-            }
-          }
-        }
-      }
+    ts.Dimensions[i] = this->SampleDimensions[i];
+    ts.Origin[i] = origin[i];
+    ts.Spacing[i] = spacing[i];
     }
-
-  // Run through scalars and compute final values
-  //
-  for (ptId=0; ptId<numNewPts; ptId++)
+  ts.MaximumDistance = maxDistance;
+  ts.NullValue = this->NullValue;
+
+  // A few slabs per thread balance the points, which are seldom spread
+  // evenly.  The points are only binned when there are several slabs.
+  int numThreads = this->NumberOfThreads;
+  int maxThreads = vtkMultiThreader::GetGlobalMaximumNumberOfThreads();
+  if ( maxThreads > 0 && numThreads > maxThreads )
     {
-    s = newScalars->GetComponent(ptId,0);
-    if ( sum[ptId] != 0.0 )
-      {
-      newScalars->SetComponent(ptId,0,s/sum[ptId]);
-      }
-    else
+    numThreads = maxThreads;
+    }
+  numThreads = (numThreads < this->SampleDimensions[2] ? numThreads :
+                this->SampleDimensions[2]);
+  ts.NumberOfThreads = (numThreads < 1 ? 1 : numThreads);
+  ts.NumberOfSlabs = (ts.NumberOfThreads == 1 ? 1 : 4*ts.NumberOfThreads);
+  ts.NumberOfSlabs = (ts.NumberOfSlabs < this->SampleDimensions[2] ?
+                      ts.NumberOfSlabs : this->SampleDimensions[2]);
+  ts.SlabStart.resize(ts.NumberOfSlabs + 1);
+  ts.SlabOfSlice.resize(this->SampleDimensions[2]);
+  for (int slab=0; slab <= ts.NumberOfSlabs; slab++)
+    {
+    ts.SlabStart[slab] = static_cast<int>(
+      static_cast<vtkIdType>(this->SampleDimensions[2])*slab/
+      ts.NumberOfSlabs);
+    }
+  for (int slab=0; slab < ts.NumberOfSlabs; slab++)
+    {
+    for (int k=ts.SlabStart[slab]; k < ts.SlabStart[slab + 1]; k++)
       {
-      newScalars->SetComponent(ptId,0,this->NullValue);
+      ts.SlabOfSlice[k] = slab;
       }
     }
 
-  // Update self
+  // Traverse all input points.
+  // Each input point affects voxels within maxDistance.
   //
-  delete [] sum;
+  this->Threader->SetNumberOfThreads(ts.NumberOfThreads);
+  this->Threader->SetSingleMethod(vtkShepardMethodThread, &ts);
+  if ( ts.NumberOfSlabs > 1 )
+    {
+    ts.Bins.resize(ts.NumberOfThreads*ts.NumberOfSlabs);
+    ts.Pass = 0;
+    this->Threader->SingleMethodExecute();
+    }
+  ts.Pass = 1;
+  this->Threader->SingleMethodExecute();
 
   return 1;
 }
@@ -20,6 +20,10 @@
 // "inverse distance weighted". Once the structured points are computed, the 
 // usual visualization techniques (e.g., iso-contouring or volume rendering)
 // can be used visualize the structured points.
+//
+// Threads interpolate slabs of slices along z, each from the points
+// within the maximum distance of the slab taken in their order, so the
+// output does not depend on the number of threads.
 // .SECTION Caveats
 // The input to this filter is any dataset type. This filter can be used 
 // to resample any form of data, i.e., the input data need not be 
@@ -35,12 +39,12 @@
 #ifndef __vtkShepardMethod_h
 #define __vtkShepardMethod_h
 
-#include "vtkImageAlgorithm.h"
+#include "vtkThreadedImageAlgorithm.h"
 
-class VTK_IMAGING_EXPORT vtkShepardMethod : public vtkImageAlgorithm 
+class VTK_IMAGING_EXPORT vtkShepardMethod : public vtkThreadedImageAlgorithm
 {
 public:
-  vtkTypeMacro(vtkShepardMethod,vtkImageAlgorithm);
+  vtkTypeMacro(vtkShepardMethod,vtkThreadedImageAlgorithm);
   void PrintSelf(ostream& os, vtkIndent indent);
 
   // Description: